@@ -3,6 +3,8 @@
 #include <string.h>
 #include <FS.h>
 #include <SD.h>
+#include "SdIo.h"
+#include "SDPlayer/PlayerState.h"
 
 // External references for SD card access
 extern fs::FS& getStorage();
@@ -307,8 +309,7 @@ void EQ16_setMenuActive(bool active) {
 
 void EQ16_displayMenu(void) {
     // GUARD: Nie rysuj gdy SDPlayer aktywny
-    extern bool sdPlayerOLEDActive;
-    if (sdPlayerOLEDActive) return;
+    if (player_state_screen_active()) return;
     
     extern U8G2_SSD1322_NHD_256X64_F_4W_HW_SPI u8g2;
     
@@ -426,18 +427,14 @@ void EQ16_saveToSD(void) {
     // Save EQ16 settings to SD card
     Serial.println("DEBUG: Saving EQ16 settings to /eq16.txt");
     
-    if (getStorage().exists("/eq16.txt")) {
-        getStorage().remove("/eq16.txt"); // Remove old file
+    // Zapis odłożony przez harmonogram SD - przesuwanie suwaków = jeden zapis, w przerwie odtwarzania
+    char text[16 * 6];
+    size_t len = 0;
+    for (uint8_t i = 0; i < APMS_EQ16::BANDS; i++) {
+        len += snprintf(text + len, sizeof(text) - len, "%d\r\n", APMS_EQ16::getBand(i));
+        Serial.printf("Band %d: %d\n", i, APMS_EQ16::getBand(i));
     }
-    
-    File myFile = getStorage().open("/eq16.txt", FILE_WRITE);
-    if (myFile) {
-        // Save all 16 band values
-        for (uint8_t i = 0; i < APMS_EQ16::BANDS; i++) {
-            myFile.println(APMS_EQ16::getBand(i));
-            Serial.printf("Band %d: %d\n", i, APMS_EQ16::getBand(i));
-        }
-        myFile.close();
+    if (sdio_write_file("/eq16.txt", text, len, SDIO_CLASS_CONFIG)) {
         Serial.println("DEBUG: EQ16 settings saved successfully");
     } else {
         Serial.println("ERROR: Failed to open /eq16.txt for writing");
@@ -0,0 +1,506 @@
+#include "AudioTask.h"
+#include "StreamRecorder.h"
+#include "Crossfade.h"
+#include "ReplayGain.h"
+#include "SDPlayer/SeekIndex.h"
+#include "SdIo.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+#include "esp_timer.h"
+
+// ======================= STAN =======================
+
+enum {
+  CMD_STOP = 0,
+  CMD_CONNECT,
+  CMD_PLAY_FILE,
+  CMD_SPEECH,
+  CMD_VOLUME_STEPS,
+  CMD_SEEK,
+  CMD_SEEK_TIME
+};
+
+typedef struct {
+  uint8_t      type;
+  uint16_t     seq;
+  uint32_t     value;                              // rozmiar bufora / liczba kroków głośności / pozycja przewinięcia
+  bool         wait;                               // loop() czeka na wynik (g_done)
+  char         text[AUDIO_CMD_TEXT_LENGTH + 1];
+  char         lang[4];
+} cmd_t;
+
+typedef struct {
+  decltype(Audio::msg_t::e) e;
+  char msg[AUDIO_INFO_MSG_LENGTH + 1];
+} info_t;
+
+static Audio*         g_audio = nullptr;
+static void         (*g_infoCallback)(Audio::msg_t) = nullptr;
+static QueueHandle_t  g_cmdQueue = nullptr;
+static QueueHandle_t  g_infoQueue = nullptr;
+static TaskHandle_t   g_loopTask = nullptr;
+static TaskHandle_t volatile g_task = nullptr;
+static volatile bool  g_taskMode = false;          // bieżący wykonawca: zadanie audio
+static volatile bool  g_wantTaskMode = false;
+static volatile bool  g_exitReq = false;
+static portMUX_TYPE   g_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t       g_seq = 0;
+
+// Wynik polecenia dla czekającej loop() - własny semafor zamiast powiadomień
+// zadania (xTaskNotifyWait kasowałby bity powiadomień używane przez innych)
+static SemaphoreHandle_t g_done = nullptr;
+static uint16_t       g_waitSeq = 0;                // polecenie, na które czeka loop() (0 = nikt), pod g_mux
+static bool           g_waitOk = false;
+
+// Głośność i barwa - ostatnia wartość wygrywa
+static int16_t        g_pendingVolume = -1;
+static bool           g_pendingTone = false;
+static int8_t         g_tone[3];
+
+// Następny plik po evt_eof (gapless odtwarzacza SD)
+static char           g_nextFile[AUDIO_CMD_TEXT_LENGTH + 1];
+static volatile uint8_t g_nextResult = AUDIO_NEXT_NONE;
+
+// Plik otwarty przez dekoder (zdarzenia z nagłówków - okładka) - przy gapless
+// wyprzedza ścieżkę w PlayerState do czasu obsługi evt_eof w loop()
+static char           g_openFile[AUDIO_CMD_TEXT_LENGTH + 1];
+
+// Statystyki
+static audio_task_status_t g_status;
+static uint32_t       g_windowStartMs = 0;
+static uint64_t       g_loopSumUs = 0;
+static uint32_t       g_loopCount = 0;
+static uint32_t       g_loopWinMaxUs = 0;
+static uint32_t       g_serviceWinMaxUs = 0;
+static int64_t        g_lastLoopUs = 0;
+static int64_t        g_lastServiceUs = 0;
+
+// ======================= POMOCNICZE =======================
+
+static void set_open_file(const char* path)
+{
+  portENTER_CRITICAL(&g_mux);
+  strlcpy(g_openFile, path ? path : "", sizeof(g_openFile));
+  portEXIT_CRITICAL(&g_mux);
+}
+
+// Czy bieżący wątek obsługuje dekoder (zadanie audio albo loop())
+static bool is_executor(void)
+{
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  return g_taskMode ? self == g_task : self == g_loopTask;
+}
+
+static bool execute(uint8_t type, const char* text, const char* lang, uint32_t value)
+{
+  bool ok = true;
+  if (type != CMD_VOLUME_STEPS && type != CMD_SEEK && type != CMD_SEEK_TIME)
+  {
+    // Jawne polecenie odtwarzania kasuje zgłoszony następny plik (przewinięcie nie - ten sam utwór)
+    portENTER_CRITICAL(&g_mux);
+    g_nextFile[0] = '\0';
+    portEXIT_CRITICAL(&g_mux);
+    g_nextResult = AUDIO_NEXT_NONE;
+    set_open_file(type == CMD_PLAY_FILE ? text : nullptr);   // przed otwarciem - nagłówki czytane już w connecttoFS
+  }
+  switch (type)
+  {
+    case CMD_STOP:         g_audio->stopSong(); break;
+    case CMD_CONNECT:
+      if (value) g_audio->setInBufferSize(value);
+      ok = g_audio->connecttohost(text);
+      break;
+    case CMD_PLAY_FILE:
+      // Odczyt z wyprzedzeniem - po stacji bufor bywa mały (BufferControl), plik z karty zawsze z dużym
+      if (psramFound() && g_audio->getInBufferSize() != SDIO_READAHEAD_BYTES) g_audio->setInBufferSize(SDIO_READAHEAD_BYTES);
+      seek_index_track_begin(value * 1000);
+      ok = g_audio->connecttoFS(SD, text, value ? (int32_t)value : -1);
+      if (!ok) set_open_file(nullptr);
+      break;
+    case CMD_SPEECH:       ok = g_audio->connecttospeech(text, lang); break;
+    case CMD_VOLUME_STEPS: g_audio->setVolumeSteps(value); break;
+    case CMD_SEEK:
+      // Pozycja z tablicy SeekIndex - biblioteka synchronizuje się do najbliższej ramki
+      ok = g_audio->setAudioFilePosition(value);
+      if (ok) seek_index_applied(); else seek_index_rejected();
+      break;
+    case CMD_SEEK_TIME:
+      ok = g_audio->setAudioPlayTime((uint16_t)value);
+      if (ok) seek_index_applied(); else seek_index_rejected();
+      break;
+  }
+  portENTER_CRITICAL(&g_mux);
+  g_status.commands++;
+  portEXIT_CRITICAL(&g_mux);
+  return ok;
+}
+
+static void apply_pending(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  int16_t volume = g_pendingVolume;
+  bool tone = g_pendingTone;
+  int8_t t[3] = {g_tone[0], g_tone[1], g_tone[2]};
+  g_pendingVolume = -1;
+  g_pendingTone = false;
+  portEXIT_CRITICAL(&g_mux);
+
+  if (volume >= 0) g_audio->setVolume(volume);
+  if (tone) g_audio->setTone(t[0], t[1], t[2]);
+}
+
+static void drain_commands(void)
+{
+  static cmd_t c;   // tylko wykonawca - jeden wątek naraz
+  apply_pending();
+  while (xQueueReceive(g_cmdQueue, &c, 0) == pdTRUE)
+  {
+    bool ok = execute(c.type, c.text, c.lang, c.value);
+    if (c.wait)
+    {
+      portENTER_CRITICAL(&g_mux);
+      bool waiting = c.seq == g_waitSeq;   // po przekroczeniu czasu nikt już nie czeka
+      if (waiting) g_waitOk = ok;
+      portEXIT_CRITICAL(&g_mux);
+      if (waiting) xSemaphoreGive(g_done);
+    }
+    apply_pending();
+  }
+}
+
+// Polecenie z innego wątku - do kolejki, opcjonalnie czekanie na wynik.
+// Czeka tylko loop(): obsługa WWW (AsyncTCP) nie może stać do AUDIO_CMD_WAIT_MS
+static bool send(cmd_t* c, bool wait)
+{
+  if (wait && (xTaskGetCurrentTaskHandle() != g_loopTask || !g_done)) wait = false;
+  c->wait = wait;
+  portENTER_CRITICAL(&g_mux);
+  c->seq = ++g_seq;
+  if (c->seq == 0) c->seq = ++g_seq;   // 0 = nikt nie czeka
+  if (wait) g_waitSeq = c->seq;
+  portEXIT_CRITICAL(&g_mux);
+  if (wait) xSemaphoreTake(g_done, 0);   // wynik spóźniony po poprzednim przekroczeniu czasu
+
+  if (xQueueSend(g_cmdQueue, c, pdMS_TO_TICKS(100)) != pdTRUE)
+  {
+    Serial.println("debug audio -> Kolejka poleceń pełna, polecenie pominięte");
+    portENTER_CRITICAL(&g_mux);
+    if (wait) g_waitSeq = 0;
+    portEXIT_CRITICAL(&g_mux);
+    return false;
+  }
+  uint8_t waiting = uxQueueMessagesWaiting(g_cmdQueue);
+  portENTER_CRITICAL(&g_mux);
+  if (waiting > g_status.queueHighWater) g_status.queueHighWater = waiting;
+  portEXIT_CRITICAL(&g_mux);
+  if (!wait) return true;
+
+  bool done = xSemaphoreTake(g_done, pdMS_TO_TICKS(AUDIO_CMD_WAIT_MS)) == pdTRUE;
+  portENTER_CRITICAL(&g_mux);
+  bool ok = done && g_waitOk;
+  g_waitSeq = 0;
+  portEXIT_CRITICAL(&g_mux);
+  if (!done) Serial.println("debug audio -> Brak odpowiedzi zadania audio");
+  return ok;
+}
+
+static bool command(uint8_t type, const char* text, const char* lang, uint32_t value, bool wait)
+{
+  if (!g_audio) return false;
+  if (is_executor()) return execute(type, text, lang, value);
+
+  cmd_t local;
+  memset(&local, 0, sizeof(local));
+  local.type = type;
+  local.value = value;
+  if (text) strncpy(local.text, text, AUDIO_CMD_TEXT_LENGTH);
+  if (lang) strncpy(local.lang, lang, sizeof(local.lang) - 1);
+  return send(&local, wait);
+}
+
+// Pomiar obiegu loop() i przerw między audio.loop()
+static void note_loop(uint32_t us)
+{
+  uint32_t now = millis();
+  portENTER_CRITICAL(&g_mux);
+  g_loopSumUs += us;
+  g_loopCount++;
+  if (us > g_loopWinMaxUs) g_loopWinMaxUs = us;
+  if (us / 1000 > g_status.loopWorstMs) g_status.loopWorstMs = us / 1000;
+  if (us >= AUDIO_STALL_MS * 1000UL) g_status.loopStalls++;
+
+  if (now - g_windowStartMs >= AUDIO_STATS_WINDOW_MS)
+  {
+    g_status.loopMaxMs = g_loopWinMaxUs / 1000;
+    g_status.loopAvgUs = g_loopCount ? (uint32_t)(g_loopSumUs / g_loopCount) : 0;
+    g_status.serviceMaxMs = g_serviceWinMaxUs / 1000;
+    g_loopSumUs = 0;
+    g_loopCount = 0;
+    g_loopWinMaxUs = 0;
+    g_serviceWinMaxUs = 0;
+    g_windowStartMs = now;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void service(void)
+{
+  int64_t now = esp_timer_get_time();
+  if (g_lastServiceUs)
+  {
+    uint32_t us = (uint32_t)(now - g_lastServiceUs);
+    portENTER_CRITICAL(&g_mux);
+    if (us > g_serviceWinMaxUs) g_serviceWinMaxUs = us;
+    if (us / 1000 > g_status.serviceWorstMs) g_status.serviceWorstMs = us / 1000;
+    if (us >= AUDIO_STALL_MS * 1000UL) g_status.serviceStalls++;
+    portEXIT_CRITICAL(&g_mux);
+  }
+  g_lastServiceUs = now;
+
+  g_audio->loop();
+  if (rec_is_active()) {rec_note_audio_loop();} // Pomiar przerw toru audio podczas nagrywania
+}
+
+// Start zgłoszonego pliku w callbacku końca pliku - jak audio_eof_mp3() w przykładach biblioteki
+static void start_next_file(void)
+{
+  char path[AUDIO_CMD_TEXT_LENGTH + 1];
+  portENTER_CRITICAL(&g_mux);
+  memcpy(path, g_nextFile, sizeof(path));
+  g_nextFile[0] = '\0';
+  portEXIT_CRITICAL(&g_mux);
+  if (!path[0]) return;
+
+  xfade_track_begin(true);
+  rgain_track_begin();   // wzmocnienie policzone przy zgłoszeniu pliku
+  seek_index_track_begin(0);
+  set_open_file(path);
+  bool ok = g_audio->connecttoFS(SD, path);
+  if (!ok) set_open_file(nullptr);
+  g_nextResult = ok ? AUDIO_NEXT_STARTED : AUDIO_NEXT_FAILED;
+  Serial.printf("debug audio -> Gapless: %s %s\n", ok ? "start" : "błąd", path);
+}
+
+// Zdarzenia biblioteki - z zadania audio kopia do kolejki, inaczej od razu
+static void info_hook(Audio::msg_t m)
+{
+  if (!g_infoCallback) return;
+  if (m.e == Audio::evt_eof && g_nextFile[0]) start_next_file();   // wynik gotowy zanim loop() zobaczy evt_eof
+  if (!g_taskMode || xTaskGetCurrentTaskHandle() != g_task || !m.vec.empty())
+  {
+    g_infoCallback(m);   // evt_image (wektor pozycji) bez kopiowania - w zadaniu audio wydruk + cover_art_source() (kopia pod mutexem CoverArt)
+    return;
+  }
+
+  info_t ev;
+  ev.e = m.e;
+  strncpy(ev.msg, m.msg ? m.msg : "", AUDIO_INFO_MSG_LENGTH);
+  ev.msg[AUDIO_INFO_MSG_LENGTH] = '\0';
+  if (xQueueSend(g_infoQueue, &ev, 0) != pdTRUE)
+  {
+    portENTER_CRITICAL(&g_mux);
+    g_status.infoDropped++;
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+static void drain_info(void)
+{
+  static info_t ev;
+  while (xQueueReceive(g_infoQueue, &ev, 0) == pdTRUE)
+  {
+    Audio::msg_t m;
+    m.e = ev.e;
+    m.msg = ev.msg;
+    g_infoCallback(m);
+  }
+}
+
+// ======================= ZADANIE =======================
+
+static void audio_task(void* arg)
+{
+  while (!g_taskMode && !g_exitReq) { vTaskDelay(1); }   // loop() kończy przekazanie obsługi
+
+  while (!g_exitReq)
+  {
+    drain_commands();
+    service();
+    vTaskDelay(1);
+  }
+
+  g_task = nullptr;
+  vTaskDelete(NULL);
+}
+
+static void switch_mode(bool taskMode)
+{
+  g_lastServiceUs = 0;   // przerwa na przełączenie nie jest zacięciem
+
+  if (taskMode)
+  {
+    TaskHandle_t handle = nullptr;
+    g_exitReq = false;
+    if (xTaskCreatePinnedToCore(audio_task, "AudioLoop", AUDIO_TASK_STACK, NULL, AUDIO_TASK_PRIORITY, &handle, AUDIO_TASK_CORE) != pdPASS)
+    {
+      Serial.println("debug audio -> Nie udało się utworzyć zadania audio, audio.loop() zostaje w loop()");
+      g_wantTaskMode = false;
+      return;
+    }
+    g_task = handle;
+    g_taskMode = true;
+    Serial.printf("debug audio -> audio.loop() w zadaniu AudioLoop (rdzeń %u, priorytet %u)\n", AUDIO_TASK_CORE, AUDIO_TASK_PRIORITY);
+  }
+  else
+  {
+    g_exitReq = true;
+    while (g_task) { vTaskDelay(1); }   // zadanie kończy bieżący audio.loop()
+    g_taskMode = false;
+    Serial.println("debug audio -> audio.loop() w loop()");
+  }
+}
+
+// ======================= API =======================
+
+void audio_task_begin(Audio* audio, void (*infoCallback)(Audio::msg_t))
+{
+  g_audio = audio;
+  g_infoCallback = infoCallback;
+  g_loopTask = xTaskGetCurrentTaskHandle();
+  if (!g_cmdQueue) g_cmdQueue = xQueueCreate(AUDIO_CMD_QUEUE_LENGTH, sizeof(cmd_t));
+  if (!g_done) g_done = xSemaphoreCreateBinary();
+  if (!g_infoQueue)
+  {
+    // Kolejka zdarzeń w PSRAM - przy łączeniu biblioteka wysyła serię komunikatów naraz
+    static StaticQueue_t infoQueueBuffer;
+    uint8_t* storage = (uint8_t*)ps_malloc(AUDIO_INFO_QUEUE_LENGTH * sizeof(info_t));
+    g_infoQueue = storage ? xQueueCreateStatic(AUDIO_INFO_QUEUE_LENGTH, sizeof(info_t), storage, &infoQueueBuffer)
+                          : xQueueCreate(AUDIO_INFO_QUEUE_LENGTH / 4, sizeof(info_t));
+  }
+  g_windowStartMs = millis();
+  Audio::audio_info_callback = info_hook;
+}
+
+void audio_task_set_mode(bool taskMode)
+{
+  g_wantTaskMode = taskMode;
+}
+
+bool audio_task_is_task_mode(void)
+{
+  return g_taskMode;
+}
+
+void audio_task_loop(void)
+{
+  int64_t now = esp_timer_get_time();
+  if (g_lastLoopUs) note_loop((uint32_t)(now - g_lastLoopUs));
+  g_lastLoopUs = now;
+
+  if (!g_audio) return;
+  if (g_wantTaskMode != g_taskMode && g_cmdQueue && g_infoQueue) switch_mode(g_wantTaskMode);
+  if (!g_taskMode)
+  {
+    drain_commands();
+    service();
+  }
+  drain_info();
+}
+
+void audio_cmd_volume(uint8_t volume)
+{
+  if (!g_audio) return;
+  if (is_executor()) { g_audio->setVolume(volume); return; }
+  portENTER_CRITICAL(&g_mux);
+  g_pendingVolume = volume;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void audio_cmd_volume_steps(uint8_t steps)
+{
+  command(CMD_VOLUME_STEPS, nullptr, nullptr, steps, false);
+}
+
+void audio_cmd_tone(int8_t low, int8_t mid, int8_t high)
+{
+  if (!g_audio) return;
+  if (is_executor()) { g_audio->setTone(low, mid, high); return; }
+  portENTER_CRITICAL(&g_mux);
+  g_tone[0] = low;
+  g_tone[1] = mid;
+  g_tone[2] = high;
+  g_pendingTone = true;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void audio_cmd_stop(void)
+{
+  command(CMD_STOP, nullptr, nullptr, 0, false);
+}
+
+bool audio_cmd_connect(const char* url, uint32_t inBufferSize)
+{
+  return command(CMD_CONNECT, url, nullptr, inBufferSize, true);
+}
+
+bool audio_cmd_play_file(const char* path)
+{
+  return command(CMD_PLAY_FILE, path, nullptr, 0, true);
+}
+
+bool audio_cmd_play_file_at(const char* path, uint32_t startSec)
+{
+  return command(CMD_PLAY_FILE, path, nullptr, startSec, true);
+}
+
+void audio_cmd_speech(const char* text, const char* lang)
+{
+  command(CMD_SPEECH, text, lang, 0, false);
+}
+
+void audio_cmd_seek_file(uint32_t offset)
+{
+  command(CMD_SEEK, nullptr, nullptr, offset, false);
+}
+
+void audio_cmd_seek_time(uint32_t sec)
+{
+  command(CMD_SEEK_TIME, nullptr, nullptr, sec, false);
+}
+
+void audio_cmd_arm_next_file(const char* path)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (path) { strncpy(g_nextFile, path, AUDIO_CMD_TEXT_LENGTH); g_nextFile[AUDIO_CMD_TEXT_LENGTH] = '\0'; }
+  else { g_nextFile[0] = '\0'; }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+uint8_t audio_task_take_next_file(void)
+{
+  uint8_t result = g_nextResult;
+  g_nextResult = AUDIO_NEXT_NONE;
+  return result;
+}
+
+size_t audio_task_open_file(char* out, size_t size)
+{
+  if (!out || !size) return 0;
+  portENTER_CRITICAL(&g_mux);
+  size_t len = strlcpy(out, g_openFile, size);
+  portEXIT_CRITICAL(&g_mux);
+  return len < size ? len : size - 1;
+}
+
+void audio_task_get_status(audio_task_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+  out->taskMode = g_taskMode;
+  TaskHandle_t task = g_task;
+  out->stackFree = task ? uxTaskGetStackHighWaterMark(task) : 0;
+}
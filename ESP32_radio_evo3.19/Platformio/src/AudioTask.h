@@ -0,0 +1,94 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Audio.h"
+
+// ========================================================================
+// AUDIO TASK - obsługa audio.loop() w osobnym zadaniu i kolejka poleceń
+// ========================================================================
+// Tryb zadania (opcja w konfiguracji): audio.loop() wywołuje zadanie
+// "AudioLoop" przypięte do rdzenia 0 z wysokim priorytetem. Długie operacje
+// w loop() (ekran, menu pilota, zapis konfiguracji, pobieranie banku)
+// nie zatrzymują już dekodera. Bez trybu zadania audio.loop() wywołuje
+// audio_task_loop() z loop() - jak dotąd.
+//
+// Polecenia zmieniające stan dekodera (głośność, barwa, stop, stacja,
+// plik, mowa, przewinięcie) idą przez audio_cmd_x(): wykonawca (zadanie audio albo
+// pętla loop()) wykonuje je od razu we własnym kontekście, inne wątki
+// (obsługa WWW) wstawiają je do kolejki. Głośność i barwa to "ostatnia
+// wartość wygrywa" - szybkie sekwencje (fade) nie zapychają kolejki.
+// Na wynik połączenia / otwarcia pliku czeka tylko loop() (semafor, bez
+// powiadomień zadania) - z innych zadań polecenie jest tylko kolejkowane
+// i funkcja zwraca true po wstawieniu do kolejki.
+//
+// Zdarzenia audio_info z zadania audio trafiają kopią do kolejki i są
+// obsługiwane w loop() - callback programu nadal działa w jednym wątku
+// z ekranem i zmiennymi String.
+//
+// Następny plik (gapless odtwarzacza SD): zgłoszony plik startuje od razu
+// przy evt_eof w kontekście dekodera, zanim zdarzenie dotrze do loop().
+//
+// Odczyty (isRunning, getVUlevel, getBitRate, inBufferFilled) pozostają
+// bezpośrednie - nie zmieniają stanu biblioteki.
+// ========================================================================
+
+static const uint8_t  AUDIO_TASK_CORE         = 0;
+static const uint8_t  AUDIO_TASK_PRIORITY     = 12;     // ponad AsyncTCP i zadaniami w tle, poniżej lwIP / WiFi
+static const uint16_t AUDIO_TASK_STACK        = 12288;  // dekodery AAC / FLAC / Opus pracują na tym stosie
+static const uint8_t  AUDIO_CMD_QUEUE_LENGTH  = 8;
+static const uint16_t AUDIO_CMD_TEXT_LENGTH   = 255;    // URL / ścieżka pliku / tekst mowy
+static const uint8_t  AUDIO_INFO_QUEUE_LENGTH = 32;     // seria komunikatów przy łączeniu ze stacją
+static const uint16_t AUDIO_INFO_MSG_LENGTH   = 255;
+static const uint32_t AUDIO_CMD_WAIT_MS       = 20000;  // maks. czas oczekiwania na wynik połączenia
+static const uint16_t AUDIO_STALL_MS          = 100;    // przerwa dłuższa = zacięcie (pętla lub obsługa audio)
+static const uint16_t AUDIO_STATS_WINDOW_MS   = 10000;
+
+enum {
+  AUDIO_NEXT_NONE = 0,           // brak zgłoszonego startu
+  AUDIO_NEXT_STARTED,            // zgłoszony plik gra
+  AUDIO_NEXT_FAILED              // zgłoszony plik nie wystartował
+};
+
+typedef struct {
+  bool     taskMode;             // audio.loop() w zadaniu "AudioLoop"
+  uint32_t loopMaxMs;            // najdłuższy obieg loop() w ostatnim oknie 10 s
+  uint32_t loopAvgUs;            // średni obieg loop() w ostatnim oknie
+  uint32_t loopWorstMs;          // najdłuższy obieg od startu
+  uint32_t loopStalls;           // obiegi loop() dłuższe niż AUDIO_STALL_MS
+  uint32_t serviceMaxMs;         // najdłuższa przerwa między audio.loop() w ostatnim oknie
+  uint32_t serviceWorstMs;       // od startu
+  uint32_t serviceStalls;        // przerwy audio.loop() dłuższe niż AUDIO_STALL_MS
+  uint32_t commands;             // wykonane polecenia
+  uint8_t  queueHighWater;
+  uint16_t infoDropped;          // zdarzenia info utracone przy pełnej kolejce
+  uint32_t stackFree;            // zapas stosu zadania audio [B]
+} audio_task_status_t;
+
+// Init - w setup(), po konfiguracji biblioteki. infoCallback = obsługa zdarzeń w loop()
+void audio_task_begin(Audio* audio, void (*infoCallback)(Audio::msg_t));
+void audio_task_set_mode(bool taskMode);   // przełączenie w najbliższym audio_task_loop()
+bool audio_task_is_task_mode(void);
+
+// Z loop() w miejscu audio.loop(): pomiar obiegu pętli, audio.loop() bez trybu
+// zadania, polecenia z kolejki i zdarzenia info z zadania audio
+void audio_task_loop(void);
+
+// Polecenia
+void audio_cmd_volume(uint8_t volume);
+void audio_cmd_volume_steps(uint8_t steps);
+void audio_cmd_tone(int8_t low, int8_t mid, int8_t high);
+void audio_cmd_stop(void);
+bool audio_cmd_connect(const char* url, uint32_t inBufferSize);    // inBufferSize 0 = bez zmiany
+bool audio_cmd_play_file(const char* path);                         // plik z karty SD
+bool audio_cmd_play_file_at(const char* path, uint32_t startSec);   // od pozycji (wznowienie), 0 = od początku
+void audio_cmd_speech(const char* text, const char* lang);
+void audio_cmd_seek_file(uint32_t offset);                          // przewinięcie pliku: pozycja z tablicy (SeekIndex)
+void audio_cmd_seek_time(uint32_t sec);                             // przewinięcie wg czasu - biblioteka szuka pozycji sama
+
+// Następny plik z karty SD po końcu bieżącego (nullptr = brak)
+void    audio_cmd_arm_next_file(const char* path);
+uint8_t audio_task_take_next_file(void);   // AUDIO_NEXT_x, odczyt kasuje wynik
+size_t  audio_task_open_file(char* out, size_t size);   // plik z karty otwarty przez dekoder ("" = brak), zwraca długość
+
+void audio_task_get_status(audio_task_status_t* out);
@@ -0,0 +1,563 @@
+#include "BankProbe.h"
+#include "StationBanks.h"
+#include "StreamHealth.h"
+#include "StreamInfo.h"
+#include "NetCache.h"
+#include <FS.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <string.h>
+
+// External references for storage access
+extern fs::FS& getStorage();
+
+// ======================= STAN =======================
+
+static portMUX_TYPE    g_mux = portMUX_INITIALIZER_UNLOCKED;
+static probe_result_t* g_results = nullptr;       // PSRAM, PROBE_STATIONS_MAX wpisów
+static probe_status_t  g_status;
+static volatile bool   g_stopReq = false;
+
+static char*           g_lines = nullptr;         // kopia linii banku z PSRAM (fromStore), linie rozdzielone '\0'
+static bool            g_fromStore = false;
+
+typedef struct {
+  bool     https;
+  char     host[NET_HOST_LENGTH + 1];
+  uint16_t port;
+  char     path[HEALTH_URL_LENGTH + 1];
+} url_parts_t;
+
+// ======================= POMOCNICZE =======================
+
+static bool url_parse(const char* url, url_parts_t* u)
+{
+  memset(u, 0, sizeof(*u));
+  if (strncmp(url, "https://", 8) == 0) { u->https = true; u->port = 443; url += 8; }
+  else if (strncmp(url, "http://", 7) == 0) { u->port = 80; url += 7; }
+  else return false;
+
+  size_t n = 0;
+  while (*url && *url != '/' && *url != ':' && *url != '?' && n < NET_HOST_LENGTH) u->host[n++] = *url++;
+  u->host[n] = '\0';
+  if (n == 0) return false;
+  if (*url == ':') { u->port = (uint16_t)strtoul(url + 1, (char**)&url, 10); }
+
+  if (*url != '/') { u->path[0] = '/'; strncpy(u->path + 1, url, HEALTH_URL_LENGTH - 1); }
+  else strncpy(u->path, url, HEALTH_URL_LENGTH);
+  return u->port != 0;
+}
+
+// Linia odpowiedzi HTTP bez "\r\n", false = przekroczony czas
+static bool read_line(Client* c, char* out, size_t outSize, uint32_t deadline)
+{
+  size_t n = 0;
+  while ((int32_t)(deadline - millis()) > 0)
+  {
+    if (!c->available())
+    {
+      if (!c->connected()) break;
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+    int ch = c->read();
+    if (ch < 0) continue;
+    if (ch == '\n') { out[n] = '\0'; return true; }
+    if (ch != '\r' && n + 1 < outSize) out[n++] = (char)ch;
+  }
+  out[n] = '\0';
+  return false;
+}
+
+static bool header_is(const char* line, const char* name)
+{
+  return strncasecmp(line, name, strlen(name)) == 0;
+}
+
+static const char* header_value(const char* line)
+{
+  const char* v = strchr(line, ':');
+  if (!v) return "";
+  v++;
+  while (*v == ' ') v++;
+  return v;
+}
+
+// Ramka MP3 - kontrola pól nagłówka, bitrate i częstotliwość
+static bool sniff_mp3(const uint8_t* p, probe_result_t* r)
+{
+  static const uint16_t BR_V1_L3[15] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+  static const uint16_t BR_V1_L2[15] = {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384};
+  static const uint16_t BR_V2[15]    = {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160};
+  static const uint32_t SR[3][3]     = {{44100, 48000, 32000}, {22050, 24000, 16000}, {11025, 12000, 8000}};
+
+  uint8_t version = (p[1] >> 3) & 3;       // 3 = MPEG1, 2 = MPEG2, 0 = MPEG2.5
+  uint8_t layer   = (p[1] >> 1) & 3;       // 1 = L3, 2 = L2, 3 = L1
+  uint8_t brIndex = p[2] >> 4;
+  uint8_t srIndex = (p[2] >> 2) & 3;
+  if (version == 1 || layer == 0 || brIndex == 0 || brIndex == 15 || srIndex == 3) return false;
+
+  const uint16_t* table = (version == 3) ? (layer == 1 ? BR_V1_L3 : BR_V1_L2) : BR_V2;
+  r->codec = SI_CODEC_MP3;
+  r->bitrateKbps = table[brIndex];
+  r->sampleRate = SR[version == 3 ? 0 : (version == 2 ? 1 : 2)][srIndex];
+  return true;
+}
+
+static bool sniff_adts(const uint8_t* p, probe_result_t* r)
+{
+  static const uint32_t SR[13] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350};
+  uint8_t srIndex = (p[2] >> 2) & 0x0F;
+  if (srIndex >= 13) return false;
+  r->codec = SI_CODEC_AAC;
+  r->sampleRate = SR[srIndex];
+  return true;
+}
+
+// Szukanie pierwszej ramki audio w danych - true = znaleziona
+static bool sniff_audio(const uint8_t* b, size_t len, probe_result_t* r)
+{
+  for (size_t i = 0; i + 32 <= len; i++)
+  {
+    if (b[i] == 0xFF)
+    {
+      if ((b[i + 1] & 0xF6) == 0xF0) { if (sniff_adts(b + i, r)) return true; }
+      else if ((b[i + 1] & 0xE0) == 0xE0) { if (sniff_mp3(b + i, r)) return true; }
+    }
+    else if (b[i] == 'O' && memcmp(b + i, "OggS", 4) == 0)
+    {
+      r->codec = SI_CODEC_VORBIS;
+      for (size_t j = i; j + 8 <= len; j++) { if (memcmp(b + j, "OpusHead", 8) == 0) { r->codec = SI_CODEC_OPUS; r->sampleRate = 48000; break; } }
+      return true;
+    }
+    else if (b[i] == 'f' && memcmp(b + i, "fLaC", 4) == 0)
+    {
+      // STREAMINFO: 4 B nagłówka bloku, częstotliwość = 20 bitów od bajtu 10
+      const uint8_t* si = b + i + 8;
+      r->codec = SI_CODEC_FLAC;
+      r->sampleRate = ((uint32_t)si[10] << 12) | ((uint32_t)si[11] << 4) | (si[12] >> 4);
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint16_t elapsed16(uint32_t since)
+{
+  uint32_t ms = millis() - since;
+  return ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+}
+
+// Pomiar jednej stacji - łańcuch przekierowań obsługiwany ręcznie
+static void probe_one(const char* url, probe_result_t* r)
+{
+  static uint8_t buf[2048 + 32];
+  char line[HEALTH_URL_LENGTH + 16];
+  char current[HEALTH_URL_LENGTH + 1];
+  char contentType[32] = "";
+  strncpy(current, url, HEALTH_URL_LENGTH);
+  current[HEALTH_URL_LENGTH] = '\0';
+  uint32_t start = millis();
+
+  for (;;)
+  {
+    url_parts_t u;
+    if (!url_parse(current, &u)) { r->error = PROBE_ERR_URL; break; }
+    strncpy(r->finalHost, u.host, PROBE_HOST_LENGTH);
+    r->finalHost[PROBE_HOST_LENGTH] = '\0';
+    r->https = u.https;
+
+    // DNS (adres IP w URL - bez zapytania)
+    uint32_t t = millis();
+    IPAddress ip;
+    if (!ip.fromString(u.host))
+    {
+      uint32_t addr;
+      if (!net_dns_resolve(u.host, &addr)) { r->error = PROBE_ERR_DNS; break; }
+      ip = IPAddress(addr);
+    }
+    r->dnsMs += elapsed16(t);
+
+    // TCP - osobno, żeby dla https odjąć go od czasu TLS
+    WiFiClient tcp;
+    t = millis();
+    if (!tcp.connect(ip, u.port, PROBE_TIMEOUT_MS)) { r->error = PROBE_ERR_CONNECT; break; }
+    uint16_t tcpMs = elapsed16(t);
+    r->tcpMs += tcpMs;
+
+    WiFiClientSecure tls;
+    Client* c = &tcp;
+    if (u.https)
+    {
+      tcp.stop();
+      tls.setInsecure();
+      tls.setHandshakeTimeout(PROBE_TIMEOUT_MS / 1000);
+      t = millis();
+      if (!tls.connect(u.host, u.port)) { r->error = PROBE_ERR_TLS; break; }
+      uint16_t total = elapsed16(t);
+      r->tlsMs += (total > tcpMs) ? total - tcpMs : 0;
+      c = &tls;
+    }
+
+    // HTTP/1.0 - bez kodowania chunked, metadane ICY wyłączone
+    c->print("GET ");
+    c->print(u.path);
+    c->print(" HTTP/1.0\r\nHost: ");
+    c->print(u.host);
+    c->print("\r\nUser-Agent: EvoRadio-Probe\r\nIcy-MetaData: 0\r\nConnection: close\r\n\r\n");
+
+    t = millis();
+    uint32_t deadline = t + PROBE_TIMEOUT_MS;
+    while (!c->available() && c->connected() && (int32_t)(deadline - millis()) > 0) vTaskDelay(pdMS_TO_TICKS(2));
+    if (!c->available()) { r->error = PROBE_ERR_TIMEOUT; c->stop(); break; }
+    r->firstByteMs = elapsed16(t);
+
+    // Linia statusu: "HTTP/1.1 200 OK" lub "ICY 200 OK"
+    read_line(c, line, sizeof(line), deadline);
+    const char* sp = strchr(line, ' ');
+    r->httpStatus = sp ? (uint16_t)atoi(sp + 1) : 0;
+
+    char location[HEALTH_URL_LENGTH + 1] = "";
+    while (read_line(c, line, sizeof(line), deadline) && line[0])
+    {
+      if (header_is(line, "Location:")) { strncpy(location, header_value(line), HEALTH_URL_LENGTH); location[HEALTH_URL_LENGTH] = '\0'; }
+      else if (header_is(line, "Content-Type:")) { strncpy(contentType, header_value(line), sizeof(contentType) - 1); }
+      else if (header_is(line, "icy-br:")) { r->bitrateKbps = (uint16_t)atoi(header_value(line)); }
+    }
+
+    if (r->httpStatus >= 300 && r->httpStatus < 400 && location[0])
+    {
+      c->stop();
+      if (++r->redirects > PROBE_REDIRECTS_MAX) { r->error = PROBE_ERR_REDIRECTS; break; }
+      if (location[0] == '/')   // względny adres - ten sam host
+        snprintf(current, sizeof(current), "%s://%s:%u%s", u.https ? "https" : "http", u.host, u.port, location);
+      else
+        strcpy(current, location);
+      continue;
+    }
+    if (r->httpStatus != 200) { r->error = PROBE_ERR_HTTP; c->stop(); break; }
+
+    // Kodek wstępnie z Content-Type, potwierdzenie z pierwszej ramki
+    if (strstr(contentType, "mpeg")) r->codec = SI_CODEC_MP3;
+    else if (strstr(contentType, "aac")) r->codec = SI_CODEC_AAC;
+    else if (strstr(contentType, "flac")) r->codec = SI_CODEC_FLAC;
+    else if (strstr(contentType, "ogg")) r->codec = SI_CODEC_VORBIS;
+
+    size_t keep = 0, sniffed = 0;
+    bool found = false;
+    while (!found && sniffed < PROBE_SNIFF_BYTES && (int32_t)(deadline - millis()) > 0)
+    {
+      int avail = c->available();
+      if (avail <= 0)
+      {
+        if (!c->connected()) break;
+        vTaskDelay(pdMS_TO_TICKS(5));
+        continue;
+      }
+      int n = c->read(buf + keep, (size_t)avail > sizeof(buf) - 32 ? sizeof(buf) - 32 : avail);
+      if (n <= 0) continue;
+      size_t len = keep + n;
+      sniffed += n;
+      found = sniff_audio(buf, len, r);
+      if (!found && len >= 32) { memmove(buf, buf + len - 32, 32); keep = 32; }  // ramka na granicy odczytów
+    }
+    c->stop();
+    if (found) r->firstAudioMs = elapsed16(start);
+    else r->error = PROBE_ERR_NO_AUDIO;
+    break;
+  }
+  r->totalMs = elapsed16(start);
+}
+
+// Nazwa stacji z linii banku - do podwójnej spacji lub adresu
+static void line_name(const char* line, char* out)
+{
+  const char* end = strstr(line, "  ");
+  const char* http = strstr(line, "http");
+  if (!end || (http && http < end)) end = http ? http : line + strlen(line);
+  size_t n = end - line;
+  if (n > PROBE_NAME_LENGTH) n = PROBE_NAME_LENGTH;
+  memcpy(out, line, n);
+  while (n && out[n - 1] == ' ') n--;
+  out[n] = '\0';
+}
+
+static void csv_field(fs::File& f, const char* s)
+{
+  f.print('"');
+  for (; *s; s++) { if (*s == '"') f.print('"'); f.print(*s); }
+  f.print('"');
+}
+
+static void json_string(fs::File& f, const char* s)
+{
+  f.print('"');
+  for (; *s; s++)
+  {
+    if (*s == '"' || *s == '\\') f.print('\\');
+    if ((uint8_t)*s >= 0x20) f.print(*s);
+  }
+  f.print('"');
+}
+
+static void write_reports(uint8_t bank, uint16_t count)
+{
+  fs::FS& fs = getStorage();
+  char path[40];
+
+  snprintf(path, sizeof(path), "/probe_bank%02u.csv", bank);
+  fs::File csv = fs.open(path, FILE_WRITE);
+  if (csv)
+  {
+    csv.print("station,name,error,http,redirects,final_host,https,dns_ms,tcp_ms,tls_ms,first_byte_ms,first_audio_ms,total_ms,codec,kbps,sample_rate\n");
+    for (uint16_t i = 0; i < count; i++)
+    {
+      const probe_result_t* r = &g_results[i];
+      csv.printf("%u,", r->station);
+      csv_field(csv, r->name);
+      csv.printf(",%s,%u,%u,", probe_error_name(r->error), r->httpStatus, r->redirects);
+      csv_field(csv, r->finalHost);
+      csv.printf(",%u,%u,%u,%u,%u,%u,%u,%s,%u,%u\n", r->https, r->dnsMs, r->tcpMs, r->tlsMs, r->firstByteMs, r->firstAudioMs,
+                 r->totalMs, stream_info_codec_name(r->codec), r->bitrateKbps, (unsigned)r->sampleRate);
+    }
+    csv.close();
+    portENTER_CRITICAL(&g_mux);
+    strcpy(g_status.report, path);
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  snprintf(path, sizeof(path), "/probe_bank%02u.json", bank);
+  fs::File json = fs.open(path, FILE_WRITE);
+  if (json)
+  {
+    json.printf("{\"bank\":%u,\"base\":", bank);
+    json_string(json, g_status.base);
+    json.print(",\"stations\":[");
+    for (uint16_t i = 0; i < count; i++)
+    {
+      const probe_result_t* r = &g_results[i];
+      json.printf("%s{\"station\":%u,\"name\":", i ? "," : "", r->station);
+      json_string(json, r->name);
+      json.printf(",\"error\":\"%s\",\"http\":%u,\"redirects\":%u,\"final_host\":", probe_error_name(r->error), r->httpStatus, r->redirects);
+      json_string(json, r->finalHost);
+      json.printf(",\"https\":%s,\"dns_ms\":%u,\"tcp_ms\":%u,\"tls_ms\":%u,\"first_byte_ms\":%u,\"first_audio_ms\":%u,\"total_ms\":%u,"
+                  "\"codec\":\"%s\",\"kbps\":%u,\"sample_rate\":%u}",
+                  r->https ? "true" : "false", r->dnsMs, r->tcpMs, r->tlsMs, r->firstByteMs, r->firstAudioMs, r->totalMs,
+                  stream_info_codec_name(r->codec), r->bitrateKbps, (unsigned)r->sampleRate);
+    }
+    json.print("]}\n");
+    json.close();
+  }
+}
+
+// Kolejna linia banku z "http" - z kopii PSRAM lub z pliku
+static bool next_line(fs::File& file, const char** cursor, char* out, size_t outSize)
+{
+  for (;;)
+  {
+    if (g_fromStore)
+    {
+      if (!**cursor) return false;
+      strncpy(out, *cursor, outSize - 1);
+      out[outSize - 1] = '\0';
+      *cursor += strlen(*cursor) + 1;
+    }
+    else
+    {
+      if (!file || !file.available()) return false;
+      size_t n = file.readBytesUntil('\n', out, outSize - 1);
+      out[n] = '\0';
+    }
+    if (strstr(out, "http")) return true;
+  }
+}
+
+// ======================= ZADANIE =======================
+
+static void probe_task(void* arg)
+{
+  static char line[STATION_LINE_MAX_LENGTH + 1];
+  char url[HEALTH_URL_LENGTH + 1];
+  fs::File file;
+  const char* cursor = g_lines;
+  uint8_t bank = g_status.bank;
+
+  if (!g_fromStore) file = getStorage().open(bank_registry_file(bank), FILE_READ);
+
+  uint16_t index = 0;
+  while (!g_stopReq && index < PROBE_STATIONS_MAX && next_line(file, &cursor, line, sizeof(line)))
+  {
+    probe_result_t r;
+    memset(&r, 0, sizeof(r));
+    r.station = index + 1;
+    line_name(line, r.name);
+
+    if (!health_first_url(line, url, sizeof(url))) r.error = PROBE_ERR_URL;
+    else
+    {
+      if (g_status.base[0])
+      {
+        // Atrapa serwera - ten sam bank, adresy podmienione na base
+        char standin[HEALTH_URL_LENGTH + 1];
+        snprintf(standin, sizeof(standin), "%s/probe/standin?n=%u", g_status.base, r.station);
+        strcpy(url, standin);
+      }
+      probe_one(url, &r);
+    }
+
+    Serial.printf("debug probe -> %u %s: %s dns %u tcp %u tls %u fb %u audio %u ms %s %u kbps\n",
+                  r.station, r.name, probe_error_name(r.error), r.dnsMs, r.tcpMs, r.tlsMs, r.firstByteMs, r.firstAudioMs,
+                  stream_info_codec_name(r.codec), r.bitrateKbps);
+
+    portENTER_CRITICAL(&g_mux);
+    g_results[index] = r;
+    g_status.done = ++index;
+    if (r.error == PROBE_OK) g_status.ok++;
+    portEXIT_CRITICAL(&g_mux);
+  }
+  if (file) file.close();
+
+  write_reports(bank, index);
+
+  portENTER_CRITICAL(&g_mux);
+  g_status.total = index;
+  g_status.elapsedMs = millis() - g_status.startedMs;
+  g_status.running = false;
+  char* lines = g_lines;
+  g_lines = nullptr;
+  portEXIT_CRITICAL(&g_mux);
+  free(lines);
+
+  Serial.printf("debug probe -> Bank %u: %u stacji, poprawnych %u, raport %s\n", bank, index, g_status.ok, g_status.report);
+  vTaskDelete(NULL);
+}
+
+// ======================= API =======================
+
+bool probe_start(uint8_t bank, bool fromStore, const char* base)
+{
+  if (g_status.running) return false;
+  if (!g_results) g_results = (probe_result_t*)ps_malloc(PROBE_STATIONS_MAX * sizeof(probe_result_t));
+  if (!g_results) return false;
+
+  uint16_t total = 0;
+  g_fromStore = fromStore;
+  if (fromStore)
+  {
+    // Kopia linii bieżącego banku - zmiana banku w trakcie testu nie przeszkadza
+    char station[STATION_LINE_MAX_LENGTH + 1];
+    uint16_t count = station_store_count();
+    if (count > PROBE_STATIONS_MAX) count = PROBE_STATIONS_MAX;
+    uint32_t bytes = 1;
+    for (uint16_t i = 0; i < count; i++) bytes += station_store_get(i, station, sizeof(station)) + 1;
+
+    g_lines = (char*)ps_malloc(bytes);
+    if (!g_lines) return false;
+    char* p = g_lines;
+    for (uint16_t i = 0; i < count; i++)
+    {
+      uint16_t n = station_store_get(i, p, STATION_LINE_MAX_LENGTH + 1);
+      p += n + 1;
+    }
+    *p = '\0';
+    total = count;
+  }
+  else
+  {
+    const char* file = bank_registry_file(bank);
+    if (!file[0] || !getStorage().exists(file)) return false;
+  }
+
+  memset(&g_status, 0, sizeof(g_status));
+  g_status.running = true;
+  g_status.bank = bank;
+  g_status.total = total;                      // z pliku - nieznana do końca testu
+  g_status.startedMs = millis();
+  if (base) { strncpy(g_status.base, base, PROBE_BASE_LENGTH); g_status.base[PROBE_BASE_LENGTH] = '\0'; }
+  size_t bl = strlen(g_status.base);
+  if (bl && g_status.base[bl - 1] == '/') g_status.base[bl - 1] = '\0';
+  g_stopReq = false;
+
+  if (xTaskCreatePinnedToCore(probe_task, "BankProbe", 12288, NULL, 1, NULL, 0) != pdPASS)
+  {
+    g_status.running = false;
+    free(g_lines);
+    g_lines = nullptr;
+    return false;
+  }
+  Serial.printf("debug probe -> Start testu banku %u%s%s\n", bank, g_status.base[0] ? " przez " : "", g_status.base);
+  return true;
+}
+
+void probe_stop(void)
+{
+  g_stopReq = true;
+}
+
+void probe_get_status(probe_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+  if (out->running) out->elapsedMs = millis() - out->startedMs;
+}
+
+uint16_t probe_get_results(probe_result_t* out, uint16_t first, uint16_t max)
+{
+  if (!out || !g_results) return 0;
+  uint16_t n = 0;
+  portENTER_CRITICAL(&g_mux);
+  while (n < max && first + n < g_status.done) { out[n] = g_results[first + n]; n++; }
+  portEXIT_CRITICAL(&g_mux);
+  return n;
+}
+
+const char* probe_error_name(uint8_t error)
+{
+  switch (error)
+  {
+    case PROBE_OK:            return "ok";
+    case PROBE_ERR_URL:       return "url";
+    case PROBE_ERR_DNS:       return "dns";
+    case PROBE_ERR_CONNECT:   return "connect";
+    case PROBE_ERR_TLS:       return "tls";
+    case PROBE_ERR_TIMEOUT:   return "timeout";
+    case PROBE_ERR_HTTP:      return "http";
+    case PROBE_ERR_REDIRECTS: return "redirects";
+    case PROBE_ERR_NO_AUDIO:  return "no_audio";
+    default:                  return "?";
+  }
+}
+
+// ======================= ATRAPA SERWERA =======================
+
+uint8_t probe_standin_kind(uint16_t n, bool redirected)
+{
+  switch (n % 6)
+  {
+    case 1:  return redirected ? 0 : 2;
+    case 2:  return 3;
+    case 3:  return 1;
+    default: return 0;
+  }
+}
+
+size_t probe_standin_fill(uint8_t kind, size_t offset, uint8_t* buf, size_t maxLen)
+{
+  // MP3: MPEG1 L3 128 kb/s 44.1 kHz, ramka 417 B; AAC: ADTS LC 44.1 kHz stereo, ramka 207 B
+  static const uint8_t MP3_HDR[4]  = {0xFF, 0xFB, 0x90, 0x64};
+  static const uint8_t ADTS_HDR[7] = {0xFF, 0xF1, 0x50, 0x80, 0x19, 0xFF, 0xFC};
+  const uint8_t* hdr = kind == 1 ? ADTS_HDR : MP3_HDR;
+  size_t hdrLen = kind == 1 ? sizeof(ADTS_HDR) : sizeof(MP3_HDR);
+  size_t frameLen = kind == 1 ? 207 : 417;
+  size_t total = frameLen * PROBE_STANDIN_FRAMES;
+
+  size_t n = 0;
+  while (n < maxLen && offset + n < total)
+  {
+    size_t pos = (offset + n) % frameLen;
+    buf[n++] = pos < hdrLen ? hdr[pos] : 0;
+  }
+  return n;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// BANK PROBE - test wszystkich stacji banku w tle (czasy, kodek, przekierowania)
+// ========================================================================
+// Zadanie "BankProbe" (rdzeń 0) łączy się po kolei z każdą stacją banku
+// własnym połączeniem - odtwarzanie radia nie jest przerywane. Dla każdej
+// stacji mierzone są etapy:
+//   DNS -> TCP -> TLS (https) -> pierwszy bajt odpowiedzi -> pierwsza ramka
+//   audio (synchronizacja MP3/AAC ADTS, "OggS", "fLaC" w danych)
+// oraz kod HTTP, łańcuch przekierowań, kodek, bitrate i częstotliwość
+// (z nagłówka ramki lub icy-br). Raport: /probe_bankNN.csv i .json na
+// nośniku oraz strona /probe.
+//
+// Tryb bez internetu: base = "http://127.0.0.1" podmienia adresy stacji
+// na wbudowaną atrapę serwera /probe/standin (przekierowania, błędy 404,
+// strumienie MP3/AAC generowane przez samo radio).
+// ========================================================================
+
+static const uint16_t PROBE_STATIONS_MAX   = 300;
+static const uint8_t  PROBE_NAME_LENGTH    = 31;
+static const uint8_t  PROBE_HOST_LENGTH    = 40;
+static const uint8_t  PROBE_BASE_LENGTH    = 64;
+static const uint8_t  PROBE_REDIRECTS_MAX  = 5;
+static const uint16_t PROBE_TIMEOUT_MS     = 4000;     // na każdy etap
+static const uint16_t PROBE_SNIFF_BYTES    = 16384;    // maks. dane przeszukiwane w poszukiwaniu ramki
+static const uint8_t  PROBE_STANDIN_FRAMES = 40;       // długość strumienia atrapy (ramki MP3)
+
+enum {
+  PROBE_OK = 0,
+  PROBE_ERR_URL,
+  PROBE_ERR_DNS,
+  PROBE_ERR_CONNECT,
+  PROBE_ERR_TLS,
+  PROBE_ERR_TIMEOUT,
+  PROBE_ERR_HTTP,
+  PROBE_ERR_REDIRECTS,
+  PROBE_ERR_NO_AUDIO
+};
+
+typedef struct {
+  char     name[PROBE_NAME_LENGTH + 1];
+  char     finalHost[PROBE_HOST_LENGTH + 1];   // host po przekierowaniach
+  uint16_t station;                            // numer stacji w banku (od 1)
+  uint16_t dnsMs;
+  uint16_t tcpMs;
+  uint16_t tlsMs;                              // 0 dla http
+  uint16_t firstByteMs;                        // od wysłania żądania
+  uint16_t firstAudioMs;                       // od startu - pierwsza ramka audio
+  uint16_t totalMs;
+  uint16_t httpStatus;
+  uint16_t bitrateKbps;
+  uint32_t sampleRate;
+  uint8_t  redirects;
+  uint8_t  codec;                              // SI_CODEC_x
+  uint8_t  error;                              // PROBE_x
+  bool     https;
+} probe_result_t;
+
+typedef struct {
+  bool     running;
+  uint8_t  bank;
+  uint16_t total;
+  uint16_t done;
+  uint16_t ok;
+  uint32_t startedMs;
+  uint32_t elapsedMs;
+  char     base[PROBE_BASE_LENGTH + 1];        // "" = prawdziwe adresy
+  char     report[40];                         // ścieżka raportu CSV po zakończeniu
+} probe_status_t;
+
+// fromStore = true - lista stacji z PSRAM (bieżący bank), false - plik banku z nośnika
+bool        probe_start(uint8_t bank, bool fromStore, const char* base);
+void        probe_stop(void);
+void        probe_get_status(probe_status_t* out);
+uint16_t    probe_get_results(probe_result_t* out, uint16_t first, uint16_t max);
+const char* probe_error_name(uint8_t error);
+
+// Atrapa strumienia dla /probe/standin?n=X - typ odpowiedzi zależny od n
+//   n%6==1 -> 302 na ...&r=1, n%6==2 -> 404, n%6==3 -> AAC ADTS, pozostałe MP3
+uint8_t     probe_standin_kind(uint16_t n, bool redirected);                   // 0=MP3 1=AAC 2=redirect 3=404
+size_t      probe_standin_fill(uint8_t kind, size_t offset, uint8_t* buf, size_t maxLen);  // 0 = koniec strumienia
@@ -0,0 +1,186 @@
+#include "BufferControl.h"
+#include <string.h>
+
+// ======================= STAN =======================
+
+typedef struct {
+  buf_station_t s;
+  uint32_t      lastUsed;     // millis() ostatniego użycia, 0 = wolny wpis
+} buf_entry_t;
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static buf_entry_t  g_entries[BUF_STATIONS_MAX];
+static buf_entry_t* g_current = nullptr;
+static uint32_t     g_appliedBytes = 0;      // 0 = domyślny rozmiar biblioteki
+
+static uint32_t     g_prevFilled = 0;
+static uint32_t     g_prevTickMs = 0;
+static bool         g_started = false;        // bufor choć raz miał >= 1 s muzyki
+static bool         g_lowState = false;       // jesteśmy w przerwie (underrun)
+
+// ======================= POMOCNICZE =======================
+
+static uint32_t url_hash(const char* s)
+{
+  uint32_t h = 2166136261u;                   // FNV-1a
+  while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+static uint32_t target_bytes(const buf_station_t* s)
+{
+  if (s->bitrateKbps == 0) return BUF_DEFAULT_BYTES;
+
+  uint32_t sec = BUF_BASE_SEC + (2 * s->jitterMs) / 1000 + BUF_UNDERRUN_STEP_SEC * s->underruns;
+  if (sec > BUF_MAX_SEC) sec = BUF_MAX_SEC;
+
+  uint32_t bytes = sec * (uint32_t)s->bitrateKbps * 1000 / 8;
+  if (bytes < BUF_MIN_BYTES) bytes = BUF_MIN_BYTES;
+  if (bytes > BUF_MAX_BYTES) bytes = BUF_MAX_BYTES;
+  return bytes;
+}
+
+static uint8_t hist_bucket(uint32_t sec10)
+{
+  if (sec10 < 10)  return 0;
+  if (sec10 < 20)  return 1;
+  if (sec10 < 40)  return 2;
+  if (sec10 < 80)  return 3;
+  if (sec10 < 160) return 4;
+  return 5;
+}
+
+// ======================= API =======================
+
+uint32_t buf_ctrl_begin(const char* url, const char* name)
+{
+  if (!url) return 0;
+  uint32_t hash = url_hash(url);
+  uint32_t now = millis();
+
+  portENTER_CRITICAL(&g_mux);
+  buf_entry_t* e = nullptr;
+  buf_entry_t* oldest = &g_entries[0];
+  for (uint8_t i = 0; i < BUF_STATIONS_MAX; i++)
+  {
+    if (g_entries[i].lastUsed && g_entries[i].s.urlHash == hash) { e = &g_entries[i]; break; }
+    if (g_entries[i].lastUsed < oldest->lastUsed) oldest = &g_entries[i];
+  }
+  if (!e)
+  {
+    e = oldest;
+    memset(e, 0, sizeof(*e));
+    e->s.urlHash = hash;
+  }
+  if (name && *name)
+  {
+    strncpy(e->s.name, name, BUF_NAME_LENGTH);
+    e->s.name[BUF_NAME_LENGTH] = '\0';
+  }
+  e->lastUsed = now ? now : 1;
+  e->s.targetBytes = target_bytes(&e->s);
+  g_current = e;
+
+  uint32_t target = e->s.targetBytes;
+  portEXIT_CRITICAL(&g_mux);
+
+  g_prevFilled = 0;
+  g_prevTickMs = 0;
+  g_started = false;
+  g_lowState = false;
+
+  // Realokacja bufora tylko przy różnicy > 25% - unikamy fragmentacji PSRAM
+  uint32_t diff = (target > g_appliedBytes) ? target - g_appliedBytes : g_appliedBytes - target;
+  if (g_appliedBytes && diff * 4 < g_appliedBytes) return 0;
+
+  g_appliedBytes = target;
+  Serial.printf("debug buffer -> Bufor wejściowy %u kB dla stacji %08X\n", (unsigned)(target / 1024), (unsigned)hash);
+  return target;
+}
+
+void buf_ctrl_tick(uint32_t filledBytes, uint32_t bitrateBps, uint8_t codec, bool running)
+{
+  if (!g_current || !running || bitrateBps == 0) return;
+
+  uint32_t now = millis();
+  uint32_t bytesPerSec = bitrateBps / 8;
+  uint32_t sec10 = (uint32_t)((uint64_t)filledBytes * 10 / bytesPerSec);
+
+  portENTER_CRITICAL(&g_mux);
+  buf_station_t* s = &g_current->s;
+  s->bitrateKbps = bitrateBps / 1000;
+  if (codec != SI_CODEC_NONE) s->codec = codec;
+
+  uint8_t b = hist_bucket(sec10);
+  if (s->hist[b] < UINT16_MAX) s->hist[b]++;
+
+  // Jitter: napływ - zużycie od poprzedniego pomiaru, czyli zmiana zapełnienia.
+  // Liczy się tylko opróżnianie (sieć wolniejsza niż odtwarzanie), pełny
+  // bufor ogranicza napływ - wtedy pomiar pomijamy
+  if (g_prevTickMs && g_appliedBytes && filledBytes < g_appliedBytes * 9 / 10)
+  {
+    uint32_t drained = (filledBytes < g_prevFilled) ? g_prevFilled - filledBytes : 0;
+    uint32_t devMs = (uint32_t)((uint64_t)drained * 1000 / bytesPerSec);
+    if (devMs > 60000) devMs = 60000;
+    s->jitterMs = (uint16_t)((7u * s->jitterMs + devMs) / 8);
+  }
+
+  // Underrun - spadek poniżej 0.2 s po tym jak bufor był już napełniony
+  bool underrun = false;
+  if (sec10 >= 10) g_started = true;
+  if (g_started && sec10 < 2 && !g_lowState)
+  {
+    g_lowState = true;
+    if (s->underruns < UINT16_MAX) s->underruns++;
+    underrun = true;
+  }
+  else if (sec10 >= 10)
+  {
+    g_lowState = false;
+  }
+  s->targetBytes = target_bytes(s);
+  uint32_t target = s->targetBytes;
+  portEXIT_CRITICAL(&g_mux);
+
+  g_prevFilled = filledBytes;
+  g_prevTickMs = now;
+
+  if (underrun) Serial.printf("debug buffer -> Przerwa w buforze, nowy cel %u kB\n", (unsigned)(target / 1024));
+}
+
+uint8_t buf_ctrl_get_stations(buf_station_t* out, uint8_t maxStations)
+{
+  if (!out) return 0;
+
+  buf_entry_t copy[BUF_STATIONS_MAX];
+  int current = -1;
+  portENTER_CRITICAL(&g_mux);
+  memcpy(copy, g_entries, sizeof(copy));
+  if (g_current) current = g_current - g_entries;
+  portEXIT_CRITICAL(&g_mux);
+
+  uint8_t n = 0;
+  if (current >= 0 && n < maxStations)
+  {
+    out[n++] = copy[current].s;
+    copy[current].lastUsed = 0;
+  }
+  // Pozostałe od ostatnio używanej
+  while (n < maxStations)
+  {
+    int best = -1;
+    for (uint8_t i = 0; i < BUF_STATIONS_MAX; i++)
+    {
+      if (copy[i].lastUsed && (best < 0 || copy[i].lastUsed > copy[best].lastUsed)) best = i;
+    }
+    if (best < 0) break;
+    out[n++] = copy[best].s;
+    copy[best].lastUsed = 0;
+  }
+  return n;
+}
+
+uint32_t buf_ctrl_get_applied_bytes(void)
+{
+  return g_appliedBytes;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "StreamInfo.h"
+
+// ========================================================================
+// BUFFER CONTROL - dobór rozmiaru bufora wejściowego audio per stacja
+// ========================================================================
+// Przed connecttohost() wyliczany jest rozmiar bufora (setInBufferSize)
+// na podstawie tego, co wiadomo o stacji z poprzednich odtworzeń:
+//   cel [s] = BUF_BASE_SEC + 2 x jitter + BUF_UNDERRUN_STEP_SEC x przerwy
+//   bajty   = cel x bitrate / 8   (w granicach BUF_MIN_BYTES..BUF_MAX_BYTES)
+// Niski bitrate AAC/Opus daje mały bufor (mniej PSRAM), przerwy w
+// odtwarzaniu powiększają cel dla danej stacji.
+//
+// Szybki start: biblioteka dekoduje od pierwszej pełnej ramki, więc
+// mniejszy bufor nie opóźnia startu - próg startu jest zawsze niski.
+//
+// Raz na sekundę buf_ctrl_tick() mierzy ile sekund muzyki jest w buforze
+// (histogram), zmienność napływu danych (jitter) i przerwy (underrun).
+// ========================================================================
+
+static const uint8_t  BUF_STATIONS_MAX      = 32;          // zapamiętane stacje (LRU)
+static const uint8_t  BUF_NAME_LENGTH       = 24;
+static const uint8_t  BUF_HIST_BUCKETS      = 6;           // <1s, 1-2s, 2-4s, 4-8s, 8-16s, >=16s
+static const uint32_t BUF_DEFAULT_BYTES     = 512 * 1024;  // stacja nieznana
+static const uint32_t BUF_MIN_BYTES         = 32 * 1024;
+static const uint32_t BUF_MAX_BYTES         = 1024 * 1024;
+static const uint8_t  BUF_BASE_SEC          = 6;
+static const uint8_t  BUF_UNDERRUN_STEP_SEC = 3;
+static const uint8_t  BUF_MAX_SEC           = 30;
+
+typedef struct {
+  char     name[BUF_NAME_LENGTH + 1];
+  uint32_t urlHash;
+  uint16_t bitrateKbps;
+  uint8_t  codec;                       // SI_CODEC_x
+  uint16_t underruns;
+  uint16_t jitterMs;                    // zmienność napływu danych w ms audio
+  uint32_t targetBytes;                 // rozmiar bufora przy następnym połączeniu
+  uint16_t hist[BUF_HIST_BUCKETS];      // liczba sekund w danym przedziale zapełnienia
+} buf_station_t;
+
+// Wywoływane przed connecttohost() - zwraca rozmiar dla setInBufferSize(), 0 = bez zmiany
+uint32_t buf_ctrl_begin(const char* url, const char* name);
+
+// Raz na sekundę podczas odtwarzania
+void     buf_ctrl_tick(uint32_t filledBytes, uint32_t bitrateBps, uint8_t codec, bool running);
+
+// Statystyki (kopie - bezpieczne z handlera WWW)
+uint8_t  buf_ctrl_get_stations(buf_station_t* out, uint8_t maxStations);  // bieżąca pierwsza
+uint32_t buf_ctrl_get_applied_bytes(void);
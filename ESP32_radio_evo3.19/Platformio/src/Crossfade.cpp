@@ -0,0 +1,349 @@
+#include "Crossfade.h"
+#include <FS.h>
+#include <SD.h>
+#include <math.h>
+#include <string.h>
+#include <esp_timer.h>
+
+// ======================= STAN =======================
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Linia opóźniająca - ramka stereo 16 bit = jeden uint32_t
+static uint32_t* g_ring = nullptr;
+static uint32_t  g_capacity = 0;          // ramki
+static uint32_t  g_head = 0;              // czoło (najstarsza ramka)
+static uint32_t  g_count = 0;             // ramki w buforze
+
+// Konfiguracja
+static volatile bool    g_gapless = false;
+static volatile uint8_t g_seconds = 0;
+static volatile bool    g_nextCompatible = false;
+
+// Stan toru - zmieniany tylko w xfade_process()
+static uint8_t   g_skipCounter = 0;
+static uint32_t  g_trackRate = 0;         // częstotliwość bieżącego utworu
+static uint32_t  g_fadeTotal = 0;         // długość bieżącego przenikania (0 = brak)
+static uint32_t  g_fadePos = 0;
+static uint32_t  g_tailRate = 0;          // częstotliwość końcówki w buforze
+static bool      g_trimming = false;
+static uint32_t  g_trimmed = 0;
+static bool      g_gapPending = false;
+static int64_t   g_lastOutUs = 0;         // czas ostatniego bloku na wyjściu
+static uint32_t  g_lastOutFrames = 0;
+static uint64_t  g_gapSum = 0;
+
+// Żądanie nowego utworu (dowolny wątek -> tor audio): 0 = brak, 1 = ręczne, 2 = automatyczne
+static volatile uint8_t g_beginReq = 0;
+
+static xfade_status_t g_status;
+
+// Ćwiartka sinusa Q15 - wzmocnienia przenikania equal-power
+static const uint16_t FADE_STEPS = 256;
+static int16_t   g_sine[FADE_STEPS + 1];
+
+// ======================= POMOCNICZE =======================
+
+static void ring_push(const uint32_t* src, uint32_t frames)
+{
+  uint32_t pos = (g_head + g_count) % g_capacity;
+  uint32_t first = g_capacity - pos;
+  if (first > frames) first = frames;
+  memcpy(g_ring + pos, src, first * 4);
+  if (frames > first) memcpy(g_ring, src + first, (frames - first) * 4);
+  g_count += frames;
+}
+
+static void ring_pop(uint32_t* dst, uint32_t frames)
+{
+  uint32_t first = g_capacity - g_head;
+  if (first > frames) first = frames;
+  memcpy(dst, g_ring + g_head, first * 4);
+  if (frames > first) memcpy(dst + first, g_ring, (frames - first) * 4);
+  g_head = (g_head + frames) % g_capacity;
+  g_count -= frames;
+}
+
+static void ring_clear(void)
+{
+  g_head = 0;
+  g_count = 0;
+}
+
+static bool is_silent(const int16_t* buf, int32_t frames)
+{
+  for (int32_t i = 0; i < frames * 2; i++)
+  {
+    if (buf[i] > XFADE_SILENCE_LEVEL || buf[i] < -XFADE_SILENCE_LEVEL) return false;
+  }
+  return true;
+}
+
+static inline int16_t clip16(int32_t v)
+{
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+// Początek B (buf) z końcówką A z bufora - wzmocnienia cos / sin
+static void mix_tail(int16_t* buf, int32_t frames)
+{
+  static uint32_t tail[1152];   // tylko tor audio - jeden wątek naraz
+  int32_t done = 0;
+  while (done < frames && g_count)
+  {
+    uint32_t n = frames - done;
+    if (n > g_count) n = g_count;
+    if (n > sizeof(tail) / 4) n = sizeof(tail) / 4;
+    ring_pop(tail, n);
+
+    const int16_t* a = (const int16_t*)tail;
+    int16_t* b = buf + done * 2;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t step = (uint32_t)((uint64_t)(g_fadePos + i) * FADE_STEPS / g_fadeTotal);
+      int32_t gIn = g_sine[step];
+      int32_t gOut = g_sine[FADE_STEPS - step];
+      b[i * 2]     = clip16(((int32_t)a[i * 2] * gOut + (int32_t)b[i * 2] * gIn) >> 15);
+      b[i * 2 + 1] = clip16(((int32_t)a[i * 2 + 1] * gOut + (int32_t)b[i * 2 + 1] * gIn) >> 15);
+    }
+    g_fadePos += n;
+    done += n;
+  }
+  if (!g_count) g_fadeTotal = 0;   // końcówka wymieszana - dalej sam utwór B
+}
+
+static void begin_track(bool automatic, uint32_t rate)
+{
+  g_trimming = automatic && g_gapless;
+  g_trimmed = 0;
+  g_gapPending = automatic && g_lastOutUs != 0;
+  g_fadeTotal = 0;
+  g_fadePos = 0;
+  g_skipCounter = 0;
+
+  if (g_count)
+  {
+    if (automatic && g_tailRate == rate)
+    {
+      g_fadeTotal = g_count;
+      portENTER_CRITICAL(&g_mux);
+      g_status.crossfades++;
+      g_status.lastFadeFrames = g_count;
+      portEXIT_CRITICAL(&g_mux);
+    }
+    else
+    {
+      ring_clear();
+      portENTER_CRITICAL(&g_mux);
+      g_status.tailsDropped++;
+      portEXIT_CRITICAL(&g_mux);
+    }
+  }
+  g_trackRate = rate;
+}
+
+static void note_gap(int64_t now, uint32_t rate)
+{
+  g_gapPending = false;
+  int64_t gap = (now - g_lastOutUs) * (int64_t)rate / 1000000 - g_lastOutFrames;
+  uint32_t samples = gap > 0 ? (uint32_t)gap : 0;
+
+  portENTER_CRITICAL(&g_mux);
+  g_status.transitions++;
+  g_status.lastGapSamples = samples;
+  g_status.lastGapRate = rate;
+  if (samples > g_status.maxGapSamples) g_status.maxGapSamples = samples;
+  g_gapSum += samples;
+  g_status.avgGapSamples = (uint32_t)(g_gapSum / g_status.transitions);
+  portEXIT_CRITICAL(&g_mux);
+}
+
+// ======================= NAGŁÓWKI PLIKÓW =======================
+
+static const uint32_t MP3_RATES[4][3] = {
+  {11025, 12000, 8000},    // MPEG 2.5
+  {0, 0, 0},
+  {22050, 24000, 16000},   // MPEG 2
+  {44100, 48000, 32000}    // MPEG 1
+};
+
+// Częstotliwość próbkowania z nagłówka (MP3, WAV, FLAC), 0 = nieznana
+static uint32_t file_sample_rate(const char* path)
+{
+  fs::File f = SD.open(path, FILE_READ);
+  if (!f) return 0;
+
+  uint8_t h[512];
+  size_t n = f.read(h, sizeof(h));
+  uint32_t rate = 0;
+
+  if (n >= 28 && memcmp(h, "RIFF", 4) == 0 && memcmp(h + 8, "WAVE", 4) == 0)
+  {
+    for (size_t p = 12; p + 16 <= n; )
+    {
+      uint32_t len = h[p + 4] | (h[p + 5] << 8) | (h[p + 6] << 16) | ((uint32_t)h[p + 7] << 24);
+      if (memcmp(h + p, "fmt ", 4) == 0) { rate = h[p + 12] | (h[p + 13] << 8) | (h[p + 14] << 16) | ((uint32_t)h[p + 15] << 24); break; }
+      p += 8 + len;
+    }
+  }
+  else if (n >= 21 && memcmp(h, "fLaC", 4) == 0)
+  {
+    rate = ((uint32_t)h[18] << 12) | (h[19] << 4) | (h[20] >> 4);   // STREAMINFO - 20 bitów
+  }
+  else
+  {
+    // MP3 - pominięcie ID3v2 i pierwsza poprawna ramka
+    uint32_t start = 0;
+    if (n >= 10 && memcmp(h, "ID3", 3) == 0)
+    {
+      start = 10 + (((uint32_t)(h[6] & 0x7F) << 21) | ((uint32_t)(h[7] & 0x7F) << 14) | ((h[8] & 0x7F) << 7) | (h[9] & 0x7F));
+      f.seek(start);
+      n = f.read(h, sizeof(h));
+    }
+    for (size_t p = 0; p + 4 <= n; p++)
+    {
+      if (h[p] != 0xFF || (h[p + 1] & 0xE0) != 0xE0) continue;
+      uint8_t version = (h[p + 1] >> 3) & 0x03;
+      uint8_t layer = (h[p + 1] >> 1) & 0x03;
+      uint8_t srIndex = (h[p + 2] >> 2) & 0x03;
+      if (version == 1 || layer == 0 || srIndex == 3 || (h[p + 2] >> 4) == 0x0F) continue;
+      rate = MP3_RATES[version][srIndex];
+      break;
+    }
+  }
+  f.close();
+  return rate;
+}
+
+// ======================= API =======================
+
+void xfade_set(bool gapless, uint8_t seconds)
+{
+  if (seconds > XFADE_MAX_SEC) seconds = XFADE_MAX_SEC;
+
+  if (seconds && !g_ring)
+  {
+    uint32_t capacity = (uint32_t)XFADE_MAX_SEC * XFADE_MAX_RATE + 4096;   // + największy blok dekodera
+    g_ring = (uint32_t*)ps_malloc(capacity * 4);
+    if (!g_ring)
+    {
+      Serial.println("debug xfade -> Brak PSRAM na bufor przenikania");
+      seconds = 0;
+    }
+    else
+    {
+      g_capacity = capacity;
+    }
+  }
+  if (!g_sine[FADE_STEPS])
+  {
+    for (uint16_t i = 0; i <= FADE_STEPS; i++) g_sine[i] = (int16_t)lroundf(32767.0f * sinf((float)i * (float)M_PI / (2.0f * FADE_STEPS)));
+  }
+
+  g_gapless = gapless || seconds;
+  g_seconds = seconds;
+  Serial.printf("debug xfade -> Gapless: %s, przenikanie: %u s\n", g_gapless ? "tak" : "nie", seconds);
+}
+
+bool xfade_gapless_enabled(void)
+{
+  return g_gapless;
+}
+
+bool xfade_prepare_next(const char* currentPath, const char* nextPath)
+{
+  bool compatible = false;
+  if (g_seconds)
+  {
+    uint32_t current = file_sample_rate(currentPath);
+    uint32_t next = file_sample_rate(nextPath);
+    compatible = current && current == next && current <= XFADE_MAX_RATE;
+    Serial.printf("debug xfade -> Następny utwór: %u Hz -> %u Hz, przenikanie %s\n",
+                  (unsigned)current, (unsigned)next, compatible ? "tak" : "nie");
+  }
+  g_nextCompatible = compatible;
+  return compatible;
+}
+
+void xfade_track_begin(bool automatic)
+{
+  // Zgodność dotyczyła pary poprzedni -> ten utwór; dla następnego ustali ją kolejne zgłoszenie
+  // (także po przejściu gapless - inaczej linia opóźniająca budowana wg nieaktualnej pary)
+  g_nextCompatible = false;
+  portENTER_CRITICAL(&g_mux);
+  if (g_beginReq != 1) g_beginReq = automatic ? 2 : 1;   // ręczna zmiana wygrywa
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void xfade_process(int16_t* buf, int32_t frames, uint32_t sampleRate, uint32_t remainingSec, bool* continueI2S)
+{
+  if (frames <= 0) return;
+
+  portENTER_CRITICAL(&g_mux);
+  uint8_t req = g_beginReq;
+  g_beginReq = 0;
+  portEXIT_CRITICAL(&g_mux);
+  if (req) begin_track(req == 2, sampleRate);
+
+  // Cisza cyfrowa na początku utworu po przejściu automatycznym
+  if (g_trimming)
+  {
+    if (is_silent(buf, frames) && (uint64_t)(g_trimmed + frames) * 1000 <= (uint64_t)XFADE_TRIM_MAX_MS * sampleRate)
+    {
+      g_trimmed += frames;
+      *continueI2S = false;
+      return;
+    }
+    g_trimming = false;
+    if (g_trimmed)
+    {
+      portENTER_CRITICAL(&g_mux);
+      g_status.trimmedFrames += g_trimmed;
+      portEXIT_CRITICAL(&g_mux);
+    }
+  }
+
+  if (g_fadeTotal)
+  {
+    mix_tail(buf, frames);
+  }
+  else if (g_ring && g_seconds && g_nextCompatible && sampleRate <= XFADE_MAX_RATE)
+  {
+    // Linia opóźniająca pod koniec utworu - budowa przez pomijanie co XFADE_SKIP_EVERY bloku
+    uint32_t target = (uint32_t)g_seconds * sampleRate;
+    uint32_t buildSec = (uint32_t)g_seconds * XFADE_SKIP_EVERY + XFADE_BUILD_MARGIN;
+    bool build = remainingSec && remainingSec <= buildSec && g_count < target;
+
+    if (g_count || build)
+    {
+      if (g_count + (uint32_t)frames > g_capacity) { ring_clear(); }   // nie powinno wystąpić - bufor na 48 kHz
+      ring_push((const uint32_t*)buf, frames);
+      g_tailRate = sampleRate;
+      if (build && ++g_skipCounter >= XFADE_SKIP_EVERY)
+      {
+        g_skipCounter = 0;
+        *continueI2S = false;   // blok tylko do bufora - dekoder wyprzedza wyjście
+        return;
+      }
+      ring_pop((uint32_t*)buf, frames);
+    }
+  }
+
+  int64_t now = esp_timer_get_time();
+  if (g_gapPending) note_gap(now, sampleRate);
+  g_lastOutUs = now;
+  g_lastOutFrames = frames;
+}
+
+void xfade_get_status(xfade_status_t* out)
+{
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+  out->gapless = g_gapless;
+  out->seconds = g_seconds;
+  out->nextCompatible = g_nextCompatible;
+  out->delayFrames = g_fadeTotal ? 0 : g_count;
+}
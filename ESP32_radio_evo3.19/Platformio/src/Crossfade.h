@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// CROSSFADE - przejścia między utworami odtwarzacza SD (gapless / przenikanie)
+// ========================================================================
+// Gapless: odtwarzacz SD wyznacza następny utwór zaraz po starcie bieżącego
+// i zgłasza go do AudioTask (audio_cmd_arm_next_file). Po końcu pliku
+// następny startuje od razu w kontekście dekodera - bez czekania na obieg
+// loop(). Cisza cyfrowa na początku następnego utworu jest pomijana.
+//
+// Przenikanie (equal-power, N sekund): biblioteka ma jeden dekoder, więc
+// końcówki utworu A nie da się dekodować równolegle z początkiem B.
+// Zamiast tego pod koniec A budowana jest linia opóźniająca w PSRAM -
+// co XFADE_SKIP_EVERY blok dekodera trafia tylko do bufora (continueI2S =
+// false), a na wyjście idą próbki z czoła bufora. Dekoder wyprzedza wyjście
+// o N sekund; po końcu pliku bufor trzyma niegraną końcówkę A, którą
+// audio_process_i2s() miesza z początkiem B (cos / sin ćwiartki okresu).
+// Przenikanie tylko przy zgodnej częstotliwości próbkowania obu plików
+// (nagłówki czytane przy zgłaszaniu następnego utworu).
+//
+// Przerwa między utworami mierzona jest w próbkach: czas od ostatniego
+// bloku A do pierwszego bloku B minus długość ostatniego bloku A
+// (szacunek na poziomie wywołań audio_process_i2s()).
+// ========================================================================
+
+static const uint8_t  XFADE_MAX_SEC        = 6;       // bufor linii opóźniającej: 6 s * 48 kHz stereo = 1.1 MB PSRAM
+static const uint32_t XFADE_MAX_RATE       = 48000;
+static const uint8_t  XFADE_SKIP_EVERY     = 4;       // co 4. blok do bufora - dekoder pracuje 4/3 szybciej niż wyjście
+static const uint8_t  XFADE_BUILD_MARGIN   = 2;       // [s] zapas przy starcie budowania linii
+static const uint16_t XFADE_TRIM_MAX_MS    = 500;     // maks. pomijana cisza na początku utworu
+static const int16_t  XFADE_SILENCE_LEVEL  = 2;       // |próbka| <= poziom = cisza cyfrowa
+
+typedef struct {
+  bool     gapless;
+  uint8_t  seconds;              // 0 = bez przenikania
+  bool     nextCompatible;       // następny utwór ma tę samą częstotliwość próbkowania
+  uint32_t delayFrames;          // bieżące opóźnienie wyjścia (ramki stereo)
+
+  uint32_t transitions;          // zmierzone przejścia automatyczne
+  uint32_t lastGapSamples;       // przerwa ostatniego przejścia (ramki)
+  uint32_t avgGapSamples;
+  uint32_t maxGapSamples;
+  uint32_t lastGapRate;          // częstotliwość, w której podano przerwę
+  uint32_t crossfades;           // przejścia z przenikaniem
+  uint32_t lastFadeFrames;       // długość ostatniego przenikania
+  uint32_t tailsDropped;         // końcówki odrzucone (inna częstotliwość, ręczna zmiana)
+  uint32_t trimmedFrames;        // pominięta cisza na początku utworów
+} xfade_status_t;
+
+// Konfiguracja (z readConfig), bufor PSRAM przydzielany przy pierwszym włączeniu przenikania
+void xfade_set(bool gapless, uint8_t seconds);
+bool xfade_gapless_enabled(void);   // gapless albo przenikanie - zgłaszanie następnego utworu
+
+// Odtwarzacz SD: nagłówki bieżącego i następnego pliku - zgodność dla przenikania
+bool xfade_prepare_next(const char* currentPath, const char* nextPath);
+
+// Nowy utwór - z dowolnego wątku przed startem pliku. automatic = przejście
+// po końcu poprzedniego (mieszanie końcówki, pomiar przerwy), inaczej końcówka
+// jest odrzucana (ręczna zmiana, stop).
+void xfade_track_begin(bool automatic);
+
+// Z audio_process_i2s() dla odtwarzacza SD. remainingSec = pozostały czas
+// pliku wg dekodera (0 = nieznany - bez linii opóźniającej)
+void xfade_process(int16_t* buf, int32_t frames, uint32_t sampleRate, uint32_t remainingSec, bool* continueI2S);
+
+void xfade_get_status(xfade_status_t* out);
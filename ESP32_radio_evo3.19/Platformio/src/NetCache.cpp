@@ -0,0 +1,189 @@
+#include "NetCache.h"
+#include <string.h>
+#include <lwip/netdb.h>
+
+// ======================= STAN =======================
+
+typedef struct {
+  net_host_info_t info;
+  uint32_t        lastUsed;   // millis() ostatniego użycia, 0 = wolny wpis
+} net_host_t;
+
+static portMUX_TYPE      g_mux = portMUX_INITIALIZER_UNLOCKED;
+static net_host_t        g_hosts[NET_CACHE_HOSTS];
+static net_cache_stats_t g_stats;
+
+static uint32_t          g_connectStartMs = 0;
+static char              g_connectHost[NET_HOST_LENGTH + 1] = "";
+static bool              g_connectHttps = false;
+
+// ======================= POMOCNICZE =======================
+
+// Średnia krocząca bez sumy (brak przepełnienia przy długiej pracy)
+static uint32_t running_avg(uint32_t avg, uint32_t value, uint32_t count)
+{
+  if (count <= 1) return value;
+  return (uint32_t)((int32_t)avg + ((int32_t)value - (int32_t)avg) / (int32_t)count);
+}
+
+// Wpis hosta - istniejący lub najstarszy do nadpisania (wywoływać w sekcji krytycznej)
+static net_host_t* host_entry(const char* host, uint32_t now)
+{
+  net_host_t* oldest = &g_hosts[0];
+  for (uint8_t i = 0; i < NET_CACHE_HOSTS; i++)
+  {
+    net_host_t* h = &g_hosts[i];
+    if (h->lastUsed && strcmp(h->info.host, host) == 0)
+    {
+      h->lastUsed = now ? now : 1;
+      return h;
+    }
+    if (h->lastUsed < oldest->lastUsed) oldest = h;
+  }
+
+  memset(oldest, 0, sizeof(*oldest));
+  strncpy(oldest->info.host, host, NET_HOST_LENGTH);
+  oldest->lastUsed = now ? now : 1;
+  return oldest;
+}
+
+// ======================= API =======================
+
+size_t net_url_host(const char* url, char* out, size_t outSize)
+{
+  if (!url || !out || outSize == 0) return 0;
+  out[0] = '\0';
+
+  const char* p = strstr(url, "://");
+  if (!p) return 0;
+  p += 3;
+
+  const char* at = strpbrk(p, "@/");             // pomijamy ewentualne user:pass@
+  if (at && *at == '@') p = at + 1;
+
+  size_t n = 0;
+  while (p[n] && p[n] != ':' && p[n] != '/' && p[n] != '?' && n + 1 < outSize)
+  {
+    out[n] = p[n];
+    n++;
+  }
+  out[n] = '\0';
+  return n;
+}
+
+// getaddrinfo() idzie przez wątek tcpip - wynik zostaje w cache DNS lwIP
+// i następne connect() (audio, HTTPClient) nie pyta już serwera DNS
+bool net_dns_resolve(const char* host, uint32_t* addr)
+{
+  if (!host || !*host) return false;
+
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo* res = nullptr;
+  uint32_t t0 = millis();
+  int err = getaddrinfo(host, nullptr, &hints, &res);
+  uint32_t dt = millis() - t0;
+
+  bool ok = (err == 0 && res && res->ai_addr);
+  if (ok && addr) *addr = ((struct sockaddr_in*)res->ai_addr)->sin_addr.s_addr;
+  if (res) freeaddrinfo(res);
+
+  portENTER_CRITICAL(&g_mux);
+  net_host_t* h = host_entry(host, millis());
+  if (!ok)
+  {
+    g_stats.dnsFailed++;
+  }
+  else if (dt < NET_DNS_HIT_MS)
+  {
+    g_stats.dnsHits++;
+    if (h->info.hits < UINT16_MAX) h->info.hits++;
+  }
+  else
+  {
+    g_stats.dnsMisses++;
+    g_stats.dnsMissAvgMs = running_avg(g_stats.dnsMissAvgMs, dt, g_stats.dnsMisses);
+    if (h->info.misses < UINT16_MAX) h->info.misses++;
+  }
+  portEXIT_CRITICAL(&g_mux);
+
+  if (!ok) Serial.printf("debug net -> Błąd DNS dla hosta %s (%d)\n", host, err);
+  return ok;
+}
+
+void net_connect_begin(const char* url)
+{
+  g_connectHost[0] = '\0';
+  if (!net_url_host(url, g_connectHost, sizeof(g_connectHost))) return;
+
+  g_connectHttps = (strncmp(url, "https://", 8) == 0);
+  net_dns_resolve(g_connectHost, nullptr);
+  g_connectStartMs = millis();
+}
+
+void net_connect_end(bool ok)
+{
+  if (!g_connectHost[0]) return;
+
+  uint32_t dt = millis() - g_connectStartMs;
+
+  portENTER_CRITICAL(&g_mux);
+  if (ok)
+  {
+    net_host_t* h = host_entry(g_connectHost, millis());
+    h->info.connectMs = dt;
+    h->info.https = g_connectHttps;
+
+    if (g_connectHttps)
+    {
+      g_stats.tlsConnects++;
+      g_stats.tlsAvgMs = running_avg(g_stats.tlsAvgMs, dt, g_stats.tlsConnects);
+      g_stats.tlsLastMs = dt;
+    }
+    else
+    {
+      g_stats.tcpConnects++;
+      g_stats.tcpAvgMs = running_avg(g_stats.tcpAvgMs, dt, g_stats.tcpConnects);
+    }
+  }
+  portEXIT_CRITICAL(&g_mux);
+
+  Serial.printf("debug net -> Połączenie %s %s: %u ms\n", g_connectHttps ? "https" : "http", g_connectHost, (unsigned)dt);
+  g_connectHost[0] = '\0';
+}
+
+void net_cache_get_stats(net_cache_stats_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+uint8_t net_cache_get_hosts(net_host_info_t* out, uint8_t maxHosts)
+{
+  if (!out) return 0;
+
+  net_host_t copy[NET_CACHE_HOSTS];
+  portENTER_CRITICAL(&g_mux);
+  memcpy(copy, g_hosts, sizeof(copy));
+  portEXIT_CRITICAL(&g_mux);
+
+  // Sortowanie przez wybór - od ostatnio używanego
+  uint8_t n = 0;
+  while (n < maxHosts)
+  {
+    int best = -1;
+    for (uint8_t i = 0; i < NET_CACHE_HOSTS; i++)
+    {
+      if (copy[i].lastUsed && (best < 0 || copy[i].lastUsed > copy[best].lastUsed)) best = i;
+    }
+    if (best < 0) break;
+    out[n++] = copy[best].info;
+    copy[best].lastUsed = 0;
+  }
+  return n;
+}
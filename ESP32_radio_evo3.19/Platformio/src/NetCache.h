@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// NET CACHE - wspólna obsługa nazw hostów i pomiar połączeń
+// ========================================================================
+// Wszystkie połączenia wychodzące (stacje, pobieranie banków, granie URL)
+// przechodzą przez net_connect_begin() / net_connect_end():
+//   1. nazwa hosta rozwiązywana jest przez getaddrinfo() - wynik trafia
+//      do cache DNS lwIP, który przestrzega TTL z odpowiedzi serwera.
+//      Odpowiedź bez zapytania sieciowego (< NET_DNS_HIT_MS) = trafienie.
+//   2. czas połączenia (TCP + TLS dla https + nagłówki) zapisywany jest
+//      per host - dla https jest to praktycznie czas handshake TLS.
+//
+// Wznawianie sesji TLS nie jest dostępne - WiFiClientSecure i biblioteka
+// ESP32-audioI2S nie udostępniają kontekstu mbedTLS przed handshake.
+// ========================================================================
+
+static const uint8_t  NET_CACHE_HOSTS    = 16;    // śledzone hosty (LRU)
+static const uint8_t  NET_HOST_LENGTH    = 64;    // maksymalna długość nazwy hosta
+static const uint32_t NET_DNS_HIT_MS     = 3;     // szybciej = odpowiedź z cache lwIP
+
+typedef struct {
+  uint32_t dnsHits;
+  uint32_t dnsMisses;
+  uint32_t dnsFailed;
+  uint32_t dnsMissAvgMs;     // średni czas zapytania DNS przy braku w cache
+  uint32_t tlsConnects;      // połączenia https
+  uint32_t tlsAvgMs;         // średni czas połączenia https (handshake TLS)
+  uint32_t tlsLastMs;
+  uint32_t tcpConnects;      // połączenia http
+  uint32_t tcpAvgMs;
+} net_cache_stats_t;
+
+typedef struct {
+  char     host[NET_HOST_LENGTH + 1];
+  uint16_t hits;
+  uint16_t misses;
+  uint32_t connectMs;        // ostatni czas połączenia
+  bool     https;
+} net_host_info_t;
+
+// Nazwa hosta z "http(s)://host[:port]/..." - zwraca długość, 0 = błąd
+size_t   net_url_host(const char* url, char* out, size_t outSize);
+
+// Rozwiązanie nazwy (bezpieczne z dowolnego zadania), addr w kolejności sieciowej
+bool     net_dns_resolve(const char* host, uint32_t* addr);
+
+// Pomiar połączenia - tylko z pętli głównej, jedno połączenie naraz
+void     net_connect_begin(const char* url);   // rozwiązuje host i startuje stoper
+void     net_connect_end(bool ok);
+
+// Statystyki
+void     net_cache_get_stats(net_cache_stats_t* out);
+uint8_t  net_cache_get_hosts(net_host_info_t* out, uint8_t maxHosts);  // najświeższe pierwsze
@@ -0,0 +1,599 @@
+#include "ReplayGain.h"
+#include "SdIo.h"
+#include "SDPlayer/MediaLibrary.h"
+#include "SDPlayer/DirIndex.h"
+#include "SDPlayer/PlayerState.h"   // odtwarzanie z karty w toku
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <math.h>
+#include <string.h>
+
+// ======================= STAN =======================
+
+// Wynik analizy pliku (rekord RGAIN_ANALYSIS_FILE)
+typedef struct {
+  uint32_t pathHash;      // media_lib_path_hash()
+  uint32_t albumKey;      // media_lib_cover_key() - katalog + album
+  int16_t  gainCdb;       // MEDIA_GAIN_NONE = plik nieobsługiwany (bez ponawiania)
+  uint16_t peak;          // Q15
+  uint32_t durationSec;
+} rgain_entry_t;
+
+// Wzmocnienie wyznaczone dla pliku
+typedef struct {
+  int32_t  q;             // Q12
+  int16_t  cdb;
+  uint8_t  source;        // rgain_source_t
+  bool     limited;
+} rgain_gain_t;
+
+static const char     FILE_MAGIC[4]  = { 'E', 'V', 'R', 'G' };
+static const uint16_t FILE_VERSION   = 1;
+static const uint32_t FILE_HEADER    = 8;
+
+// Histogram głośności bloków 400 ms: -70..+5 LUFS co 0.1 LU
+static const uint16_t HIST_BINS      = 750;
+static const float    HIST_MIN_LUFS  = -70.0f;
+
+static portMUX_TYPE      g_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile int32_t  g_gainQ = RGAIN_UNITY;   // czytane w torze próbek
+static volatile uint8_t  g_mode = RGAIN_MODE_OFF;
+static rgain_gain_t      g_next;                  // następny utwór gapless (pod g_mux)
+static bool              g_nextValid = false;
+
+static SemaphoreHandle_t g_lock = nullptr;        // wyniki analizy
+static rgain_entry_t*    g_entries = nullptr;
+static uint16_t          g_entryCount = 0;
+
+static rgain_status_t    g_status;
+static uint32_t          g_analysisMs = 0;        // suma czasu analizy (tempo)
+static uint64_t          g_audioMs = 0;           // suma czasu audio przeanalizowanych plików
+static uint8_t*          g_ioBuf = nullptr;       // tylko zadanie analizy
+static uint32_t*         g_hist = nullptr;
+
+static void* rg_malloc(size_t size)
+{
+  void* p = psramFound() ? ps_malloc(size) : nullptr;
+  return p ? p : malloc(size);
+}
+
+// ======================= WYNIKI ANALIZY =======================
+
+static void entries_load(void)
+{
+  g_entries = (rgain_entry_t*)rg_malloc(RGAIN_MAX_ANALYSED * sizeof(rgain_entry_t));
+  if (!g_entries) return;
+
+  File f = SD.open(RGAIN_ANALYSIS_FILE, FILE_READ);
+  if (!f) return;
+  uint8_t h[FILE_HEADER];
+  bool ok = f.read(h, sizeof(h)) == sizeof(h) && memcmp(h, FILE_MAGIC, 4) == 0 && (h[4] | (h[5] << 8)) == FILE_VERSION;
+  uint32_t count = ok ? (f.size() - FILE_HEADER) / sizeof(rgain_entry_t) : 0;
+  if (count > RGAIN_MAX_ANALYSED) count = RGAIN_MAX_ANALYSED;
+  if (count) ok = f.read((uint8_t*)g_entries, count * sizeof(rgain_entry_t)) == count * sizeof(rgain_entry_t);
+  f.close();
+  if (ok) {
+    g_entryCount = count;
+  } else {
+    SD.remove(RGAIN_ANALYSIS_FILE);
+    Serial.println("debug rgain -> Plik wyników analizy uszkodzony - usunięty");
+  }
+}
+
+// Numer wyniku dla pliku, -1 = brak (pod g_lock)
+static int32_t entry_find(uint32_t pathHash)
+{
+  for (uint16_t i = 0; i < g_entryCount; i++) {
+    if (g_entries[i].pathHash == pathHash) return i;
+  }
+  return -1;
+}
+
+// Album z analizy: energia utworów ważona czasem, szczyt = największy (pod g_lock). Min. 2 utwory
+static bool entry_album(uint32_t albumKey, int16_t* gainCdb, uint16_t* peak)
+{
+  float energy = 0.0f;
+  float seconds = 0.0f;
+  uint16_t tracks = 0;
+  *peak = 0;
+  for (uint16_t i = 0; i < g_entryCount; i++) {
+    const rgain_entry_t* e = &g_entries[i];
+    if (e->albumKey != albumKey || e->gainCdb == MEDIA_GAIN_NONE || !e->durationSec) continue;
+    float lufs = RGAIN_REFERENCE_LUFS - e->gainCdb / 100.0f;
+    energy += e->durationSec * powf(10.0f, lufs / 10.0f);
+    seconds += e->durationSec;
+    if (e->peak > *peak) *peak = e->peak;
+    tracks++;
+  }
+  if (tracks < 2 || energy <= 0.0f) return false;
+  float lufs = 10.0f * log10f(energy / seconds);
+  *gainCdb = (int16_t)lroundf((RGAIN_REFERENCE_LUFS - lufs) * 100.0f);
+  return true;
+}
+
+static bool entry_add(const rgain_entry_t* e)
+{
+  if (!g_entries || g_entryCount >= RGAIN_MAX_ANALYSED) return false;
+
+  sdio_begin(SDIO_CLASS_LOUDNESS, 0);
+  bool fresh = !SD.exists(RGAIN_ANALYSIS_FILE);
+  File f = SD.open(RGAIN_ANALYSIS_FILE, fresh ? FILE_WRITE : FILE_APPEND);
+  bool ok = (bool)f;
+  if (ok && fresh) {
+    uint8_t h[FILE_HEADER] = { 0 };
+    memcpy(h, FILE_MAGIC, 4);
+    h[4] = FILE_VERSION & 0xFF; h[5] = FILE_VERSION >> 8;
+    ok = f.write(h, sizeof(h)) == sizeof(h);
+  }
+  ok = ok && f.write((const uint8_t*)e, sizeof(rgain_entry_t)) == sizeof(rgain_entry_t);
+  if (f) f.close();
+  sdio_end(SDIO_CLASS_LOUDNESS, sizeof(rgain_entry_t));
+
+  // Wynik w pamięci także przy błędzie zapisu - bez ponownej analizy do restartu
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_entries[g_entryCount++] = *e;
+  g_status.analysed = g_entryCount;
+  xSemaphoreGive(g_lock);
+  return ok;
+}
+
+// ======================= WZMOCNIENIE =======================
+
+static void gain_for(const char* path, rgain_gain_t* g)
+{
+  memset(g, 0, sizeof(rgain_gain_t));
+  g->q = RGAIN_UNITY;
+  uint8_t mode = g_mode;
+  if (mode == RGAIN_MODE_OFF || !path || !path[0]) return;
+
+  int32_t cdb = MEDIA_GAIN_NONE;
+  uint16_t peak = 0;
+  media_info_t info;
+  if (media_lib_lookup(path, &info)) {
+    if (mode == RGAIN_MODE_ALBUM && info.albumGain != MEDIA_GAIN_NONE) {
+      cdb = info.albumGain;
+      peak = info.albumPeak;
+      g->source = RGAIN_SRC_ALBUM_TAG;
+    } else if (info.trackGain != MEDIA_GAIN_NONE) {
+      cdb = info.trackGain;
+      peak = info.trackPeak;
+      g->source = RGAIN_SRC_TRACK_TAG;
+    }
+  }
+
+  if (cdb == MEDIA_GAIN_NONE && g_lock) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    int32_t i = entry_find(media_lib_path_hash(path));
+    if (i >= 0 && g_entries[i].gainCdb != MEDIA_GAIN_NONE) {
+      int16_t albumCdb;
+      uint16_t albumPeak;
+      if (mode == RGAIN_MODE_ALBUM && entry_album(g_entries[i].albumKey, &albumCdb, &albumPeak)) {
+        cdb = albumCdb;
+        peak = albumPeak;
+        g->source = RGAIN_SRC_ALBUM_ANALYSIS;
+      } else {
+        cdb = g_entries[i].gainCdb;
+        peak = g_entries[i].peak;
+        g->source = RGAIN_SRC_TRACK_ANALYSIS;
+      }
+    }
+    xSemaphoreGive(g_lock);
+  }
+
+  if (cdb == MEDIA_GAIN_NONE) {
+    cdb = RGAIN_UNTAGGED_CDB;
+    g->source = RGAIN_SRC_DEFAULT;
+  }
+  cdb += RGAIN_PREAMP_CDB;
+  if (cdb > RGAIN_MAX_BOOST_CDB) cdb = RGAIN_MAX_BOOST_CDB;
+  if (cdb < RGAIN_MIN_CDB) cdb = RGAIN_MIN_CDB;
+
+  // Szczyt po wzmocnieniu <= pełna skala
+  float linear = powf(10.0f, cdb / 2000.0f);
+  if (peak) {
+    float p = peak / 32768.0f;
+    if (linear * p > 1.0f) {
+      linear = 1.0f / p;
+      cdb = lroundf(2000.0f * log10f(linear));
+      g->limited = true;
+    }
+  }
+  g->q = lroundf(linear * RGAIN_UNITY);
+  g->cdb = cdb;
+}
+
+// Włączenie wzmocnienia (pod g_mux)
+static void gain_apply(const rgain_gain_t* g)
+{
+  g_gainQ = g->q;
+  g_status.gainCdb = g->cdb;
+  g_status.source = g->source;
+  g_status.peakLimited = g->limited;
+  if (g->source == RGAIN_SRC_NONE) return;
+  g_status.tracks++;
+  if (g->source == RGAIN_SRC_TRACK_TAG || g->source == RGAIN_SRC_ALBUM_TAG) g_status.fromTags++;
+  else if (g->source == RGAIN_SRC_DEFAULT) g_status.untagged++;
+  else g_status.fromAnalysis++;
+}
+
+// ======================= ANALIZA GŁOŚNOŚCI =======================
+
+typedef struct {
+  float b0, b1, b2, a1, a2;
+} biquad_t;
+
+typedef struct {
+  float z1, z2;
+} biquad_state_t;
+
+// Filtr K (BS.1770) dla dowolnej częstotliwości: półka wysokich tonów + górnoprzepustowy RLB
+static void k_filter(uint32_t rate, biquad_t* shelf, biquad_t* highpass)
+{
+  float k = tanf(PI * 1681.974450955533f / rate);
+  float q = 0.7071752369554196f;
+  float vh = powf(10.0f, 3.999843853973347f / 20.0f);
+  float vb = powf(vh, 0.4996667741545416f);
+  float a0 = 1.0f + k / q + k * k;
+  shelf->b0 = (vh + vb * k / q + k * k) / a0;
+  shelf->b1 = 2.0f * (k * k - vh) / a0;
+  shelf->b2 = (vh - vb * k / q + k * k) / a0;
+  shelf->a1 = 2.0f * (k * k - 1.0f) / a0;
+  shelf->a2 = (1.0f - k / q + k * k) / a0;
+
+  k = tanf(PI * 38.13547087602444f / rate);
+  q = 0.5003270373238773f;
+  a0 = 1.0f + k / q + k * k;
+  highpass->b0 = 1.0f;
+  highpass->b1 = -2.0f;
+  highpass->b2 = 1.0f;
+  highpass->a1 = 2.0f * (k * k - 1.0f) / a0;
+  highpass->a2 = (1.0f - k / q + k * k) / a0;
+}
+
+static inline float biquad_run(const biquad_t* c, biquad_state_t* s, float x)
+{
+  float y = c->b0 * x + s->z1;
+  s->z1 = c->b1 * x - c->a1 * y + s->z2;
+  s->z2 = c->b2 * x - c->a2 * y;
+  return y;
+}
+
+typedef struct {
+  uint32_t rate;
+  uint16_t channels;
+  uint16_t bits;
+  uint32_t dataStart;
+  uint32_t dataLen;
+} wav_format_t;
+
+static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+// RIFF/WAVE: fmt (PCM albo EXTENSIBLE z PCM) + data; 16 / 24 bit, 1-2 kanały
+static bool wav_format(File& f, wav_format_t* w)
+{
+  uint8_t h[40];
+  memset(w, 0, sizeof(wav_format_t));
+  if (f.read(h, 12) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) return false;
+  uint32_t size = f.size();
+  uint32_t pos = 12;
+  bool pcm = false;
+  for (uint8_t chunk = 0; chunk < 32 && pos + 8 <= size; chunk++) {
+    f.seek(pos);
+    if (f.read(h, 8) != 8) return false;
+    uint32_t len = le32(h + 4);
+    if (memcmp(h, "fmt ", 4) == 0 && len >= 16) {
+      size_t n = len < sizeof(h) ? len : sizeof(h);
+      if (f.read(h, n) != n) return false;
+      uint16_t tag = h[0] | (h[1] << 8);
+      if (tag == 0xFFFE && n >= 26) tag = h[24] | (h[25] << 8);   // podformat EXTENSIBLE
+      pcm = tag == 1;
+      w->channels = h[2] | (h[3] << 8);
+      w->rate = le32(h + 4);
+      w->bits = h[14] | (h[15] << 8);
+    } else if (memcmp(h, "data", 4) == 0) {
+      w->dataStart = pos + 8;
+      w->dataLen = len < size - w->dataStart ? len : size - w->dataStart;
+      break;
+    }
+    pos += 8 + len + (len & 1);
+  }
+  return pcm && w->dataLen && (w->bits == 16 || w->bits == 24) && w->channels >= 1 && w->channels <= 2 &&
+         w->rate >= 8000 && w->rate <= RGAIN_MAX_ANALYSIS_RATE;
+}
+
+// Głośność zintegrowana z histogramu bloków: bramka -70 LUFS, potem -10 LU względem średniej
+static bool hist_integrated(float* lufs)
+{
+  float sum = 0.0f;
+  uint32_t count = 0;
+  for (uint16_t i = 0; i < HIST_BINS; i++) {
+    if (!g_hist[i]) continue;
+    sum += g_hist[i] * powf(10.0f, (HIST_MIN_LUFS + (i + 0.5f) / 10.0f + 0.691f) / 10.0f);
+    count += g_hist[i];
+  }
+  if (!count) return false;
+  float gate = -0.691f + 10.0f * log10f(sum / count) - 10.0f;
+
+  sum = 0.0f;
+  count = 0;
+  for (uint16_t i = 0; i < HIST_BINS; i++) {
+    float center = HIST_MIN_LUFS + (i + 0.5f) / 10.0f;
+    if (!g_hist[i] || center < gate) continue;
+    sum += g_hist[i] * powf(10.0f, (center + 0.691f) / 10.0f);
+    count += g_hist[i];
+  }
+  if (!count) return false;
+  *lufs = -0.691f + 10.0f * log10f(sum / count);
+  return true;
+}
+
+// Jeden plik: 1 = wynik, 0 = nieobsługiwany, -1 = przerwany (start odtwarzania)
+static int8_t analyse_file(const char* path, rgain_entry_t* out)
+{
+  File f = SD.open(path, FILE_READ);
+  if (!f) return 0;
+  wav_format_t w;
+  if (!wav_format(f, &w)) {
+    f.close();
+    return 0;
+  }
+
+  biquad_t shelf, highpass;
+  k_filter(w.rate, &shelf, &highpass);
+  biquad_state_t state[2][2];
+  memset(state, 0, sizeof(state));
+  memset(g_hist, 0, HIST_BINS * sizeof(uint32_t));
+
+  uint8_t bytes = w.bits / 8;
+  uint32_t frameBytes = w.channels * bytes;
+  uint32_t subFrames = w.rate / 10;          // 100 ms - krok bloków 400 ms
+  uint32_t chunk = RGAIN_IO_CHUNK - RGAIN_IO_CHUNK % frameBytes;
+  float sub[4] = { 0 };
+  uint32_t subs = 0;
+  float subSum = 0.0f;
+  uint32_t subCount = 0;
+  uint32_t peak = 0;
+  uint64_t frames = 0;
+  uint32_t remaining = w.dataLen - w.dataLen % frameBytes;
+
+  f.seek(w.dataStart);
+  while (remaining) {
+    if (player_state_playing() || g_mode == RGAIN_MODE_OFF) {
+      f.close();
+      return -1;
+    }
+    uint32_t want = remaining < chunk ? remaining : chunk;
+    sdio_begin(SDIO_CLASS_LOUDNESS, 0);
+    uint32_t got = f.read(g_ioBuf, want);
+    sdio_end(SDIO_CLASS_LOUDNESS, got);
+    got -= got % frameBytes;
+    if (!got) break;
+
+    for (const uint8_t* p = g_ioBuf; p < g_ioBuf + got; ) {
+      for (uint8_t ch = 0; ch < w.channels; ch++, p += bytes) {
+        // Próbka w skali 24 bit
+        int32_t v = bytes == 2 ? (int16_t)(p[0] | (p[1] << 8)) * 256
+                               : (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) / 256;
+        uint32_t a = v < 0 ? -v : v;
+        if (a > peak) peak = a;
+        float y = biquad_run(&highpass, &state[ch][1], biquad_run(&shelf, &state[ch][0], v / 8388608.0f));
+        subSum += y * y;
+      }
+      if (++subCount < subFrames) continue;
+
+      // Blok 400 ms = średnia czterech ostatnich podbloków 100 ms
+      sub[subs++ % 4] = subSum / subFrames;
+      subSum = 0.0f;
+      subCount = 0;
+      if (subs < 4) continue;
+      float z = (sub[0] + sub[1] + sub[2] + sub[3]) / 4.0f;
+      if (z <= 0.0f) continue;
+      float lufs = -0.691f + 10.0f * log10f(z);
+      if (lufs < HIST_MIN_LUFS) continue;
+      int32_t bin = (int32_t)((lufs - HIST_MIN_LUFS) * 10.0f);
+      g_hist[bin < HIST_BINS ? bin : HIST_BINS - 1]++;
+    }
+    remaining -= got;
+    frames += got / frameBytes;
+    vTaskDelay(1);
+  }
+  f.close();
+
+  float lufs;
+  if (!hist_integrated(&lufs)) return 0;   // cisza / plik krótszy niż 400 ms
+  float gain = (RGAIN_REFERENCE_LUFS - lufs) * 100.0f;
+  out->gainCdb = (int16_t)lroundf(gain < -32000.0f ? -32000.0f : gain > 32000.0f ? 32000.0f : gain);
+  out->peak = (peak >> 8) > 65535 ? 65535 : (peak >> 8);
+  out->durationSec = frames / w.rate;
+  g_status.lastLufs10 = (int16_t)lroundf(lufs * 10.0f);
+  return 1;
+}
+
+// Przegląd biblioteki: pliki PCM bez tagów i bez wyniku. false = przerwany
+static bool analysis_sweep(void)
+{
+  char path[DIR_PATH_LENGTH + DIR_NAME_LENGTH + 2];
+  media_info_t info;
+  for (uint32_t i = 0; media_lib_record_at(i, path, sizeof(path), &info); i++) {
+    if (info.format != DIR_TYPE_WAV || info.trackGain != MEDIA_GAIN_NONE) continue;
+    uint32_t hash = media_lib_path_hash(path);
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    bool known = entry_find(hash) >= 0;
+    xSemaphoreGive(g_lock);
+    if (known) continue;
+    if (g_entryCount >= RGAIN_MAX_ANALYSED) return true;
+
+    rgain_entry_t e;
+    memset(&e, 0, sizeof(e));
+    uint32_t t0 = millis();
+    int8_t result = analyse_file(path, &e);
+    if (result < 0) {
+      g_status.analysisAborted++;
+      return false;
+    }
+    uint32_t ms = millis() - t0;
+    e.pathHash = hash;
+    e.albumKey = media_lib_cover_key(path);
+    if (result == 0) {
+      e.gainCdb = MEDIA_GAIN_NONE;
+      g_status.analysisFailed++;
+      Serial.printf("debug rgain -> Analiza: plik nieobsługiwany %s\n", path);
+    } else {
+      g_analysisMs += ms;
+      g_audioMs += (uint64_t)e.durationSec * 1000;
+      g_status.passFiles++;
+      g_status.lastFileMs = ms;
+      g_status.filesPerMin10 = g_analysisMs ? (uint64_t)g_status.passFiles * 600000ULL / g_analysisMs : 0;
+      g_status.realtime10 = g_analysisMs ? g_audioMs * 10 / g_analysisMs : 0;
+      Serial.printf("debug rgain -> Analiza: %s %s%d.%d LUFS, wzmocnienie %d cdB, %u ms, %u.%u plików/min\n",
+                    path, g_status.lastLufs10 < 0 ? "-" : "", abs(g_status.lastLufs10) / 10, abs(g_status.lastLufs10) % 10,
+                    e.gainCdb, (unsigned)ms,
+                    (unsigned)(g_status.filesPerMin10 / 10), (unsigned)(g_status.filesPerMin10 % 10));
+    }
+    entry_add(&e);
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+static void rgain_task(void* arg)
+{
+  uint32_t idleSince = millis();
+  uint32_t sweepEnd = 0;
+  uint32_t sweepPasses = UINT32_MAX;   // przebieg indeksera, po którym był ostatni przegląd
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    if (g_mode == RGAIN_MODE_OFF) {
+      g_status.analysisState = RGAIN_ANALYSIS_OFF;
+      sweepPasses = UINT32_MAX;
+      continue;
+    }
+
+    // Bezczynność: bez odtwarzania z karty i bez indeksowania przez RGAIN_IDLE_MS
+    media_lib_status_t lib;
+    media_lib_get_status(&lib);
+    if (player_state_playing() || lib.state == MEDIA_LIB_SCANNING || lib.state == MEDIA_LIB_SAVING || !lib.passes) {
+      idleSince = millis();
+      if (g_status.analysisState != RGAIN_ANALYSIS_DONE) g_status.analysisState = RGAIN_ANALYSIS_WAITING;
+      continue;
+    }
+    if (millis() - idleSince < RGAIN_IDLE_MS) continue;
+    if (lib.passes == sweepPasses && millis() - sweepEnd < RGAIN_SWEEP_MS) continue;
+
+    g_status.analysisState = RGAIN_ANALYSIS_RUNNING;
+    if (analysis_sweep()) {
+      g_status.analysisState = RGAIN_ANALYSIS_DONE;
+      sweepPasses = lib.passes;
+      sweepEnd = millis();
+    } else {
+      g_status.analysisState = RGAIN_ANALYSIS_WAITING;
+      idleSince = millis();
+    }
+  }
+}
+
+// ======================= API =======================
+
+void rgain_init(void)
+{
+  if (g_lock) return;
+  g_lock = xSemaphoreCreateMutex();
+  g_ioBuf = (uint8_t*)rg_malloc(RGAIN_IO_CHUNK);
+  g_hist = (uint32_t*)rg_malloc(HIST_BINS * sizeof(uint32_t));
+  if (!g_lock || !g_ioBuf || !g_hist) {
+    Serial.println("debug rgain -> Brak pamięci - analiza głośności wyłączona");
+    return;
+  }
+
+  entries_load();
+  g_status.analysed = g_entryCount;
+  Serial.printf("debug rgain -> Wyniki analizy: %u plików\n", (unsigned)g_entryCount);
+
+  if (xTaskCreatePinnedToCore(rgain_task, "RGain", 4096, NULL, 1, NULL, 0) != pdPASS) {
+    Serial.println("debug rgain -> Nie można uruchomić zadania analizy");
+  }
+}
+
+void rgain_set_mode(uint8_t mode)
+{
+  if (mode > RGAIN_MODE_ALBUM) mode = RGAIN_MODE_OFF;
+  g_mode = mode;
+  g_status.mode = mode;
+  if (mode == RGAIN_MODE_OFF) {
+    // Wyłączenie od razu; włączenie / zmiana trybu - od następnego utworu
+    rgain_gain_t g;
+    gain_for(nullptr, &g);
+    portENTER_CRITICAL(&g_mux);
+    gain_apply(&g);
+    g_nextValid = false;
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+void rgain_select(const char* path)
+{
+  rgain_gain_t g;
+  gain_for(path, &g);
+  portENTER_CRITICAL(&g_mux);
+  gain_apply(&g);
+  g_nextValid = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void rgain_prepare_next(const char* path)
+{
+  rgain_gain_t g;
+  gain_for(path, &g);
+  portENTER_CRITICAL(&g_mux);
+  g_next = g;
+  g_nextValid = true;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void rgain_track_begin(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_nextValid) gain_apply(&g_next);
+  g_nextValid = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void rgain_process(int16_t* buf, int32_t frames)
+{
+  int32_t g = g_gainQ;
+  if (g == RGAIN_UNITY || frames <= 0) return;
+
+  uint32_t clipped = 0;
+  for (int32_t i = 0, n = frames * 2; i < n; i++) {
+    int32_t v = (buf[i] * g) >> RGAIN_Q_BITS;   // jedno mnożenie na próbkę
+    if (v > 32767) { v = 32767; clipped++; }
+    else if (v < -32768) { v = -32768; clipped++; }
+    buf[i] = (int16_t)v;
+  }
+  if (clipped) {
+    portENTER_CRITICAL(&g_mux);
+    g_status.clippedSamples += clipped;
+    portEXIT_CRITICAL(&g_mux);
+  }
+}
+
+void rgain_get_status(rgain_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+const char* rgain_source_name(uint8_t source)
+{
+  switch (source) {
+    case RGAIN_SRC_TRACK_TAG:      return "track_tag";
+    case RGAIN_SRC_ALBUM_TAG:      return "album_tag";
+    case RGAIN_SRC_TRACK_ANALYSIS: return "track_analysis";
+    case RGAIN_SRC_ALBUM_ANALYSIS: return "album_analysis";
+    case RGAIN_SRC_DEFAULT:        return "default";
+    default:                       return "none";
+  }
+}
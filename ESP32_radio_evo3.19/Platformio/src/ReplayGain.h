@@ -0,0 +1,107 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// REPLAYGAIN - wyrównanie głośności utworów odtwarzacza SD
+// ========================================================================
+// Źródło wzmocnienia dla pliku (w tej kolejności):
+//   1. tagi ReplayGain / R128 z biblioteki (MediaLibrary czyta je przy
+//      indeksowaniu) - tryb albumu bierze wartość albumu, bez niej utworu,
+//   2. własna analiza głośności (ITU-R BS.1770 / EBU R128: filtr K,
+//      bloki 400 ms co 100 ms, bramka bezwzględna -70 LUFS i względna
+//      -10 LU) - wynik w RGAIN_ANALYSIS_FILE; album = średnia energii
+//      przeanalizowanych utworów tego albumu ważona czasem,
+//   3. RGAIN_UNTAGGED_CDB dla plików bez danych.
+// Poziom odniesienia ReplayGain 2.0: -18 LUFS.
+//
+// Ochrona przed przesterowaniem: przy znanym szczycie wzmocnienie
+// ograniczone do 1 / szczyt, pozostałe przekroczenia nasycane.
+// Koszt w torze próbek: jedno mnożenie na próbkę (Q12), wzmocnienie 1.0
+// - bez pętli. Wzmocnienie liczone poza torem: ręczny start pliku
+// (rgain_select) albo zgłoszenie następnego utworu gapless
+// (rgain_prepare_next) - w kontekście dekodera tylko podmiana liczby
+// (rgain_track_begin).
+//
+// Analiza w tle (zadanie "RGain", rdzeń 0) tylko gdy urządzenie nie gra
+// z karty: jeden dekoder biblioteki audio jest zajęty odtwarzaniem, więc
+// analizowane są pliki PCM (WAV 16 / 24 bit) bez tagów - skompresowane
+// formaty muszą mieć tagi (np. z foobar2000 / loudgain). Tempo analizy
+// w plikach na minutę w statusie (/api/replaygain).
+// ========================================================================
+
+static const uint8_t  RGAIN_Q_BITS          = 12;              // wzmocnienie Q12: 4096 = 1.0
+static const int32_t  RGAIN_UNITY           = 1 << RGAIN_Q_BITS;
+static const int16_t  RGAIN_PREAMP_CDB      = 0;               // [0.01 dB] dodawane do każdego wzmocnienia
+static const int16_t  RGAIN_UNTAGGED_CDB    = -600;            // [0.01 dB] pliki bez tagów i analizy
+static const int16_t  RGAIN_MAX_BOOST_CDB   = 1200;            // [0.01 dB] limit wzmocnienia (zakres Q12 w int32)
+static const int16_t  RGAIN_MIN_CDB         = -4000;
+static const float    RGAIN_REFERENCE_LUFS  = -18.0f;
+static const char     RGAIN_ANALYSIS_FILE[] = "/.replaygain.dat";
+static const uint16_t RGAIN_MAX_ANALYSED    = 4096;            // wyniki analizy w PSRAM (16 B na plik)
+static const uint32_t RGAIN_IDLE_MS         = 60000;           // analiza po takim czasie bez odtwarzania z karty
+static const uint32_t RGAIN_SWEEP_MS        = 10UL * 60UL * 1000UL;   // ponowny przegląd biblioteki
+static const uint16_t RGAIN_IO_CHUNK        = 8192;
+static const uint32_t RGAIN_MAX_ANALYSIS_RATE = 192000;
+
+typedef enum {
+  RGAIN_MODE_OFF = 0,
+  RGAIN_MODE_TRACK,
+  RGAIN_MODE_ALBUM
+} rgain_mode_t;
+
+typedef enum {
+  RGAIN_SRC_NONE = 0,          // tryb wyłączony
+  RGAIN_SRC_TRACK_TAG,
+  RGAIN_SRC_ALBUM_TAG,
+  RGAIN_SRC_TRACK_ANALYSIS,
+  RGAIN_SRC_ALBUM_ANALYSIS,
+  RGAIN_SRC_DEFAULT            // brak tagów i analizy - RGAIN_UNTAGGED_CDB
+} rgain_source_t;
+
+typedef enum {
+  RGAIN_ANALYSIS_OFF = 0,      // tryb wyłączony
+  RGAIN_ANALYSIS_WAITING,      // odtwarzanie z karty / indeksowanie / brak bezczynności
+  RGAIN_ANALYSIS_RUNNING,
+  RGAIN_ANALYSIS_DONE          // wszystkie pliki PCM bez tagów przeanalizowane
+} rgain_analysis_state_t;
+
+typedef struct {
+  uint8_t  mode;               // rgain_mode_t
+  int16_t  gainCdb;            // wzmocnienie bieżącego utworu [0.01 dB] (po ograniczeniu szczytem)
+  uint8_t  source;             // rgain_source_t
+  bool     peakLimited;        // wzmocnienie zmniejszone przez szczyt
+  uint32_t clippedSamples;     // próbki nasycone w torze
+  uint32_t tracks;             // utwory z ustawionym wzmocnieniem
+  uint32_t fromTags;
+  uint32_t fromAnalysis;
+  uint32_t untagged;
+
+  uint8_t  analysisState;      // rgain_analysis_state_t
+  uint32_t analysed;           // wyniki analizy w RGAIN_ANALYSIS_FILE
+  uint32_t analysisFailed;     // pliki nieobsługiwane (format / uszkodzone)
+  uint32_t analysisAborted;    // przerwane startem odtwarzania - do ponowienia
+  uint32_t passFiles;          // przeanalizowane w tej sesji
+  uint32_t filesPerMin10;      // tempo analizy x10 (pliki / min czasu analizy)
+  uint32_t realtime10;         // czas audio / czas analizy x10
+  uint32_t lastFileMs;
+  int16_t  lastLufs10;         // głośność ostatniego pliku [0.1 LUFS]
+} rgain_status_t;
+
+// Init - po media_lib_init() (zadanie analizy "RGain", wyniki z karty)
+void rgain_init(void);
+void rgain_set_mode(uint8_t mode);   // z readConfig / strony ustawień
+
+// Ręczny start pliku - wzmocnienie od razu (pełna ścieżka)
+void rgain_select(const char* path);
+// Następny utwór gapless - wzmocnienie liczone teraz, włączane przez rgain_track_begin()
+void rgain_prepare_next(const char* path);
+// Kontekst dekodera tuż przed connecttoFS() następnego pliku
+void rgain_track_begin(void);
+
+// Z audio_process_i2s() dla odtwarzacza SD (ramki stereo)
+void rgain_process(int16_t* buf, int32_t frames);
+
+void rgain_get_status(rgain_status_t* out);
+const char* rgain_source_name(uint8_t source);
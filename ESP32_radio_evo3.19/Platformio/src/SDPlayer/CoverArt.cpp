@@ -0,0 +1,982 @@
+#include "CoverArt.h"
+#include "../SdIo.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+
+// TJpgDec w ROM układu (ten sam, którego używa esp32-camera)
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/tjpgd.h"
+#define COVER_HAS_JPEG 1
+#elif CONFIG_IDF_TARGET_ESP32
+#include "esp32/rom/tjpgd.h"
+#define COVER_HAS_JPEG 1
+#else
+#define COVER_HAS_JPEG 0
+#endif
+
+static const uint16_t SIGNATURE_SCAN = 512;    // tekst ramki APIC / bloku PICTURE przed obrazem
+static const uint16_t JPEG_POOL_SIZE = 4096;   // pula TJpgDec (wymaga ~3100 B)
+static const uint32_t INFLATE_WINDOW = 32768;
+static const char* const FOLDER_IMAGES[] = { "cover.jpg", "folder.jpg", "front.jpg", "cover.png", "folder.png", "front.png" };
+
+// ======================= STAN =======================
+
+typedef struct {
+  char     path[COVER_ART_PATH_LENGTH + 1];
+  uint32_t seq;                 // zmiana utworu
+  uint32_t shownAt;
+  uint32_t seg[COVER_ART_MAX_SEGMENTS * 2];
+  uint8_t  segCount;            // 0 = brak evt_image (jeszcze)
+} cover_req_t;
+
+static SemaphoreHandle_t  g_lock = nullptr;
+static TaskHandle_t       g_task = nullptr;
+static cover_req_t        g_req;
+static cover_art_status_t g_status;
+static uint8_t            g_bitmap[MEDIA_COVER_BYTES];   // gotowa okładka (pod g_lock)
+static uint32_t           g_bitmapPath = 0;              // skrót ścieżki gotowej okładki, 0 = brak
+static volatile uint32_t  g_generation = 0;
+static uint32_t           g_failed[COVER_ART_FAILED_KEYS];
+static uint8_t            g_failedNext = 0;
+static uint32_t           g_memNow = 0;                  // pamięć dekodowania - tylko zadanie
+static uint32_t           g_memPeak = 0;
+
+// ======================= PAMIĘĆ =======================
+
+static void* cov_alloc(size_t size)
+{
+  void* p = psramFound() ? ps_malloc(size) : nullptr;
+  if (!p) p = malloc(size);
+  if (p) {
+    memset(p, 0, size);
+    g_memNow += size;
+    if (g_memNow > g_memPeak) g_memPeak = g_memNow;
+  }
+  return p;
+}
+
+static void cov_free(void* p, size_t size)
+{
+  if (!p) return;
+  free(p);
+  g_memNow -= size;
+}
+
+// ======================= ŹRÓDŁO =======================
+
+// Odczyt kolejnych segmentów pliku jako jednego strumienia
+typedef struct {
+  File*    f;
+  uint32_t seg[COVER_ART_MAX_SEGMENTS * 2];
+  uint8_t  segCount;
+  int8_t   segNo;
+  uint32_t segLeft;
+  uint8_t* buf;
+  uint16_t bufPos;
+  uint16_t bufLen;
+  bool     error;
+} cover_src_t;
+
+static void src_rewind(cover_src_t* s)
+{
+  s->segNo = -1;
+  s->segLeft = 0;
+  s->bufPos = s->bufLen = 0;
+  s->error = false;
+}
+
+static bool src_fill(cover_src_t* s)
+{
+  while (s->segLeft == 0) {
+    if (s->segNo + 1 >= s->segCount) return false;
+    s->segNo++;
+    s->segLeft = s->seg[s->segNo * 2 + 1];
+    if (!s->f->seek(s->seg[s->segNo * 2])) { s->error = true; return false; }
+  }
+  uint32_t n = s->segLeft < COVER_ART_IO_CHUNK ? s->segLeft : COVER_ART_IO_CHUNK;
+  sdio_begin(SDIO_CLASS_COVER, COVER_ART_IO_MAX_WAIT_MS);
+  int got = s->f->read(s->buf, n);
+  sdio_end(SDIO_CLASS_COVER, got > 0 ? got : 0);
+  if (got <= 0) { s->error = true; return false; }
+  s->segLeft -= got;
+  s->bufPos = 0;
+  s->bufLen = got;
+  return true;
+}
+
+static int src_byte(cover_src_t* s)
+{
+  if (s->bufPos >= s->bufLen && !src_fill(s)) return -1;
+  return s->buf[s->bufPos++];
+}
+
+// dst == nullptr - pominięcie n bajtów
+static uint32_t src_read(cover_src_t* s, uint8_t* dst, uint32_t n)
+{
+  uint32_t done = 0;
+  while (done < n) {
+    if (s->bufPos >= s->bufLen && !src_fill(s)) break;
+    uint32_t part = s->bufLen - s->bufPos;
+    if (part > n - done) part = n - done;
+    if (dst) memcpy(dst + done, s->buf + s->bufPos, part);
+    s->bufPos += part;
+    done += part;
+  }
+  return done;
+}
+
+static uint32_t src_be32(cover_src_t* s)
+{
+  uint8_t b[4];
+  if (src_read(s, b, 4) != 4) { s->error = true; return 0; }
+  return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+// Początek obrazu w pierwszym segmencie (przed nim tekst ramki) - segment przycięty do sygnatury
+static uint8_t src_find_image(cover_src_t* s)
+{
+  uint8_t head[SIGNATURE_SCAN];
+  uint32_t limit = s->seg[1] < SIGNATURE_SCAN ? s->seg[1] : SIGNATURE_SCAN;
+  uint32_t n = src_read(s, head, limit);
+  uint8_t format = COVER_FORMAT_NONE;
+  uint32_t at = 0;
+  for (uint32_t i = 0; i + 4 <= n && format == COVER_FORMAT_NONE; i++) {
+    if (head[i] == 0xFF && head[i + 1] == 0xD8 && head[i + 2] == 0xFF) { format = COVER_FORMAT_JPEG; at = i; }
+    else if (head[i] == 0x89 && head[i + 1] == 'P' && head[i + 2] == 'N' && head[i + 3] == 'G') { format = COVER_FORMAT_PNG; at = i; }
+  }
+  s->seg[0] += at;
+  s->seg[1] -= at;
+  src_rewind(s);
+  return format;
+}
+
+// ======================= PRÓBKOWANIE 64x64 =======================
+
+typedef struct {
+  uint32_t* sum;
+  uint16_t* cnt;
+  uint16_t  side;      // bok środkowego kwadratu obrazu
+  uint16_t  x0;
+  uint16_t  y0;
+} cover_acc_t;
+
+static const uint32_t ACC_PIXELS = (uint32_t)MEDIA_COVER_SIZE * MEDIA_COVER_SIZE;
+
+static void acc_setup(cover_acc_t* a, uint16_t w, uint16_t h)
+{
+  a->side = w < h ? w : h;
+  a->x0 = (w - a->side) / 2;
+  a->y0 = (h - a->side) / 2;
+}
+
+static inline void acc_pixel(cover_acc_t* a, uint32_t x, uint32_t y, uint8_t gray)
+{
+  if (x < a->x0 || y < a->y0) return;
+  x -= a->x0;
+  y -= a->y0;
+  if (x >= a->side || y >= a->side) return;
+  uint32_t i = (y * MEDIA_COVER_SIZE / a->side) * MEDIA_COVER_SIZE + x * MEDIA_COVER_SIZE / a->side;
+  a->sum[i] += gray;
+  a->cnt[i]++;
+}
+
+static inline uint8_t luma(uint8_t r, uint8_t g, uint8_t b)
+{
+  return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// Średnie pól -> rozciągnięcie kontrastu -> Floyd-Steinberg -> XBM (bit 0 = lewy piksel)
+static bool acc_finish(cover_acc_t* a, uint8_t* bitmap)
+{
+  uint8_t* gray = (uint8_t*)cov_alloc(ACC_PIXELS);
+  int16_t* err = (int16_t*)cov_alloc(2 * (MEDIA_COVER_SIZE + 2) * sizeof(int16_t));
+  if (!gray || !err) {
+    cov_free(gray, ACC_PIXELS);
+    cov_free(err, 2 * (MEDIA_COVER_SIZE + 2) * sizeof(int16_t));
+    return false;
+  }
+
+  uint8_t lo = 255;
+  uint8_t hi = 0;
+  for (uint32_t y = 0; y < MEDIA_COVER_SIZE; y++) {
+    // Obraz mniejszy niż 64 px - pominięty wiersz z wiersza wyżej, pominięta kolumna z lewego sąsiada
+    uint32_t row = y * MEDIA_COVER_SIZE;
+    bool rowEmpty = true;
+    for (uint32_t x = 0; x < MEDIA_COVER_SIZE && rowEmpty; x++) rowEmpty = a->cnt[row + x] == 0;
+    for (uint32_t x = 0; x < MEDIA_COVER_SIZE; x++) {
+      uint32_t i = row + x;
+      if (a->cnt[i]) gray[i] = a->sum[i] / a->cnt[i];
+      else if (rowEmpty && y) gray[i] = gray[i - MEDIA_COVER_SIZE];
+      else if (x) gray[i] = gray[i - 1];
+      else gray[i] = 0;
+      if (gray[i] < lo) lo = gray[i];
+      if (gray[i] > hi) hi = gray[i];
+    }
+  }
+  uint16_t range = hi > lo ? hi - lo : 1;
+
+  int16_t* cur = err;
+  int16_t* nxt = err + MEDIA_COVER_SIZE + 2;
+  memset(bitmap, 0, MEDIA_COVER_BYTES);
+  for (uint8_t y = 0; y < MEDIA_COVER_SIZE; y++) {
+    memset(nxt, 0, (MEDIA_COVER_SIZE + 2) * sizeof(int16_t));
+    for (uint8_t x = 0; x < MEDIA_COVER_SIZE; x++) {
+      int32_t v = (int32_t)(gray[y * MEDIA_COVER_SIZE + x] - lo) * 255 / range + cur[x + 1] / 16;
+      bool on = v >= 128;
+      int32_t e = (v - (on ? 255 : 0)) * 16;
+      cur[x + 2] += e * 7 / 16;
+      nxt[x]     += e * 3 / 16;
+      nxt[x + 1] += e * 5 / 16;
+      nxt[x + 2] += e / 16;
+      if (on) bitmap[y * (MEDIA_COVER_SIZE / 8) + x / 8] |= 1 << (x & 7);
+    }
+    int16_t* t = cur; cur = nxt; nxt = t;
+  }
+
+  cov_free(gray, ACC_PIXELS);
+  cov_free(err, 2 * (MEDIA_COVER_SIZE + 2) * sizeof(int16_t));
+  return true;
+}
+
+// ======================= JPEG =======================
+
+typedef struct {
+  cover_src_t* src;
+  cover_acc_t* acc;
+} cover_job_t;
+
+#if COVER_HAS_JPEG
+static uint32_t jpeg_in(JDEC* jd, uint8_t* buf, uint32_t len)
+{
+  cover_job_t* job = (cover_job_t*)jd->device;
+  return src_read(job->src, buf, len);
+}
+
+// Blok MCU w RGB888
+static uint32_t jpeg_out(JDEC* jd, void* bitmap, JRECT* rect)
+{
+  cover_job_t* job = (cover_job_t*)jd->device;
+  const uint8_t* p = (const uint8_t*)bitmap;
+  for (uint32_t y = rect->top; y <= rect->bottom; y++) {
+    for (uint32_t x = rect->left; x <= rect->right; x++, p += 3) {
+      acc_pixel(job->acc, x, y, luma(p[0], p[1], p[2]));
+    }
+  }
+  return 1;
+}
+
+static uint8_t decode_jpeg(cover_job_t* job, uint16_t* w, uint16_t* h)
+{
+  void* pool = cov_alloc(JPEG_POOL_SIZE);
+  JDEC* jd = (JDEC*)cov_alloc(sizeof(JDEC));
+  if (!pool || !jd) {
+    cov_free(pool, JPEG_POOL_SIZE);
+    cov_free(jd, sizeof(JDEC));
+    return COVER_ERR_MEMORY;
+  }
+
+  uint8_t result = COVER_OK;
+  JRESULT r = jd_prepare(jd, jpeg_in, pool, JPEG_POOL_SIZE, job);
+  if (r == JDR_OK) {
+    *w = jd->width;
+    *h = jd->height;
+    if (*w > COVER_ART_MAX_SIDE || *h > COVER_ART_MAX_SIDE) {
+      result = COVER_ERR_UNSUPPORTED;
+    } else {
+      // Największe zmniejszenie w dekoderze, przy którym krótszy bok ma jeszcze 64 px
+      uint16_t minSide = *w < *h ? *w : *h;
+      uint8_t scale = 0;
+      while (scale < 3 && (minSide >> (scale + 1)) >= MEDIA_COVER_SIZE) scale++;
+      acc_setup(job->acc, (*w + (1 << scale) - 1) >> scale, (*h + (1 << scale) - 1) >> scale);
+      r = jd_decomp(jd, jpeg_out, scale);
+      if (r != JDR_OK) result = job->src->error ? COVER_ERR_READ : COVER_ERR_DATA;
+    }
+  } else {
+    result = r == JDR_FMT3 ? COVER_ERR_UNSUPPORTED : (r == JDR_MEM1 || r == JDR_MEM2) ? COVER_ERR_MEMORY :
+             job->src->error ? COVER_ERR_READ : COVER_ERR_DATA;
+  }
+
+  cov_free(pool, JPEG_POOL_SIZE);
+  cov_free(jd, sizeof(JDEC));
+  return result;
+}
+#else
+static uint8_t decode_jpeg(cover_job_t* job, uint16_t* w, uint16_t* h)
+{
+  return COVER_ERR_UNSUPPORTED;
+}
+#endif
+
+// ======================= PNG: WIERSZE =======================
+
+typedef struct {
+  uint32_t     w;
+  uint32_t     h;
+  uint8_t      depth;
+  uint8_t      color;
+  uint8_t      channels;
+  uint8_t      bpp;          // bajty na piksel dla filtrów (min. 1)
+  uint32_t     stride;       // bajty wiersza bez bajtu filtra
+  uint8_t*     cur;
+  uint8_t*     prev;
+  uint32_t     pos;          // 0 = bajt filtra, dalej 1..stride
+  uint8_t      filter;
+  uint32_t     row;
+  uint8_t      palette[256]; // jasność wpisów palety
+  cover_acc_t* acc;
+} png_rows_t;
+
+static void png_row_done(png_rows_t* p)
+{
+  const uint8_t* r = p->cur;
+  uint32_t y = p->row;
+  if (y < p->acc->y0 || y >= (uint32_t)p->acc->y0 + p->acc->side) return;   // poza kwadratem
+
+  uint8_t step = p->depth == 16 ? 2 : 1;
+  for (uint32_t x = 0; x < p->w; x++) {
+    uint8_t g;
+    if (p->depth < 8) {
+      uint32_t bit = x * p->depth;
+      uint8_t v = (r[bit >> 3] >> (8 - p->depth - (bit & 7))) & ((1 << p->depth) - 1);
+      g = p->color == 3 ? p->palette[v] : v * 255 / ((1 << p->depth) - 1);
+    } else {
+      const uint8_t* px = r + x * p->channels * step;
+      if (p->color == 3) g = p->palette[px[0]];
+      else if (p->color == 2 || p->color == 6) g = luma(px[0], px[step], px[2 * step]);
+      else g = px[0];                                   // szarość (+ alfa)
+    }
+    acc_pixel(p->acc, x, y, g);
+  }
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+  int p = (int)a + b - c;
+  int pa = abs(p - a);
+  int pb = abs(p - b);
+  int pc = abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  return pb <= pc ? b : c;
+}
+
+// Bajt po inflate -> wiersz z usuniętym filtrem
+static bool png_sink(png_rows_t* p, uint8_t b)
+{
+  if (p->row >= p->h) return true;          // nadmiarowe dane po ostatnim wierszu
+  if (p->pos == 0) {
+    if (b > 4) return false;
+    p->filter = b;
+    p->pos = 1;
+    return true;
+  }
+  uint32_t i = p->pos - 1;
+  uint8_t a = i >= p->bpp ? p->cur[i - p->bpp] : 0;
+  uint8_t up = p->prev[i];
+  switch (p->filter) {
+    case 1: b += a; break;
+    case 2: b += up; break;
+    case 3: b += (a + up) >> 1; break;
+    case 4: b += paeth(a, up, i >= p->bpp ? p->prev[i - p->bpp] : 0); break;
+  }
+  p->cur[i] = b;
+  if (++p->pos > p->stride) {
+    png_row_done(p);
+    uint8_t* t = p->prev; p->prev = p->cur; p->cur = t;
+    p->pos = 0;
+    p->row++;
+  }
+  return true;
+}
+
+// ======================= PNG: INFLATE =======================
+// Dekoder bit po bicie na wzór puff (zlib) - wolniejszy od tablicowego,
+// ale bez dużych tablic; okładka to najwyżej kilkaset kB danych.
+
+typedef struct {
+  int16_t count[16];
+  int16_t symbol[288];
+} huff_t;
+
+typedef struct {
+  cover_src_t* src;
+  png_rows_t*  rows;
+  uint32_t     chunkLeft;    // bajty w bieżącym IDAT
+  uint32_t     bitbuf;
+  uint8_t      bitcnt;
+  bool         error;
+  uint8_t*     win;
+  uint32_t     total;        // bajty wyjścia (zakres odległości)
+  huff_t       lencode;
+  huff_t       distcode;
+  int16_t      lengths[320];
+} inflate_t;
+
+static const uint16_t LEN_BASE[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t  LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537,
+                                        2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t  DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t  CODE_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// Bajt strumienia zlib - kolejne porcje IDAT (CRC pomijane)
+static int inf_byte(inflate_t* s)
+{
+  while (s->chunkLeft == 0) {
+    src_read(s->src, nullptr, 4);                 // CRC poprzedniego IDAT
+    uint32_t len = src_be32(s->src);
+    uint8_t type[4];
+    if (s->src->error || src_read(s->src, type, 4) != 4 || memcmp(type, "IDAT", 4) != 0) {
+      s->error = true;
+      return -1;
+    }
+    s->chunkLeft = len;
+  }
+  int b = src_byte(s->src);
+  if (b < 0) { s->error = true; return -1; }
+  s->chunkLeft--;
+  return b;
+}
+
+static uint32_t inf_bits(inflate_t* s, uint8_t need)
+{
+  uint32_t val = s->bitbuf;
+  while (s->bitcnt < need) {
+    int b = inf_byte(s);
+    if (b < 0) return 0;
+    val |= (uint32_t)b << s->bitcnt;
+    s->bitcnt += 8;
+  }
+  s->bitbuf = val >> need;
+  s->bitcnt -= need;
+  return val & ((1UL << need) - 1);
+}
+
+static bool inf_out(inflate_t* s, uint8_t b)
+{
+  s->win[s->total & (INFLATE_WINDOW - 1)] = b;
+  s->total++;
+  return png_sink(s->rows, b);
+}
+
+static int inf_decode(inflate_t* s, const huff_t* h)
+{
+  int code = 0;
+  int first = 0;
+  int index = 0;
+  for (uint8_t len = 1; len < 16; len++) {
+    code |= inf_bits(s, 1);
+    int count = h->count[len];
+    if (code - count < first) return h->symbol[index + (code - first)];
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+// Tablica kodu z długości; <0 = nadmiar kodów, >0 = kod niepełny
+static int inf_construct(huff_t* h, const int16_t* length, int n)
+{
+  memset(h->count, 0, sizeof(h->count));
+  for (int sym = 0; sym < n; sym++) h->count[length[sym]]++;
+  if (h->count[0] == n) return 0;
+
+  int left = 1;
+  for (uint8_t len = 1; len < 16; len++) {
+    left <<= 1;
+    left -= h->count[len];
+    if (left < 0) return left;
+  }
+  int16_t offs[16];
+  offs[1] = 0;
+  for (uint8_t len = 1; len < 15; len++) offs[len + 1] = offs[len] + h->count[len];
+  for (int sym = 0; sym < n; sym++) {
+    if (length[sym] != 0) h->symbol[offs[length[sym]]++] = sym;
+  }
+  return left;
+}
+
+static bool inf_codes(inflate_t* s)
+{
+  for (;;) {
+    int sym = inf_decode(s, &s->lencode);
+    if (sym < 0 || s->error) return false;
+    if (sym < 256) {
+      if (!inf_out(s, sym)) return false;
+    } else if (sym == 256) {
+      return true;
+    } else {
+      sym -= 257;
+      if (sym >= 29) return false;
+      uint32_t len = LEN_BASE[sym] + inf_bits(s, LEN_EXTRA[sym]);
+      int dsym = inf_decode(s, &s->distcode);
+      if (dsym < 0 || dsym >= 30) return false;
+      uint32_t dist = DIST_BASE[dsym] + inf_bits(s, DIST_EXTRA[dsym]);
+      if (s->error || dist > s->total) return false;
+      while (len--) {
+        if (!inf_out(s, s->win[(s->total - dist) & (INFLATE_WINDOW - 1)])) return false;
+      }
+    }
+  }
+}
+
+static bool inf_stored(inflate_t* s)
+{
+  s->bitbuf = 0;
+  s->bitcnt = 0;
+  uint8_t b[4];
+  for (uint8_t i = 0; i < 4; i++) {
+    int v = inf_byte(s);
+    if (v < 0) return false;
+    b[i] = v;
+  }
+  uint16_t len = b[0] | (b[1] << 8);
+  if (len != (uint16_t)~(b[2] | (b[3] << 8))) return false;
+  while (len--) {
+    int v = inf_byte(s);
+    if (v < 0 || !inf_out(s, v)) return false;
+  }
+  return true;
+}
+
+static bool inf_fixed(inflate_t* s)
+{
+  int16_t* l = s->lengths;
+  int sym = 0;
+  for (; sym < 144; sym++) l[sym] = 8;
+  for (; sym < 256; sym++) l[sym] = 9;
+  for (; sym < 280; sym++) l[sym] = 7;
+  for (; sym < 288; sym++) l[sym] = 8;
+  inf_construct(&s->lencode, l, 288);
+  for (sym = 0; sym < 30; sym++) l[sym] = 5;
+  inf_construct(&s->distcode, l, 30);
+  return inf_codes(s);
+}
+
+static bool inf_dynamic(inflate_t* s)
+{
+  int16_t* l = s->lengths;
+  int nlen = inf_bits(s, 5) + 257;
+  int ndist = inf_bits(s, 5) + 1;
+  int ncode = inf_bits(s, 4) + 4;
+  if (s->error || nlen > 286 || ndist > 30) return false;
+
+  int index = 0;
+  for (; index < ncode; index++) l[CODE_ORDER[index]] = inf_bits(s, 3);
+  for (; index < 19; index++) l[CODE_ORDER[index]] = 0;
+  if (inf_construct(&s->lencode, l, 19) != 0) return false;
+
+  index = 0;
+  while (index < nlen + ndist) {
+    int sym = inf_decode(s, &s->lencode);
+    if (sym < 0 || s->error) return false;
+    if (sym < 16) {
+      l[index++] = sym;
+    } else {
+      int16_t len = 0;
+      if (sym == 16) {
+        if (index == 0) return false;
+        len = l[index - 1];
+        sym = 3 + inf_bits(s, 2);
+      } else if (sym == 17) {
+        sym = 3 + inf_bits(s, 3);
+      } else {
+        sym = 11 + inf_bits(s, 7);
+      }
+      if (index + sym > nlen + ndist) return false;
+      while (sym--) l[index++] = len;
+    }
+  }
+  if (l[256] == 0) return false;
+
+  int err = inf_construct(&s->lencode, l, nlen);
+  if (err < 0 || (err > 0 && nlen - s->lencode.count[0] != 1)) return false;
+  err = inf_construct(&s->distcode, l + nlen, ndist);
+  if (err < 0 || (err > 0 && ndist - s->distcode.count[0] != 1)) return false;
+  return inf_codes(s);
+}
+
+static bool inflate_zlib(inflate_t* s)
+{
+  int cmf = inf_byte(s);
+  int flg = inf_byte(s);
+  if (cmf < 0 || flg < 0 || (cmf & 0x0F) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) return false;
+
+  bool last = false;
+  while (!last && s->rows->row < s->rows->h) {
+    last = inf_bits(s, 1);
+    uint8_t type = inf_bits(s, 2);
+    bool ok = false;
+    if (s->error) return false;
+    if (type == 0) ok = inf_stored(s);
+    else if (type == 1) ok = inf_fixed(s);
+    else if (type == 2) ok = inf_dynamic(s);
+    if (!ok) return false;
+  }
+  return s->rows->row >= s->rows->h;
+}
+
+// ======================= PNG =======================
+
+static uint8_t decode_png(cover_job_t* job, uint16_t* w, uint16_t* h)
+{
+  cover_src_t* src = job->src;
+  static const uint8_t SIG[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+  uint8_t sig[8];
+  if (src_read(src, sig, 8) != 8 || memcmp(sig, SIG, 8) != 0) return COVER_ERR_DATA;
+
+  png_rows_t* p = (png_rows_t*)cov_alloc(sizeof(png_rows_t));
+  if (!p) return COVER_ERR_MEMORY;
+  p->acc = job->acc;
+  uint8_t result = COVER_ERR_DATA;
+  bool header = false;
+
+  // Fragmenty do pierwszego IDAT: IHDR, PLTE, reszta pomijana
+  for (;;) {
+    uint32_t len = src_be32(src);
+    uint8_t type[4];
+    if (src->error || src_read(src, type, 4) != 4) { result = COVER_ERR_READ; break; }
+
+    if (memcmp(type, "IHDR", 4) == 0 && len == 13) {
+      uint8_t ih[13];
+      if (src_read(src, ih, 13) != 13) break;
+      p->w = ((uint32_t)ih[0] << 24) | ((uint32_t)ih[1] << 16) | (ih[2] << 8) | ih[3];
+      p->h = ((uint32_t)ih[4] << 24) | ((uint32_t)ih[5] << 16) | (ih[6] << 8) | ih[7];
+      p->depth = ih[8];
+      p->color = ih[9];
+      *w = p->w > 0xFFFF ? 0xFFFF : p->w;
+      *h = p->h > 0xFFFF ? 0xFFFF : p->h;
+      static const uint8_t CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+      p->channels = p->color <= 6 ? CHANNELS[p->color] : 0;
+      bool depthOk = p->depth == 8 || (p->depth == 16 && p->color != 3) ||
+                     ((p->depth == 1 || p->depth == 2 || p->depth == 4) && (p->color == 0 || p->color == 3));
+      if (!p->channels || !depthOk || ih[10] != 0 || ih[11] != 0 || p->w == 0 || p->h == 0) break;
+      if (ih[12] != 0 || p->w > COVER_ART_MAX_SIDE || p->h > COVER_ART_MAX_SIDE) { result = COVER_ERR_UNSUPPORTED; break; }
+      p->stride = (p->w * p->channels * p->depth + 7) / 8;
+      p->bpp = (p->channels * p->depth + 7) / 8;
+      header = true;
+      if (p->color == 0) {
+        for (uint16_t i = 0; i < 256; i++) p->palette[i] = i;
+      }
+      src_read(src, nullptr, 4);
+    } else if (memcmp(type, "PLTE", 4) == 0 && header && len % 3 == 0 && len <= 768) {
+      for (uint16_t i = 0; i < len / 3; i++) {
+        uint8_t rgb[3];
+        if (src_read(src, rgb, 3) != 3) break;
+        p->palette[i] = luma(rgb[0], rgb[1], rgb[2]);
+      }
+      src_read(src, nullptr, 4);
+    } else if (memcmp(type, "IDAT", 4) == 0 && header) {
+      acc_setup(job->acc, p->w, p->h);
+      inflate_t* inf = (inflate_t*)cov_alloc(sizeof(inflate_t));
+      p->cur = (uint8_t*)cov_alloc(p->stride);
+      p->prev = (uint8_t*)cov_alloc(p->stride);
+      uint8_t* win = (uint8_t*)cov_alloc(INFLATE_WINDOW);
+      if (inf && p->cur && p->prev && win) {
+        inf->src = src;
+        inf->rows = p;
+        inf->chunkLeft = len;
+        inf->win = win;
+        result = inflate_zlib(inf) ? COVER_OK : src->error ? COVER_ERR_READ : COVER_ERR_DATA;
+      } else {
+        result = COVER_ERR_MEMORY;
+      }
+      cov_free(win, INFLATE_WINDOW);
+      cov_free(p->prev, p->stride);
+      cov_free(p->cur, p->stride);
+      cov_free(inf, sizeof(inflate_t));
+      break;
+    } else if (memcmp(type, "IEND", 4) == 0) {
+      break;
+    } else {
+      if (src_read(src, nullptr, len + 4) != len + 4) { result = COVER_ERR_READ; break; }
+    }
+  }
+
+  cov_free(p, sizeof(png_rows_t));
+  return result;
+}
+
+// ======================= DEKODOWANIE =======================
+
+static uint8_t decode_cover(const char* path, const uint32_t* seg, uint8_t segCount, uint8_t* bitmap,
+                            uint8_t* format, uint16_t* w, uint16_t* h)
+{
+  *format = COVER_FORMAT_NONE;
+  *w = *h = 0;
+  g_memNow = 0;
+  g_memPeak = 0;
+
+  cover_src_t* src = (cover_src_t*)cov_alloc(sizeof(cover_src_t));
+  if (!src) return COVER_ERR_MEMORY;
+  src->buf = (uint8_t*)cov_alloc(COVER_ART_IO_CHUNK);
+  memcpy(src->seg, seg, segCount * 2 * sizeof(uint32_t));
+  src->segCount = segCount;
+  src_rewind(src);
+
+  uint8_t result = COVER_ERR_READ;
+  sdio_begin(SDIO_CLASS_COVER, COVER_ART_IO_MAX_WAIT_MS);
+  File f = SD.open(path, FILE_READ);
+  sdio_end(SDIO_CLASS_COVER, 0);
+  src->f = &f;
+
+  cover_acc_t acc;
+  acc.sum = (uint32_t*)cov_alloc(ACC_PIXELS * sizeof(uint32_t));
+  acc.cnt = (uint16_t*)cov_alloc(ACC_PIXELS * sizeof(uint16_t));
+
+  if (!src->buf || !acc.sum || !acc.cnt) {
+    result = COVER_ERR_MEMORY;
+  } else if (f) {
+    *format = src_find_image(src);
+    cover_job_t job = { src, &acc };
+    if (*format == COVER_FORMAT_JPEG) result = decode_jpeg(&job, w, h);
+    else if (*format == COVER_FORMAT_PNG) result = decode_png(&job, w, h);
+    else result = COVER_ERR_NO_IMAGE;
+    if (result == COVER_OK && !acc_finish(&acc, bitmap)) result = COVER_ERR_MEMORY;
+  }
+  if (f) f.close();
+
+  cov_free(acc.sum, ACC_PIXELS * sizeof(uint32_t));
+  cov_free(acc.cnt, ACC_PIXELS * sizeof(uint16_t));
+  cov_free(src->buf, COVER_ART_IO_CHUNK);
+  cov_free(src, sizeof(cover_src_t));
+  return result;
+}
+
+// Obraz okładki w katalogu utworu (cover.jpg, folder.jpg, ...) - cały plik jako segment
+static bool folder_image(const char* path, char* out, size_t outSize, uint32_t* size)
+{
+  const char* slash = strrchr(path, '/');
+  size_t dirLen = slash ? (size_t)(slash - path) : 0;
+  for (uint8_t i = 0; i < sizeof(FOLDER_IMAGES) / sizeof(FOLDER_IMAGES[0]); i++) {
+    if (dirLen + 1 + strlen(FOLDER_IMAGES[i]) >= outSize) return false;
+    memcpy(out, path, dirLen);
+    out[dirLen] = '/';
+    strcpy(out + dirLen + 1, FOLDER_IMAGES[i]);
+    File f = SD.open(out, FILE_READ);
+    if (f) {
+      *size = f.size();
+      bool isFile = !f.isDirectory();
+      f.close();
+      if (isFile && *size > 0) return true;
+    }
+  }
+  return false;
+}
+
+// ======================= ZADANIE =======================
+
+static void publish(uint32_t pathHash, const uint8_t* bitmap)
+{
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (bitmap) memcpy(g_bitmap, bitmap, MEDIA_COVER_BYTES);
+  g_bitmapPath = bitmap ? pathHash : 0;
+  g_generation++;
+  xSemaphoreGive(g_lock);
+}
+
+static bool failed_known(uint32_t key)
+{
+  for (uint8_t i = 0; i < COVER_ART_FAILED_KEYS; i++) {
+    if (g_failed[i] == key) return true;
+  }
+  return false;
+}
+
+static void cover_task(void* arg)
+{
+  static cover_req_t req;                      // static - ścieżki poza stosem zadania
+  static char imagePath[COVER_ART_PATH_LENGTH + 1];
+  static uint8_t bitmap[MEDIA_COVER_BYTES];
+  uint32_t doneSeq = 0;
+  uint32_t checkedSeq = 0;
+  uint32_t key = 0;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    req = g_req;
+    xSemaphoreGive(g_lock);
+    if (req.seq == doneSeq) continue;
+    uint32_t pathHash = media_lib_path_hash(req.path);
+
+    if (req.path[0] == '\0') {
+      publish(0, nullptr);
+      doneSeq = req.seq;
+      continue;
+    }
+
+    // Okładka albumu już w bazie
+    if (checkedSeq != req.seq) {
+      checkedSeq = req.seq;
+      key = media_lib_cover_key(req.path);
+      if (media_lib_cover_get(key, bitmap)) {
+        publish(pathHash, bitmap);
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        g_status.cacheHits++;
+        xSemaphoreGive(g_lock);
+        doneSeq = req.seq;
+        continue;
+      }
+      if (failed_known(key)) {
+        publish(0, nullptr);
+        doneSeq = req.seq;
+        continue;
+      }
+    }
+
+    // Źródło: obraz z tagów (evt_image), po COVER_ART_SOURCE_WAIT_MS obraz z katalogu
+    const char* file = req.path;
+    uint32_t folderSeg[2];
+    const uint32_t* seg = req.seg;
+    uint8_t segCount = req.segCount;
+    if (segCount == 0) {
+      if (millis() - req.shownAt < COVER_ART_SOURCE_WAIT_MS) continue;
+      if (!folder_image(req.path, imagePath, sizeof(imagePath), &folderSeg[1])) {
+        xSemaphoreTake(g_lock, portMAX_DELAY);
+        g_status.noSource++;
+        xSemaphoreGive(g_lock);
+        g_failed[g_failedNext++ % COVER_ART_FAILED_KEYS] = key;
+        publish(0, nullptr);
+        doneSeq = req.seq;
+        continue;
+      }
+      folderSeg[0] = 0;
+      file = imagePath;
+      seg = folderSeg;
+      segCount = 1;
+    }
+
+    uint32_t t0 = millis();
+    uint8_t format;
+    uint16_t w, h;
+    uint8_t result = decode_cover(file, seg, segCount, bitmap, &format, &w, &h);
+    uint32_t ms = millis() - t0;
+    Serial.printf("debug cover -> %s %ux%u -> %ux%u: %s, %u ms, pamięć %u B\n",
+                  cover_art_format_name(format), w, h, MEDIA_COVER_SIZE, MEDIA_COVER_SIZE,
+                  cover_art_result_name(result), (unsigned)ms, (unsigned)g_memPeak);
+
+    if (result == COVER_OK) {
+      media_lib_cover_put(key, bitmap);
+      publish(pathHash, bitmap);
+    } else {
+      g_failed[g_failedNext++ % COVER_ART_FAILED_KEYS] = key;
+      publish(0, nullptr);
+    }
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    if (result == COVER_OK) g_status.decoded++;
+    else g_status.failed++;
+    g_status.lastDecodeMs = ms;
+    if (ms > g_status.maxDecodeMs) g_status.maxDecodeMs = ms;
+    g_status.lastPeakBytes = g_memPeak;
+    if (g_memPeak > g_status.maxPeakBytes) g_status.maxPeakBytes = g_memPeak;
+    g_status.lastWidth = w;
+    g_status.lastHeight = h;
+    g_status.lastFormat = format;
+    g_status.lastResult = result;
+    xSemaphoreGive(g_lock);
+    doneSeq = req.seq;
+  }
+}
+
+// ======================= API =======================
+
+// Zmiana utworu (pod g_lock) - nowe zgłoszenie, segmenty od nowa
+static void req_path(const char* path)
+{
+  if (strncmp(g_req.path, path, COVER_ART_PATH_LENGTH) == 0) return;
+  strncpy(g_req.path, path, COVER_ART_PATH_LENGTH);
+  g_req.path[COVER_ART_PATH_LENGTH] = '\0';
+  g_req.seq++;
+  g_req.shownAt = millis();
+  g_req.segCount = 0;
+}
+
+void cover_art_init(void)
+{
+  if (g_lock) return;
+  g_lock = xSemaphoreCreateMutex();
+  if (!g_lock) return;
+  if (xTaskCreatePinnedToCore(cover_task, "CoverArt", 6144, NULL, 1, &g_task, 0) != pdPASS) {
+    Serial.println("debug cover -> Nie można uruchomić zadania okładek");
+    g_task = nullptr;
+  }
+}
+
+void cover_art_show(const char* path)
+{
+  if (!g_lock || !path) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  req_path(path);
+  xSemaphoreGive(g_lock);
+  if (g_task) xTaskNotifyGive(g_task);
+}
+
+void cover_art_source(const char* path, const uint32_t* segments, uint8_t count)
+{
+  if (!g_lock || !path || !segments || count == 0) return;
+  if (count > COVER_ART_MAX_SEGMENTS) count = COVER_ART_MAX_SEGMENTS;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  req_path(path);
+  memcpy(g_req.seg, segments, count * 2 * sizeof(uint32_t));
+  g_req.segCount = count;
+  xSemaphoreGive(g_lock);
+  if (g_task) xTaskNotifyGive(g_task);
+}
+
+uint32_t cover_art_generation(void)
+{
+  return g_generation;
+}
+
+bool cover_art_get(const char* path, uint8_t* bitmap)
+{
+  if (!g_lock || !path || !bitmap) return false;
+  uint32_t hash = media_lib_path_hash(path);
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  bool ok = g_bitmapPath != 0 && g_bitmapPath == hash;
+  if (ok) memcpy(bitmap, g_bitmap, MEDIA_COVER_BYTES);
+  xSemaphoreGive(g_lock);
+  return ok;
+}
+
+void cover_art_get_status(cover_art_status_t* out)
+{
+  if (!out) return;
+  if (g_lock) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    *out = g_status;
+    xSemaphoreGive(g_lock);
+  } else {
+    memset(out, 0, sizeof(*out));
+  }
+  media_lib_status_t lib;
+  media_lib_get_status(&lib);
+  out->covers = lib.covers;
+}
+
+const char* cover_art_format_name(uint8_t format)
+{
+  switch (format) {
+    case COVER_FORMAT_JPEG: return "JPEG";
+    case COVER_FORMAT_PNG:  return "PNG";
+    default:                return "-";
+  }
+}
+
+const char* cover_art_result_name(uint8_t result)
+{
+  switch (result) {
+    case COVER_OK:              return "ok";
+    case COVER_ERR_NO_IMAGE:    return "no_image";
+    case COVER_ERR_UNSUPPORTED: return "unsupported";
+    case COVER_ERR_MEMORY:      return "memory";
+    case COVER_ERR_READ:        return "read";
+    default:                    return "data";
+  }
+}
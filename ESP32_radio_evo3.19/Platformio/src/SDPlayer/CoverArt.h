@@ -0,0 +1,83 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "MediaLibrary.h"
+
+// ========================================================================
+// COVER ART - okładka albumu 64x64 1bpp dla odtwarzacza SD
+// ========================================================================
+// Źródło: obraz wbudowany w plik (ID3 APIC, FLAC PICTURE) - pozycje
+// segmentów podaje dekoder w evt_image; brak obrazu w tagach przez
+// COVER_ART_SOURCE_WAIT_MS -> cover.jpg / folder.jpg / ... w katalogu.
+// Odczyt blokami COVER_ART_IO_CHUNK przez harmonogram SD (SdIo) -
+// odtwarzanie ma pierwszeństwo.
+//
+// Dekodowanie strumieniowe, bez pełnego obrazu w pamięci:
+//   - JPEG : TJpgDec z ROM układu (bloki MCU, pula ~3 kB), skala 1/2..1/8
+//            już w dekoderze; JPEG progresywny nieobsługiwany,
+//   - PNG  : własny inflate (okno 32 kB) + filtry wierszy, tylko dwa
+//            wiersze w pamięci; bez przeplotu, głębia 1..16 bitów.
+// Piksel -> jasność -> suma w polu 64x64 (środkowy kwadrat obrazu),
+// rozciągnięcie kontrastu, dithering Floyda-Steinberga do 1bpp (XBM,
+// wprost dla u8g2 drawXBM).
+//
+// Wynik w bazie biblioteki (media_lib_cover_put) pod kluczem albumu -
+// każdy album dekodowany raz. Czas dekodowania i szczyt pamięci per
+// okładka w statusie (/sdplayer/api/cover) i w logu.
+// ========================================================================
+
+static const uint8_t  COVER_ART_MAX_SEGMENTS   = 8;
+static const uint16_t COVER_ART_PATH_LENGTH    = 255;
+static const uint16_t COVER_ART_MAX_SIDE       = 4096;    // [px] większy obraz - pomijany
+static const uint16_t COVER_ART_IO_CHUNK       = 4096;
+static const uint16_t COVER_ART_IO_MAX_WAIT_MS = 1000;    // czekanie na przerwę w odtwarzaniu przy odczycie
+static const uint16_t COVER_ART_SOURCE_WAIT_MS = 3000;    // brak evt_image -> obraz z katalogu
+static const uint8_t  COVER_ART_FAILED_KEYS    = 16;      // albumy bez okładki - bez ponawiania do restartu
+
+typedef enum {
+  COVER_FORMAT_NONE = 0,
+  COVER_FORMAT_JPEG,
+  COVER_FORMAT_PNG
+} cover_format_t;
+
+typedef enum {
+  COVER_OK = 0,
+  COVER_ERR_NO_IMAGE,          // brak sygnatury JPEG / PNG w segmencie
+  COVER_ERR_UNSUPPORTED,       // JPEG progresywny, PNG z przeplotem, za duży obraz
+  COVER_ERR_MEMORY,
+  COVER_ERR_READ,
+  COVER_ERR_DATA               // uszkodzone dane obrazu
+} cover_result_t;
+
+typedef struct {
+  uint32_t decoded;            // okładki zdekodowane i zapisane w bazie
+  uint32_t cacheHits;          // okładki z bazy bez dekodowania
+  uint32_t failed;
+  uint32_t noSource;           // utwory bez okładki (tagi ani katalog)
+  uint32_t lastDecodeMs;
+  uint32_t maxDecodeMs;
+  uint32_t lastPeakBytes;      // szczyt pamięci dekodowania (bufory dekodera)
+  uint32_t maxPeakBytes;
+  uint16_t lastWidth;          // obraz źródłowy
+  uint16_t lastHeight;
+  uint8_t  lastFormat;         // cover_format_t
+  uint8_t  lastResult;         // cover_result_t
+  uint32_t covers;             // okładki w bazie
+} cover_art_status_t;
+
+// Init - po media_lib_init() (zadanie "CoverArt", rdzeń 0)
+void     cover_art_init(void);
+
+// Bieżący utwór (pełna ścieżka, pusty = brak) - okładka z bazy albo dekodowanie
+void     cover_art_show(const char* path);
+// evt_image: pary pozycja / długość segmentów obrazu w pliku
+void     cover_art_source(const char* path, const uint32_t* segments, uint8_t count);
+
+// Zmiana gotowej okładki (odświeżenie ekranu) i bitmapa dla ścieżki (MEDIA_COVER_BYTES), false = brak
+uint32_t cover_art_generation(void);
+bool     cover_art_get(const char* path, uint8_t* bitmap);
+
+void     cover_art_get_status(cover_art_status_t* out);
+const char* cover_art_format_name(uint8_t format);
+const char* cover_art_result_name(uint8_t result);
@@ -0,0 +1,385 @@
+#include "DirIndex.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+
+// ======================= STRUKTURY INDEKSU =======================
+
+// Wpis katalogu - nazwa leży w arenie katalogu
+typedef struct {
+  uint32_t nameOff;   // offset nazwy w arenie
+  uint8_t  nameLen;   // długość nazwy (bez \0)
+  uint8_t  type;      // dir_type_t
+} slot_entry_t;
+
+typedef struct {
+  char          path[DIR_PATH_LENGTH + 1];
+  slot_entry_t* entries;
+  char*         arena;
+  uint16_t      count;
+  uint16_t      capacity;
+  uint32_t      arenaUsed;
+  uint32_t      arenaSize;
+  uint32_t      lastUse;    // licznik użyć - LRU
+  uint32_t      generation; // numer skanu (dir_index_generation)
+  bool          valid;
+} dir_slot_t;
+
+static dir_slot_t        g_slots[DIR_INDEX_SLOTS];
+static dir_index_stats_t g_stats;
+static uint32_t          g_useCounter = 0;
+static uint32_t          g_generation = 0;
+static SemaphoreHandle_t g_lock = nullptr;
+
+static const uint16_t INITIAL_CAPACITY = 64;
+static const uint32_t INITIAL_ARENA    = 2048;
+
+// Rozszerzenia plików audio - ten sam zestaw dla WebUI i OLED
+typedef struct {
+  const char* ext;
+  uint8_t     type;
+} audio_ext_t;
+
+static const audio_ext_t AUDIO_EXTS[] = {
+  { ".mp3",  DIR_TYPE_MP3 },
+  { ".wav",  DIR_TYPE_WAV },
+  { ".flac", DIR_TYPE_FLAC },
+  { ".aac",  DIR_TYPE_AAC },
+  { ".m4a",  DIR_TYPE_M4A },
+  { ".ogg",  DIR_TYPE_OGG },
+};
+
+// ======================= PAMIĘĆ =======================
+
+static void* index_realloc(void* ptr, size_t size)
+{
+  void* p = ps_realloc(ptr, size);
+  if (!p) p = realloc(ptr, size);   // bez PSRAM - pamięć wewnętrzna
+  return p;
+}
+
+static void slot_free(dir_slot_t* s)
+{
+  if (s->entries) free(s->entries);
+  if (s->arena) free(s->arena);
+  memset(s, 0, sizeof(dir_slot_t));
+}
+
+static bool slot_add(dir_slot_t* s, const char* name, size_t len, uint8_t type)
+{
+  if (s->count >= s->capacity) {
+    uint16_t cap = s->capacity ? s->capacity * 2 : INITIAL_CAPACITY;
+    if (cap > DIR_INDEX_MAX_ENTRIES) cap = DIR_INDEX_MAX_ENTRIES;
+    if (cap <= s->count) return false;
+    slot_entry_t* e = (slot_entry_t*)index_realloc(s->entries, cap * sizeof(slot_entry_t));
+    if (!e) return false;
+    s->entries = e;
+    s->capacity = cap;
+  }
+  if (s->arenaUsed + len + 1 > s->arenaSize) {
+    uint32_t size = s->arenaSize ? s->arenaSize : INITIAL_ARENA;
+    while (s->arenaUsed + len + 1 > size) size *= 2;
+    char* a = (char*)index_realloc(s->arena, size);
+    if (!a) return false;
+    s->arena = a;
+    s->arenaSize = size;
+  }
+
+  slot_entry_t* e = &s->entries[s->count++];
+  e->nameOff = s->arenaUsed;
+  e->nameLen = (uint8_t)len;
+  e->type = type;
+  memcpy(s->arena + s->arenaUsed, name, len);
+  s->arena[s->arenaUsed + len] = '\0';
+  s->arenaUsed += len + 1;
+  return true;
+}
+
+// ======================= SKANOWANIE =======================
+
+// Typ pliku z rozszerzenia, 0 = nie audio (DIR_TYPE_DIR nie występuje dla plików)
+static uint8_t audio_type(const char* name, size_t len)
+{
+  for (size_t i = 0; i < sizeof(AUDIO_EXTS) / sizeof(AUDIO_EXTS[0]); i++) {
+    size_t el = strlen(AUDIO_EXTS[i].ext);
+    if (len > el && strcasecmp(name + len - el, AUDIO_EXTS[i].ext) == 0) return AUDIO_EXTS[i].type;
+  }
+  return 0;
+}
+
+// Odczyt katalogu z karty do s (poza mutexem), false = brak katalogu
+static bool slot_scan(dir_slot_t* s, const char* path, uint16_t* skippedOut)
+{
+  File dir = SD.open(path);
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return false;
+  }
+
+  strncpy(s->path, path, DIR_PATH_LENGTH);
+  s->path[DIR_PATH_LENGTH] = '\0';
+
+  uint16_t skipped = 0;
+  bool isDir = false;
+  // getNextFileName() czyta tylko wpis katalogu - openNextFile() otwierał każdy plik
+  String full = dir.getNextFileName(&isDir);
+  while (full.length() > 0) {
+    const char* name = full.c_str();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    size_t len = strlen(name);
+
+    uint8_t type = isDir ? (uint8_t)DIR_TYPE_DIR : audio_type(name, len);
+    if (len > 0 && (isDir || type != 0)) {
+      if (len > DIR_NAME_LENGTH || !slot_add(s, name, len, type)) skipped++;
+    }
+    full = dir.getNextFileName(&isDir);
+  }
+  dir.close();
+
+  // Najpierw katalogi, potem pliki - alfabetycznie (jak dotychczas compareTo)
+  const char* arena = s->arena;
+  std::sort(s->entries, s->entries + s->count, [arena](const slot_entry_t& a, const slot_entry_t& b) {
+    bool ad = a.type == DIR_TYPE_DIR;
+    bool bd = b.type == DIR_TYPE_DIR;
+    if (ad != bd) return ad;
+    return strcmp(arena + a.nameOff, arena + b.nameOff) < 0;
+  });
+
+  s->valid = true;
+  *skippedOut = skipped;
+  if (skipped) {
+    Serial.printf("debug DirIndex -> %s: pominięto %u wpisów\n", path, skipped);
+  }
+  return true;
+}
+
+// Katalog w pamięci (pod mutexem), nullptr = brak
+static dir_slot_t* slot_find(const char* path)
+{
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS; i++) {
+    if (g_slots[i].valid && strcmp(g_slots[i].path, path) == 0) {
+      g_slots[i].lastUse = ++g_useCounter;
+      return &g_slots[i];
+    }
+  }
+  return nullptr;
+}
+
+static void stats_refresh_memory(void)
+{
+  uint8_t dirs = 0;
+  uint32_t bytes = 0;
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS; i++) {
+    if (!g_slots[i].valid) continue;
+    dirs++;
+    bytes += g_slots[i].arenaSize + g_slots[i].capacity * sizeof(slot_entry_t);
+  }
+  g_stats.cachedDirs = dirs;
+  g_stats.arenaBytes = bytes;
+}
+
+// Zwraca katalog w pamięci - z mutexem ZABRANYM, nullptr = brak katalogu (mutex zwolniony)
+static dir_slot_t* slot_acquire(const char* path)
+{
+  if (!g_lock || !path || !path[0]) return nullptr;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  dir_slot_t* s = slot_find(path);
+  if (s) {
+    g_stats.hits++;
+    return s;
+  }
+  g_stats.misses++;
+  xSemaphoreGive(g_lock);
+
+  // Skan bez blokady - drugi wątek w tym czasie obsługuje inne katalogi z pamięci
+  dir_slot_t fresh;
+  memset(&fresh, 0, sizeof(fresh));
+  uint16_t skipped = 0;
+  uint32_t t0 = millis();
+  if (!slot_scan(&fresh, path, &skipped)) {
+    slot_free(&fresh);
+    return nullptr;
+  }
+  uint32_t ms = millis() - t0;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_stats.scans++;
+  g_stats.lastScanMs = ms;
+  g_stats.lastScanEntries = fresh.count;
+  g_stats.skipped = skipped;
+  if (ms > g_stats.maxScanMs) g_stats.maxScanMs = ms;
+  g_stats.avgScanMs = g_stats.scans == 1 ? ms : (g_stats.avgScanMs * 7 + ms) / 8;
+
+  // Miejsce: ten sam katalog (równoległy skan), wolny slot albo najdawniej używany
+  dir_slot_t* victim = nullptr;
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS && !victim; i++) {
+    if (g_slots[i].valid && strcmp(g_slots[i].path, path) == 0) victim = &g_slots[i];
+  }
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS && !victim; i++) {
+    if (!g_slots[i].valid) victim = &g_slots[i];
+  }
+  if (!victim) {
+    victim = &g_slots[0];
+    for (uint8_t i = 1; i < DIR_INDEX_SLOTS; i++) {
+      if (g_slots[i].lastUse < victim->lastUse) victim = &g_slots[i];
+    }
+  }
+
+  dir_slot_t old = *victim;
+  *victim = fresh;
+  victim->lastUse = ++g_useCounter;
+  victim->generation = ++g_generation;
+  stats_refresh_memory();
+  slot_free(&old);   // free() pod mutexem - krótkie, bez I/O
+  return victim;
+}
+
+// ======================= API =======================
+
+void dir_index_init(void)
+{
+  if (g_lock) return;
+  memset(g_slots, 0, sizeof(g_slots));
+  memset(&g_stats, 0, sizeof(g_stats));
+  g_lock = xSemaphoreCreateMutex();
+}
+
+int32_t dir_index_open(const char* path)
+{
+  dir_slot_t* s = slot_acquire(path);
+  if (!s) return -1;
+  int32_t count = s->count;
+  xSemaphoreGive(g_lock);
+  return count;
+}
+
+bool dir_index_get(const char* path, int32_t index, dir_entry_t* out)
+{
+  if (!out) return false;
+  dir_slot_t* s = slot_acquire(path);
+  if (!s) return false;
+
+  bool ok = index >= 0 && index < s->count;
+  if (ok) {
+    const slot_entry_t* e = &s->entries[index];
+    out->type = e->type;
+    memcpy(out->name, s->arena + e->nameOff, e->nameLen + 1);
+  }
+  xSemaphoreGive(g_lock);
+  return ok;
+}
+
+// Porządek listy: katalogi, potem pliki, w grupie strcmp
+static int entry_compare(const dir_slot_t* s, const slot_entry_t* e, bool isDir, const char* name)
+{
+  bool ed = e->type == DIR_TYPE_DIR;
+  if (ed != isDir) return ed ? -1 : 1;
+  return strcmp(s->arena + e->nameOff, name);
+}
+
+int32_t dir_index_seek(const char* path, bool isDir, const char* name)
+{
+  if (!name) return 0;
+  dir_slot_t* s = slot_acquire(path);
+  if (!s) return -1;
+
+  // Wyszukiwanie binarne pierwszego wpisu większego od kursora
+  int32_t lo = 0;
+  int32_t hi = s->count;
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (entry_compare(s, &s->entries[mid], isDir, name) <= 0) lo = mid + 1;
+    else hi = mid;
+  }
+  g_stats.seeks++;
+  xSemaphoreGive(g_lock);
+  return lo;
+}
+
+uint32_t dir_index_generation(const char* path)
+{
+  if (!g_lock || !path) return 0;
+  uint32_t gen = 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS; i++) {
+    if (g_slots[i].valid && strcmp(g_slots[i].path, path) == 0) {
+      gen = g_slots[i].generation;
+      break;
+    }
+  }
+  xSemaphoreGive(g_lock);
+  return gen;
+}
+
+void dir_index_invalidate(const char* path)
+{
+  if (!g_lock || !path) return;
+  dir_slot_t old;
+  memset(&old, 0, sizeof(old));
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS; i++) {
+    if (g_slots[i].valid && strcmp(g_slots[i].path, path) == 0) {
+      old = g_slots[i];
+      memset(&g_slots[i], 0, sizeof(dir_slot_t));
+      g_stats.invalidations++;
+      break;
+    }
+  }
+  stats_refresh_memory();
+  xSemaphoreGive(g_lock);
+
+  slot_free(&old);
+}
+
+void dir_index_invalidate_parent(const char* filePath)
+{
+  if (!filePath) return;
+  const char* slash = strrchr(filePath, '/');
+  if (!slash || slash == filePath) {
+    dir_index_invalidate("/");
+    return;
+  }
+
+  char parent[DIR_PATH_LENGTH + 1];
+  size_t len = slash - filePath;
+  if (len > DIR_PATH_LENGTH) return;
+  memcpy(parent, filePath, len);
+  parent[len] = '\0';
+  dir_index_invalidate(parent);
+}
+
+void dir_index_invalidate_all(void)
+{
+  if (!g_lock) return;
+  for (uint8_t i = 0; i < DIR_INDEX_SLOTS; i++) {
+    char path[DIR_PATH_LENGTH + 1];
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    bool valid = g_slots[i].valid;
+    if (valid) memcpy(path, g_slots[i].path, sizeof(path));
+    xSemaphoreGive(g_lock);
+    if (valid) dir_index_invalidate(path);
+  }
+}
+
+uint8_t dir_index_audio_type(const char* name)
+{
+  return name ? audio_type(name, strlen(name)) : 0;
+}
+
+void dir_index_get_stats(dir_index_stats_t* out)
+{
+  if (!out) return;
+  if (!g_lock) {
+    memset(out, 0, sizeof(dir_index_stats_t));
+    return;
+  }
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  *out = g_stats;
+  xSemaphoreGive(g_lock);
+}
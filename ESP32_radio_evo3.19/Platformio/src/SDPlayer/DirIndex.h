@@ -0,0 +1,89 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// DIR INDEX - wspólny indeks katalogów karty SD (SDPlayerWebUI + SDPlayerOLED)
+// ========================================================================
+// Do tej pory każdy interfejs skanował katalog sam: WebUI przy każdym
+// /sdplayer/api/list (co 5 s z przeglądarki), OLED przy aktywacji i po
+// każdej zmianie katalogu - za każdym razem openNextFile() otwierał każdy
+// wpis, a nazwy lądowały w osobnych obiektach String na stercie.
+// Do tego oba filtry plików audio były różne, więc indeksy list WebUI
+// i OLED (synchronizowane przez getSelectedIndex()) potrafiły się rozjechać.
+//
+// Teraz katalog skanowany jest raz (getNextFileName() - bez otwierania
+// wpisów), posortowany (katalogi, potem pliki, strcmp) i trzymany w pamięci
+// podręcznej DIR_INDEX_SLOTS ostatnio używanych katalogów (LRU):
+//   - nazwy w jednym bloku PSRAM (arena, rozdzielone '\0'),
+//   - wpis = przesunięcie w arenie + długość + typ (katalog / format audio),
+//     typ liczony raz przy skanowaniu.
+// Unieważnienie: zmiana katalogu (cd / up - świeży odczyt), wgranie
+// i usunięcie pliku (/upload, /delete - katalog nadrzędny pliku).
+// Dostęp z wątku WWW i z loop() - pod mutexem, nazwy kopiowane do
+// bufora wołającego.
+// ========================================================================
+
+static const uint8_t  DIR_INDEX_SLOTS       = 4;      // katalogi w pamięci podręcznej
+static const uint16_t DIR_INDEX_MAX_ENTRIES = 8192;   // wpisów w jednym katalogu
+static const uint16_t DIR_NAME_LENGTH       = 255;    // maks. nazwa wpisu (bajty UTF-8)
+static const uint16_t DIR_PATH_LENGTH       = 255;    // maks. ścieżka katalogu
+
+typedef enum {
+  DIR_TYPE_DIR = 0,
+  DIR_TYPE_MP3,
+  DIR_TYPE_WAV,
+  DIR_TYPE_FLAC,
+  DIR_TYPE_AAC,
+  DIR_TYPE_M4A,
+  DIR_TYPE_OGG
+} dir_type_t;
+
+typedef struct {
+  uint8_t type;                        // dir_type_t
+  char    name[DIR_NAME_LENGTH + 1];   // sama nazwa, bez ścieżki
+} dir_entry_t;
+
+typedef struct {
+  uint32_t scans;                      // odczyty katalogów z karty
+  uint32_t hits;                       // zapytania obsłużone z pamięci
+  uint32_t misses;
+  uint32_t invalidations;
+  uint32_t lastScanMs;
+  uint32_t avgScanMs;
+  uint32_t maxScanMs;
+  uint16_t lastScanEntries;
+  uint16_t skipped;                    // pominięte wpisy (za długa nazwa, limit wpisów)
+  uint8_t  cachedDirs;
+  uint32_t arenaBytes;                 // nazwy + wpisy wszystkich katalogów w pamięci
+  uint32_t seeks;                      // kursory stronicowania
+} dir_index_stats_t;
+
+// Init - mutex, w setup() przed serwerem WWW i loop(); pamięć przydzielana przy pierwszym skanie
+void     dir_index_init(void);
+
+// Liczba wpisów katalogu (skan przy braku w pamięci), -1 = brak katalogu
+int32_t  dir_index_open(const char* path);
+
+// Wpis nr index katalogu path (kopia), false = poza zakresem / brak katalogu
+bool     dir_index_get(const char* path, int32_t index, dir_entry_t* out);
+
+// Kursor stronicowania: pierwszy wpis za (typ, nazwa) w porządku listy.
+// Nazwa zamiast numeru - strona "po X" jest ta sama po ponownym skanie
+// (dopisany / usunięty plik nie przesuwa kolejnych stron o jeden wpis).
+int32_t  dir_index_seek(const char* path, bool isDir, const char* name);
+
+// Numer wersji listy katalogu (zmienia się przy każdym skanie), 0 = brak w pamięci.
+// Bez skanowania - do wykrywania zmian przez WebUI / OLED.
+uint32_t dir_index_generation(const char* path);
+
+// Unieważnienie - katalog / katalog nadrzędny pliku (np. "/music/a.mp3" -> "/music")
+void     dir_index_invalidate(const char* path);
+void     dir_index_invalidate_parent(const char* filePath);
+void     dir_index_invalidate_all(void);
+
+// Typ pliku z rozszerzenia (DIR_TYPE_MP3..), 0 = nie audio - wspólny filtr formatów
+uint8_t  dir_index_audio_type(const char* name);
+
+void     dir_index_get_stats(dir_index_stats_t* out);
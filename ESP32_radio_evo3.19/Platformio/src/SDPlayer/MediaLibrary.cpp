@@ -0,0 +1,1464 @@
+#include "MediaLibrary.h"
+#include "DirIndex.h"
+#include "PlayerState.h"   // odtwarzanie z karty w toku
+#include "SdIo.h"          // zapisy na kartę przez harmonogram (odtwarzanie ma pierwszeństwo)
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <algorithm>
+
+// ======================= STRUKTURY BAZY =======================
+
+// Rekord utworu - teksty w arenie bazy (offset 0 = pusty tekst)
+typedef struct {
+  uint32_t pathHash;      // FNV-1a pełnej ścieżki - wyszukiwanie
+  uint32_t pathOff;
+  uint32_t titleOff;
+  uint32_t artistOff;
+  uint32_t albumOff;
+  uint32_t durationSec;
+  uint32_t sampleRate;
+  uint16_t dir;           // numer katalogu
+  uint8_t  format;        // dir_type_t
+  uint8_t  reserved;
+  int16_t  trackGain;     // ReplayGain [0.01 dB], MEDIA_GAIN_NONE = brak
+  int16_t  albumGain;
+  uint16_t trackPeak;     // Q15, 0 = nieznany
+  uint16_t albumPeak;
+} lib_record_t;
+
+typedef struct {
+  uint32_t pathOff;
+  uint32_t signature;     // czas modyfikacji + skrót nazw wpisów
+  uint32_t firstRecord;
+  uint32_t recordCount;
+} lib_dir_t;
+
+typedef struct {
+  lib_record_t* records;
+  uint32_t      count;
+  uint32_t      capacity;
+  lib_dir_t*    dirs;
+  uint32_t      dirCount;
+  uint32_t      dirCapacity;
+  char*         arena;
+  uint32_t      arenaUsed;
+  uint32_t      arenaSize;
+  uint16_t*     byHash;     // numery rekordów wg pathHash
+  uint16_t*     byArtist;   // numery rekordów wg wykonawca, album, tytuł
+} lib_db_t;
+
+// Nagłówek pliku bazy; dalej: katalogi, rekordy, arena
+typedef struct {
+  char     magic[4];
+  uint16_t version;
+  uint16_t dirCount;
+  uint32_t recordCount;
+  uint32_t arenaSize;
+} db_header_t;
+
+static const char     DB_MAGIC[4]   = { 'E', 'V', 'M', 'L' };
+static const uint16_t DB_VERSION    = 2;   // 2: pola ReplayGain w rekordzie
+static const char     DB_TMP_FILE[] = "/.medialib.tmp";
+static const size_t   TAG_BUF_SIZE  = 4096;
+static const uint32_t RESCAN_SETTLE_MS = 5000;   // seria wgrań - jeden przebieg
+
+static lib_db_t           g_db;         // baza w użyciu (zamiana pod g_lock)
+static lib_db_t           g_build;      // przebieg w toku - tylko zadanie indeksera
+static media_lib_status_t g_status;
+static SemaphoreHandle_t  g_lock = nullptr;
+static volatile bool      g_rescan = false;
+static volatile uint32_t  g_rescanAt = 0;
+static uint8_t*           g_buf = nullptr;   // bufor nagłówków - tylko zadanie indeksera
+static uint32_t*          g_coverKeys = nullptr;   // klucze okładek w kolejności pliku (pod g_lock)
+static uint16_t           g_coverCount = 0;
+static uint32_t*          g_seekKeys = nullptr;    // klucze tablic przewijania w kolejności pliku (pod g_lock)
+static uint16_t           g_seekCount = 0;
+
+// ======================= PAMIĘĆ =======================
+
+static void* lib_realloc(void* ptr, size_t size)
+{
+  void* p = ps_realloc(ptr, size);
+  if (!p) p = realloc(ptr, size);   // bez PSRAM - pamięć wewnętrzna
+  return p;
+}
+
+static void db_free(lib_db_t* db)
+{
+  if (db->records) free(db->records);
+  if (db->dirs) free(db->dirs);
+  if (db->arena) free(db->arena);
+  if (db->byHash) free(db->byHash);
+  if (db->byArtist) free(db->byArtist);
+  memset(db, 0, sizeof(lib_db_t));
+}
+
+static uint32_t db_add_text(lib_db_t* db, const char* text)
+{
+  size_t len = strlen(text);
+  if (len == 0 && db->arenaUsed > 0) return 0;
+  if (db->arenaUsed + len + 1 > db->arenaSize) {
+    uint32_t size = db->arenaSize ? db->arenaSize : 16384;
+    while (db->arenaUsed + len + 1 > size) size *= 2;
+    char* a = (char*)lib_realloc(db->arena, size);
+    if (!a) return UINT32_MAX;
+    db->arena = a;
+    db->arenaSize = size;
+  }
+  uint32_t off = db->arenaUsed;
+  memcpy(db->arena + off, text, len + 1);
+  db->arenaUsed += len + 1;
+  return off;
+}
+
+static lib_record_t* db_add_record(lib_db_t* db)
+{
+  if (db->count >= MEDIA_LIB_MAX_RECORDS) return nullptr;
+  if (db->count >= db->capacity) {
+    uint32_t cap = db->capacity ? db->capacity * 2 : 256;
+    if (cap > MEDIA_LIB_MAX_RECORDS) cap = MEDIA_LIB_MAX_RECORDS;
+    lib_record_t* r = (lib_record_t*)lib_realloc(db->records, cap * sizeof(lib_record_t));
+    if (!r) return nullptr;
+    db->records = r;
+    db->capacity = cap;
+  }
+  lib_record_t* r = &db->records[db->count++];
+  memset(r, 0, sizeof(lib_record_t));
+  return r;
+}
+
+static lib_dir_t* db_add_dir(lib_db_t* db)
+{
+  if (db->dirCount >= MEDIA_LIB_MAX_DIRS) return nullptr;
+  if (db->dirCount >= db->dirCapacity) {
+    uint32_t cap = db->dirCapacity ? db->dirCapacity * 2 : 32;
+    if (cap > MEDIA_LIB_MAX_DIRS) cap = MEDIA_LIB_MAX_DIRS;
+    lib_dir_t* d = (lib_dir_t*)lib_realloc(db->dirs, cap * sizeof(lib_dir_t));
+    if (!d) return nullptr;
+    db->dirs = d;
+    db->dirCapacity = cap;
+  }
+  lib_dir_t* d = &db->dirs[db->dirCount++];
+  memset(d, 0, sizeof(lib_dir_t));
+  return d;
+}
+
+static uint32_t fnv_update(uint32_t h, const void* data, size_t len)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < len; i++) { h ^= p[i]; h *= 16777619UL; }
+  return h;
+}
+
+static uint32_t path_hash(const char* path)
+{
+  return fnv_update(2166136261UL, path, strlen(path));
+}
+
+static int text_compare(const lib_db_t* db, uint32_t a, uint32_t b)
+{
+  return strcasecmp(db->arena + a, db->arena + b);
+}
+
+// Indeksy wyszukiwania po wczytaniu / przebiegu
+static bool db_build_indexes(lib_db_t* db)
+{
+  if (db->byHash) free(db->byHash);
+  if (db->byArtist) free(db->byArtist);
+  db->byHash = nullptr;
+  db->byArtist = nullptr;
+  if (db->count == 0) return true;
+
+  db->byHash = (uint16_t*)lib_realloc(nullptr, db->count * sizeof(uint16_t));
+  db->byArtist = (uint16_t*)lib_realloc(nullptr, db->count * sizeof(uint16_t));
+  if (!db->byHash || !db->byArtist) return false;
+  for (uint32_t i = 0; i < db->count; i++) { db->byHash[i] = i; db->byArtist[i] = i; }
+
+  const lib_record_t* rec = db->records;
+  std::sort(db->byHash, db->byHash + db->count, [rec](uint16_t a, uint16_t b) {
+    return rec[a].pathHash < rec[b].pathHash;
+  });
+  std::sort(db->byArtist, db->byArtist + db->count, [db, rec](uint16_t a, uint16_t b) {
+    int c = text_compare(db, rec[a].artistOff, rec[b].artistOff);
+    if (c == 0) c = text_compare(db, rec[a].albumOff, rec[b].albumOff);
+    if (c == 0) c = text_compare(db, rec[a].titleOff, rec[b].titleOff);
+    if (c == 0) c = strcmp(db->arena + rec[a].pathOff, db->arena + rec[b].pathOff);
+    return c < 0;
+  });
+  return true;
+}
+
+// ======================= PLIK BAZY =======================
+
+static bool db_load(lib_db_t* db)
+{
+  File f = SD.open(MEDIA_LIB_DB_FILE, FILE_READ);
+  if (!f) return false;
+
+  db_header_t h;
+  bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            memcmp(h.magic, DB_MAGIC, 4) == 0 && h.version == DB_VERSION &&
+            h.dirCount <= MEDIA_LIB_MAX_DIRS && h.recordCount <= MEDIA_LIB_MAX_RECORDS &&
+            f.size() == sizeof(h) + h.dirCount * sizeof(lib_dir_t) + h.recordCount * sizeof(lib_record_t) + h.arenaSize;
+  if (ok) {
+    db->dirs = (lib_dir_t*)lib_realloc(nullptr, (h.dirCount + 1) * sizeof(lib_dir_t));
+    db->records = (lib_record_t*)lib_realloc(nullptr, (h.recordCount + 1) * sizeof(lib_record_t));
+    db->arena = (char*)lib_realloc(nullptr, h.arenaSize + 1);
+    ok = db->dirs && db->records && db->arena;
+  }
+  if (ok) {
+    size_t dirBytes = h.dirCount * sizeof(lib_dir_t);
+    size_t recBytes = h.recordCount * sizeof(lib_record_t);
+    ok = f.read((uint8_t*)db->dirs, dirBytes) == dirBytes &&
+         f.read((uint8_t*)db->records, recBytes) == recBytes &&
+         f.read((uint8_t*)db->arena, h.arenaSize) == h.arenaSize;
+  }
+  f.close();
+
+  if (ok) {
+    db->dirCount = db->dirCapacity = h.dirCount;
+    db->count = db->capacity = h.recordCount;
+    db->arenaUsed = db->arenaSize = h.arenaSize;
+    db->arena[h.arenaSize] = '\0';
+    // Offsety poza arenę = uszkodzony plik
+    for (uint32_t i = 0; ok && i < db->count; i++) {
+      const lib_record_t* r = &db->records[i];
+      ok = r->pathOff < h.arenaSize && r->titleOff < h.arenaSize && r->artistOff < h.arenaSize &&
+           r->albumOff < h.arenaSize && r->dir < h.dirCount;
+    }
+    for (uint32_t i = 0; ok && i < db->dirCount; i++) {
+      ok = db->dirs[i].pathOff < h.arenaSize &&
+           db->dirs[i].firstRecord + db->dirs[i].recordCount <= h.recordCount;
+    }
+  }
+  if (ok) ok = db_build_indexes(db);
+  if (!ok) {
+    db_free(db);
+    Serial.println("debug medialib -> Plik bazy uszkodzony - pełny przebieg");
+  }
+  return ok;
+}
+
+static bool db_save(const lib_db_t* db)
+{
+  sdio_begin(SDIO_CLASS_LIBRARY, MEDIA_LIB_IO_MAX_WAIT_MS);
+  File f = SD.open(DB_TMP_FILE, FILE_WRITE);
+  if (!f) {
+    sdio_end(SDIO_CLASS_LIBRARY, 0);
+    return false;
+  }
+
+  db_header_t h;
+  memcpy(h.magic, DB_MAGIC, 4);
+  h.version = DB_VERSION;
+  h.dirCount = db->dirCount;
+  h.recordCount = db->count;
+  h.arenaSize = db->arenaUsed;
+
+  size_t dirBytes = db->dirCount * sizeof(lib_dir_t);
+  size_t recBytes = db->count * sizeof(lib_record_t);
+  bool ok = f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+            f.write((const uint8_t*)db->dirs, dirBytes) == dirBytes &&
+            f.write((const uint8_t*)db->records, recBytes) == recBytes &&
+            f.write((const uint8_t*)db->arena, db->arenaUsed) == db->arenaUsed;
+  f.close();
+
+  if (ok) {
+    SD.remove(MEDIA_LIB_DB_FILE);
+    ok = SD.rename(DB_TMP_FILE, MEDIA_LIB_DB_FILE);
+  }
+  if (!ok) SD.remove(DB_TMP_FILE);
+  sdio_end(SDIO_CLASS_LIBRARY, ok ? sizeof(h) + dirBytes + recBytes + db->arenaUsed : 0);
+  return ok;
+}
+
+// ======================= OKŁADKI =======================
+
+// Plik okładek: nagłówek, dalej rekordy { klucz, bitmapa } - tylko dopisywanie
+static const char     COVER_MAGIC[4] = { 'E', 'V', 'C', 'V' };
+static const uint16_t COVER_VERSION  = 1;
+static const uint32_t COVER_HEADER   = 8;
+static const uint32_t COVER_RECORD   = 4 + MEDIA_COVER_BYTES;
+
+static void cover_load(void)
+{
+  g_coverKeys = (uint32_t*)lib_realloc(nullptr, MEDIA_LIB_MAX_COVERS * sizeof(uint32_t));
+  if (!g_coverKeys) return;
+
+  File f = SD.open(MEDIA_LIB_COVER_FILE, FILE_READ);
+  if (!f) return;
+  uint8_t h[COVER_HEADER];
+  bool ok = f.read(h, sizeof(h)) == sizeof(h) && memcmp(h, COVER_MAGIC, 4) == 0 &&
+            (h[4] | (h[5] << 8)) == COVER_VERSION && (h[6] | (h[7] << 8)) == MEDIA_COVER_SIZE;
+  uint32_t count = ok ? (f.size() - COVER_HEADER) / COVER_RECORD : 0;
+  if (count > MEDIA_LIB_MAX_COVERS) count = MEDIA_LIB_MAX_COVERS;
+  for (uint32_t i = 0; ok && i < count; i++) {
+    ok = f.seek(COVER_HEADER + i * COVER_RECORD) && f.read((uint8_t*)&g_coverKeys[i], 4) == 4;
+    if (ok) g_coverCount = i + 1;
+  }
+  f.close();
+  if (!ok && g_coverCount == 0) {
+    SD.remove(MEDIA_LIB_COVER_FILE);
+    Serial.println("debug medialib -> Plik okładek uszkodzony - usunięty");
+  }
+}
+
+// Numer rekordu okładki, -1 = brak (pod g_lock)
+static int32_t cover_find(uint32_t key)
+{
+  for (uint16_t i = 0; i < g_coverCount; i++) {
+    if (g_coverKeys[i] == key) return i;
+  }
+  return -1;
+}
+
+// ======================= TABLICE PRZEWIJANIA =======================
+
+// Plik tablic: nagłówek, dalej rekordy { klucz, tablica } - tylko dopisywanie
+static const char     SEEK_MAGIC[4] = { 'E', 'V', 'S', 'K' };
+static const uint16_t SEEK_VERSION  = 1;
+static const uint32_t SEEK_HEADER   = 8;
+static const uint32_t SEEK_RECORD   = 4 + MEDIA_SEEK_BYTES;
+
+static void seek_load(void)
+{
+  g_seekKeys = (uint32_t*)lib_realloc(nullptr, MEDIA_LIB_MAX_SEEK * sizeof(uint32_t));
+  if (!g_seekKeys) return;
+
+  File f = SD.open(MEDIA_LIB_SEEK_FILE, FILE_READ);
+  if (!f) return;
+  uint8_t h[SEEK_HEADER];
+  bool ok = f.read(h, sizeof(h)) == sizeof(h) && memcmp(h, SEEK_MAGIC, 4) == 0 &&
+            (h[4] | (h[5] << 8)) == SEEK_VERSION && (h[6] | (h[7] << 8)) == MEDIA_SEEK_BYTES;
+  uint32_t count = ok ? (f.size() - SEEK_HEADER) / SEEK_RECORD : 0;
+  if (count > MEDIA_LIB_MAX_SEEK) count = MEDIA_LIB_MAX_SEEK;
+  for (uint32_t i = 0; ok && i < count; i++) {
+    ok = f.seek(SEEK_HEADER + i * SEEK_RECORD) && f.read((uint8_t*)&g_seekKeys[i], 4) == 4;
+    if (ok) g_seekCount = i + 1;
+  }
+  f.close();
+  if (!ok && g_seekCount == 0) {
+    SD.remove(MEDIA_LIB_SEEK_FILE);
+    Serial.println("debug medialib -> Plik tablic przewijania uszkodzony - usunięty");
+  }
+}
+
+// Numer najnowszego rekordu tablicy, -1 = brak (pod g_lock)
+static int32_t seek_find(uint32_t key)
+{
+  for (int32_t i = (int32_t)g_seekCount - 1; i >= 0; i--) {
+    if (g_seekKeys[i] == key) return i;
+  }
+  return -1;
+}
+
+// ======================= TEKST TAGÓW =======================
+
+// Znak Unicode jako UTF-8 - tylko gdy zmieści się w całości
+static bool utf8_put(char* out, size_t* pos, uint32_t cp)
+{
+  char tmp[3];
+  size_t n;
+  if (cp < 0x80) { tmp[0] = (char)cp; n = 1; }
+  else if (cp < 0x800) { tmp[0] = 0xC0 | (cp >> 6); tmp[1] = 0x80 | (cp & 0x3F); n = 2; }
+  else { tmp[0] = 0xE0 | (cp >> 12); tmp[1] = 0x80 | ((cp >> 6) & 0x3F); tmp[2] = 0x80 | (cp & 0x3F); n = 3; }
+  if (*pos + n > MEDIA_TAG_LENGTH) return false;
+  memcpy(out + *pos, tmp, n);
+  *pos += n;
+  return true;
+}
+
+static void text_finish(char* out, size_t pos)
+{
+  while (pos > 0 && (out[pos - 1] == ' ' || out[pos - 1] == '\0')) pos--;
+  out[pos] = '\0';
+}
+
+// Tekst tagu: 0 = ISO-8859-1, 1 = UTF-16 z BOM, 2 = UTF-16BE, 3 = UTF-8 (kodowania ID3v2)
+static void tag_text(char* out, const uint8_t* src, size_t len, uint8_t encoding)
+{
+  size_t pos = 0;
+  if (encoding == 1 || encoding == 2) {
+    bool bigEndian = encoding == 2;
+    size_t i = 0;
+    if (len >= 2 && src[0] == 0xFF && src[1] == 0xFE) { bigEndian = false; i = 2; }
+    else if (len >= 2 && src[0] == 0xFE && src[1] == 0xFF) { bigEndian = true; i = 2; }
+    for (; i + 1 < len; i += 2) {
+      uint32_t cp = bigEndian ? (src[i] << 8) | src[i + 1] : src[i] | (src[i + 1] << 8);
+      if (cp == 0) break;
+      if (cp >= 0xD800 && cp <= 0xDFFF) cp = '?';   // poza BMP - czcionki OLED i tak nie mają
+      if (!utf8_put(out, &pos, cp)) break;
+    }
+  } else if (encoding == 3) {
+    size_t n = 0;
+    while (n < len && src[n]) n++;
+    if (n > MEDIA_TAG_LENGTH) {
+      n = MEDIA_TAG_LENGTH;
+      while (n > 0 && (src[n] & 0xC0) == 0x80) n--;   // bez uciętego znaku wielobajtowego
+    }
+    memcpy(out, src, n);
+    pos = n;
+  } else {
+    for (size_t i = 0; i < len && src[i]; i++) {
+      if (!utf8_put(out, &pos, src[i])) break;
+    }
+  }
+  text_finish(out, pos);
+}
+
+// ReplayGain z pary klucz / wartość tekstowa: "-6.54 dB", szczyt "0.988123";
+// R128_*_GAIN (Opus) = liczba całkowita Q7.8 dB względem -23 LUFS -> +5 dB do poziomu ReplayGain
+static void gain_tag(const char* key, size_t keyLen, const uint8_t* value, size_t valueLen, media_info_t* out)
+{
+  static const char* const KEYS[] = { "REPLAYGAIN_TRACK_GAIN", "REPLAYGAIN_ALBUM_GAIN", "REPLAYGAIN_TRACK_PEAK",
+                                      "REPLAYGAIN_ALBUM_PEAK", "R128_TRACK_GAIN", "R128_ALBUM_GAIN" };
+  int8_t k = -1;
+  for (uint8_t i = 0; i < sizeof(KEYS) / sizeof(KEYS[0]); i++) {
+    if (strlen(KEYS[i]) == keyLen && strncasecmp(key, KEYS[i], keyLen) == 0) { k = i; break; }
+  }
+  if (k < 0) return;
+
+  char v[24];
+  size_t n = valueLen < sizeof(v) - 1 ? valueLen : sizeof(v) - 1;
+  memcpy(v, value, n);
+  v[n] = '\0';
+  char* end;
+  float x = strtof(v, &end);
+  if (end == v) return;
+
+  if (k == 2 || k == 3) {
+    float q = x * 32768.0f;
+    uint16_t peak = q >= 65535.0f ? 65535 : q < 1.0f ? 1 : (uint16_t)q;
+    if (k == 2) out->trackPeak = peak;
+    else out->albumPeak = peak;
+    return;
+  }
+  if (k >= 4) x = x / 256.0f + 5.0f;
+  if (x < -300.0f) x = -300.0f;
+  if (x > 300.0f) x = 300.0f;
+  int16_t gain = (int16_t)lroundf(x * 100.0f);
+  int16_t* field = (k == 0 || k == 4) ? &out->trackGain : &out->albumGain;
+  if (k < 4 || *field == MEDIA_GAIN_NONE) *field = gain;   // REPLAYGAIN_* ma pierwszeństwo przed R128_*
+}
+
+// Komentarze Vorbis (FLAC, OGG Vorbis / Opus): długości little-endian, "KLUCZ=wartość" w UTF-8
+static uint32_t le32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint32_t be32(const uint8_t* p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+static void vorbis_comments(const uint8_t* p, size_t len, media_info_t* out)
+{
+  if (len < 8) return;
+  size_t pos = 4 + le32(p);   // vendor
+  if (pos + 4 > len) return;
+  uint32_t count = le32(p + pos);
+  pos += 4;
+  for (uint32_t i = 0; i < count && pos + 4 <= len; i++) {
+    uint32_t clen = le32(p + pos);
+    pos += 4;
+    if (clen > len - pos) clen = len - pos;   // ucięty bufor - ostatni komentarz częściowo
+    const char* c = (const char*)(p + pos);
+    char* field = nullptr;
+    size_t klen = 0;
+    if (clen > 6 && strncasecmp(c, "TITLE=", 6) == 0) { field = out->title; klen = 6; }
+    else if (clen > 7 && strncasecmp(c, "ARTIST=", 7) == 0) { field = out->artist; klen = 7; }
+    else if (clen > 6 && strncasecmp(c, "ALBUM=", 6) == 0) { field = out->album; klen = 6; }
+    if (field && !field[0]) tag_text(field, p + pos + klen, clen - klen, 3);
+    else if (!field) {
+      const char* eq = (const char*)memchr(c, '=', clen);
+      if (eq) gain_tag(c, eq - c, (const uint8_t*)eq + 1, clen - (eq - c) - 1, out);
+    }
+    pos += clen;
+  }
+}
+
+// ======================= FORMATY =======================
+
+static const uint16_t MP3_BITRATES[2][3][15] = {
+  { // MPEG1: Layer I, II, III
+    { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+    { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+  { // MPEG2 / 2.5
+    { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+    { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } }
+};
+static const uint32_t MP3_RATES[4][3] = {
+  { 11025, 12000, 8000 },    // MPEG2.5
+  { 0, 0, 0 },
+  { 22050, 24000, 16000 },   // MPEG2
+  { 44100, 48000, 32000 }    // MPEG1
+};
+static const uint32_t ADTS_RATES[13] = { 96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350 };
+
+// Ramka TXXX: kodowanie, opis, terminator (1 / 2 bajty), wartość
+static void txxx_gain(const uint8_t* p, size_t len, media_info_t* out)
+{
+  uint8_t encoding = p[0];
+  bool wide = encoding == 1 || encoding == 2;
+  size_t i = 1;
+  while (i + (wide ? 1 : 0) < len && (wide ? (p[i] | p[i + 1]) : p[i])) i += wide ? 2 : 1;
+  size_t v = i + (wide ? 2 : 1);
+  if (v >= len) return;
+  char key[MEDIA_TAG_LENGTH + 1];
+  char value[MEDIA_TAG_LENGTH + 1];
+  tag_text(key, p + 1, i - 1, encoding);
+  tag_text(value, p + v, len - v, encoding);
+  gain_tag(key, strlen(key), (const uint8_t*)value, strlen(value), out);
+}
+
+// ID3v2 na początku pliku, zwraca początek danych audio
+static uint32_t read_id3v2(File& f, media_info_t* out)
+{
+  uint8_t h[10];
+  f.seek(0);
+  if (f.read(h, 10) != 10 || memcmp(h, "ID3", 3) != 0) return 0;
+
+  uint8_t version = h[3];
+  uint32_t size = ((uint32_t)(h[6] & 0x7F) << 21) | ((h[7] & 0x7F) << 14) | ((h[8] & 0x7F) << 7) | (h[9] & 0x7F);
+  uint32_t end = 10 + size;
+  uint32_t audioStart = end + ((h[5] & 0x10) ? 10 : 0);   // stopka ID3v2.4
+  if (version < 2 || version > 4) return audioStart;
+
+  uint32_t pos = 10;
+  if ((h[5] & 0x40) && version >= 3) {   // nagłówek rozszerzony
+    uint8_t e[4];
+    if (f.read(e, 4) != 4) return audioStart;
+    uint32_t elen = version == 4 ? ((uint32_t)(e[0] & 0x7F) << 21) | ((e[1] & 0x7F) << 14) | ((e[2] & 0x7F) << 7) | (e[3] & 0x7F)
+                                 : be32(e) + 4;
+    if (elen < 4 || elen > end - pos) return audioStart;   // bez przepełnienia pos
+    pos += elen;
+  }
+
+  uint8_t hdrLen = version == 2 ? 6 : 10;
+  while (pos <= end && end - pos >= hdrLen) {
+    uint8_t fh[10];
+    f.seek(pos);
+    if (f.read(fh, hdrLen) != hdrLen || fh[0] == 0) break;   // dopełnienie
+
+    uint32_t fsize;
+    uint8_t flags = 0;
+    char* field = nullptr;
+    bool userText = false;   // TXXX - ReplayGain
+    if (version == 2) {
+      fsize = ((uint32_t)fh[3] << 16) | (fh[4] << 8) | fh[5];
+      if (memcmp(fh, "TT2", 3) == 0) field = out->title;
+      else if (memcmp(fh, "TP1", 3) == 0) field = out->artist;
+      else if (memcmp(fh, "TAL", 3) == 0) field = out->album;
+      else userText = memcmp(fh, "TXX", 3) == 0;
+    } else {
+      fsize = version == 4 ? ((uint32_t)(fh[4] & 0x7F) << 21) | ((fh[5] & 0x7F) << 14) | ((fh[6] & 0x7F) << 7) | (fh[7] & 0x7F)
+                           : be32(fh + 4);
+      flags = fh[9];
+      if (memcmp(fh, "TIT2", 4) == 0) field = out->title;
+      else if (memcmp(fh, "TPE1", 4) == 0) field = out->artist;
+      else if (memcmp(fh, "TALB", 4) == 0) field = out->album;
+      else userText = memcmp(fh, "TXXX", 4) == 0;
+    }
+    if (fsize == 0 || fsize > end - pos - hdrLen) break;   // rozmiar 32-bit (v2.3) - bez przepełnienia pos
+
+    // Kompresja / szyfrowanie / unsynchronizacja ramki - pomijamy
+    bool plain = version == 4 ? (flags & 0x0E) == 0 : (flags & 0xC0) == 0;
+    if (((field && !field[0]) || userText) && plain && fsize >= 2) {
+      uint32_t skip = (version == 4 && (flags & 0x01)) ? 4 : 0;   // wskaźnik długości danych
+      uint32_t n = fsize - skip;
+      if (n > 512) n = 512;
+      f.seek(pos + hdrLen + skip);
+      if (n >= 2 && f.read(g_buf, n) == n) {
+        if (field) tag_text(field, g_buf + 1, n - 1, g_buf[0]);
+        else txxx_gain(g_buf, n, out);
+      }
+    }
+    pos += hdrLen + fsize;
+  }
+  return audioStart;
+}
+
+// Pierwsza ramka MPEG: częstotliwość + czas (Xing / Info / VBRI albo CBR)
+static void read_mp3_stream(File& f, uint32_t start, uint32_t fileSize, media_info_t* out)
+{
+  f.seek(start);
+  size_t n = f.read(g_buf, TAG_BUF_SIZE);
+  for (size_t p = 0; p + 4 <= n; p++) {
+    const uint8_t* h = g_buf + p;
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) continue;
+    uint8_t version = (h[1] >> 3) & 0x03;
+    uint8_t layer = (h[1] >> 1) & 0x03;
+    uint8_t brIndex = h[2] >> 4;
+    uint8_t srIndex = (h[2] >> 2) & 0x03;
+    if (version == 1 || layer == 0 || brIndex == 0 || brIndex == 15 || srIndex == 3) continue;
+
+    bool mpeg1 = version == 3;
+    uint8_t layerIdx = 3 - layer;                  // 0 = Layer I, 2 = Layer III
+    uint32_t rate = MP3_RATES[version][srIndex];
+    uint32_t bitrate = MP3_BITRATES[mpeg1 ? 0 : 1][layerIdx][brIndex];
+    uint32_t spf = layerIdx == 0 ? 384 : (layerIdx == 1 || mpeg1) ? 1152 : 576;
+    bool mono = (h[3] >> 6) == 3;
+    out->sampleRate = rate;
+
+    uint32_t frames = 0;
+    size_t xing = p + 4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17));
+    if (xing + 12 <= n && (memcmp(g_buf + xing, "Xing", 4) == 0 || memcmp(g_buf + xing, "Info", 4) == 0)) {
+      if (be32(g_buf + xing + 4) & 0x01) frames = be32(g_buf + xing + 8);
+    } else if (p + 36 + 18 <= n && memcmp(g_buf + p + 36, "VBRI", 4) == 0) {
+      frames = be32(g_buf + p + 36 + 14);
+    }
+    if (frames) out->durationSec = (uint64_t)frames * spf / rate;
+    else if (bitrate) out->durationSec = (uint64_t)(fileSize - start - p) * 8 / (bitrate * 1000UL);
+    return;
+  }
+}
+
+static void read_flac(File& f, media_info_t* out)
+{
+  uint8_t h[4];
+  uint32_t pos = 4;
+  for (uint8_t block = 0; block < 32; block++) {
+    f.seek(pos);
+    if (f.read(h, 4) != 4) return;
+    uint8_t type = h[0] & 0x7F;
+    uint32_t len = ((uint32_t)h[1] << 16) | (h[2] << 8) | h[3];
+
+    if (type == 0 && len >= 18) {   // STREAMINFO
+      if (f.read(g_buf, 18) != 18) return;
+      uint32_t rate = ((uint32_t)g_buf[10] << 12) | (g_buf[11] << 4) | (g_buf[12] >> 4);
+      uint64_t total = ((uint64_t)(g_buf[13] & 0x0F) << 32) | be32(g_buf + 14);
+      out->sampleRate = rate;
+      if (rate) out->durationSec = total / rate;
+    } else if (type == 4) {         // VORBIS_COMMENT
+      size_t n = len < TAG_BUF_SIZE ? len : TAG_BUF_SIZE;
+      vorbis_comments(g_buf, f.read(g_buf, n), out);
+    }
+    pos += 4 + len;
+    if (h[0] & 0x80) return;        // ostatni blok metadanych
+  }
+}
+
+// OGG: pakiet 0 = nagłówek identyfikacyjny, pakiet 1 = komentarze (może zajmować kilka stron)
+static void read_ogg(File& f, uint32_t fileSize, media_info_t* out)
+{
+  uint8_t ph[27 + 255];
+  uint8_t ident[32];
+  size_t identLen = 0;
+  size_t commentLen = 0;
+  uint8_t packet = 0;
+  bool opus = false;
+  uint16_t preSkip = 0;
+  uint32_t pos = 0;
+
+  for (uint8_t page = 0; page < 32 && packet < 2; page++) {
+    f.seek(pos);
+    if (f.read(ph, 27) != 27 || memcmp(ph, "OggS", 4) != 0) break;
+    uint8_t segments = ph[26];
+    if (f.read(ph + 27, segments) != segments) break;
+
+    uint32_t data = pos + 27 + segments;
+    for (uint8_t s = 0; s < segments && packet < 2; s++) {
+      uint8_t len = ph[27 + s];
+      if (packet == 0 && identLen < sizeof(ident)) {
+        size_t n = len < sizeof(ident) - identLen ? len : sizeof(ident) - identLen;
+        f.seek(data);
+        identLen += f.read(ident + identLen, n);
+      } else if (packet == 1 && commentLen < TAG_BUF_SIZE) {
+        size_t n = len < TAG_BUF_SIZE - commentLen ? len : TAG_BUF_SIZE - commentLen;
+        f.seek(data);
+        commentLen += f.read(g_buf + commentLen, n);
+      }
+      data += len;
+      if (len < 255) packet++;   // koniec pakietu
+    }
+    pos = data;
+  }
+
+  if (identLen >= 16 && memcmp(ident, "\x01vorbis", 7) == 0) {
+    out->sampleRate = le32(ident + 12);
+    if (commentLen > 7) vorbis_comments(g_buf + 7, commentLen - 7, out);
+  } else if (identLen >= 12 && memcmp(ident, "OpusHead", 8) == 0) {
+    opus = true;
+    preSkip = ident[10] | (ident[11] << 8);
+    out->sampleRate = 48000;   // Opus dekoduje zawsze do 48 kHz
+    if (commentLen > 8) vorbis_comments(g_buf + 8, commentLen - 8, out);
+  }
+  if (!out->sampleRate) return;
+
+  // Czas: granule ostatniej strony (ostatnie "OggS" w końcówce pliku)
+  uint32_t tail = fileSize > TAG_BUF_SIZE ? fileSize - TAG_BUF_SIZE : 0;
+  f.seek(tail);
+  size_t n = f.read(g_buf, TAG_BUF_SIZE);
+  for (size_t p = n >= 14 ? n - 14 : 0; p > 0; p--) {
+    if (memcmp(g_buf + p, "OggS", 4) != 0) continue;
+    uint64_t granule = le32(g_buf + p + 6) | ((uint64_t)le32(g_buf + p + 10) << 32);
+    if (opus && granule > preSkip) granule -= preSkip;
+    out->durationSec = granule / out->sampleRate;
+    break;
+  }
+}
+
+// Atom "----" (iTunes freeform): mean / name / data - ReplayGain z foobar2000 / iTunes
+static void mp4_freeform(const uint8_t* p, size_t len, media_info_t* out)
+{
+  const uint8_t* name = nullptr;
+  const uint8_t* data = nullptr;
+  size_t nameLen = 0;
+  size_t dataLen = 0;
+  for (size_t pos = 0; pos + 8 <= len; ) {
+    uint32_t size = be32(p + pos);
+    if (size < 8 || size > len - pos) break;
+    if (memcmp(p + pos + 4, "name", 4) == 0 && size > 12) { name = p + pos + 12; nameLen = size - 12; }
+    else if (memcmp(p + pos + 4, "data", 4) == 0 && size > 16) { data = p + pos + 16; dataLen = size - 16; }
+    pos += size;
+  }
+  if (name && data) gain_tag((const char*)name, nameLen, data, dataLen, out);
+}
+
+// MP4 / M4A: moov -> mvhd (czas), trak/mdia/mdhd (częstotliwość), udta/meta/ilst (tagi)
+static void read_mp4_atoms(File& f, uint32_t start, uint32_t end, uint8_t depth, media_info_t* out, char* albumArtist)
+{
+  uint32_t pos = start;
+  while (pos + 8 <= end) {
+    uint8_t h[16];
+    f.seek(pos);
+    if (f.read(h, 8) != 8) return;
+    uint64_t size = be32(h);
+    uint32_t hdr = 8;
+    if (size == 1) {   // rozmiar 64-bit
+      if (f.read(h + 8, 8) != 8 || be32(h + 8) != 0) return;
+      size = be32(h + 12);
+      hdr = 16;
+    } else if (size == 0) {
+      size = end - pos;
+    }
+    if (size < hdr || pos + size > end) return;
+    const uint8_t* type = h + 4;
+    uint32_t body = pos + hdr;
+    uint32_t bodyEnd = pos + size;
+
+    if (depth < 6 && (memcmp(type, "moov", 4) == 0 || memcmp(type, "trak", 4) == 0 ||
+                      memcmp(type, "mdia", 4) == 0 || memcmp(type, "udta", 4) == 0 ||
+                      memcmp(type, "ilst", 4) == 0)) {
+      read_mp4_atoms(f, body, bodyEnd, depth + 1, out, albumArtist);
+    } else if (depth < 6 && memcmp(type, "meta", 4) == 0) {
+      read_mp4_atoms(f, body + 4, bodyEnd, depth + 1, out, albumArtist);   // pełny atom: wersja + flagi
+    } else if (memcmp(type, "mvhd", 4) == 0 || memcmp(type, "mdhd", 4) == 0) {
+      uint8_t b[32];
+      if (f.read(b, 32) != 32) return;
+      uint32_t scale = b[0] == 1 ? be32(b + 20) : be32(b + 12);
+      uint64_t dur = b[0] == 1 ? ((uint64_t)be32(b + 24) << 32) | be32(b + 28) : be32(b + 16);
+      if (type[1] == 'v' && scale && !out->durationSec) out->durationSec = dur / scale;
+      if (type[1] == 'd' && !out->sampleRate && scale >= 8000 && scale <= 192000) out->sampleRate = scale;
+    } else if (depth > 0 && memcmp(type, "----", 4) == 0) {
+      uint32_t n = bodyEnd - body;
+      if (n > 256) n = 256;
+      if (f.read(g_buf, n) == n) mp4_freeform(g_buf, n, out);
+    } else if (depth > 0 && (type[0] == 0xA9 || memcmp(type, "aART", 4) == 0)) {
+      char* field = nullptr;
+      if (memcmp(type + 1, "nam", 3) == 0 && type[0] == 0xA9) field = out->title;
+      else if (memcmp(type + 1, "ART", 3) == 0 && type[0] == 0xA9) field = out->artist;
+      else if (memcmp(type + 1, "alb", 3) == 0 && type[0] == 0xA9) field = out->album;
+      else if (type[0] == 'a') field = albumArtist;
+      // Atom "data": rozmiar, "data", typ, locale, tekst UTF-8
+      if (field && bodyEnd - body > 16) {
+        uint32_t n = bodyEnd - body;
+        if (n > 16 + 256) n = 16 + 256;
+        if (f.read(g_buf, n) == n && memcmp(g_buf + 4, "data", 4) == 0) {
+          uint32_t dlen = be32(g_buf);
+          if (dlen > n) dlen = n;
+          if (dlen > 16) tag_text(field, g_buf + 16, dlen - 16, 3);
+        }
+      }
+    }
+    pos = bodyEnd;
+  }
+}
+
+static void read_wav(File& f, uint32_t fileSize, media_info_t* out)
+{
+  uint8_t h[12];
+  uint32_t pos = 12;
+  uint32_t byteRate = 0;
+  uint32_t dataLen = 0;
+  for (uint8_t chunk = 0; chunk < 32 && pos + 8 <= fileSize; chunk++) {
+    f.seek(pos);
+    if (f.read(h, 8) != 8) break;
+    uint32_t len = le32(h + 4);
+    if (memcmp(h, "fmt ", 4) == 0 && len >= 16) {
+      uint8_t fmt[16];
+      if (f.read(fmt, 16) != 16) break;
+      out->sampleRate = le32(fmt + 4);
+      byteRate = le32(fmt + 8);
+    } else if (memcmp(h, "data", 4) == 0) {
+      dataLen = len;
+    } else if (memcmp(h, "LIST", 4) == 0 && len > 4) {
+      size_t n = len < TAG_BUF_SIZE ? len : TAG_BUF_SIZE;
+      n = f.read(g_buf, n);
+      if (n > 4 && memcmp(g_buf, "INFO", 4) == 0) {
+        for (size_t p = 4; p + 8 <= n; ) {
+          uint32_t slen = le32(g_buf + p + 4);
+          if (slen > n - p - 8) break;   // bez przepełnienia p + 8 + slen
+          char* field = nullptr;
+          if (memcmp(g_buf + p, "INAM", 4) == 0) field = out->title;
+          else if (memcmp(g_buf + p, "IART", 4) == 0) field = out->artist;
+          else if (memcmp(g_buf + p, "IPRD", 4) == 0) field = out->album;
+          if (field) tag_text(field, g_buf + p + 8, slen, 3);
+          p += 8 + slen + (slen & 1);
+        }
+      }
+    }
+    uint64_t next = (uint64_t)pos + 8 + len + (len & 1);   // zawsze do przodu, bez zawinięcia 32 bit
+    if (next > fileSize) break;
+    pos = (uint32_t)next;
+  }
+  if (byteRate && dataLen) out->durationSec = dataLen / byteRate;
+}
+
+static void read_adts(File& f, uint32_t start, media_info_t* out)
+{
+  uint8_t h[7];
+  f.seek(start);
+  if (f.read(h, 7) != 7 || h[0] != 0xFF || (h[1] & 0xF6) != 0xF0) return;
+  uint8_t srIndex = (h[2] >> 2) & 0x0F;
+  if (srIndex < 13) out->sampleRate = ADTS_RATES[srIndex];
+}
+
+// Tagi jednego pliku - tylko nagłówki, bez dekodowania
+static bool read_tags(const char* path, uint8_t format, media_info_t* out)
+{
+  memset(out, 0, sizeof(media_info_t));
+  out->format = format;
+  out->trackGain = out->albumGain = MEDIA_GAIN_NONE;
+  File f = SD.open(path, FILE_READ);
+  if (!f) return false;
+  uint32_t size = f.size();
+
+  switch (format) {
+    case DIR_TYPE_MP3: {
+      uint32_t start = read_id3v2(f, out);
+      read_mp3_stream(f, start, size, out);
+      break;
+    }
+    case DIR_TYPE_AAC:
+      read_adts(f, read_id3v2(f, out), out);
+      break;
+    case DIR_TYPE_FLAC: {
+      uint8_t magic[4];
+      if (f.read(magic, 4) == 4 && memcmp(magic, "fLaC", 4) == 0) read_flac(f, out);
+      break;
+    }
+    case DIR_TYPE_OGG:
+      read_ogg(f, size, out);
+      break;
+    case DIR_TYPE_M4A: {
+      char albumArtist[MEDIA_TAG_LENGTH + 1] = "";
+      read_mp4_atoms(f, 0, size, 0, out, albumArtist);
+      if (!out->artist[0]) strcpy(out->artist, albumArtist);
+      break;
+    }
+    case DIR_TYPE_WAV: {
+      uint8_t riff[12];
+      if (f.read(riff, 12) == 12 && memcmp(riff, "RIFF", 4) == 0 && memcmp(riff + 8, "WAVE", 4) == 0) read_wav(f, size, out);
+      break;
+    }
+  }
+  f.close();
+  return true;
+}
+
+// ======================= PRZEBIEG INDEKSERA =======================
+
+// Stos katalogów do odwiedzenia: ścieżki rozdzielone '\0'
+typedef struct {
+  char*    buf;
+  uint32_t used;
+  uint32_t size;
+} dir_stack_t;
+
+static bool stack_push(dir_stack_t* st, const char* path)
+{
+  size_t len = strlen(path) + 1;
+  if (st->used + len > st->size) {
+    uint32_t size = st->size ? st->size * 2 : 4096;
+    while (st->used + len > size) size *= 2;
+    char* b = (char*)lib_realloc(st->buf, size);
+    if (!b) return false;
+    st->buf = b;
+    st->size = size;
+  }
+  memcpy(st->buf + st->used, path, len);
+  st->used += len;
+  return true;
+}
+
+static bool stack_pop(dir_stack_t* st, char* out, size_t outSize)
+{
+  if (st->used == 0) return false;
+  uint32_t start = st->used - 1;   // '\0' ostatniej ścieżki
+  while (start > 0 && st->buf[start - 1] != '\0') start--;
+  strncpy(out, st->buf + start, outSize - 1);
+  out[outSize - 1] = '\0';
+  st->used = start;
+  return true;
+}
+
+// Katalog z poprzedniej bazy (tylko zadanie indeksera zmienia g_db - odczyt bez blokady)
+static const lib_dir_t* old_dir(const char* path)
+{
+  for (uint32_t i = 0; i < g_db.dirCount; i++) {
+    if (strcmp(g_db.arena + g_db.dirs[i].pathOff, path) == 0) return &g_db.dirs[i];
+  }
+  return nullptr;
+}
+
+// Tekst rekordu: ten sam co w poprzednim rekordzie (katalog = zwykle jeden album) bez kopii
+static uint32_t build_text(const char* text, uint32_t prevOff)
+{
+  if (g_build.count > 1 && strcmp(g_build.arena + prevOff, text) == 0) return prevOff;
+  return db_add_text(&g_build, text);
+}
+
+static bool build_record(uint16_t dirNo, const char* path, const media_info_t* info)
+{
+  lib_record_t* prev = g_build.count ? &g_build.records[g_build.count - 1] : nullptr;
+  uint32_t prevArtist = prev ? prev->artistOff : 0;
+  uint32_t prevAlbum = prev ? prev->albumOff : 0;
+
+  lib_record_t* r = db_add_record(&g_build);
+  if (!r) return false;
+  r->pathHash = path_hash(path);
+  r->pathOff = db_add_text(&g_build, path);
+  r->titleOff = db_add_text(&g_build, info->title);
+  r->artistOff = build_text(info->artist, prevArtist);
+  r->albumOff = build_text(info->album, prevAlbum);
+  r->durationSec = info->durationSec;
+  r->sampleRate = info->sampleRate;
+  r->dir = dirNo;
+  r->format = info->format;
+  r->trackGain = info->trackGain;
+  r->albumGain = info->albumGain;
+  r->trackPeak = info->trackPeak;
+  r->albumPeak = info->albumPeak;
+  if (r->pathOff == UINT32_MAX || r->titleOff == UINT32_MAX || r->artistOff == UINT32_MAX || r->albumOff == UINT32_MAX) {
+    g_build.count--;
+    return false;
+  }
+  return true;
+}
+
+static void record_info(const lib_db_t* db, const lib_record_t* r, media_info_t* out)
+{
+  strncpy(out->title, db->arena + r->titleOff, MEDIA_TAG_LENGTH);
+  strncpy(out->artist, db->arena + r->artistOff, MEDIA_TAG_LENGTH);
+  strncpy(out->album, db->arena + r->albumOff, MEDIA_TAG_LENGTH);
+  out->title[MEDIA_TAG_LENGTH] = out->artist[MEDIA_TAG_LENGTH] = out->album[MEDIA_TAG_LENGTH] = '\0';
+  out->durationSec = r->durationSec;
+  out->sampleRate = r->sampleRate;
+  out->format = r->format;
+  out->trackGain = r->trackGain;
+  out->albumGain = r->albumGain;
+  out->trackPeak = r->trackPeak;
+  out->albumPeak = r->albumPeak;
+}
+
+// Jeden katalog: podpis z nazw wpisów, podkatalogi na stos, pliki audio - przejęte albo czytane
+static bool scan_dir(const char* path, uint8_t depth, dir_stack_t* stack, dir_stack_t* names,
+                     uint32_t* readMs, bool* changed)
+{
+  File dir = SD.open(path);
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return true;
+  }
+
+  time_t mtime = dir.getLastWrite();
+  uint32_t signature = fnv_update(2166136261UL, &mtime, sizeof(mtime));
+  char child[DIR_PATH_LENGTH + DIR_NAME_LENGTH + 2];
+  names->used = 0;
+  uint32_t files = 0;
+
+  bool isDir = false;
+  String full = dir.getNextFileName(&isDir);
+  while (full.length() > 0) {
+    const char* name = full.c_str();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+
+    if (name[0] != '.') {
+      signature = fnv_update(signature, name, strlen(name) + 1);
+      snprintf(child, sizeof(child), "%s/%s", strcmp(path, "/") == 0 ? "" : path, name);
+      if (isDir) {
+        // Bez katalogów systemowych i fragmentów zegara głosowego
+        if (depth < MEDIA_LIB_MAX_DEPTH && strcmp(name, "System Volume Information") != 0 &&
+            strcmp(child, "/voice") != 0 && strlen(child) <= DIR_PATH_LENGTH) {
+          stack_push(stack, child);
+        }
+      } else if (dir_index_audio_type(name)) {
+        stack_push(names, name);
+        files++;
+      }
+    }
+    full = dir.getNextFileName(&isDir);
+  }
+  dir.close();
+  if (files == 0) return true;
+
+  lib_dir_t* d = db_add_dir(&g_build);
+  if (!d) return false;
+  uint16_t dirNo = g_build.dirCount - 1;
+  d->pathOff = db_add_text(&g_build, path);
+  d->signature = signature;
+  d->firstRecord = g_build.count;
+
+  const lib_dir_t* old = old_dir(path);
+  if (old && old->signature == signature) {
+    // Bez zmian - rekordy z poprzedniej bazy, bez otwierania plików
+    media_info_t info;
+    for (uint32_t i = 0; i < old->recordCount; i++) {
+      const lib_record_t* r = &g_db.records[old->firstRecord + i];
+      record_info(&g_db, r, &info);
+      if (!build_record(dirNo, g_db.arena + r->pathOff, &info)) return false;
+    }
+    g_status.passDirsSkipped++;
+  } else {
+    *changed = true;
+    media_info_t info;
+    uint32_t pos = 0;
+    while (pos < names->used) {
+      const char* name = names->buf + pos;
+      pos += strlen(name) + 1;
+      snprintf(child, sizeof(child), "%s/%s", strcmp(path, "/") == 0 ? "" : path, name);
+
+      uint32_t t0 = millis();
+      read_tags(child, dir_index_audio_type(name), &info);
+      *readMs += millis() - t0;
+      if (!build_record(dirNo, child, &info)) return false;
+      g_status.passFiles++;
+      g_status.filesPerSec10 = *readMs ? g_status.passFiles * 10000UL / *readMs : 0;
+
+      // Odczyt dekodera z karty ma pierwszeństwo
+      bool busy = player_state_playing();
+      g_status.throttled = busy;
+      vTaskDelay(pdMS_TO_TICKS(busy ? MEDIA_LIB_BUSY_DELAY_MS : MEDIA_LIB_IDLE_DELAY_MS));
+    }
+  }
+  d = &g_build.dirs[dirNo];   // realloc w trakcie
+  d->recordCount = g_build.count - d->firstRecord;
+  return true;
+}
+
+static void lib_pass(void)
+{
+  uint32_t t0 = millis();
+  uint32_t readMs = 0;
+  bool changed = false;
+  bool ok = true;
+
+  db_free(&g_build);
+  db_add_text(&g_build, "");   // offset 0 = pusty tekst
+  g_status.state = MEDIA_LIB_SCANNING;
+  g_status.passFiles = 0;
+  g_status.passDirsSkipped = 0;
+
+  dir_stack_t stack = { nullptr, 0, 0 };
+  dir_stack_t names = { nullptr, 0, 0 };
+  char path[DIR_PATH_LENGTH + 1];
+  stack_push(&stack, "/");
+  while (ok && stack_pop(&stack, path, sizeof(path))) {
+    uint8_t depth = 0;
+    for (const char* p = path + 1; *p; p++) if (*p == '/') depth++;
+    ok = scan_dir(path, depth + (path[1] ? 1 : 0), &stack, &names, &readMs, &changed);
+    vTaskDelay(1);
+  }
+  if (stack.buf) free(stack.buf);
+  if (names.buf) free(names.buf);
+
+  if (!ok) {
+    Serial.println("debug medialib -> Brak pamięci / limit bazy - przebieg przerwany");
+    db_free(&g_build);
+    g_status.state = MEDIA_LIB_ERROR;
+    return;
+  }
+  if (g_build.dirCount != g_db.dirCount || g_build.count != g_db.count) changed = true;
+
+  if (changed) {
+    if (!db_build_indexes(&g_build)) {
+      db_free(&g_build);
+      g_status.state = MEDIA_LIB_ERROR;
+      return;
+    }
+    lib_db_t old;
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    old = g_db;
+    g_db = g_build;
+    xSemaphoreGive(g_lock);
+    memset(&g_build, 0, sizeof(lib_db_t));
+    db_free(&old);
+
+    g_status.state = MEDIA_LIB_SAVING;
+    if (!db_save(&g_db)) Serial.println("debug medialib -> Błąd zapisu bazy na kartę");
+  } else {
+    db_free(&g_build);
+  }
+
+  uint32_t tagged = 0;
+  for (uint32_t i = 0; i < g_db.count; i++) if (g_db.records[i].titleOff) tagged++;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_status.records = g_db.count;
+  g_status.dirs = g_db.dirCount;
+  g_status.tagged = tagged;
+  g_status.dbBytes = sizeof(db_header_t) + g_db.dirCount * sizeof(lib_dir_t) + g_db.count * sizeof(lib_record_t) + g_db.arenaUsed;
+  g_status.lastPassMs = millis() - t0;
+  g_status.passes++;
+  g_status.throttled = false;
+  g_status.state = MEDIA_LIB_IDLE;
+  xSemaphoreGive(g_lock);
+  Serial.printf("debug medialib -> Przebieg: %u utworów, %u plików czytanych, %u katalogów bez zmian, %u ms, %u.%u plików/s\n",
+                (unsigned)g_db.count, (unsigned)g_status.passFiles, (unsigned)g_status.passDirsSkipped,
+                (unsigned)g_status.lastPassMs, (unsigned)(g_status.filesPerSec10 / 10), (unsigned)(g_status.filesPerSec10 % 10));
+}
+
+static void lib_task(void* arg)
+{
+  vTaskDelay(pdMS_TO_TICKS(MEDIA_LIB_START_DELAY_MS));
+  for (;;) {
+    lib_pass();
+
+    // Następny przebieg: co MEDIA_LIB_RESCAN_MS albo po zmianie plików (z odczekaniem na serię wgrań)
+    uint32_t passEnd = millis();
+    while (millis() - passEnd < MEDIA_LIB_RESCAN_MS) {
+      if (g_rescan && millis() - g_rescanAt > RESCAN_SETTLE_MS) break;
+      vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+    g_rescan = false;
+  }
+}
+
+// ======================= API =======================
+
+void media_lib_init(void)
+{
+  if (g_lock) return;
+  g_lock = xSemaphoreCreateMutex();
+  g_buf = (uint8_t*)lib_realloc(nullptr, TAG_BUF_SIZE);
+  if (!g_lock || !g_buf) {
+    g_status.state = MEDIA_LIB_ERROR;
+    return;
+  }
+
+  uint32_t t0 = millis();
+  if (db_load(&g_db)) {
+    g_status.records = g_db.count;
+    g_status.dirs = g_db.dirCount;
+    g_status.dbBytes = sizeof(db_header_t) + g_db.dirCount * sizeof(lib_dir_t) + g_db.count * sizeof(lib_record_t) + g_db.arenaUsed;
+    Serial.printf("debug medialib -> Baza: %u utworów, %u katalogów, wczytana w %u ms\n",
+                  (unsigned)g_db.count, (unsigned)g_db.dirCount, (unsigned)(millis() - t0));
+  }
+
+  cover_load();
+  g_status.covers = g_coverCount;
+  seek_load();
+  g_status.seekTables = g_seekCount;
+
+  if (xTaskCreatePinnedToCore(lib_task, "MediaLib", 8192, NULL, 1, NULL, 0) != pdPASS) {
+    Serial.println("debug medialib -> Nie można uruchomić zadania indeksera");
+    g_status.state = MEDIA_LIB_ERROR;
+  }
+}
+
+void media_lib_request_rescan(void)
+{
+  g_rescanAt = millis();
+  g_rescan = true;
+}
+
+bool media_lib_lookup(const char* path, media_info_t* out)
+{
+  if (!g_lock || !path || !out) return false;
+  uint32_t hash = path_hash(path);
+  bool found = false;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint32_t lo = 0;
+  uint32_t hi = g_db.count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (g_db.records[g_db.byHash[mid]].pathHash < hash) lo = mid + 1;
+    else hi = mid;
+  }
+  for (; lo < g_db.count && g_db.records[g_db.byHash[lo]].pathHash == hash; lo++) {
+    const lib_record_t* r = &g_db.records[g_db.byHash[lo]];
+    if (strcmp(g_db.arena + r->pathOff, path) == 0) {
+      record_info(&g_db, r, out);
+      found = true;
+      break;
+    }
+  }
+  xSemaphoreGive(g_lock);
+  return found;
+}
+
+uint32_t media_lib_path_hash(const char* path)
+{
+  return path ? path_hash(path) : 0;
+}
+
+bool media_lib_path_by_hash(uint32_t hash, char* out, size_t outSize)
+{
+  if (!g_lock || !out || outSize == 0) return false;
+  bool found = false;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint32_t lo = 0;
+  uint32_t hi = g_db.count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (g_db.records[g_db.byHash[mid]].pathHash < hash) lo = mid + 1;
+    else hi = mid;
+  }
+  bool unique = lo < g_db.count && g_db.records[g_db.byHash[lo]].pathHash == hash &&
+                (lo + 1 >= g_db.count || g_db.records[g_db.byHash[lo + 1]].pathHash != hash);
+  if (unique) {
+    strncpy(out, g_db.arena + g_db.records[g_db.byHash[lo]].pathOff, outSize - 1);
+    out[outSize - 1] = '\0';
+    found = true;
+  }
+  xSemaphoreGive(g_lock);
+  return found;
+}
+
+bool media_lib_record_at(uint32_t index, char* path, size_t pathSize, media_info_t* info)
+{
+  if (!g_lock) return false;
+  bool found = false;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (index < g_db.count) {
+    const lib_record_t* r = &g_db.records[index];
+    if (path && pathSize) {
+      strncpy(path, g_db.arena + r->pathOff, pathSize - 1);
+      path[pathSize - 1] = '\0';
+    }
+    if (info) record_info(&g_db, r, info);
+    found = true;
+  }
+  xSemaphoreGive(g_lock);
+  return found;
+}
+
+uint32_t media_lib_cover_key(const char* path)
+{
+  if (!path) return 0;
+  // Katalog pliku + album: utwory jednego albumu dzielą okładkę, różne albumy w jednym katalogu nie
+  const char* slash = strrchr(path, '/');
+  size_t dirLen = slash ? (size_t)(slash - path) : 0;
+  uint32_t h = fnv_update(2166136261UL, path, dirLen);
+  media_info_t info;
+  if (media_lib_lookup(path, &info) && info.album[0]) {
+    h = fnv_update(h, "\x1f", 1);
+    h = fnv_update(h, info.album, strlen(info.album));
+  }
+  return h ? h : 1;
+}
+
+bool media_lib_cover_get(uint32_t key, uint8_t* bitmap)
+{
+  if (!g_lock || !g_coverKeys || !bitmap) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int32_t n = cover_find(key);
+  xSemaphoreGive(g_lock);
+  if (n < 0) return false;
+
+  File f = SD.open(MEDIA_LIB_COVER_FILE, FILE_READ);
+  if (!f) return false;
+  bool ok = f.seek(COVER_HEADER + n * COVER_RECORD + 4) && f.read(bitmap, MEDIA_COVER_BYTES) == MEDIA_COVER_BYTES;
+  f.close();
+  return ok;
+}
+
+bool media_lib_cover_put(uint32_t key, const uint8_t* bitmap)
+{
+  if (!g_lock || !g_coverKeys || !bitmap) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  bool known = cover_find(key) >= 0;
+  bool full = g_coverCount >= MEDIA_LIB_MAX_COVERS;
+  xSemaphoreGive(g_lock);
+  if (known) return true;
+  if (full) return false;
+
+  sdio_begin(SDIO_CLASS_COVER, MEDIA_LIB_IO_MAX_WAIT_MS);
+  bool fresh = !SD.exists(MEDIA_LIB_COVER_FILE);
+  File f = SD.open(MEDIA_LIB_COVER_FILE, fresh ? FILE_WRITE : FILE_APPEND);
+  if (!f) {
+    sdio_end(SDIO_CLASS_COVER, 0);
+    return false;
+  }
+  bool ok = true;
+  if (fresh) {
+    uint8_t h[COVER_HEADER];
+    memcpy(h, COVER_MAGIC, 4);
+    h[4] = COVER_VERSION & 0xFF; h[5] = COVER_VERSION >> 8;
+    h[6] = MEDIA_COVER_SIZE;     h[7] = 0;
+    ok = f.write(h, sizeof(h)) == sizeof(h);
+  }
+  ok = ok && f.write((const uint8_t*)&key, 4) == 4 && f.write(bitmap, MEDIA_COVER_BYTES) == MEDIA_COVER_BYTES;
+  f.close();
+  sdio_end(SDIO_CLASS_COVER, ok ? COVER_RECORD : 0);
+  if (!ok) return false;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_coverKeys[g_coverCount++] = key;
+  g_status.covers = g_coverCount;
+  xSemaphoreGive(g_lock);
+  return true;
+}
+
+bool media_lib_seek_get(uint32_t key, void* table)
+{
+  if (!g_lock || !g_seekKeys || !table) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int32_t n = seek_find(key);
+  xSemaphoreGive(g_lock);
+  if (n < 0) return false;
+
+  File f = SD.open(MEDIA_LIB_SEEK_FILE, FILE_READ);
+  if (!f) return false;
+  bool ok = f.seek(SEEK_HEADER + n * SEEK_RECORD + 4) && f.read((uint8_t*)table, MEDIA_SEEK_BYTES) == MEDIA_SEEK_BYTES;
+  f.close();
+  return ok;
+}
+
+bool media_lib_seek_put(uint32_t key, const void* table)
+{
+  if (!g_lock || !g_seekKeys || !table) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  bool full = g_seekCount >= MEDIA_LIB_MAX_SEEK;
+  xSemaphoreGive(g_lock);
+  if (full) return false;
+
+  sdio_begin(SDIO_CLASS_SEEK, MEDIA_LIB_IO_MAX_WAIT_MS);
+  bool fresh = !SD.exists(MEDIA_LIB_SEEK_FILE);
+  File f = SD.open(MEDIA_LIB_SEEK_FILE, fresh ? FILE_WRITE : FILE_APPEND);
+  if (!f) {
+    sdio_end(SDIO_CLASS_SEEK, 0);
+    return false;
+  }
+  bool ok = true;
+  if (fresh) {
+    uint8_t h[SEEK_HEADER];
+    memcpy(h, SEEK_MAGIC, 4);
+    h[4] = SEEK_VERSION & 0xFF;     h[5] = SEEK_VERSION >> 8;
+    h[6] = MEDIA_SEEK_BYTES & 0xFF; h[7] = MEDIA_SEEK_BYTES >> 8;
+    ok = f.write(h, sizeof(h)) == sizeof(h);
+  }
+  ok = ok && f.write((const uint8_t*)&key, 4) == 4 && f.write((const uint8_t*)table, MEDIA_SEEK_BYTES) == MEDIA_SEEK_BYTES;
+  f.close();
+  sdio_end(SDIO_CLASS_SEEK, ok ? SEEK_RECORD : 0);
+  if (!ok) return false;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_seekKeys[g_seekCount++] = key;
+  g_status.seekTables = g_seekCount;
+  xSemaphoreGive(g_lock);
+  return true;
+}
+
+// Zakres byArtist pasujący do wykonawcy (i albumu, gdy podany)
+static void artist_range(const char* artist, const char* album, uint32_t* first, uint32_t* last)
+{
+  *first = *last = 0;
+  uint32_t i = 0;
+  while (i < g_db.count && strcasecmp(g_db.arena + g_db.records[g_db.byArtist[i]].artistOff, artist) != 0) i++;
+  if (album) {
+    while (i < g_db.count && strcasecmp(g_db.arena + g_db.records[g_db.byArtist[i]].artistOff, artist) == 0 &&
+           strcasecmp(g_db.arena + g_db.records[g_db.byArtist[i]].albumOff, album) != 0) i++;
+  }
+  *first = i;
+  while (i < g_db.count && strcasecmp(g_db.arena + g_db.records[g_db.byArtist[i]].artistOff, artist) == 0 &&
+         (!album || strcasecmp(g_db.arena + g_db.records[g_db.byArtist[i]].albumOff, album) == 0)) i++;
+  *last = i;
+}
+
+// Grupy kolejnych rekordów o tym samym tekście (wykonawca albo album) w zakresie byArtist
+static uint16_t list_groups(uint32_t first, uint32_t last, bool albums, uint16_t offset, uint16_t max,
+                            uint16_t* total, media_lib_name_cb cb, void* ctx)
+{
+  uint16_t groups = 0;
+  uint16_t listed = 0;
+  uint32_t i = first;
+  while (i < last) {
+    const lib_record_t* r = &g_db.records[g_db.byArtist[i]];
+    uint32_t off = albums ? r->albumOff : r->artistOff;
+    uint32_t j = i + 1;
+    while (j < last) {
+      const lib_record_t* n = &g_db.records[g_db.byArtist[j]];
+      if (strcasecmp(g_db.arena + (albums ? n->albumOff : n->artistOff), g_db.arena + off) != 0) break;
+      j++;
+    }
+    if (groups >= offset && listed < max) {
+      if (cb) cb(g_db.arena + off, j - i, ctx);
+      listed++;
+    }
+    groups++;
+    i = j;
+  }
+  if (total) *total = groups;
+  return listed;
+}
+
+uint16_t media_lib_artists(uint16_t offset, uint16_t max, uint16_t* total, media_lib_name_cb cb, void* ctx)
+{
+  if (total) *total = 0;
+  if (!g_lock) return 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint16_t n = list_groups(0, g_db.count, false, offset, max, total, cb, ctx);
+  xSemaphoreGive(g_lock);
+  return n;
+}
+
+uint16_t media_lib_albums(const char* artist, uint16_t offset, uint16_t max, uint16_t* total, media_lib_name_cb cb, void* ctx)
+{
+  if (total) *total = 0;
+  if (!g_lock || !artist) return 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint32_t first, last;
+  artist_range(artist, nullptr, &first, &last);
+  uint16_t n = list_groups(first, last, true, offset, max, total, cb, ctx);
+  xSemaphoreGive(g_lock);
+  return n;
+}
+
+uint16_t media_lib_tracks(const char* artist, const char* album, uint16_t offset, uint16_t max, uint16_t* total,
+                          media_lib_track_cb cb, void* ctx)
+{
+  if (total) *total = 0;
+  if (!g_lock || !artist) return 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint32_t first, last;
+  artist_range(artist, album, &first, &last);
+  uint16_t listed = 0;
+  media_info_t info;
+  for (uint32_t i = first + offset; i < last && listed < max; i++) {
+    const lib_record_t* r = &g_db.records[g_db.byArtist[i]];
+    record_info(&g_db, r, &info);
+    if (cb) cb(g_db.arena + r->pathOff, &info, ctx);
+    listed++;
+  }
+  if (total) *total = last - first;
+  xSemaphoreGive(g_lock);
+  return listed;
+}
+
+void media_lib_get_status(media_lib_status_t* out)
+{
+  if (!out) return;
+  if (!g_lock) {
+    *out = g_status;
+    return;
+  }
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  *out = g_status;
+  xSemaphoreGive(g_lock);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// MEDIA LIBRARY - biblioteka utworów karty SD (tagi bez dekodowania)
+// ========================================================================
+// Zadanie w tle o niskim priorytecie przechodzi kartę katalog po katalogu
+// i czyta z nagłówków plików: tytuł, wykonawcę, album, czas trwania
+// i częstotliwość próbkowania:
+//   - MP3  : ID3v2.2/2.3/2.4 (TIT2/TPE1/TALB, TXXX), czas z Xing/Info/VBRI albo CBR
+//   - FLAC : STREAMINFO + VORBIS_COMMENT
+//   - OGG  : Vorbis / Opus - nagłówek identyfikacyjny + komentarze,
+//            czas z pozycji granule ostatniej strony
+//   - M4A  : mvhd / mdhd + ilst (©nam / ©ART / ©alb, ----:REPLAYGAIN_*)
+//   - WAV  : fmt + data + LIST/INFO
+//   - AAC  : nagłówek ADTS (tylko częstotliwość)
+// ReplayGain: REPLAYGAIN_TRACK/ALBUM_GAIN/PEAK (TXXX, komentarze Vorbis,
+// atomy ----) oraz R128_TRACK/ALBUM_GAIN Opus (Q7.8 dB względem -23 LUFS,
+// przeliczone na poziom odniesienia ReplayGain -18 LUFS).
+// Przyrostowo: podpis katalogu = czas modyfikacji katalogu + skrót nazw
+// wpisów. Katalog z niezmienionym podpisem przejmuje rekordy z poprzedniej
+// bazy bez otwierania plików (zmiana zawartości pliku pod tą samą nazwą
+// nie jest wykrywana).
+//
+// Baza w MEDIA_LIB_DB_FILE (binarnie: nagłówek, katalogi, rekordy, arena
+// tekstów), wczytywana przy starcie do PSRAM. W czasie odtwarzania z karty
+// indekser czeka MEDIA_LIB_BUSY_DELAY_MS między plikami - odczyt dekodera
+// ma pierwszeństwo.
+//
+// Okładki albumów (dekodowane przez CoverArt) w MEDIA_LIB_COVER_FILE:
+// bitmapa 1bpp MEDIA_COVER_SIZE x MEDIA_COVER_SIZE (XBM, 512 B) na album,
+// klucz = katalog pliku + album z tagów. Plik tylko dopisywany, klucze
+// w PSRAM - album dekodowany raz, kolejne odtworzenia czytają 512 B.
+//
+// Tablice przewijania (budowane przez SeekIndex przy pierwszym odtworzeniu)
+// w MEDIA_LIB_SEEK_FILE: rekord MEDIA_SEEK_BYTES na plik, klucz = skrót
+// ścieżki. Plik tylko dopisywany - nowszy rekord tego samego klucza
+// (plik zmieniony pod tą samą nazwą) zastępuje starszy.
+// ========================================================================
+
+static const char     MEDIA_LIB_DB_FILE[]       = "/.medialib.db";
+static const uint16_t MEDIA_LIB_MAX_RECORDS     = 20000;
+static const uint16_t MEDIA_LIB_MAX_DIRS        = 2000;
+static const uint8_t  MEDIA_LIB_MAX_DEPTH       = 8;
+static const uint8_t  MEDIA_TAG_LENGTH          = 63;      // tytuł / wykonawca / album (bajty UTF-8)
+static const uint32_t MEDIA_LIB_START_DELAY_MS  = 30000;   // pierwszy przebieg po starcie radia
+static const uint32_t MEDIA_LIB_RESCAN_MS       = 30UL * 60UL * 1000UL;
+static const uint16_t MEDIA_LIB_IDLE_DELAY_MS   = 2;       // przerwa między plikami - karta wolna
+static const uint16_t MEDIA_LIB_BUSY_DELAY_MS   = 150;     // przerwa między plikami - odtwarzanie z karty
+static const uint32_t MEDIA_LIB_IO_MAX_WAIT_MS  = 2000;    // zapis bazy / okładki / tablicy - czekanie na przerwę w odtwarzaniu
+static const char     MEDIA_LIB_COVER_FILE[]    = "/.medialib.cov";
+static const uint16_t MEDIA_LIB_MAX_COVERS      = 2048;
+static const uint8_t  MEDIA_COVER_SIZE          = 64;      // [px] bok okładki
+static const uint16_t MEDIA_COVER_BYTES         = MEDIA_COVER_SIZE * MEDIA_COVER_SIZE / 8;
+static const int16_t  MEDIA_GAIN_NONE           = INT16_MIN;   // brak tagu ReplayGain
+static const char     MEDIA_LIB_SEEK_FILE[]     = "/.medialib.seek";
+static const uint16_t MEDIA_LIB_MAX_SEEK        = 1024;
+static const uint16_t MEDIA_SEEK_BYTES          = 2072;    // rekord tablicy przewijania (seek_table_t)
+
+typedef enum {
+  MEDIA_LIB_IDLE = 0,
+  MEDIA_LIB_SCANNING,
+  MEDIA_LIB_SAVING,
+  MEDIA_LIB_ERROR
+} media_lib_state_t;
+
+typedef struct {
+  char     title[MEDIA_TAG_LENGTH + 1];
+  char     artist[MEDIA_TAG_LENGTH + 1];
+  char     album[MEDIA_TAG_LENGTH + 1];
+  uint32_t durationSec;            // 0 = nieznany
+  uint32_t sampleRate;             // 0 = nieznana
+  uint8_t  format;                 // dir_type_t (DirIndex.h)
+  int16_t  trackGain;              // [0.01 dB] ReplayGain, MEDIA_GAIN_NONE = brak
+  int16_t  albumGain;
+  uint16_t trackPeak;              // szczyt próbki Q15 (32768 = pełna skala), 0 = nieznany
+  uint16_t albumPeak;
+} media_info_t;
+
+typedef struct {
+  media_lib_state_t state;
+  uint32_t records;                // utwory w bazie
+  uint32_t dirs;
+  uint32_t passes;                 // zakończone przebiegi
+  uint32_t passFiles;              // pliki przeczytane w bieżącym / ostatnim przebiegu
+  uint32_t passDirsSkipped;        // katalogi bez zmian (rekordy przejęte)
+  uint32_t lastPassMs;
+  uint32_t filesPerSec10;          // tempo indeksowania x10 (tylko czytane pliki)
+  uint32_t tagged;                 // rekordy z tytułem z tagów
+  uint32_t dbBytes;                // rozmiar pliku bazy
+  uint32_t covers;                 // okładki w MEDIA_LIB_COVER_FILE
+  uint32_t seekTables;             // rekordy w MEDIA_LIB_SEEK_FILE
+  bool     throttled;              // indekser ustępuje odtwarzaniu
+} media_lib_status_t;
+
+// Init - po uruchomieniu karty SD: wczytanie bazy i start zadania w tle
+void     media_lib_init(void);
+void     media_lib_request_rescan(void);     // np. po wgraniu / usunięciu pliku
+
+// Informacje o pliku (pełna ścieżka), false = brak w bazie
+bool     media_lib_lookup(const char* path, media_info_t* out);
+
+// Klucz utworu = skrót ścieżki (stały między przebiegami, w przeciwieństwie do numeru rekordu).
+// Playlisty trzymają klucze zamiast ścieżek; ścieżka z klucza, false = brak w bazie
+// albo klucz wspólny dla kilku ścieżek (kolizja - ścieżkę trzyma wywołujący)
+uint32_t media_lib_path_hash(const char* path);
+bool     media_lib_path_by_hash(uint32_t hash, char* out, size_t outSize);
+
+// Rekord wg numeru (przegląd całej bazy w tle), false = poza zakresem
+bool     media_lib_record_at(uint32_t index, char* path, size_t pathSize, media_info_t* info);
+
+// Okładka albumu: klucz dla pliku, odczyt / zapis bitmapy (MEDIA_COVER_BYTES), false = brak
+uint32_t media_lib_cover_key(const char* path);
+bool     media_lib_cover_get(uint32_t key, uint8_t* bitmap);
+bool     media_lib_cover_put(uint32_t key, const uint8_t* bitmap);
+
+// Tablica przewijania (MEDIA_SEEK_BYTES) wg klucza media_lib_path_hash(), false = brak
+bool     media_lib_seek_get(uint32_t key, void* table);
+bool     media_lib_seek_put(uint32_t key, const void* table);
+
+// Przeglądanie (porządek: wykonawca, album, tytuł). Zwracają liczbę pozycji
+// w zakresie offset/max i łączną liczbę w *total.
+// Wykonawcy / albumy - kolejne nazwy przez callback, utwory - pełne ścieżki.
+typedef void (*media_lib_name_cb)(const char* name, uint16_t tracks, void* ctx);
+typedef void (*media_lib_track_cb)(const char* path, const media_info_t* info, void* ctx);
+uint16_t media_lib_artists(uint16_t offset, uint16_t max, uint16_t* total, media_lib_name_cb cb, void* ctx);
+uint16_t media_lib_albums(const char* artist, uint16_t offset, uint16_t max, uint16_t* total, media_lib_name_cb cb, void* ctx);
+uint16_t media_lib_tracks(const char* artist, const char* album, uint16_t offset, uint16_t max, uint16_t* total, media_lib_track_cb cb, void* ctx);
+
+void     media_lib_get_status(media_lib_status_t* out);
@@ -0,0 +1,159 @@
+#include "PlayerState.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+// ======================= STAN =======================
+
+static portMUX_TYPE      g_mux = portMUX_INITIALIZER_UNLOCKED;
+static player_state_t    g_state = { 0, PLAYER_STOPPED, -1, 7, false, 0, 0, "" };   // pod g_mux
+static volatile bool     g_playing = false;       // kopie do odczytu bez blokady (tor próbek)
+static volatile bool     g_screen = false;
+static volatile bool     g_nextRequest = false;
+
+// ======================= API =======================
+
+uint32_t player_state_version(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  uint32_t version = g_state.version;
+  portEXIT_CRITICAL(&g_mux);
+  return version;
+}
+
+void player_state_get(player_state_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  memcpy(out, &g_state, sizeof(*out));
+  portEXIT_CRITICAL(&g_mux);
+}
+
+size_t player_state_path(char* out, size_t size)
+{
+  if (!out || !size) return 0;
+  portENTER_CRITICAL(&g_mux);
+  size_t len = strlcpy(out, g_state.path, size);
+  portEXIT_CRITICAL(&g_mux);
+  return len < size ? len : size - 1;
+}
+
+bool player_state_playing(void)
+{
+  return g_playing;
+}
+
+bool player_state_screen_active(void)
+{
+  return g_screen;
+}
+
+uint8_t player_state_transport(void)
+{
+  return g_state.transport;
+}
+
+int16_t player_state_index(void)
+{
+  return g_state.index;
+}
+
+uint8_t player_state_volume(void)
+{
+  return g_state.volume;
+}
+
+uint32_t player_state_track_gen(void)
+{
+  return g_state.trackGen;
+}
+
+void player_state_set_transport(uint8_t transport)
+{
+  if (transport > PLAYER_PAUSED) return;
+  portENTER_CRITICAL(&g_mux);
+  if (g_state.transport != transport) {
+    g_state.transport = transport;
+    g_state.version++;
+  }
+  g_playing = transport == PLAYER_PLAYING;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_set_track(const char* path)
+{
+  // Ścieżka kopiowana poza sekcją krytyczną - jedyny zapis z głównej pętli
+  char copy[PLAYER_STATE_PATH_LENGTH + 1];
+  strlcpy(copy, path ? path : "", sizeof(copy));
+  portENTER_CRITICAL(&g_mux);
+  memcpy(g_state.path, copy, sizeof(copy));
+  g_state.trackGen++;
+  g_state.version++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_set_index(int16_t index)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_state.index != index) {
+    g_state.index = index;
+    g_state.version++;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_set_volume(uint8_t volume)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_state.volume != volume) {
+    g_state.volume = volume;
+    g_state.version++;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_set_screen(bool active)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_state.screen != active) {
+    g_state.screen = active;
+    g_state.version++;
+  }
+  g_screen = active;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_dir_changed(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_state.dirGen++;
+  g_state.version++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_position_changed(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_state.version++;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void player_state_request_next(void)
+{
+  g_nextRequest = true;
+}
+
+bool player_state_take_next_request(void)
+{
+  if (!g_nextRequest) return false;
+  g_nextRequest = false;
+  return true;
+}
+
+const char* player_state_transport_name(uint8_t transport)
+{
+  switch (transport) {
+    case PLAYER_PLAYING: return "Playing";
+    case PLAYER_PAUSED:  return "Paused";
+    default:             return "Stopped";
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// PLAYERSTATE - wspólny stan odtwarzacza SD (WebUI, OLED, pilot, main.cpp)
+// ========================================================================
+// Jedno źródło stanu transportu zamiast kopii w SDPlayerWebUI
+// (_isPlaying / _isPaused / _selectedIndex / _volume), SDPlayerOLED
+// i flagach main.cpp (sdPlayerPlayingMusic, sdPlayerOLEDActive,
+// sdPlayerAutoPlayNext) synchronizowanych ręcznie w loop().
+//
+// Każda zmiana pola podbija wersję - obserwatorzy porównują jedną liczbę
+// zamiast kopiować pola co klatkę:
+//   - SDPlayerWebUI wysyła stan przez WebSocket /sdplayer/ws (strona nie
+//     odpytuje /sdplayer/api/list co 5 s),
+//   - SDPlayerOLED przesuwa kursor za utworem i rysuje statyczne style
+//     tylko po zmianie wersji,
+//   - koniec pliku (zdarzenie dekodera) = żądanie następnego utworu,
+//     odbierane w głównej pętli.
+// Zapis tylko z głównej pętli (WebUI / OLED / pilot / zdarzenia audio -
+// polecenia ze strony idą przez kolejkę SDPlayerWebUI), odczyt z każdego
+// zadania: player_state_playing() i player_state_screen_active() bez
+// blokady (tor próbek, zadania karty), ścieżka i pełna migawka - kopia
+// pod spinlockiem.
+// ========================================================================
+
+static const uint16_t PLAYER_STATE_PATH_LENGTH = 255;
+
+typedef enum {
+  PLAYER_STOPPED = 0,
+  PLAYER_PLAYING,              // dekoder gra z karty
+  PLAYER_PAUSED                // pauza = zatrzymany dekoder + pozycja wznowienia
+} player_transport_t;
+
+typedef struct {
+  uint32_t version;            // +1 przy każdej zmianie
+  uint8_t  transport;          // player_transport_t
+  int16_t  index;              // pozycja bieżącego utworu w katalogu WebUI (-1 = brak / spoza listy)
+  uint8_t  volume;
+  bool     screen;             // ekran odtwarzacza na OLED (radio nie rysuje)
+  uint32_t trackGen;           // +1 przy każdym starcie utworu (także tego samego pliku)
+  uint32_t dirGen;             // +1 przy zmianie katalogu WebUI
+  char     path[PLAYER_STATE_PATH_LENGTH + 1];   // "" = nic nie gra
+} player_state_t;
+
+uint32_t player_state_version(void);
+void     player_state_get(player_state_t* out);
+size_t   player_state_path(char* out, size_t size);   // kopia ścieżki bieżącego utworu, zwraca długość
+
+// Odczyt z dowolnego zadania (pojedyncze pola bez blokady)
+bool     player_state_playing(void);      // PLAYER_PLAYING - dekoder czyta z karty
+bool     player_state_screen_active(void);
+uint8_t  player_state_transport(void);
+int16_t  player_state_index(void);
+uint8_t  player_state_volume(void);
+uint32_t player_state_track_gen(void);
+
+// Zmiany - tylko główna pętla; bez zmiany wartości wersja bez zmian
+void     player_state_set_transport(uint8_t transport);
+void     player_state_set_track(const char* path);   // start utworu ("" = stop)
+void     player_state_set_index(int16_t index);
+void     player_state_set_volume(uint8_t volume);
+void     player_state_set_screen(bool active);
+void     player_state_dir_changed(void);
+void     player_state_position_changed(void);   // przewinięcie - pozycja skokowo (tylko wersja)
+
+// Koniec pliku - zdarzenie dekodera, obsługa w głównej pętli
+void     player_state_request_next(void);
+bool     player_state_take_next_request(void);
+
+const char* player_state_transport_name(uint8_t transport);   // "Playing" / "Paused" / "Stopped"
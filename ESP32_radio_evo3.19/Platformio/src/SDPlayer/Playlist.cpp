@@ -0,0 +1,515 @@
+#include "Playlist.h"
+#include "MediaLibrary.h"
+#include "TextTranscode.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+  uint32_t hash;          // klucz utworu, 0 = wolny
+  uint32_t positionSec;
+} resume_slot_t;
+
+// Wpis z zachowaną ścieżką - numery wpisów rosnąco (dopisywanie), wyszukiwanie binarne
+typedef struct {
+  uint16_t entry;
+  uint32_t off;           // ścieżka w g_keptArena
+} kept_path_t;
+
+static SemaphoreHandle_t g_lock = nullptr;
+static uint32_t*  g_entries = nullptr;   // klucze utworów w kolejności playlisty
+static uint16_t*  g_order = nullptr;     // kolejność odtwarzania -> numer wpisu
+static uint16_t   g_count = 0;
+static uint16_t   g_position = 0;
+static bool       g_active = false;
+static bool       g_shuffle = false;
+static uint8_t    g_repeat = PLAYLIST_REPEAT_OFF;
+static uint16_t   g_skipped = 0;
+static uint16_t   g_missing = 0;
+static char       g_name[PLAYLIST_NAME_LENGTH + 1] = "";
+static resume_slot_t g_resume[PLAYLIST_RESUME_SLOTS];
+static kept_path_t* g_kept = nullptr;
+static char*      g_keptArena = nullptr;
+static uint16_t   g_keptCount = 0;
+static uint32_t   g_keptUsed = 0;
+
+// ======================= POMOCNICZE =======================
+
+static bool ensure_buffers(void)
+{
+  if (g_entries && g_order) return true;
+  g_entries = (uint32_t*)ps_malloc(PLAYLIST_MAX_ENTRIES * sizeof(uint32_t));
+  if (!g_entries) g_entries = (uint32_t*)malloc(PLAYLIST_MAX_ENTRIES * sizeof(uint32_t));
+  g_order = (uint16_t*)ps_malloc(PLAYLIST_MAX_ENTRIES * sizeof(uint16_t));
+  if (!g_order) g_order = (uint16_t*)malloc(PLAYLIST_MAX_ENTRIES * sizeof(uint16_t));
+  // Ścieżki zachowanych wpisów tylko w PSRAM - bez nich zapis pomija takie wpisy jak dotąd
+  if (!g_kept) g_kept = (kept_path_t*)ps_malloc(PLAYLIST_KEPT_MAX * sizeof(kept_path_t));
+  if (!g_keptArena) g_keptArena = (char*)ps_malloc(PLAYLIST_KEPT_ARENA);
+  return g_entries && g_order;
+}
+
+// Fisher-Yates na pozycjach from..count-1 (pozycje przed from bez zmian)
+static void shuffle_from(uint16_t from)
+{
+  for (uint16_t i = g_count - 1; i > from; i--) {
+    uint16_t j = from + esp_random() % (i - from + 1);
+    uint16_t t = g_order[i];
+    g_order[i] = g_order[j];
+    g_order[j] = t;
+  }
+}
+
+// Nowa kolejność - bieżący wpis zostaje bieżącym
+static void rebuild_order(void)
+{
+  uint16_t current = g_count ? g_order[g_position] : 0;
+  for (uint16_t i = 0; i < g_count; i++) g_order[i] = i;
+  if (g_shuffle && g_count > 1) {
+    g_order[0] = current;
+    g_order[current] = 0;
+    shuffle_from(1);
+    g_position = 0;
+  } else {
+    g_position = current;
+  }
+}
+
+static void set_name(const char* path)
+{
+  const char* name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  strncpy(g_name, name, PLAYLIST_NAME_LENGTH);
+  g_name[PLAYLIST_NAME_LENGTH] = '\0';
+  char* dot = strrchr(g_name, '.');
+  if (dot && dot != g_name) *dot = '\0';
+}
+
+// Linia playlisty -> pełna ścieżka na karcie, false = pominąć (URL, ścieżka Windows z literą dysku)
+static bool resolve_line(const char* line, const char* baseDir, char* out, size_t outSize)
+{
+  if (strstr(line, "://")) return false;   // strumień radiowy - nie plik z karty
+  if (line[0] && line[1] == ':') return false;
+
+  char path[PLAYLIST_PATH_LENGTH + 1];
+  int n = line[0] == '/' || line[0] == '\\' ? snprintf(path, sizeof(path), "%s", line)
+                                            : snprintf(path, sizeof(path), "%s/%s", strcmp(baseDir, "/") == 0 ? "" : baseDir, line);
+  if (n <= 0 || n >= (int)sizeof(path)) return false;
+  for (char* c = path; *c; c++) if (*c == '\\') *c = '/';
+
+  // Normalizacja "./" i "../"
+  size_t o = 0;
+  const char* p = path;
+  while (*p) {
+    while (*p == '/') p++;
+    if (!*p) break;
+    const char* seg = p;
+    while (*p && *p != '/') p++;
+    size_t len = p - seg;
+    if (len == 1 && seg[0] == '.') continue;
+    if (len == 2 && seg[0] == '.' && seg[1] == '.') {
+      while (o > 0 && out[o - 1] != '/') o--;
+      if (o > 0) o--;
+      continue;
+    }
+    if (o + 1 + len >= outSize) return false;
+    out[o++] = '/';
+    memcpy(out + o, seg, len);
+    o += len;
+  }
+  out[o] = '\0';
+  return o > 0;
+}
+
+static void clear_entries(void)
+{
+  g_count = 0;
+  g_position = 0;
+  g_keptCount = 0;
+  g_keptUsed = 0;
+}
+
+// Zachowana ścieżka wpisu, nullptr = ścieżka z klucza (pod g_lock)
+static const char* kept_path(uint16_t entry)
+{
+  uint16_t lo = 0;
+  uint16_t hi = g_keptCount;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (g_kept[mid].entry < entry) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo < g_keptCount && g_kept[lo].entry == entry ? g_keptArena + g_kept[lo].off : nullptr;
+}
+
+// Wpis = klucz; ścieżka zachowana, gdy klucz jej nie odtwarza (spoza biblioteki, kolizja)
+static bool append_path(const char* path)
+{
+  if (g_count >= PLAYLIST_MAX_ENTRIES) return false;
+  uint32_t hash = media_lib_path_hash(path);
+  static char known[PLAYLIST_PATH_LENGTH + 1];
+  if (!media_lib_path_by_hash(hash, known, sizeof(known)) || strcmp(known, path) != 0) {
+    size_t len = strlen(path) + 1;
+    if (g_kept && g_keptArena && g_keptCount < PLAYLIST_KEPT_MAX && g_keptUsed + len <= PLAYLIST_KEPT_ARENA) {
+      g_kept[g_keptCount].entry = g_count;
+      g_kept[g_keptCount].off = g_keptUsed;
+      memcpy(g_keptArena + g_keptUsed, path, len);
+      g_keptCount++;
+      g_keptUsed += len;
+    }
+  }
+  g_entries[g_count] = hash;
+  g_order[g_count] = g_count;
+  g_count++;
+  return true;
+}
+
+// ======================= POZYCJE WZNOWIENIA =======================
+
+static void resume_save(void)
+{
+  File f = SD.open(PLAYLIST_RESUME_FILE, FILE_WRITE);
+  if (!f) return;
+  f.write((const uint8_t*)g_resume, sizeof(g_resume));
+  f.close();
+}
+
+static void resume_load(void)
+{
+  memset(g_resume, 0, sizeof(g_resume));
+  File f = SD.open(PLAYLIST_RESUME_FILE, FILE_READ);
+  if (!f) return;
+  if (f.size() != sizeof(g_resume) || f.read((uint8_t*)g_resume, sizeof(g_resume)) != sizeof(g_resume)) {
+    memset(g_resume, 0, sizeof(g_resume));
+  }
+  f.close();
+}
+
+static int8_t resume_find(uint32_t hash)
+{
+  for (uint8_t i = 0; i < PLAYLIST_RESUME_SLOTS; i++) {
+    if (g_resume[i].hash == hash) return i;
+  }
+  return -1;
+}
+
+// ======================= API =======================
+
+void playlist_init(void)
+{
+  if (g_lock) return;
+  g_lock = xSemaphoreCreateMutex();
+  if (!ensure_buffers()) {
+    Serial.println("debug playlist -> Brak pamięci na playlistę");
+  }
+  resume_load();
+}
+
+int32_t playlist_load(const char* path)
+{
+  if (!g_lock || !path || !ensure_buffers()) return -1;
+  File f = SD.open(path, FILE_READ);
+  if (!f) return -1;
+
+  uint32_t t0 = millis();
+  const char* ext = strrchr(path, '.');
+  bool pls = ext && strcasecmp(ext, ".pls") == 0;
+  bool utf8 = ext && strcasecmp(ext, ".m3u8") == 0;
+
+  char baseDir[PLAYLIST_PATH_LENGTH + 1];
+  strncpy(baseDir, path, PLAYLIST_PATH_LENGTH);
+  baseDir[PLAYLIST_PATH_LENGTH] = '\0';
+  char* slash = strrchr(baseDir, '/');
+  if (slash == baseDir) baseDir[1] = '\0';
+  else if (slash) *slash = '\0';
+  else strcpy(baseDir, "/");
+
+  static char line[PLAYLIST_PATH_LENGTH + 1];
+  static char text[TEXT_WEB_MAX + 1];
+  static char full[PLAYLIST_PATH_LENGTH + 1];
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  clear_entries();
+  g_skipped = 0;
+  g_missing = 0;
+  while (f.available()) {
+    size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    while (n > 0 && (line[n - 1] == '\r' || line[n - 1] == ' ' || line[n - 1] == '\t')) line[--n] = '\0';
+    if (n == sizeof(line) - 1 && f.available()) {
+      // Linia dłuższa niż bufor - reszta do końca linii pominięta
+      while (f.available() && f.read() != '\n') {}
+      g_skipped++;
+      continue;
+    }
+
+    const char* entry = line;
+    if (utf8 && (uint8_t)entry[0] == 0xEF && (uint8_t)entry[1] == 0xBB && (uint8_t)entry[2] == 0xBF) entry += 3;
+    if (pls) {
+      // Tylko "FileN=ścieżka"; Title / Length / [playlist] pomijane
+      if (strncasecmp(entry, "File", 4) != 0) continue;
+      const char* eq = strchr(entry, '=');
+      if (!eq) continue;
+      entry = eq + 1;
+    } else if (entry[0] == '#' || entry[0] == '\0') {
+      continue;   // #EXTM3U / #EXTINF / komentarz
+    }
+    if (!entry[0]) continue;
+
+    // M3U / PLS bez deklaracji kodowania: bajty spoza UTF-8 jako Windows-1250
+    if (!utf8) {
+      text_result_t r;
+      text_transcode(entry, nullptr, 0, text, sizeof(text), &r);
+      entry = text;
+    }
+    if (!resolve_line(entry, baseDir, full, sizeof(full)) || g_count >= PLAYLIST_MAX_ENTRIES) {
+      g_skipped++;
+      continue;
+    }
+    media_info_t info;
+    if (!media_lib_lookup(full, &info)) g_missing++;
+    append_path(full);
+  }
+  f.close();
+
+  g_active = g_count > 0;
+  set_name(path);
+  if (g_shuffle && g_count > 1) shuffle_from(0);
+  int32_t count = g_count;
+  xSemaphoreGive(g_lock);
+
+  Serial.printf("debug playlist -> %s: %d wpisów, %u pominiętych, %u spoza biblioteki, %u ms\n",
+                path, (int)count, g_skipped, g_missing, (unsigned)(millis() - t0));
+  return count;
+}
+
+bool playlist_save(const char* name)
+{
+  if (!g_lock || !name || !name[0]) return false;
+  // Nazwa pliku bez ścieżki i znaków niedozwolonych w FAT
+  char safe[PLAYLIST_NAME_LENGTH + 1];
+  size_t o = 0;
+  for (const char* c = name; *c && o < PLAYLIST_NAME_LENGTH; c++) {
+    safe[o++] = strchr("/\\:*?\"<>|", *c) || (uint8_t)*c < 0x20 ? '_' : *c;
+  }
+  safe[o] = '\0';
+
+  char path[PLAYLIST_PATH_LENGTH + 1];
+  snprintf(path, sizeof(path), "%s/%s.m3u8", PLAYLIST_DIR, safe);
+  if (!SD.exists(PLAYLIST_DIR)) SD.mkdir(PLAYLIST_DIR);
+  File f = SD.open(path, FILE_WRITE);
+  if (!f) return false;
+
+  static char entry[PLAYLIST_PATH_LENGTH + 1];
+  uint16_t written = 0;
+  uint16_t lost = 0;
+  f.print("#EXTM3U\n");
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  for (uint16_t i = 0; i < g_count; i++) {
+    // Kolejność playlisty (nie losowania); wpisy spoza biblioteki - zachowana linia
+    const char* kept = kept_path(i);
+    if (kept) {
+      f.print(kept);
+    } else if (media_lib_path_by_hash(g_entries[i], entry, sizeof(entry))) {
+      f.print(entry);
+    } else {
+      lost++;   // usunięty z biblioteki po wczytaniu, ścieżka nie zachowana
+      continue;
+    }
+    f.print("\n");
+    written++;
+  }
+  strncpy(g_name, safe, PLAYLIST_NAME_LENGTH);
+  g_name[PLAYLIST_NAME_LENGTH] = '\0';
+  xSemaphoreGive(g_lock);
+  f.close();
+
+  Serial.printf("debug playlist -> Zapis %s: %u wpisów, %u bez ścieżki\n", path, written, lost);
+  return true;
+}
+
+bool playlist_add(const char* path)
+{
+  if (!g_lock || !path || !ensure_buffers()) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (g_count == 0) {
+    clear_entries();
+    g_skipped = 0;
+    g_missing = 0;
+    strcpy(g_name, "Queue");
+  }
+  uint16_t index = g_count;
+  bool ok = append_path(path);
+  if (ok && g_shuffle && index > g_position + 1) {
+    // Nowy wpis w losowym miejscu jeszcze nieodtworzonej części
+    uint16_t j = g_position + 1 + esp_random() % (index - g_position);
+    g_order[index] = g_order[j];
+    g_order[j] = index;
+  }
+  xSemaphoreGive(g_lock);
+  return ok;
+}
+
+void playlist_clear(void)
+{
+  if (!g_lock) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  clear_entries();
+  g_active = false;
+  g_name[0] = '\0';
+  xSemaphoreGive(g_lock);
+}
+
+void playlist_set_active(bool on)
+{
+  g_active = on && g_count > 0;
+}
+
+bool playlist_is_active(void)
+{
+  return g_active;
+}
+
+void playlist_set_shuffle(bool on)
+{
+  if (!g_lock) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (on != g_shuffle) {
+    g_shuffle = on;
+    rebuild_order();
+  }
+  xSemaphoreGive(g_lock);
+}
+
+void playlist_set_repeat(uint8_t mode)
+{
+  if (mode <= PLAYLIST_REPEAT_ONE) g_repeat = mode;
+}
+
+int32_t playlist_peek(int8_t step, bool automatic)
+{
+  if (!g_lock) return -1;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int32_t next = -1;
+  if (g_count > 0) {
+    if (automatic && g_repeat == PLAYLIST_REPEAT_ONE) {
+      next = g_position;
+    } else {
+      int32_t p = (int32_t)g_position + step;
+      // Ręcznie zawsze z zawinięciem, automatycznie tylko przy powtarzaniu całości
+      if (p >= 0 && p < g_count) next = p;
+      else if (!automatic || g_repeat == PLAYLIST_REPEAT_ALL) next = (p + g_count) % g_count;
+    }
+  }
+  xSemaphoreGive(g_lock);
+  return next;
+}
+
+void playlist_set_position(uint16_t position)
+{
+  if (!g_lock) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (position < g_count) {
+    // Zawinięcie listy losowej - nowa kolejność reszty, wpis na pozycji 0 już wybrany (gapless)
+    if (g_shuffle && position == 0 && g_position == g_count - 1 && g_count > 2) shuffle_from(1);
+    g_position = position;
+  }
+  xSemaphoreGive(g_lock);
+}
+
+bool playlist_path_at(uint16_t position, char* out, size_t outSize)
+{
+  if (!g_lock) return false;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  bool valid = position < g_count;
+  uint32_t hash = valid ? g_entries[g_order[position]] : 0;
+  const char* kept = valid ? kept_path(g_order[position]) : nullptr;
+  if (kept) strlcpy(out, kept, outSize);
+  xSemaphoreGive(g_lock);
+  if (!valid) return false;
+  if (!kept) return media_lib_path_by_hash(hash, out, outSize);
+  media_info_t info;
+  return media_lib_lookup(out, &info);   // odtwarzany tylko plik w bibliotece (zindeksowany później - gra)
+}
+
+uint16_t playlist_position(void)
+{
+  return g_position;
+}
+
+uint16_t playlist_list(uint16_t offset, uint16_t max, playlist_entry_cb cb, void* ctx)
+{
+  if (!g_lock || !cb) return 0;
+  static char path[PLAYLIST_PATH_LENGTH + 1];
+  uint16_t sent = 0;
+  for (uint32_t pos = offset; pos < g_count && sent < max; pos++) {
+    if (!playlist_path_at(pos, path, sizeof(path))) path[0] = '\0';   // spoza biblioteki - pusta ścieżka
+    cb(pos, path, ctx);
+    sent++;
+  }
+  return sent;
+}
+
+void playlist_get_status(playlist_status_t* out)
+{
+  if (!out) return;
+  memset(out, 0, sizeof(playlist_status_t));
+  if (!g_lock) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  out->active = g_active;
+  out->count = g_count;
+  out->position = g_position;
+  out->shuffle = g_shuffle;
+  out->repeat = g_repeat;
+  out->skipped = g_skipped;
+  out->missing = g_missing;
+  out->kept = g_keptCount;
+  strcpy(out->name, g_name);
+  xSemaphoreGive(g_lock);
+}
+
+uint32_t playlist_resume_get(const char* path)
+{
+  if (!g_lock || !path) return 0;
+  uint32_t hash = media_lib_path_hash(path);
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int8_t i = resume_find(hash);
+  uint32_t pos = i >= 0 ? g_resume[i].positionSec : 0;
+  xSemaphoreGive(g_lock);
+  return pos;
+}
+
+void playlist_resume_note(const char* path, uint32_t positionSec, uint32_t durationSec)
+{
+  if (!g_lock || !path) return;
+  if (durationSec < PLAYLIST_RESUME_MIN_LENGTH || positionSec < PLAYLIST_RESUME_MIN_POS ||
+      positionSec + PLAYLIST_RESUME_END_MARGIN >= durationSec) {
+    playlist_resume_forget(path);
+    return;
+  }
+  uint32_t hash = media_lib_path_hash(path);
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  // Najnowszy wpis na początku, najstarszy wypada
+  int8_t i = resume_find(hash);
+  if (i < 0) i = PLAYLIST_RESUME_SLOTS - 1;
+  memmove(&g_resume[1], &g_resume[0], i * sizeof(resume_slot_t));
+  g_resume[0].hash = hash;
+  g_resume[0].positionSec = positionSec;
+  resume_save();
+  xSemaphoreGive(g_lock);
+}
+
+void playlist_resume_forget(const char* path)
+{
+  if (!g_lock || !path) return;
+  uint32_t hash = media_lib_path_hash(path);
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int8_t i = resume_find(hash);
+  if (i >= 0) {
+    memmove(&g_resume[i], &g_resume[i + 1], (PLAYLIST_RESUME_SLOTS - 1 - i) * sizeof(resume_slot_t));
+    memset(&g_resume[PLAYLIST_RESUME_SLOTS - 1], 0, sizeof(resume_slot_t));
+    resume_save();
+  }
+  xSemaphoreGive(g_lock);
+}
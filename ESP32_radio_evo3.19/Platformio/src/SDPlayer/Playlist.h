@@ -0,0 +1,93 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// PLAYLIST - kolejka odtwarzacza SD (M3U / M3U8 / PLS, zapis z WebUI)
+// ========================================================================
+// Wpis playlisty = klucz utworu w bibliotece (media_lib_path_hash(), 4 B)
+// zamiast ścieżki - pamięć stała niezależnie od długości ścieżek
+// (10000 wpisów = 40 kB kluczy + 20 kB kolejności w PSRAM). Ścieżka
+// rozwiązywana przez bibliotekę dopiero przy odtwarzaniu; wpis spoza
+// biblioteki (plik usunięty / jeszcze nie zindeksowany) jest pomijany.
+// Ścieżkę trzymają tylko wpisy, których klucz jej nie odtwarza (spoza
+// biblioteki przy wczytaniu, kolizja klucza) - zapis playlisty zachowuje
+// takie linie, wpis zindeksowany później zaczyna grać.
+//
+// Kolejność odtwarzania = osobna permutacja numerów wpisów:
+//   - bez losowania: 0, 1, 2, ...
+//   - losowo: permutacja Fishera-Yatesa liczona raz przy włączeniu
+//     (bieżący utwór na pozycji 0) - następny utwór O(1), bez powtórzeń
+//     do końca listy; przy zawinięciu (powtarzanie całości) nowa
+//     permutacja bez zmiany utworu, który właśnie startuje.
+//
+// Pozycja wznowienia: długie pliki (audiobooki, audycje) zapamiętują
+// miejsce przerwania (stop, zmiana utworu) w PLAYLIST_RESUME_FILE -
+// ponowne odtworzenie startuje od tego miejsca (connecttoFS z czasem
+// startu). Plik odtworzony do końca - pozycja kasowana.
+// ========================================================================
+
+static const uint16_t PLAYLIST_MAX_ENTRIES       = 10000;
+static const uint16_t PLAYLIST_PATH_LENGTH       = 255;
+static const uint16_t PLAYLIST_KEPT_MAX          = 1024;                // wpisy z zachowaną ścieżką
+static const uint32_t PLAYLIST_KEPT_ARENA        = 64UL * 1024UL;       // [B] ich ścieżki (PSRAM)
+static const uint8_t  PLAYLIST_NAME_LENGTH       = 63;
+static const char     PLAYLIST_DIR[]             = "/playlists";        // zapis z WebUI
+static const char     PLAYLIST_RESUME_FILE[]     = "/.resume.dat";
+static const uint8_t  PLAYLIST_RESUME_SLOTS      = 32;                  // ostatnio przerwane pliki
+static const uint32_t PLAYLIST_RESUME_MIN_LENGTH = 10UL * 60UL;         // [s] krótsze pliki zawsze od początku
+static const uint32_t PLAYLIST_RESUME_MIN_POS    = 30;                  // [s] przerwanie na początku - bez pozycji
+static const uint32_t PLAYLIST_RESUME_END_MARGIN = 30;                  // [s] przerwanie przy końcu = odtworzony
+
+typedef enum {
+  PLAYLIST_REPEAT_OFF = 0,
+  PLAYLIST_REPEAT_ALL,
+  PLAYLIST_REPEAT_ONE
+} playlist_repeat_t;
+
+typedef struct {
+  bool     active;                        // playlista steruje następnym / poprzednim utworem
+  uint16_t count;
+  uint16_t position;                      // pozycja w kolejności odtwarzania
+  bool     shuffle;
+  uint8_t  repeat;                        // playlist_repeat_t
+  uint16_t skipped;                       // linie pominięte przy wczytaniu (URL, za długa ścieżka, limit)
+  uint16_t missing;                       // wpisy spoza biblioteki w chwili wczytania
+  uint16_t kept;                          // wpisy z zachowaną ścieżką (spoza biblioteki / kolizja klucza)
+  char     name[PLAYLIST_NAME_LENGTH + 1];
+} playlist_status_t;
+
+// Init - bufory w PSRAM, pozycje wznowienia z karty
+void     playlist_init(void);
+
+// Wczytanie M3U / M3U8 / PLS (ścieżki względne - względem katalogu playlisty).
+// Zwraca liczbę wpisów, -1 = błąd. Playlista staje się aktywna od pozycji 0.
+int32_t  playlist_load(const char* path);
+bool     playlist_save(const char* name);                // PLAYLIST_DIR/name.m3u8
+bool     playlist_add(const char* path);                 // dopisanie na koniec (bez zmiany trybu)
+void     playlist_clear(void);                           // pusta lista, koniec trybu playlisty
+void     playlist_set_active(bool on);                   // wybór pliku z katalogu - lista zostaje na później
+bool     playlist_is_active(void);
+
+void     playlist_set_shuffle(bool on);
+void     playlist_set_repeat(uint8_t mode);
+
+// Nawigacja: pozycja następnego utworu bez zmiany stanu (-1 = koniec listy).
+// automatic = przejście po końcu utworu (powtarzanie jednego / brak zawinięcia bez repeat)
+int32_t  playlist_peek(int8_t step, bool automatic);
+void     playlist_set_position(uint16_t position);       // przejście (zawinięcie -> nowa permutacja)
+bool     playlist_path_at(uint16_t position, char* out, size_t outSize);
+uint16_t playlist_position(void);
+
+// Wpisy w kolejności odtwarzania (WebUI), zwraca liczbę wysłanych
+typedef void (*playlist_entry_cb)(uint16_t position, const char* path, void* ctx);
+uint16_t playlist_list(uint16_t offset, uint16_t max, playlist_entry_cb cb, void* ctx);
+
+void     playlist_get_status(playlist_status_t* out);
+
+// Pozycja wznowienia pliku [s], 0 = od początku
+uint32_t playlist_resume_get(const char* path);
+// Zapis przy przerwaniu (pozycja / długość pliku [s]); poza progami - pozycja kasowana
+void     playlist_resume_note(const char* path, uint32_t positionSec, uint32_t durationSec);
+void     playlist_resume_forget(const char* path);      // plik odtworzony do końca
@@ -1,12 +1,14 @@
 #include "SDPlayerOLED.h"
 #include "SDPlayerWebUI.h"
+#include "PlayerState.h"
+#include "DirIndex.h"
+#include "MediaLibrary.h"
+#include "CoverArt.h"
+#include "SeekIndex.h"
 #include "EQ_FFTAnalyzer.h"
+#include "Audio.h"
 #include <SD.h>
 
-// Extern zmienne z main.cpp do zarządzania trybem odtwarzania
-extern bool sdPlayerPlayingMusic;
-extern bool sdPlayerOLEDActive;
-
 // Forward declaration funkcji z main.cpp
 extern void displayRadio();
 extern U8G2 u8g2;
@@ -17,6 +19,12 @@ extern String streamCodec;
 extern String bitrateString;
 extern uint32_t SampleRate;
 extern uint8_t SampleRateRest;
+extern Audio audio;
+
+// Czcionki tytułu w modelu NowPlaying (kolejność jak NpFont)
+static const uint8_t* const NP_FONTS[] = {
+    u8g2_font_6x10_tr, u8g2_font_7x13_tf, u8g2_font_8x13_tf, spleen6x12PL
+};
 
 SDPlayerOLED::SDPlayerOLED(U8G2& display) 
     : _display(display),
@@ -25,6 +33,13 @@ SDPlayerOLED::SDPlayerOLED(U8G2& display)
       _style(STYLE_1),
       _infoStyle(INFO_CLOCK_DATE),
       _mode(MODE_NORMAL),
+      _windowStart(-1),
+      _fileCount(0),
+      _listGen(0),
+      _npTrackGen(0),
+      _stateVersion(0),
+      _coverValid(false),
+      _coverGen(0),
       _selectedIndex(0),
       _scrollOffset(0),
       _splashStartTime(0),
@@ -32,7 +47,6 @@ SDPlayerOLED::SDPlayerOLED(U8G2& display)
       _lastUpdate(0),
       _lastSrcPressTime(0),
       _srcClickCount(0),
-      _scrollPosition(0),
       _animFrame(0),
       _scrollTextOffset(0),
       _lastScrollTime(0),
@@ -43,6 +57,12 @@ SDPlayerOLED::SDPlayerOLED(U8G2& display)
       _actionMessage(""),
       _actionMessageTime(0),
       _showActionMessage(false) {
+    _np.version = 0;
+    buildNowPlaying(true);   // pusty model - nic nie gra
+    memset(_renderStats, 0, sizeof(_renderStats));
+    memset(&_frameKey, 0, sizeof(_frameKey));
+    _frameValid = false;
+    _framesSkipped = 0;
 }
 
 void SDPlayerOLED::begin(SDPlayerWebUI* player) {
@@ -53,13 +73,15 @@ void SDPlayerOLED::begin(SDPlayerWebUI* player) {
 
 void SDPlayerOLED::activate() {
     _active = true;
+    player_state_set_screen(true);   // radio nie rysuje
+    _frameValid = false;
     
     // KRYTYCZNE: Pełny reset stanu przy aktywacji
     _mode = MODE_SPLASH;
     _splashStartTime = millis();
     _selectedIndex = 0;
     _scrollOffset = 0;
-    _scrollPosition = 0;
+    _np.scroll = 0;
     _animFrame = 0;
     _scrollTextOffset = 0;
     
@@ -77,12 +99,14 @@ void SDPlayerOLED::activate() {
 
 void SDPlayerOLED::deactivate() {
     _active = false;
+    player_state_set_screen(false);
+    logRenderStats();
     
     // Reset stanu przy deaktywacji
     _mode = MODE_NORMAL;
     _selectedIndex = 0;
     _scrollOffset = 0;
-    _scrollPosition = 0;
+    _np.scroll = 0;
     
     _display.clearBuffer();
     _display.sendBuffer();
@@ -100,11 +124,14 @@ void SDPlayerOLED::loop() {
     
     unsigned long now = millis();
     
-    // Synchronizuj _selectedIndex z SDPlayerWebUI TYLKO gdy gramy (dla auto-play)
-    // NIE podczas ręcznej nawigacji - inaczej pilot nie działa!
-    if (_player && _mode == MODE_NORMAL && _player->isPlaying()) {
-        int webIndex = _player->getSelectedIndex();
-        if (webIndex != _selectedIndex && webIndex >= 0 && webIndex < _fileList.size()) {
+    // Kursor za bieżącym utworem (auto-play, WWW) tylko po zmianie stanu odtwarzacza -
+    // ręczna nawigacja pilotem między zmianami nie jest nadpisywana
+    uint32_t stateVersion = player_state_version();
+    bool stateChanged = stateVersion != _stateVersion;
+    _stateVersion = stateVersion;
+    if (stateChanged && _mode == MODE_NORMAL && player_state_transport() != PLAYER_STOPPED) {
+        int webIndex = player_state_index();
+        if (webIndex != _selectedIndex && webIndex >= 0 && webIndex < _fileCount) {
             _selectedIndex = webIndex;
             // Dostosuj scroll offset aby kursor był widoczny
             int visibleLines = 4;  // Liczba widocznych linii na ekranie
@@ -135,57 +162,226 @@ void SDPlayerOLED::loop() {
     // Odświeżanie ekranu co 100ms (zmniejszenie częstotliwości dla stabilności)
     if (now - _lastUpdate > 100) {
         _lastUpdate = now;
+        syncFileList();
+        syncNowPlaying();
+        _np.scroll++;
         _animFrame++;
-        render();
+        
+        // Style statyczne - klatka tylko po zmianie stanu / modelu / listy / kursora
+        FrameKey key;
+        frameKey(&key);
+        if (!_frameValid || frameAnimated() || memcmp(&key, &_frameKey, sizeof(key)) != 0) {
+            render();
+            frameKey(&_frameKey);   // po rysowaniu - renderery poprawiają _scrollOffset
+            _frameValid = true;
+        } else {
+            _framesSkipped++;
+        }
+    }
+}
+
+void SDPlayerOLED::frameKey(FrameKey* key) {
+    memset(key, 0, sizeof(*key));   // zerowe wypełnienie - porównanie memcmp
+    key->stateVersion = player_state_version();
+    key->npVersion = _np.version;
+    key->listGen = _listGen;
+    key->coverGen = _coverGen;
+    key->selectedIndex = _selectedIndex;
+    key->scrollOffset = _scrollOffset;
+    key->fileCount = _fileCount;
+    key->mode = _mode;
+    key->style = _style;
+    key->infoStyle = _infoStyle;
+}
+
+bool SDPlayerOLED::frameAnimated() const {
+    if (_mode != MODE_NORMAL) return false;
+    bool title = _np.title.length() > 0;
+    switch (_style) {
+        // Tytuł przewijany tylko gdy nie mieści się w polu
+        case STYLE_1:
+        case STYLE_2: return title && _np.width[NP_FONT_6X10] > 180;
+        case STYLE_4: return title && _np.width[NP_FONT_7X13] > 250;
+        case STYLE_5: return title && _np.width[NP_FONT_8X13] > 240;
+        // Analizator, zegar, czas odtwarzania - co klatkę
+        default: return true;
     }
 }
 
 void SDPlayerOLED::refreshFileList() {
     if (!_player) return;
     
-    _fileList.clear();
+    // Lista z tego samego indeksu co WebUI (DirIndex) - bez osobnego skanu karty,
+    // ten sam filtr formatów i kolejność, więc indeksy obu list są zgodne
+    _listGen = 0;
+    syncFileList();
+    
+    _selectedIndex = 0;
+    _scrollOffset = 0;
+}
+
+void SDPlayerOLED::syncFileList() {
+    if (!_player) return;
+    
     String currentDir = _player->getCurrentDirectory();
+    uint32_t gen = dir_index_generation(currentDir.c_str());
+    if (gen != 0 && gen == _listGen && currentDir == _listDir) return;
+    
+    // Nowy katalog albo nowa wersja listy - sama liczba wpisów, okno doczyta fileAt()
+    int32_t count = dir_index_open(currentDir.c_str());
+    _fileCount = count > 0 ? count : 0;
+    _listDir = currentDir;
+    _listGen = dir_index_generation(currentDir.c_str());
+    _windowStart = -1;
+    
+    if (_selectedIndex >= _fileCount) _selectedIndex = _fileCount > 0 ? _fileCount - 1 : 0;
+    if (_scrollOffset > _selectedIndex) _scrollOffset = _selectedIndex;
+}
+
+const SDPlayerOLED::FileEntry& SDPlayerOLED::fileAt(int index) {
+    static const FileEntry empty = { String(""), false };
+    if (index < 0 || index >= _fileCount) return empty;
+    
+    if (_windowStart < 0 || index < _windowStart || index >= _windowStart + FILE_WINDOW) {
+        // Okno wycentrowane na żądanym wpisie - przewijanie w obie strony bez doczytywania co krok
+        int start = index - FILE_WINDOW / 2;
+        if (start > _fileCount - FILE_WINDOW) start = _fileCount - FILE_WINDOW;
+        if (start < 0) start = 0;
+        
+        dir_entry_t item;
+        for (int i = 0; i < FILE_WINDOW; i++) {
+            if (start + i < _fileCount && dir_index_get(_listDir.c_str(), start + i, &item)) {
+                _window[i].name = item.name;
+                _window[i].isDir = item.type == DIR_TYPE_DIR;
+            } else {
+                _window[i].name = "";
+                _window[i].isDir = false;
+            }
+        }
+        _windowStart = start;
+    }
+    return _window[index - _windowStart];
+}
+
+void SDPlayerOLED::syncNowPlaying() {
+    if (!_player) return;
     
-    File dir = SD.open(currentDir);
-    if (!dir || !dir.isDirectory()) {
-        if (dir) dir.close();
+    // Zmiana utworu z generacji w SDPlayerWebUI - ścieżka kopiowana tylko wtedy, nie co klatkę
+    uint32_t trackGen = _player->getTrackGeneration();
+    bool changed = trackGen != _npTrackGen;
+    if (changed) {
+        _npTrackGen = trackGen;
+        String path = _player->getCurrentFile();
+        if (path == "None") path = "";
+        changed = path != _np.path;
+        _np.path = path;
+    }
+    
+    // Okładka gotowa w tle (z bazy biblioteki albo po dekodowaniu) - kopia przy zmianie generacji
+    uint32_t coverGen = cover_art_generation();
+    if (coverGen != _coverGen) {
+        _coverGen = coverGen;
+        _coverValid = cover_art_get(_np.path.c_str(), _cover);
+    }
+    
+    // Tytuł z nazwy pliku - ponowne zapytanie biblioteki co 5 s (indekser w tle)
+    if (!changed && (_np.tagged || millis() - _np.lookupTime < 5000)) return;
+    if (changed) {
+        _coverValid = false;
+        cover_art_show(_np.path.c_str());
+    }
+    buildNowPlaying(changed);
+}
+
+void SDPlayerOLED::buildNowPlaying(bool changed) {
+    _np.lookupTime = millis();
+    _np.version++;
+    if (changed) _np.scroll = 0;   // nowy utwór przewijany od początku
+    
+    if (_np.path.length() == 0) {
+        _np.title = "";
+        _np.titleTop = "";
+        _np.titleShort = "";
+        _np.titleLine = "";
+        _np.titleLarge = "";
+        _np.format[0] = '\0';
+        _np.formatShort[0] = '\0';
+        _np.durationSec = 0;
+        _np.tagged = true;
+        memset(_np.width, 0, sizeof(_np.width));
+        _np.titleTopWidth = 0;
+        _np.titleLargeWidth = 0;
+        _np.titlePadWidth = 0;
+        _np.formatWidth = 0;
         return;
     }
     
-    File entry = dir.openNextFile();
-    while (entry) {
-        FileEntry fe;
-        fe.name = String(entry.name());
-        
-        // Usuń ścieżkę - zostaw tylko nazwę
-        int lastSlash = fe.name.lastIndexOf('/');
-        if (lastSlash >= 0) {
-            fe.name = fe.name.substring(lastSlash + 1);
-        }
-        
-        fe.isDir = entry.isDirectory();
-        
-        // Dodaj tylko katalogi i pliki audio
-        if (fe.isDir || 
-            fe.name.endsWith(".mp3") || fe.name.endsWith(".MP3") ||
-            fe.name.endsWith(".wav") || fe.name.endsWith(".WAV") ||
-            fe.name.endsWith(".flac") || fe.name.endsWith(".FLAC")) {
-            _fileList.push_back(fe);
+    // Tagi z biblioteki (indekser w tle - plik może jeszcze nie być w bazie)
+    media_info_t info;
+    bool found = media_lib_lookup(_np.path.c_str(), &info);
+    _np.tagged = found && info.title[0];
+    _np.durationSec = found ? info.durationSec : 0;
+    if (_np.tagged) {
+        _np.title = info.artist[0] ? String(info.artist) + " - " + info.title : String(info.title);
+    } else if (changed) {
+        // Nazwa pliku bez ścieżki i rozszerzenia
+        int slashPos = _np.path.lastIndexOf('/');
+        _np.title = _np.path.substring(slashPos + 1);
+        int dotPos = _np.title.lastIndexOf('.');
+        if (dotPos > 0) _np.title = _np.title.substring(0, dotPos);
+    } else {
+        return;   // nadal bez tagów - tytuł bez zmian
+    }
+    
+    if (changed) {
+        _np.format[0] = '\0';
+        int dotPos = _np.path.lastIndexOf('.');
+        if (dotPos > 0 && dotPos < (int)_np.path.length() - 1) {
+            strlcpy(_np.format, _np.path.c_str() + dotPos + 1, sizeof(_np.format));
+            for (char* c = _np.format; *c; c++) *c = toupper((unsigned char)*c);
         }
-        
-        entry.close();
-        entry = dir.openNextFile();
+        strlcpy(_np.formatShort, _np.format, sizeof(_np.formatShort));
     }
-    dir.close();
     
-    // Sortuj: foldery, potem pliki
-    std::sort(_fileList.begin(), _fileList.end(), [](const FileEntry& a, const FileEntry& b) {
-        if (a.isDir != b.isDir) return a.isDir;
-        return a.name.compareTo(b.name) < 0;
-    });
+    // Wersje skrócone (limity znaków jak dotąd w stylach 11, 13, 14)
+    const String& title = _np.title;
+    _np.titleShort = title.length() <= 15 ? title : title.substring(0, 12) + "...";
+    _np.titleLine = title.length() <= 35 ? title : title.substring(0, 32) + "...";
+    _np.titleLarge = title.length() <= 20 ? title : title.substring(0, 17) + "...";
     
-    _selectedIndex = 0;
-    _scrollOffset = 0;
+    // Szerokości - jedyne getStrWidth() tytułu, renderery biorą gotowe liczby
+    for (int f = 0; f < NP_FONT_COUNT; f++) {
+        _display.setFont(NP_FONTS[f]);
+        _np.width[f] = _display.getStrWidth(title.c_str());
+    }
+    String padded = title + "    ";   // spleen ustawiony ostatni w pętli
+    _np.titlePadWidth = _display.getStrWidth(padded.c_str());
+    
+    _display.setFont(u8g2_font_UnnamedDOSFontIV_tr);
+    _np.titleLargeWidth = _display.getStrWidth(_np.titleLarge.c_str());
+    
+    _display.setFont(u8g2_font_6x10_tr);
+    _np.formatWidth = _display.getStrWidth(_np.format);
+    
+    // Górny pasek: obcięcie do 250 px z "..." - raz na utwór zamiast pętli w każdej klatce
+    _np.titleTop = title;
+    if (_np.width[NP_FONT_6X10] > 250) {
+        while (_np.titleTop.length() > 0 && _display.getStrWidth(_np.titleTop.c_str()) > 250) {
+            _np.titleTop.remove(_np.titleTop.length() - 1);
+        }
+        _np.titleTop += "...";
+    }
+    _np.titleTopWidth = _display.getStrWidth(_np.titleTop.c_str());
+}
+
+void SDPlayerOLED::logRenderStats() {
+    RenderStat& st = _renderStats[_style];
+    if (st.frames == 0) return;
+    Serial.printf("debug SDPlayerOLED -> styl %d: %u klatek (%u pominiętych bez zmian), rysowanie śr. %u us, max %u us\n",
+                  (int)_style, (unsigned)st.frames, (unsigned)_framesSkipped,
+                  (unsigned)(st.totalUs / st.frames), (unsigned)st.maxUs);
+    memset(&st, 0, sizeof(st));
+    _framesSkipped = 0;
 }
 
 void SDPlayerOLED::render() {
@@ -198,7 +394,8 @@ void SDPlayerOLED::render() {
         case MODE_VOLUME:
             renderVolume();
             break;
-        case MODE_NORMAL:
+        case MODE_NORMAL: {
+            uint32_t startUs = micros();
             switch (_style) {
                 case STYLE_1: renderStyle1(); break;
                 case STYLE_2: renderStyle2(); break;
@@ -215,7 +412,13 @@ void SDPlayerOLED::render() {
             }
             // Ikonki kontroli wyłączone - teraz wbudowane w Style 1
             // drawControlIcons();
+            uint32_t renderUs = micros() - startUs;
+            RenderStat& st = _renderStats[_style];
+            st.frames++;
+            st.totalUs += renderUs;
+            if (renderUs > st.maxUs) st.maxUs = renderUs;
             break;
+        }
     }
     
     _display.sendBuffer();
@@ -263,60 +466,31 @@ void SDPlayerOLED::renderStyle1() {
     // KRYTYCZNE: Wyczyść bufor przed rysowaniem
     _display.clearBuffer();
     
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "Zatrzymany";
-    } else {
-        // Usuń rozszerzenie
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) {
-            currentFile = currentFile.substring(0, dotPos);
-        }
-        // Usuń ścieżkę
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) {
-            currentFile = currentFile.substring(slashPos + 1);
-        }
-    }
+    const char* currentFile = npText(_np.title, "Zatrzymany");
     
     _display.setFont(u8g2_font_6x10_tr);
     
     // === GÓRNY PASEK - TYTUŁ UTWORU ===
     int titleMaxWidth = 180; // Zostaw miejsce na format i volume
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_6X10], currentFile);
     
     if (titleWidth > titleMaxWidth) {
         // Płynne scrollowanie w prawo
-        static int scrollOffset = 0;
-        static unsigned long lastScrollTime = 0;
-        
-        if (millis() - lastScrollTime > 100) {
-            scrollOffset++;
-            if (scrollOffset > titleWidth + 30) scrollOffset = 0;
-            lastScrollTime = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 30);
         
         _display.setClipWindow(2, 0, titleMaxWidth + 2, 14);
-        _display.drawStr(2 - scrollOffset, 11, currentFile.c_str());
+        _display.drawStr(2 - scrollOffset, 11, currentFile);
         // Powtórz tekst dla ciągłego scrollowania
-        _display.drawStr(2 - scrollOffset + titleWidth + 30, 11, currentFile.c_str());
+        _display.drawStr(2 - scrollOffset + titleWidth + 30, 11, currentFile);
         _display.setMaxClipWindow();
     } else {
         // Wyśrodkowany jeśli się mieści
         int centerX = (titleMaxWidth - titleWidth) / 2;
-        _display.drawStr(2 + centerX, 11, currentFile.c_str());
+        _display.drawStr(2 + centerX, 11, currentFile);
     }
     
     // FORMAT AUDIO
-    String audioFormat = "";
-    String fullFileName = _player->getCurrentFile();
-    if (fullFileName.length() > 0 && fullFileName != "None") {
-        int dotPos = fullFileName.lastIndexOf('.');
-        if (dotPos > 0) {
-            audioFormat = fullFileName.substring(dotPos + 1);
-            audioFormat.toUpperCase();
-        }
-    }
+    const char* audioFormat = _np.format;
     
     // IKONKA GŁOŚNICZKA + VOLUME
     int vol = _player->getVolume();
@@ -328,10 +502,9 @@ void SDPlayerOLED::renderStyle1() {
     _display.drawStr(speakerX + 14, 11, volStr.c_str());
     
     // Format przed głośnikiem
-    if (audioFormat.length() > 0) {
-        int formatWidth = _display.getStrWidth(audioFormat.c_str());
-        int formatX = speakerX - formatWidth - 8;
-        _display.drawStr(formatX, 11, audioFormat.c_str());
+    if (audioFormat[0]) {
+        int formatX = speakerX - _np.formatWidth - 8;
+        _display.drawStr(formatX, 11, audioFormat);
     }
     
     // === CIENKA LINIA ===
@@ -347,7 +520,7 @@ void SDPlayerOLED::renderStyle1() {
     if (_selectedIndex < _scrollOffset) _scrollOffset = _selectedIndex;
     if (_selectedIndex >= _scrollOffset + visibleLines) _scrollOffset = _selectedIndex - visibleLines + 1;
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -357,14 +530,14 @@ void SDPlayerOLED::renderStyle1() {
         }
         
         // Ikona
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
         } else {
             _display.drawStr(2, y, "\xB7");
         }
         
         // Nazwa
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         if (name.length() > 48) name = name.substring(0, 47) + "...";
         _display.drawStr(8, y, name.c_str());
         
@@ -394,16 +567,8 @@ void SDPlayerOLED::drawTopBar() {
             int dateCenterX = (256 - dateWidth) / 2;  // Wyśrodkuj datę
             _display.drawStr(dateCenterX, 11, dateStr);
             
-            // Wykryj rozszerzenie pliku audio
-            String audioFormat = "";
-            String currentFile = _player->getCurrentFile();
-            if (currentFile.length() > 0 && currentFile != "None") {
-                int dotPos = currentFile.lastIndexOf('.');
-                if (dotPos > 0 && dotPos < currentFile.length() - 1) {
-                    audioFormat = currentFile.substring(dotPos + 1);
-                    audioFormat.toUpperCase();  // MP3, FLAC, WAV, OGG, AAC
-                }
-            }
+            // Rozszerzenie pliku audio z modelu NowPlaying
+            const char* audioFormat = _np.format;   // MP3, FLAC, WAV, OGG, AAC
             
             // Ikonka głośnika + Volume po prawej stronie
             int vol = _player->getVolume();
@@ -419,37 +584,20 @@ void SDPlayerOLED::drawTopBar() {
             _display.drawStr(volX, 11, volStr.c_str());
             
             // Format audio między datą a głośnikiem (jeśli jest)
-            if (audioFormat.length() > 0) {
-                int formatWidth = _display.getStrWidth(audioFormat.c_str());
-                int formatX = speakerX - formatWidth - 8;  // 8px odstęp od głośnika
-                _display.drawStr(formatX, 11, audioFormat.c_str());
+            if (audioFormat[0]) {
+                int formatX = speakerX - _np.formatWidth - 8;  // 8px odstęp od głośnika
+                _display.drawStr(formatX, 11, audioFormat);
             }
         }
     } 
     else {
-        // **TYTUŁ UTWORU** - cała szerokość górnego paska
-        String currentTrack = _player->getCurrentFile();
-        if (currentTrack.length() > 0) {
-            // Usuń rozszerzenie
-            int dotPos = currentTrack.lastIndexOf('.');
-            if (dotPos > 0) {
-                currentTrack = currentTrack.substring(0, dotPos);
-            }
-            
-            // Obetnij jeśli za długi
-            int maxWidth = 250;  // 256px - marginesy
-            while (_display.getStrWidth(currentTrack.c_str()) > maxWidth && currentTrack.length() > 0) {
-                currentTrack = currentTrack.substring(0, currentTrack.length() - 1);
-            }
-            if (currentTrack.length() < _player->getCurrentFile().length() - 4) {
-                currentTrack += "...";
-            }
-            
-            // Wyśrodkuj tytuł
-            int titleWidth = _display.getStrWidth(currentTrack.c_str());
-            int titleX = (256 - titleWidth) / 2;
-            _display.drawStr(titleX, 11, currentTrack.c_str());
-        }
+        // **TYTUŁ UTWORU** - cała szerokość górnego paska (obcięty do 250 px w modelu)
+        const char* currentTrack = npText(_np.titleTop, "None");
+        
+        // Wyśrodkuj tytuł
+        int titleWidth = npWidth(_np.titleTopWidth, currentTrack);
+        int titleX = (256 - titleWidth) / 2;
+        _display.drawStr(titleX, 11, currentTrack);
     }
     
     // **POZIOMA KRESKA** przez cały wyświetlacz
@@ -471,7 +619,7 @@ void SDPlayerOLED::drawFileList() {
         _scrollOffset = _selectedIndex - visibleLines + 1;
     }
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -482,7 +630,7 @@ void SDPlayerOLED::drawFileList() {
         }
         
         // Ikona: trójkąt dla folderów, nota dla plików
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             // Trójkąt wskazujący w prawo ►
             _display.drawTriangle(3, y-6, 3, y-2, 7, y-4);
         } else {
@@ -491,7 +639,7 @@ void SDPlayerOLED::drawFileList() {
         }
         
         // Nazwa pliku ze scrollowaniem dla zaznaczonego
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         
         if (idx == _selectedIndex) {
             // SCROLLOWANIE dla zaznaczonego elementu
@@ -571,61 +719,32 @@ void SDPlayerOLED::renderStyle2() {
     // KRYTYCZNE: Wyczyść bufor przed rysowaniem
     _display.clearBuffer();
     
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "Zatrzymany";
-    } else {
-        // Usuń rozszerzenie
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) {
-            currentFile = currentFile.substring(0, dotPos);
-        }
-        // Usuń ścieżkę
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) {
-            currentFile = currentFile.substring(slashPos + 1);
-        }
-    }
+    const char* currentFile = npText(_np.title, "Zatrzymany");
     
     _display.setFont(u8g2_font_6x10_tr);
     
     // === GÓRNY PASEK ===
     // 1. TYTUŁ UTWORU - SCROLLOWANY jeśli za długi
     int titleMaxWidth = 180; // Zostaw miejsce na format i volume
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_6X10], currentFile);
     
     if (titleWidth > titleMaxWidth) {
         // Płynne scrollowanie w prawo
-        static int scrollOffset = 0;
-        static unsigned long lastScrollTime = 0;
-        
-        if (millis() - lastScrollTime > 100) {
-            scrollOffset++;
-            if (scrollOffset > titleWidth + 30) scrollOffset = 0;
-            lastScrollTime = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 30);
         
         _display.setClipWindow(2, 0, titleMaxWidth + 2, 14);
-        _display.drawStr(2 - scrollOffset, 11, currentFile.c_str());
+        _display.drawStr(2 - scrollOffset, 11, currentFile);
         // Powtórz tekst dla ciągłego scrollowania
-        _display.drawStr(2 - scrollOffset + titleWidth + 30, 11, currentFile.c_str());
+        _display.drawStr(2 - scrollOffset + titleWidth + 30, 11, currentFile);
         _display.setMaxClipWindow();
     } else {
         // Wyśrodkowany jeśli się mieści
         int centerX = (titleMaxWidth - titleWidth) / 2;
-        _display.drawStr(2 + centerX, 11, currentFile.c_str());
+        _display.drawStr(2 + centerX, 11, currentFile);
     }
     
     // 2. FORMAT AUDIO
-    String audioFormat = "";
-    String fullFileName = _player->getCurrentFile();
-    if (fullFileName.length() > 0 && fullFileName != "None") {
-        int dotPos = fullFileName.lastIndexOf('.');
-        if (dotPos > 0) {
-            audioFormat = fullFileName.substring(dotPos + 1);
-            audioFormat.toUpperCase();
-        }
-    }
+    const char* audioFormat = _np.format;
     
     // 3. IKONKA GŁOŚNICZKA + VOLUME
     int vol = _player->getVolume();
@@ -637,10 +756,9 @@ void SDPlayerOLED::renderStyle2() {
     _display.drawStr(speakerX + 14, 11, volStr.c_str());
     
     // Format przed głośnikiem
-    if (audioFormat.length() > 0) {
-        int formatWidth = _display.getStrWidth(audioFormat.c_str());
-        int formatX = speakerX - formatWidth - 8;
-        _display.drawStr(formatX, 11, audioFormat.c_str());
+    if (audioFormat[0]) {
+        int formatX = speakerX - _np.formatWidth - 8;
+        _display.drawStr(formatX, 11, audioFormat);
     }
     
     // === CIENKA LINIA ===
@@ -656,7 +774,7 @@ void SDPlayerOLED::renderStyle2() {
     if (_selectedIndex < _scrollOffset) _scrollOffset = _selectedIndex;
     if (_selectedIndex >= _scrollOffset + visibleLines) _scrollOffset = _selectedIndex - visibleLines + 1;
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -666,14 +784,14 @@ void SDPlayerOLED::renderStyle2() {
         }
         
         // Ikona
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
         } else {
             _display.drawStr(2, y, "\xB7");
         }
         
         // Nazwa
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         if (name.length() > 48) name = name.substring(0, 47) + "...";
         _display.drawStr(8, y, name.c_str());
         
@@ -691,52 +809,30 @@ void SDPlayerOLED::renderStyle3() {
     // KRYTYCZNE: Wyczyść bufor przed rysowaniem
     _display.clearBuffer();
     
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None") currentFile = "---";
-    else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
-    }
+    const char* currentFile = npText(_np.title, "---");
     
     _display.setFont(u8g2_font_6x10_tr);
     
     // === GÓRNY PASEK ===
     // Tytuł ze scrollowaniem
     int titleMaxWidth = 180;
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_6X10], currentFile);
     
     if (titleWidth > titleMaxWidth) {
         // Scrollowanie jak w stylu 2
-        static int scrollOffset3 = 0;
-        static unsigned long lastScrollTime3 = 0;
-        
-        if (millis() - lastScrollTime3 > 120) {
-            scrollOffset3++;
-            if (scrollOffset3 > titleWidth + 25) scrollOffset3 = 0;
-            lastScrollTime3 = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 25);
         
         _display.setClipWindow(2, 0, titleMaxWidth + 2, 14);
-        _display.drawStr(2 - scrollOffset3, 11, currentFile.c_str());
-        _display.drawStr(2 - scrollOffset3 + titleWidth + 25, 11, currentFile.c_str());
+        _display.drawStr(2 - scrollOffset, 11, currentFile);
+        _display.drawStr(2 - scrollOffset + titleWidth + 25, 11, currentFile);
         _display.setMaxClipWindow();
     } else {
         int centerX = (titleMaxWidth - titleWidth) / 2;
-        _display.drawStr(2 + centerX, 11, currentFile.c_str());
+        _display.drawStr(2 + centerX, 11, currentFile);
     }
     
     // Format audio
-    String fullFileName = _player->getCurrentFile();
-    String audioFormat = "";
-    if (fullFileName != "None") {
-        int dotPos = fullFileName.lastIndexOf('.');
-        if (dotPos > 0) {
-            audioFormat = fullFileName.substring(dotPos + 1);
-            audioFormat.toUpperCase();
-        }
-    }
+    const char* audioFormat = _np.format;
     
     // Volume + głośnik
     int vol = _player->getVolume();
@@ -747,10 +843,9 @@ void SDPlayerOLED::renderStyle3() {
     drawVolumeIcon(speakerX, 3);
     _display.drawStr(speakerX + 14, 11, volStr.c_str());
     
-    if (audioFormat.length() > 0) {
-        int formatWidth = _display.getStrWidth(audioFormat.c_str());
-        int formatX = speakerX - formatWidth - 8;
-        _display.drawStr(formatX, 11, audioFormat.c_str());
+    if (audioFormat[0]) {
+        int formatX = speakerX - _np.formatWidth - 8;
+        _display.drawStr(formatX, 11, audioFormat);
     }
     
     _display.drawLine(0, 14, 256, 14);
@@ -792,7 +887,7 @@ void SDPlayerOLED::renderStyle3() {
     if (_selectedIndex < _scrollOffset) _scrollOffset = _selectedIndex;
     if (_selectedIndex >= _scrollOffset + visibleLines) _scrollOffset = _selectedIndex - visibleLines + 1;
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -801,13 +896,13 @@ void SDPlayerOLED::renderStyle3() {
             _display.setDrawColor(0);
         }
         
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
         } else {
             _display.drawStr(2, y, "\xB7");
         }
         
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         if (name.length() > 48) name = name.substring(0, 47) + "...";
         _display.drawStr(8, y, name.c_str());
         
@@ -825,37 +920,22 @@ void SDPlayerOLED::renderStyle4() {
     // KRYTYCZNE: Wyczyść bufor przed rysowaniem
     _display.clearBuffer();
     
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "Zatrzymany";
-    } else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
-    }
+    const char* currentFile = npText(_np.title, "Zatrzymany");
     
     // === DUŻY TYTUŁ (większa czcionka) ===
     _display.setFont(u8g2_font_7x13_tf);
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_7X13], currentFile);
     
     if (titleWidth > 250) {
-        static int scrollOffset4 = 0;
-        static unsigned long lastScrollTime4 = 0;
-        
-        if (millis() - lastScrollTime4 > 90) {
-            scrollOffset4++;
-            if (scrollOffset4 > titleWidth + 35) scrollOffset4 = 0;
-            lastScrollTime4 = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 35);
         
         _display.setClipWindow(3, 0, 253, 15);
-        _display.drawStr(3 - scrollOffset4, 12, currentFile.c_str());
-        _display.drawStr(3 - scrollOffset4 + titleWidth + 35, 12, currentFile.c_str());
+        _display.drawStr(3 - scrollOffset, 12, currentFile);
+        _display.drawStr(3 - scrollOffset + titleWidth + 35, 12, currentFile);
         _display.setMaxClipWindow();
     } else {
         int centerX = (256 - titleWidth) / 2;
-        _display.drawStr(centerX, 12, currentFile.c_str());
+        _display.drawStr(centerX, 12, currentFile);
     }
     
     _display.drawLine(0, 15, 256, 15);
@@ -864,15 +944,7 @@ void SDPlayerOLED::renderStyle4() {
     _display.setFont(u8g2_font_6x10_tr);
     
     // Format audio
-    String fullFileName = _player->getCurrentFile();
-    String audioFormat = "";
-    if (fullFileName != "None") {
-        int dotPos = fullFileName.lastIndexOf('.');
-        if (dotPos > 0) {
-            audioFormat = fullFileName.substring(dotPos + 1);
-            audioFormat.toUpperCase();
-        }
-    }
+    const char* audioFormat = _np.format;
     
     // Status odtwarzania
     String status = "STOP";
@@ -883,9 +955,9 @@ void SDPlayerOLED::renderStyle4() {
     }
     
     // Lewa strona: Format
-    if (audioFormat.length() > 0) {
+    if (audioFormat[0]) {
         _display.drawStr(4, 26, "Format:");
-        _display.drawStr(50, 26, audioFormat.c_str());
+        _display.drawStr(50, 26, audioFormat);
     }
     
     // Prawa strona: Status
@@ -917,7 +989,7 @@ void SDPlayerOLED::renderStyle4() {
     if (_selectedIndex < _scrollOffset) _scrollOffset = _selectedIndex;
     if (_selectedIndex >= _scrollOffset + visibleLines) _scrollOffset = _selectedIndex - visibleLines + 1;
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -926,13 +998,13 @@ void SDPlayerOLED::renderStyle4() {
             _display.setDrawColor(0);
         }
         
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
         } else {
             _display.drawStr(2, y, "\xB7");
         }
         
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         if (name.length() > 48) name = name.substring(0, 47) + "...";
         _display.drawStr(8, y, name.c_str());
         
@@ -950,36 +1022,21 @@ void SDPlayerOLED::renderStyle5() {
     _display.clearBuffer();
     
     // === TYTUŁ SCROLLOWANY NA ŚRODKU ===
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "---";
-    } else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
-    }
+    const char* currentFile = npText(_np.title, "---");
     
     _display.setFont(u8g2_font_8x13_tf);
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_8X13], currentFile);
     
     if (titleWidth > 240) {
-        static int scrollOffset5 = 0;
-        static unsigned long lastScrollTime5 = 0;
-        
-        if (millis() - lastScrollTime5 > 120) {
-            scrollOffset5++;
-            if (scrollOffset5 > titleWidth + 30) scrollOffset5 = 0;
-            lastScrollTime5 = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 30);
         
         _display.setClipWindow(8, 0, 248, 35);
-        _display.drawStr(8 - scrollOffset5, 30, currentFile.c_str());
-        _display.drawStr(8 - scrollOffset5 + titleWidth + 30, 30, currentFile.c_str());
+        _display.drawStr(8 - scrollOffset, 30, currentFile);
+        _display.drawStr(8 - scrollOffset + titleWidth + 30, 30, currentFile);
         _display.setMaxClipWindow();
     } else {
         int centerX = (256 - titleWidth) / 2;
-        _display.drawStr(centerX, 30, currentFile.c_str());
+        _display.drawStr(centerX, 30, currentFile);
     }
     
     // === VOLUME BAR (mały) ===
@@ -997,7 +1054,7 @@ void SDPlayerOLED::renderStyle5() {
     if (_selectedIndex < _scrollOffset) _scrollOffset = _selectedIndex;
     if (_selectedIndex >= _scrollOffset + visibleLines) _scrollOffset = _selectedIndex - visibleLines + 1;
     
-    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileList.size(); i++) {
+    for (int i = 0; i < visibleLines && (i + _scrollOffset) < _fileCount; i++) {
         int idx = i + _scrollOffset;
         int y = startY + i * lineHeight;
         
@@ -1006,13 +1063,13 @@ void SDPlayerOLED::renderStyle5() {
             _display.setDrawColor(0);
         }
         
-        if (_fileList[idx].isDir) {
+        if (fileAt(idx).isDir) {
             _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
         } else {
             _display.drawStr(2, y, "\xB7");
         }
         
-        String name = _fileList[idx].name;
+        String name = fileAt(idx).name;
         if (name.length() > 48) name = name.substring(0, 47) + "...";
         _display.drawStr(8, y, name.c_str());
         
@@ -1021,128 +1078,108 @@ void SDPlayerOLED::renderStyle5() {
 }
 
 void SDPlayerOLED::renderStyle6() {
-    // STYL 6: INFO AUDIO + PROGRESS BAR
-    // Tytuł scrollowany na środku + informacje o pliku audio z paskiem postępu
+    // STYL 6: OKŁADKA + INFO AUDIO
+    // Lewa strona okładka albumu 64x64 (CoverArt), prawa: tytuł, format, status i pasek postępu
     
     if (!_player) return;
     
     // KRYTYCZNE: Wyczyść bufor przed rysowaniem - blokuje przebijanie się radia
     _display.clearBuffer();
     
-    _display.setFont(u8g2_font_6x10_tr);
-    
-    // === TYTUŁ SCROLLOWANY NA ŚRODKU ===
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "Brak utworu";
+    // === OKŁADKA ===
+    if (_coverValid) {
+        _display.drawXBM(0, 0, MEDIA_COVER_SIZE, MEDIA_COVER_SIZE, _cover);
     } else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
+        // Brak okładki - ramka z nutą
+        _display.drawFrame(0, 0, MEDIA_COVER_SIZE, MEDIA_COVER_SIZE);
+        _display.drawDisc(24, 42, 6);
+        _display.drawDisc(42, 38, 6);
+        _display.drawBox(29, 18, 2, 24);
+        _display.drawBox(47, 14, 2, 24);
+        _display.drawBox(29, 14, 20, 4);
     }
     
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    const int textX = MEDIA_COVER_SIZE + 6;
+    _display.setFont(u8g2_font_6x10_tr);
     
-    if (titleWidth > 240) {
-        static int scrollOffset6 = 0;
-        static unsigned long lastScrollTime6 = 0;
-        
-        if (millis() - lastScrollTime6 > 100) {
-            scrollOffset6++;
-            if (scrollOffset6 > titleWidth + 30) scrollOffset6 = 0;
-            lastScrollTime6 = millis();
-        }
+    // === TYTUŁ SCROLLOWANY ===
+    const char* currentFile = npText(_np.title, "Brak utworu");
+    
+    int titleWidth = npWidth(_np.width[NP_FONT_6X10], currentFile);
+    
+    if (titleWidth > 256 - textX) {
+        int scrollOffset = npScroll(titleWidth + 30);
         
-        _display.setClipWindow(8, 0, 248, 14);
-        _display.drawStr(8 - scrollOffset6, 11, currentFile.c_str());
-        _display.drawStr(8 - scrollOffset6 + titleWidth + 30, 11, currentFile.c_str());
+        _display.setClipWindow(textX, 0, 256, 14);
+        _display.drawStr(textX - scrollOffset, 11, currentFile);
+        _display.drawStr(textX - scrollOffset + titleWidth + 30, 11, currentFile);
         _display.setMaxClipWindow();
     } else {
-        int centerX = (256 - titleWidth) / 2;
-        _display.drawStr(centerX, 11, currentFile.c_str());
+        _display.drawStr(textX, 11, currentFile);
     }
     
-    _display.drawLine(0, 14, 256, 14);
+    _display.drawLine(textX, 14, 256, 14);
     
     // === INFORMACJE O AUDIO (2 kolumny) ===
     _display.setFont(u8g2_font_5x8_tr);
     
     // Lewa kolumna
-    _display.drawStr(4, 24, "Format:");
-    // USUNIĘTO getCurrentFile() - nie pobieramy nazwy pliku, tylko wyświetlamy stałą wartość
-    _display.drawStr(42, 24, "MP3");
+    _display.drawStr(textX, 26, "Format:");
+    _display.drawStr(textX + 40, 26, _np.format[0] ? _np.format : "-");
     
-    _display.drawStr(4, 34, "Bitrate:");
-    _display.drawStr(42, 34, "192k");  // Można dodać rzeczywiste dane z audio
+    _display.drawStr(textX, 36, "Bitrate:");
+    String bitrate = bitrateString.length() ? bitrateString + "k" : String("-");
+    _display.drawStr(textX + 40, 36, bitrate.c_str());
     
     // Prawa kolumna
-    _display.drawStr(130, 24, "Volume:");
-    int vol = _player->getVolume();
-    String volStr = String(vol);
-    _display.drawStr(168, 24, volStr.c_str());
+    _display.drawStr(textX + 96, 26, "Volume:");
+    String volStr = String(_player->getVolume());
+    _display.drawStr(textX + 134, 26, volStr.c_str());
     
-    _display.drawStr(130, 34, "Status:");
+    _display.drawStr(textX + 96, 36, "Status:");
     if (_player->isPlaying() && !_player->isPaused()) {
-        _display.drawStr(168, 34, "PLAY");
+        _display.drawStr(textX + 134, 36, "PLAY");
     } else if (_player->isPaused()) {
-        _display.drawStr(168, 34, "PAUSE");
+        _display.drawStr(textX + 134, 36, "PAUSE");
     } else {
-        _display.drawStr(168, 34, "STOP");
+        _display.drawStr(textX + 134, 36, "STOP");
     }
     
     // === PASEK POSTĘPU (z czasem) ===
-    _display.setFont(u8g2_font_5x8_tr);
-    
-    // Symulacja czasu - w rzeczywistości pobierz z player
-    int currentSeconds = 125;  // 2:05
-    int totalSeconds = 245;    // 4:05
+    uint32_t currentSeconds = 0;
+    uint32_t totalSeconds = 0;
+    if (_player->isPlaying()) {
+        currentSeconds = seek_index_position_ms() / 1000;   // ramki od startu / przewinięcia (także VBR)
+        totalSeconds = seek_index_duration_ms() / 1000;      // z tablicy przewijania (Xing / STREAMINFO / mdhd)
+        if (totalSeconds == 0) totalSeconds = audio.getAudioFileDuration();
+        if (totalSeconds == 0) totalSeconds = _np.durationSec;   // dekoder jeszcze nie zna - czas z biblioteki
+    }
     
-    // Formatowanie czasu
     char currentTime[8];
     char totalTime[8];
-    snprintf(currentTime, sizeof(currentTime), "%d:%02d", currentSeconds / 60, currentSeconds % 60);
-    snprintf(totalTime, sizeof(totalTime), "%d:%02d", totalSeconds / 60, totalSeconds % 60);
+    snprintf(currentTime, sizeof(currentTime), "%u:%02u", (unsigned)(currentSeconds / 60) % 100, (unsigned)(currentSeconds % 60));
+    snprintf(totalTime, sizeof(totalTime), "%u:%02u", (unsigned)(totalSeconds / 60) % 100, (unsigned)(totalSeconds % 60));
     
-    // Wyświetl czas po lewej i prawej
-    _display.drawStr(4, 46, currentTime);
+    _display.drawStr(textX, 60, currentTime);
     int totalTimeWidth = _display.getStrWidth(totalTime);
-    _display.drawStr(256 - totalTimeWidth - 4, 46, totalTime);
+    _display.drawStr(256 - totalTimeWidth, 60, totalTime);
     
-    // Pasek postępu (między czasami)
-    int progressBarX = 30;
-    int progressBarY = 40;
-    int progressBarWidth = 195;
-    int progressBarHeight = 8;
+    // Pasek postępu nad czasami
+    int progressBarX = textX;
+    int progressBarY = 44;
+    int progressBarWidth = 256 - textX;
+    int progressBarHeight = 7;
     
     _display.drawFrame(progressBarX, progressBarY, progressBarWidth, progressBarHeight);
     
-    // Wypełnienie na podstawie postępu
     int progressFill = 0;
     if (totalSeconds > 0) {
-        progressFill = (currentSeconds * (progressBarWidth - 2)) / totalSeconds;
+        uint32_t pos = currentSeconds < totalSeconds ? currentSeconds : totalSeconds;
+        progressFill = (pos * (progressBarWidth - 2)) / totalSeconds;
     }
     if (progressFill > 0) {
         _display.drawBox(progressBarX + 1, progressBarY + 1, progressFill, progressBarHeight - 2);
     }
-    
-    // === LISTA PLIKÓW (1 linia kompaktowa) ===
-    _display.setFont(u8g2_font_5x8_tr);
-    const int startY = 58;
-    
-    if (_selectedIndex < _fileList.size()) {
-        int y = startY;
-        
-        if (_fileList[_selectedIndex].isDir) {
-            _display.drawTriangle(2, y-5, 2, y-2, 5, y-3);
-        } else {
-            _display.drawStr(2, y, "\xB7");
-        }
-        
-        String name = _fileList[_selectedIndex].name;
-        if (name.length() > 48) name = name.substring(0, 47) + "...";
-        _display.drawStr(8, y, name.c_str());
-    }
 }
 
 void SDPlayerOLED::renderStyle7() {
@@ -1188,39 +1225,24 @@ void SDPlayerOLED::renderStyle7() {
     _display.drawLine(0, 14, 256, 14);
     
     // === TYTUŁ UTWORU (scrollowany) ===
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "---";
-    } else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
-    }
+    const char* currentFile = npText(_np.title, "---");
     
     _display.setFont(u8g2_font_7x13_tf);
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_7X13], currentFile);
     int titleY = 26;
     
     if (titleWidth > 250) {
         // Scrolluj długi tytuł
-        static int scrollOffset = 0;
-        static unsigned long lastScrollTime = 0;
-        
-        if (millis() - lastScrollTime > 100) {
-            scrollOffset++;
-            if (scrollOffset > titleWidth + 30) scrollOffset = 0;
-            lastScrollTime = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 30);
         
         _display.setClipWindow(3, 16, 253, 30);
-        _display.drawStr(3 - scrollOffset, titleY, currentFile.c_str());
-        _display.drawStr(3 - scrollOffset + titleWidth + 30, titleY, currentFile.c_str());
+        _display.drawStr(3 - scrollOffset, titleY, currentFile);
+        _display.drawStr(3 - scrollOffset + titleWidth + 30, titleY, currentFile);
         _display.setMaxClipWindow();
     } else {
         // Wyśrodkuj krótki tytuł
         int centerX = (256 - titleWidth) / 2;
-        _display.drawStr(centerX, titleY, currentFile.c_str());
+        _display.drawStr(centerX, titleY, currentFile);
     }
     
     // === DŁUGA KRESKA POD TYTUŁEM ===
@@ -1317,37 +1339,22 @@ void SDPlayerOLED::renderStyle10() {
     _display.setFont(u8g2_font_6x10_tr);
     
     // === TYTUŁ SCROLLOWANY NA ŚRODKU ===
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None" || currentFile.length() == 0) {
-        currentFile = "NO FILE";
-    } else {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) currentFile = currentFile.substring(0, dotPos);
-        int slashPos = currentFile.lastIndexOf('/');
-        if (slashPos >= 0) currentFile = currentFile.substring(slashPos + 1);
-    }
+    const char* currentFile = npText(_np.title, "NO FILE");
     
-    int titleWidth = _display.getStrWidth(currentFile.c_str());
+    int titleWidth = npWidth(_np.width[NP_FONT_6X10], currentFile);
     
     if (titleWidth > 200) {
         // Scrollowanie dla długiego tytułu
-        static int scrollOffset10 = 0;
-        static unsigned long lastScrollTime10 = 0;
-        
-        if (millis() - lastScrollTime10 > 100) {
-            scrollOffset10++;
-            if (scrollOffset10 > titleWidth + 30) scrollOffset10 = 0;
-            lastScrollTime10 = millis();
-        }
+        int scrollOffset = npScroll(titleWidth + 30);
         
         _display.setClipWindow(4, 0, 200, 13);
-        _display.drawStr(4 - scrollOffset10, 10, currentFile.c_str());
-        _display.drawStr(4 - scrollOffset10 + titleWidth + 30, 10, currentFile.c_str());
+        _display.drawStr(4 - scrollOffset, 10, currentFile);
+        _display.drawStr(4 - scrollOffset + titleWidth + 30, 10, currentFile);
         _display.setMaxClipWindow();
     } else {
         // Wyśrodkowanie krótkiego tytułu
         int centerX = (200 - titleWidth) / 2;
-        _display.drawStr(centerX, 10, currentFile.c_str());
+        _display.drawStr(centerX, 10, currentFile);
     }
     
     // Volume po prawej
@@ -1641,13 +1648,6 @@ void SDPlayerOLED::nextInfoStyle() {
                   _infoStyle == INFO_CLOCK_DATE ? "CLOCK/DATE" : "TRACK TITLE");
 }
 
-void SDPlayerOLED::setSelectedIndex(int index) {
-    if (index >= 0 && index < _fileList.size()) {
-        _selectedIndex = index;
-        Serial.printf("SD Player OLED: Selected index updated to %d\n", index);
-    }
-}
-
 void SDPlayerOLED::onRemoteVolUp() {
     if (!_player) return;
     int vol = _player->getVolume();
@@ -1672,7 +1672,6 @@ void SDPlayerOLED::onRemoteStop() {
     if (!_player) return;
     
     _player->stop();
-    sdPlayerPlayingMusic = false;
     
     // KRYTYCZNE: Przywróć tryb normalny aby nawigacja działała
     _mode = MODE_NORMAL;
@@ -1712,8 +1711,7 @@ bool SDPlayerOLED::checkEncoderLongPress(bool buttonState) {
         // DŁUGIE PRZYTRZYMANIE (4 sek) - WYJŚCIE DO RADIA
         Serial.println("SD Player: Long press detected (4s) - returning to radio");
         showActionMessage("EXIT");
-        sdPlayerOLEDActive = false;
-        sdPlayerPlayingMusic = false;
+        if (_player) _player->stop();
         _encoderButtonPressed = false; // Reset flagi
         deactivate();
         displayRadio();
@@ -1728,8 +1726,7 @@ void SDPlayerOLED::onEncoderButtonHold(unsigned long holdTime) {
     if (holdTime >= 4000) {
         Serial.println("SD Player: Long hold detected - returning to radio");
         showActionMessage("EXIT");
-        sdPlayerOLEDActive = false;
-        sdPlayerPlayingMusic = false;
+        if (_player) _player->stop();
         deactivate();
         displayRadio();
     }
@@ -1751,8 +1748,7 @@ void SDPlayerOLED::onEncoderButton() {
             // POTRÓJNE KLIKNIĘCIE - WYJŚCIE DO RADIA
             Serial.println("SD Player: Triple click detected - returning to radio");
             showActionMessage("EXIT");
-            sdPlayerOLEDActive = false;
-            sdPlayerPlayingMusic = false;
+            if (_player) _player->stop();
             deactivate();
             displayRadio();
             _encoderClickCount = 0;
@@ -1793,7 +1789,7 @@ void SDPlayerOLED::scrollUp() {
 }
 
 void SDPlayerOLED::scrollDown() {
-    if (_selectedIndex < _fileList.size() - 1) {
+    if (_selectedIndex < _fileCount - 1) {
         _selectedIndex++;
         
         // KRYTYCZNE: Dostosuj scrollOffset aby kursor był widoczny
@@ -1805,9 +1801,9 @@ void SDPlayerOLED::scrollDown() {
 }
 
 void SDPlayerOLED::selectCurrent() {
-    if (!_player || _selectedIndex >= _fileList.size()) return;
+    if (!_player || _selectedIndex >= _fileCount) return;
     
-    FileEntry& entry = _fileList[_selectedIndex];
+    const FileEntry& entry = fileAt(_selectedIndex);
     
     if (entry.isDir) {
         // Wejdź do katalogu
@@ -1826,7 +1822,6 @@ void SDPlayerOLED::selectCurrent() {
         
         // Odtwórz nowy plik
         _player->playIndex(_selectedIndex);
-        sdPlayerPlayingMusic = true;
         Serial.println("DEBUG: Playing selected track from SD Player");
         
         // POZOSTAJEMY w panelu SD Player OLED - nie wychodzimy automatycznie
@@ -1835,6 +1830,7 @@ void SDPlayerOLED::selectCurrent() {
 }
 
 void SDPlayerOLED::nextStyle() {
+    logRenderStats();
     switch (_style) {
         case STYLE_1: _style = STYLE_2; break;
         case STYLE_2: _style = STYLE_3; break;
@@ -1852,6 +1848,7 @@ void SDPlayerOLED::nextStyle() {
 }
 
 void SDPlayerOLED::setStyle(DisplayStyle style) {
+    logRenderStats();
     _style = style;
 }
 // ========== STYLE 11 - Bazujący na Radio Mode 0 (podstawowy) ==========
@@ -1863,13 +1860,7 @@ void SDPlayerOLED::renderStyle11() {
     _display.clearBuffer();
     
     // Nazwa aktualnego pliku (bez rozszerzenia) - DUŻA CZCIONKA jak w trybie 0
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None") currentFile = "---";
-    
-    int dotPos = currentFile.lastIndexOf('.');
-    if (dotPos > 0) {
-        currentFile = currentFile.substring(0, dotPos);
-    }
+    const char* currentFile = npText(_np.title, "---");
     
     // GÓRNA CZĘŚĆ: Numer + duża nazwa (jak w radyjku)
     int trackNum = _selectedIndex + 1;
@@ -1885,36 +1876,28 @@ void SDPlayerOLED::renderStyle11() {
     _display.setDrawColor(1);  // Powrót do białego
     
     // DUŻA CZCIONKA dla nazwy pliku u góry (jak w trybie 0 radyjka) - TYLKO skrócona
+    // Długa nazwa skrócona w modelu do 12 znaków + "..." (jak stationNameLenghtCut w radyjku)
     _display.setFont(u8g2_font_helvB14_tr);
-    if (currentFile.length() <= 15) {
-        // Krótka nazwa - wyświetl całą
-        _display.drawStr(24, 16, currentFile.c_str());
-    } else {
-        // Długa nazwa - skróć do 12 znaków + "..." (jak stationNameLenghtCut w radyjku)
-        String shortName = currentFile.substring(0, 12) + "...";
-        _display.drawStr(24, 16, shortName.c_str());
-    }
+    _display.drawStr(24, 16, npText(_np.titleShort, currentFile));
     
     // ŚRODEK EKRANU (y=33): Scrolling pełna nazwa pliku (jak stationStringScroll w radyjku Mode 0)
     _display.setFont(spleen6x12PL);
-    String scrollText = currentFile; // Pełna nazwa bez rozszerzenia
-    int scrollW = _display.getStrWidth(scrollText.c_str());
+    int scrollW = npWidth(_np.width[NP_FONT_SPLEEN], currentFile);
     
     // Scrolling tylko jeśli tekst szerszy niż ekran (42 znaki, jak maxStationVisibleStringScrollLength)
     if (scrollW > 250) {
-        _scrollPosition = (_scrollPosition + 1) % (scrollW + 20);
-        int x = 0 - _scrollPosition;
+        int x = 0 - npScroll(scrollW + 20);
         if (x < -scrollW) x = 0;
         
         // Rysuj tekst wielokrotnie aby zapełnić ekran (jak w displayRadioScroller)
         int xPos = x;
         do {
-            _display.drawStr(xPos, 33, scrollText.c_str());
+            _display.drawStr(xPos, 33, currentFile);
             xPos += scrollW + 20; // Odstęp między powtórzeniami
         } while (xPos < 256);
     } else {
         // Krótki tekst - wyświetl od lewej (jak w Radio Mode 0)
-        _display.drawStr(0, 33, scrollText.c_str());
+        _display.drawStr(0, 33, currentFile);
     }
     
     // Dolna linia separująca (jak w trybie 0)
@@ -2042,40 +2025,25 @@ void SDPlayerOLED::renderStyle12() {
     }
     
     // 3. Format/system pliku (MP3, FLAC, WAV, etc.)
-    String currentFile = _player->getCurrentFile();
-    String fileExt = "";
-    String fileName = currentFile;
-    
-    if (currentFile != "None") {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) {
-            fileExt = currentFile.substring(dotPos + 1);
-            fileExt.toUpperCase(); // MP3, FLAC, WAV
-            if (fileExt.length() > 4) fileExt = fileExt.substring(0, 4); // Ogranicz do 4 znaków
-            fileName = currentFile.substring(0, dotPos); // Nazwa bez rozszerzenia
-        }
-    } else {
-        fileName = "Brak pliku";
-    }
-    
-    if (fileExt == "") fileExt = "---";
-    _display.drawStr(235, 47, fileExt.c_str());
+    // Format obcięty do 4 znaków w modelu (MP3, FLAC, WAV)
+    _display.drawStr(235, 47, _np.formatShort[0] ? _np.formatShort : "---");
     
     // DOLNA LINIA: Scrolling nazwa utworu (pełna szerokość - format już wyświetlony w linii 47)
-    int trackNum = _selectedIndex + 1;
-    String scrollText = String(trackNum) + ". " + fileName;
+    const char* fileName = npText(_np.title, "Brak pliku");
+    char trackPrefix[8];
+    snprintf(trackPrefix, sizeof(trackPrefix), "%d. ", _selectedIndex + 1);
     
-    // Scrolling nazwa utworu (pełna szerokość ekranu)
+    // Scrolling nazwa utworu (pełna szerokość ekranu) - numer + tytuł, szerokość tytułu z modelu
     _display.setFont(spleen6x12PL);
-    int scrollW = _display.getStrWidth(scrollText.c_str());
+    int prefixW = _display.getStrWidth(trackPrefix);
+    int scrollW = prefixW + npWidth(_np.width[NP_FONT_SPLEEN], fileName);
+    int x = 0;
     if (scrollW > 250) { // Scrolling jeśli tekst szerszy niż ekran
-        _scrollPosition = (_scrollPosition + 1) % (scrollW + 250);
-        int x = 250 - _scrollPosition;
+        x = 250 - npScroll(scrollW + 250);
         if (x < -scrollW) x = 250;
-        _display.drawStr(x, 63, scrollText.c_str());
-    } else {
-        _display.drawStr(0, 63, scrollText.c_str());
     }
+    _display.drawStr(x, 63, trackPrefix);
+    _display.drawStr(x + prefixW, 63, fileName);
 }
 
 // ========== STYLE 13 - Bazujący na Radio Mode 2 (3 linijki tekstu) ==========
@@ -2088,14 +2056,8 @@ void SDPlayerOLED::renderStyle13() {
     
     _display.setFont(spleen6x12PL);
     
-    // Nazwa pliku na górze z numerem
-    String currentFile = _player->getCurrentFile();
-    if (currentFile == "None") currentFile = "Brak pliku";
-    
-    int dotPos = currentFile.lastIndexOf('.');
-    if (dotPos > 0) {
-        currentFile = currentFile.substring(0, dotPos);
-    }
+    // Nazwa pliku na górze z numerem (skrócona w modelu do 35 znaków)
+    const char* currentFile = npText(_np.titleLine, "Brak pliku");
     
     // Kwadrat z numerem (jak w trybie 2 radyjka)
     int trackNum = _selectedIndex + 1;
@@ -2107,11 +2069,8 @@ void SDPlayerOLED::renderStyle13() {
     _display.print(trackStr);
     _display.setDrawColor(1);
     
-    // Nazwa pliku obok numeru (skrócona aby się zmieściła)
-    if (currentFile.length() > 35) {
-        currentFile = currentFile.substring(0, 32) + "...";
-    }
-    _display.drawStr(23, 11, currentFile.c_str());
+    // Nazwa pliku obok numeru
+    _display.drawStr(23, 11, currentFile);
     
     // Status odtwarzania w środku (linijka 2)
     const char* status = _player->isPlaying() ? (_player->isPaused() ? "PAUSED" : "PLAYING") : "STOPPED";
@@ -2155,20 +2114,7 @@ void SDPlayerOLED::renderStyle14() {
     extern String streamCodec;
     extern String bitrateString;
     
-    String currentFile = _player->getCurrentFile();
-    String fileName = currentFile;
-    String fileExt = "";
-    
-    if (currentFile != "None") {
-        int dotPos = currentFile.lastIndexOf('.');
-        if (dotPos > 0) {
-            fileExt = currentFile.substring(dotPos + 1);
-            fileExt.toUpperCase();
-            fileName = currentFile.substring(0, dotPos);
-        }
-    } else {
-        fileName = "Brak pliku";
-    }
+    const char* fileName = npText(_np.title, "Brak pliku");
     
     // ========== GÓRNA LINIA (y=10) - STATUS ==========
     _display.setFont(spleen6x12PL);
@@ -2213,16 +2159,13 @@ void SDPlayerOLED::renderStyle14() {
     }
     
     // ========== ŚRODEK - DUŻA NAZWA UTWORU (wycentrowana) ==========
-    // Skróć nazwę jeśli za długa (max 20 znaków dla dużej czcionki)
-    String displayName = fileName;
-    if (displayName.length() > 20) {
-        displayName = displayName.substring(0, 17) + "...";
-    }
+    // Nazwa skrócona w modelu (max 20 znaków dla dużej czcionki)
+    const char* displayName = npText(_np.titleLarge, fileName);
     
     _display.setFont(u8g2_font_UnnamedDOSFontIV_tr); // Duża czcionka jak w Radio Mode 3
-    int nameWidth = _display.getStrWidth(displayName.c_str());
+    int nameWidth = npWidth(_np.titleLargeWidth, displayName);
     int nameX = (256 - nameWidth) / 2; // Wycentruj
-    _display.drawStr(nameX, 27, displayName.c_str()); // y=27 wyżej niż poprzednio
+    _display.drawStr(nameX, 27, displayName); // y=27 wyżej niż poprzednio
     
     // ========== STATUS ODTWARZANIA (PO ŚRODKU) ==========
     _display.setFont(spleen6x12PL);
@@ -2242,25 +2185,24 @@ void SDPlayerOLED::renderStyle14() {
     
     // ========== DÓŁ - SCROLLING PEŁNA NAZWA ==========
     _display.setFont(spleen6x12PL);
-    String scrollText = fileName + "    "; // Dodaj separatory
-    int scrollW = _display.getStrWidth(scrollText.c_str());
+    // Szerokość z separatorami (tytuł + 4 spacje) z modelu
+    int scrollW = _np.title.length() ? _np.titlePadWidth : _display.getStrWidth("Brak pliku    ");
     
     // Scrolling jeśli tekst szerszy niż ekran (jak w displayRadioScroller Mode 3)
     if (scrollW > 250) {
-        _scrollPosition = (_scrollPosition + 1) % (scrollW + 20);
-        int x = 0 - _scrollPosition;
+        int x = 0 - npScroll(scrollW + 20);
         if (x < -scrollW) x = 0;
         
         // Rysuj tekst wielokrotnie aby zapełnić ekran
         int xPos = x;
         do {
-            _display.drawStr(xPos, 52, scrollText.c_str()); // y=52 jak yPositionDisplayScrollerMode3
+            _display.drawStr(xPos, 52, fileName); // y=52 jak yPositionDisplayScrollerMode3
             xPos += scrollW;
         } while (xPos < 256);
     } else {
         // Krótki tekst - wyśrodkuj (jak w Radio Mode 3)
         int x = (256 - scrollW) / 2;
-        _display.drawStr(x, 52, scrollText.c_str());
+        _display.drawStr(x, 52, fileName);
     }
     
     // Linia separująca nad dolnym paskiem
@@ -2272,8 +2214,9 @@ void SDPlayerOLED::renderStyle14() {
     
     // Lewa strona: Samplerate + format
     String infoStr = String(SampleRate) + "." + String(SampleRateRest) + "kHz";
-    if (fileExt.length() > 0) {
-        infoStr += " " + fileExt;
+    if (_np.format[0]) {
+        infoStr += " ";
+        infoStr += _np.format;
     }
     _display.setFont(spleen6x12PL);
     _display.drawStr(0, 63, infoStr.c_str());
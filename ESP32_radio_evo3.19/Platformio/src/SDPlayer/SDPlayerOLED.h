@@ -2,6 +2,7 @@
 #include <Arduino.h>
 #include <U8g2lib.h>
 #include <vector>
+#include "MediaLibrary.h"
 
 // Forward declaration
 class SDPlayerWebUI;
@@ -16,6 +17,8 @@ class SDPlayerWebUI;
  * - 7 stylów wyświetlania (1-6 + 10)
  * - Obsługa pilota (góra/dół/OK/SRC/VOL)
  * - Obsługa enkodera
+ * - Model bieżącego utworu (NowPlaying) liczony raz na zmianę utworu,
+ *   czas rysowania per styl w logu (debug SDPlayerOLED) przy zmianie stylu
  */
 
 class SDPlayerOLED {
@@ -60,7 +63,7 @@ public:
         STYLE_3 = 3,  // VU meter + utwór
         STYLE_4 = 4,  // Spektrum częstotliwości
         STYLE_5 = 5,  // Minimalistyczny
-        STYLE_6 = 6,  // Album art simulation
+        STYLE_6 = 6,  // Okładka albumu + info audio
         STYLE_7 = 7,  // Analizator retro z trójkątnymi słupkami
         STYLE_10 = 10, // Pełny ekran z animacją
         STYLE_11 = 11, // Styl bazujący na Radio Mode 0 - podstawowy
@@ -80,7 +83,6 @@ public:
     };
     
     void nextInfoStyle();  // Przełączanie przyciskiem SRC
-    void setSelectedIndex(int index);  // Ustawia _selectedIndex (synchronizacja z WebUI)
     int getSelectedIndex() { return _selectedIndex; }  // Zwraca aktualny indeks
     
 private:
@@ -98,12 +100,55 @@ private:
     };
     Mode _mode;
     
-    // Lista utworów
+    // Lista utworów - w pamięci tylko okno wpisów wokół kursora,
+    // pełna lista katalogu w DirIndex (wspólna z WebUI)
     struct FileEntry {
         String name;
         bool isDir;
     };
-    std::vector<FileEntry> _fileList;
+    static const int FILE_WINDOW = 12;  // wpisów w oknie (ekran pokazuje 2-4)
+    FileEntry _window[FILE_WINDOW];
+    int _windowStart;                   // indeks pierwszego wpisu okna, -1 = okno puste
+    int _fileCount;                     // liczba wpisów bieżącego katalogu
+    String _listDir;                    // katalog, z którego pochodzi okno
+    uint32_t _listGen;                  // wersja listy w DirIndex - zmiana = okno od nowa
+    
+    // Bieżący utwór (NowPlaying) - wszystko, czego renderery potrzebują o utworze,
+    // liczone raz na zmianę utworu / tagów; renderery tylko czytają, bez kopii
+    // ścieżki, substring() i getStrWidth() tytułu w każdej klatce
+    enum NpFont {
+        NP_FONT_6X10 = 0,               // u8g2_font_6x10_tr - style 1-3, 6, 10
+        NP_FONT_7X13,                   // u8g2_font_7x13_tf - style 4, 7
+        NP_FONT_8X13,                   // u8g2_font_8x13_tf - styl 5
+        NP_FONT_SPLEEN,                 // spleen6x12PL - przewijanie stylów 11, 12
+        NP_FONT_COUNT
+    };
+    struct NowPlaying {
+        String path;                    // ścieżka, dla której policzono model ("" = brak utworu)
+        String title;                   // "Wykonawca - Tytuł" z biblioteki albo nazwa pliku
+        String titleTop;                // górny pasek INFO_TRACK_TITLE - obcięty do 250 px + "..."
+        String titleShort;              // styl 11 (helvB14) - max 15 znaków
+        String titleLine;               // styl 13 - max 35 znaków
+        String titleLarge;              // styl 14 (UnnamedDOSFontIV) - max 20 znaków
+        char format[8];                 // MP3 / FLAC / ... ("" = nieznany)
+        char formatShort[5];            // format obcięty do 4 znaków (styl 12)
+        uint32_t durationSec;           // czas z biblioteki, 0 = nieznany
+        bool tagged;                    // tytuł z tagów (false = nazwa pliku, ponowne zapytanie)
+        unsigned long lookupTime;
+        int16_t width[NP_FONT_COUNT];   // szerokość tytułu w każdej czcionce [px]
+        int16_t titleTopWidth;          // 6x10
+        int16_t titleLargeWidth;        // UnnamedDOSFontIV
+        int16_t titlePadWidth;          // spleen, tytuł + 4 spacje (pasek przewijania stylu 14)
+        int16_t formatWidth;            // 6x10
+        uint32_t scroll;                // przewinięcie tytułu [px] - +1 co klatkę, 0 przy zmianie utworu
+        uint32_t version;               // +1 przy każdym przeliczeniu modelu
+    };
+    NowPlaying _np;
+    uint32_t _npTrackGen;               // generacja utworu w SDPlayerWebUI przy ostatnim modelu
+    uint32_t _stateVersion;             // wersja PlayerState przy ostatniej synchronizacji kursora
+    uint8_t _cover[MEDIA_COVER_BYTES];  // okładka bieżącego utworu (XBM 64x64) - kopia z CoverArt
+    bool _coverValid;
+    uint32_t _coverGen;                 // generacja okładek w CoverArt przy ostatniej kopii
     int _selectedIndex;
     int _scrollOffset;
     
@@ -121,7 +166,6 @@ private:
     bool _encoderButtonPressed;
     
     // Animacje
-    int _scrollPosition;
     int _animFrame;
     int _scrollTextOffset;        // Offset scrollowania tekstu w liście
     unsigned long _lastScrollTime; // Timer scrollowania tekstu
@@ -132,7 +176,50 @@ private:
     bool _showActionMessage;       // Czy pokazywać komunikat
     
     // Odświeżanie listy plików
-    void refreshFileList();
+    void refreshFileList();             // nowy katalog - kursor na początek
+    void syncFileList();                // wykrycie zmian listy (wgranie / usunięcie pliku)
+    const FileEntry& fileAt(int index); // wpis z okna, doczytanie okna gdy poza nim
+    void syncNowPlaying();              // model NowPlaying po zmianie utworu / tagów
+    void buildNowPlaying(bool changed); // tytuł, format, szerokości i wersje skrócone
+    // Tekst modelu albo tekst zastępczy, gdy nic nie gra
+    const char* npText(const String& text, const char* idleText) const {
+        return _np.title.length() ? text.c_str() : idleText;
+    }
+    // Szerokość z modelu albo tekstu zastępczego (w bieżącej czcionce)
+    int npWidth(int width, const char* idleText) {
+        return _np.title.length() ? width : _display.getStrWidth(idleText);
+    }
+    // Przesunięcie przewijanego tytułu dla cyklu tekst + odstęp [px]
+    int npScroll(int period) const { return period > 0 ? _np.scroll % period : 0; }
+    
+    // Czas rysowania klatki per styl (bez wysyłki bufora) - log przy zmianie stylu / wyjściu
+    struct RenderStat {
+        uint32_t frames;
+        uint32_t totalUs;
+        uint32_t maxUs;
+    };
+    static const int RENDER_STAT_SLOTS = STYLE_14 + 1;
+    RenderStat _renderStats[RENDER_STAT_SLOTS];
+    void logRenderStats();
+    
+    // Klucz narysowanej klatki - style statyczne rysowane tylko po jego zmianie
+    struct FrameKey {
+        uint32_t stateVersion;          // PlayerState (transport, utwór, głośność, indeks)
+        uint32_t npVersion;             // model NowPlaying (tagi doczytane w tle)
+        uint32_t listGen;
+        uint32_t coverGen;
+        int32_t selectedIndex;
+        int32_t scrollOffset;
+        int32_t fileCount;
+        uint8_t mode;
+        uint8_t style;
+        uint8_t infoStyle;
+    };
+    FrameKey _frameKey;
+    bool _frameValid;                   // false = następna klatka rysowana bez porównania
+    uint32_t _framesSkipped;            // klatki pominięte bez zmian (log ze statystykami)
+    void frameKey(FrameKey* key);
+    bool frameAnimated() const;         // analizator / zegar / przewijany tytuł - rysowanie co klatkę
     
     // Renderowanie
     void render();
@@ -143,7 +230,7 @@ private:
     void renderStyle3();  // VU meter
     void renderStyle4();  // Spektrum
     void renderStyle5();  // Minimal
-    void renderStyle6();  // Album art
+    void renderStyle6();  // Okładka albumu
     void renderStyle7();  // Analizator retro
     void renderStyle10(); // Full screen animated
     void renderStyle11(); // Radio Mode 0 - podstawowy
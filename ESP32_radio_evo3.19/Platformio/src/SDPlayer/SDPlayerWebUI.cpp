@@ -1,6 +1,14 @@
 #include "SDPlayerWebUI.h"
 #include "Audio.h"
+#include "AudioTask.h"   // Polecenia dla dekodera przez kolejkę (wątek WWW != wątek audio)
+#include "Crossfade.h"   // Gapless / przenikanie między utworami
+#include "ReplayGain.h"  // Wyrównanie głośności utworów
 #include "SDPlayerOLED.h"
+#include "MediaLibrary.h"   // Tagi (tytuł / wykonawca) i przeglądanie biblioteki
+#include "Playlist.h"       // Kolejka M3U / PLS, losowanie, powtarzanie, pozycje wznowienia
+#include "CoverArt.h"       // Okładki albumów 64x64 (statystyki dekodowania)
+#include "SeekIndex.h"      // Pozycja i przewijanie przez tablice z nagłówków plików
+#include <memory>
 
 SDPlayerWebUI::SDPlayerWebUI() 
     : _server(nullptr),
@@ -8,11 +16,19 @@ SDPlayerWebUI::SDPlayerWebUI()
       _oled(nullptr),
       _exitCallback(nullptr),
       _currentDir("/"),
-      _currentFile("None"),
-      _volume(7),
-      _isPlaying(false),
-      _isPaused(false),
-      _selectedIndex(-1) {
+      _ws("/sdplayer/ws"),
+      _wsVersion(0),
+      _wsDirGen(0),
+      _wsCleanupTime(0),
+      _wsSeekGen(0),
+      _seekTrackGen(0),
+      _armedIndex(-1),
+      _autoAdvance(false),
+      _pausedAt(0) {
+    strcpy(_webDir, "/");
+    _armedPath[0] = '\0';
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+    _cmdQueue = xQueueCreate(SDPLAYER_CMD_QUEUE_LENGTH, sizeof(sdplayer_cmd_msg_t));
 }
 
 void SDPlayerWebUI::begin(AsyncWebServer* server, Audio* audioPtr) {
@@ -24,6 +40,13 @@ void SDPlayerWebUI::begin(AsyncWebServer* server, Audio* audioPtr) {
     // WAŻNE: API endpoints NAJPIERW - muszą być przed /sdplayer
     // ESPAsyncWebServer dopasowuje pierwszy pasujący route
     
+    // WebSocket stanu odtwarzacza - przed /sdplayer (ten dopasowałby też /sdplayer/ws)
+    _ws.onEvent([this](AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                       void* arg, uint8_t* data, size_t len) {
+        if (type == WS_EVT_CONNECT) client->text(stateJson());   // pełny stan od razu po połączeniu
+    });
+    _server->addHandler(&_ws);
+    
     _server->on("/sdplayer/api/list", HTTP_GET, [this](AsyncWebServerRequest *request){
         // Serial.println("SDPlayerWebUI: /sdplayer/api/list requested");
         this->handleList(request);
@@ -71,13 +94,45 @@ void SDPlayerWebUI::begin(AsyncWebServer* server, Audio* audioPtr) {
         this->handleBack(request);
     });
     
+    _server->on("/sdplayer/api/transition", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleTransition(request);
+    });
+    
+    _server->on("/sdplayer/api/index", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleIndex(request);
+    });
+    
+    _server->on("/sdplayer/api/cover", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleCover(request);
+    });
+    
+    _server->on("/sdplayer/api/library", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleLibrary(request);
+    });
+    
+    _server->on("/sdplayer/api/playPath", HTTP_POST, [this](AsyncWebServerRequest *request){
+        this->handlePlayPath(request);
+    });
+    
+    _server->on("/sdplayer/api/playlist", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handlePlaylist(request);
+    });
+    
+    _server->on("/sdplayer/api/seek", HTTP_POST, [this](AsyncWebServerRequest *request){
+        this->handleSeek(request);
+    });
+    
+    _server->on("/sdplayer/api/seek", HTTP_GET, [this](AsyncWebServerRequest *request){
+        this->handleSeek(request);
+    });
+    
     // Główna strona SD Player - NA KOŃCU!
     _server->on("/sdplayer", HTTP_GET, [this](AsyncWebServerRequest *request){
         // Serial.println("SDPlayerWebUI: /sdplayer requested");
         this->handleRoot(request);
     });
     
-    // Inicjalizacja
+    // Inicjalizacja (dir_index_init() w setup())
     if (!SD.begin()) {
         // Serial.println("SD Card initialization failed!");
     } else {
@@ -113,236 +168,625 @@ void SDPlayerWebUI::handleRoot(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: HTML sent");
 }
 
+// ======================= LISTA STRONAMI (odpowiedź chunked) =======================
+
+// Stan jednej odpowiedzi /sdplayer/api/list - stały rozmiar niezależnie od liczby plików
+struct ListStream {
+    String   dir;
+    uint32_t gen;        // wersja listy - skan w trakcie wysyłania kończy stronę wcześniej
+    int32_t  first;
+    int32_t  pos;
+    int32_t  end;
+    int32_t  total;
+    bool     itemsDone;
+    bool     finished;
+    bool     lastDir;
+    char     lastName[DIR_NAME_LENGTH + 1];
+    size_t   pendLen;    // przygotowany fragment JSON i ile z niego już wysłano
+    size_t   pendOff;
+    char     pend[2048];
+};
+
+// Tekst do JSON - cudzysłów, backslash, bez znaków sterujących (jak jsonEscape() w main.cpp)
+static void list_add(ListStream* st, const char* text, bool escape)
+{
+    for (; *text && st->pendLen + 3 < sizeof(st->pend); text++) {
+        if (escape && (*text == '"' || *text == '\\')) {
+            st->pend[st->pendLen++] = '\\';
+            st->pend[st->pendLen++] = *text;
+        } else if (!escape || (uint8_t)*text >= 0x20) {
+            st->pend[st->pendLen++] = *text;
+        }
+    }
+    st->pend[st->pendLen] = '\0';
+}
+
+// Następny fragment: wpisy (ile zmieści bufor), potem stopka z kursorem. false = koniec
+static bool list_next(ListStream* st)
+{
+    st->pendLen = 0;
+    st->pendOff = 0;
+    if (st->finished) return false;
+
+    char num[16];
+    dir_entry_t item;
+    while (!st->itemsDone && st->pendLen + 2 * DIR_NAME_LENGTH + 48 < sizeof(st->pend)) {
+        if (st->pos >= st->end ||
+            dir_index_generation(st->dir.c_str()) != st->gen ||
+            !dir_index_get(st->dir.c_str(), st->pos, &item)) {
+            st->itemsDone = true;
+            break;
+        }
+        bool isDir = item.type == DIR_TYPE_DIR;
+        snprintf(num, sizeof(num), "%ld", (long)st->pos);
+        list_add(st, st->pos > st->first ? ",{\"i\":" : "{\"i\":", false);
+        list_add(st, num, false);
+        list_add(st, ",\"n\":\"", false);
+        list_add(st, item.name, true);
+        list_add(st, isDir ? "\",\"d\":true}" : "\",\"d\":false}", false);
+        st->lastDir = isDir;
+        strcpy(st->lastName, item.name);
+        st->pos++;
+    }
+    if (!st->itemsDone) return true;
+
+    // Stopka - kursor następnej strony (typ + nazwa ostatniego wpisu)
+    list_add(st, "],\"next\":", false);
+    if (st->pos > st->first && st->pos < st->total) {
+        list_add(st, st->lastDir ? "\"d:" : "\"f:", false);
+        list_add(st, st->lastName, true);
+        list_add(st, "\"}", false);
+    } else {
+        list_add(st, "null}", false);
+    }
+    st->finished = true;
+    return true;
+}
+
 void SDPlayerWebUI::handleList(AsyncWebServerRequest *request) {
     // Serial.println("========================================");
     // Serial.println("SDPlayerWebUI: handleList called");
     // Serial.printf("SDPlayerWebUI: Request URL: %s\n", request->url().c_str());
     // Serial.println("========================================");
-    scanCurrentDirectory();
-    
-    DynamicJsonDocument doc(4096);
-    doc["cwd"] = _currentDir;
-    doc["now"] = _currentFile;
+    // Bez skanowania - lista z indeksu katalogów (odczyt z karty tylko po unieważnieniu)
+    String dir = webDir();
+    int32_t total = dir_index_open(dir.c_str());
+    if (total < 0) total = 0;
     
-    // Status odtwarzania
-    if (_isPaused) {
-        doc["status"] = "Paused";
-    } else if (_isPlaying) {
-        doc["status"] = "Playing";
-    } else {
-        doc["status"] = "Stopped";
+    int32_t offset = 0;
+    int32_t limit = SDPLAYER_PAGE_DEFAULT;
+    if (request->hasParam("limit")) {
+        limit = request->getParam("limit")->value().toInt();
+        if (limit < 0) limit = 0;
+        if (limit > SDPLAYER_PAGE_MAX) limit = SDPLAYER_PAGE_MAX;
     }
-    
-    // Synchronizuj volume z globalnym Audio
-    if (_audio) {
-        _volume = _audio->getVolume();
+    if (request->hasParam("cursor")) {
+        // "d:nazwa" / "f:nazwa" - pierwszy wpis za ostatnim z poprzedniej strony
+        String cursor = request->getParam("cursor")->value();
+        if (cursor.length() > 2 && cursor[1] == ':') {
+            offset = dir_index_seek(dir.c_str(), cursor[0] == 'd', cursor.c_str() + 2);
+        }
+    } else if (request->hasParam("offset")) {
+        offset = request->getParam("offset")->value().toInt();
     }
-    doc["vol"] = _volume;
+    if (offset < 0) offset = 0;
+    if (offset > total) offset = total;
     
-    JsonArray items = doc.createNestedArray("items");
-    buildFileList(items);
+    std::shared_ptr<ListStream> st = std::make_shared<ListStream>();
+    st->dir = dir;
+    st->gen = dir_index_generation(dir.c_str());
+    st->first = offset;
+    st->pos = offset;
+    st->end = offset + limit < total ? offset + limit : total;
+    st->total = total;
+    st->itemsDone = false;
+    st->finished = false;
+    st->lastDir = false;
+    st->lastName[0] = '\0';
+    st->pendLen = 0;
+    st->pendOff = 0;
     
-    String response;
-    serializeJson(doc, response);
-    // Serial.println("SDPlayerWebUI: Sending JSON: " + response);
-    request->send(200, "application/json", response);
+    // Nagłówek: status odtwarzacza i parametry strony
+    char num[192];
+    char now[PLAYER_STATE_PATH_LENGTH + 1];
+    player_state_path(now, sizeof(now));
+    list_add(st.get(), "{\"cwd\":\"", false);
+    list_add(st.get(), dir.c_str(), true);
+    list_add(st.get(), "\",\"now\":\"", false);
+    list_add(st.get(), now[0] ? now : "None", true);
+    media_info_t info;
+    if (now[0] && media_lib_lookup(now, &info) && info.title[0]) {
+        list_add(st.get(), "\",\"title\":\"", false);
+        list_add(st.get(), info.title, true);
+        list_add(st.get(), "\",\"artist\":\"", false);
+        list_add(st.get(), info.artist, true);
+    }
+    snprintf(num, sizeof(num), "\",\"status\":\"%s\",\"vol\":%d,\"pos\":%lu,\"dur\":%lu,\"total\":%ld,\"offset\":%ld,\"limit\":%ld,\"gen\":%lu,\"items\":[",
+             player_state_transport_name(player_state_transport()), player_state_volume(),
+             (unsigned long)positionSec(), (unsigned long)durationSec(),
+             (long)total, (long)offset, (long)limit, (unsigned long)st->gen);
+    list_add(st.get(), num, false);
+    
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+        [st](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t len = 0;
+            while (len < maxLen) {
+                if (st->pendOff >= st->pendLen && !list_next(st.get())) break;
+                size_t n = st->pendLen - st->pendOff;
+                if (n > maxLen - len) n = maxLen - len;
+                memcpy(buffer + len, st->pend + st->pendOff, n);
+                st->pendOff += n;
+                len += n;
+            }
+            return len;   // 0 = koniec odpowiedzi
+        });
+    request->send(response);
+}
+
+// Polecenie do loop() - odpowiedź od razu, nowy stan dociera przez WebSocket
+bool SDPlayerWebUI::post(AsyncWebServerRequest *request, uint8_t cmd, int32_t value, const char* path) {
+    sdplayer_cmd_msg_t msg;
+    msg.cmd = cmd;
+    msg.value = value;
+    strlcpy(msg.path, path ? path : "", sizeof(msg.path));
+    if (!_cmdQueue || xQueueSend(_cmdQueue, &msg, 0) != pdTRUE) {
+        if (request) request->send(503, "text/plain", "Busy");
+        return false;
+    }
+    if (request) request->send(200, "text/plain", "OK");
+    return true;
+}
+
+void SDPlayerWebUI::execute(const sdplayer_cmd_msg_t& msg) {
+    switch (msg.cmd) {
+        case SDPLAYER_CMD_PLAY:
+            playIndex(msg.value);
+            break;
+        case SDPLAYER_CMD_PLAY_SELECTED: {
+            int selected = player_state_index();
+            if (selected >= 0 && selected < fileCount()) playIndex(selected);
+            break;
+        }
+        case SDPLAYER_CMD_PAUSE:       pause(); break;
+        case SDPLAYER_CMD_STOP:        stop(); break;
+        case SDPLAYER_CMD_NEXT:        next(); break;
+        case SDPLAYER_CMD_PREV:        prev(); break;
+        case SDPLAYER_CMD_VOLUME:      setVolume(msg.value); break;
+        case SDPLAYER_CMD_CD:          changeDirectory(String(msg.path)); break;
+        case SDPLAYER_CMD_UP:          upDirectory(); break;
+        case SDPLAYER_CMD_PLAY_PATH:   playPath(String(msg.path)); break;
+        case SDPLAYER_CMD_SEEK:        seek(msg.value); break;
+        case SDPLAYER_CMD_PLAYLIST_AT: playPlaylistAt(msg.value); break;
+        case SDPLAYER_CMD_REARM:       armNext(); break;
+        case SDPLAYER_CMD_BACK:
+            // Zatrzymaj odtwarzanie przed wyjściem
+            stop();
+            
+            // Deaktywuj OLED display
+            if (_oled && _oled->isActive()) {
+                _oled->deactivate();
+                // Serial.println("SDPlayerWebUI: OLED deactivated");
+            }
+            
+            if (_exitCallback) {
+                _exitCallback();
+            }
+            break;
+    }
 }
 
 void SDPlayerWebUI::handlePlay(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handlePlay called");
-    if (request->hasParam("i")) {
-        int idx = request->getParam("i")->value().toInt();
-        // Serial.printf("Playing index: %d\n", idx);
-        playIndex(idx);
+    if (!request->hasParam("i")) {
+        request->send(200, "text/plain", "OK");
+        return;
     }
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_PLAY, request->getParam("i")->value().toInt());
 }
 
 void SDPlayerWebUI::handlePlaySelected(AsyncWebServerRequest *request) {
-    // Serial.printf("SDPlayerWebUI: handlePlaySelected called, index=%d, listSize=%d\n", _selectedIndex, _fileList.size());
-    if (_selectedIndex >= 0 && _selectedIndex < _fileList.size()) {
-        playIndex(_selectedIndex);
-    } else {
-        // Serial.println("SDPlayerWebUI: No file selected or invalid index");
-    }
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_PLAY_SELECTED);
 }
 
 void SDPlayerWebUI::handlePause(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handlePause called");
-    pause();
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_PAUSE);
 }
 
 void SDPlayerWebUI::handleStop(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handleStop called");
-    stop();
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_STOP);
 }
 
 void SDPlayerWebUI::handleNext(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handleNext called");
-    next();
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_NEXT);
 }
 
 void SDPlayerWebUI::handlePrev(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handlePrev called");
-    prev();
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_PREV);
 }
 
 void SDPlayerWebUI::handleVol(AsyncWebServerRequest *request) {
-    if (request->hasParam("v")) {
-        int vol = request->getParam("v")->value().toInt();
-        setVolume(vol);
+    if (!request->hasParam("v")) {
+        request->send(200, "text/plain", "OK");
+        return;
     }
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_VOLUME, request->getParam("v")->value().toInt());
 }
 
 void SDPlayerWebUI::handleCd(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handleCd called");
-    if (request->hasParam("p")) {
-        String path = request->getParam("p")->value();
-        // Serial.println("Changing directory to: " + path);
-        changeDirectory(path);
+    if (!request->hasParam("p")) {
+        request->send(200, "text/plain", "OK");
+        return;
     }
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_CD, 0, request->getParam("p")->value().c_str());
 }
 
 void SDPlayerWebUI::handleUp(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handleUp called");
-    upDirectory();
-    request->send(200, "text/plain", "OK");
+    post(request, SDPLAYER_CMD_UP);
 }
 
 void SDPlayerWebUI::handleBack(AsyncWebServerRequest *request) {
     // Serial.println("SDPlayerWebUI: handleBack called - stopping playback");
+    post(request, SDPLAYER_CMD_BACK);
+}
+
+void SDPlayerWebUI::handleTransition(AsyncWebServerRequest *request) {
+    xfade_status_t st;
+    xfade_get_status(&st);
+    
+    DynamicJsonDocument doc(768);
+    doc["gapless"] = st.gapless;
+    doc["crossfade_sec"] = st.seconds;
+    char armed[PLAYER_STATE_PATH_LENGTH + 1];
+    portENTER_CRITICAL(&_mux);
+    strcpy(armed, _armedPath);
+    portEXIT_CRITICAL(&_mux);
+    doc["next"] = armed;
+    doc["next_compatible"] = st.nextCompatible;
+    doc["delay_frames"] = st.delayFrames;
+    doc["transitions"] = st.transitions;
+    doc["gap_last"] = st.lastGapSamples;
+    doc["gap_avg"] = st.avgGapSamples;
+    doc["gap_max"] = st.maxGapSamples;
+    doc["gap_rate"] = st.lastGapRate;
+    doc["crossfades"] = st.crossfades;
+    doc["fade_last_frames"] = st.lastFadeFrames;
+    doc["tails_dropped"] = st.tailsDropped;
+    doc["trimmed_frames"] = st.trimmedFrames;
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void SDPlayerWebUI::handleIndex(AsyncWebServerRequest *request) {
+    dir_index_stats_t st;
+    dir_index_get_stats(&st);
+    uint32_t lookups = st.hits + st.misses;
+    
+    String dir = webDir();
+    int32_t entries = dir_index_open(dir.c_str());
+    
+    DynamicJsonDocument doc(512);
+    doc["cwd"] = dir;
+    doc["entries"] = entries > 0 ? entries : 0;
+    doc["scans"] = st.scans;
+    doc["hits"] = st.hits;
+    doc["misses"] = st.misses;
+    doc["hit_rate"] = lookups ? (st.hits * 100UL) / lookups : 0;
+    doc["invalidations"] = st.invalidations;
+    doc["scan_last_ms"] = st.lastScanMs;
+    doc["scan_avg_ms"] = st.avgScanMs;
+    doc["scan_max_ms"] = st.maxScanMs;
+    doc["scan_last_entries"] = st.lastScanEntries;
+    doc["skipped"] = st.skipped;
+    doc["cached_dirs"] = st.cachedDirs;
+    doc["bytes"] = st.arenaBytes;
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+void SDPlayerWebUI::handleCover(AsyncWebServerRequest *request) {
+    cover_art_status_t st;
+    cover_art_get_status(&st);
+    uint8_t bitmap[MEDIA_COVER_BYTES];
+    
+    char path[PLAYER_STATE_PATH_LENGTH + 1];
+    player_state_path(path, sizeof(path));
     
-    // Zatrzymaj odtwarzanie przed wyjściem
-    stop();
+    DynamicJsonDocument doc(512);
+    doc["current"] = cover_art_get(path, bitmap);
+    doc["covers"] = st.covers;
+    doc["decoded"] = st.decoded;
+    doc["cache_hits"] = st.cacheHits;
+    doc["failed"] = st.failed;
+    doc["no_source"] = st.noSource;
+    doc["last_format"] = cover_art_format_name(st.lastFormat);
+    doc["last_result"] = cover_art_result_name(st.lastResult);
+    doc["last_width"] = st.lastWidth;
+    doc["last_height"] = st.lastHeight;
+    doc["decode_last_ms"] = st.lastDecodeMs;
+    doc["decode_max_ms"] = st.maxDecodeMs;
+    doc["peak_last_bytes"] = st.lastPeakBytes;
+    doc["peak_max_bytes"] = st.maxPeakBytes;
     
-    // Deaktywuj OLED display
-    if (_oled && _oled->isActive()) {
-        _oled->deactivate();
-        // Serial.println("SDPlayerWebUI: OLED deactivated");
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// POST ?s= przewinięcie [s]; GET tablica bieżącego utworu i opóźnienie przewijania per format
+void SDPlayerWebUI::handleSeek(AsyncWebServerRequest *request) {
+    if (request->method() == HTTP_POST) {
+        if (!request->hasParam("s")) {
+            request->send(400, "text/plain", "Missing s");
+            return;
+        }
+        post(request, SDPLAYER_CMD_SEEK, request->getParam("s")->value().toInt());
+        return;
     }
     
-    if (_exitCallback) {
-        _exitCallback();
+    seek_index_status_t st;
+    seek_index_get_status(&st);
+    
+    DynamicJsonDocument doc(1024);
+    doc["position_ms"] = seek_index_position_ms();
+    doc["duration_ms"] = st.durationMs;
+    doc["ready"] = st.ready;
+    doc["format"] = seek_index_format_name(st.format);
+    doc["source"] = seek_index_source_name(st.source);
+    doc["points"] = st.points;
+    doc["tables"] = st.tables;
+    doc["built"] = st.built;
+    doc["cache_hits"] = st.cacheHits;
+    doc["failed"] = st.failed;
+    doc["build_last_ms"] = st.lastBuildMs;
+    doc["build_max_ms"] = st.maxBuildMs;
+    JsonObject latency = doc.createNestedObject("latency");
+    for (uint8_t i = 0; i < SEEK_FORMAT_COUNT; i++) {
+        JsonObject l = latency.createNestedObject(seek_index_format_name(i));
+        l["seeks"] = st.latency[i].seeks;
+        l["last_ms"] = st.latency[i].lastMs;
+        l["avg_ms"] = st.latency[i].avgMs;
+        l["max_ms"] = st.latency[i].maxMs;
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// ======================= BIBLIOTEKA =======================
+
+static void library_text(AsyncResponseStream* response, const char* text)
+{
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') { response->write('\\'); }
+        if ((uint8_t)*c >= 0x20) { response->write(*c); }
+    }
+}
+
+struct LibraryList {
+    AsyncResponseStream* response;
+    uint16_t count;
+};
+
+static void library_name(const char* name, uint16_t tracks, void* ctx)
+{
+    LibraryList* l = (LibraryList*)ctx;
+    l->response->print(l->count++ ? ",{\"n\":\"" : "{\"n\":\"");
+    library_text(l->response, name);
+    l->response->printf("\",\"t\":%u}", tracks);
+}
+
+static void library_track(const char* path, const media_info_t* info, void* ctx)
+{
+    LibraryList* l = (LibraryList*)ctx;
+    l->response->print(l->count++ ? ",{\"p\":\"" : "{\"p\":\"");
+    library_text(l->response, path);
+    l->response->print("\",\"t\":\"");
+    library_text(l->response, info->title);
+    l->response->printf("\",\"s\":%u,\"r\":%u}", (unsigned)info->durationSec, (unsigned)info->sampleRate);
+}
+
+// /sdplayer/api/library - wykonawcy, ?artist= albumy, ?artist=&album= utwory (+ offset / limit)
+void SDPlayerWebUI::handleLibrary(AsyncWebServerRequest *request) {
+    uint16_t offset = 0;
+    uint16_t limit = SDPLAYER_LIBRARY_MAX;
+    if (request->hasParam("offset")) offset = constrain(request->getParam("offset")->value().toInt(), 0, 65535);
+    if (request->hasParam("limit")) limit = constrain(request->getParam("limit")->value().toInt(), 1, SDPLAYER_LIBRARY_MAX);
+    
+    media_lib_status_t ms;
+    media_lib_get_status(&ms);
+    static const char* const STATES[] = { "idle", "scanning", "saving", "error" };
+    
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->printf("{\"state\":\"%s\",\"records\":%u,\"tagged\":%u,\"dirs\":%u,\"passes\":%u,\"last_pass_ms\":%u,"
+                     "\"files_per_s\":%u.%u,\"throttled\":%s,\"offset\":%u,",
+                     STATES[ms.state], (unsigned)ms.records, (unsigned)ms.tagged, (unsigned)ms.dirs, (unsigned)ms.passes,
+                     (unsigned)ms.lastPassMs, (unsigned)(ms.filesPerSec10 / 10), (unsigned)(ms.filesPerSec10 % 10),
+                     ms.throttled ? "true" : "false", offset);
+    
+    LibraryList l = { response, 0 };
+    uint16_t total = 0;
+    if (!request->hasParam("artist")) {
+        response->print("\"artists\":[");
+        media_lib_artists(offset, limit, &total, library_name, &l);
+    } else if (!request->hasParam("album")) {
+        response->print("\"albums\":[");
+        media_lib_albums(request->getParam("artist")->value().c_str(), offset, limit, &total, library_name, &l);
+    } else {
+        response->print("\"tracks\":[");
+        media_lib_tracks(request->getParam("artist")->value().c_str(), request->getParam("album")->value().c_str(),
+                         offset, limit, &total, library_track, &l);
+    }
+    response->printf("],\"total\":%u}", total);
+    request->send(response);
+}
+
+void SDPlayerWebUI::handlePlayPath(AsyncWebServerRequest *request) {
+    if (!request->hasParam("p")) {
+        request->send(400, "text/plain", "Missing p");
+        return;
+    }
+    post(request, SDPLAYER_CMD_PLAY_PATH, 0, request->getParam("p")->value().c_str());
+}
+
+void SDPlayerWebUI::playPath(const String& path) {
+    int slash = path.lastIndexOf('/');
+    if (slash < 0) return;
+    String dir = slash == 0 ? String("/") : path.substring(0, slash);
+    String name = path.substring(slash + 1);
+    
+    // Katalog pliku jako bieżący - następny / poprzedni i przejścia działają jak z listy
+    if (_currentDir != dir) changeDirectory(dir);
+    if (_currentDir == dir && dir_index_open(dir.c_str()) >= 0) {
+        int32_t after = dir_index_seek(dir.c_str(), false, name.c_str());
+        dir_entry_t entry;
+        if (after > 0 && dir_index_get(dir.c_str(), after - 1, &entry) &&
+            entry.type != DIR_TYPE_DIR && name == entry.name) {
+            playIndex(after - 1);
+            return;
+        }
     }
-    request->send(200, "text/plain", "OK");
+    playFile(path);   // plik spoza listy (np. za długa nazwa) - bez pozycji na liście
 }
 
 void SDPlayerWebUI::playFile(const String& path) {
-    _currentFile = path;
-    _isPlaying = true;
-    _isPaused = false;
+    if (!_autoAdvance) noteResume();   // przerwany utwór - pozycja do wznowienia
+    player_state_set_track(path.c_str());
     // Serial.println("SDPlayerWebUI: Playing file: " + path);
     
     if (_audio) {
-        _audio->stopSong();  // Zatrzymaj obecną muzykę
-        if (_audio->connecttoFS(SD, path.c_str())) {
+        audio_cmd_arm_next_file(nullptr);  // Poprzednio zgłoszony następny utwór nieaktualny
+        xfade_track_begin(_autoAdvance);   // Ręczny wybór odrzuca końcówkę w linii opóźniającej
+        rgain_select(path.c_str());
+        audio_cmd_stop();  // Zatrzymaj obecną muzykę
+        uint32_t startSec = playlist_resume_get(path.c_str());
+        if (startSec) Serial.printf("SDPlayerWebUI: Wznowienie od %u s\n", (unsigned)startSec);
+        if (audio_cmd_play_file_at(path.c_str(), startSec)) {
             // Serial.println("SDPlayerWebUI: Audio started playing from SD");
-            // Ustaw flagę globalną
-            extern bool sdPlayerPlayingMusic;
-            sdPlayerPlayingMusic = true;
+            player_state_set_transport(PLAYER_PLAYING);
+            armNext();
         } else {
             // Serial.println("SDPlayerWebUI: ERROR - Failed to play file!");
-            _isPlaying = false;
+            player_state_set_transport(PLAYER_STOPPED);
         }
     } else {
         // Serial.println("SDPlayerWebUI: ERROR - Audio pointer is NULL!");
+        player_state_set_transport(PLAYER_STOPPED);
     }
-    
-    // Aktualizuj OLED
-    if (_oled && _oled->isActive()) {
-        _oled->loop();  // Odśwież wyświetlacz
-    }
+    // OLED i strona - po zmianie wersji stanu (PlayerState)
 }
 
 void SDPlayerWebUI::playIndex(int index) {
-    if (index < 0 || index >= _fileList.size()) return;
+    dir_entry_t item;
+    if (!fileAt(index, &item)) return;
     
-    FileItem& item = _fileList[index];
-    if (item.isDir) {
+    if (item.type == DIR_TYPE_DIR) {
         // Jeśli to katalog, wejdź do niego
-        String newPath = _currentDir;
-        if (newPath != "/") newPath += "/";
-        newPath += item.name;
-        changeDirectory(newPath);
+        changeDirectory(filePath(item));
     } else {
-        // Jeśli to plik, odtwórz go
-        _selectedIndex = index;
-        String fullPath = _currentDir;
-        if (fullPath != "/") fullPath += "/";
-        fullPath += item.name;
-        playFile(fullPath);
+        // Jeśli to plik, odtwórz go - wybór z katalogu kończy sterowanie playlistą
+        playlist_set_active(false);
+        player_state_set_index(index);
+        playFile(filePath(item));
     }
 }
 
 void SDPlayerWebUI::pause() {
     if (_audio) {
-        _isPaused = !_isPaused;
+        uint8_t transport = player_state_transport();
+        if (transport == PLAYER_STOPPED) return;   // nic do wstrzymania
         
-        if (_isPaused) {
+        if (transport == PLAYER_PLAYING) {
             // PAUZA = STOP (bezpieczniejsze niż pauseResume() które crashuje FreeRTOS)
             Serial.println("SDPlayerWebUI: Paused (STOP)");
-            _audio->stopSong();
-            extern bool sdPlayerPlayingMusic;
-            sdPlayerPlayingMusic = false;
+            _pausedAt = positionSec();
+            noteResume();
+            audio_cmd_arm_next_file(nullptr);
+            xfade_track_begin(false);
+            audio_cmd_stop();
+            player_state_set_transport(PLAYER_PAUSED);
         } else {
-            // WZNOWIENIE = Odtwórz ten sam plik od nowa
-            Serial.println("SDPlayerWebUI: Resumed (RESTART)");
-            if (_selectedIndex >= 0 && _selectedIndex < _fileList.size()) {
-                FileItem& item = _fileList[_selectedIndex];
-                String fullPath = _currentDir;
-                if (fullPath != "/") fullPath += "/";
-                fullPath += item.name;
-                
-                _audio->stopSong();
-                if (_audio->connecttoFS(SD, fullPath.c_str())) {
-                    extern bool sdPlayerPlayingMusic;
-                    sdPlayerPlayingMusic = true;
+            // WZNOWIENIE = ten sam plik od miejsca pauzy
+            Serial.printf("SDPlayerWebUI: Resumed at %u s\n", (unsigned)_pausedAt);
+            char path[PLAYER_STATE_PATH_LENGTH + 1];
+            if (player_state_path(path, sizeof(path))) {
+                xfade_track_begin(false);
+                audio_cmd_stop();
+                if (audio_cmd_play_file_at(path, _pausedAt)) {
+                    player_state_set_transport(PLAYER_PLAYING);
+                    armNext();
                 }
             }
         }
-        
-        // Aktualizuj OLED
-        if (_oled && _oled->isActive()) {
-            _oled->loop();
-        }
     } else {
         Serial.println("SDPlayerWebUI: ERROR - Audio pointer is NULL!");
     }
 }
 
+void SDPlayerWebUI::seek(uint32_t sec) {
+    uint8_t transport = player_state_transport();
+    char path[PLAYER_STATE_PATH_LENGTH + 1];
+    if (!_audio || transport == PLAYER_STOPPED || !player_state_path(path, sizeof(path))) return;
+    
+    if (transport == PLAYER_PAUSED) {
+        _pausedAt = sec;   // wznowienie od nowej pozycji
+    } else {
+        seek_index_seek(path, sec * 1000);
+    }
+    player_state_position_changed();   // strona / OLED - nowa pozycja od razu
+}
+
+uint32_t SDPlayerWebUI::positionSec() {
+    switch (player_state_transport()) {
+        case PLAYER_PAUSED:  return _pausedAt;
+        case PLAYER_PLAYING: return seek_index_position_ms() / 1000;
+        default:             return 0;
+    }
+}
+
+uint32_t SDPlayerWebUI::durationSec() {
+    uint32_t ms = seek_index_duration_ms();
+    if (ms) return ms / 1000;
+    return _audio && player_state_playing() ? _audio->getAudioFileDuration() : 0;
+}
+
 void SDPlayerWebUI::stop() {
-    _isPlaying = false;
-    _isPaused = false;
-    _currentFile = "None";
+    noteResume();
     // Serial.println("SDPlayerWebUI: Stopped");
     
     if (_audio) {
-        _audio->stopSong();
-        // Resetuj flagę globalną
-        extern bool sdPlayerPlayingMusic;
-        sdPlayerPlayingMusic = false;
+        audio_cmd_arm_next_file(nullptr);
+        xfade_track_begin(false);
+        audio_cmd_stop();
     } else {
         // Serial.println("SDPlayerWebUI: ERROR - Audio pointer is NULL!");
     }
-    
-    // Aktualizuj OLED
-    if (_oled && _oled->isActive()) {
-        _oled->loop();
-    }
+    player_state_set_transport(PLAYER_STOPPED);
+    player_state_set_track("");
 }
 
 void SDPlayerWebUI::next() {
-    if (_selectedIndex < _fileList.size() - 1) {
+    if (playlist_is_active()) {
+        playPlaylistStep(1, false);
+        return;
+    }
+    int count = fileCount();
+    int selected = player_state_index();
+    dir_entry_t item;
+    if (selected < count - 1) {
         // Znajdź następny plik audio (pomiń katalogi)
-        for (int i = _selectedIndex + 1; i < _fileList.size(); i++) {
-            if (!_fileList[i].isDir) {
+        for (int i = selected + 1; i < count; i++) {
+            if (fileAt(i, &item) && item.type != DIR_TYPE_DIR) {
                 playIndex(i);
                 break;
             }
@@ -351,10 +795,16 @@ void SDPlayerWebUI::next() {
 }
 
 void SDPlayerWebUI::prev() {
-    if (_selectedIndex > 0) {
+    if (playlist_is_active()) {
+        playPlaylistStep(-1, false);
+        return;
+    }
+    int selected = player_state_index();
+    dir_entry_t item;
+    if (selected > 0) {
         // Znajdź poprzedni plik audio (pomiń katalogi)
-        for (int i = _selectedIndex - 1; i >= 0; i--) {
-            if (!_fileList[i].isDir) {
+        for (int i = selected - 1; i >= 0; i--) {
+            if (fileAt(i, &item) && item.type != DIR_TYPE_DIR) {
                 playIndex(i);
                 break;
             }
@@ -362,13 +812,89 @@ void SDPlayerWebUI::prev() {
     }
 }
 
+int SDPlayerWebUI::nextAudioIndex() {
+    int count = fileCount();
+    int selected = player_state_index();
+    dir_entry_t item;
+    for (int step = 1; step <= count; step++) {
+        int i = (selected + step) % count;
+        if (i >= 0 && fileAt(i, &item) && item.type != DIR_TYPE_DIR) return i;
+    }
+    return -1;
+}
+
+void SDPlayerWebUI::armNext() {
+    _armedIndex = -1;
+    portENTER_CRITICAL(&_mux);
+    _armedPath[0] = '\0';
+    portEXIT_CRITICAL(&_mux);
+    if (!xfade_gapless_enabled()) return;
+    
+    int next;
+    String path;
+    if (playlist_is_active()) {
+        // Następny wg kolejności playlisty (losowanie / powtarzanie); pozycja wznowienia - zwykły start
+        char entry[PLAYLIST_PATH_LENGTH + 1];
+        next = playlist_peek(1, true);
+        if (next < 0 || !playlist_path_at(next, entry, sizeof(entry)) || playlist_resume_get(entry)) return;
+        path = entry;
+    } else {
+        if (player_state_index() < 0) return;
+        next = nextAudioIndex();
+        dir_entry_t item;
+        if (next < 0 || !fileAt(next, &item)) return;
+        path = filePath(item);
+    }
+    
+    // Nagłówki obu plików - przenikanie tylko przy tej samej częstotliwości próbkowania
+    char current[PLAYER_STATE_PATH_LENGTH + 1];
+    player_state_path(current, sizeof(current));
+    xfade_prepare_next(current, path.c_str());
+    rgain_prepare_next(path.c_str());   // przed zgłoszeniem - dekoder tylko podmienia wzmocnienie
+    audio_cmd_arm_next_file(path.c_str());
+    _armedIndex = next;
+    portENTER_CRITICAL(&_mux);
+    strlcpy(_armedPath, path.c_str(), sizeof(_armedPath));
+    portEXIT_CRITICAL(&_mux);
+}
+
 void SDPlayerWebUI::playNextAuto() {
+    // Gapless - następny utwór wystartował już przy końcu pliku, tylko przejmujemy stan
+    uint8_t armed = audio_task_take_next_file();
+    char current[PLAYER_STATE_PATH_LENGTH + 1];
+    player_state_path(current, sizeof(current));
+    playlist_resume_forget(current);   // odtworzony do końca
+    bool listMode = playlist_is_active();
+    if (armed == AUDIO_NEXT_STARTED && _armedIndex >= 0 && (listMode || _armedIndex < fileCount())) {
+        if (listMode) playlist_set_position(_armedIndex);
+        else player_state_set_index(_armedIndex);
+        player_state_set_track(_armedPath);   // _armedPath zmienia tylko loop() - odczyt bez blokady
+        player_state_set_transport(PLAYER_PLAYING);
+        Serial.println("[SDPlayer] Auto-play (gapless): Następny utwór #" + String(player_state_index()));
+        armNext();
+        return;
+    }
+    
     // Automatyczne odtwarzanie następnego utworu po zakończeniu obecnego
-    if (_selectedIndex < _fileList.size() - 1) {
+    _autoAdvance = true;
+    if (listMode) {
+        if (!playPlaylistStep(1, true)) {
+            Serial.println("[SDPlayer] Auto-play: Koniec playlisty");
+            _autoAdvance = false;
+            stop();
+            return;
+        }
+        _autoAdvance = false;
+        return;
+    }
+    int count = fileCount();
+    int selected = player_state_index();
+    dir_entry_t item;
+    if (selected < count - 1) {
         // Znajdź następny plik audio (pomiń katalogi)
         bool foundNext = false;
-        for (int i = _selectedIndex + 1; i < _fileList.size(); i++) {
-            if (!_fileList[i].isDir) {
+        for (int i = selected + 1; i < count; i++) {
+            if (fileAt(i, &item) && item.type != DIR_TYPE_DIR) {
                 playIndex(i);
                 foundNext = true;
                 Serial.println("[SDPlayer] Auto-play: Następny utwór #" + String(i));
@@ -379,8 +905,8 @@ void SDPlayerWebUI::playNextAuto() {
         // Jeśli nie znaleziono następnego, wróć na początek listy
         if (!foundNext) {
             // Znajdź pierwszy plik audio od początku
-            for (int i = 0; i < _fileList.size(); i++) {
-                if (!_fileList[i].isDir) {
+            for (int i = 0; i < count; i++) {
+                if (fileAt(i, &item) && item.type != DIR_TYPE_DIR) {
                     playIndex(i);
                     Serial.println("[SDPlayer] Auto-play: Koniec listy - powrót na początek, utwór #" + String(i));
                     break;
@@ -389,46 +915,256 @@ void SDPlayerWebUI::playNextAuto() {
         }
     } else {
         // Koniec listy - wróć na początek
-        for (int i = 0; i < _fileList.size(); i++) {
-            if (!_fileList[i].isDir) {
+        for (int i = 0; i < count; i++) {
+            if (fileAt(i, &item) && item.type != DIR_TYPE_DIR) {
                 playIndex(i);
                 Serial.println("[SDPlayer] Auto-play: Koniec listy - powrót na początek, utwór #" + String(i));
                 break;
             }
         }
     }
+    _autoAdvance = false;
+}
+
+// ======================= PLAYLISTA =======================
+
+void SDPlayerWebUI::noteResume() {
+    uint8_t transport = player_state_transport();
+    char path[PLAYER_STATE_PATH_LENGTH + 1];
+    if (!_audio || transport == PLAYER_STOPPED || !player_state_path(path, sizeof(path))) return;
+    playlist_resume_note(path, positionSec(), durationSec());
+}
+
+// Krok playlisty (wpisy spoza biblioteki pomijane), false = koniec listy / brak odtwarzalnych
+bool SDPlayerWebUI::playPlaylistStep(int8_t step, bool automatic) {
+    playlist_status_t ps;
+    playlist_get_status(&ps);
+    char path[PLAYLIST_PATH_LENGTH + 1];
+    for (uint16_t attempt = 0; attempt < ps.count; attempt++) {
+        int32_t pos = playlist_peek(step, automatic && attempt == 0);
+        if (pos < 0) return false;
+        playlist_set_position(pos);
+        if (playlist_path_at(pos, path, sizeof(path))) {
+            playFile(String(path));
+            return true;
+        }
+        if (automatic && pos == (int32_t)ps.count - 1 && ps.repeat != PLAYLIST_REPEAT_ALL) return false;
+    }
+    return false;
+}
+
+void SDPlayerWebUI::playPlaylistAt(uint16_t position) {
+    char path[PLAYLIST_PATH_LENGTH + 1];
+    playlist_set_active(true);
+    playlist_set_position(position);
+    if (playlist_path_at(playlist_position(), path, sizeof(path))) {
+        playFile(String(path));
+    } else {
+        playPlaylistStep(1, false);   // wpis spoza biblioteki - następny odtwarzalny
+    }
+}
+
+struct PlaylistList {
+    AsyncResponseStream* response;
+    uint16_t count;
+};
+
+static void playlist_entry(uint16_t position, const char* path, void* ctx)
+{
+    PlaylistList* l = (PlaylistList*)ctx;
+    l->response->printf(l->count++ ? ",{\"i\":%u,\"p\":\"" : "{\"i\":%u,\"p\":\"", position);
+    library_text(l->response, path);
+    l->response->print("\"}");
+}
+
+// Pliki playlist w katalogu (PLAYLIST_DIR i bieżący katalog odtwarzacza)
+static void playlist_files(AsyncResponseStream* response, const char* dir, uint16_t* count)
+{
+    File root = SD.open(dir);
+    if (!root || !root.isDirectory()) return;
+    bool isDir = false;
+    String full = root.getNextFileName(&isDir);
+    while (full.length() > 0 && *count < SDPLAYER_LIBRARY_MAX) {
+        const char* ext = strrchr(full.c_str(), '.');
+        if (!isDir && ext && (strcasecmp(ext, ".m3u") == 0 || strcasecmp(ext, ".m3u8") == 0 || strcasecmp(ext, ".pls") == 0)) {
+            response->print((*count)++ ? ",\"" : "\"");
+            library_text(response, full.c_str());
+            response->print("\"");
+        }
+        full = root.getNextFileName(&isDir);
+    }
+    root.close();
+}
+
+// /sdplayer/api/playlist?cmd=load&p= | save&name= | add&p= | clear | shuffle&v=0/1 | repeat&v=off/all/one | play&i= | files
+void SDPlayerWebUI::handlePlaylist(AsyncWebServerRequest *request) {
+    String cmd = request->hasParam("cmd") ? request->getParam("cmd")->value() : String("");
+    String v = request->hasParam("v") ? request->getParam("v")->value() : String("");
+    
+    if (cmd == "files") {
+        AsyncResponseStream *response = request->beginResponseStream("application/json");
+        uint16_t count = 0;
+        response->print("{\"files\":[");
+        playlist_files(response, PLAYLIST_DIR, &count);
+        String dir = webDir();
+        if (dir != PLAYLIST_DIR) playlist_files(response, dir.c_str(), &count);
+        response->print("]}");
+        request->send(response);
+        return;
+    }
+    if (cmd == "load" && request->hasParam("p")) {
+        if (playlist_load(request->getParam("p")->value().c_str()) <= 0) {
+            request->send(400, "text/plain", "Empty or unreadable playlist");
+            return;
+        }
+        if (!post(nullptr, SDPLAYER_CMD_PLAYLIST_AT, 0)) {
+            request->send(503, "text/plain", "Busy");
+            return;
+        }
+    } else if (cmd == "save" && request->hasParam("name")) {
+        if (!playlist_save(request->getParam("name")->value().c_str())) {
+            request->send(500, "text/plain", "Save failed");
+            return;
+        }
+    } else if (cmd == "add" && request->hasParam("p")) {
+        playlist_add(request->getParam("p")->value().c_str());
+        if (!isPlaying()) playlist_set_active(true);   // w trakcie odtwarzania z katalogu kolejka czeka na "play"
+    } else if (cmd == "clear") {
+        playlist_clear();
+    } else if (cmd == "shuffle") {
+        playlist_set_shuffle(v == "1");
+    } else if (cmd == "repeat") {
+        playlist_set_repeat(v == "all" ? PLAYLIST_REPEAT_ALL : v == "one" ? PLAYLIST_REPEAT_ONE : PLAYLIST_REPEAT_OFF);
+    } else if (cmd == "play" && request->hasParam("i")) {
+        if (!post(nullptr, SDPLAYER_CMD_PLAYLIST_AT, request->getParam("i")->value().toInt())) {
+            request->send(503, "text/plain", "Busy");
+            return;
+        }
+    } else if (cmd.length() > 0) {
+        request->send(400, "text/plain", "Unknown cmd");
+        return;
+    }
+    if (cmd == "shuffle" || cmd == "repeat" || cmd == "add") post(nullptr, SDPLAYER_CMD_REARM);   // zgłoszony następny utwór wg nowej kolejności
+    
+    uint16_t offset = 0;
+    uint16_t limit = SDPLAYER_LIBRARY_MAX;
+    if (request->hasParam("offset")) offset = constrain(request->getParam("offset")->value().toInt(), 0, 65535);
+    if (request->hasParam("limit")) limit = constrain(request->getParam("limit")->value().toInt(), 0, SDPLAYER_LIBRARY_MAX);
+    
+    playlist_status_t ps;
+    playlist_get_status(&ps);
+    static const char* const REPEAT[] = { "off", "all", "one" };
+    AsyncResponseStream *response = request->beginResponseStream("application/json");
+    response->printf("{\"active\":%s,\"count\":%u,\"position\":%u,\"shuffle\":%s,\"repeat\":\"%s\",\"skipped\":%u,\"missing\":%u,\"kept\":%u,\"name\":\"",
+                     ps.active ? "true" : "false", ps.count, ps.position, ps.shuffle ? "true" : "false",
+                     REPEAT[ps.repeat], ps.skipped, ps.missing, ps.kept);
+    library_text(response, ps.name);
+    response->printf("\",\"offset\":%u,\"items\":[", offset);
+    PlaylistList l = { response, 0 };
+    playlist_list(offset, limit, playlist_entry, &l);
+    response->print("]}");
+    request->send(response);
 }
 
 void SDPlayerWebUI::setVolume(int vol) {
     if (vol < 0) vol = 0;
     if (vol > 21) vol = 21;
-    _volume = vol;
+    player_state_set_volume(vol);
     // Serial.println("SDPlayerWebUI: Setting volume to " + String(vol));
     
     // Ustaw globalną głośność Audio
     if (_audio) {
-        _audio->setVolume(vol);
+        audio_cmd_volume(vol);
         // Serial.println("SDPlayerWebUI: Audio volume set");
     } else {
         // Serial.println("SDPlayerWebUI: WARNING - Audio pointer is NULL!");
     }
 }
 
+// ===================== STAN PRZEZ WEBSOCKET =====================
+
+String SDPlayerWebUI::stateJson() {
+    player_state_t st;
+    player_state_get(&st);
+
+    DynamicJsonDocument doc(1024);
+    doc["v"] = st.version;
+    doc["status"] = player_state_transport_name(st.transport);
+    doc["now"] = st.path[0] ? st.path : "None";
+    media_info_t info;
+    if (st.path[0] && media_lib_lookup(st.path, &info) && info.title[0]) {
+        doc["title"] = info.title;
+        if (info.artist[0]) doc["artist"] = info.artist;
+    }
+    doc["vol"] = st.volume;
+    doc["index"] = st.index;
+    String dir = webDir();   // także z zadania AsyncTCP (WS_EVT_CONNECT)
+    doc["cwd"] = dir;
+    doc["gen"] = dir_index_generation(dir.c_str());
+    doc["pos"] = positionSec();
+    doc["dur"] = durationSec();
+    doc["indexed"] = seek_index_ready();   // przewijanie przez tablicę z nagłówków
+
+    String response;
+    serializeJson(doc, response);
+    return response;
+}
+
+void SDPlayerWebUI::loop() {
+    // Polecenia ze strony - w tym samym wątku co playNextAuto() / armNext()
+    sdplayer_cmd_msg_t msg;
+    while (_cmdQueue && xQueueReceive(_cmdQueue, &msg, 0) == pdTRUE) {
+        execute(msg);
+    }
+    
+    // Głośność zmieniona poza odtwarzaczem (pilot, enkoder, strona radia)
+    if (_audio) {
+        player_state_set_volume(_audio->getVolume());
+    }
+    
+    uint32_t now = millis();
+    if (now - _wsCleanupTime >= SDPLAYER_WS_CLEANUP_MS) {
+        _wsCleanupTime = now;
+        _ws.cleanupClients();
+    }
+
+    // Tablica przewijania bieżącego utworu - budowa w tle po zmianie utworu
+    uint32_t trackGen = player_state_track_gen();
+    if (trackGen != _seekTrackGen) {
+        _seekTrackGen = trackGen;
+        char path[PLAYER_STATE_PATH_LENGTH + 1];
+        player_state_path(path, sizeof(path));
+        seek_index_track(path);
+    }
+
+    // Wysyłka tylko po zmianie wersji stanu, zawartości katalogu (zapis na kartę) lub tablicy (czas trwania)
+    uint32_t version = player_state_version();
+    uint32_t dirGen = dir_index_generation(_currentDir.c_str());
+    uint32_t seekGen = seek_index_generation();
+    if (version == _wsVersion && dirGen == _wsDirGen && seekGen == _wsSeekGen) return;
+    _wsVersion = version;
+    _wsDirGen = dirGen;
+    _wsSeekGen = seekGen;
+    if (_ws.count() == 0) return;
+
+    _ws.textAll(stateJson());
+}
+
 void SDPlayerWebUI::changeDirectory(const String& path) {
-    File dir = SD.open(path);
-    if (!dir || !dir.isDirectory()) {
+    String dir = path;
+    // Usuń podwójne slashe
+    dir.replace("//", "/");
+    
+    // Świeży odczyt katalogu docelowego - wejście do katalogu pokazuje zmiany na karcie
+    dir_index_invalidate(dir.c_str());
+    if (dir_index_open(dir.c_str()) < 0) {
         // Serial.println("Failed to open directory: " + path);
-        dir.close();
         return;
     }
-    dir.close();
-    
-    _currentDir = path;
-    // Usuń podwójne slashe
-    _currentDir.replace("//", "/");
     
+    setCurrentDir(dir);
+    player_state_dir_changed();
     // Serial.println("Changed directory to: " + _currentDir);
-    scanCurrentDirectory();
 }
 
 void SDPlayerWebUI::upDirectory() {
@@ -436,76 +1172,48 @@ void SDPlayerWebUI::upDirectory() {
     
     int lastSlash = _currentDir.lastIndexOf('/');
     if (lastSlash == 0) {
-        _currentDir = "/";
+        setCurrentDir("/");
     } else if (lastSlash > 0) {
-        _currentDir = _currentDir.substring(0, lastSlash);
+        setCurrentDir(_currentDir.substring(0, lastSlash));
     }
     
     // Serial.println("Up to directory: " + _currentDir);
+    player_state_dir_changed();
     scanCurrentDirectory();
 }
 
+void SDPlayerWebUI::setCurrentDir(const String& dir) {
+    _currentDir = dir;
+    portENTER_CRITICAL(&_mux);
+    strlcpy(_webDir, dir.c_str(), sizeof(_webDir));
+    portEXIT_CRITICAL(&_mux);
+}
+
+String SDPlayerWebUI::webDir() {
+    char dir[DIR_PATH_LENGTH + 1];
+    portENTER_CRITICAL(&_mux);
+    strcpy(dir, _webDir);
+    portEXIT_CRITICAL(&_mux);
+    return String(dir);
+}
+
 void SDPlayerWebUI::scanCurrentDirectory() {
-    _fileList.clear();
-    
-    File dir = SD.open(_currentDir);
-    if (!dir || !dir.isDirectory()) {
-        // Serial.println("Failed to scan directory: " + _currentDir);
-        if (dir) dir.close();
-        return;
-    }
-    
-    File entry = dir.openNextFile();
-    while (entry) {
-        FileItem item;
-        item.name = String(entry.name());
-        item.isDir = entry.isDirectory();
-        
-        // Usuń ścieżkę z nazwy - zostaw tylko nazwę pliku/katalogu
-        int lastSlash = item.name.lastIndexOf('/');
-        if (lastSlash >= 0) {
-            item.name = item.name.substring(lastSlash + 1);
-        }
-        
-        // Dodaj tylko jeśli to katalog lub plik audio
-        if (item.isDir || isAudioFile(item.name)) {
-            _fileList.push_back(item);
-        }
-        
-        entry.close();
-        entry = dir.openNextFile();
-    }
-    dir.close();
-    
-    sortFileList();
-    // Serial.println("Scanned " + String(_fileList.size()) + " items in " + _currentDir);
+    dir_index_invalidate(_currentDir.c_str());
+    dir_index_open(_currentDir.c_str());
 }
 
-void SDPlayerWebUI::buildFileList(JsonArray& items) {
-    for (const auto& item : _fileList) {
-        JsonObject obj = items.createNestedObject();
-        obj["n"] = item.name;
-        obj["d"] = item.isDir;
-    }
+int SDPlayerWebUI::fileCount() {
+    int32_t count = dir_index_open(_currentDir.c_str());
+    return count > 0 ? count : 0;
 }
 
-bool SDPlayerWebUI::isAudioFile(const String& filename) {
-    String lower = filename;
-    lower.toLowerCase();
-    return lower.endsWith(".mp3") || 
-           lower.endsWith(".wav") || 
-           lower.endsWith(".flac") ||
-           lower.endsWith(".aac") ||
-           lower.endsWith(".m4a") ||
-           lower.endsWith(".ogg");
+bool SDPlayerWebUI::fileAt(int index, dir_entry_t* out) {
+    return dir_index_get(_currentDir.c_str(), index, out);
 }
 
-void SDPlayerWebUI::sortFileList() {
-    // Sortuj: najpierw katalogi, potem pliki (alfabetycznie)
-    std::sort(_fileList.begin(), _fileList.end(), [](const FileItem& a, const FileItem& b) {
-        if (a.isDir != b.isDir) {
-            return a.isDir; // Katalogi na początku
-        }
-        return a.name.compareTo(b.name) < 0;
-    });
+String SDPlayerWebUI::filePath(const dir_entry_t& entry) {
+    String path = _currentDir;
+    if (path != "/") path += "/";
+    path += entry.name;
+    return path;
 }
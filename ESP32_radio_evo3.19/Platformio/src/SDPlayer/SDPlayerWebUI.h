@@ -5,13 +5,52 @@
 #include <SD.h>
 #include <FS.h>
 #include <functional>
+#include "DirIndex.h"
+#include "PlayerState.h"
 
 // Forward declarations
 class Audio;
 class SDPlayerOLED;
 
+// Stronicowanie /sdplayer/api/list: ?offset=&limit= albo ?cursor=&limit=
+// (kursor "next" z poprzedniej strony). Odpowiedź strumieniowana (chunked) -
+// pamięć stała niezależnie od liczby plików w katalogu. limit=0 = tylko status.
+static const uint16_t SDPLAYER_PAGE_DEFAULT = 100;
+static const uint16_t SDPLAYER_PAGE_MAX     = 500;
+static const uint16_t SDPLAYER_LIBRARY_MAX  = 200;   // pozycji na stronę /sdplayer/api/library
+static const uint32_t SDPLAYER_WS_CLEANUP_MS = 1000;  // zamykanie nadmiarowych klientów WebSocket
+static const uint8_t  SDPLAYER_CMD_QUEUE_LENGTH = 8;  // polecenia ze strony czekające na loop()
+
+// Polecenia ze strony - obsługa WWW (zadanie AsyncTCP) tylko je kolejkuje,
+// wykonanie w loop() razem z playNextAuto() / armNext() (jeden wątek stanu)
+typedef enum {
+    SDPLAYER_CMD_PLAY = 0,       // value = indeks w katalogu
+    SDPLAYER_CMD_PLAY_SELECTED,
+    SDPLAYER_CMD_PAUSE,
+    SDPLAYER_CMD_STOP,
+    SDPLAYER_CMD_NEXT,
+    SDPLAYER_CMD_PREV,
+    SDPLAYER_CMD_VOLUME,         // value = głośność
+    SDPLAYER_CMD_CD,             // path = katalog
+    SDPLAYER_CMD_UP,
+    SDPLAYER_CMD_BACK,
+    SDPLAYER_CMD_PLAY_PATH,      // path = plik
+    SDPLAYER_CMD_SEEK,           // value = [s]
+    SDPLAYER_CMD_PLAYLIST_AT,    // value = pozycja playlisty
+    SDPLAYER_CMD_REARM           // kolejność playlisty zmieniona - następny utwór od nowa
+} sdplayer_cmd_t;
+
+typedef struct {
+    uint8_t cmd;                 // sdplayer_cmd_t
+    int32_t value;
+    char    path[DIR_PATH_LENGTH + 1];
+} sdplayer_cmd_msg_t;
+
 // Minimal HTML/CSS/JS to mimic the screenshot layout.
-// Page polls /sdplayer/api/list every ~1s.
+// Page loads the list page by page; status comes over the /sdplayer/ws WebSocket
+// (pushed on every PlayerState change, falls back to one poll per reconnect).
+// Position slider: pos / dur from the state, advanced locally once per second
+// while playing; release = POST /sdplayer/api/seek?s= (SeekIndex).
 
 static const char SDPLAYER_HTML[] PROGMEM = R"HTML(
 <!doctype html>
@@ -37,6 +76,8 @@ static const char SDPLAYER_HTML[] PROGMEM = R"HTML(
   .item{padding:10px 12px;border-radius:6px;margin:4px 0;background:#f4f7fb;display:flex;gap:10px;align-items:center}
   .item:hover{background:#e9f1ff}
   .icon{width:22px}
+  .add{margin-left:auto;padding:2px 10px;font-size:14px}
+  .cur{background:#d6f5dc}
   .sliderWrap{margin:20px 0}
   input[type=range]{width:340px}
 </style>
@@ -52,6 +93,11 @@ static const char SDPLAYER_HTML[] PROGMEM = R"HTML(
     <div>Status: <b id="playStatus">Stopped</b></div>
   </div>
 
+  <div class="sliderWrap">
+    <div><b id="pos">0:00</b> / <b id="dur">0:00</b></div>
+    <input id="posr" type="range" min="0" max="0" value="0" oninput="seeking=true" onchange="seekTo(this.value)"/>
+  </div>
+
   <div class="btnrow">
     <button onclick="post('/sdplayer/api/playSelected')">Play Selected</button>
     <button id="pauseBtn" onclick="post('/sdplayer/api/pause')">Pause / Resume</button>
@@ -63,11 +109,26 @@ static const char SDPLAYER_HTML[] PROGMEM = R"HTML(
   <div class="btnrow">
     <button onclick="post('/sdplayer/api/up')">Up Directory</button>
     <button onclick="refresh()">Refresh</button>
+    <button id="viewBtn" onclick="toggleView()">Artists</button>
   </div>
 
   <div class="listbox">
     <div class="path">📁 <span id="path2">/</span></div>
     <div class="items" id="items"></div>
+    <div class="info" id="libInfo"></div>
+  </div>
+
+  <div class="listbox">
+    <div class="path">🎶 Playlist: <span id="plName">-</span></div>
+    <div class="btnrow">
+      <select id="plFiles"></select>
+      <button onclick="plLoad()">Load</button>
+      <button id="shufBtn" onclick="plShuffle()">Shuffle: off</button>
+      <button id="repBtn" onclick="plRepeat()">Repeat: off</button>
+      <button onclick="plSave()">Save</button>
+      <button onclick="plCmd('clear')">Clear</button>
+    </div>
+    <div class="items" id="plItems"></div>
   </div>
 
   <div class="sliderWrap">
@@ -83,7 +144,16 @@ static const char SDPLAYER_HTML[] PROGMEM = R"HTML(
 <script>
 console.log('=== SD Player JavaScript START ===');
 let data=null;
-let refreshTimer=null;
+let items=[];        // wczytane strony listy (kolejne przez kursor "next")
+let next=null;
+let loading=false;
+let ws=null;
+let leaving=false;
+const PAGE=100;
+let view='dir';      // 'dir' = katalogi, 'lib' = biblioteka (wykonawca / album / utwór)
+let lib={artist:null,album:null};
+let seeking=false;   // suwak pozycji trzymany - bez nadpisywania
+let posAt=0;         // czas odebrania pozycji (przesuwanie lokalne)
 
 function post(url){
   console.log('POST:',url);
@@ -95,22 +165,65 @@ function post(url){
     .catch(e => console.error('POST error:',e));
 }
 
+// Status + pierwsza strona listy
 function refresh(){
   console.log('Refresh called');
-  fetch('/sdplayer/api/list')
+  loadPage(null);
+}
+
+function loadPage(cursor){
+  if(loading) return;
+  loading=true;
+  let url='/sdplayer/api/list?limit='+PAGE;
+  if(cursor) url+='&cursor='+encodeURIComponent(cursor);
+  fetch(url)
     .then(r=>{
-      console.log('List response status:',r.status);
       if(!r.ok) throw new Error('HTTP error! status: '+r.status);
       return r.json();
     })
     .then(j=>{
-      console.log('List data received:',j);
+      const start=cursor?items.length:0;
+      if(!cursor) items=[];
+      items=items.concat(j.items||[]);
+      next=j.next;
       data=j;
-      render();
+      renderStatus();
+      renderItems(start);
     })
     .catch(e=>{
-      console.error('Refresh error:',e);
-    });
+      console.error('List error:',e);
+    })
+    .finally(()=>{ loading=false; });
+}
+
+// Tylko status (limit=0) - lista od nowa gdy zmienił się katalog lub jego zawartość
+function poll(){
+  fetch('/sdplayer/api/list?limit=0')
+    .then(r=>r.json())
+    .then(j=>{
+      if(!data || j.cwd!==data.cwd || j.gen!==data.gen){ refresh(); return; }
+      data.now=j.now; data.title=j.title; data.artist=j.artist; data.status=j.status; data.vol=j.vol;
+      data.pos=j.pos; data.dur=j.dur; posAt=Date.now();
+      renderStatus();
+    })
+    .catch(e=>console.error('Poll error:',e));
+}
+
+// Stan odtwarzacza wypychany przez serwer po każdej zmianie (bez odpytywania)
+function connect(){
+  ws=new WebSocket('ws://'+location.host+'/sdplayer/ws');
+  ws.onmessage=(e)=>{
+    const j=JSON.parse(e.data);
+    if(!data || j.cwd!==data.cwd || j.gen!==data.gen){ refresh(); return; }
+    data.now=j.now; data.title=j.title; data.artist=j.artist; data.status=j.status; data.vol=j.vol;
+    data.pos=j.pos; data.dur=j.dur; posAt=Date.now();
+    renderStatus();
+    if(pl&&pl.active) plCmd('');   // pozycja playlisty
+  };
+  ws.onclose=()=>{
+    if(leaving) return;
+    setTimeout(()=>{ poll(); connect(); }, 3000);   // ponowne połączenie
+  };
 }
 
 function setVol(v){
@@ -118,9 +231,29 @@ function setVol(v){
   fetch('/sdplayer/api/vol?v='+encodeURIComponent(v),{method:'POST'});
 }
 
+// Pozycja / czas trwania - między wysyłkami stanu liczona lokalnie
+function fmt(s){ s=Math.max(0,Math.floor(s)); return Math.floor(s/60)+':'+String(s%60).padStart(2,'0'); }
+function renderPos(){
+  if(!data) return;
+  let p=data.pos||0;
+  if(data.status==='Playing') p+=(Date.now()-posAt)/1000;
+  if(data.dur && p>data.dur) p=data.dur;
+  document.getElementById('pos').innerText=fmt(p);
+  document.getElementById('dur').innerText=fmt(data.dur||0);
+  const r=document.getElementById('posr');
+  r.max=data.dur||0;
+  if(!seeking) r.value=Math.floor(p);
+}
+function seekTo(s){
+  seeking=false;
+  fetch('/sdplayer/api/seek?s='+encodeURIComponent(s),{method:'POST'});
+}
+setInterval(renderPos,1000);
+
 function back(){ 
   console.log('Back to menu clicked');
-  if(refreshTimer) clearInterval(refreshTimer);  // Zatrzymaj odświeżanie
+  leaving=true;
+  if(ws) ws.close();  // Zatrzymaj aktualizacje
   fetch('/sdplayer/api/back', {method:'POST'})
     .then(() => {
       console.log('Redirecting to /');
@@ -129,19 +262,15 @@ function back(){
     .catch(e => console.error('Back error:',e));
 }
 
-function render(){
-  console.log('Render called, data:',data);
-  if(!data){
-    console.log('No data yet, skipping render');
-    return;
-  }
-  
+function renderStatus(){
+  if(!data) return;
   try{
     document.getElementById('cwd').innerText=data.cwd||'/';
-    document.getElementById('path2').innerText=data.cwd||'/';
-    document.getElementById('now').innerText=data.now||'None';
+    document.getElementById('path2').innerText=(data.cwd||'/')+' ('+(data.total||0)+')';
+    document.getElementById('now').innerText=data.title?((data.artist?data.artist+' - ':'')+data.title):(data.now||'None');
     document.getElementById('vol').innerText=data.vol||0;
     document.getElementById('volr').value=data.vol||0;
+    renderPos();
     
     // Aktualizuj status odtwarzania
     const playStatus = document.getElementById('playStatus');
@@ -164,41 +293,168 @@ function render(){
     const s=document.getElementById('status');
     s.className='status active';
     s.innerText='Active';
-
-    const box=document.getElementById('items');
-    box.innerHTML='';
-    if(data.items && Array.isArray(data.items)){
-      console.log('Rendering',data.items.length,'items');
-      data.items.forEach((it,idx)=>{
-        const row=document.createElement('div');
-        row.className='item';
-        const ic=document.createElement('div');
-        ic.className='icon';
-        ic.innerText=it.d?'📁':'🎵';
-        const nm=document.createElement('div');
-        nm.innerText=it.d?('/'+it.n):it.n;
-        row.appendChild(ic); row.appendChild(nm);
-        row.onclick=()=>{
-          if(it.d){
-            fetch('/sdplayer/api/cd?p='+encodeURIComponent(data.cwd=='/'?('/'+it.n):(data.cwd+'/'+it.n)))
-              .then(()=>refresh());
-          }else{
-            fetch('/sdplayer/api/play?i='+idx,{method:'POST'}).then(()=>refresh());
-          }
-        };
-        box.appendChild(row);
-      });
-    }else{
-      console.log('No items or items not array');
-    }
   }catch(e){
     console.error('Render error:',e);
   }
 }
 
+// Wiersze od start (kolejna strona dopisywana na końcu listy)
+function renderItems(start){
+  if(view!=='dir') return;
+  const box=document.getElementById('items');
+  if(start===0) box.innerHTML='';
+  const more=document.getElementById('more');
+  if(more) more.remove();
+  for(let k=start;k<items.length;k++){
+    const it=items[k];
+    const row=document.createElement('div');
+    row.className='item';
+    const ic=document.createElement('div');
+    ic.className='icon';
+    ic.innerText=it.d?'📁':'🎵';
+    const nm=document.createElement('div');
+    nm.innerText=it.d?('/'+it.n):it.n;
+    row.appendChild(ic); row.appendChild(nm);
+    if(!it.d) addButton(row,data.cwd=='/'?('/'+it.n):(data.cwd+'/'+it.n));
+    row.onclick=()=>{
+      if(it.d){
+        fetch('/sdplayer/api/cd?p='+encodeURIComponent(data.cwd=='/'?('/'+it.n):(data.cwd+'/'+it.n)))
+          .then(()=>refresh());
+      }else{
+        fetch('/sdplayer/api/play?i='+it.i,{method:'POST'}).then(()=>refresh());
+      }
+    };
+    box.appendChild(row);
+  }
+  if(next){
+    const row=document.createElement('div');
+    row.className='item';
+    row.id='more';
+    row.innerText='More... ('+items.length+' / '+(data.total||0)+')';
+    row.onclick=()=>loadPage(next);
+    box.appendChild(row);
+  }
+}
+
+// Następna strona przy przewinięciu listy do końca
+document.getElementById('items').addEventListener('scroll',function(){
+  if(view==='dir' && next && this.scrollTop+this.clientHeight>=this.scrollHeight-40) loadPage(next);
+});
+
+// Biblioteka: wykonawcy -> albumy -> utwory (baza indeksera w tle)
+function toggleView(){
+  view=view==='dir'?'lib':'dir';
+  document.getElementById('viewBtn').innerText=view==='dir'?'Artists':'Folders';
+  document.getElementById('libInfo').innerText='';
+  if(view==='lib'){ lib={artist:null,album:null}; loadLibrary(); }
+  else renderItems(0);
+}
+
+function libRow(box,icon,text,fn){
+  const row=document.createElement('div');
+  row.className='item';
+  const ic=document.createElement('div');
+  ic.className='icon';
+  ic.innerText=icon;
+  const nm=document.createElement('div');
+  nm.innerText=text;
+  row.appendChild(ic); row.appendChild(nm);
+  row.onclick=fn;
+  box.appendChild(row);
+}
+
+function loadLibrary(){
+  let url='/sdplayer/api/library?limit=200';
+  if(lib.artist!==null) url+='&artist='+encodeURIComponent(lib.artist);
+  if(lib.album!==null) url+='&album='+encodeURIComponent(lib.album);
+  fetch(url)
+    .then(r=>r.json())
+    .then(j=>{
+      if(view!=='lib') return;
+      const box=document.getElementById('items');
+      box.innerHTML='';
+      if(lib.album!==null) libRow(box,'⬆','..',()=>{ lib.album=null; loadLibrary(); });
+      else if(lib.artist!==null) libRow(box,'⬆','..',()=>{ lib.artist=null; loadLibrary(); });
+      (j.artists||[]).forEach(a=>libRow(box,'👤',(a.n||'(unknown)')+' ('+a.t+')',()=>{ lib.artist=a.n; loadLibrary(); }));
+      (j.albums||[]).forEach(a=>libRow(box,'💿',(a.n||'(unknown)')+' ('+a.t+')',()=>{ lib.album=a.n; loadLibrary(); }));
+      (j.tracks||[]).forEach(t=>{
+        const d=t.s?' ['+Math.floor(t.s/60)+':'+String(t.s%60).padStart(2,'0')+']':'';
+        libRow(box,'🎵',(t.t||t.p.substring(t.p.lastIndexOf('/')+1))+d,()=>{
+          fetch('/sdplayer/api/playPath?p='+encodeURIComponent(t.p),{method:'POST'}).then(()=>refresh());
+        });
+        addButton(box.lastChild,t.p);
+      });
+      document.getElementById('libInfo').innerText='Library: '+j.records+' tracks ('+j.state+(j.throttled?', throttled':'')+', '+j.files_per_s+' files/s)';
+    })
+    .catch(e=>console.error('Library error:',e));
+}
+
+// Playlista: pliki M3U / PLS, kolejka, losowanie, powtarzanie
+let pl=null;
+function addButton(row,path){
+  const b=document.createElement('button');
+  b.className='add';
+  b.innerText='+';
+  b.title='Add to playlist';
+  b.onclick=(e)=>{ e.stopPropagation(); plCmd('add&p='+encodeURIComponent(path)); };
+  row.appendChild(b);
+}
+
+function plCmd(q){
+  fetch('/sdplayer/api/playlist?cmd='+q)
+    .then(r=>{ if(!r.ok) throw new Error('HTTP '+r.status); return r.json(); })
+    .then(j=>{ pl=j; renderPlaylist(); })
+    .catch(e=>console.error('Playlist error:',e));
+}
+
+function plLoad(){
+  const f=document.getElementById('plFiles').value;
+  if(f) plCmd('load&p='+encodeURIComponent(f));
+  setTimeout(refresh,300);
+}
+function plShuffle(){ plCmd('shuffle&v='+(pl&&pl.shuffle?'0':'1')); }
+function plRepeat(){
+  const next={off:'all',all:'one',one:'off'};
+  plCmd('repeat&v='+next[pl?pl.repeat:'off']);
+}
+function plSave(){
+  const n=prompt('Playlist name:',pl&&pl.name?pl.name:'');
+  if(n) plCmd('save&name='+encodeURIComponent(n));
+  setTimeout(plFiles,500);
+}
+
+function plFiles(){
+  fetch('/sdplayer/api/playlist?cmd=files')
+    .then(r=>r.json())
+    .then(j=>{
+      const sel=document.getElementById('plFiles');
+      sel.innerHTML='';
+      (j.files||[]).forEach(f=>{ const o=document.createElement('option'); o.value=f; o.innerText=f; sel.appendChild(o); });
+    })
+    .catch(e=>console.error('Playlist files error:',e));
+}
+
+function renderPlaylist(){
+  if(!pl) return;
+  document.getElementById('plName').innerText=(pl.name||'-')+' ('+pl.count+(pl.active?', active':'')+(pl.missing?', '+pl.missing+' not in library':'')+')';
+  document.getElementById('shufBtn').innerText='Shuffle: '+(pl.shuffle?'on':'off');
+  document.getElementById('repBtn').innerText='Repeat: '+pl.repeat;
+  const box=document.getElementById('plItems');
+  box.innerHTML='';
+  (pl.items||[]).forEach(it=>{
+    const row=document.createElement('div');
+    row.className='item'+(pl.active&&it.i===pl.position?' cur':'');
+    row.innerText=(it.i+1)+'. '+(it.p?it.p.substring(it.p.lastIndexOf('/')+1):'(not in library)');
+    row.onclick=()=>{ plCmd('play&i='+it.i); setTimeout(refresh,300); };
+    box.appendChild(row);
+  });
+}
+
 console.log('SDPlayer script loaded, starting initial refresh');
 refresh();  // Pierwsze załadowanie
-refreshTimer = setInterval(refresh, 5000);  // Odświeżaj co 5 sekund (tylko status/volume)
+plFiles();
+plCmd('');
+connect();  // Status/volume (+ pozycja playlisty) po każdej zmianie stanu
 </script>
 </body>
 </html>
@@ -214,24 +470,29 @@ public:
     // Kontrola odtwarzacza
     void playFile(const String& path);
     void playIndex(int index);
+    void playPath(const String& path);   // pełna ścieżka (biblioteka) - katalog pliku staje się bieżącym
+    void playPlaylistAt(uint16_t position);   // pozycja w kolejności odtwarzania playlisty
     void pause();
     void stop();
     void next();
     void prev();
     void playNextAuto(); // Automatyczne odtwarzanie następnego utworu (zapętlenie)
     void setVolume(int vol);
+    void seek(uint32_t sec);   // przewinięcie bieżącego utworu (SeekIndex), przy pauzie - pozycja wznowienia
+    void loop();         // główna pętla: stan do klientów WebSocket po zmianie wersji
     
     // Zarządzanie katalogiem
     void changeDirectory(const String& path);
     void upDirectory();
     String getCurrentDirectory() { return _currentDir; }
     
-    // Status
-    bool isPlaying() { return _isPlaying; }
-    bool isPaused() { return _isPaused; }
-    String getCurrentFile() { return _currentFile; }
-    int getVolume() { return _volume; }
-    int getSelectedIndex() const { return _selectedIndex; }  // Zwraca aktualny indeks zaznaczonego pliku
+    // Status - widok na PlayerState (jedno źródło dla WebUI / OLED / pilota)
+    bool isPlaying() { return player_state_transport() != PLAYER_STOPPED; }
+    bool isPaused() { return player_state_transport() == PLAYER_PAUSED; }
+    String getCurrentFile() { char p[PLAYER_STATE_PATH_LENGTH + 1]; return String(player_state_path(p, sizeof(p)) ? p : "None"); }
+    uint32_t getTrackGeneration() const { return player_state_track_gen(); }  // zmiana = inny bieżący plik (bez kopii ścieżki)
+    int getVolume() { return player_state_volume(); }
+    int getSelectedIndex() const { return player_state_index(); }  // Zwraca aktualny indeks zaznaczonego pliku
 
 private:
     AsyncWebServer* _server;
@@ -239,23 +500,38 @@ private:
     SDPlayerOLED* _oled;
     std::function<void()> _exitCallback;
     
-    String _currentDir;
-    String _currentFile;
-    int _volume;
-    bool _isPlaying;
-    bool _isPaused;
-    int _selectedIndex;
+    String _currentDir;        // tylko loop() - obsługa WWW czyta kopię webDir()
+    char _webDir[DIR_PATH_LENGTH + 1];
+    portMUX_TYPE _mux;         // _webDir / _armedPath - odczyt z zadania AsyncTCP
+    QueueHandle_t _cmdQueue;   // polecenia ze strony -> loop()
+    AsyncWebSocket _ws;        // /sdplayer/ws - stan odtwarzacza wypychany do strony
+    uint32_t _wsVersion;       // wersja PlayerState ostatnio wysłana
+    uint32_t _wsDirGen;        // generacja bieżącego katalogu ostatnio wysłana
+    uint32_t _wsCleanupTime;
+    uint32_t _wsSeekGen;       // generacja SeekIndex ostatnio wysłana (czas trwania z tablicy)
+    uint32_t _seekTrackGen;    // utwór ostatnio zgłoszony do SeekIndex
+    int _armedIndex;      // następny utwór zgłoszony do startu gapless (-1 = brak)
+    char _armedPath[PLAYER_STATE_PATH_LENGTH + 1];
+    bool _autoAdvance;    // bieżący start to przejście po końcu utworu
+    uint32_t _pausedAt;   // [s] pozycja pauzy - wznowienie od tego miejsca
     
-    struct FileItem {
-        String name;
-        bool isDir;
-    };
-    std::vector<FileItem> _fileList;
+    bool post(AsyncWebServerRequest *request, uint8_t cmd, int32_t value = 0, const char* path = nullptr);  // polecenie do loop(), odpowiedź od razu
+    void execute(const sdplayer_cmd_msg_t& msg);
+    void setCurrentDir(const String& dir);               // _currentDir + kopia dla obsługi WWW
+    String webDir();
+    String stateJson();                                  // stan dla WebSocket (jak status /api/list)
+    uint32_t positionSec();                              // pozycja bieżącego utworu (pauza - pozycja wznowienia)
+    uint32_t durationSec();                              // czas trwania: tablica przewijania, dekoder
+    void noteResume();                                   // pozycja przerwanego utworu (Playlist)
+    bool playPlaylistStep(int8_t step, bool automatic);  // następny / poprzedni wg playlisty
     
-    void scanCurrentDirectory();
-    void buildFileList(JsonArray& items);
-    bool isAudioFile(const String& filename);
-    void sortFileList();
+    // Lista plików bieżącego katalogu - wspólny indeks katalogów (DirIndex), ten sam co OLED
+    void scanCurrentDirectory();           // świeży odczyt bieżącego katalogu (cd / up)
+    int fileCount();
+    bool fileAt(int index, dir_entry_t* out);
+    String filePath(const dir_entry_t& entry);
+    int nextAudioIndex();  // następny plik audio po bieżącym indeksie, z zawinięciem listy
+    void armNext();        // zgłoszenie następnego utworu (gapless / przenikanie)
     
     // Handler functions
     void handleRoot(AsyncWebServerRequest *request);
@@ -270,4 +546,11 @@ private:
     void handleCd(AsyncWebServerRequest *request);
     void handleUp(AsyncWebServerRequest *request);
     void handleBack(AsyncWebServerRequest *request);
+    void handleTransition(AsyncWebServerRequest *request);
+    void handleIndex(AsyncWebServerRequest *request);
+    void handleCover(AsyncWebServerRequest *request);
+    void handleLibrary(AsyncWebServerRequest *request);
+    void handlePlayPath(AsyncWebServerRequest *request);
+    void handlePlaylist(AsyncWebServerRequest *request);
+    void handleSeek(AsyncWebServerRequest *request);
 };
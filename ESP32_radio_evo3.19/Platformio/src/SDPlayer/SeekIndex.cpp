@@ -0,0 +1,823 @@
+#include "SeekIndex.h"
+#include "../AudioTask.h"
+#include "../SdIo.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <SD.h>
+#include <string.h>
+#include <strings.h>
+
+static_assert(sizeof(seek_table_t) == MEDIA_SEEK_BYTES, "seek_table_t != MEDIA_SEEK_BYTES");
+
+static const uint8_t SEEK_STREAMS = 3;   // M4A: stts, stsc, stco czytane równolegle
+
+// ======================= STAN =======================
+
+// Pozycja odtwarzania - kontekst dekodera zapisuje, pozostałe czytają (pod g_mux)
+typedef struct {
+  uint32_t baseMs;             // start pliku / wykonane przewinięcie
+  uint64_t frames;             // ramki od baseMs
+  uint32_t rate;
+  bool     pending;            // przewinięcie zlecone, dekoder jeszcze nie wykonał
+  bool     measuring;          // wykonane, czekamy na pierwsze próbki
+  uint32_t targetMs;
+  uint32_t seekAt;             // millis() zlecenia
+  uint8_t  format;
+} seek_pos_t;
+
+static SemaphoreHandle_t   g_lock = nullptr;
+static TaskHandle_t        g_task = nullptr;
+static char                g_reqPath[SEEK_INDEX_PATH_LENGTH + 1];   // pod g_lock
+static uint32_t            g_reqSeq = 0;
+static seek_table_t        g_table;                  // tablica bieżącego utworu (pod g_lock)
+static uint32_t            g_tablePath = 0;          // skrót ścieżki g_table
+static volatile bool       g_ready = false;
+static volatile uint32_t   g_durationMs = 0;
+static volatile uint32_t   g_generation = 0;
+static seek_index_status_t g_status;                 // pod g_lock, poza latency
+
+static portMUX_TYPE        g_mux = portMUX_INITIALIZER_UNLOCKED;
+static seek_pos_t          g_pos;                    // pod g_mux
+static seek_latency_t      g_latency[SEEK_FORMAT_COUNT];   // pod g_mux
+
+// ======================= ŹRÓDŁO =======================
+
+// Odczyt z buforem - pozycje losowe (nagłówki) i strumienie tablic M4A
+typedef struct {
+  File*    f;
+  uint32_t size;
+  uint32_t bufPos;             // pozycja bufora w pliku
+  uint16_t bufLen;
+  bool     error;
+  uint8_t  buf[SEEK_INDEX_IO_CHUNK];
+} seek_src_t;
+
+static void src_open(seek_src_t* s, File* f, uint32_t size)
+{
+  s->f = f;
+  s->size = size;
+  s->bufPos = 0;
+  s->bufLen = 0;
+  s->error = false;
+}
+
+static bool src_read_at(seek_src_t* s, uint32_t pos, uint8_t* dst, uint32_t n)
+{
+  while (n) {
+    if (pos < s->bufPos || pos >= s->bufPos + s->bufLen) {
+      if (pos >= s->size) { s->error = true; return false; }
+      uint32_t want = s->size - pos < SEEK_INDEX_IO_CHUNK ? s->size - pos : SEEK_INDEX_IO_CHUNK;
+      sdio_begin(SDIO_CLASS_SEEK, SEEK_INDEX_IO_MAX_WAIT_MS);
+      int got = s->f->seek(pos) ? s->f->read(s->buf, want) : -1;
+      sdio_end(SDIO_CLASS_SEEK, got > 0 ? got : 0);
+      if (got <= 0) { s->bufLen = 0; s->error = true; return false; }
+      s->bufPos = pos;
+      s->bufLen = got;
+    }
+    uint32_t part = s->bufPos + s->bufLen - pos;
+    if (part > n) part = n;
+    memcpy(dst, s->buf + (pos - s->bufPos), part);
+    dst += part;
+    pos += part;
+    n -= part;
+  }
+  return true;
+}
+
+static inline uint32_t be32(const uint8_t* b)
+{
+  return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+static uint32_t src_be32(seek_src_t* s, uint32_t pos)
+{
+  uint8_t b[4];
+  return src_read_at(s, pos, b, 4) ? be32(b) : 0;
+}
+
+static uint64_t src_be64(seek_src_t* s, uint32_t pos)
+{
+  uint8_t b[8];
+  return src_read_at(s, pos, b, 8) ? ((uint64_t)be32(b) << 32) | be32(b + 4) : 0;
+}
+
+static uint16_t src_be16(seek_src_t* s, uint32_t pos)
+{
+  uint8_t b[2];
+  return src_read_at(s, pos, b, 2) ? (b[0] << 8) | b[1] : 0;
+}
+
+static uint32_t src_le32(seek_src_t* s, uint32_t pos)
+{
+  uint8_t b[4];
+  return src_read_at(s, pos, b, 4) ? ((uint32_t)b[3] << 24) | ((uint32_t)b[2] << 16) | (b[1] << 8) | b[0] : 0;
+}
+
+static uint16_t src_le16(seek_src_t* s, uint32_t pos)
+{
+  uint8_t b[2];
+  return src_read_at(s, pos, b, 2) ? (b[1] << 8) | b[0] : 0;
+}
+
+// Za znacznikami ID3v2 (także kilkoma po sobie)
+static uint32_t skip_id3v2(seek_src_t* s, uint32_t pos)
+{
+  uint8_t h[10];
+  while (pos + 10 <= s->size && src_read_at(s, pos, h, 10) && memcmp(h, "ID3", 3) == 0) {
+    uint32_t size = ((uint32_t)(h[6] & 0x7F) << 21) | ((uint32_t)(h[7] & 0x7F) << 14) | ((h[8] & 0x7F) << 7) | (h[9] & 0x7F);
+    pos += 10 + size + ((h[5] & 0x10) ? 10 : 0);   // stopka
+  }
+  return pos;
+}
+
+// ======================= TABLICA =======================
+
+// Punkty rosnąco w czasie i pozycji - inne pomijane
+static void add_point(seek_table_t* t, uint32_t ms, uint32_t offset)
+{
+  if (t->count >= SEEK_INDEX_POINTS) return;
+  if (t->count && (ms <= t->points[t->count - 1].ms || offset < t->points[t->count - 1].offset)) return;
+  t->points[t->count].ms = ms;
+  t->points[t->count].offset = offset;
+  t->count++;
+}
+
+// Pozycja proporcjonalna do czasu (CBR / PCM / FLAC bez SEEKTABLE)
+static bool linear_table(seek_table_t* t)
+{
+  t->source = SEEK_SOURCE_LINEAR;
+  t->count = 0;
+  add_point(t, 0, t->dataStart);
+  add_point(t, t->durationMs, t->dataEnd);
+  return t->durationMs > 0 && t->count == 2;
+}
+
+// Pozycja w pliku dla ms (pod g_lock), *actualMs = czas od którego gra dekoder
+static uint32_t table_offset(const seek_table_t* t, uint32_t ms, uint32_t* actualMs)
+{
+  if (ms < t->points[0].ms) { *actualMs = 0; return t->dataStart; }
+  uint16_t lo = 0;
+  uint16_t hi = t->count;
+  while (hi - lo > 1) {
+    uint16_t mid = (lo + hi) / 2;
+    if (t->points[mid].ms <= ms) lo = mid;
+    else hi = mid;
+  }
+  const seek_point_t* a = &t->points[lo];
+  if (t->exact || lo + 1 >= t->count) {
+    *actualMs = a->ms;   // M4A: początek porcji - dekoder AAC nie ma synchronizacji w strumieniu
+    return a->offset;
+  }
+  const seek_point_t* b = a + 1;
+  uint32_t offset = a->offset + (uint32_t)((uint64_t)(b->offset - a->offset) * (ms - a->ms) / (b->ms - a->ms));
+  if (t->align > 1) offset = t->dataStart + (offset - t->dataStart) / t->align * t->align;
+  *actualMs = ms;   // MP3 / FLAC: dekoder szuka najbliższej ramki
+  return offset;
+}
+
+// ======================= MP3 =======================
+
+static const uint16_t MP3_BITRATE[2][15] = {
+  { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },   // MPEG1 Layer III
+  { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }         // MPEG2 / 2.5 Layer III
+};
+static const uint16_t MP3_RATE[3] = { 44100, 48000, 32000 };                // MPEG1, MPEG2 /2, MPEG2.5 /4
+
+typedef struct {
+  uint32_t rate;
+  uint16_t kbps;
+  uint16_t spf;                // próbki na ramkę
+  uint16_t length;             // bajty ramki
+  uint8_t  side;               // informacja boczna - za nią nagłówek Xing
+} mp3_frame_t;
+
+static bool mp3_header(const uint8_t* h, mp3_frame_t* fr)
+{
+  if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) return false;
+  uint8_t ver = (h[1] >> 3) & 3;     // 3 = MPEG1, 2 = MPEG2, 0 = MPEG2.5
+  uint8_t layer = (h[1] >> 1) & 3;   // 1 = Layer III
+  uint8_t br = h[2] >> 4;
+  uint8_t sr = (h[2] >> 2) & 3;
+  if (ver == 1 || layer != 1 || br == 0 || br == 15 || sr == 3) return false;
+  bool mpeg1 = ver == 3;
+  bool mono = (h[3] >> 6) == 3;
+  fr->rate = MP3_RATE[sr] >> (mpeg1 ? 0 : (ver == 2 ? 1 : 2));
+  fr->kbps = MP3_BITRATE[mpeg1 ? 0 : 1][br];
+  fr->spf = mpeg1 ? 1152 : 576;
+  fr->length = (mpeg1 ? 144000UL : 72000UL) * fr->kbps / fr->rate + ((h[2] >> 1) & 1);
+  fr->side = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+  return true;
+}
+
+static bool build_mp3(seek_src_t* s, seek_table_t* t)
+{
+  uint32_t end = t->fileSize;
+  uint8_t tag[4];
+  if (end > 128 && src_read_at(s, end - 128, tag, 3) && memcmp(tag, "TAG", 3) == 0) end -= 128;   // ID3v1
+
+  // Pierwsza ramka - nagłówek potwierdzony przez następną ramkę
+  mp3_frame_t fr;
+  uint32_t pos = skip_id3v2(s, 0);
+  uint32_t limit = pos + SEEK_INDEX_MP3_SYNC_SCAN;
+  bool found = false;
+  for (; pos + 4 <= end && pos < limit; pos++) {
+    uint8_t h[4];
+    if (!src_read_at(s, pos, h, 4)) break;
+    if (!mp3_header(h, &fr)) continue;
+    mp3_frame_t next;
+    if (pos + fr.length + 4 > end || (src_read_at(s, pos + fr.length, h, 4) && mp3_header(h, &next))) { found = true; break; }
+  }
+  if (!found) return false;
+  t->dataStart = pos;
+  t->dataEnd = end;
+
+  // Xing / Info: liczba ramek, bajty danych, TOC 100 x 1/256 danych
+  uint32_t x = pos + 4 + fr.side;
+  if (src_read_at(s, x, tag, 4) && (memcmp(tag, "Xing", 4) == 0 || memcmp(tag, "Info", 4) == 0)) {
+    uint32_t flags = src_be32(s, x + 4);
+    uint32_t p = x + 8;
+    uint32_t frames = 0;
+    uint32_t bytes = 0;
+    if (flags & 1) { frames = src_be32(s, p); p += 4; }
+    if (flags & 2) { bytes = src_be32(s, p); p += 4; }
+    if (frames) {
+      t->durationMs = (uint64_t)frames * fr.spf * 1000 / fr.rate;
+      if (!bytes || bytes > end - pos) bytes = end - pos;
+      uint8_t toc[100];
+      if ((flags & 4) && t->durationMs >= 100 && src_read_at(s, p, toc, sizeof(toc))) {
+        t->source = SEEK_SOURCE_XING;
+        for (uint8_t i = 0; i < 100; i++) add_point(t, t->durationMs * i / 100, pos + (uint32_t)((uint64_t)toc[i] * bytes / 256));
+        add_point(t, t->durationMs, pos + bytes);
+        return true;
+      }
+      t->dataStart = pos + fr.length;   // Info bez TOC (CBR) - ramka nagłówka bez dźwięku
+      return linear_table(t);
+    }
+  }
+
+  // VBRI (Fraunhofer): TOC rozmiarów odcinków po framesPerEntry ramek
+  uint32_t v = pos + 4 + 32;
+  if (src_read_at(s, v, tag, 4) && memcmp(tag, "VBRI", 4) == 0) {
+    uint32_t frames = src_be32(s, v + 14);
+    uint16_t entries = src_be16(s, v + 18);
+    uint16_t scale = src_be16(s, v + 20);
+    uint16_t size = src_be16(s, v + 22);
+    uint16_t perEntry = src_be16(s, v + 24);
+    if (frames && entries && size >= 1 && size <= 4 && !s->error) {
+      t->durationMs = (uint64_t)frames * fr.spf * 1000 / fr.rate;
+      t->source = SEEK_SOURCE_VBRI;
+      uint16_t step = entries / (SEEK_INDEX_POINTS - 2) + 1;
+      uint32_t offset = pos;
+      add_point(t, 0, pos);
+      for (uint16_t i = 0; i < entries; i++) {
+        uint8_t b[4];
+        if (!src_read_at(s, v + 26 + (uint32_t)i * size, b, size)) return false;
+        uint32_t value = 0;
+        for (uint8_t k = 0; k < size; k++) value = (value << 8) | b[k];
+        offset += value * scale;
+        if ((i + 1) % step && i + 1 != entries) continue;
+        uint64_t ms = (uint64_t)(i + 1) * perEntry * fr.spf * 1000 / fr.rate;
+        add_point(t, ms < t->durationMs ? (uint32_t)ms : t->durationMs, offset < end ? offset : end);
+      }
+      return t->count > 1;
+    }
+  }
+
+  // Bez nagłówka - CBR, czas z długości danych
+  t->durationMs = (uint64_t)(end - pos) * 8 / fr.kbps;
+  return linear_table(t);
+}
+
+// ======================= FLAC =======================
+
+static bool build_flac(seek_src_t* s, seek_table_t* t)
+{
+  uint32_t pos = skip_id3v2(s, 0);
+  uint8_t h[18];
+  if (!src_read_at(s, pos, h, 4) || memcmp(h, "fLaC", 4) != 0) return false;
+  pos += 4;
+
+  // Bloki metadanych: STREAMINFO (częstotliwość, liczba próbek), SEEKTABLE
+  uint32_t rate = 0;
+  uint64_t total = 0;
+  uint32_t tablePos = 0;
+  uint32_t tableLen = 0;
+  for (;;) {
+    if (!src_read_at(s, pos, h, 4)) return false;
+    uint32_t len = ((uint32_t)h[1] << 16) | (h[2] << 8) | h[3];
+    uint8_t type = h[0] & 0x7F;
+    bool last = h[0] & 0x80;
+    if (type == 0 && len >= 18) {
+      if (!src_read_at(s, pos + 4, h, 18)) return false;
+      rate = ((uint32_t)h[10] << 12) | (h[11] << 4) | (h[12] >> 4);
+      total = ((uint64_t)(h[13] & 0x0F) << 32) | be32(h + 14);
+    } else if (type == 3) {
+      tablePos = pos + 4;
+      tableLen = len;
+    }
+    pos += 4 + len;
+    if (last) break;
+    if (pos >= t->fileSize) return false;
+  }
+  if (!rate || !total) return false;
+  t->dataStart = pos;
+  t->dataEnd = t->fileSize;
+  t->durationMs = total * 1000 / rate;
+
+  // Punkty: numer próbki, pozycja względem pierwszej ramki (0xFF.. = miejsce zarezerwowane)
+  uint32_t n = tableLen / 18;
+  if (n) {
+    t->source = SEEK_SOURCE_SEEKTABLE;
+    uint32_t step = n / (SEEK_INDEX_POINTS - 2) + 1;
+    add_point(t, 0, pos);
+    for (uint32_t i = 0; i < n; i += step) {
+      uint64_t sample = src_be64(s, tablePos + i * 18);
+      uint64_t offset = src_be64(s, tablePos + i * 18 + 8);
+      if (s->error) return false;
+      if (sample == UINT64_MAX || sample >= total || offset >= t->fileSize - pos) continue;
+      add_point(t, (uint32_t)(sample * 1000 / rate), pos + (uint32_t)offset);
+    }
+    add_point(t, t->durationMs, t->dataEnd);
+    if (t->count > 2) return true;
+    t->count = 0;
+  }
+  return linear_table(t);
+}
+
+// ======================= M4A =======================
+
+// Atom w [pos, end): *size całość, *hdr nagłówek; false = koniec / błąd
+static bool m4a_atom(seek_src_t* s, uint32_t pos, uint32_t end, uint32_t* size, uint32_t* hdr, char* type)
+{
+  uint8_t h[8];
+  if (pos + 8 > end || !src_read_at(s, pos, h, 8)) return false;
+  uint32_t sz = be32(h);
+  *hdr = 8;
+  if (sz == 1) {
+    uint64_t large = src_be64(s, pos + 8);
+    if (large >> 32) return false;
+    sz = (uint32_t)large;
+    *hdr = 16;
+  } else if (sz == 0) {
+    sz = end - pos;   // do końca pliku
+  }
+  if (sz < *hdr || sz > end - pos) return false;
+  memcpy(type, h + 4, 4);
+  *size = sz;
+  return true;
+}
+
+// Pierwszy atom typu w [pos, end) - zawartość [*body, *bodyEnd)
+static bool m4a_find(seek_src_t* s, uint32_t pos, uint32_t end, const char* type, uint32_t* body, uint32_t* bodyEnd)
+{
+  uint32_t size;
+  uint32_t hdr;
+  char t[4];
+  while (m4a_atom(s, pos, end, &size, &hdr, t)) {
+    if (memcmp(t, type, 4) == 0) {
+      *body = pos + hdr;
+      *bodyEnd = pos + size;
+      return true;
+    }
+    pos += size;
+  }
+  return false;
+}
+
+// Pierwsza ścieżka dźwięku: skala czasu, czas trwania, stbl
+static bool m4a_sound_track(seek_src_t* s, uint32_t moov, uint32_t moovEnd, uint32_t* timescale, uint64_t* duration,
+                            uint32_t* stbl, uint32_t* stblEnd)
+{
+  uint32_t pos = moov;
+  uint32_t size;
+  uint32_t hdr;
+  char type[4];
+  while (m4a_atom(s, pos, moovEnd, &size, &hdr, type)) {
+    uint32_t mdia, mdiaEnd, b, e, minf, minfEnd;
+    uint8_t handler[4];
+    if (memcmp(type, "trak", 4) == 0 &&
+        m4a_find(s, pos + hdr, pos + size, "mdia", &mdia, &mdiaEnd) &&
+        m4a_find(s, mdia, mdiaEnd, "hdlr", &b, &e) && src_read_at(s, b + 8, handler, 4) && memcmp(handler, "soun", 4) == 0 &&
+        m4a_find(s, mdia, mdiaEnd, "mdhd", &b, &e)) {
+      uint8_t version;
+      if (!src_read_at(s, b, &version, 1)) return false;
+      if (version == 1) {
+        *timescale = src_be32(s, b + 20);
+        *duration = src_be64(s, b + 24);
+      } else {
+        *timescale = src_be32(s, b + 12);
+        *duration = src_be32(s, b + 16);
+      }
+      return *timescale && m4a_find(s, mdia, mdiaEnd, "minf", &minf, &minfEnd) &&
+             m4a_find(s, minf, minfEnd, "stbl", stbl, stblEnd);
+    }
+    pos += size;
+  }
+  return false;
+}
+
+// Początki porcji (stco / co64) co ~1/256 utworu - czas porcji z stsc (próbki na porcję) i stts (czas próbek)
+static bool build_m4a(seek_src_t* src, seek_table_t* t)
+{
+  seek_src_t* s = &src[0];
+  uint32_t moov, moovEnd, stbl, stblEnd, timescale, e;
+  uint64_t duration;
+  if (!m4a_find(s, 0, t->fileSize, "moov", &moov, &moovEnd)) return false;
+  if (!m4a_sound_track(s, moov, moovEnd, &timescale, &duration, &stbl, &stblEnd)) return false;
+
+  uint32_t stts, stsc, stco;
+  bool co64 = false;
+  if (!m4a_find(s, stbl, stblEnd, "stts", &stts, &e) || !m4a_find(s, stbl, stblEnd, "stsc", &stsc, &e)) return false;
+  if (!m4a_find(s, stbl, stblEnd, "stco", &stco, &e)) {
+    if (!m4a_find(s, stbl, stblEnd, "co64", &stco, &e)) return false;
+    co64 = true;
+  }
+
+  seek_src_t* sTime = &src[0];
+  seek_src_t* sChunk = &src[1];
+  seek_src_t* sOffset = &src[2];
+  uint32_t sttsCount = src_be32(sTime, stts + 4);
+  uint32_t stscCount = src_be32(sChunk, stsc + 4);
+  uint32_t chunks = src_be32(sOffset, stco + 4);
+  if (!sttsCount || !stscCount || !chunks) return false;
+
+  t->durationMs = duration * 1000 / timescale;
+  t->exact = true;
+  t->source = SEEK_SOURCE_SAMPLE_TABLE;
+  uint32_t stepMs = t->durationMs / (SEEK_INDEX_POINTS - 1) + 1;
+  uint32_t nextMs = 0;
+  uint64_t time = 0;               // jednostki timescale
+  uint32_t sttsNo = 0, sttsLeft = 0, sttsDelta = 0;
+  uint32_t stscNo = 0, perChunk = 0;
+  uint32_t nextFirst = src_be32(sChunk, stsc + 8);
+
+  for (uint32_t c = 1; c <= chunks; c++) {
+    while (stscNo < stscCount && nextFirst <= c) {
+      perChunk = src_be32(sChunk, stsc + 8 + stscNo * 12 + 4);
+      stscNo++;
+      nextFirst = stscNo < stscCount ? src_be32(sChunk, stsc + 8 + stscNo * 12) : UINT32_MAX;
+    }
+    uint32_t ms = time * 1000 / timescale;
+    if (ms >= nextMs) {
+      uint32_t offset = co64 ? (uint32_t)src_be64(sOffset, stco + 8 + (c - 1) * 8) : src_be32(sOffset, stco + 8 + (c - 1) * 4);
+      if (sOffset->error) return false;
+      if (t->count == 0) t->dataStart = offset;
+      add_point(t, ms, offset);
+      nextMs = ms + stepMs;
+    }
+    // Czas następnej porcji
+    uint32_t n = perChunk;
+    while (n) {
+      if (!sttsLeft) {
+        if (sttsNo >= sttsCount) break;
+        sttsLeft = src_be32(sTime, stts + 8 + sttsNo * 8);
+        sttsDelta = src_be32(sTime, stts + 12 + sttsNo * 8);
+        sttsNo++;
+        continue;
+      }
+      uint32_t take = n < sttsLeft ? n : sttsLeft;
+      time += (uint64_t)take * sttsDelta;
+      sttsLeft -= take;
+      n -= take;
+    }
+    if (sTime->error || sChunk->error) return false;
+  }
+  t->dataEnd = t->fileSize;
+  return t->count > 0;
+}
+
+// ======================= WAV =======================
+
+static bool build_wav(seek_src_t* s, seek_table_t* t)
+{
+  uint8_t h[12];
+  if (!src_read_at(s, 0, h, 12) || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) return false;
+  uint32_t pos = 12;
+  uint32_t byteRate = 0;
+  uint16_t align = 0;
+  while (pos + 8 <= t->fileSize && src_read_at(s, pos, h, 8)) {
+    uint32_t len = src_le32(s, pos + 4);
+    if (memcmp(h, "fmt ", 4) == 0 && len >= 16) {
+      byteRate = src_le32(s, pos + 16);
+      align = src_le16(s, pos + 20);
+    } else if (memcmp(h, "data", 4) == 0) {
+      if (!byteRate || !align) return false;
+      t->dataStart = pos + 8;
+      t->dataEnd = len && len <= t->fileSize - t->dataStart ? t->dataStart + len : t->fileSize;   // 0 / za duży = nagranie przerwane
+      t->align = align;
+      t->durationMs = (uint64_t)(t->dataEnd - t->dataStart) * 1000 / byteRate;
+      return linear_table(t);
+    }
+    if (len > t->fileSize - pos) return false;
+    pos += 8 + len + (len & 1);
+  }
+  return false;
+}
+
+// ======================= BUDOWA =======================
+
+static uint8_t format_of(const char* path)
+{
+  const char* dot = strrchr(path, '.');
+  if (!dot) return SEEK_FORMAT_OTHER;
+  if (strcasecmp(dot, ".mp3") == 0) return SEEK_FORMAT_MP3;
+  if (strcasecmp(dot, ".flac") == 0) return SEEK_FORMAT_FLAC;
+  if (strcasecmp(dot, ".m4a") == 0 || strcasecmp(dot, ".m4b") == 0 || strcasecmp(dot, ".mp4") == 0) return SEEK_FORMAT_M4A;
+  if (strcasecmp(dot, ".wav") == 0) return SEEK_FORMAT_WAV;
+  return SEEK_FORMAT_OTHER;
+}
+
+// Tablica z nagłówków, *ioError = błąd odczytu (wynik nie do zapisania w bazie)
+static bool build_table(File* f, uint32_t size, uint8_t format, seek_src_t* src, seek_table_t* t, bool* ioError)
+{
+  memset(t, 0, sizeof(*t));
+  t->fileSize = size;
+  t->format = format;
+  t->align = 1;
+  for (uint8_t i = 0; i < SEEK_STREAMS; i++) src_open(&src[i], f, size);
+
+  bool ok = false;
+  switch (format) {
+    case SEEK_FORMAT_MP3:  ok = build_mp3(&src[0], t); break;
+    case SEEK_FORMAT_FLAC: ok = build_flac(&src[0], t); break;
+    case SEEK_FORMAT_M4A:  ok = build_m4a(src, t); break;
+    case SEEK_FORMAT_WAV:  ok = build_wav(&src[0], t); break;
+    default: break;
+  }
+  *ioError = false;
+  for (uint8_t i = 0; i < SEEK_STREAMS; i++) *ioError |= src[i].error;
+  if (!ok) {
+    t->count = 0;
+    t->source = SEEK_SOURCE_NONE;
+  }
+  return ok;
+}
+
+// ======================= ZADANIE =======================
+
+static void publish(uint32_t seq, uint32_t pathHash, const seek_table_t* t, bool cached, uint32_t ms)
+{
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (seq == g_reqSeq) {
+    memcpy(&g_table, t, sizeof(g_table));
+    g_tablePath = pathHash;
+    g_ready = t->count > 0;
+    g_durationMs = g_ready ? t->durationMs : 0;
+    g_status.ready = g_ready;
+    g_status.format = t->format;
+    g_status.source = t->source;
+    g_status.points = t->count;
+    g_status.durationMs = t->durationMs;
+  }
+  if (cached) {
+    g_status.cacheHits++;
+  } else if (t->count > 0) {
+    g_status.built++;
+    g_status.lastBuildMs = ms;
+    if (ms > g_status.maxBuildMs) g_status.maxBuildMs = ms;
+  }
+  if (t->count == 0) g_status.failed++;
+  xSemaphoreGive(g_lock);
+  g_generation++;
+}
+
+static void seek_task(void* arg)
+{
+  static char path[SEEK_INDEX_PATH_LENGTH + 1];   // static - poza stosem zadania
+  static seek_table_t table;
+  static seek_src_t src[SEEK_STREAMS];
+  uint32_t doneSeq = 0;
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    uint32_t seq = g_reqSeq;
+    memcpy(path, g_reqPath, sizeof(path));
+    xSemaphoreGive(g_lock);
+    if (seq == doneSeq) continue;
+    doneSeq = seq;
+    if (!path[0]) continue;
+
+    uint8_t format = format_of(path);
+    uint32_t key = media_lib_path_hash(path);
+    uint32_t t0 = millis();
+    if (format == SEEK_FORMAT_OTHER) {
+      memset(&table, 0, sizeof(table));   // OGG / AAC - przewijanie biblioteki audio
+      publish(seq, key, &table, false, 0);
+      continue;
+    }
+
+    sdio_begin(SDIO_CLASS_SEEK, SEEK_INDEX_IO_MAX_WAIT_MS);
+    File f = SD.open(path, FILE_READ);
+    sdio_end(SDIO_CLASS_SEEK, 0);
+    if (!f) {
+      memset(&table, 0, sizeof(table));
+      publish(seq, key, &table, false, 0);
+      continue;
+    }
+    uint32_t size = f.size();
+
+    // Rekord w bazie ważny przy tym samym rozmiarze pliku (także "bez tablicy" - bez ponownej analizy)
+    bool cached = media_lib_seek_get(key, &table) && table.fileSize == size && table.format == format;
+    bool ioError = false;
+    if (!cached) {
+      build_table(&f, size, format, src, &table, &ioError);
+      if (!ioError) media_lib_seek_put(key, &table);
+    }
+    f.close();
+    uint32_t ms = millis() - t0;
+    Serial.printf("debug seek -> %s: %s, %u punktów, %u s, %u ms (%s)\n", seek_index_format_name(table.format),
+                  seek_index_source_name(table.source), table.count, (unsigned)(table.durationMs / 1000), (unsigned)ms,
+                  cached ? "baza" : (ioError ? "błąd odczytu" : "nagłówki"));
+    publish(seq, key, &table, cached, ms);
+  }
+}
+
+// ======================= API =======================
+
+void seek_index_init(void)
+{
+  if (g_lock) return;
+  g_lock = xSemaphoreCreateMutex();
+  if (!g_lock) return;
+  if (xTaskCreatePinnedToCore(seek_task, "SeekIndex", 4096, NULL, 1, &g_task, 0) != pdPASS) {
+    Serial.println("debug seek -> Nie można uruchomić zadania tablic przewijania");
+    g_task = nullptr;
+  }
+}
+
+void seek_index_track(const char* path)
+{
+  if (!g_lock) return;
+  if (!path) path = "";
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (strncmp(g_reqPath, path, SEEK_INDEX_PATH_LENGTH) == 0) {
+    xSemaphoreGive(g_lock);
+    return;   // ten sam plik od nowa - tablica aktualna
+  }
+  strncpy(g_reqPath, path, SEEK_INDEX_PATH_LENGTH);
+  g_reqPath[SEEK_INDEX_PATH_LENGTH] = '\0';
+  g_reqSeq++;
+  g_ready = false;
+  g_durationMs = 0;
+  g_status.ready = false;
+  xSemaphoreGive(g_lock);
+  g_generation++;
+  if (g_task) xTaskNotifyGive(g_task);
+}
+
+uint32_t seek_index_generation(void)
+{
+  return g_generation;
+}
+
+bool seek_index_seek(const char* path, uint32_t ms)
+{
+  if (!g_lock || !path || !path[0]) return false;
+  uint32_t hash = media_lib_path_hash(path);
+  uint32_t offset = 0;
+  uint32_t target = ms;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  bool table = g_ready && g_tablePath == hash;
+  uint8_t format = table ? g_table.format : format_of(path);
+  if (table) {
+    uint32_t duration = g_table.durationMs;
+    if (ms > duration) ms = duration;   // bez przepełnienia ms + GUARD
+    if (duration - ms < SEEK_INDEX_END_GUARD_MS) ms = duration > SEEK_INDEX_END_GUARD_MS ? duration - SEEK_INDEX_END_GUARD_MS : 0;
+    offset = table_offset(&g_table, ms, &target);
+  }
+  xSemaphoreGive(g_lock);
+  if (!table) target = ms / 1000 * 1000;   // biblioteka przewija co sekundę
+
+  portENTER_CRITICAL(&g_mux);
+  g_pos.pending = true;
+  g_pos.measuring = false;
+  g_pos.targetMs = target;
+  g_pos.seekAt = millis();
+  g_pos.format = format;
+  portEXIT_CRITICAL(&g_mux);
+
+  if (table) audio_cmd_seek_file(offset);
+  else audio_cmd_seek_time(target / 1000);
+  Serial.printf("debug seek -> %s %u ms -> %s %u\n", seek_index_format_name(format), (unsigned)target,
+                table ? "pozycja" : "czas", (unsigned)(table ? offset : target / 1000));
+  return true;
+}
+
+uint32_t seek_index_position_ms(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  seek_pos_t p = g_pos;
+  portEXIT_CRITICAL(&g_mux);
+  if (p.pending) return p.targetMs;
+  return p.baseMs + (p.rate ? (uint32_t)(p.frames * 1000 / p.rate) : 0);
+}
+
+uint32_t seek_index_duration_ms(void)
+{
+  return g_durationMs;
+}
+
+bool seek_index_ready(void)
+{
+  return g_ready;
+}
+
+void seek_index_track_begin(uint32_t startMs)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_pos.baseMs = startMs;
+  g_pos.frames = 0;
+  g_pos.pending = false;
+  g_pos.measuring = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void seek_index_applied(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_pos.pending) {
+    g_pos.baseMs = g_pos.targetMs;
+    g_pos.frames = 0;
+    g_pos.pending = false;
+    g_pos.measuring = true;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void seek_index_rejected(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_pos.pending = false;
+  g_pos.measuring = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void seek_index_process(int32_t frames, uint32_t sampleRate)
+{
+  if (frames <= 0 || !sampleRate) return;
+  uint32_t now = millis();
+  portENTER_CRITICAL(&g_mux);
+  if (g_pos.rate != sampleRate) {
+    if (g_pos.rate) g_pos.baseMs += (uint32_t)(g_pos.frames * 1000 / g_pos.rate);   // zmiana częstotliwości - licznik od nowa
+    g_pos.frames = 0;
+    g_pos.rate = sampleRate;
+  }
+  g_pos.frames += frames;
+  if (g_pos.pending && now - g_pos.seekAt > SEEK_INDEX_LATENCY_MAX_MS) g_pos.pending = false;   // polecenie utracone
+  if (g_pos.measuring) {
+    g_pos.measuring = false;
+    uint32_t ms = now - g_pos.seekAt;
+    if (ms <= SEEK_INDEX_LATENCY_MAX_MS) {
+      seek_latency_t* l = &g_latency[g_pos.format < SEEK_FORMAT_COUNT ? g_pos.format : (uint8_t)SEEK_FORMAT_OTHER];
+      l->seeks++;
+      l->lastMs = ms;
+      l->avgMs = (uint32_t)(((uint64_t)l->avgMs * (l->seeks - 1) + ms) / l->seeks);
+      if (ms > l->maxMs) l->maxMs = ms;
+    }
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void seek_index_get_status(seek_index_status_t* out)
+{
+  if (!out) return;
+  if (g_lock) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    *out = g_status;
+    xSemaphoreGive(g_lock);
+  } else {
+    memset(out, 0, sizeof(*out));
+  }
+  portENTER_CRITICAL(&g_mux);
+  memcpy(out->latency, g_latency, sizeof(out->latency));
+  portEXIT_CRITICAL(&g_mux);
+  media_lib_status_t lib;
+  media_lib_get_status(&lib);
+  out->tables = lib.seekTables;
+}
+
+const char* seek_index_format_name(uint8_t format)
+{
+  switch (format) {
+    case SEEK_FORMAT_MP3:  return "MP3";
+    case SEEK_FORMAT_FLAC: return "FLAC";
+    case SEEK_FORMAT_M4A:  return "M4A";
+    case SEEK_FORMAT_WAV:  return "WAV";
+    default:               return "other";
+  }
+}
+
+const char* seek_index_source_name(uint8_t source)
+{
+  switch (source) {
+    case SEEK_SOURCE_XING:         return "xing";
+    case SEEK_SOURCE_VBRI:         return "vbri";
+    case SEEK_SOURCE_SEEKTABLE:    return "seektable";
+    case SEEK_SOURCE_SAMPLE_TABLE: return "sample_table";
+    case SEEK_SOURCE_LINEAR:       return "linear";
+    default:                       return "none";
+  }
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "MediaLibrary.h"
+
+// ========================================================================
+// SEEK INDEX - pozycja i przewijanie utworów odtwarzacza SD
+// ========================================================================
+// Tablica przewijania (czas -> pozycja w pliku) z nagłówków pliku:
+//   - MP3  : TOC Xing / Info (100 punktów, % danych) albo VBRI,
+//            bez TOC (CBR) - pozycja proporcjonalna,
+//   - FLAC : blok SEEKTABLE (punkty co kilka sekund), bez niego
+//            proporcjonalnie - dekoder szuka synchronizacji ramki,
+//   - M4A  : stts + stsc + stco / co64 - początki porcji (chunk), czyli
+//            dokładne granice próbek AAC / ALAC,
+//   - WAV  : początek danych + byteRate, wyrównanie do bloku próbek.
+// Tablica budowana raz (zadanie "SeekIndex", odczyt przez harmonogram SD)
+// i zapisywana w bazie biblioteki (media_lib_seek_put) - kolejne
+// odtworzenia czytają jeden rekord. Przewinięcie = wyszukanie binarne
+// w tablicy bieżącego utworu w pamięci + jeden odczyt dekodera od
+// wyliczonej pozycji (setAudioFilePosition) zamiast przeszukiwania pliku od początku.
+// OGG / AAC (ADTS) bez tablicy - przewijanie wg czasu biblioteki audio.
+//
+// Pozycja odtwarzania = punkt startu (plik / przewinięcie) + ramki
+// policzone w torze próbek - niezależna od szacunku dekodera dla VBR.
+// Opóźnienie przewinięcia (polecenie -> pierwsze próbki z nowej pozycji)
+// mierzone per format - /sdplayer/api/seek.
+// ========================================================================
+
+static const uint16_t SEEK_INDEX_POINTS         = 256;     // punkty tablicy (czas -> pozycja)
+static const uint16_t SEEK_INDEX_PATH_LENGTH    = 255;
+static const uint16_t SEEK_INDEX_IO_CHUNK       = 512;     // odczyt tablic M4A / FLAC blokami
+static const uint16_t SEEK_INDEX_IO_MAX_WAIT_MS = 1000;    // czekanie na przerwę w odtwarzaniu przy odczycie
+static const uint32_t SEEK_INDEX_LATENCY_MAX_MS = 5000;    // przewinięcie bez próbek dłużej - pomiar porzucony
+static const uint32_t SEEK_INDEX_END_GUARD_MS   = 1000;    // przewinięcie za koniec -> tyle przed końcem
+static const uint32_t SEEK_INDEX_MP3_SYNC_SCAN  = 65536;   // szukanie pierwszej ramki MP3 za ID3v2
+
+typedef enum {
+  SEEK_FORMAT_OTHER = 0,       // OGG / AAC - przewijanie biblioteki audio
+  SEEK_FORMAT_MP3,
+  SEEK_FORMAT_FLAC,
+  SEEK_FORMAT_M4A,
+  SEEK_FORMAT_WAV,
+  SEEK_FORMAT_COUNT
+} seek_format_t;
+
+typedef enum {
+  SEEK_SOURCE_NONE = 0,        // brak tablicy
+  SEEK_SOURCE_XING,            // MP3 TOC Xing / Info
+  SEEK_SOURCE_VBRI,            // MP3 TOC VBRI
+  SEEK_SOURCE_SEEKTABLE,       // FLAC SEEKTABLE
+  SEEK_SOURCE_SAMPLE_TABLE,    // M4A stts / stsc / stco
+  SEEK_SOURCE_LINEAR           // WAV, MP3 CBR, FLAC bez SEEKTABLE
+} seek_source_t;
+
+typedef struct {
+  uint32_t ms;
+  uint32_t offset;             // pozycja w pliku
+} seek_point_t;
+
+// Rekord bazy biblioteki - rozmiar = MEDIA_SEEK_BYTES
+typedef struct {
+  uint32_t fileSize;           // inny rozmiar = plik zmieniony, tablica od nowa
+  uint32_t durationMs;
+  uint32_t dataStart;          // pierwsza ramka audio
+  uint32_t dataEnd;
+  uint16_t align;              // wyrównanie pozycji (blok próbek WAV), 1 = bez
+  uint8_t  format;             // seek_format_t
+  uint8_t  source;             // seek_source_t
+  uint16_t count;              // punkty w points[]
+  bool     exact;              // punkty = granice ramek / próbek (M4A) - bez interpolacji
+  uint8_t  reserved;
+  seek_point_t points[SEEK_INDEX_POINTS];
+} seek_table_t;
+
+typedef struct {
+  uint32_t seeks;
+  uint32_t lastMs;             // polecenie -> pierwsze próbki z nowej pozycji
+  uint32_t avgMs;
+  uint32_t maxMs;
+} seek_latency_t;
+
+typedef struct {
+  bool     ready;              // tablica bieżącego utworu w pamięci
+  uint8_t  format;
+  uint8_t  source;
+  uint16_t points;
+  uint32_t durationMs;
+  uint32_t built;              // tablice zbudowane z nagłówków
+  uint32_t cacheHits;          // tablice z bazy biblioteki
+  uint32_t failed;             // format bez tablicy / błąd odczytu
+  uint32_t lastBuildMs;
+  uint32_t maxBuildMs;
+  uint32_t tables;             // rekordy w bazie
+  seek_latency_t latency[SEEK_FORMAT_COUNT];
+} seek_index_status_t;
+
+// Init - po media_lib_init() (zadanie "SeekIndex", rdzeń 0)
+void     seek_index_init(void);
+
+// Bieżący utwór (pełna ścieżka, pusty = brak) - tablica z bazy albo z nagłówków
+void     seek_index_track(const char* path);
+uint32_t seek_index_generation(void);       // zmiana = tablica gotowa (czas trwania znany)
+
+// Przewinięcie bieżącego utworu do ms - polecenie dla dekodera. false = nic nie gra
+bool     seek_index_seek(const char* path, uint32_t ms);
+
+// Pozycja / czas trwania [ms] bieżącego utworu, 0 = nieznany
+uint32_t seek_index_position_ms(void);
+uint32_t seek_index_duration_ms(void);
+bool     seek_index_ready(void);            // tablica bieżącego utworu w pamięci (przewijanie bez szukania w pliku)
+
+// Kontekst dekodera (AudioTask / audio_process_i2s)
+void     seek_index_track_begin(uint32_t startMs);   // start pliku od startMs
+void     seek_index_applied(void);                   // wykonane przewinięcie
+void     seek_index_rejected(void);                  // przewinięcie odrzucone - pozycja bez zmian
+void     seek_index_process(int32_t frames, uint32_t sampleRate);
+
+void     seek_index_get_status(seek_index_status_t* out);
+const char* seek_index_format_name(uint8_t format);
+const char* seek_index_source_name(uint8_t source);
@@ -0,0 +1,358 @@
+#include "SdIo.h"
+#include "SDPlayer/PlayerState.h"   // odtwarzanie z karty w toku
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <FS.h>
+#include <string.h>
+
+extern fs::FS& getStorage();        // main.cpp - SD albo pamięć wewnętrzna (AUTOSTORAGE)
+
+// Maksymalne czekanie na przerwę zapisu odłożonego (zadanie w tle - może czekać dłużej)
+static const uint32_t DEFERRED_MAX_WAIT_MS[SDIO_CLASS_COUNT] = { 5000, 10000, 0, 0, 0, 0, 0 };
+
+// ======================= STAN =======================
+
+typedef struct {
+  bool     used;
+  uint8_t  cls;
+  char     path[SDIO_PATH_LENGTH + 1];
+  uint8_t* data;
+  size_t   len;
+  size_t   capacity;
+  uint32_t submittedAt;   // pierwsze zgłoszenie (opóźnienie liczone od niego)
+  uint32_t dueAt;         // ostatnie zgłoszenie + SDIO_COALESCE_MS
+} sdio_pending_t;
+
+typedef struct {
+  uint32_t ops;
+  uint32_t bytes;
+  uint32_t coalesced;
+  uint64_t waitSumMs;
+  uint32_t waitMaxMs;
+  uint64_t opSumMs;
+  uint32_t opMaxMs;
+  uint32_t gapTimeouts;
+  uint32_t stalls;
+  uint32_t failed;
+} sdio_counters_t;
+
+static Audio*            g_audio = nullptr;
+static SemaphoreHandle_t g_lock = nullptr;     // kolejka + liczniki
+static SemaphoreHandle_t g_bus = nullptr;      // jedna operacja harmonogramu naraz
+static sdio_pending_t    g_pending[SDIO_PENDING_MAX];
+static sdio_counters_t   g_cnt[SDIO_CLASS_COUNT];
+static uint8_t           g_highWater = 0;
+static uint32_t          g_lowEvents = 0;
+static uint32_t          g_ioStalls = 0;
+static volatile bool     g_opActive = false;
+static volatile uint8_t  g_opClass = 0;
+static volatile uint32_t g_opEndAt = 0;
+static bool              g_low = false;        // bufor poniżej SDIO_STALL_FILL (zbocze = zdarzenie)
+static uint32_t          g_beginAt = 0;        // sdio_begin() -> sdio_end()
+static uint32_t          g_beginWait = 0;
+
+// ======================= POMOCNICZE =======================
+
+static void* io_realloc(void* ptr, size_t size)
+{
+  void* p = psramFound() ? ps_realloc(ptr, size) : nullptr;
+  if (!p) p = realloc(ptr, size);
+  return p;
+}
+
+static bool playback_active(void)
+{
+  return player_state_playing() && g_audio && g_audio->isRunning();
+}
+
+static uint8_t queue_depth(void)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < SDIO_PENDING_MAX; i++) {
+    if (g_pending[i].used) n++;
+  }
+  return n;
+}
+
+// Czekanie na zapas w buforze dekodera; false = minął maxWaitMs bez przerwy
+static bool wait_gap(uint32_t maxWaitMs)
+{
+  uint32_t t0 = millis();
+  while (playback_active() && g_audio->inBufferFilled() < SDIO_GAP_MIN_FILL) {
+    if (millis() - t0 >= maxWaitMs) return false;
+    vTaskDelay(pdMS_TO_TICKS(SDIO_TICK_MS));
+  }
+  return true;
+}
+
+static void record_op(uint8_t cls, uint32_t waitMs, uint32_t opMs, uint32_t bytes, bool gapTimeout)
+{
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  sdio_counters_t* c = &g_cnt[cls];
+  c->ops++;
+  c->bytes += bytes;
+  c->waitSumMs += waitMs;
+  if (waitMs > c->waitMaxMs) c->waitMaxMs = waitMs;
+  c->opSumMs += opMs;
+  if (opMs > c->opMaxMs) c->opMaxMs = opMs;
+  if (gapTimeout) c->gapTimeouts++;
+  xSemaphoreGive(g_lock);
+}
+
+// Spadek bufora dekodera - liczony na zboczu, przypisany operacji w toku / zakończonej przed chwilą
+static void check_buffer(void)
+{
+  if (!playback_active()) { g_low = false; return; }
+  bool low = g_audio->inBufferFilled() < SDIO_STALL_FILL;
+  if (low && !g_low) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    g_lowEvents++;
+    if (g_opActive || millis() - g_opEndAt < SDIO_STALL_WINDOW_MS) {
+      g_ioStalls++;
+      g_cnt[g_opClass].stalls++;
+    }
+    xSemaphoreGive(g_lock);
+  }
+  g_low = low;
+}
+
+static void op_start(uint8_t cls)
+{
+  g_opClass = cls;
+  g_opActive = true;
+}
+
+static void op_finish(void)
+{
+  g_opEndAt = millis();
+  g_opActive = false;
+}
+
+static bool write_once(const char* path, const uint8_t* data, size_t len)
+{
+  File f = getStorage().open(path, FILE_WRITE);
+  if (!f) {
+    Serial.printf("debug sdio -> Błąd otwarcia %s do zapisu\n", path);
+    return false;
+  }
+  size_t written = f.write(data, len);
+  f.close();
+  if (written != len) {
+    Serial.printf("debug sdio -> Błąd zapisu %s (%u z %u B)\n", path, (unsigned)written, (unsigned)len);
+    return false;
+  }
+  return true;
+}
+
+// Zapis całego pliku (pod g_bus) - kilka prób, po ostatniej treść jest tracona
+static bool write_now(const char* path, const uint8_t* data, size_t len, uint8_t cls)
+{
+  for (uint8_t attempt = 1; attempt <= SDIO_WRITE_RETRIES; attempt++) {
+    if (write_once(path, data, len)) return true;
+    if (attempt < SDIO_WRITE_RETRIES) delay(SDIO_RETRY_DELAY_MS);
+  }
+  Serial.printf("debug sdio -> Zapis %s utracony po %u próbach\n", path, (unsigned)SDIO_WRITE_RETRIES);
+  if (g_lock) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    g_cnt[cls].failed++;
+    xSemaphoreGive(g_lock);
+  }
+  return false;
+}
+
+// Zdjęcie z kolejki najstarszego wpisu gotowego do zapisu (force = wszystkie, bez odczekania)
+static bool take_due(sdio_pending_t* out, bool force)
+{
+  int8_t best = -1;
+  uint32_t now = millis();
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  for (uint8_t i = 0; i < SDIO_PENDING_MAX; i++) {
+    sdio_pending_t* p = &g_pending[i];
+    if (!p->used) continue;
+    if (!force && (int32_t)(now - p->dueAt) < 0) continue;
+    if (best < 0 || (int32_t)(p->submittedAt - g_pending[best].submittedAt) < 0) best = i;
+  }
+  if (best >= 0) {
+    *out = g_pending[best];
+    // Dane przechodzą do wywołującego - slot dostaje nowy bufor przy następnym zgłoszeniu
+    g_pending[best].used = false;
+    g_pending[best].data = nullptr;
+    g_pending[best].capacity = 0;
+  }
+  xSemaphoreGive(g_lock);
+  return best >= 0;
+}
+
+static void run_pending(sdio_pending_t* p, bool force)
+{
+  // Czekanie przed zajęciem g_bus - wgrywanie nie stoi za odłożonym zapisem
+  bool gap = force ? true : wait_gap(DEFERRED_MAX_WAIT_MS[p->cls]);
+  xSemaphoreTake(g_bus, portMAX_DELAY);
+  uint32_t t0 = millis();
+  op_start(p->cls);
+  write_now(p->path, p->data, p->len, p->cls);
+  op_finish();
+  uint32_t opMs = millis() - t0;
+  xSemaphoreGive(g_bus);
+
+  record_op(p->cls, t0 - p->submittedAt, opMs, p->len, !gap);
+  free(p->data);
+  p->data = nullptr;
+}
+
+static void sdio_task(void* arg)
+{
+  sdio_pending_t p;
+  for (;;) {
+    check_buffer();
+    if (take_due(&p, false)) {
+      run_pending(&p, false);
+      check_buffer();
+    }
+    vTaskDelay(pdMS_TO_TICKS(SDIO_TICK_MS));
+  }
+}
+
+// ======================= API =======================
+
+void sdio_init(Audio* audio)
+{
+  if (g_lock) return;
+  g_audio = audio;
+  g_lock = xSemaphoreCreateMutex();
+  g_bus = xSemaphoreCreateMutex();
+  if (!g_lock || !g_bus) {
+    Serial.println("debug sdio -> Brak pamięci na semafory");
+    return;
+  }
+  if (xTaskCreatePinnedToCore(sdio_task, "SdIo", 4096, NULL, 1, NULL, 0) != pdPASS) {
+    Serial.println("debug sdio -> Nie można uruchomić zadania SdIo");
+  }
+}
+
+bool sdio_write_file(const char* path, const void* data, size_t len, uint8_t cls)
+{
+  if (cls >= SDIO_CLASS_COUNT) cls = SDIO_CLASS_CONFIG;
+  if (!g_lock || strlen(path) > SDIO_PATH_LENGTH) {
+    // Bez harmonogramu - zapis od razu jak dotąd
+    return write_now(path, (const uint8_t*)data, len, cls);
+  }
+
+  uint32_t now = millis();
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  int8_t slot = -1;
+  int8_t freeSlot = -1;
+  for (uint8_t i = 0; i < SDIO_PENDING_MAX; i++) {
+    if (g_pending[i].used && strcmp(g_pending[i].path, path) == 0) { slot = i; break; }
+    if (!g_pending[i].used && freeSlot < 0) freeSlot = i;
+  }
+
+  bool queued = false;
+  sdio_pending_t* p = nullptr;
+  if (slot >= 0) {
+    p = &g_pending[slot];
+    g_cnt[p->cls].coalesced++;     // poprzednia treść nie trafi na kartę
+  } else if (freeSlot >= 0) {
+    p = &g_pending[freeSlot];
+    p->submittedAt = now;
+  }
+  if (p) {
+    if (p->capacity < len) {
+      uint8_t* buf = (uint8_t*)io_realloc(p->data, len);
+      if (buf) { p->data = buf; p->capacity = len; }
+    }
+    if (p->capacity >= len) {
+      memcpy(p->data, data, len);
+      p->len = len;
+      p->cls = cls;
+      strcpy(p->path, path);
+      p->dueAt = now + SDIO_COALESCE_MS;
+      p->used = true;
+      queued = true;
+      uint8_t depth = queue_depth();
+      if (depth > g_highWater) g_highWater = depth;
+    }
+  }
+  xSemaphoreGive(g_lock);
+
+  if (queued) return true;
+
+  // Kolejka pełna / brak pamięci - zapis od razu, ale też pod harmonogramem
+  Serial.printf("debug sdio -> Kolejka pełna, zapis %s od razu\n", path);
+  sdio_begin(cls, 0);
+  bool ok = write_now(path, (const uint8_t*)data, len, cls);
+  sdio_end(cls, len);
+  return ok;
+}
+
+void sdio_flush(void)
+{
+  if (!g_lock) return;
+  sdio_pending_t p;
+  while (take_due(&p, true)) {
+    run_pending(&p, true);
+  }
+  // Wpis zdjęty z kolejki przez zadanie SdIo może być jeszcze w zapisie
+  xSemaphoreTake(g_bus, portMAX_DELAY);
+  xSemaphoreGive(g_bus);
+}
+
+void sdio_begin(uint8_t cls, uint32_t maxWaitMs)
+{
+  if (!g_bus) return;
+  if (cls >= SDIO_CLASS_COUNT) cls = SDIO_CLASS_CONFIG;
+  uint32_t t0 = millis();
+  bool gap = wait_gap(maxWaitMs);
+  xSemaphoreTake(g_bus, portMAX_DELAY);
+  if (!gap) {
+    xSemaphoreTake(g_lock, portMAX_DELAY);
+    g_cnt[cls].gapTimeouts++;
+    xSemaphoreGive(g_lock);
+  }
+  g_beginAt = millis();
+  g_beginWait = g_beginAt - t0;
+  op_start(cls);
+}
+
+void sdio_end(uint8_t cls, uint32_t bytes)
+{
+  if (!g_bus) return;
+  if (cls >= SDIO_CLASS_COUNT) cls = SDIO_CLASS_CONFIG;
+  op_finish();
+  uint32_t opMs = millis() - g_beginAt;
+  uint32_t waitMs = g_beginWait;
+  xSemaphoreGive(g_bus);
+  record_op(cls, waitMs, opMs, bytes, false);
+}
+
+void sdio_get_status(sdio_status_t* out)
+{
+  memset(out, 0, sizeof(*out));
+  out->playback = playback_active();
+  if (g_audio) {
+    out->bufferFill = g_audio->inBufferFilled();
+    out->bufferSize = g_audio->getInBufferSize();
+  }
+  if (!g_lock) return;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  out->queueDepth = queue_depth();
+  out->queueHighWater = g_highWater;
+  out->lowBufferEvents = g_lowEvents;
+  out->ioStalls = g_ioStalls;
+  for (uint8_t i = 0; i < SDIO_CLASS_COUNT; i++) {
+    const sdio_counters_t* c = &g_cnt[i];
+    sdio_class_stats_t* s = &out->cls[i];
+    s->ops = c->ops;
+    s->bytes = c->bytes;
+    s->coalesced = c->coalesced;
+    s->waitAvgMs = c->ops ? (uint32_t)(c->waitSumMs / c->ops) : 0;
+    s->waitMaxMs = c->waitMaxMs;
+    s->opAvgMs = c->ops ? (uint32_t)(c->opSumMs / c->ops) : 0;
+    s->opMaxMs = c->opMaxMs;
+    s->gapTimeouts = c->gapTimeouts;
+    s->stalls = c->stalls;
+    s->failed = c->failed;
+  }
+  xSemaphoreGive(g_lock);
+}
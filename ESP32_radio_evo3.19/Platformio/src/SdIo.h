@@ -0,0 +1,89 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "Audio.h"
+
+// ========================================================================
+// SD IO - harmonogram operacji na karcie (odtwarzanie ma pierwszeństwo)
+// ========================================================================
+// Odtwarzanie pliku z karty (connecttoFS) czyta przez bibliotekę audio,
+// pozostali użytkownicy karty piszą synchronicznie z własnych zadań.
+// Krótki zapis konfiguracji w trakcie odtwarzania FLAC potrafił opróżnić
+// bufor wejściowy dekodera. Teraz:
+//   - odczyt z wyprzedzeniem: odtwarzanie pliku zawsze z buforem
+//     wejściowym SDIO_READAHEAD_BYTES w PSRAM (po stacji radiowej bufor
+//     bywa mały - BufferControl dobiera go per stacja),
+//   - zapisy konfiguracji (głośność, stacja / bank, EQ16) przez
+//     sdio_write_file(): kopia treści w PSRAM, kolejny zapis tego samego
+//     pliku przed wykonaniem zastępuje poprzedni (łączenie), zadanie
+//     "SdIo" zapisuje po SDIO_COALESCE_MS w przerwie - gdy w buforze
+//     dekodera jest co najmniej SDIO_GAP_MIN_FILL bajtów,
+//   - operacje synchroniczne (bloki wgrywanego pliku) w nawiasie
+//     sdio_begin() / sdio_end() - to samo czekanie na przerwę, krócej.
+// Pomiar: głębokość kolejki, opóźnienie i czas operacji per klasa,
+// spadki bufora dekodera poniżej SDIO_STALL_FILL (wszystkie i te w czasie
+// / tuż po operacji na karcie).
+// ========================================================================
+
+static const uint32_t SDIO_READAHEAD_BYTES = 512 * 1024;   // bufor wejściowy przy odtwarzaniu z karty
+static const uint32_t SDIO_GAP_MIN_FILL    = 96 * 1024;    // zapis dopiero przy takim zapasie w buforze (~1 s FLAC)
+static const uint32_t SDIO_STALL_FILL      = 16 * 1024;    // poniżej = zagrożenie przerwy w odtwarzaniu
+static const uint16_t SDIO_COALESCE_MS     = 1500;         // zapis konfiguracji odłożony - seria zmian = jeden zapis
+static const uint16_t SDIO_STALL_WINDOW_MS = 500;          // spadek bufora tyle po operacji - przypisany operacji
+static const uint32_t SDIO_UPLOAD_MAX_WAIT_MS = 300;       // wgrywanie czeka w zadaniu serwera WWW - krótko
+static const uint8_t  SDIO_PENDING_MAX     = 12;           // pliki oczekujące na zapis
+static const uint8_t  SDIO_PATH_LENGTH     = 47;
+static const uint16_t SDIO_TICK_MS         = 10;
+static const uint8_t  SDIO_WRITE_RETRIES   = 3;            // próby zapisu pliku zanim treść zostanie utracona
+static const uint16_t SDIO_RETRY_DELAY_MS  = 50;
+
+typedef enum {
+  SDIO_CLASS_CONFIG = 0,         // pliki konfiguracji (odłożone, łączone)
+  SDIO_CLASS_LOG,                // dzienniki
+  SDIO_CLASS_UPLOAD,             // wgrywanie plików z WWW
+  SDIO_CLASS_COVER,              // odczyt okładek (dekoder w tle)
+  SDIO_CLASS_LOUDNESS,           // odczyt plików do analizy głośności (ReplayGain)
+  SDIO_CLASS_SEEK,               // odczyt tablic przewijania z nagłówków plików (SeekIndex)
+  SDIO_CLASS_LIBRARY,            // zapis bazy biblioteki (MediaLibrary)
+  SDIO_CLASS_COUNT
+} sdio_class_t;
+
+typedef struct {
+  uint32_t ops;
+  uint32_t bytes;
+  uint32_t coalesced;            // zapisy zastąpione nowszą treścią przed wykonaniem
+  uint32_t waitAvgMs;            // zgłoszenie -> start operacji (odłożenie + czekanie na przerwę)
+  uint32_t waitMaxMs;
+  uint32_t opAvgMs;              // czas samej operacji na karcie
+  uint32_t opMaxMs;
+  uint32_t gapTimeouts;          // operacja bez przerwy w odtwarzaniu (minął maks. czas czekania)
+  uint32_t stalls;               // spadki bufora dekodera w czasie / tuż po operacji tej klasy
+  uint32_t failed;               // zapisy utracone po SDIO_WRITE_RETRIES próbach
+} sdio_class_stats_t;
+
+typedef struct {
+  uint8_t  queueDepth;
+  uint8_t  queueHighWater;
+  bool     playback;             // odtwarzanie z karty w toku
+  uint32_t bufferFill;           // bufor wejściowy dekodera
+  uint32_t bufferSize;
+  uint32_t lowBufferEvents;      // wszystkie spadki poniżej SDIO_STALL_FILL w czasie odtwarzania z karty
+  uint32_t ioStalls;             // z tego w czasie / tuż po operacji na karcie
+  sdio_class_stats_t cls[SDIO_CLASS_COUNT];
+} sdio_status_t;
+
+// Init - w setup() po uruchomieniu karty (zadanie "SdIo", rdzeń 0)
+void sdio_init(Audio* audio);
+
+// Zapis całego pliku w tle (kopia danych). false = brak miejsca w kolejce -> zapis od razu
+bool sdio_write_file(const char* path, const void* data, size_t len, uint8_t cls);
+
+// Zapis oczekujących plików od razu i czekanie na zapis w toku - przed restartem, uśpieniem, OTA
+void sdio_flush(void);
+
+// Operacja synchroniczna: czekanie na przerwę (maks. maxWaitMs) i wyłączność między użytkownikami harmonogramu
+void sdio_begin(uint8_t cls, uint32_t maxWaitMs);
+void sdio_end(uint8_t cls, uint32_t bytes);
+
+void sdio_get_status(sdio_status_t* out);
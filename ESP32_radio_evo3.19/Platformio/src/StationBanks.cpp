@@ -0,0 +1,224 @@
+#include "StationBanks.h"
+#include <string.h>
+
+// ======================= ARENA PSRAM =======================
+
+typedef struct {
+  char*    data;
+  uint32_t used;
+  uint32_t size;
+} arena_t;
+
+static void* banks_realloc(void* ptr, size_t size)
+{
+  void* p = ps_realloc(ptr, size);
+  if (!p) p = realloc(ptr, size);   // bez PSRAM - pamięć wewnętrzna
+  return p;
+}
+
+// Dopisuje tekst z terminatorem, zwraca offset lub UINT32_MAX przy braku pamięci
+static uint32_t arena_push(arena_t* a, const char* s, uint32_t len, uint32_t initialSize)
+{
+  if (a->used + len + 1 > a->size)
+  {
+    uint32_t newSize = a->size ? a->size : initialSize;
+    while (a->used + len + 1 > newSize) newSize *= 2;
+    char* d = (char*)banks_realloc(a->data, newSize);
+    if (!d) return UINT32_MAX;
+    a->data = d;
+    a->size = newSize;
+  }
+  uint32_t off = a->used;
+  memcpy(a->data + off, s, len);
+  a->data[off + len] = '\0';
+  a->used += len + 1;
+  return off;
+}
+
+// ======================= REJESTR BANKÓW =======================
+
+typedef struct {
+  uint32_t name;  // offsety w arenie rejestru
+  uint32_t url;
+  uint32_t file;
+} bank_entry_t;
+
+static arena_t       g_regArena = {nullptr, 0, 0};
+static bank_entry_t* g_banks = nullptr;
+static uint8_t       g_bankCount = 0;
+
+bool bank_registry_init(void)
+{
+  if (g_banks) return true;
+  g_banks = (bank_entry_t*)banks_realloc(nullptr, BANK_REGISTRY_MAX * sizeof(bank_entry_t));
+  return g_banks != nullptr;
+}
+
+void bank_registry_clear(void)
+{
+  g_bankCount = 0;
+  g_regArena.used = 0;
+}
+
+bool bank_registry_add(const char* name, const char* url, const char* file)
+{
+  if (!g_banks || g_bankCount >= BANK_REGISTRY_MAX || !url || !*url) return false;
+
+  char defName[12];
+  char defFile[16];
+  uint8_t bank = g_bankCount + 1;
+  if (!name || !*name) { snprintf(defName, sizeof(defName), "Bank %u", bank); name = defName; }
+  if (!file || !*file) { snprintf(defFile, sizeof(defFile), "/bank%02u.txt", bank); file = defFile; }
+
+  bank_entry_t e;
+  e.name = arena_push(&g_regArena, name, strlen(name), 2048);
+  e.url  = arena_push(&g_regArena, url, strlen(url), 2048);
+  e.file = arena_push(&g_regArena, file, strlen(file), 2048);
+  if (e.name == UINT32_MAX || e.url == UINT32_MAX || e.file == UINT32_MAX) return false;
+
+  g_banks[g_bankCount++] = e;
+  return true;
+}
+
+// Usuwa białe znaki z początku i końca pola (w miejscu)
+static char* trim_field(char* s)
+{
+  while (*s == ' ' || *s == '\t') s++;
+  char* end = s + strlen(s);
+  while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+  *end = '\0';
+  return s;
+}
+
+uint8_t bank_registry_load(fs::FS& fs, const char* path)
+{
+  if (!g_banks || !fs.exists(path)) return 0;
+
+  File f = fs.open(path, FILE_READ);
+  if (!f) return 0;
+
+  bank_registry_clear();
+  char line[STATION_LINE_MAX_LENGTH + 1];
+  while (f.available())
+  {
+    size_t len = f.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[len] = '\0';
+
+    char* p = trim_field(line);
+    if (*p == '\0' || *p == '#') continue;
+
+    char* name = p;
+    char* url = strchr(name, ';');
+    if (!url) continue;
+    *url++ = '\0';
+    char* file = strchr(url, ';');
+    if (file) *file++ = '\0';
+
+    if (!bank_registry_add(trim_field(name), trim_field(url), file ? trim_field(file) : nullptr))
+    {
+      Serial.println("debug banks -> Błąd: brak miejsca w rejestrze banków");
+      break;
+    }
+  }
+  f.close();
+
+  Serial.printf("debug banks -> Wczytano %u banków z pliku %s\n", g_bankCount, path);
+  return g_bankCount;
+}
+
+uint8_t bank_registry_count(void)
+{
+  return g_bankCount;
+}
+
+const char* bank_registry_name(uint8_t bank)
+{
+  if (bank == 0 || bank > g_bankCount) return "";
+  return g_regArena.data + g_banks[bank - 1].name;
+}
+
+const char* bank_registry_url(uint8_t bank)
+{
+  if (bank == 0 || bank > g_bankCount) return "";
+  return g_regArena.data + g_banks[bank - 1].url;
+}
+
+const char* bank_registry_file(uint8_t bank)
+{
+  if (bank == 0 || bank > g_bankCount) return "";
+  return g_regArena.data + g_banks[bank - 1].file;
+}
+
+// ======================= LISTA STACJI =======================
+
+static arena_t   g_stationArena = {nullptr, 0, 0};
+static uint32_t* g_offsets = nullptr;       // offset linii stacji w arenie
+static uint16_t  g_stationCount = 0;
+static uint16_t  g_offsetCapacity = 0;
+
+bool station_store_init(void)
+{
+  if (g_offsets) return true;
+  g_offsetCapacity = 128;
+  g_offsets = (uint32_t*)banks_realloc(nullptr, g_offsetCapacity * sizeof(uint32_t));
+  if (!g_offsets) { g_offsetCapacity = 0; return false; }
+  return true;
+}
+
+void station_store_clear(void)
+{
+  // Pamięć zostaje zarezerwowana - kolejny bank zwykle ma podobny rozmiar
+  g_stationCount = 0;
+  g_stationArena.used = 0;
+}
+
+bool station_store_add(const char* line)
+{
+  if (!g_offsets || !line || g_stationCount == UINT16_MAX) return false;
+
+  uint32_t len = strlen(line);
+  if (len > STATION_LINE_MAX_LENGTH) return false;
+
+  if (g_stationCount >= g_offsetCapacity)
+  {
+    uint16_t newCapacity = (g_offsetCapacity > UINT16_MAX / 2) ? UINT16_MAX : g_offsetCapacity * 2;
+    uint32_t* o = (uint32_t*)banks_realloc(g_offsets, newCapacity * sizeof(uint32_t));
+    if (!o) return false;
+    g_offsets = o;
+    g_offsetCapacity = newCapacity;
+  }
+
+  uint32_t off = arena_push(&g_stationArena, line, len, 16 * 1024);
+  if (off == UINT32_MAX) return false;
+
+  g_offsets[g_stationCount++] = off;
+  return true;
+}
+
+uint16_t station_store_count(void)
+{
+  return g_stationCount;
+}
+
+uint16_t station_store_get(uint16_t index, char* out, uint16_t outSize)
+{
+  if (!out || outSize == 0) return 0;
+  out[0] = '\0';
+  if (index >= g_stationCount) return 0;
+
+  const char* s = g_stationArena.data + g_offsets[index];
+  uint16_t n = 0;
+  while (s[n] && n + 1 < outSize) { out[n] = s[n]; n++; }
+  out[n] = '\0';
+  return n;
+}
+
+uint32_t station_store_get_bytes_used(void)
+{
+  return g_stationArena.used + g_stationCount * sizeof(uint32_t);
+}
+
+uint32_t station_store_get_bytes_reserved(void)
+{
+  return g_stationArena.size + g_offsetCapacity * sizeof(uint32_t);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <FS.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STATION BANKS - rejestr banków i lista stacji bieżącego banku w PSRAM
+// ========================================================================
+// REJESTR BANKÓW - plik /banks.txt na karcie (lub LittleFS), jedna linia
+// na bank, pola rozdzielone średnikiem:
+//   nazwa;url;plik
+//   Jazz;https://example.com/jazz.txt;/jazz.txt
+// Linie zaczynające się od '#' są komentarzem. Puste pole "plik" oznacza
+// domyślną nazwę /bankNN.txt. Brak pliku = domyślne banki z STATIONS_URLx.
+//
+// LISTA STACJI - linie banku leżą jedna za drugą w arenie PSRAM (bez
+// stałych slotów), arena i tablica offsetów rosną w miarę potrzeby.
+// Liczba stacji w banku i długość linii nie są ograniczone w czasie
+// kompilacji - jedynie ilością wolnej pamięci PSRAM.
+// ========================================================================
+
+static const uint8_t  BANK_REGISTRY_MAX      = 250;  // bank_nr jest uint8_t, 0 = granie z URL
+static const uint16_t STATION_LINE_MAX_LENGTH = 511; // najdłuższa akceptowana linia stacji
+static const uint8_t  STATION_NR_DIGITS_MAX   = 5;   // station_nr jest uint16_t - do 65535
+static const uint8_t  STATION_NR_STR_LENGTH   = STATION_NR_DIGITS_MAX + 1;   // numer stacji jako tekst + '\0'
+
+// Rejestr banków (numeracja banków od 1)
+bool        bank_registry_init(void);
+void        bank_registry_clear(void);
+bool        bank_registry_add(const char* name, const char* url, const char* file);
+uint8_t     bank_registry_load(fs::FS& fs, const char* path);   // zwraca liczbę banków, 0 = brak pliku
+uint8_t     bank_registry_count(void);
+const char* bank_registry_name(uint8_t bank);                   // "" gdy bank nie istnieje
+const char* bank_registry_url(uint8_t bank);
+const char* bank_registry_file(uint8_t bank);
+
+// Lista stacji bieżącego banku (indeks od 0)
+bool        station_store_init(void);
+void        station_store_clear(void);
+bool        station_store_add(const char* line);
+uint16_t    station_store_count(void);
+uint16_t    station_store_get(uint16_t index, char* out, uint16_t outSize);  // zwraca długość, 0 = brak
+uint32_t    station_store_get_bytes_used(void);
+uint32_t    station_store_get_bytes_reserved(void);
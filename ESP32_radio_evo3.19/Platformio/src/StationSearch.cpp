@@ -0,0 +1,533 @@
+#include "StationSearch.h"
+#include "StationBanks.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include <FS.h>
+#include <string.h>
+
+// External references for storage access
+extern fs::FS& getStorage();
+
+// ======================= STRUKTURY INDEKSU =======================
+
+// Wpis indeksu - nazwa i nazwa znormalizowana leżą jedna za drugą w arenie banku
+typedef struct {
+  uint16_t station;   // numer stacji w banku 1..n
+  uint32_t nameOff;   // offset nazwy w arenie (~86 B na stację - duże banki przekraczają 64 kB)
+  uint8_t  nameLen;   // długość nazwy (bez \0)
+  uint8_t  normLen;   // długość nazwy znormalizowanej (bez \0), zaraz za nazwą
+} entry_t;
+
+typedef struct {
+  entry_t* entries;
+  char*    arena;
+  uint16_t count;
+  uint32_t capacity;
+  uint32_t arenaUsed;
+  uint32_t arenaSize;
+  bool     indexed;   // bank zawiera aktualne dane
+} bank_index_t;
+
+static bank_index_t* g_banks = nullptr;               // BANK_REGISTRY_MAX + 1 wpisów, indeks 0 nieużywany (bank_nr od 1)
+static bank_index_t g_build;                          // bank w trakcie budowania
+static uint8_t      g_buildBank = 0;
+static uint8_t      g_bankCount = 0;
+static uint32_t     g_lastQueryUs = 0;
+static uint32_t     g_lastLoopMs = 0;
+
+static SemaphoreHandle_t g_lock = nullptr;
+
+static const uint16_t INITIAL_CAPACITY = 128;
+static const uint16_t ENTRY_ARENA_SIZE = 2 * (SEARCH_NAME_LENGTH + 1);
+static const uint32_t LOOP_INTERVAL_MS = 250;         // co ile indeksujemy kolejny bank z pliku
+
+// ======================= PAMIĘĆ =======================
+
+static void* search_alloc(size_t size)
+{
+  void* p = ps_malloc(size);
+  if (!p) p = malloc(size);   // bez PSRAM - pamięć wewnętrzna
+  return p;
+}
+
+static void* search_realloc(void* ptr, size_t size)
+{
+  void* p = ps_realloc(ptr, size);
+  if (!p) p = realloc(ptr, size);
+  return p;
+}
+
+static void bank_free(bank_index_t* b)
+{
+  if (b->entries) free(b->entries);
+  if (b->arena) free(b->arena);
+  memset(b, 0, sizeof(bank_index_t));
+}
+
+static bool bank_reserve(bank_index_t* b, uint32_t capacity)
+{
+  if (capacity <= b->capacity) return true;
+
+  entry_t* e = (entry_t*)search_realloc(b->entries, capacity * sizeof(entry_t));
+  if (!e) return false;
+  b->entries = e;
+
+  uint32_t arenaSize = (uint32_t)capacity * ENTRY_ARENA_SIZE;
+  char* a = (char*)search_realloc(b->arena, arenaSize);
+  if (!a) return false;
+  b->arena = a;
+  b->arenaSize = arenaSize;
+  b->capacity = capacity;
+  return true;
+}
+
+// ======================= NORMALIZACJA =======================
+
+// Mapowanie 2-bajtowych sekwencji UTF-8 (Latin-1 Supplement / Latin Extended-A) na ASCII
+static char fold_utf8(uint8_t lead, uint8_t cont)
+{
+  if (lead == 0xC3)
+  {
+    uint8_t c = cont & 0xDF;  // wielkie i małe litery różnią się bitem 0x20
+    if (c >= 0x80 && c <= 0x85) return 'a';
+    if (c == 0x87) return 'c';
+    if (c >= 0x88 && c <= 0x8B) return 'e';
+    if (c >= 0x8C && c <= 0x8F) return 'i';
+    if (c == 0x91) return 'n';
+    if ((c >= 0x92 && c <= 0x96) || c == 0x98) return 'o';
+    if (c >= 0x99 && c <= 0x9C) return 'u';
+    if (c == 0x9D || cont == 0xBF) return 'y';
+    if (cont == 0x9F) return 's';  // ß
+    return 0;
+  }
+  if (lead == 0xC4)
+  {
+    if (cont >= 0x80 && cont <= 0x85) return 'a';  // ą Ą ā ă
+    if (cont >= 0x86 && cont <= 0x8D) return 'c';  // ć Ć č
+    if (cont >= 0x8E && cont <= 0x91) return 'd';
+    if (cont >= 0x92 && cont <= 0x9B) return 'e';  // ę Ę ě
+    if (cont >= 0x9C && cont <= 0xA3) return 'g';
+    if (cont >= 0xA8 && cont <= 0xB1) return 'i';
+    if (cont >= 0xB9 && cont <= 0xBF) return 'l';
+    return 0;
+  }
+  if (lead == 0xC5)
+  {
+    if (cont >= 0x80 && cont <= 0x82) return 'l';  // ł Ł
+    if (cont >= 0x83 && cont <= 0x88) return 'n';  // ń Ń ň
+    if (cont >= 0x8C && cont <= 0x91) return 'o';  // ő
+    if (cont >= 0x94 && cont <= 0x99) return 'r';  // ř
+    if (cont >= 0x9A && cont <= 0xA1) return 's';  // ś Ś š
+    if (cont >= 0xA2 && cont <= 0xA7) return 't';
+    if (cont >= 0xA8 && cont <= 0xB3) return 'u';  // ű ů
+    if (cont >= 0xB9 && cont <= 0xBE) return 'z';  // ź ż ž
+    return 0;
+  }
+  return 0;
+}
+
+// Mapowanie pojedynczego bajtu (ASCII oraz polskie znaki Win-1250)
+static char fold_byte(uint8_t c)
+{
+  if (c >= 'a' && c <= 'z') return (char)c;
+  if (c >= '0' && c <= '9') return (char)c;
+  if (c >= 'A' && c <= 'Z') return (char)(c + 32);
+  switch (c)
+  {
+    case 0xA5: case 0xB9: return 'a';
+    case 0xC6: case 0xE6: return 'c';
+    case 0xCA: case 0xEA: return 'e';
+    case 0xA3: case 0xB3: return 'l';
+    case 0xD1: case 0xF1: return 'n';
+    case 0xD3: case 0xF3: return 'o';
+    case 0x8C: case 0x9C: case 0xA6: case 0xB6: return 's';
+    case 0x8F: case 0x9F: case 0xAC: case 0xBC: case 0xAF: case 0xBF: return 'z';
+  }
+  return ' ';  // wszystko inne działa jak separator słów
+}
+
+size_t station_search_normalize(const char* in, char* out, size_t outSize)
+{
+  if (!out || outSize == 0) return 0;
+  size_t n = 0;
+  bool lastSpace = true;  // pomijamy spacje na początku
+  const uint8_t* p = (const uint8_t*)in;
+
+  while (p && *p && n + 1 < outSize)
+  {
+    char c;
+    uint8_t b = *p;
+
+    if (b >= 0xC0 && b <= 0xDF && (p[1] & 0xC0) == 0x80)
+    {
+      c = fold_utf8(b, p[1]);
+      if (!c) c = ' ';
+      p += 2;
+    }
+    else if (b >= 0xE0 && b <= 0xEF && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80)
+    {
+      c = ' ';
+      p += 3;
+    }
+    else if (b >= 0xF0 && b <= 0xF7 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80)
+    {
+      c = ' ';
+      p += 4;
+    }
+    else
+    {
+      c = fold_byte(b);
+      p++;
+    }
+
+    if (c == ' ')
+    {
+      if (lastSpace) continue;
+      lastSpace = true;
+    }
+    else
+    {
+      lastSpace = false;
+    }
+    out[n++] = c;
+  }
+
+  while (n > 0 && out[n - 1] == ' ') n--;  // bez spacji na końcu
+  out[n] = '\0';
+  return n;
+}
+
+// Wycina nazwę stacji z linii banku - tak samo jak changeStation(): 41 znaków do podwójnej spacji
+static size_t extract_name(const char* line, char* out, size_t outSize)
+{
+  size_t n = 0;
+  while (line[n] && n < 41 && n + 1 < outSize)
+  {
+    if (line[n] == ' ' && line[n + 1] == ' ') break;
+    if (line[n] == 'h' && strncmp(line + n, "http", 4) == 0) break;
+    out[n] = line[n];
+    n++;
+  }
+  while (n > 0 && (out[n - 1] == ' ' || out[n - 1] == '\t')) n--;
+  out[n] = '\0';
+  return n;
+}
+
+// ======================= BUDOWANIE INDEKSU =======================
+
+static void build_add(bank_index_t* b, uint16_t station, const char* line)
+{
+  if (!strstr(line, "http")) return;  // linia bez adresu URL nie jest stacją
+  if (b->count >= b->capacity)
+  {
+    if (!bank_reserve(b, b->capacity ? b->capacity * 2 : INITIAL_CAPACITY)) return;
+  }
+
+  entry_t* e = &b->entries[b->count];
+  char* dst = b->arena + b->arenaUsed;
+
+  size_t nameLen = extract_name(line, dst, SEARCH_NAME_LENGTH + 1);
+  size_t normLen = station_search_normalize(dst, dst + nameLen + 1, SEARCH_NAME_LENGTH + 1);
+
+  e->station = station;
+  e->nameOff = b->arenaUsed;
+  e->nameLen = (uint8_t)nameLen;
+  e->normLen = (uint8_t)normLen;
+
+  b->arenaUsed += nameLen + 1 + normLen + 1;
+  b->count++;
+}
+
+static void build_commit(uint8_t bank)
+{
+  if (bank == 0 || bank > BANK_REGISTRY_MAX) { bank_free(&g_build); return; }
+
+  g_build.indexed = true;
+  bank_index_t old;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  old = g_banks[bank];
+  g_banks[bank] = g_build;
+  xSemaphoreGive(g_lock);
+
+  memset(&g_build, 0, sizeof(bank_index_t));
+  bank_free(&old);
+}
+
+void station_search_bank_begin(uint8_t bank, uint16_t count)
+{
+  if (!g_lock) return;
+  bank_free(&g_build);
+  g_buildBank = bank;
+  bank_reserve(&g_build, count > 0 ? count : INITIAL_CAPACITY);
+}
+
+void station_search_bank_add(uint16_t station, const char* line)
+{
+  if (!g_lock || !line || g_buildBank == 0) return;
+  build_add(&g_build, station, line);
+}
+
+void station_search_bank_end(void)
+{
+  if (!g_lock || g_buildBank == 0) return;
+  build_commit(g_buildBank);
+  Serial.printf("debug search -> Bank %u zaindeksowany, stacji: %u\n", g_buildBank, g_banks[g_buildBank].count);
+  g_buildBank = 0;
+}
+
+void station_search_invalidate_bank(uint8_t bank)
+{
+  if (!g_lock || bank == 0 || bank > BANK_REGISTRY_MAX) return;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  g_banks[bank].indexed = false;
+  xSemaphoreGive(g_lock);
+}
+
+// Odczyt banku z pliku z rejestru banków - numeracja stacji jak w loadStationsFromStream():
+// cała linia (dłuższa niż STATION_LINE_MAX_LENGTH - reszta pominięta, nie jako nowa linia),
+// stacja = linia z "http"
+static void index_bank_from_file(uint8_t bank)
+{
+  const char* fileName = bank_registry_file(bank);
+
+  bank_index_t b;
+  memset(&b, 0, sizeof(b));
+
+  File f;
+  if (*fileName && getStorage().exists(fileName)) f = getStorage().open(fileName, FILE_READ);
+  if (f)
+  {
+    static char line[STATION_LINE_MAX_LENGTH + 1];   // static - tylko pętla główna
+    uint16_t station = 0;
+    while (f.available())
+    {
+      size_t len = f.readBytesUntil('\n', line, sizeof(line) - 1);
+      line[len] = '\0';
+      bool url = strstr(line, "http") != nullptr;
+      if (len == sizeof(line) - 1)
+      {
+        String rest = f.readStringUntil('\n');   // koniec zbyt długiej linii
+        if (!url) url = rest.indexOf("http") >= 0;
+      }
+      if (!url) continue;
+      station++;
+      build_add(&b, station, line);
+    }
+    f.close();
+  }
+
+  bank_index_t saved = g_build;
+  g_build = b;
+  build_commit(bank);
+  g_build = saved;
+}
+
+// ======================= ZAPYTANIE =======================
+
+// Czy dwa słowa różnią się co najwyżej jedną edycją (wstawienie/usunięcie/zamiana)
+static bool edit_distance_le1(const char* a, uint8_t al, const char* b, uint8_t bl)
+{
+  if (al > bl + 1 || bl > al + 1) return false;
+  uint8_t i = 0, j = 0;
+  bool edited = false;
+  while (i < al && j < bl)
+  {
+    if (a[i] == b[j]) { i++; j++; continue; }
+    if (edited) return false;
+    edited = true;
+    if (al > bl) i++;
+    else if (bl > al) j++;
+    else { i++; j++; }
+  }
+  return !(edited && (i < al || j < bl));
+}
+
+static uint16_t match_token(const char* q, uint8_t ql, const char* t, uint8_t tl)
+{
+  if (ql == 0 || tl == 0) return 0;
+
+  if (ql <= tl && memcmp(q, t, ql) == 0)
+  {
+    if (ql == tl) return 100;
+    return 60 + (uint16_t)(20 * ql / tl);
+  }
+
+  if (ql >= 3 && ql < tl)
+  {
+    for (uint8_t k = 1; k + ql <= tl; k++)
+    {
+      if (memcmp(q, t + k, ql) == 0) return 30;
+    }
+  }
+
+  if (ql >= 4)
+  {
+    if (edit_distance_le1(q, ql, t, tl)) return 20;
+    // literówka w prefiksie dłuższego słowa
+    if (tl > ql && edit_distance_le1(q, ql, t, ql)) return 20;
+  }
+  return 0;
+}
+
+typedef struct {
+  const char* s;
+  uint8_t     len;
+} token_t;
+
+static uint8_t split_tokens(const char* s, uint8_t len, token_t* out, uint8_t maxTokens)
+{
+  uint8_t n = 0, i = 0;
+  while (i < len && n < maxTokens)
+  {
+    while (i < len && s[i] == ' ') i++;
+    if (i >= len) break;
+    uint8_t start = i;
+    while (i < len && s[i] != ' ') i++;
+    out[n].s = s + start;
+    out[n].len = i - start;
+    n++;
+  }
+  return n;
+}
+
+static uint16_t score_entry(const token_t* q, uint8_t qn, const char* norm, uint8_t normLen)
+{
+  token_t t[12];
+  uint8_t tn = split_tokens(norm, normLen, t, 12);
+  if (tn == 0) return 0;
+
+  uint16_t total = 0;
+  bool firstHit = false;
+  for (uint8_t i = 0; i < qn; i++)
+  {
+    uint16_t best = 0;
+    uint8_t bestToken = 0;
+    for (uint8_t j = 0; j < tn; j++)
+    {
+      uint16_t s = match_token(q[i].s, q[i].len, t[j].s, t[j].len);
+      if (s > best) { best = s; bestToken = j; }
+    }
+    if (best == 0) return 0;  // każde słowo zapytania musi pasować
+    if (bestToken == 0) firstHit = true;
+    total += best;
+  }
+  if (firstHit) total += 10;
+  return total;
+}
+
+static void insert_result(search_result_t* out, uint8_t* n, uint8_t maxResults,
+                          uint8_t bank, const entry_t* e, const char* arena, uint16_t score)
+{
+  // Lista posortowana malejąco, przy remisie krótsza nazwa wyżej
+  uint8_t pos = *n;
+  while (pos > 0)
+  {
+    const search_result_t* prev = &out[pos - 1];
+    if (prev->score > score) break;
+    if (prev->score == score && strlen(prev->name) <= e->nameLen) break;
+    pos--;
+  }
+  if (pos >= maxResults) return;
+
+  uint8_t last = (*n < maxResults) ? *n : maxResults - 1;
+  for (uint8_t k = last; k > pos; k--) out[k] = out[k - 1];
+
+  out[pos].bank = bank;
+  out[pos].station = e->station;
+  out[pos].score = score;
+  memcpy(out[pos].name, arena + e->nameOff, e->nameLen);
+  out[pos].name[e->nameLen] = '\0';
+
+  if (*n < maxResults) (*n)++;
+}
+
+uint8_t station_search_query(const char* query, search_result_t* out, uint8_t maxResults)
+{
+  if (!g_lock || !query || !out || maxResults == 0) return 0;
+  if (maxResults > SEARCH_MAX_RESULTS) maxResults = SEARCH_MAX_RESULTS;
+
+  uint64_t t0 = esp_timer_get_time();
+
+  char qnorm[SEARCH_QUERY_LENGTH + 1];
+  uint8_t qlen = (uint8_t)station_search_normalize(query, qnorm, sizeof(qnorm));
+  token_t q[6];
+  uint8_t qn = split_tokens(qnorm, qlen, q, 6);
+  if (qn == 0) return 0;
+
+  uint8_t n = 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  for (uint16_t bank = 1; bank <= g_bankCount; bank++)
+  {
+    const bank_index_t* b = &g_banks[bank];
+    for (uint16_t i = 0; i < b->count; i++)
+    {
+      const entry_t* e = &b->entries[i];
+      const char* norm = b->arena + e->nameOff + e->nameLen + 1;
+      uint16_t score = score_entry(q, qn, norm, e->normLen);
+      if (score) insert_result(out, &n, maxResults, bank, e, b->arena, score);
+    }
+  }
+  xSemaphoreGive(g_lock);
+
+  g_lastQueryUs = (uint32_t)(esp_timer_get_time() - t0);
+  return n;
+}
+
+// ======================= INIT / LOOP =======================
+
+bool station_search_init(void)
+{
+  if (g_lock) return true;
+  g_banks = (bank_index_t*)search_alloc((BANK_REGISTRY_MAX + 1) * sizeof(bank_index_t));
+  if (!g_banks) return false;
+  memset(g_banks, 0, (BANK_REGISTRY_MAX + 1) * sizeof(bank_index_t));
+  g_lock = xSemaphoreCreateMutex();
+  if (!g_lock) return false;
+  memset(&g_build, 0, sizeof(g_build));
+  return true;
+}
+
+void station_search_set_bank_count(uint8_t banks)
+{
+  g_bankCount = (banks > BANK_REGISTRY_MAX) ? BANK_REGISTRY_MAX : banks;
+}
+
+void station_search_loop(void)
+{
+  if (!g_lock || g_buildBank != 0) return;
+  if (millis() - g_lastLoopMs < LOOP_INTERVAL_MS) return;
+  g_lastLoopMs = millis();
+
+  // Jeden nieaktualny bank na wywołanie - nie blokujemy pętli głównej na dłużej
+  for (uint16_t bank = 1; bank <= g_bankCount; bank++)
+  {
+    if (!g_banks[bank].indexed)
+    {
+      index_bank_from_file(bank);
+      return;
+    }
+  }
+}
+
+uint16_t station_search_get_entry_count(void)
+{
+  uint16_t total = 0;
+  if (!g_banks) return 0;
+  for (uint16_t bank = 1; bank <= g_bankCount; bank++) total += g_banks[bank].count;
+  return total;
+}
+
+uint8_t station_search_get_indexed_banks(void)
+{
+  uint8_t n = 0;
+  if (!g_banks) return 0;
+  for (uint16_t bank = 1; bank <= g_bankCount; bank++) if (g_banks[bank].indexed) n++;
+  return n;
+}
+
+uint32_t station_search_get_last_query_us(void)
+{
+  return g_lastQueryUs;
+}
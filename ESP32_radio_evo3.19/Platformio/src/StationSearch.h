@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STATION SEARCH - indeks wyszukiwania stacji we wszystkich bankach
+// ========================================================================
+// Indeks trzyma znormalizowane nazwy stacji (małe litery, bez polskich
+// znaków diakrytycznych, separator = spacja) w pamięci PSRAM, osobno dla
+// każdego banku. Zmiana jednego banku przebudowuje tylko jego fragment.
+//
+// DOPASOWANIE (dla każdego słowa zapytania, wymagane wszystkie słowa):
+//   - dokładne słowo         -> 100 pkt
+//   - prefiks słowa          ->  60..80 pkt
+//   - fragment słowa         ->  30 pkt
+//   - literówka (1 edycja)   ->  20 pkt (tylko słowa >= 4 znaki)
+//   + 10 pkt gdy dopasowane jest pierwsze słowo nazwy
+//
+// Koszt: ~1700 stacji (17 banków x 99) - zapytanie rzędu 1-3 ms.
+// Liczba banków zgodna z rejestrem banków (StationBanks.h).
+// ========================================================================
+
+static const uint8_t  SEARCH_MAX_RESULTS  = 20;   // maksymalna liczba wyników jednego zapytania
+static const uint8_t  SEARCH_NAME_LENGTH  = 42;   // długość nazwy stacji w indeksie (jak w changeStation)
+static const uint8_t  SEARCH_QUERY_LENGTH = 32;   // maksymalna długość zapytania
+
+typedef struct {
+  uint8_t  bank;                          // numer banku 1..n
+  uint16_t station;                       // numer stacji w banku 1..n
+  uint16_t score;                         // ranking dopasowania
+  char     name[SEARCH_NAME_LENGTH + 1];  // nazwa do wyświetlenia
+} search_result_t;
+
+// Init / runtime
+bool     station_search_init(void);                        // alokacja struktur indeksu
+void     station_search_loop(void);                        // indeksowanie w tle - jeden bank na wywołanie
+void     station_search_set_bank_count(uint8_t banks);     // ile banków istnieje (bank_nr_max)
+
+// Aktualizacja indeksu banku (wywoływana po załadowaniu banku do PSRAM)
+void     station_search_bank_begin(uint8_t bank, uint16_t count);
+void     station_search_bank_add(uint16_t station, const char* line);
+void     station_search_bank_end(void);
+void     station_search_invalidate_bank(uint8_t bank);     // bank do ponownego odczytu z pliku w tle
+
+// Zapytanie - zwraca liczbę wyników posortowanych malejąco wg score
+uint8_t  station_search_query(const char* query, search_result_t* out, uint8_t maxResults);
+
+// Normalizacja tekstu (UTF-8 / Win-1250 -> ASCII małe litery), zwraca długość
+size_t   station_search_normalize(const char* in, char* out, size_t outSize);
+
+// Statystyki
+uint16_t station_search_get_entry_count(void);
+uint8_t  station_search_get_indexed_banks(void);
+uint32_t station_search_get_last_query_us(void);
@@ -0,0 +1,203 @@
+#include "StationWarmup.h"
+#include <string.h>
+#include "NetCache.h"
+
+// ======================= STAN =======================
+
+typedef struct {
+  char     host[WARM_HOST_LENGTH + 1];
+} warm_req_t;
+
+typedef struct {
+  char     host[WARM_HOST_LENGTH + 1];
+  uint32_t resolvedAt;   // millis() udanego rozwiązania, 0 = brak
+} warm_host_t;
+
+static QueueHandle_t g_q = nullptr;
+static TaskHandle_t  g_task = nullptr;
+static portMUX_TYPE  g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static warm_host_t   g_hosts[WARM_HOSTS_MAX];
+static uint8_t       g_hostNext = 0;          // kolejny wpis do nadpisania (FIFO)
+static bool          g_enabled = false;
+
+static warm_stats_t  g_stats;
+static uint32_t      g_warmSumMs = 0;
+static uint32_t      g_coldSumMs = 0;
+
+static volatile bool g_switchPending = false; // czekamy na pierwsze próbki po connecttohost()
+static volatile uint32_t g_switchStartMs = 0; // zapis w loop(), odczyt w audio_process_i2s()
+static volatile bool g_switchWarm = false;
+
+// ======================= POMOCNICZE =======================
+
+// Indeks wpisu hosta w tablicy lub -1 (wywoływać w sekcji krytycznej)
+static int find_host(const char* host)
+{
+  for (uint8_t i = 0; i < WARM_HOSTS_MAX; i++)
+  {
+    if (g_hosts[i].host[0] && strcmp(g_hosts[i].host, host) == 0) return i;
+  }
+  return -1;
+}
+
+static bool host_is_fresh(const char* host, uint32_t now)
+{
+  bool fresh = false;
+  portENTER_CRITICAL(&g_mux);
+  int i = find_host(host);
+  if (i >= 0 && g_hosts[i].resolvedAt && (now - g_hosts[i].resolvedAt) < WARM_DNS_FRESH_MS) fresh = true;
+  portEXIT_CRITICAL(&g_mux);
+  return fresh;
+}
+
+static void store_host(const char* host, uint32_t now)
+{
+  portENTER_CRITICAL(&g_mux);
+  int i = find_host(host);
+  if (i < 0)
+  {
+    i = g_hostNext;
+    g_hostNext = (g_hostNext + 1) % WARM_HOSTS_MAX;
+    strncpy(g_hosts[i].host, host, WARM_HOST_LENGTH);
+    g_hosts[i].host[WARM_HOST_LENGTH] = '\0';
+  }
+  g_hosts[i].resolvedAt = now ? now : 1;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+static void enqueue_url(const char* url)
+{
+  warm_req_t req;
+  if (!net_url_host(url, req.host, sizeof(req.host))) return;
+  if (host_is_fresh(req.host, millis())) return;  // już rozgrzany
+  xQueueSend(g_q, &req, 0);                        // pełna kolejka = pomijamy
+}
+
+// ======================= ZADANIE DNS =======================
+
+// Rozwiązanie nazwy przez NetCache - wynik ląduje w cache DNS lwIP
+static void warm_task(void* arg)
+{
+  (void)arg;
+  warm_req_t req;
+
+  for (;;)
+  {
+    if (xQueueReceive(g_q, &req, portMAX_DELAY) != pdTRUE) continue;
+    if (!g_enabled) continue;
+
+    uint32_t t0 = millis();
+    bool ok = net_dns_resolve(req.host, nullptr);
+    uint32_t dt = millis() - t0;
+
+    if (ok)
+    {
+      store_host(req.host, millis());
+      g_stats.lastResolveMs = dt;
+      Serial.printf("debug warm -> Rozgrzano host %s (%u ms)\n", req.host, (unsigned)dt);
+    }
+    else
+    {
+      g_stats.resolveFailed++;
+    }
+  }
+}
+
+// ======================= API =======================
+
+bool warm_init(void)
+{
+  if (g_q) return true;
+
+  memset(g_hosts, 0, sizeof(g_hosts));
+  memset(&g_stats, 0, sizeof(g_stats));
+
+  g_q = xQueueCreate(WARM_HOSTS_MAX, sizeof(warm_req_t));
+  if (!g_q) return false;
+
+  BaseType_t ok = xTaskCreatePinnedToCore(
+    warm_task,
+    "StationWarm",
+    3072,          // stack
+    nullptr,
+    1,             // niski priorytet
+    &g_task,
+    0              // Core0 - obok stosu WiFi
+  );
+  if (ok != pdPASS)
+  {
+    vQueueDelete(g_q);
+    g_q = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void warm_set_enabled(bool enabled)
+{
+  g_enabled = enabled;
+}
+
+bool warm_is_enabled(void)
+{
+  return g_enabled;
+}
+
+void warm_neighbours(const char* prevUrl, const char* nextUrl)
+{
+  if (!g_q || !g_enabled) return;
+  enqueue_url(nextUrl);   // "w górę" częściej używane - pierwsze w kolejce
+  enqueue_url(prevUrl);
+}
+
+void warm_switch_begin(const char* url)
+{
+  char host[WARM_HOST_LENGTH + 1];
+  uint32_t now = millis();
+
+  g_switchWarm = net_url_host(url, host, sizeof(host)) && host_is_fresh(host, now);
+  g_switchStartMs = now;
+  g_switchPending = true;
+}
+
+void warm_switch_end(bool connected)
+{
+  if (!connected) g_switchPending = false;   // bez połączenia nie będzie pierwszych próbek - nie liczymy czasu
+}
+
+void warm_first_audio(void)
+{
+  if (!g_switchPending) return;
+  g_switchPending = false;
+
+  uint32_t ttfa = millis() - g_switchStartMs;
+  bool warm = g_switchWarm;
+
+  portENTER_CRITICAL(&g_mux);
+  g_stats.lastTtfaMs = ttfa;
+  g_stats.lastWarm = warm;
+  if (g_stats.warmCount == UINT16_MAX) { g_warmSumMs /= 2; g_stats.warmCount /= 2; }  // średnia ruchoma zamiast przepełnienia
+  if (g_stats.coldCount == UINT16_MAX) { g_coldSumMs /= 2; g_stats.coldCount /= 2; }
+  if (warm)
+  {
+    g_warmSumMs += ttfa;
+    g_stats.warmCount++;
+    g_stats.warmAvgMs = g_warmSumMs / g_stats.warmCount;
+  }
+  else
+  {
+    g_coldSumMs += ttfa;
+    g_stats.coldCount++;
+    g_stats.coldAvgMs = g_coldSumMs / g_stats.coldCount;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void warm_get_stats(warm_stats_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  portEXIT_CRITICAL(&g_mux);
+}
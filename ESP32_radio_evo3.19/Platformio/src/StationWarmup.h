@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STATION WARMUP - "ciepli sąsiedzi" i pomiar czasu do pierwszego dźwięku
+// ========================================================================
+// Po zmianie stacji zadanie w tle rozwiązuje nazwy hostów stacji
+// station_nr-1 i station_nr+1 (NetCache -> cache DNS lwIP). Kolejne
+// connecttohost() na sąsiednią stację pomija zapytanie DNS.
+//
+// TTFA (time to first audio) - czas od wywołania connecttohost() do
+// pierwszych próbek w audio_process_i2s(), osobno dla przełączeń "ciepłych"
+// (host rozwiązany wcześniej) i "zimnych".
+//
+// Otwarte gniazda / pre-bufor nie są przekazywane do dekodera - biblioteka
+// ESP32-audioI2S zawsze otwiera własne połączenie w connecttohost().
+// ========================================================================
+
+static const uint8_t  WARM_HOSTS_MAX     = 4;       // tyle ile wpisów ma tablica DNS lwIP
+static const uint8_t  WARM_HOST_LENGTH   = 64;      // maksymalna długość nazwy hosta
+static const uint32_t WARM_DNS_FRESH_MS  = 60000;   // po tym czasie host traktujemy jako "zimny"
+
+typedef struct {
+  uint32_t lastTtfaMs;      // TTFA ostatniego przełączenia
+  bool     lastWarm;        // czy ostatnie przełączenie było "ciepłe"
+  uint32_t warmAvgMs;       // średni TTFA przełączeń ciepłych
+  uint32_t coldAvgMs;       // średni TTFA przełączeń zimnych
+  uint16_t warmCount;
+  uint16_t coldCount;
+  uint32_t lastResolveMs;   // czas ostatniego rozwiązania nazwy w tle
+  uint16_t resolveFailed;   // nieudane rozwiązania nazw
+} warm_stats_t;
+
+// Init / konfiguracja
+bool warm_init(void);                                   // kolejka + zadanie rozwiązywania nazw
+void warm_set_enabled(bool enabled);
+bool warm_is_enabled(void);
+
+// Wywoływane z changeStation()
+void warm_neighbours(const char* prevUrl, const char* nextUrl);  // zlecenie rozgrzania sąsiadów
+void warm_switch_begin(const char* url);                          // tuż przed connecttohost()
+void warm_switch_end(bool connected);                             // po connecttohost(), błąd = pomiar porzucony
+
+// Wywoływane z audio_process_i2s() - tanie, bez blokowania
+void warm_first_audio(void);
+
+// Statystyki
+void warm_get_stats(warm_stats_t* out);
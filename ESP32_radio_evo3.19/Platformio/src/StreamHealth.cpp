@@ -0,0 +1,372 @@
+#include "StreamHealth.h"
+#include "NetCache.h"
+#include <string.h>
+
+// ======================= STAN =======================
+
+typedef struct {
+  health_url_stats_t s;
+  uint32_t           lastUsed;     // millis() ostatniego użycia, 0 = wolny wpis
+} health_entry_t;
+
+static portMUX_TYPE    g_mux = portMUX_INITIALIZER_UNLOCKED;
+static health_entry_t  g_entries[HEALTH_STATS_MAX];
+
+static char            g_urls[HEALTH_URLS_MAX][HEALTH_URL_LENGTH + 1];   // w kolejności wg statystyk
+static health_status_t g_status;
+static health_entry_t* g_current = nullptr;
+
+static volatile bool   g_audioSeen = false;
+static bool            g_eof = false;
+static uint8_t         g_silentSec = 0;
+static uint32_t        g_connectStartMs = 0;
+static uint32_t        g_retryAtMs = 0;
+static uint32_t        g_stallStartMs = 0;      // 0 = brak trwającej awarii
+static uint32_t        g_errorsWindowStartMs = 0;
+static uint32_t        g_lastTickMs = 0;
+static uint32_t        g_prevFilled = 0;
+
+// ======================= POMOCNICZE =======================
+
+static uint32_t url_hash(const char* s)
+{
+  uint32_t h = 2166136261u;                     // FNV-1a
+  while (*s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+static bool url_separator(char c)
+{
+  return c == ' ' || c == '\t' || c == '|' || c == '\r' || c == '\n';
+}
+
+// Kolejne adresy z linii stacji - każdy zaczyna się od "http"
+static uint8_t split_urls(const char* line, char urls[][HEALTH_URL_LENGTH + 1], uint8_t max)
+{
+  uint8_t n = 0;
+  const char* p = line;
+  while (n < max && (p = strstr(p, "http")) != nullptr)
+  {
+    size_t len = 0;
+    while (p[len] && !url_separator(p[len])) len++;
+    if ((strncmp(p, "http://", 7) == 0 || strncmp(p, "https://", 8) == 0) && len <= HEALTH_URL_LENGTH)
+    {
+      memcpy(urls[n], p, len);
+      urls[n][len] = '\0';
+      n++;
+    }
+    p += len;
+  }
+  return n;
+}
+
+// Wpis statystyk URL - istniejący lub najstarszy do nadpisania (w sekcji krytycznej)
+static health_entry_t* stats_entry(const char* url, bool touch)
+{
+  uint32_t hash = url_hash(url);
+  health_entry_t* oldest = &g_entries[0];
+  for (uint8_t i = 0; i < HEALTH_STATS_MAX; i++)
+  {
+    health_entry_t* e = &g_entries[i];
+    if (e->lastUsed && e->s.urlHash == hash)
+    {
+      if (touch) e->lastUsed = millis() ? millis() : 1;
+      return e;
+    }
+    if (e->lastUsed < oldest->lastUsed) oldest = e;
+  }
+  if (!touch) return nullptr;
+
+  memset(oldest, 0, sizeof(*oldest));
+  oldest->s.urlHash = hash;
+  oldest->lastUsed = millis() ? millis() : 1;
+  return oldest;
+}
+
+// Kara za zawodność - im wyżej, tym dalej w kolejności (na 100 połączeń)
+static uint32_t penalty(const char* url)
+{
+  health_entry_t* e = stats_entry(url, false);
+  if (!e) return 0;
+  return (uint32_t)(e->s.connectFails * 2 + e->s.stalls) * 100 / (e->s.connects + 1);
+}
+
+// Przejście do adresu urlIndex - wpis statystyk i aktualny URL w statusie
+static void select_url(uint8_t index)
+{
+  g_status.urlIndex = index;
+  strcpy(g_status.url, g_urls[index]);
+  g_current = stats_entry(g_urls[index], true);
+  if (!g_current->s.host[0]) net_url_host(g_urls[index], g_current->s.host, sizeof(g_current->s.host));
+}
+
+// Awaria (zacięcie lub nieudane połączenie) - plan kolejnej próby (w sekcji krytycznej)
+static void schedule_retry(uint32_t now)
+{
+  if (!g_stallStartMs) g_stallStartMs = now ? now : 1;
+
+  g_status.retries++;
+  uint32_t backoff = HEALTH_BACKOFF_MIN_MS;
+  for (uint16_t i = 1; i < g_status.retries && backoff < HEALTH_BACKOFF_MAX_MS; i++) backoff *= 2;
+  if (backoff > HEALTH_BACKOFF_MAX_MS) backoff = HEALTH_BACKOFF_MAX_MS;
+  g_retryAtMs = now + backoff;
+
+  // Pierwsza próba na tym samym adresie, kolejne na następnym z listy
+  if (g_status.retries > 1 && g_status.urlCount > 1)
+  {
+    select_url((g_status.urlIndex + 1) % g_status.urlCount);
+    g_status.failovers++;
+  }
+  g_status.state = HEALTH_WAIT_RETRY;
+}
+
+// ======================= API =======================
+
+size_t health_first_url(const char* line, char* out, size_t outSize)
+{
+  if (!line || !out || outSize == 0) return 0;
+  char urls[1][HEALTH_URL_LENGTH + 1];
+  out[0] = '\0';
+  if (split_urls(line, urls, 1) == 0) return 0;
+  strncpy(out, urls[0], outSize - 1);
+  out[outSize - 1] = '\0';
+  return strlen(out);
+}
+
+const char* health_begin(const char* line)
+{
+  static char first[HEALTH_URL_LENGTH + 1];
+  first[0] = '\0';
+  if (!line) return first;
+
+  char urls[HEALTH_URLS_MAX][HEALTH_URL_LENGTH + 1];
+  uint8_t count = split_urls(line, urls, HEALTH_URLS_MAX);
+
+  portENTER_CRITICAL(&g_mux);
+  // Sortowanie przez wstawianie wg kary - przy remisie kolejność z banku
+  uint32_t pen[HEALTH_URLS_MAX];
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint32_t p = penalty(urls[i]);
+    uint8_t j = i;
+    while (j > 0 && pen[j - 1] > p)
+    {
+      pen[j] = pen[j - 1];
+      memcpy(g_urls[j], g_urls[j - 1], sizeof(g_urls[j]));
+      j--;
+    }
+    pen[j] = p;
+    memcpy(g_urls[j], urls[i], sizeof(g_urls[j]));
+  }
+
+  uint16_t stalls = g_status.stalls, recoveries = g_status.recoveries, failovers = g_status.failovers;
+  uint32_t lastTtr = g_status.lastTtrMs, avgTtr = g_status.avgTtrMs, maxTtr = g_status.maxTtrMs;
+  memset(&g_status, 0, sizeof(g_status));
+  g_status.stalls = stalls;                         // liczniki globalne zostają
+  g_status.recoveries = recoveries;
+  g_status.failovers = failovers;
+  g_status.lastTtrMs = lastTtr;
+  g_status.avgTtrMs = avgTtr;
+  g_status.maxTtrMs = maxTtr;
+  g_status.urlCount = count;
+
+  g_current = nullptr;
+  g_stallStartMs = 0;
+  g_silentSec = 0;
+  g_eof = false;
+  g_prevFilled = 0;
+  g_errorsWindowStartMs = millis();
+  g_connectStartMs = millis();
+  g_lastTickMs = millis();
+  g_audioSeen = false;
+  if (count)
+  {
+    select_url(0);
+    g_status.state = HEALTH_CONNECTING;
+    strcpy(first, g_urls[0]);
+  }
+  portEXIT_CRITICAL(&g_mux);
+
+  if (count > 1) Serial.printf("debug health -> %u adresy stacji, pierwszy: %s\n", count, first);
+  return first;
+}
+
+void health_connect_result(bool ok)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_current && g_status.state == HEALTH_CONNECTING)
+  {
+    if (g_current->s.connects < UINT16_MAX) g_current->s.connects++;
+    if (!ok)
+    {
+      if (g_current->s.connectFails < UINT16_MAX) g_current->s.connectFails++;
+      schedule_retry(millis());
+    }
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void health_audio_flowing(void)
+{
+  g_audioSeen = true;
+}
+
+void health_note_error(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  if (g_status.state != HEALTH_IDLE)
+  {
+    g_status.errorsWindow++;
+    if (g_current && g_current->s.errors < UINT16_MAX) g_current->s.errors++;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void health_note_eof(void)
+{
+  if (g_status.state == HEALTH_PLAYING) g_eof = true;
+}
+
+const char* health_tick(uint32_t filledBytes, uint32_t bitrateBps, bool running)
+{
+  static char retryUrl[HEALTH_URL_LENGTH + 1];
+  uint32_t now = millis();
+  bool audio = g_audioSeen;
+  g_audioSeen = false;
+  const char* result = nullptr;
+
+  portENTER_CRITICAL(&g_mux);
+  if (g_status.state == HEALTH_IDLE || !g_current)
+  {
+    portEXIT_CRITICAL(&g_mux);
+    return nullptr;
+  }
+
+  // Przerwa w wywołaniach (komunikat głosowy, SDPlayer, aktualizacja) - liczniki od nowa
+  uint32_t dt = now - g_lastTickMs;
+  g_lastTickMs = now;
+  if (dt > 3000)
+  {
+    g_silentSec = 0;
+    g_connectStartMs = now;
+    if (g_status.state == HEALTH_PLAYING) g_status.state = HEALTH_CONNECTING;
+    dt = 1000;
+  }
+
+  // Napływ z sieci ~ przyrost bufora + to co zjadł dekoder
+  int64_t arrived = (int64_t)filledBytes - (int64_t)g_prevFilled;
+  if (audio) arrived += (int64_t)bitrateBps / 8 * dt / 1000;
+  g_status.arrivalBps = (arrived > 0 && dt) ? (uint32_t)(arrived * 8000 / dt) : 0;
+  g_status.bufferFilled = filledBytes;
+  g_prevFilled = filledBytes;
+
+  if (now - g_errorsWindowStartMs >= HEALTH_ERRORS_WINDOW * 1000UL)
+  {
+    g_errorsWindowStartMs = now;
+    g_status.errorsWindow = 0;
+  }
+
+  switch (g_status.state)
+  {
+    case HEALTH_CONNECTING:
+      if (audio)
+      {
+        g_status.state = HEALTH_PLAYING;
+        g_silentSec = 0;
+        g_eof = false;
+        if (g_stallStartMs)
+        {
+          // Powrót dźwięku po awarii - czas odzyskania
+          uint32_t ttr = now - g_stallStartMs;
+          g_status.lastTtrMs = ttr;
+          if (ttr > g_status.maxTtrMs) g_status.maxTtrMs = ttr;
+          if (g_status.recoveries < UINT16_MAX) g_status.recoveries++;
+          g_status.avgTtrMs = (g_status.recoveries <= 1) ? ttr
+                            : (uint32_t)((int32_t)g_status.avgTtrMs + ((int32_t)ttr - (int32_t)g_status.avgTtrMs) / (int32_t)g_status.recoveries);
+          g_stallStartMs = 0;
+        }
+        g_status.retries = 0;
+      }
+      else if (now - g_connectStartMs >= HEALTH_CONNECT_SEC * 1000UL)
+      {
+        if (g_current->s.connectFails < UINT16_MAX) g_current->s.connectFails++;
+        schedule_retry(now);
+      }
+      break;
+
+    case HEALTH_PLAYING:
+      if (audio)
+      {
+        g_silentSec = 0;
+        g_current->s.playSec++;
+      }
+      else if (g_silentSec < UINT8_MAX) g_silentSec++;
+
+      if (g_silentSec >= HEALTH_STALL_SEC || g_eof || !running || g_status.errorsWindow >= HEALTH_ERRORS_MAX)
+      {
+        if (g_current->s.stalls < UINT16_MAX) g_current->s.stalls++;
+        if (g_status.stalls < UINT16_MAX) g_status.stalls++;
+        g_eof = false;
+        g_status.errorsWindow = 0;
+        g_silentSec = 0;
+        schedule_retry(now);
+      }
+      break;
+
+    case HEALTH_WAIT_RETRY:
+      if ((int32_t)(now - g_retryAtMs) >= 0)
+      {
+        g_status.state = HEALTH_CONNECTING;
+        g_connectStartMs = now;
+        strcpy(retryUrl, g_status.url);
+        result = retryUrl;
+      }
+      break;
+  }
+
+  g_status.nextRetryMs = (g_status.state == HEALTH_WAIT_RETRY && (int32_t)(g_retryAtMs - now) > 0) ? g_retryAtMs - now : 0;
+  portEXIT_CRITICAL(&g_mux);
+
+  if (result) Serial.printf("debug health -> Ponowne połączenie (próba %u): %s\n", g_status.retries, result);
+  return result;
+}
+
+void health_get_status(health_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+uint8_t health_get_url_stats(health_url_stats_t* out, uint8_t max)
+{
+  if (!out) return 0;
+
+  health_entry_t copy[HEALTH_STATS_MAX];
+  int current = -1;
+  portENTER_CRITICAL(&g_mux);
+  memcpy(copy, g_entries, sizeof(copy));
+  if (g_current) current = g_current - g_entries;
+  portEXIT_CRITICAL(&g_mux);
+
+  uint8_t n = 0;
+  if (current >= 0 && n < max)
+  {
+    out[n++] = copy[current].s;
+    copy[current].lastUsed = 0;
+  }
+  // Pozostałe od ostatnio używanego
+  while (n < max)
+  {
+    int best = -1;
+    for (uint8_t i = 0; i < HEALTH_STATS_MAX; i++)
+    {
+      if (copy[i].lastUsed && (best < 0 || copy[i].lastUsed > copy[best].lastUsed)) best = i;
+    }
+    if (best < 0) break;
+    out[n++] = copy[best].s;
+    copy[best].lastUsed = 0;
+  }
+  return n;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STREAM HEALTH - nadzór strumienia, ponowne połączenie i URL zapasowe
+// ========================================================================
+// Linia stacji w banku może zawierać kilka adresów tej samej stacji:
+//   Nazwa stacji  http://glowny/stream http://zapasowy/stream | https://...
+// (rozdzielone spacją lub '|'). Pierwszy jest głównym, kolejne zapasowe.
+//
+// Raz na sekundę health_tick() ocenia strumień: czy z dekodera płyną
+// próbki, zapełnienie bufora, szacowany napływ bajtów, błędy dekodera
+// i koniec strumienia (evt_eof). Zacięcie = ponowne połączenie z rosnącym
+// odstępem (1, 2, 4 ... 60 s): pierwsza próba na tym samym URL, kolejne
+// przechodzą po adresach zapasowych. Statystyki per URL (połączenia,
+// błędy, zacięcia) ustawiają kolejność - zawodny adres spada na koniec.
+// Czas od wykrycia zacięcia do powrotu dźwięku = czas odzyskania (TTR).
+// ========================================================================
+
+static const uint8_t  HEALTH_URLS_MAX       = 4;       // główny + 3 zapasowe
+static const uint16_t HEALTH_URL_LENGTH     = 255;
+static const uint8_t  HEALTH_STATS_MAX      = 32;      // zapamiętane URL (LRU)
+static const uint8_t  HEALTH_HOST_LENGTH    = 40;
+static const uint8_t  HEALTH_STALL_SEC      = 4;       // tyle sekund bez próbek = zacięcie
+static const uint8_t  HEALTH_CONNECT_SEC    = 12;      // maks. czas od połączenia do dźwięku
+static const uint8_t  HEALTH_ERRORS_MAX     = 5;       // błędy dekodera w oknie
+static const uint8_t  HEALTH_ERRORS_WINDOW  = 10;      // s
+static const uint16_t HEALTH_BACKOFF_MIN_MS = 1000;
+static const uint32_t HEALTH_BACKOFF_MAX_MS = 60000;
+
+enum {
+  HEALTH_IDLE = 0,
+  HEALTH_CONNECTING,
+  HEALTH_PLAYING,
+  HEALTH_WAIT_RETRY
+};
+
+typedef struct {
+  char     host[HEALTH_HOST_LENGTH + 1];
+  uint32_t urlHash;
+  uint16_t connects;
+  uint16_t connectFails;
+  uint16_t stalls;
+  uint16_t errors;               // błędy dekodera
+  uint32_t playSec;
+} health_url_stats_t;
+
+typedef struct {
+  uint8_t  state;                // HEALTH_x
+  uint8_t  urlIndex;             // aktualny adres (0 = pierwszy w kolejności)
+  uint8_t  urlCount;
+  uint16_t retries;              // kolejne nieudane próby
+  uint32_t nextRetryMs;          // za ile ms następna próba
+  uint32_t bufferFilled;
+  uint32_t arrivalBps;           // szacowany napływ danych z sieci
+  uint8_t  errorsWindow;
+  uint16_t stalls;               // od startu
+  uint16_t recoveries;
+  uint16_t failovers;            // przejścia na inny adres
+  uint32_t lastTtrMs;
+  uint32_t avgTtrMs;
+  uint32_t maxTtrMs;
+  char     url[HEALTH_URL_LENGTH + 1];
+} health_status_t;
+
+// Pierwszy URL z linii stacji (bez adresów zapasowych), 0 = brak
+size_t      health_first_url(const char* line, char* out, size_t outSize);
+
+// Nowa stacja (linia banku lub pojedynczy URL) - zwraca adres do połączenia, "" = brak
+const char* health_begin(const char* line);
+void        health_connect_result(bool ok);   // wynik connecttohost()
+
+// Zdarzenia
+void        health_audio_flowing(void);       // audio_process_i2s() - tylko ustawienie flagi
+void        health_note_error(void);          // błąd dekodera z my_audio_info()
+void        health_note_eof(void);            // evt_eof strumienia
+
+// Raz na sekundę - zwraca URL do ponownego połączenia albo nullptr
+const char* health_tick(uint32_t filledBytes, uint32_t bitrateBps, bool running);
+
+void        health_get_status(health_status_t* out);
+uint8_t     health_get_url_stats(health_url_stats_t* out, uint8_t max);   // bieżący pierwszy
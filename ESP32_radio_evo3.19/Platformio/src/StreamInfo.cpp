@@ -0,0 +1,187 @@
+#include "StreamInfo.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ======================= LICZNIK ALOKACJI =======================
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile TaskHandle_t g_scopeTask = nullptr;   // zadanie w obsłudze komunikatu
+static volatile uint32_t g_scopeAllocs = 0;
+static volatile bool g_wrapActive = false;
+static stream_info_stats_t g_stats = {};
+static uint32_t g_windowStartMs = 0;
+static uint32_t g_windowMessages = 0;
+static uint32_t g_windowAllocs = 0;
+
+// Owinięcia z -Wl,--wrap=malloc/calloc/realloc - tylko środowisko diagnostyczne
+// (STREAM_INFO_ALLOC_COUNTER w platformio.ini), jedno porównanie na alokację
+#if STREAM_INFO_ALLOC_COUNTER
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static inline void count_alloc(void)
+{
+  g_wrapActive = true;
+  if (g_scopeTask && g_scopeTask == xTaskGetCurrentTaskHandle()) g_scopeAllocs++;
+}
+
+void* __wrap_malloc(size_t size)               { count_alloc(); return __real_malloc(size); }
+void* __wrap_calloc(size_t n, size_t size)     { count_alloc(); return __real_calloc(n, size); }
+void* __wrap_realloc(void* ptr, size_t size)   { if (size) count_alloc(); return __real_realloc(ptr, size); }
+}
+#endif
+
+// ======================= POMOCNICZE =======================
+
+// Dopasowanie stałego klucza na pozycji p - zwraca wskaźnik za kluczem lub nullptr
+#define SI_MATCH(p, key) (strncmp((p), (key), sizeof(key) - 1) == 0 ? (p) + sizeof(key) - 1 : nullptr)
+
+// Liczba dziesiętna po kluczu (pomija spacje), parsowanie w miejscu
+static uint32_t parse_uint(const char* p)
+{
+  while (*p == ' ' || *p == '\t') p++;
+  uint32_t v = 0;
+  while (*p >= '0' && *p <= '9') { v = v * 10 + (uint32_t)(*p - '0'); p++; }
+  return v;
+}
+
+static uint8_t set_u32(uint32_t* field, uint32_t value, uint8_t flag)
+{
+  if (value == 0 || *field == value) return 0;
+  *field = value;
+  return flag;
+}
+
+static uint8_t set_codec(stream_info_t* si, uint8_t codec)
+{
+  if (si->codec == codec) return 0;
+  si->codec = codec;
+  return SI_CHANGED_CODEC;
+}
+
+// ======================= API =======================
+
+void stream_info_reset(stream_info_t* si)
+{
+  if (si) memset(si, 0, sizeof(*si));
+}
+
+uint8_t stream_info_parse(const char* msg, stream_info_t* si)
+{
+  if (!msg || !si) return 0;
+
+  uint8_t changed = 0;
+  const char* v;
+
+  for (const char* p = msg; *p; p++)
+  {
+    switch (*p)
+    {
+      case 'B':
+        if ((v = SI_MATCH(p, "Bitrate (b/s):"))) { changed |= set_u32(&si->bitrate, parse_uint(v), SI_CHANGED_BITRATE); p = v - 1; }
+        else if ((v = SI_MATCH(p, "BitsPerSample:")))
+        {
+          uint32_t bits = parse_uint(v);
+          if (bits && bits != si->bitsPerSample) { si->bitsPerSample = bits; changed |= SI_CHANGED_BITS; }
+          p = v - 1;
+        }
+        break;
+
+      case 'S':
+        if ((v = SI_MATCH(p, "SampleRate (Hz):"))) { changed |= set_u32(&si->sampleRate, parse_uint(v), SI_CHANGED_SAMPLERATE); p = v - 1; }
+        break;
+
+      case 'F':
+        if ((v = SI_MATCH(p, "FLACDecoder"))) { changed |= set_codec(si, SI_CODEC_FLAC); p = v - 1; }
+        else if ((v = SI_MATCH(p, "FLAC bitspersample:")))
+        {
+          uint32_t bits = parse_uint(v);
+          if (bits && bits != si->bitsPerSample) { si->bitsPerSample = bits; changed |= SI_CHANGED_BITS; }
+          p = v - 1;
+        }
+        break;
+
+      case 'M':
+        if ((v = SI_MATCH(p, "MP3Decoder"))) { changed |= set_codec(si, SI_CODEC_MP3); p = v - 1; }
+        break;
+
+      case 'A':
+        if ((v = SI_MATCH(p, "AACDecoder"))) { changed |= set_codec(si, SI_CODEC_AAC); p = v - 1; }
+        break;
+
+      case 'V':
+        if ((v = SI_MATCH(p, "VORBISDecoder"))) { changed |= set_codec(si, SI_CODEC_VORBIS); p = v - 1; }
+        break;
+
+      case 'O':
+        if ((v = SI_MATCH(p, "OPUSDecoder"))) { changed |= set_codec(si, SI_CODEC_OPUS); p = v - 1; }
+        break;
+
+      case 'E':
+        if (SI_MATCH(p, "Error")) changed |= SI_EVENT_ERROR;
+        break;
+
+      case 'e':
+        if (SI_MATCH(p, "error")) changed |= SI_EVENT_ERROR;
+        break;
+
+      default:
+        break;
+    }
+  }
+  return changed;
+}
+
+const char* stream_info_codec_name(uint8_t codec)
+{
+  switch (codec)
+  {
+    case SI_CODEC_MP3:    return "MP3";
+    case SI_CODEC_AAC:    return "AAC";
+    case SI_CODEC_FLAC:   return "FLAC";
+    case SI_CODEC_VORBIS: return "VRB";
+    case SI_CODEC_OPUS:   return "OPUS";
+    default:              return "-";
+  }
+}
+
+void stream_info_scope_begin(void)
+{
+  g_scopeAllocs = 0;
+  g_scopeTask = xTaskGetCurrentTaskHandle();
+}
+
+void stream_info_scope_end(void)
+{
+  g_scopeTask = nullptr;
+  uint32_t allocs = g_scopeAllocs;
+  uint32_t now = millis();
+
+  portENTER_CRITICAL(&g_mux);
+  g_stats.messages++;
+  g_stats.allocs += allocs;
+  g_stats.allocCounter = g_wrapActive;
+  g_windowMessages++;
+  g_windowAllocs += allocs;
+  if (g_windowStartMs == 0) g_windowStartMs = now;
+  else if (now - g_windowStartMs >= SI_STATS_WINDOW_MS)
+  {
+    g_stats.messagesPerMin = g_windowMessages;
+    g_stats.allocsPerMin = g_windowAllocs;
+    g_windowMessages = 0;
+    g_windowAllocs = 0;
+    g_windowStartMs = now;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void stream_info_get_stats(stream_info_stats_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_stats;
+  out->allocCounter = g_wrapActive;
+  portEXIT_CRITICAL(&g_mux);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STREAM INFO - parser komunikatów evt_info biblioteki audio bez alokacji
+// ========================================================================
+// Jedno przejście po const char*: dla każdej pozycji przełącznik po
+// pierwszym znaku wybiera kandydatów (np. 'B' -> "Bitrate (b/s):" lub
+// "BitsPerSample:"), porównanie strncmp, liczba parsowana w miejscu.
+// Wynik trafia do struktury stream_info_t, a zwracana maska bitów mówi
+// co się faktycznie zmieniło - odświeżenie ekranu / WebSocket tylko wtedy.
+//
+// Licznik alokacji sterty: malloc/calloc/realloc owinięte przez linker
+// tylko w środowisku diagnostycznym ..._allocstats (platformio.ini),
+// liczone w zadaniu, które jest między stream_info_scope_begin() i _end()
+// - obsługa evt_info. Wynik za ostatnią pełną minutę w /api/audiotask.
+// W zwykłym firmware licznik nieaktywny (allocCounter = false).
+// ========================================================================
+
+enum {
+  SI_CODEC_NONE = 0,
+  SI_CODEC_MP3,
+  SI_CODEC_AAC,
+  SI_CODEC_FLAC,
+  SI_CODEC_VORBIS,
+  SI_CODEC_OPUS
+};
+
+// Maska zmian zwracana przez stream_info_parse()
+static const uint8_t SI_CHANGED_BITRATE    = 0x01;
+static const uint8_t SI_CHANGED_SAMPLERATE = 0x02;
+static const uint8_t SI_CHANGED_BITS       = 0x04;
+static const uint8_t SI_CHANGED_CODEC      = 0x08;
+static const uint8_t SI_EVENT_ERROR        = 0x80;   // komunikat zawiera "Error"/"error"
+static const uint8_t SI_CHANGED_DISPLAY    = SI_CHANGED_BITRATE | SI_CHANGED_SAMPLERATE | SI_CHANGED_BITS | SI_CHANGED_CODEC;
+
+typedef struct {
+  uint32_t bitrate;          // b/s
+  uint32_t sampleRate;       // Hz
+  uint8_t  bitsPerSample;
+  uint8_t  codec;            // SI_CODEC_x
+} stream_info_t;
+
+#ifndef STREAM_INFO_ALLOC_COUNTER
+#define STREAM_INFO_ALLOC_COUNTER 0                 // 1 = owinięcie malloc (env ..._allocstats)
+#endif
+
+static const uint32_t SI_STATS_WINDOW_MS = 60000;   // okno licznika komunikatów / alokacji
+
+typedef struct {
+  uint32_t messages;         // komunikaty evt_info od startu
+  uint32_t allocs;           // alokacje sterty w ich obsłudze od startu
+  uint32_t messagesPerMin;   // ostatnia pełna minuta
+  uint32_t allocsPerMin;
+  bool     allocCounter;     // owinięcie malloc aktywne (flagi linkera)
+} stream_info_stats_t;
+
+void        stream_info_reset(stream_info_t* si);                 // przy zmianie stacji / pliku
+uint8_t     stream_info_parse(const char* msg, stream_info_t* si);  // zwraca maskę SI_CHANGED_x
+const char* stream_info_codec_name(uint8_t codec);                // "MP3", "FLAC", ... jak streamCodec
+
+// Obsługa jednego komunikatu evt_info - alokacje zadania liczone między begin i end
+void        stream_info_scope_begin(void);
+void        stream_info_scope_end(void);
+void        stream_info_get_stats(stream_info_stats_t* out);
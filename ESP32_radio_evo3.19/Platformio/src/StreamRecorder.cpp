@@ -0,0 +1,432 @@
+#include "StreamRecorder.h"
+#include <FS.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <esp_timer.h>
+#include <string.h>
+#include <time.h>
+
+// External references for storage access
+extern fs::FS& getStorage();
+
+// ======================= STAN =======================
+
+static const uint32_t REC_RING_MASK = REC_RING_BYTES - 1;   // REC_RING_BYTES = potęga 2
+static const uint16_t REC_NET_READ  = 2048;
+
+typedef struct {
+  char     title[REC_TITLE_LENGTH + 1];
+  uint32_t atMs;                            // millis() odebrania tytułu
+} rec_title_t;
+
+static portMUX_TYPE  g_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t*      g_ring = nullptr;
+static uint32_t      g_head = 0;            // bajty odebrane (licznik modularny)
+static uint32_t      g_tail = 0;            // bajty zapisane na SD
+static QueueHandle_t g_titleQ = nullptr;
+static TaskHandle_t  g_writeTask = nullptr;
+
+static volatile bool g_running = false;     // sesja trwa (do zakończenia zadania zapisu)
+static volatile bool g_stopReq = false;
+static volatile bool g_netDone = false;
+
+static char          g_url[256];
+static char          g_station[48];
+static char          g_ext[6] = "mp3";
+static uint32_t      g_startMs = 0;
+static uint32_t      g_durationMs = 0;      // 0 = bez limitu
+static uint32_t      g_netBytes = 0;
+static uint32_t      g_writeUs = 0;         // łączny czas write() w sesji
+static int64_t       g_lastAudioLoopUs = 0;
+static rec_status_t  g_status;
+
+// ======================= POMOCNICZE =======================
+
+static void set_state(uint8_t state, const char* error)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_status.state = state;
+  if (error) { strncpy(g_status.error, error, sizeof(g_status.error) - 1); g_status.error[sizeof(g_status.error) - 1] = '\0'; }
+  portEXIT_CRITICAL(&g_mux);
+  if (error) Serial.printf("debug rec -> %s\n", error);
+}
+
+// Rozszerzenie pliku z Content-Type strumienia
+static void ext_from_content_type(const String& type)
+{
+  const char* ext = "mp3";
+  if (type.indexOf("aac") >= 0 || type.indexOf("mp4") >= 0) ext = "aac";
+  else if (type.indexOf("flac") >= 0) ext = "flac";
+  else if (type.indexOf("ogg") >= 0 || type.indexOf("opus") >= 0) ext = "ogg";
+  strncpy(g_ext, ext, sizeof(g_ext) - 1);
+}
+
+// Odbiór -> pierścień; pełny pierścień = czekamy na zapis, potem odrzucamy
+static void ring_push(const uint8_t* data, uint32_t len)
+{
+  uint32_t waited = 0;
+  for (;;)
+  {
+    portENTER_CRITICAL(&g_mux);
+    uint32_t used = g_head - g_tail;
+    portEXIT_CRITICAL(&g_mux);
+    if (REC_RING_BYTES - used >= len) break;
+
+    if (waited >= REC_STALL_MAX_MS || g_stopReq)
+    {
+      portENTER_CRITICAL(&g_mux);
+      g_status.droppedBytes += len;
+      portEXIT_CRITICAL(&g_mux);
+      return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(10));
+    waited += 10;
+    portENTER_CRITICAL(&g_mux);
+    g_status.stallMs += 10;
+    portEXIT_CRITICAL(&g_mux);
+  }
+
+  uint32_t pos = g_head & REC_RING_MASK;
+  uint32_t first = REC_RING_BYTES - pos;
+  if (first > len) first = len;
+  memcpy(g_ring + pos, data, first);
+  if (len > first) memcpy(g_ring, data + first, len - first);
+
+  portENTER_CRITICAL(&g_mux);
+  g_head += len;
+  uint32_t used = g_head - g_tail;
+  if (used > g_status.ringHighWater) g_status.ringHighWater = used;
+  portEXIT_CRITICAL(&g_mux);
+  g_netBytes += len;
+
+  if (used >= REC_CHUNK_BYTES && g_writeTask) xTaskNotifyGive(g_writeTask);
+}
+
+// Tytuł w pliku .cue - cudzysłów zamieniany na apostrof
+static void cue_track(fs::File& cue, uint16_t track, const char* title, uint32_t ms)
+{
+  char line[REC_TITLE_LENGTH + 16];
+  size_t n = 0;
+  for (const char* c = title; *c && n < REC_TITLE_LENGTH; c++) line[n++] = (*c == '"') ? '\'' : *c;
+  line[n] = '\0';
+
+  uint32_t frames = (ms % 1000) * 75 / 1000;    // ramki CUE = 1/75 s
+  cue.printf("  TRACK %02u AUDIO\n    TITLE \"%s\"\n    INDEX 01 %02u:%02u:%02u\n",
+             track, line, (unsigned)(ms / 60000), (unsigned)((ms / 1000) % 60), (unsigned)frames);
+}
+
+// ======================= ZADANIE ODBIORU =======================
+
+static void rec_net_task(void* arg)
+{
+  static uint8_t buf[REC_NET_READ];
+  uint8_t failures = 0;
+
+  while (!g_stopReq)
+  {
+    bool https = (strncmp(g_url, "https", 5) == 0);
+    WiFiClient plain;
+    WiFiClientSecure secure;
+    if (https) secure.setInsecure();
+
+    HTTPClient http;
+    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+    http.setTimeout(5000);
+    const char* headers[] = {"Content-Type"};
+    http.collectHeaders(headers, 1);
+
+    int code = -1;
+    if (https ? http.begin(secure, g_url) : http.begin(plain, g_url)) code = http.GET();
+    if (code != HTTP_CODE_OK)
+    {
+      http.end();
+      if (++failures > REC_RECONNECTS) { set_state(REC_ERROR, "Brak połączenia ze stacją"); break; }
+      portENTER_CRITICAL(&g_mux);
+      g_status.reconnects++;
+      portEXIT_CRITICAL(&g_mux);
+      vTaskDelay(pdMS_TO_TICKS(1000));
+      continue;
+    }
+
+    String type = http.header("Content-Type");
+    if (type.indexOf("mpegurl") >= 0 || type.indexOf("scpls") >= 0 || type.indexOf("x-mpegURL") >= 0)
+    {
+      http.end();
+      set_state(REC_ERROR, "Playlista / HLS - nie nagrywamy");
+      break;
+    }
+    if (g_head == 0) ext_from_content_type(type);    // rozszerzenie tylko przed pierwszym plikiem
+    failures = 0;
+    set_state(REC_RECORDING, nullptr);
+
+    WiFiClient* stream = http.getStreamPtr();
+    while (!g_stopReq && http.connected())
+    {
+      if (g_durationMs && millis() - g_startMs >= g_durationMs) { g_stopReq = true; break; }
+
+      int avail = stream->available();
+      if (avail <= 0) { vTaskDelay(pdMS_TO_TICKS(5)); continue; }
+      int n = stream->read(buf, avail > (int)sizeof(buf) ? sizeof(buf) : avail);
+      if (n > 0) ring_push(buf, n);
+    }
+    http.end();
+    if (!g_stopReq)
+    {
+      portENTER_CRITICAL(&g_mux);
+      g_status.reconnects++;
+      portEXIT_CRITICAL(&g_mux);
+    }
+  }
+
+  g_netDone = true;
+  if (g_writeTask) xTaskNotifyGive(g_writeTask);
+  vTaskDelete(NULL);
+}
+
+// ======================= ZADANIE ZAPISU =======================
+
+static bool open_part(fs::File& audio, fs::File& cue, uint16_t part, const char* lastTitle)
+{
+  fs::FS& fs = getStorage();
+  if (!fs.exists(REC_DIR)) fs.mkdir(REC_DIR);
+
+  char base[32];
+  time_t now = time(nullptr);
+  struct tm t;
+  localtime_r(&now, &t);
+  if (t.tm_year + 1900 >= 2024) strftime(base, sizeof(base), "%Y%m%d_%H%M%S", &t);
+  else snprintf(base, sizeof(base), "rec_%lu", (unsigned long)(millis() / 1000));
+
+  char path[64];
+  snprintf(path, sizeof(path), "%s/%s_%02u.%s", REC_DIR, base, part, g_ext);
+  audio = fs.open(path, FILE_WRITE);
+  if (!audio) return false;
+
+  snprintf(path, sizeof(path), "%s/%s_%02u.cue", REC_DIR, base, part);
+  cue = fs.open(path, FILE_WRITE);
+  if (cue)
+  {
+    cue.printf("TITLE \"%s\"\nFILE \"%s_%02u.%s\" %s\n", g_station, base, part, g_ext, strcmp(g_ext, "mp3") == 0 ? "MP3" : "WAVE");
+    cue_track(cue, 1, lastTitle[0] ? lastTitle : g_station, 0);
+    cue.flush();
+  }
+
+  portENTER_CRITICAL(&g_mux);
+  snprintf(g_status.fileName, sizeof(g_status.fileName), "%s_%02u.%s", base, part, g_ext);
+  g_status.fileIndex = part;
+  g_status.fileBytes = 0;
+  portEXIT_CRITICAL(&g_mux);
+  Serial.printf("debug rec -> Nowy plik %s/%s_%02u.%s\n", REC_DIR, base, part, g_ext);
+  return true;
+}
+
+// Zapis len bajtów z pierścienia od g_tail (len <= REC_CHUNK_BYTES)
+static bool write_from_ring(fs::File& audio, uint32_t len)
+{
+  uint32_t pos = g_tail & REC_RING_MASK;
+  uint32_t first = REC_RING_BYTES - pos;
+  if (first > len) first = len;
+
+  int64_t t0 = esp_timer_get_time();
+  size_t written = audio.write(g_ring + pos, first);
+  if (len > first) written += audio.write(g_ring, len - first);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+  g_writeUs += us;
+
+  portENTER_CRITICAL(&g_mux);
+  g_tail += len;
+  g_status.fileBytes += written;
+  g_status.totalBytes += written;
+  if (us / 1000 > g_status.maxWriteMs) g_status.maxWriteMs = us / 1000;
+  portEXIT_CRITICAL(&g_mux);
+  return written == len;
+}
+
+static void rec_write_task(void* arg)
+{
+  fs::File audio, cue;
+  uint16_t part = 0;
+  uint16_t track = 1;
+  uint32_t partStartMs = 0;
+  char lastTitle[REC_TITLE_LENGTH + 1] = "";
+  rec_title_t t;
+  bool sdError = false;
+
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+
+    portENTER_CRITICAL(&g_mux);
+    uint32_t used = g_head - g_tail;
+    portEXIT_CRITICAL(&g_mux);
+
+    // Plik otwierany przy pierwszych danych - rozszerzenie znane z Content-Type
+    if (!audio && used > 0)
+    {
+      if (!open_part(audio, cue, ++part, lastTitle)) { sdError = true; break; }
+      partStartMs = millis();
+      track = 1;
+    }
+
+    while (xQueueReceive(g_titleQ, &t, 0) == pdTRUE)
+    {
+      strcpy(lastTitle, t.title);
+      if (cue)
+      {
+        uint32_t at = (t.atMs > partStartMs) ? t.atMs - partStartMs : 0;
+        cue_track(cue, ++track, t.title, at);
+        cue.flush();
+        portENTER_CRITICAL(&g_mux);
+        g_status.titles++;
+        portEXIT_CRITICAL(&g_mux);
+      }
+    }
+
+    // Tylko pełne bloki - pozycja w pierścieniu i w pliku zawsze wyrównana
+    while (audio && used >= REC_CHUNK_BYTES)
+    {
+      if (!write_from_ring(audio, REC_CHUNK_BYTES)) { sdError = true; break; }
+      used -= REC_CHUNK_BYTES;
+    }
+    if (sdError || g_netDone) break;
+
+    // Podział pliku po rozmiarze lub czasie
+    if (audio && (g_status.fileBytes >= REC_ROTATE_BYTES || millis() - partStartMs >= REC_ROTATE_SEC * 1000UL))
+    {
+      audio.close();
+      if (cue) cue.close();
+      if (!open_part(audio, cue, ++part, lastTitle)) { sdError = true; break; }
+      partStartMs = millis();
+      track = 1;
+    }
+  }
+
+  if (sdError)
+  {
+    set_state(REC_ERROR, "Błąd zapisu na SD (pełna karta?)");
+    g_stopReq = true;
+  }
+
+  // Koniec - czekamy na zadanie odbioru i zapisujemy resztę (niepełny blok)
+  while (!g_netDone) vTaskDelay(pdMS_TO_TICKS(10));
+  portENTER_CRITICAL(&g_mux);
+  uint32_t rest = g_head - g_tail;
+  portEXIT_CRITICAL(&g_mux);
+  if (audio && !sdError)
+  {
+    while (rest)
+    {
+      uint32_t len = rest > REC_CHUNK_BYTES ? REC_CHUNK_BYTES : rest;
+      if (!write_from_ring(audio, len)) break;
+      rest -= len;
+    }
+  }
+  if (audio) audio.close();
+  if (cue) cue.close();
+
+  Serial.printf("debug rec -> Koniec nagrywania, zapisano %u B, maks. zapis %u ms, odrzucono %u B\n",
+                (unsigned)g_status.totalBytes, (unsigned)g_status.maxWriteMs, (unsigned)g_status.droppedBytes);
+
+  portENTER_CRITICAL(&g_mux);
+  uint8_t* ring = g_ring;
+  g_ring = nullptr;
+  if (g_status.state != REC_ERROR) g_status.state = REC_IDLE;
+  g_writeTask = nullptr;
+  g_running = false;
+  portEXIT_CRITICAL(&g_mux);
+  free(ring);
+  vTaskDelete(NULL);
+}
+
+// ======================= API =======================
+
+bool rec_start(const char* url, const char* stationName, uint16_t minutes)
+{
+  if (g_running || !url || strncmp(url, "http", 4) != 0) return false;
+
+  g_ring = (uint8_t*)ps_malloc(REC_RING_BYTES);
+  if (!g_ring) { set_state(REC_ERROR, "Brak PSRAM na bufor"); return false; }
+  if (!g_titleQ) g_titleQ = xQueueCreate(REC_TITLES_QUEUE, sizeof(rec_title_t));
+  else xQueueReset(g_titleQ);
+
+  strncpy(g_url, url, sizeof(g_url) - 1);
+  g_url[sizeof(g_url) - 1] = '\0';
+  strncpy(g_station, stationName ? stationName : "", sizeof(g_station) - 1);
+  g_station[sizeof(g_station) - 1] = '\0';
+  for (char* c = g_station; *c; c++) { if (*c == '"') *c = '\''; }
+  strcpy(g_ext, "mp3");
+
+  memset(&g_status, 0, sizeof(g_status));
+  g_status.state = REC_CONNECTING;
+  g_head = g_tail = 0;
+  g_netBytes = 0;
+  g_writeUs = 0;
+  g_lastAudioLoopUs = 0;
+  g_startMs = millis();
+  g_durationMs = (uint32_t)minutes * 60000UL;
+  g_stopReq = false;
+  g_netDone = false;
+  g_running = true;
+
+  BaseType_t ok = xTaskCreatePinnedToCore(rec_write_task, "RecWrite", 6144, NULL, 1, &g_writeTask, 0);
+  if (ok == pdPASS) ok = xTaskCreatePinnedToCore(rec_net_task, "RecNet", 12288, NULL, 1, NULL, 0);
+  if (ok != pdPASS)
+  {
+    Serial.println("debug rec -> Błąd uruchomienia zadań nagrywania");
+    g_stopReq = true;
+    g_netDone = true;                 // zadanie zapisu (jeśli wystartowało) samo zwolni bufor
+    if (!g_writeTask) { free(g_ring); g_ring = nullptr; g_running = false; }
+    set_state(REC_ERROR, "Błąd uruchomienia zadań");
+    return false;
+  }
+
+  Serial.printf("debug rec -> Start nagrywania %s (%u min)\n", g_url, minutes);
+  return true;
+}
+
+void rec_stop(void)
+{
+  if (!g_running) return;
+  g_stopReq = true;
+  set_state(REC_STOPPING, nullptr);
+}
+
+bool rec_is_active(void)
+{
+  return g_running;
+}
+
+void rec_mark_title(const char* title)
+{
+  if (!g_running || !title || !g_titleQ) return;
+  rec_title_t t;
+  strncpy(t.title, title, REC_TITLE_LENGTH);
+  t.title[REC_TITLE_LENGTH] = '\0';
+  t.atMs = millis();
+  xQueueSend(g_titleQ, &t, 0);        // pełna kolejka = znacznik pomijamy
+}
+
+void rec_note_audio_loop(void)
+{
+  int64_t now = esp_timer_get_time();
+  if (g_lastAudioLoopUs)
+  {
+    uint32_t gapMs = (uint32_t)((now - g_lastAudioLoopUs) / 1000);
+    if (gapMs > g_status.maxAudioGapMs) g_status.maxAudioGapMs = gapMs;
+  }
+  g_lastAudioLoopUs = now;
+}
+
+void rec_get_status(rec_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+
+  uint32_t elapsedMs = g_running ? millis() - g_startMs : 0;
+  out->elapsedSec = elapsedMs / 1000;
+  out->remainingSec = (g_running && g_durationMs > elapsedMs) ? (g_durationMs - elapsedMs) / 1000 : 0;
+  out->netKBps = elapsedMs ? (uint32_t)((uint64_t)g_netBytes / elapsedMs) : 0;          // B/ms = KB/s
+  out->writeKBps = g_writeUs ? (uint32_t)((uint64_t)out->totalBytes * 1000 / g_writeUs) : 0;
+}
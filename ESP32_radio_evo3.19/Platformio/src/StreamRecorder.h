@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// STREAM RECORDER - nagrywanie strumienia stacji na kartę SD
+// ========================================================================
+// Biblioteka audio nie udostępnia danych skompresowanych, dlatego nagranie
+// idzie osobnym połączeniem HTTP do tego samego URL (bez metadanych ICY).
+// Dwa zadania na rdzeniu 0:
+//   - "RecNet"   - odbiór z sieci do pierścienia w PSRAM,
+//   - "RecWrite" - zapis na SD wyłącznie pełnymi blokami REC_CHUNK_BYTES
+//     (pozycja w pliku zawsze wyrównana do bloku, bez kopiowania - blok
+//     nigdy nie przechodzi przez koniec pierścienia).
+// Pełny pierścień = odbiór czeka (back-pressure), po REC_STALL_MAX_MS
+// dane są odrzucane i liczone. Pliki dzielone po rozmiarze / czasie,
+// tytuły ICY z odtwarzacza zapisywane jako ścieżki w pliku .cue.
+// ========================================================================
+
+static const uint32_t REC_CHUNK_BYTES   = 32 * 1024;              // rozmiar jednego zapisu na SD
+static const uint32_t REC_RING_BYTES    = 8 * REC_CHUNK_BYTES;    // 256 KB w PSRAM
+static const uint32_t REC_ROTATE_BYTES  = 64UL * 1024 * 1024;     // nowy plik co 64 MB
+static const uint32_t REC_ROTATE_SEC    = 3600;                   // lub co godzinę
+static const uint16_t REC_STALL_MAX_MS  = 500;                    // maks. oczekiwanie na miejsce w pierścieniu
+static const uint8_t  REC_TITLE_LENGTH  = 96;
+static const uint8_t  REC_TITLES_QUEUE  = 8;
+static const uint8_t  REC_RECONNECTS    = 3;
+static const char     REC_DIR[]         = "/rec";
+
+enum {
+  REC_IDLE = 0,
+  REC_CONNECTING,
+  REC_RECORDING,
+  REC_STOPPING,
+  REC_ERROR
+};
+
+typedef struct {
+  uint8_t  state;               // REC_x
+  char     fileName[48];
+  char     error[40];
+  uint16_t fileIndex;           // numer części po podziale
+  uint32_t fileBytes;
+  uint32_t totalBytes;          // zapisane na SD w całej sesji
+  uint32_t elapsedSec;
+  uint32_t remainingSec;        // 0 = bez limitu
+  uint32_t netKBps;             // odbiór z sieci (średnia sesji)
+  uint32_t writeKBps;           // szybkość samego zapisu SD (bajty / czas write)
+  uint32_t maxWriteMs;          // najdłuższy pojedynczy zapis - blokada magistrali SD
+  uint32_t maxAudioGapMs;       // najdłuższa przerwa między audio.loop() podczas nagrywania
+  uint32_t ringHighWater;       // maks. zajętość pierścienia w bajtach
+  uint32_t stallMs;             // łączny czas oczekiwania odbioru na miejsce
+  uint32_t droppedBytes;        // odrzucone przy pełnym pierścieniu
+  uint16_t titles;              // znaczniki .cue
+  uint8_t  reconnects;
+} rec_status_t;
+
+// minutes = 0 - do zatrzymania, > 0 - automatyczny koniec jak sleep timer
+bool rec_start(const char* url, const char* stationName, uint16_t minutes);
+void rec_stop(void);
+bool rec_is_active(void);
+
+void rec_mark_title(const char* title);          // evt_streamtitle
+void rec_note_audio_loop(void);                  // przy każdym audio.loop() gdy nagrywanie trwa
+void rec_get_status(rec_status_t* out);
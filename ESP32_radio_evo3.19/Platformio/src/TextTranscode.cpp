@@ -0,0 +1,161 @@
+#include "TextTranscode.h"
+#include <string.h>
+
+// ======================= TABLICE =======================
+
+// U+0080..U+017F -> znak czcionki OLED (Windows-1250 dla liter polskich,
+// litera bazowa ASCII dla pozostałych), 0 = brak odpowiednika ('?')
+static const uint8_t UNI_TO_DISPLAY[256] = {
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // U+0080
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // U+0090
+  0x20, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x22, 0x63, 0x61, 0x22, 0x00, 0x00, 0x72, 0x20,  // U+00A0
+  0x6F, 0x00, 0x32, 0x33, 0x27, 0x00, 0x00, 0x2E, 0x2C, 0x31, 0x6F, 0x22, 0x31, 0x31, 0x33, 0x3F,  // U+00B0
+  0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x43, 0x45, 0x45, 0x45, 0x45, 0x49, 0x49, 0x49, 0x49,  // U+00C0
+  0x44, 0x4E, 0x4F, 0xD3, 0x4F, 0x4F, 0x4F, 0x78, 0x4F, 0x55, 0x55, 0x55, 0x55, 0x59, 0x54, 0x73,  // U+00D0
+  0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x61, 0x63, 0x65, 0x65, 0x65, 0x65, 0x69, 0x69, 0x69, 0x69,  // U+00E0
+  0x64, 0x6E, 0x6F, 0xF3, 0x6F, 0x6F, 0x6F, 0x2F, 0x6F, 0x75, 0x75, 0x75, 0x75, 0x79, 0x74, 0x79,  // U+00F0
+  0x41, 0x61, 0x41, 0x61, 0xA5, 0xB9, 0xC6, 0xE6, 0x43, 0x63, 0x43, 0x63, 0x43, 0x63, 0x44, 0x64,  // U+0100
+  0x44, 0x64, 0x45, 0x65, 0x45, 0x65, 0x45, 0x65, 0xCA, 0xEA, 0x45, 0x65, 0x47, 0x67, 0x47, 0x67,  // U+0110
+  0x47, 0x67, 0x47, 0x67, 0x48, 0x68, 0x48, 0x68, 0x49, 0x69, 0x49, 0x69, 0x49, 0x69, 0x49, 0x69,  // U+0120
+  0x49, 0x69, 0x49, 0x69, 0x4A, 0x6A, 0x4B, 0x6B, 0x6B, 0x4C, 0x6C, 0x4C, 0x6C, 0x4C, 0x6C, 0x4C,  // U+0130
+  0x6C, 0xA3, 0xB3, 0xD1, 0xF1, 0x4E, 0x6E, 0x4E, 0x6E, 0x6E, 0x4E, 0x6E, 0x4F, 0x6F, 0x4F, 0x6F,  // U+0140
+  0x4F, 0x6F, 0x4F, 0x6F, 0x52, 0x72, 0x52, 0x72, 0x52, 0x72, 0x8C, 0x9C, 0x53, 0x73, 0x53, 0x73,  // U+0150
+  0x53, 0x73, 0x54, 0x74, 0x54, 0x74, 0x00, 0x00, 0x55, 0x75, 0x55, 0x75, 0x55, 0x75, 0x55, 0x75,  // U+0160
+  0x55, 0x75, 0x55, 0x75, 0x57, 0x77, 0x59, 0x79, 0x59, 0x8F, 0x9F, 0xAF, 0xBF, 0x5A, 0x7A, 0x73,  // U+0170
+};
+
+// Windows-1250 0x80..0xFF -> Unicode, 0 = nieprzypisany. Pozycje 0xA6, 0xAC,
+// 0xB6, 0xBC jak w ISO-8859-2 (Ś Ź ś ź) - tak nadają część polskich stacji
+static const uint16_t CP1250_TO_UNI[128] = {
+  0x20AC, 0x0000, 0x201A, 0x0000, 0x201E, 0x2026, 0x2020, 0x2021,  // 0x80
+  0x0000, 0x2030, 0x0160, 0x2039, 0x015A, 0x0164, 0x017D, 0x0179,  // 0x88
+  0x0000, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,  // 0x90
+  0x0000, 0x2122, 0x0161, 0x203A, 0x015B, 0x0165, 0x017E, 0x017A,  // 0x98
+  0x00A0, 0x02C7, 0x02D8, 0x0141, 0x00A4, 0x0104, 0x015A, 0x00A7,  // 0xA0
+  0x00A8, 0x00A9, 0x015E, 0x00AB, 0x0179, 0x00AD, 0x00AE, 0x017B,  // 0xA8
+  0x00B0, 0x00B1, 0x02DB, 0x0142, 0x00B4, 0x00B5, 0x015B, 0x00B7,  // 0xB0
+  0x00B8, 0x0105, 0x015F, 0x00BB, 0x017A, 0x02DD, 0x013E, 0x017C,  // 0xB8
+  0x0154, 0x00C1, 0x00C2, 0x0102, 0x00C4, 0x0139, 0x0106, 0x00C7,  // 0xC0
+  0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,  // 0xC8
+  0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7,  // 0xD0
+  0x0158, 0x016E, 0x00DA, 0x0170, 0x00DC, 0x00DD, 0x0162, 0x00DF,  // 0xD8
+  0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,  // 0xE0
+  0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F,  // 0xE8
+  0x0111, 0x0144, 0x0148, 0x00F3, 0x00F4, 0x0151, 0x00F6, 0x00F7,  // 0xF0
+  0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9,  // 0xF8
+};
+
+// ======================= POMOCNICZE =======================
+
+static uint8_t display_char(uint32_t cp)
+{
+  if (cp < 0x80) return (uint8_t)cp;
+  if (cp < 0x180) return UNI_TO_DISPLAY[cp - 0x80] ? UNI_TO_DISPLAY[cp - 0x80] : '?';
+
+  switch (cp)
+  {
+    case 0x2010: case 0x2011: case 0x2012: case 0x2013: case 0x2014: case 0x2015: return '-';
+    case 0x2018: case 0x2019: case 0x201A: case 0x201B: case 0x2032:            return '\'';
+    case 0x201C: case 0x201D: case 0x201E: case 0x201F: case 0x2033:            return '"';
+    case 0x2022: case 0x2026: case 0x00B7:                                      return '.';
+    case 0x2039: return '<';
+    case 0x203A: return '>';
+    default:     return '?';
+  }
+}
+
+// Długość poprawnej sekwencji UTF-8 zaczynającej się w p, 0 = niepoprawna
+static uint8_t utf8_sequence(const uint8_t* p, uint32_t* cp)
+{
+  uint8_t c = p[0];
+  if (c < 0x80) { *cp = c; return 1; }
+
+  uint8_t len;
+  uint8_t lo = 0x80, hi = 0xBF;     // dozwolony zakres drugiego bajtu
+  if (c >= 0xC2 && c <= 0xDF)      { len = 2; *cp = c & 0x1F; }
+  else if (c >= 0xE0 && c <= 0xEF) { len = 3; *cp = c & 0x0F; if (c == 0xE0) lo = 0xA0; if (c == 0xED) hi = 0x9F; }
+  else if (c >= 0xF0 && c <= 0xF4) { len = 4; *cp = c & 0x07; if (c == 0xF0) lo = 0x90; if (c == 0xF4) hi = 0x8F; }
+  else return 0;
+
+  if (p[1] < lo || p[1] > hi) return 0;
+  *cp = (*cp << 6) | (p[1] & 0x3F);
+  for (uint8_t i = 2; i < len; i++)
+  {
+    if ((p[i] & 0xC0) != 0x80) return 0;   // także koniec tekstu (0x00)
+    *cp = (*cp << 6) | (p[i] & 0x3F);
+  }
+  return len;
+}
+
+static uint8_t utf8_encode(uint32_t cp, uint8_t* out)
+{
+  if (cp < 0x80)  { out[0] = cp; return 1; }
+  if (cp < 0x800) { out[0] = 0xC0 | (cp >> 6); out[1] = 0x80 | (cp & 0x3F); return 2; }
+  out[0] = 0xE0 | (cp >> 12); out[1] = 0x80 | ((cp >> 6) & 0x3F); out[2] = 0x80 | (cp & 0x3F);
+  return 3;  // tablica CP1250 nie wychodzi poza BMP
+}
+
+// ======================= API =======================
+
+void text_transcode(const char* in, char* display, size_t displaySize, char* web, size_t webSize, text_result_t* result)
+{
+  text_result_t r = {0, 0, false, false};
+  size_t d = 0, w = 0;
+  bool displayFull = (display == nullptr || displaySize == 0);
+  bool webFull = (web == nullptr || webSize == 0);
+
+  const uint8_t* p = (const uint8_t*)(in ? in : "");
+  if (p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) { p += 3; r.bomRemoved = true; }
+
+  while (*p && !(displayFull && webFull))
+  {
+    // ASCII - najczęstszy przypadek, bez dekodowania
+    if (*p < 0x80)
+    {
+      if (!displayFull) { if (d + 1 < displaySize) display[d++] = *p; else displayFull = true; }
+      if (!webFull)     { if (w + 1 < webSize) web[w++] = *p; else webFull = true; }
+      p++;
+      continue;
+    }
+
+    uint32_t cp;
+    uint8_t enc[4];
+    const uint8_t* src;
+    uint8_t srcLen;
+
+    uint8_t len = utf8_sequence(p, &cp);
+    if (len)
+    {
+      src = p;                    // poprawny UTF-8 - do WWW bez zmian
+      srcLen = len;
+      p += len;
+    }
+    else
+    {
+      r.invalidBytes = true;      // bajt spoza UTF-8 - traktujemy jako Windows-1250
+      cp = CP1250_TO_UNI[*p - 0x80];
+      if (cp == 0) cp = '?';
+      srcLen = utf8_encode(cp, enc);
+      src = enc;
+      p++;
+    }
+
+    if (!displayFull)
+    {
+      if (d + 1 < displaySize) display[d++] = (char)display_char(cp);
+      else displayFull = true;
+    }
+    if (!webFull)
+    {
+      if (w + srcLen < webSize) { memcpy(web + w, src, srcLen); w += srcLen; }
+      else webFull = true;
+    }
+  }
+
+  if (display && displaySize) display[d] = '\0';
+  if (web && webSize) web[w] = '\0';
+
+  r.displayLength = d;
+  r.webLength = w;
+  if (result) *result = r;
+}
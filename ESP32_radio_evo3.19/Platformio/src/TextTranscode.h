@@ -0,0 +1,34 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// TEXT TRANSCODE - tytuły streamów / nazwy plików dla OLED i WWW
+// ========================================================================
+// Jedno przejście po tekście wejściowym, zapis do gotowych buforów:
+//   - usunięcie BOM (EF BB BF) z początku,
+//   - walidacja UTF-8 (bez overlong, surogatów i bajtów > U+10FFFF),
+//   - wyjście "display": strona kodowa czcionki OLED (Windows-1250 dla
+//     polskich liter, pozostałe litery łacińskie bez ogonków, typograficzne
+//     cudzysłowy/myślniki na ASCII, reszta '?'),
+//   - wyjście "web": poprawny UTF-8; bajty spoza UTF-8 traktowane jako
+//     Windows-1250 (polskie litery także w pozycjach ISO-8859-2).
+// Tekst dłuższy niż bufor jest obcinany na granicy znaku.
+//
+// Próba na hoście: test/host_text_transcode (fuzz ASan/UBSan, porównanie
+// z dawnym processText(), pomiar czasu) - uruchomić po zmianach tutaj.
+// ========================================================================
+
+static const uint16_t TEXT_DISPLAY_MAX = 512;                   // bufor wyjścia OLED
+static const uint16_t TEXT_WEB_MAX     = TEXT_DISPLAY_MAX * 3;  // bufor wyjścia WWW (UTF-8)
+
+typedef struct {
+  uint16_t displayLength;
+  uint16_t webLength;
+  bool     bomRemoved;
+  bool     invalidBytes;     // wejście zawierało bajty spoza UTF-8
+} text_result_t;
+
+// display / web mogą być nullptr - wtedy to wyjście jest pomijane
+void text_transcode(const char* in, char* display, size_t displaySize, char* web, size_t webSize, text_result_t* result);
@@ -0,0 +1,267 @@
+#include "TimeShift.h"
+#include <string.h>
+#include <esp_timer.h>
+
+// ======================= STAN =======================
+
+static portMUX_TYPE g_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Pierścień - ramka stereo 16 bit = jeden uint32_t
+static uint32_t* g_ring = nullptr;
+static uint32_t  g_capacity = 0;         // ramki
+static uint32_t  g_ringBytes = 0;
+static volatile bool g_busy = false;     // timeshift_process() w trakcie (ochrona free())
+
+// Stan odtwarzania - zmieniany tylko w timeshift_process()
+static uint32_t  g_head = 0;             // następna ramka do zapisu
+static uint32_t  g_filled = 0;           // ramki historii (max g_capacity)
+static uint32_t  g_delay = 0;            // opóźnienie w ramkach
+static bool      g_paused = false;
+static uint32_t  g_sampleRate = 0;
+
+// Polecenia oczekujące (pętla / WWW -> tor audio)
+static bool      g_cmdPause = false;
+static bool      g_cmdLive = false;
+static bool      g_cmdReset = false;
+static int32_t   g_cmdSkipSec = 0;
+
+// Pomiar przepływu - okno 1 s
+static uint32_t  g_winStartMs = 0;
+static uint32_t  g_winWriteBytes = 0, g_winReadBytes = 0;
+static uint32_t  g_winWriteUs = 0, g_winReadUs = 0;
+static timeshift_status_t g_status;
+
+// ======================= POMOCNICZE =======================
+
+// Kopia do pierścienia od pozycji pos z zawinięciem (maks. dwa memcpy)
+static void ring_write(uint32_t pos, const uint32_t* src, uint32_t frames)
+{
+  uint32_t first = g_capacity - pos;
+  if (first > frames) first = frames;
+  memcpy(g_ring + pos, src, first * 4);
+  if (frames > first) memcpy(g_ring, src + first, (frames - first) * 4);
+}
+
+static void ring_read(uint32_t pos, uint32_t* dst, uint32_t frames)
+{
+  uint32_t first = g_capacity - pos;
+  if (first > frames) first = frames;
+  memcpy(dst, g_ring + pos, first * 4);
+  if (frames > first) memcpy(dst + first, g_ring, (frames - first) * 4);
+}
+
+static uint32_t frames_to_ms(uint32_t frames, uint32_t rate)
+{
+  return rate ? (uint32_t)((uint64_t)frames * 1000 / rate) : 0;
+}
+
+static void state_reset(void)
+{
+  g_head = 0;
+  g_filled = 0;
+  g_delay = 0;
+  g_paused = false;
+}
+
+// Zamknięcie okna pomiarowego - raz na sekundę (w sekcji krytycznej)
+static void stats_window(uint32_t now)
+{
+  uint32_t elapsed = now - g_winStartMs;
+  if (elapsed < 1000) return;
+
+  g_status.writeBytesPerSec = (uint32_t)((uint64_t)g_winWriteBytes * 1000 / elapsed);
+  g_status.readBytesPerSec  = (uint32_t)((uint64_t)g_winReadBytes * 1000 / elapsed);
+  g_status.writeUsPerSec    = (uint32_t)((uint64_t)g_winWriteUs * 1000 / elapsed);
+  g_status.readUsPerSec     = (uint32_t)((uint64_t)g_winReadUs * 1000 / elapsed);
+  g_status.writeMBps        = g_winWriteUs ? g_winWriteBytes / g_winWriteUs : 0;   // B/us = MB/s
+  g_status.readMBps         = g_winReadUs ? g_winReadBytes / g_winReadUs : 0;
+
+  g_winStartMs = now;
+  g_winWriteBytes = g_winReadBytes = 0;
+  g_winWriteUs = g_winReadUs = 0;
+}
+
+// ======================= API =======================
+
+bool timeshift_enable(void)
+{
+  if (g_ring) return true;
+
+  // Rozmiar w granicach największego wolnego bloku PSRAM minus rezerwa
+  uint32_t freePsram = ESP.getMaxAllocPsram();
+  uint32_t bytes = TS_RING_BYTES;
+  if (freePsram < TS_RING_MIN_BYTES + TS_PSRAM_RESERVE)
+  {
+    Serial.printf("debug timeshift -> Za mało PSRAM (%u B)\n", (unsigned)freePsram);
+    return false;
+  }
+  if (bytes > freePsram - TS_PSRAM_RESERVE) bytes = freePsram - TS_PSRAM_RESERVE;
+  bytes &= ~3u;
+
+  uint32_t* ring = (uint32_t*)ps_malloc(bytes);
+  if (!ring)
+  {
+    Serial.println("debug timeshift -> Błąd alokacji bufora");
+    return false;
+  }
+
+  portENTER_CRITICAL(&g_mux);
+  g_ring = ring;
+  g_ringBytes = bytes;
+  g_capacity = bytes / 4;
+  state_reset();
+  g_sampleRate = 0;
+  g_cmdPause = g_cmdLive = g_cmdReset = false;
+  g_cmdSkipSec = 0;
+  memset(&g_status, 0, sizeof(g_status));
+  portEXIT_CRITICAL(&g_mux);
+
+  Serial.printf("debug timeshift -> Bufor %u KB w PSRAM\n", (unsigned)(bytes / 1024));
+  return true;
+}
+
+void timeshift_disable(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  uint32_t* ring = g_ring;
+  g_ring = nullptr;
+  portEXIT_CRITICAL(&g_mux);
+  if (!ring) return;
+
+  while (g_busy) { vTaskDelay(1); }   // czekamy aż tor audio skończy bieżący blok
+  free(ring);
+
+  portENTER_CRITICAL(&g_mux);
+  g_capacity = 0;
+  g_ringBytes = 0;
+  state_reset();
+  memset(&g_status, 0, sizeof(g_status));
+  portEXIT_CRITICAL(&g_mux);
+  Serial.println("debug timeshift -> Bufor zwolniony");
+}
+
+bool timeshift_is_enabled(void)
+{
+  return g_ring != nullptr;
+}
+
+void timeshift_process(int16_t* buf, int32_t frames, uint32_t sampleRate)
+{
+  if (frames <= 0 || sampleRate == 0) return;
+
+  // Pobranie poleceń i oznaczenie pracy na pierścieniu
+  portENTER_CRITICAL(&g_mux);
+  if (!g_ring || (uint32_t)frames * 2 > g_capacity)
+  {
+    portEXIT_CRITICAL(&g_mux);
+    return;
+  }
+  g_busy = true;
+  bool cmdPause = g_cmdPause, cmdLive = g_cmdLive, cmdReset = g_cmdReset;
+  int32_t cmdSkipSec = g_cmdSkipSec;
+  g_cmdPause = g_cmdLive = g_cmdReset = false;
+  g_cmdSkipSec = 0;
+  portEXIT_CRITICAL(&g_mux);
+
+  if (cmdReset || sampleRate != g_sampleRate)
+  {
+    state_reset();                 // nowa stacja lub inna częstotliwość - stara historia nieprzydatna
+    g_sampleRate = sampleRate;
+  }
+  if (cmdPause) g_paused = !g_paused;
+  if (cmdLive)  { g_paused = false; g_delay = 0; }
+
+  // Zapis - jedna kopia bloku I2S do pierścienia
+  int64_t t0 = esp_timer_get_time();
+  ring_write(g_head, (const uint32_t*)buf, frames);
+  g_head += frames;
+  if (g_head >= g_capacity) g_head -= g_capacity;
+  g_filled += frames;
+  if (g_filled > g_capacity) g_filled = g_capacity;
+  int64_t t1 = esp_timer_get_time();
+
+  // Najstarsza ramka jaką można odtworzyć: odczyt kończy się na head - delay
+  uint32_t maxDelay = g_filled - frames;
+  if (cmdSkipSec)
+  {
+    int64_t d = (int64_t)g_delay - (int64_t)cmdSkipSec * (int64_t)sampleRate;
+    if (d < 0) d = 0;
+    if (d > (int64_t)maxDelay) d = maxDelay;
+    g_delay = (uint32_t)d;
+  }
+
+  uint32_t readBytes = 0;
+  if (g_paused)
+  {
+    memset(buf, 0, frames * 4);
+    g_delay += frames;             // transmisja płynie dalej, odtwarzanie stoi
+    if (g_delay > maxDelay) g_delay = maxDelay;
+  }
+  else if (g_delay)
+  {
+    uint32_t pos = (g_head + 2 * g_capacity - frames - g_delay) % g_capacity;
+    ring_read(pos, (uint32_t*)buf, frames);
+    readBytes = frames * 4;
+  }
+  int64_t t2 = esp_timer_get_time();
+
+  uint32_t now = millis();
+  portENTER_CRITICAL(&g_mux);
+  g_winWriteBytes += frames * 4;
+  g_winWriteUs    += (uint32_t)(t1 - t0);
+  if (readBytes) { g_winReadBytes += readBytes; g_winReadUs += (uint32_t)(t2 - t1); }
+  stats_window(now);
+  g_status.paused     = g_paused;
+  g_status.sampleRate = sampleRate;
+  g_status.delayMs    = frames_to_ms(g_delay, sampleRate);
+  g_status.bufferedMs = frames_to_ms(g_filled, sampleRate);
+  g_status.capacityMs = frames_to_ms(g_capacity, sampleRate);
+  g_busy = false;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void timeshift_toggle_pause(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_cmdPause = !g_cmdPause;        // dwa szybkie naciśnięcia znoszą się
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void timeshift_skip(int16_t seconds)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_cmdSkipSec += seconds;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void timeshift_go_live(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_cmdLive = true;
+  g_cmdPause = false;
+  g_cmdSkipSec = 0;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void timeshift_reset(void)
+{
+  portENTER_CRITICAL(&g_mux);
+  g_cmdReset = true;
+  g_cmdPause = false;
+  g_cmdLive = false;
+  g_cmdSkipSec = 0;
+  g_status.paused = false;
+  g_status.delayMs = 0;
+  g_status.bufferedMs = 0;
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void timeshift_get_status(timeshift_status_t* out)
+{
+  if (!out) return;
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  out->enabled = (g_ring != nullptr);
+  out->ringBytes = g_ringBytes;
+  portEXIT_CRITICAL(&g_mux);
+}
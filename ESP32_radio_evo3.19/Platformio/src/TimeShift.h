@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// TIMESHIFT - pauza / cofanie / powrót "na żywo" dla radia internetowego
+// ========================================================================
+// Bufor pierścieniowy w PSRAM z ostatnimi sekundami zdekodowanego dźwięku
+// (ramki stereo 16 bit), zapisywany w audio_process_i2s(). Biblioteka audio
+// nie udostępnia strumienia skompresowanego ani wejścia dekodera, dlatego
+// bufor trzyma PCM - stąd krótsza historia niż przy zapisie MP3/AAC.
+//
+// Ścieżka gorąca:
+//   - na żywo (opóźnienie 0): jedna kopia bufora I2S do pierścienia,
+//     dane wyjściowe zostają bez zmian,
+//   - z opóźnieniem: kopia do pierścienia + kopia starszych ramek na wyjście,
+//   - pauza: zapis trwa dalej, na wyjście cisza, opóźnienie rośnie.
+// Polecenia (pauza, skok, na żywo) z pętli / WWW są tylko zapamiętywane
+// i wykonywane w timeshift_process() - bez blokowania toru audio.
+// ========================================================================
+
+static const uint32_t TS_RING_BYTES       = 4 * 1024 * 1024;  // ~23 s przy 44.1 kHz
+static const uint32_t TS_RING_MIN_BYTES   = 512 * 1024;
+static const uint32_t TS_PSRAM_RESERVE    = 1024 * 1024;      // zostawiamy dla bufora wejściowego audio
+static const uint8_t  TS_SKIP_SHORT_SEC   = 10;
+static const uint8_t  TS_SKIP_LONG_SEC    = 30;
+
+typedef struct {
+  bool     enabled;
+  bool     paused;
+  uint32_t sampleRate;
+  uint32_t delayMs;           // opóźnienie względem transmisji na żywo
+  uint32_t bufferedMs;        // historia dostępna do cofnięcia
+  uint32_t capacityMs;
+  uint32_t ringBytes;
+  uint32_t writeBytesPerSec;  // przepływ danych do pierścienia (ostatnia sekunda)
+  uint32_t readBytesPerSec;   // przepływ danych z pierścienia
+  uint32_t writeUsPerSec;     // czas kopiowania na sekundę
+  uint32_t readUsPerSec;
+  uint32_t writeMBps;         // szybkość kopiowania (bajty / czas kopii)
+  uint32_t readMBps;
+} timeshift_status_t;
+
+bool timeshift_enable(void);      // alokacja pierścienia w PSRAM
+void timeshift_disable(void);     // zwolnienie pierścienia
+bool timeshift_is_enabled(void);
+
+// Wywoływane w audio_process_i2s(), frames = liczba ramek stereo
+void timeshift_process(int16_t* buf, int32_t frames, uint32_t sampleRate);
+
+// Polecenia - wykonywane przy następnym wywołaniu timeshift_process()
+void timeshift_toggle_pause(void);
+void timeshift_skip(int16_t seconds);   // ujemne = cofnięcie, dodatnie = w stronę "na żywo"
+void timeshift_go_live(void);
+void timeshift_reset(void);             // zmiana stacji - historia kasowana
+
+void timeshift_get_status(timeshift_status_t* out);
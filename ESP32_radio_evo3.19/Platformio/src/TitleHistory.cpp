@@ -0,0 +1,427 @@
+#include "TitleHistory.h"
+#include <FS.h>
+#include <string.h>
+#include <time.h>
+
+// External references for storage access
+extern fs::FS& getStorage();
+
+// ======================= STAN =======================
+
+static const uint16_t STRINGS_MAX = HISTORY_STATIONS_MAX * HISTORY_TITLES_PER_STATION;   // tyle wpisów może istnieć naraz
+
+typedef struct {
+  uint32_t hash;
+  uint32_t offset;               // położenie w puli
+  uint16_t len;
+  uint16_t refs;                 // 0 = wolny wpis
+} pool_string_t;
+
+typedef struct {
+  uint32_t urlHash;
+  char     name[HISTORY_NAME_LENGTH + 1];
+  uint32_t lastUsed;             // licznik kolejności (LRU), 0 = wolny wpis
+  uint8_t  head;                 // miejsce następnego wpisu
+  uint8_t  count;
+  bool     logged;               // definicja stacji jest już w bieżącej paczce dziennika
+  uint16_t titles[HISTORY_TITLES_PER_STATION];   // indeksy w g_strings
+  uint32_t times[HISTORY_TITLES_PER_STATION];
+} station_t;
+
+static SemaphoreHandle_t g_lock = nullptr;
+static char*          g_pool = nullptr;
+static uint32_t       g_poolUsed = 0;
+static pool_string_t* g_strings = nullptr;
+static station_t*     g_stations = nullptr;
+static uint32_t       g_useCounter = 0;
+static history_status_t g_status;
+
+// Dziennik
+static bool           g_logEnabled = false;
+static bool           g_logLoaded = false;
+static char*          g_batch = nullptr;
+static char*          g_writeBuf = nullptr;     // kopia paczki zapisywana poza blokadą
+static uint16_t       g_batchLen = 0;
+static uint32_t       g_batchSinceMs = 0;
+
+// ======================= POMOCNICZE =======================
+
+static uint32_t fnv_hash(const char* s, size_t len)
+{
+  uint32_t h = 2166136261u;                   // FNV-1a
+  while (len--) { h ^= (uint8_t)*s++; h *= 16777619u; }
+  return h;
+}
+
+static bool string_equals(uint16_t index, uint32_t hash, const char* s, uint16_t len)
+{
+  const pool_string_t* p = &g_strings[index];
+  return p->refs && p->hash == hash && p->len == len && memcmp(g_pool + p->offset, s, len) == 0;
+}
+
+static void string_release(uint16_t index)
+{
+  if (g_strings[index].refs) g_strings[index].refs--;
+}
+
+static int compare_offset(const void* a, const void* b)
+{
+  uint32_t oa = g_strings[*(const uint16_t*)a].offset;
+  uint32_t ob = g_strings[*(const uint16_t*)b].offset;
+  return oa < ob ? -1 : (oa > ob ? 1 : 0);
+}
+
+// Zagęszczenie puli - żywe napisy przesuwane na początek w kolejności położenia
+static void pool_compact(void)
+{
+  static uint16_t order[STRINGS_MAX];
+  uint16_t live = 0;
+  for (uint16_t i = 0; i < STRINGS_MAX; i++) { if (g_strings[i].refs) order[live++] = i; }
+  qsort(order, live, sizeof(order[0]), compare_offset);
+
+  uint32_t used = 0;
+  for (uint16_t i = 0; i < live; i++)
+  {
+    pool_string_t* p = &g_strings[order[i]];
+    if (p->offset != used) memmove(g_pool + used, g_pool + p->offset, p->len + 1);
+    p->offset = used;
+    used += p->len + 1;
+  }
+  g_poolUsed = used;
+  g_status.compactions++;
+}
+
+// Indeks napisu w puli - istniejący (+1 odwołanie) albo nowy, -1 = brak miejsca
+static int32_t string_intern(const char* s, uint16_t len, uint32_t hash)
+{
+  int32_t freeSlot = -1;
+  for (uint16_t i = 0; i < STRINGS_MAX; i++)
+  {
+    if (string_equals(i, hash, s, len)) { g_strings[i].refs++; return i; }
+    if (freeSlot < 0 && g_strings[i].refs == 0) freeSlot = i;
+  }
+  if (freeSlot < 0) return -1;
+
+  if (g_poolUsed + len + 1 > HISTORY_POOL_BYTES) pool_compact();
+  if (g_poolUsed + len + 1 > HISTORY_POOL_BYTES) return -1;
+
+  pool_string_t* p = &g_strings[freeSlot];
+  memcpy(g_pool + g_poolUsed, s, len);
+  g_pool[g_poolUsed + len] = '\0';
+  p->hash = hash;
+  p->offset = g_poolUsed;
+  p->len = len;
+  p->refs = 1;
+  g_poolUsed += len + 1;
+  return freeSlot;
+}
+
+static station_t* station_find(uint32_t urlHash)
+{
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++)
+  {
+    if (g_stations[i].lastUsed && g_stations[i].urlHash == urlHash) return &g_stations[i];
+  }
+  return nullptr;
+}
+
+// Nowa stacja - wolny wpis albo najdawniej używany (jego tytuły zwalniane)
+static station_t* station_create(uint32_t urlHash)
+{
+  station_t* victim = &g_stations[0];
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++)
+  {
+    if (g_stations[i].lastUsed == 0) { victim = &g_stations[i]; break; }
+    if (g_stations[i].lastUsed < victim->lastUsed) victim = &g_stations[i];
+  }
+  for (uint8_t i = 0; i < victim->count; i++)
+  {
+    string_release(victim->titles[(victim->head + HISTORY_TITLES_PER_STATION - 1 - i) % HISTORY_TITLES_PER_STATION]);
+  }
+  memset(victim, 0, sizeof(*victim));
+  victim->urlHash = urlHash;
+  victim->lastUsed = ++g_useCounter;
+  return victim;
+}
+
+static void station_set_name(station_t* s, const char* name)
+{
+  if (!name || !name[0]) return;
+  strncpy(s->name, name, HISTORY_NAME_LENGTH);
+  s->name[HISTORY_NAME_LENGTH] = '\0';
+}
+
+// Stacje od ostatnio granej
+static uint8_t station_order(uint8_t* order)
+{
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++) { if (g_stations[i].lastUsed) order[n++] = i; }
+  for (uint8_t i = 1; i < n; i++)
+  {
+    uint8_t v = order[i];
+    int8_t j = i - 1;
+    while (j >= 0 && g_stations[order[j]].lastUsed < g_stations[v].lastUsed) { order[j + 1] = order[j]; j--; }
+    order[j + 1] = v;
+  }
+  return n;
+}
+
+static void log_append(station_t* s, uint32_t time, const char* title, uint16_t len)
+{
+  if (!g_logEnabled || !g_batch) return;
+  size_t need = (s->logged ? 0 : 12 + strlen(s->name)) + 22 + len;
+  if (g_batchLen + need >= HISTORY_LOG_BATCH_BYTES) return;    // paczka pełna - zapis w history_tick()
+
+  if (g_batchLen == 0) g_batchSinceMs = millis();
+  if (!s->logged)
+  {
+    g_batchLen += snprintf(g_batch + g_batchLen, HISTORY_LOG_BATCH_BYTES - g_batchLen, "#%08X\t%s\n", (unsigned)s->urlHash, s->name);
+    s->logged = true;
+  }
+  g_batchLen += snprintf(g_batch + g_batchLen, HISTORY_LOG_BATCH_BYTES - g_batchLen, "%u\t%08X\t", (unsigned)time, (unsigned)s->urlHash);
+  for (uint16_t i = 0; i < len; i++)
+  {
+    char c = title[i];
+    g_batch[g_batchLen++] = (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+  }
+  g_batch[g_batchLen++] = '\n';
+}
+
+// Wpis do pierścienia stacji (pod blokadą), false = powtórzenie lub brak miejsca
+static bool entry_add(station_t* s, uint32_t time, const char* title, uint16_t len, bool log)
+{
+  uint32_t hash = fnv_hash(title, len);
+  if (s->count)
+  {
+    uint8_t last = (s->head + HISTORY_TITLES_PER_STATION - 1) % HISTORY_TITLES_PER_STATION;
+    if (string_equals(s->titles[last], hash, title, len)) { g_status.duplicates++; return false; }
+  }
+  if (s->count == HISTORY_TITLES_PER_STATION) string_release(s->titles[s->head]);   // najstarszy wpis wypada
+
+  int32_t index = string_intern(title, len, hash);
+  if (index < 0)
+  {
+    if (s->count == HISTORY_TITLES_PER_STATION) s->count--;   // zwolniony wyżej
+    return false;
+  }
+  s->titles[s->head] = index;
+  s->times[s->head] = time;
+  s->head = (s->head + 1) % HISTORY_TITLES_PER_STATION;
+  if (s->count < HISTORY_TITLES_PER_STATION) s->count++;
+  s->lastUsed = ++g_useCounter;
+  g_status.titlesAdded++;
+
+  if (log) log_append(s, time, title, len);
+  return true;
+}
+
+// Długość tytułu po obcięciu na granicy znaku UTF-8
+static uint16_t title_length(const char* title)
+{
+  size_t len = strlen(title);
+  if (len <= HISTORY_TITLE_LENGTH) return len;
+  len = HISTORY_TITLE_LENGTH;
+  while (len && ((uint8_t)title[len] & 0xC0) == 0x80) len--;
+  return len;
+}
+
+// Końcówka dziennika -> historia (bez ponownego dopisywania do dziennika)
+static void log_load(void)
+{
+  fs::FS& fs = getStorage();
+  if (!fs.exists(HISTORY_LOG_FILE)) return;
+  fs::File f = fs.open(HISTORY_LOG_FILE, FILE_READ);
+  if (!f) return;
+
+  static char line[HISTORY_NAME_LENGTH + HISTORY_TITLE_LENGTH + 32];
+  size_t size = f.size();
+  if (size > HISTORY_LOG_LOAD_BYTES)
+  {
+    f.seek(size - HISTORY_LOG_LOAD_BYTES);
+    f.readBytesUntil('\n', line, sizeof(line) - 1);     // niepełna linia na początku okna
+  }
+
+  uint16_t loaded = 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  while (f.available())
+  {
+    size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    if (line[0] == '#')
+    {
+      uint32_t hash = strtoul(line + 1, nullptr, 16);
+      char* name = strchr(line, '\t');
+      station_t* s = station_find(hash);
+      if (!s) s = station_create(hash);
+      if (name) station_set_name(s, name + 1);
+      continue;
+    }
+    char* p;
+    uint32_t time = strtoul(line, &p, 10);
+    if (*p != '\t') continue;
+    uint32_t hash = strtoul(p + 1, &p, 16);
+    if (*p != '\t') continue;
+    const char* title = p + 1;
+    station_t* s = station_find(hash);
+    if (!s) s = station_create(hash);
+    if (entry_add(s, time, title, title_length(title), false)) loaded++;
+  }
+  xSemaphoreGive(g_lock);
+  f.close();
+  Serial.printf("debug history -> Wczytano %u tytułów z dziennika\n", loaded);
+}
+
+// ======================= API =======================
+
+bool history_init(void)
+{
+  if (g_lock) return true;
+  g_pool = (char*)ps_malloc(HISTORY_POOL_BYTES);
+  g_strings = (pool_string_t*)ps_calloc(STRINGS_MAX, sizeof(pool_string_t));
+  g_stations = (station_t*)ps_calloc(HISTORY_STATIONS_MAX, sizeof(station_t));
+  g_batch = (char*)ps_malloc(HISTORY_LOG_BATCH_BYTES);
+  g_writeBuf = (char*)ps_malloc(HISTORY_LOG_BATCH_BYTES);
+  if (!g_pool || !g_strings || !g_stations || !g_batch || !g_writeBuf)
+  {
+    free(g_pool); free(g_strings); free(g_stations); free(g_batch); free(g_writeBuf);
+    g_pool = nullptr; g_strings = nullptr; g_stations = nullptr; g_batch = nullptr; g_writeBuf = nullptr;
+    Serial.println("debug history -> Brak PSRAM na historię tytułów");
+    return false;
+  }
+  g_lock = xSemaphoreCreateMutex();
+  return g_lock != nullptr;
+}
+
+bool history_add(const char* stationName, const char* url, const char* title)
+{
+  if (!g_lock || !url || !title || !title[0]) return false;
+  uint16_t len = title_length(title);
+  uint32_t urlHash = fnv_hash(url, strlen(url));
+  time_t now = time(nullptr);
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  station_t* s = station_find(urlHash);
+  if (!s) s = station_create(urlHash);
+  station_set_name(s, stationName);
+  bool added = entry_add(s, now > 1600000000 ? (uint32_t)now : 0, title, len, true);   // przed synchronizacją NTP czas = 0
+  uint16_t pending = g_batchLen;
+  xSemaphoreGive(g_lock);
+
+  if (pending >= HISTORY_LOG_BATCH_BYTES * 3 / 4) history_flush();
+  return added;
+}
+
+void history_set_log(bool enabled)
+{
+  g_logEnabled = enabled && g_lock;
+  if (g_logEnabled && !g_logLoaded)
+  {
+    g_logLoaded = true;
+    log_load();
+  }
+}
+
+void history_tick(void)
+{
+  if (g_batchLen && millis() - g_batchSinceMs >= HISTORY_LOG_FLUSH_SEC * 1000UL) history_flush();
+}
+
+void history_flush(void)
+{
+  if (!g_lock || !g_logEnabled) return;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint16_t len = g_batchLen;
+  memcpy(g_writeBuf, g_batch, len);
+  g_batchLen = 0;
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++) g_stations[i].logged = false;   // definicje stacji w każdej paczce
+  xSemaphoreGive(g_lock);
+  if (len == 0) return;
+
+  fs::FS& fs = getStorage();
+  fs::File f = fs.open(HISTORY_LOG_FILE, FILE_APPEND);
+  if (f && f.size() > HISTORY_LOG_MAX_BYTES)
+  {
+    f.close();
+    fs.remove(HISTORY_LOG_OLD_FILE);
+    fs.rename(HISTORY_LOG_FILE, HISTORY_LOG_OLD_FILE);
+    f = fs.open(HISTORY_LOG_FILE, FILE_WRITE);
+  }
+  if (!f)
+  {
+    Serial.println("debug history -> Nie można otworzyć dziennika tytułów");
+    return;
+  }
+  f.write((const uint8_t*)g_writeBuf, len);
+  f.close();
+  g_status.logWrites++;
+  g_status.logBytes += len;
+  Serial.printf("debug history -> Zapisano paczkę dziennika: %u B\n", len);
+}
+
+uint8_t history_station_count(void)
+{
+  if (!g_lock) return 0;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++) { if (g_stations[i].lastUsed) n++; }
+  return n;
+}
+
+bool history_get_station(uint8_t index, history_station_t* station)
+{
+  if (!g_lock || !station) return false;
+  uint8_t order[HISTORY_STATIONS_MAX];
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  uint8_t n = station_order(order);
+  bool ok = index < n;
+  if (ok)
+  {
+    const station_t* s = &g_stations[order[index]];
+    station->urlHash = s->urlHash;
+    strcpy(station->name, s->name);
+    station->count = s->count;
+    station->lastTime = s->count ? s->times[(s->head + HISTORY_TITLES_PER_STATION - 1) % HISTORY_TITLES_PER_STATION] : 0;
+  }
+  xSemaphoreGive(g_lock);
+  return ok;
+}
+
+uint8_t history_get_titles(uint8_t index, history_entry_t* out, uint8_t max)
+{
+  if (!g_lock || !out) return 0;
+  uint8_t order[HISTORY_STATIONS_MAX];
+  uint8_t copied = 0;
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  if (index < station_order(order))
+  {
+    const station_t* s = &g_stations[order[index]];
+    while (copied < max && copied < s->count)
+    {
+      uint8_t slot = (s->head + HISTORY_TITLES_PER_STATION - 1 - copied) % HISTORY_TITLES_PER_STATION;
+      const pool_string_t* p = &g_strings[s->titles[slot]];
+      out[copied].time = s->times[slot];
+      memcpy(out[copied].title, g_pool + p->offset, p->len + 1);
+      copied++;
+    }
+  }
+  xSemaphoreGive(g_lock);
+  return copied;
+}
+
+void history_get_status(history_status_t* out)
+{
+  if (!out) return;
+  *out = g_status;
+  out->poolBytes = HISTORY_POOL_BYTES;
+  out->logEnabled = g_logEnabled;
+  if (!g_lock) return;
+
+  xSemaphoreTake(g_lock, portMAX_DELAY);
+  out->stations = 0;
+  out->strings = 0;
+  for (uint8_t i = 0; i < HISTORY_STATIONS_MAX; i++) { if (g_stations[i].lastUsed) out->stations++; }
+  for (uint16_t i = 0; i < STRINGS_MAX; i++) { if (g_strings[i].refs) out->strings++; }
+  out->poolUsed = g_poolUsed;
+  out->logPending = g_batchLen;
+  xSemaphoreGive(g_lock);
+}
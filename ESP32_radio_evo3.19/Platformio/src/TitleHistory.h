@@ -0,0 +1,74 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// TITLE HISTORY - historia tytułów utworów per stacja ("ostatnio grane")
+// ========================================================================
+// Każda stacja (klucz = skrót FNV-1a adresu) ma pierścień ostatnich
+// HISTORY_TITLES_PER_STATION tytułów z czasem (epoch z NTP). Tytuły są
+// "internowane" - jeden napis w puli PSRAM, wpisy trzymają tylko indeks
+// i licznik odwołań. Pula jest zagęszczana gdy brakuje miejsca; limit
+// stacji (LRU) i tytułów na stację ogranicza pamięć z góry.
+// Powtórzony tytuł (ponowne połączenie, ten sam utwór) nie tworzy wpisu.
+//
+// Dziennik (opcja, karta SD): plik tekstowy dopisywany paczkami
+//   #<skrót>\t<nazwa stacji>          - definicja stacji w paczce
+//   <epoch>\t<skrót>\t<tytuł>         - tytuł
+// Wpisy czekają w buforze PSRAM i trafiają na kartę gdy bufor się zapełni
+// lub po HISTORY_LOG_FLUSH_SEC - nie ma zapisu na każdą zmianę tytułu.
+// Przy starcie końcówka dziennika odtwarza historię.
+// ========================================================================
+
+static const uint8_t  HISTORY_STATIONS_MAX       = 32;
+static const uint8_t  HISTORY_TITLES_PER_STATION = 20;
+static const uint8_t  HISTORY_NAME_LENGTH        = 31;
+static const uint8_t  HISTORY_TITLE_LENGTH       = 127;     // dłuższe tytuły są obcinane (na granicy znaku UTF-8)
+static const uint32_t HISTORY_POOL_BYTES         = 96 * 1024;   // pula napisów w PSRAM
+static const uint16_t HISTORY_LOG_BATCH_BYTES    = 4096;    // bufor paczki dziennika
+static const uint16_t HISTORY_LOG_FLUSH_SEC      = 300;     // maks. czas oczekiwania wpisu na zapis
+static const uint32_t HISTORY_LOG_MAX_BYTES      = 512 * 1024;  // potem dziennik -> .old
+static const uint16_t HISTORY_LOG_LOAD_BYTES     = 16384;   // końcówka dziennika czytana przy starcie
+static const char     HISTORY_LOG_FILE[]         = "/title_history.log";
+static const char     HISTORY_LOG_OLD_FILE[]     = "/title_history.old";
+
+typedef struct {
+  uint32_t time;                 // epoch, 0 = zegar nieustawiony
+  char     title[HISTORY_TITLE_LENGTH + 1];
+} history_entry_t;
+
+typedef struct {
+  uint32_t urlHash;
+  char     name[HISTORY_NAME_LENGTH + 1];
+  uint8_t  count;                // wpisów w pierścieniu
+  uint32_t lastTime;             // czas najnowszego wpisu
+} history_station_t;
+
+typedef struct {
+  uint8_t  stations;
+  uint16_t strings;              // unikalne tytuły w puli
+  uint32_t poolUsed;
+  uint32_t poolBytes;
+  uint16_t compactions;
+  uint32_t titlesAdded;
+  uint32_t duplicates;           // pominięte powtórzenia
+  bool     logEnabled;
+  uint16_t logPending;           // bajty czekające na zapis
+  uint32_t logWrites;            // zapisy paczek na kartę
+  uint32_t logBytes;             // bajty zapisane od startu
+} history_status_t;
+
+bool    history_init(void);                                                // pula i tablice w PSRAM
+bool    history_add(const char* stationName, const char* url, const char* title);   // true = nowy wpis
+
+// Dziennik na karcie SD
+void    history_set_log(bool enabled);   // włączenie wczytuje końcówkę dziennika
+void    history_tick(void);              // co 1 s z loop() - zapis paczki gdy pora
+void    history_flush(void);             // zapis natychmiast (np. przed wyłączeniem)
+
+// Odczyt - stacje od ostatnio granej, wpisy od najnowszego
+uint8_t history_station_count(void);
+bool    history_get_station(uint8_t index, history_station_t* station);
+uint8_t history_get_titles(uint8_t index, history_entry_t* out, uint8_t max);
+void    history_get_status(history_status_t* out);
@@ -0,0 +1,401 @@
+#include "VoiceClock.h"
+#include <FS.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include <string.h>
+#include "AudioTask.h"
+
+// External references for storage access
+extern fs::FS& getStorage();
+
+// ======================= STAN =======================
+
+static const char* const LANG_CODES[VOICE_LANGS] = {"pl", "en"};
+
+static portMUX_TYPE    g_mux = portMUX_INITIALIZER_UNLOCKED;
+static voice_status_t  g_status;
+static bool            g_autoFetched[VOICE_LANGS];   // automatyczne pobieranie - raz na start
+static uint32_t        g_cachedSumMs = 0;
+static uint32_t        g_onlineSumMs = 0;
+static uint16_t        g_cachedMeasured = 0;     // komunikaty z pełnym pomiarem (stacja wróciła)
+static uint16_t        g_onlineMeasured = 0;
+
+// Pomiar bieżącego komunikatu
+static bool            g_active = false;             // komunikat trwa (do końca pliku)
+static volatile bool   g_resumePending = false;      // czekamy na pierwsze próbki stacji
+static bool            g_cached = false;
+static uint32_t        g_startMs = 0;
+static uint32_t        g_endMs = 0;
+
+// ======================= POMOCNICZE =======================
+
+static int lang_index(const char* lang)
+{
+  for (uint8_t i = 0; i < VOICE_LANGS; i++)
+  {
+    if (lang && strcmp(lang, LANG_CODES[i]) == 0) return i;
+  }
+  return -1;
+}
+
+static void clip_path(char* out, size_t outSize, uint8_t lang, char kind, uint8_t value, const char* ext)
+{
+  snprintf(out, outSize, "%s/%s/%c%02u.%s", VOICE_DIR, LANG_CODES[lang], kind, value, ext);
+}
+
+// Tekst fragmentu - godzina 0..23 ('h') albo minuta 1..59 ('m')
+static void clip_text(uint8_t lang, char kind, uint8_t value, char* out, size_t outSize)
+{
+  if (lang == 0)
+  {
+    if (kind == 'h') snprintf(out, outSize, "Jest godzina %u", value);
+    else snprintf(out, outSize, "%02u", value);
+    return;
+  }
+
+  if (kind == 'h')
+  {
+    uint8_t h12 = value % 12;
+    if (h12 == 0) h12 = 12;
+    snprintf(out, outSize, "It is now %u %s", h12, value < 12 ? "am." : "pm.");
+  }
+  else
+  {
+    snprintf(out, outSize, "and %u minutes", value);
+  }
+}
+
+// Liczba fragmentów języka na karcie - jeden odczyt katalogu
+static uint8_t count_clips(uint8_t lang)
+{
+  char dirPath[16];
+  snprintf(dirPath, sizeof(dirPath), "%s/%s", VOICE_DIR, LANG_CODES[lang]);
+
+  fs::File dir = getStorage().open(dirPath);
+  if (!dir || !dir.isDirectory()) return 0;
+
+  uint8_t count = 0;
+  for (fs::File f = dir.openNextFile(); f; f = dir.openNextFile())
+  {
+    const char* name = strrchr(f.name(), '/');
+    name = name ? name + 1 : f.name();
+    if ((name[0] == 'h' || name[0] == 'm') && strlen(name) == 7 && strcmp(name + 3, ".mp3") == 0 && f.size() > 0) count++;
+    f.close();
+  }
+  dir.close();
+  return count;
+}
+
+// Długość znacznika ID3v2 na początku pliku (0 = brak)
+static uint32_t id3_skip(fs::File& f)
+{
+  uint8_t h[10];
+  if (f.read(h, sizeof(h)) != sizeof(h) || memcmp(h, "ID3", 3) != 0)
+  {
+    f.seek(0);
+    return 0;
+  }
+  uint32_t len = 10 + (((uint32_t)(h[6] & 0x7F) << 21) | ((uint32_t)(h[7] & 0x7F) << 14) |
+                       ((uint32_t)(h[8] & 0x7F) << 7) | (h[9] & 0x7F));
+  f.seek(len);
+  return len;
+}
+
+// Dopisanie fragmentu do pliku komunikatu (bez ID3 - w środku pliku przeszkadza dekoderowi)
+static bool append_clip(fs::File& out, const char* path)
+{
+  fs::File in = getStorage().open(path, FILE_READ);
+  if (!in) return false;
+
+  id3_skip(in);
+  uint8_t buf[1024];
+  bool ok = true;
+  for (;;)
+  {
+    size_t n = in.read(buf, sizeof(buf));
+    if (n == 0) break;
+    if (out.write(buf, n) != n) { ok = false; break; }
+  }
+  in.close();
+  return ok;
+}
+
+// ======================= POBIERANIE =======================
+
+static size_t url_encode(const char* in, char* out, size_t outSize)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  size_t n = 0;
+  for (const uint8_t* c = (const uint8_t*)in; *c && n + 4 < outSize; c++)
+  {
+    if (isalnum(*c) || *c == '-' || *c == '.' || *c == '_') out[n++] = *c;
+    else if (*c == ' ') out[n++] = '+';
+    else { out[n++] = '%'; out[n++] = hex[*c >> 4]; out[n++] = hex[*c & 0x0F]; }
+  }
+  out[n] = '\0';
+  return n;
+}
+
+// Jeden fragment: zapis do .tmp, sprawdzenie nagłówka MP3, zmiana nazwy
+static bool fetch_clip(uint8_t lang, char kind, uint8_t value)
+{
+  fs::FS& fs = getStorage();
+  char path[32];
+  char tmpPath[32];
+  clip_path(path, sizeof(path), lang, kind, value, "mp3");
+  clip_path(tmpPath, sizeof(tmpPath), lang, kind, value, "tmp");
+  if (fs.exists(path)) return true;   // plik użytkownika lub wcześniej pobrany
+
+  char text[40];
+  char encoded[96];
+  char url[192];
+  clip_text(lang, kind, value, text, sizeof(text));
+  url_encode(text, encoded, sizeof(encoded));
+  snprintf(url, sizeof(url), "https://translate.google.com/translate_tts?ie=UTF-8&tl=%s&client=tw-ob&q=%s",
+           LANG_CODES[lang], encoded);
+
+  WiFiClientSecure secure;
+  secure.setInsecure();
+  HTTPClient http;
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+  http.setTimeout(VOICE_FETCH_TIMEOUT);
+
+  int code = -1;
+  if (http.begin(secure, url)) code = http.GET();
+  if (code != HTTP_CODE_OK)
+  {
+    http.end();
+    snprintf(g_status.fetchError, sizeof(g_status.fetchError), "HTTP %d (%s)", code, text);
+    return false;
+  }
+
+  fs::File out = fs.open(tmpPath, FILE_WRITE);
+  if (!out)
+  {
+    http.end();
+    snprintf(g_status.fetchError, sizeof(g_status.fetchError), "Zapis %s", tmpPath);
+    return false;
+  }
+
+  WiFiClient* stream = http.getStreamPtr();
+  uint8_t buf[1024];
+  uint8_t head[3] = {0, 0, 0};
+  uint32_t total = 0;
+  uint32_t lastData = millis();
+  int expected = http.getSize();   // -1 = chunked
+
+  while (http.connected() || (stream && stream->available() > 0))
+  {
+    int avail = stream ? stream->available() : 0;
+    if (avail <= 0)
+    {
+      if (expected > 0 && total >= (uint32_t)expected) break;
+      if (millis() - lastData > VOICE_FETCH_TIMEOUT) break;
+      vTaskDelay(pdMS_TO_TICKS(5));
+      continue;
+    }
+    int n = stream->read(buf, avail > (int)sizeof(buf) ? sizeof(buf) : avail);
+    if (n <= 0) continue;
+    if (total == 0) memcpy(head, buf, n < 3 ? n : 3);
+    total += n;
+    lastData = millis();
+    if (total > VOICE_CLIP_MAX_BYTES || out.write(buf, n) != (size_t)n) { total = 0; break; }
+  }
+  out.close();
+  http.end();
+
+  bool mp3 = (memcmp(head, "ID3", 3) == 0) || (head[0] == 0xFF && (head[1] & 0xE0) == 0xE0);
+  if (total < 256 || !mp3)
+  {
+    fs.remove(tmpPath);
+    snprintf(g_status.fetchError, sizeof(g_status.fetchError), "Niepoprawna odpowiedź (%s)", text);
+    return false;
+  }
+  fs.remove(path);
+  return fs.rename(tmpPath, path);
+}
+
+static void fetch_task(void* arg)
+{
+  uint8_t lang = (uint8_t)(uintptr_t)arg;
+  fs::FS& fs = getStorage();
+  char dirPath[16];
+  if (!fs.exists(VOICE_DIR)) fs.mkdir(VOICE_DIR);
+  snprintf(dirPath, sizeof(dirPath), "%s/%s", VOICE_DIR, LANG_CODES[lang]);
+  if (!fs.exists(dirPath)) fs.mkdir(dirPath);
+
+  uint8_t done = 0;
+  uint8_t failed = 0;
+  for (uint8_t i = 0; i < VOICE_CLIPS_PER_LANG; i++)
+  {
+    if (WiFi.status() != WL_CONNECTED)
+    {
+      snprintf(g_status.fetchError, sizeof(g_status.fetchError), "Brak WiFi");
+      failed += VOICE_CLIPS_PER_LANG - i;
+      break;
+    }
+
+    char kind = (i < 24) ? 'h' : 'm';
+    uint8_t value = (i < 24) ? i : (i - 24 + 1);
+    char path[32];
+    clip_path(path, sizeof(path), lang, kind, value, "mp3");
+    bool existed = fs.exists(path);
+
+    if (fetch_clip(lang, kind, value)) done++;
+    else failed++;
+
+    portENTER_CRITICAL(&g_mux);
+    g_status.fetchDone = done;
+    g_status.fetchFailed = failed;
+    portEXIT_CRITICAL(&g_mux);
+
+    if (!existed) vTaskDelay(pdMS_TO_TICKS(VOICE_FETCH_DELAY_MS));   // bez zalewania usługi TTS
+  }
+
+  uint8_t cached = count_clips(lang);
+  portENTER_CRITICAL(&g_mux);
+  g_status.cached[lang] = cached;
+  g_status.fetchState = failed ? VOICE_FETCH_ERROR : VOICE_FETCH_DONE;
+  portEXIT_CRITICAL(&g_mux);
+
+  Serial.printf("debug voice -> Pobieranie fragmentów %s: %u OK, %u błędów, na karcie %u/%u\n",
+                LANG_CODES[lang], done, failed, cached, VOICE_CLIPS_PER_LANG);
+  vTaskDelete(NULL);
+}
+
+// ======================= API =======================
+
+void voice_init(void)
+{
+  memset(g_autoFetched, 0, sizeof(g_autoFetched));
+  for (uint8_t i = 0; i < VOICE_LANGS; i++) g_status.cached[i] = count_clips(i);
+  Serial.printf("debug voice -> Fragmenty zegara na karcie: pl %u/%u, en %u/%u\n",
+                g_status.cached[0], VOICE_CLIPS_PER_LANG, g_status.cached[1], VOICE_CLIPS_PER_LANG);
+}
+
+bool voice_fetch_start(const char* lang)
+{
+  int li = lang_index(lang);
+  if (li < 0) return false;
+
+  portENTER_CRITICAL(&g_mux);
+  bool busy = (g_status.fetchState == VOICE_FETCH_RUNNING);
+  if (!busy)
+  {
+    g_status.fetchState = VOICE_FETCH_RUNNING;
+    strncpy(g_status.fetchLang, LANG_CODES[li], sizeof(g_status.fetchLang));
+    g_status.fetchDone = 0;
+    g_status.fetchFailed = 0;
+    g_status.fetchError[0] = '\0';
+  }
+  portEXIT_CRITICAL(&g_mux);
+  if (busy) return false;
+
+  if (xTaskCreatePinnedToCore(fetch_task, "VoiceFetch", 8192, (void*)(uintptr_t)li, 1, NULL, 0) != pdPASS)
+  {
+    g_status.fetchState = VOICE_FETCH_ERROR;
+    return false;
+  }
+  Serial.printf("debug voice -> Start pobierania fragmentów zegara (%s)\n", LANG_CODES[li]);
+  return true;
+}
+
+bool voice_play(const char* lang, uint8_t hour, uint8_t minute)
+{
+  int li = lang_index(lang);
+  if (li < 0 || hour > 23 || minute > 59) return false;
+
+  fs::FS& fs = getStorage();
+  char hourPath[32];
+  char minutePath[32];
+  clip_path(hourPath, sizeof(hourPath), li, 'h', hour, "mp3");
+  clip_path(minutePath, sizeof(minutePath), li, 'm', minute, "mp3");
+
+  // Pobieranie zapisuje .tmp i zmienia nazwę - gotowe pliki można czytać w jego trakcie
+  bool ready = fs.exists(hourPath) && (minute == 0 || fs.exists(minutePath));
+  if (!ready)
+  {
+    g_status.fallbacks++;
+    if (!g_autoFetched[li] && WiFi.status() == WL_CONNECTED)
+    {
+      g_autoFetched[li] = true;
+      voice_fetch_start(LANG_CODES[li]);   // następny komunikat zagra już z karty
+    }
+    return false;
+  }
+
+  // Pełna godzina - sam fragment godziny, bez kopiowania
+  const char* playPath = hourPath;
+  if (minute != 0)
+  {
+    fs::File out = fs.open(VOICE_SAY_FILE, FILE_WRITE);
+    bool ok = out && append_clip(out, hourPath) && append_clip(out, minutePath);
+    if (out) out.close();
+    if (!ok)
+    {
+      Serial.println("debug voice -> Błąd składania komunikatu, mowa online");
+      g_status.fallbacks++;
+      return false;
+    }
+    playPath = VOICE_SAY_FILE;
+  }
+
+  voice_begin(true);
+  if (!audio_cmd_play_file(playPath))
+  {
+    g_active = false;
+    g_status.fallbacks++;
+    return false;
+  }
+  return true;
+}
+
+void voice_begin(bool cached)
+{
+  g_cached = cached;
+  g_startMs = millis();
+  g_resumePending = false;
+  g_active = true;
+  if (cached) g_status.playedCached++;
+  else g_status.playedOnline++;
+}
+
+void voice_note_end(void)
+{
+  if (!g_active) return;
+  g_active = false;
+  g_endMs = millis();
+  g_status.lastClipMs = g_endMs - g_startMs;
+  g_resumePending = true;
+}
+
+void voice_note_audio(void)
+{
+  if (!g_resumePending) return;
+  g_resumePending = false;
+
+  uint32_t now = millis();
+  portENTER_CRITICAL(&g_mux);
+  g_status.lastCached = g_cached;
+  g_status.lastResumeMs = now - g_endMs;
+  g_status.lastTotalMs = now - g_startMs;
+  if (g_cached)
+  {
+    g_cachedSumMs += g_status.lastTotalMs;
+    g_status.cachedAvgMs = g_cachedSumMs / ++g_cachedMeasured;
+  }
+  else
+  {
+    g_onlineSumMs += g_status.lastTotalMs;
+    g_status.onlineAvgMs = g_onlineSumMs / ++g_onlineMeasured;
+  }
+  portEXIT_CRITICAL(&g_mux);
+}
+
+void voice_get_status(voice_status_t* out)
+{
+  portENTER_CRITICAL(&g_mux);
+  *out = g_status;
+  portEXIT_CRITICAL(&g_mux);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================================================================
+// VOICE CLOCK - zegar głosowy z nagranych wcześniej fragmentów na karcie SD
+// ========================================================================
+// Zamiast connecttospeech() co godzinę (zapytanie do usługi TTS, kilka
+// sekund ciszy, brak działania bez internetu) komunikat składany jest
+// z fragmentów w katalogu VOICE_DIR:
+//   /voice/<język>/hHH.mp3   - "Jest godzina 7" / "It is now 7 am."  (00..23)
+//   /voice/<język>/mMM.mp3   - "05" / "and 5 minutes"               (01..59)
+// Fragmenty pobiera raz zadanie w tle (usługa TTS, jak connecttospeech())
+// albo wgrywa je użytkownik - dowolne MP3 o tych nazwach.
+// Godzina + minuty łączone są w jeden plik VOICE_SAY_FILE (ramki MP3 są
+// niezależne) i grane lokalnie przez audio_cmd_play_file().
+//
+// Powrót do stacji: biblioteka ma jeden dekoder, więc nie da się trzymać
+// "ciepłego" bufora stacji w czasie komunikatu - stacja łączy się po
+// zakończeniu pliku. Mierzony jest czas całej przerwy: komunikat
+// (start -> koniec pliku) i powrót (koniec pliku -> pierwsze próbki stacji),
+// osobno dla fragmentów z karty i dla mowy online.
+// ========================================================================
+
+static const char     VOICE_DIR[]          = "/voice";
+static const char     VOICE_SAY_FILE[]     = "/voice/say.mp3";
+static const uint8_t  VOICE_LANGS          = 2;          // 0 = pl, 1 = en
+static const uint8_t  VOICE_CLIPS_PER_LANG = 24 + 59;    // godziny + minuty
+static const uint16_t VOICE_FETCH_DELAY_MS = 400;        // odstęp między zapytaniami do usługi TTS
+static const uint16_t VOICE_FETCH_TIMEOUT  = 8000;
+static const uint32_t VOICE_CLIP_MAX_BYTES = 64 * 1024;  // większa odpowiedź = błąd usługi
+
+typedef enum {
+  VOICE_FETCH_IDLE = 0,
+  VOICE_FETCH_RUNNING,
+  VOICE_FETCH_DONE,
+  VOICE_FETCH_ERROR
+} voice_fetch_state_t;
+
+typedef struct {
+  uint8_t  cached[VOICE_LANGS];  // fragmenty na karcie (z VOICE_CLIPS_PER_LANG)
+  voice_fetch_state_t fetchState;
+  char     fetchLang[3];
+  uint8_t  fetchDone;            // pobrane / sprawdzone fragmenty bieżącego języka
+  uint8_t  fetchFailed;
+  char     fetchError[48];
+
+  uint16_t playedCached;         // komunikaty z karty
+  uint16_t playedOnline;         // komunikaty przez connecttospeech()
+  uint16_t fallbacks;            // brak fragmentów -> mowa online
+  bool     lastCached;
+  uint32_t lastClipMs;           // start komunikatu -> koniec pliku
+  uint32_t lastResumeMs;         // koniec pliku -> pierwsze próbki stacji
+  uint32_t lastTotalMs;          // cała przerwa w odtwarzaniu stacji
+  uint32_t cachedAvgMs;          // średnia cała przerwa - fragmenty z karty
+  uint32_t onlineAvgMs;          // średnia cała przerwa - mowa online
+} voice_status_t;
+
+// Init - po uruchomieniu karty SD, tylko gdy karta jest (liczy fragmenty)
+void voice_init(void);
+
+// Komunikat z fragmentów: lang "pl" / "en", godzina 0..23, minuta 0..59.
+// false = brak fragmentów - wołający używa connecttospeech().
+// Brak fragmentów uruchamia jednorazowo (na start) ich pobieranie w tle.
+bool voice_play(const char* lang, uint8_t hour, uint8_t minute);
+
+// Pomiar przerwy
+void voice_begin(bool cached);     // tuż przed komunikatem (także online)
+void voice_note_end(void);         // evt_eof komunikatu - start powrotu do stacji
+void voice_note_audio(void);       // z audio_process_i2s() - tanie, bez blokowania
+
+// Pobieranie fragmentów w tle (istniejące pliki są pomijane)
+bool voice_fetch_start(const char* lang);
+void voice_get_status(voice_status_t* out);
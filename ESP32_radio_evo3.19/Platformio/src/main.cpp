@@ -45,6 +45,12 @@
 // SDPlayer - odtwarzacz plików z karty SD
 #include "SDPlayer/SDPlayerOLED.h"
 #include "SDPlayer/SDPlayerWebUI.h"
+#include "SDPlayer/PlayerState.h"
+#include "SDPlayer/DirIndex.h"
+#include "SDPlayer/MediaLibrary.h"
+#include "SDPlayer/Playlist.h"
+#include "SDPlayer/CoverArt.h"
+#include "SDPlayer/SeekIndex.h"
 
 // Analyzer - analizator spektrum FFT
 #include "EQ_FFTAnalyzer.h"
@@ -58,6 +64,57 @@
 
 // VU Style 11 - analog VU meter
 #include "vu_style11.h"
+
+// StationBanks - rejestr banków i lista stacji w PSRAM
+#include "StationBanks.h"
+
+// StationSearch - wyszukiwarka stacji we wszystkich bankach
+#include "StationSearch.h"
+
+// StationWarmup - rozgrzewanie sąsiednich stacji i pomiar TTFA
+#include "StationWarmup.h"
+
+// NetCache - wspólny cache DNS i pomiar połączeń (stacje, banki, URL)
+#include "NetCache.h"
+
+// BufferControl - rozmiar bufora wejściowego audio per stacja
+#include "BufferControl.h"
+
+// SdIo - harmonogram zapisów na karcie, odczyt z wyprzedzeniem przy odtwarzaniu
+#include "SdIo.h"
+
+// StreamInfo - parser komunikatów evt_info bez alokacji
+#include "StreamInfo.h"
+
+// TextTranscode - UTF-8 -> strona kodowa OLED i UTF-8 dla WWW w jednym przejściu
+#include "TextTranscode.h"
+
+// TimeShift - pauza / cofanie radia na żywo (bufor PCM w PSRAM)
+#include "TimeShift.h"
+
+// StreamRecorder - nagrywanie strumienia stacji na kartę SD
+#include "StreamRecorder.h"
+
+// StreamHealth - nadzór strumienia, ponowne połączenie i adresy zapasowe
+#include "StreamHealth.h"
+
+// AudioTask - audio.loop() w zadaniu na rdzeniu 0, kolejka poleceń dla dekodera
+#include "AudioTask.h"
+
+// TitleHistory - historia tytułów per stacja i dziennik na karcie SD
+#include "TitleHistory.h"
+
+// BankProbe - test stacji banku w tle (czasy połączenia, kodeki, przekierowania)
+#include "BankProbe.h"
+
+// VoiceClock - zegar głosowy z fragmentów MP3 na karcie SD
+#include "VoiceClock.h"
+
+// Crossfade - gapless i przenikanie utworów odtwarzacza SD
+#include "Crossfade.h"
+
+// ReplayGain - wyrównanie głośności utworów odtwarzacza SD (tagi / analiza R128)
+#include "ReplayGain.h"
 // ==================================================
 
 // --------------- DEFINICJA WERSJI RADIA i NAZWT HOSTA ---------------
@@ -159,10 +216,10 @@ const bool f_logoSlowBrightness = 1;
 #define WAKEUP_INTERVAL_US (60ULL * 1000000ULL) // 1 minuta
 
 // definicja dlugosci ilosci stacji w banku, dlugosci nazwy stacji w PSRAM/EEPROM, maksymalnej ilosci plikow audio (odtwarzacz)
-#define MAX_STATIONS 99          // Maksymalna liczba stacji radiowych, które mogą być przechowywane w jednym banku
-#define STATION_NAME_LENGTH 220  // Nazwa stacji wraz z bankiem i numerem stacji do wyświetlenia w pierwszej linii na ekranie
+#define STATION_NAME_LENGTH STATION_LINE_MAX_LENGTH  // Maksymalna długość linii stacji (nazwa + URL), liczba stacji w banku ograniczona tylko pamięcią PSRAM
 #define MAX_FILES 100            // Maksymalna liczba plików lub katalogów w tablicy directoriesz
-#define bank_nr_max 17           // Numer jaki może osiągnac maksymalnie zmienna bank_nr czyli ilość banków
+#define BANK_NR_MAX_DEFAULT 17   // Liczba domyślnych banków (STATIONS_URLx) gdy brak pliku /banks.txt
+#define BANK_REGISTRY_FILE "/banks.txt" // Plik rejestru banków: nazwa;url;plik
 #define displayModeMax 11         // Ogrniczenie maksymalnej ilosci trybów wyswietlacza OLED
 
 // DEBUG PRINTS - ON/OFF
@@ -234,21 +291,22 @@ uint16_t rcCmdPower = 0;       // Przycisk Power
 uint16_t rcCmdBT = 0;          // Przycisk Bluetooth menu
 uint16_t rcCmdYellow = 0;      // Przycisk Yellow - toggle Analyzer
 uint16_t lastIrCode = 0;       // Ostatni kod IR (do obsługi combo)
+unsigned long lastIrCodeTime = 0;               // Czas ostatniego kodu IR - combo tylko przy szybkim podwójnym naciśnięciu
+const unsigned long irComboWindowMs = 400;      // Maksymalny odstęp naciśnięć combo (wolniej = zwykłe cyfry, np. stacja 33)
 // Koniec definicji pilota IR
 
 bool  f_callInfo = 0;       // Flaga czy wsiwetlamy "INFO" również na OLED
 bool  f_logo = 0;           // Flaga czy wyswietlamy logo
 bool  f_simpleMode3 =0;
 
-// SDPlayer global flags
-bool sdPlayerAutoPlayNext = false; // Flaga żądania automatycznego odtworzenia następnego utworu
-
 int currentSelection = 0;                     // Numer aktualnego wyboru na ekranie OLED
 int firstVisibleLine = 0;                     // Numer pierwszej widocznej linii na ekranie OLED
-uint8_t station_nr = 0;                       // Numer aktualnie wybranej stacji radiowej z listy
+uint16_t station_nr = 0;                      // Numer aktualnie wybranej stacji radiowej z listy
 int stationFromBuffer = 0;                    // Numer stacji radiowej przechowywanej w buforze do przywrocenia na ekran po bezczynności
 uint8_t bank_nr;                              // Numer aktualnie wybranego banku stacji z listy
 uint8_t previous_bank_nr = 0;                 // Numer banku przed wejsciem do menu zmiany banku
+uint8_t bank_nr_max = BANK_NR_MAX_DEFAULT;    // Ilość banków - ustalana z rejestru banków przy starcie
+const uint16_t webStationsPageSize = 100;     // Ilość stacji na jednej stronie listy WWW
 //int bankFromBuffer = 0;                       // Numer aktualnie wybranego banku stacji z listy do przywrócenia na ekran po bezczynności
 
 //Enkoder 2 (podstawowy)
@@ -325,26 +383,54 @@ int analyzerStyles = 2;          // 0=styles 0-4-5, 1=0-4-6, 2=All(0-4-5-6-10-11
 int analyzerPreset = 4;          // 0=Classic, 1=Modern, 2=Compact, 3=Retro, 4=Custom
 
 // SDPlayer - odtwarzacz plików (extern dla SDPlayerOLED/WebUI)
+// Odtwarzanie z karty i ekran odtwarzacza - PlayerState (player_state_playing / player_state_screen_active)
 extern bool sdPlayerActive;
-extern bool sdPlayerPlayingMusic;
-extern bool sdPlayerOLEDActive;
 bool sdPlayerActive = false;     // Czy SDPlayer jest aktywny
-bool sdPlayerPlayingMusic = false; // Czy SDPlayer odtwarza muzykę (używane przez SDPlayerOLED/WebUI)
-bool sdPlayerOLEDActive = false;   // Czy OLED SDPlayer jest aktywny (używane przez EQ16)
+
+// StationSearch - wyszukiwanie stacji z pilota (T9) i enkodera
+#define STATION_SEARCH_OLED_RESULTS 10           // Ile wyników trzymamy dla ekranu OLED
+bool stationSearchActive = false;                // Flaga aktywnego ekranu wyszukiwania
+char stationSearchQuery[SEARCH_QUERY_LENGTH + 1] = ""; // Wpisywany tekst zapytania
+search_result_t stationSearchResults[STATION_SEARCH_OLED_RESULTS]; // Wyniki dla OLED
+uint8_t stationSearchResultCount = 0;            // Liczba znalezionych wyników
+uint8_t stationSearchSelection = 0;              // Zaznaczony wynik na liście
+uint8_t stationSearchLastKey = 0xFF;             // Ostatnio wciśnięty klawisz T9
+uint8_t stationSearchTapIndex = 0;               // Który znak z klawisza T9
+unsigned long stationSearchLastKeyTime = 0;      // Czas ostatniego wciśnięcia dla multi-tap
+const unsigned long stationSearchTapTimeout = 1000; // Czas na kolejne wciśnięcie tego samego klawisza
+const unsigned long stationSearchTimeout = 20000;   // Wyjście z wyszukiwania po bezczynności
 
 // BTModule - moduł Bluetooth UART
 bool btModuleEnabled = false;      // Czy moduł BT przez UART jest włączony
 
+// StationWarmup - "ciepli sąsiedzi"
+bool f_warmNeighbours = false;     // Flaga rozgrzewania (DNS) stacji station_nr-1 i station_nr+1
+
+// TimeShift - pauza / cofanie radia na żywo
+bool f_timeShift = false;          // Flaga bufora timeshift w PSRAM
+bool timeShiftActive = false;      // Flaga aktywnego ekranu sterowania timeshift
+
+// AudioTask - audio.loop() w osobnym zadaniu
+bool f_audioTask = false;          // Flaga trybu zadania audio (rdzeń 0, wysoki priorytet)
+
+// TitleHistory - dziennik tytułów
+bool f_titleLog = false;           // Flaga zapisu historii tytułów do dziennika na karcie SD
+
+// Crossfade - przejścia między utworami odtwarzacza SD
+bool f_sdGapless = false;          // Flaga startu następnego utworu od razu po końcu pliku
+uint8_t sdCrossfadeSec = 0;        // Czas przenikania utworów [s], 0 = wyłączone
+uint8_t sdReplayGain = 0;          // ReplayGain odtwarzacza SD: 0 = wyłączony, 1 = utwór, 2 = album
+
 // ====================================================
 
 
-uint8_t rcInputDigit1 = 0xFF;      // Pierwsza cyfra w przy wprowadzaniu numeru stacji z pilota
-uint8_t rcInputDigit2 = 0xFF;      // Druga cyfra w przy wprowadzaniu numeru stacji z pilota
+uint32_t rcInputNumber = 0;        // Numer stacji wprowadzany cyframi z pilota
+uint8_t rcInputDigitCount = 0;     // Liczba wpisanych cyfr, 0 = pole puste
 
 
 // ---- Zmienne konfiguracji ---- //
-uint16_t configArray[29] = {0};  // [0-24]=stare, [25]=btModuleEnabled, [26]=analyzerEnabled, [27]=analyzerStyles, [28]=analyzerPreset
-#define CONFIG_COUNT 29
+uint16_t configArray[36] = {0};  // [0-24]=stare, [25]=btModuleEnabled, [26]=analyzerEnabled, [27]=analyzerStyles, [28]=analyzerPreset, [29]=f_warmNeighbours, [30]=f_timeShift, [31]=f_audioTask, [32]=f_titleLog, [33]=f_sdGapless, [34]=sdCrossfadeSec, [35]=sdReplayGain
+#define CONFIG_COUNT 36
 uint8_t rcPage = 0;
 uint16_t configRemoteArray[30] = {0};   // Tablica przechowująca kody pilota podczas odczytu z pliku
 uint16_t configAdcArray[20] = { 0};      // Tablica przechowująca wartosci ADC dla przyciskow klawiatury
@@ -365,6 +451,7 @@ bool flac = false;                // Flaga określająca, czy aktualny plik audi
 bool aac = false;                 // Flaga określająca, czy aktualny plik audio jest w formacie AAC
 bool vorbis = false;              // Flaga określająca, czy aktualny plik audio jest w formacie VORBIS
 bool opus = false;
+stream_info_t streamInfo;          // Parametry bieżącego streamu z komunikatów evt_info (bitrate, sample rate, kodek)
 bool timeDisplay = true;          // Flaga określająca kiedy pokazać czas na wyświetlaczu, domyślnie od razu po starcie
 bool listedStations = false;      // Flaga określająca czy na ekranie jest pokazana lista stacji do wyboru
 bool bankMenuEnable = false;      // Flaga określająca czy na ekranie jest wyświetlone menu wyboru banku
@@ -394,7 +481,6 @@ unsigned long debounceDelay = 300;    // Czas trwania debouncingu w milisekundac
 unsigned long displayTimeout = 3000;  // Czas wyświetlania komunikatu na ekranie w milisekundach
 unsigned long displayStartTime = 0;   // Czas rozpoczęcia wyświetlania komunikatu
 unsigned long seconds = 0;            // Licznik sekund timera
-unsigned int PSRAM_lenght = MAX_STATIONS * (STATION_NAME_LENGTH) + MAX_STATIONS; // deklaracjia długości pamięci PSRAM
 unsigned long lastCheckTime = 0;      // No stream audio blink
 //uint8_t stationNameStreamWidth = 0;   // Test pełnej nazwy stacji
 uint64_t seconds2nextMinute;
@@ -440,6 +526,7 @@ uint8_t volumeFadeOutTime = 25; //ms * volumeValue
 uint8_t volumeSleepFadeOutTime = 50;
 
 unsigned long scrollingStationStringTime;  // Czas do odswiezania scorllingu
+unsigned long bufferControlTime = 0;       // Czas ostatniego pomiaru bufora wejściowego audio
 uint8_t scrollingRefresh = 50;              // Czas w ms przewijania tekstu funkcji Scroller
 
 uint8_t vuMeterRefreshCounterSet = 0;      // Mnoznik co ile petli loopRefreshTime ma byc odswiezony VU Meter
@@ -448,7 +535,6 @@ uint8_t scrollerRefreshCounterSet = 0;     // Mnoznik co ile petli loopRefreshTi
 uint16_t stationStringScrollWidth;         // szerokosc Stringu nazwy stacji w funkcji Scrollera
 uint16_t xPositionStationString = 0;       // Pozycja początkowa dla przewijania tekstu StationString
 uint16_t offset;                           // Zminnna offsetu dla funkcji Scrollera - przewijania streamtitle na ekranie OLED
-unsigned char * psramData;                 // zmienna do trzymania danych stacji w pamieci PSRAM
 
 unsigned long vuMeterMilisTimeUpdate;           // Zmienna przechowujaca czas dla funkci millis VU Meter refresh
 uint8_t vuMeterRefreshTime = 50;                // Czas w ms odswiezania VUmetera
@@ -469,7 +555,8 @@ unsigned long runTime2 = 0;
 
 String stationStringScroll = "";     // Zmienna przechowująca tekst do przewijania na ekranie
 String stationName;                  // Nazwa aktualnie wybranej stacji radiowej
-String stationString;                // Dodatkowe dane stacji radiowej (jeśli istnieją)
+String stationString;                // Dodatkowe dane stacji radiowej (jeśli istnieją) - w stronie kodowej OLED
+String stationStringUtf8;            // Ten sam tytuł w poprawnym UTF-8 dla strony WWW
 String stationStringWeb;                // Dodatkowe dane stacji radiowej (jeśli istnieją)
 String bitrateString;                // Zmienna przechowująca informację o bitrate
 String sampleRateString;             // Zmienna przechowująca informację o sample rate
@@ -1090,6 +1177,17 @@ const char config_html[] PROGMEM = R"rawliteral(
   
   <tr><th><b>Bluetooth Module (UART)</b></th></tr>
   <tr><td>Enable BT UART Module (RX=19, TX=20), default:Off</td><td><input type="checkbox" name="btModuleEnabled" value="1" %S26_checked></td></tr>
+
+  <tr><th><b>Station Switching</b></th></tr>
+  <tr><td>Warm Neighbour Stations (pre-resolve DNS of next/previous station), default:Off</td><td><input type="checkbox" name="f_warmNeighbours" value="1" %S27_checked></td></tr>
+  <tr><td>Live Timeshift (pause / rewind radio, PSRAM buffer, remote combo 555), default:Off</td><td><input type="checkbox" name="f_timeShift" value="1" %S28_checked></td></tr>
+  <tr><td>Audio Task (audio decoding in a dedicated high-priority task on core 0), default:Off</td><td><input type="checkbox" name="f_audioTask" value="1" %S29_checked></td></tr>
+  <tr><td>Title History Log (recently played titles saved to SD in batches), default:Off</td><td><input type="checkbox" name="f_titleLog" value="1" %S30_checked></td></tr>
+
+  <tr><th><b>SD Player</b></th></tr>
+  <tr><td>Gapless Playback (next track starts right at the end of the file), default:Off</td><td><input type="checkbox" name="f_sdGapless" value="1" %S31_checked></td></tr>
+  <tr><td>Crossfade Between Tracks [0 off - 6 s], PSRAM, default:0</td><td><input type="number" name="sdCrossfadeSec" min="0" max="6" value="%X1"></td></tr>
+  <tr><td>ReplayGain Loudness Levelling [0 off, 1 track, 2 album], default:0</td><td><input type="number" name="sdReplayGain" min="0" max="2" value="%X2"></td></tr>
   
   </table>
   
@@ -1212,6 +1310,7 @@ const char menu_html[] PROGMEM = R"rawliteral(
   <br><button class="button" onclick="location.href='/list'">SD / SPIFFS Explorer</button><br>
   <br><button class="button" onclick="location.href='/editor'">Memory Bank Editor</button><br>
   <br><button class="button" onclick="location.href='/browser'">Radio Browser API</button><br>
+  <br><button class="button" onclick="location.href='/probe'">Bank Probe</button><br>
   <br><button class="button" onclick="location.href='/playurl'">Play from URL</button><br>
   <br><button class="button" onclick="location.href='/bt'">Bluetooth Settings</button><br>
   <br><button class="button" onclick="location.href='/config'">Settings</button><br>
@@ -1281,6 +1380,9 @@ const char info_html[] PROGMEM = R"rawliteral(
       <tr><td>IP Address:</td><td><input name="ipValue" value="%D5"></td></tr>
       <tr><td>MAC Address:</td><td><input name="macValue" value="%D6"></td></tr>
       <tr><td>Memory type:</td><td><input name="memValue" value="%D7"></td></tr>
+      <tr><td>DNS cache hit / miss / fail:</td><td><input name="dnsValue" value="%D8"></td></tr>
+      <tr><td>Connect time avg HTTPS / HTTP:</td><td><input name="tlsValue" value="%D9"></td></tr>
+      <tr><td>Recent hosts (hit/miss, connect):</td><td style="font-size:0.8rem;">%N1</td></tr>
     </table>
   </form>
 
@@ -1307,6 +1409,72 @@ const char info_html[] PROGMEM = R"rawliteral(
 </html>
 )rawliteral";
 
+const char probe_html[] PROGMEM = R"rawliteral(
+ <!DOCTYPE HTML>
+  <html>
+  <head>
+    <link rel='icon' href='/favicon.ico' type='image/x-icon'>
+    <meta name="viewport" content="width=device-width, initial-scale=1">
+    <title>Evo Web Radio</title>
+    <style>
+      html{font-family:Arial;display:inline-block;text-align:center;}
+      h2{font-size:1.3rem;}
+      table{border:2px solid #4CAF50;border-collapse:collapse;margin:10px auto;width:90%;}
+      th,td{font-size:0.85rem;border:1px solid gray;padding:4px;text-align:right;}
+      td.l{text-align:left;}
+      tr.err td{color:#B00;}
+      a{color:black;text-decoration:none;}
+      body{max-width:1380px;margin:0 auto;padding-bottom:15px;}
+      .button{background-color:#4CAF50;border:1;color:white;padding:8px 16px;border-radius:5px;cursor:pointer;}
+      .button:hover{background-color:#4a4a4a;}
+      input{padding:5px;border-radius:5px;}
+    </style>
+  </head>
+  <body>
+  <h2>Evo Web Radio - Bank Probe</h2>
+  <p>Bank: <input id="bank" type="number" min="1" max="99" value="%B0" style="width:60px;">
+     Base: <input id="base" placeholder="http://127.0.0.1 (stand-in)" style="width:220px;">
+     <button class="button" onclick="cmd('start')">Start</button>
+     <button class="button" onclick="cmd('stop')">Stop</button></p>
+  <p id="status">-</p>
+  <table>
+    <thead><tr><th>#</th><th>Name</th><th>Result</th><th>HTTP</th><th>Redir</th><th>Host</th>
+      <th>DNS</th><th>TCP</th><th>TLS</th><th>1st byte</th><th>1st audio</th><th>Codec</th><th>kbps</th><th>Hz</th></tr></thead>
+    <tbody id="rows"></tbody>
+  </table>
+  <p style="font-size:0.8rem;"><a href="/menu">Go Back</a></p>
+
+  <script>
+    let timer=null,res=[];
+    function cmd(c){
+      let q='/api/probe?cmd='+c;
+      if(c=='start'){q+='&bank='+document.getElementById('bank').value;
+        const b=document.getElementById('base').value.trim(); if(b)q+='&base='+encodeURIComponent(b);}
+      fetch(q).then(r=>{if(!r.ok)r.text().then(t=>alert(t));if(c=='start')res=[];return refresh();});
+    }
+    function esc(s){return s.replace(/[&<>]/g,c=>({'&':'&amp;','<':'&lt;','>':'&gt;'}[c]));}
+    function refresh(){
+      return fetch('/api/probe?from='+res.length).then(r=>r.json()).then(d=>{
+        if(d.from==0||d.done<res.length)res=[];
+        res=res.concat(d.results);
+        const ms=v=>v?v+' ms':'-';
+        document.getElementById('status').innerText=(d.running?'Running':'Done')+' - bank '+d.bank+': '+d.done+
+          (d.total?'/'+d.total:'')+' tested, '+d.ok+' ok, '+(d.elapsed_ms/1000).toFixed(1)+' s'+(d.report?' - report '+d.report:'');
+        let h='';
+        res.forEach(r=>{h+='<tr'+(r.error!='ok'?' class="err"':'')+'><td>'+r.station+'</td><td class="l">'+esc(r.name)+'</td><td>'+r.error+
+          '</td><td>'+r.http+'</td><td>'+r.redirects+'</td><td class="l">'+(r.https?'&#128274; ':'')+esc(r.host)+'</td><td>'+ms(r.dns_ms)+
+          '</td><td>'+ms(r.tcp_ms)+'</td><td>'+ms(r.tls_ms)+'</td><td>'+ms(r.first_byte_ms)+'</td><td>'+ms(r.first_audio_ms)+
+          '</td><td>'+r.codec+'</td><td>'+(r.kbps||'-')+'</td><td>'+(r.sample_rate||'-')+'</td></tr>';});
+        document.getElementById('rows').innerHTML=h;
+        clearTimeout(timer); if(d.running||res.length<d.done)timer=setTimeout(refresh,d.results.length?200:2000);
+      });
+    }
+    refresh();
+  </script>
+</body>
+</html>
+)rawliteral";
+
 const char urlplay_html[] PROGMEM = R"rawliteral(
   <!DOCTYPE HTML>
   <html>
@@ -1750,8 +1918,6 @@ const char ota_html[] PROGMEM = R"rawliteral(
 
 
 
-char stations[MAX_STATIONS][STATION_NAME_LENGTH + 1];  // Tablica przechowująca linki do stacji radiowych (jedna na stację) +1 dla terminatora null
-
 const char *ntpServer1 = "pool.ntp.org";  // Adres serwera NTP używany do synchronizacji czasu
 const char *ntpServer2 = "time.nist.gov"; // Adres serwera NTP używany do synchronizacji czasu
 //const long gmtOffset_sec = 3600;          // Przesunięcie czasu UTC w sekundach
@@ -2118,6 +2284,7 @@ bool adcKeyboardEnabled = false;    // Flaga właczajaca działanie klawiatury A
 void displayDimmer(bool dimmerON);
 void displayDimmerTimer();
 void displayPowerSave(bool mode);
+String stationUrlFromStore(uint16_t index);
 
 
 #ifdef AUTOSTORAGE
@@ -2183,63 +2350,12 @@ bool isValidUtf8(const String& str)
 }
 */
 
-void removeUtf8Bom(String &text) 
+// Funkcja przetwarza tekst, zamieniając polskie znaki diakrytyczne na stronę kodową czcionki OLED
+// buf - bufor wywołującego (wyjście nie dłuższe niż wejście), bez współdzielonego stanu między zadaniami
+void processText(String &text, char* buf, size_t size) 
 {
-  if (text.length() >= 3 &&
-      (uint8_t)text[0] == 0xEF &&
-      (uint8_t)text[1] == 0xBB &&
-      (uint8_t)text[2] == 0xBF) {
-    text.remove(0, 3);  // usuń bajty EF BB BF
-  }
-}
-
-// Funkcja przetwarza tekst, zamieniając polskie znaki diakrytyczne
-void processText(String &text) 
-{
-  removeUtf8Bom(text); // Usuwamy znaki BOM na początku nazwy utworu
-
-  for (int i = 0; i < text.length() - 1; i++) 
-  {
-    if (i + 1 >= text.length()) break; // zabezpieczenie przed wyjściem poza bufor
-
-    switch ((uint8_t)text[i]) {
-      case 0xC3:
-        switch ((uint8_t)text[i + 1]) {
-          case 0xB3: text.setCharAt(i, 0xF3); break;  // ó
-          case 0x93: text.setCharAt(i, 0xD3); break;  // Ó
-        }
-        text.remove(i + 1, 1);
-        break;
-
-      case 0xC4:
-        switch ((uint8_t)text[i + 1]) {
-          case 0x85: text.setCharAt(i, 0xB9); break;  // ą
-          case 0x84: text.setCharAt(i, 0xA5); break;  // Ą
-          case 0x87: text.setCharAt(i, 0xE6); break;  // ć
-          case 0x86: text.setCharAt(i, 0xC6); break;  // Ć
-          case 0x99: text.setCharAt(i, 0xEA); break;  // ę
-          case 0x98: text.setCharAt(i, 0xCA); break;  // Ę
-        }
-        text.remove(i + 1, 1);
-        break;
-
-      case 0xC5:
-        switch ((uint8_t)text[i + 1]) {
-          case 0x82: text.setCharAt(i, 0xB3); break;  // ł
-          case 0x81: text.setCharAt(i, 0xA3); break;  // Ł
-          case 0x84: text.setCharAt(i, 0xF1); break;  // ń
-          case 0x83: text.setCharAt(i, 0xD1); break;  // Ń
-          case 0x9B: text.setCharAt(i, 0x9C); break;  // ś
-          case 0x9A: text.setCharAt(i, 0x8C); break;  // Ś
-          case 0xBA: text.setCharAt(i, 0x9F); break;  // ź
-          case 0xB9: text.setCharAt(i, 0x8F); break;  // Ź
-          case 0xBC: text.setCharAt(i, 0xBF); break;  // ż
-          case 0xBB: text.setCharAt(i, 0xAF); break;  // Ż
-        }
-        text.remove(i + 1, 1);
-        break;
-    }
-  }
+  text_transcode(text.c_str(), buf, size, nullptr, 0, nullptr);
+  text = buf;
 }
 
 /*
@@ -2286,86 +2402,34 @@ void win1250ToUtf8(String& input)
 }
 */
 
-bool sanitizeUtf8(String& s)
+// Poprawia tekst dla WWW do prawidłowego UTF-8 (bajty Win-1250 -> UTF-8), kopiuje tylko gdy trzeba
+// buf - bufor wywołującego (TEXT_WEB_MAX), każde zadanie używa własnego
+bool sanitizeUtf8(String& s, char* buf, size_t size)
 {
-  String out;
-  out.reserve(s.length() * 2);
+  text_result_t r;
+  text_transcode(s.c_str(), nullptr, 0, buf, size, &r);
 
-  const uint8_t* p = (const uint8_t*)s.c_str();
-
-  while (*p)
+  if (r.invalidBytes || r.bomRemoved) 
   {
-    uint8_t c = *p;
-
-    // ASCII
-    if (c < 0x80) {
-      out += (char)c;
-      p++;
-      continue;
-    }
-
-    // Poprawny UTF-8 (2–4 bajty)
-    uint8_t len = 0;
-    if ((c & 0xE0) == 0xC0) len = 2;
-    else if ((c & 0xF0) == 0xE0) len = 3;
-    else if ((c & 0xF8) == 0xF0) len = 4;
-
-    if (len) {
-      bool ok = true;
-      for (uint8_t i = 1; i < len; i++) {
-        if ((p[i] & 0xC0) != 0x80) {
-          ok = false;
-          break;
-        }
-      }
-      if (ok) {
-        for (uint8_t i = 0; i < len; i++)
-          out += (char)p[i];
-        p += len;
-        continue;
-      }
-    }
-
-    // Win-1250 na UTF-8 (PL)
-    switch (c)
-    {
-      case 0xA5: out += "Ą"; break;
-      case 0xB9: out += "ą"; break;
-      case 0xC6: out += "Ć"; break;
-      case 0xE6: out += "ć"; break;
-      case 0xCA: out += "Ę"; break;
-      case 0xEA: out += "ę"; break;
-      case 0xA3: out += "Ł"; break;
-      case 0xB3: out += "ł"; break;
-      case 0xD1: out += "Ń"; break;
-      case 0xF1: out += "ń"; break;
-      case 0xD3: out += "Ó"; break;
-      case 0xF3: out += "ó"; break;
-      case 0xA6: out += "Ś"; break;
-      case 0xB6: out += "ś"; break;
-      case 0xAF: out += "Ż"; break;
-      case 0xBF: out += "ż"; break;
-      case 0xAC: out += "Ź"; break;
-      case 0xBC: out += "ź"; break;
-      case 0x8C: out += "Ś"; break;
-      case 0x9C: out += "ś"; break;
-      case 0x8F: out += "Ź"; break;
-      case 0x9F: out += "ź"; break;
-      default:   Serial.print("debug - > UTF8 Web Sanitizer, Nieznany znak:"); Serial.println(c, HEX); out += '?'; break;
-    }
-
-    p++;
-  }
-
-  if (out != s) {
-    s = out;
+    s = buf;
     return true;   // coś poprawiono
   }
   return false;    // było OK
 }
 
+// Tytuł streamu - jedno przejście: stationString dla OLED, stationStringUtf8 dla WWW (bufory wywołującego)
+void setStationStringFromStream(const char* title, char* displayBuf, size_t displaySize, char* webBuf, size_t webSize)
+{
+  text_transcode(title, displayBuf, displaySize, webBuf, webSize, nullptr);
+
+  stationString = displayBuf;
+  stationString.trim();
+  stationStringUtf8 = webBuf;
+  stationStringUtf8.trim();
+}
+
 
-void wsStationChange(uint8_t stationId, uint8_t bankId) 
+void wsStationChange(uint16_t stationId, uint8_t bankId) 
 {
   // iteracja po wszystkich podłączonych klientach
   for (auto& client : ws.getClients()) 
@@ -2414,7 +2478,8 @@ void wsStreamInfoRefresh()
 
     if (audio.isRunning() == true)
     {  
-      sanitizeUtf8(stationStringWeb);
+      static char webBuf[TEXT_WEB_MAX];   // tylko zadanie loop()
+      sanitizeUtf8(stationStringWeb, webBuf, sizeof(webBuf));
       client.text("stationtext$" + stationStringWeb); 
     }
     else
@@ -2450,6 +2515,28 @@ void wsStreamInfoRefresh()
   }
 }
 
+// Tekst do JSON - cudzysłów, backslash i znaki sterujące
+String jsonEscape(const char* text)
+{
+  String out;
+  out.reserve(strlen(text) + 8);
+  for (; *text; text++)
+  {
+    if (*text == '"' || *text == '\\') { out += '\\'; out += *text; }
+    else if ((uint8_t)*text >= 0x20) { out += *text; }
+  }
+  return out;
+}
+
+void wsHistoryPush() // Najnowszy tytuł z historii do wszystkich klientów
+{
+  history_station_t hs;
+  history_entry_t entry;
+  if (!history_get_station(0, &hs) || history_get_titles(0, &entry, 1) == 0) return;
+  ws.textAll("history${\"station\":\"" + jsonEscape(hs.name) + "\",\"id\":\"" + String(hs.urlHash, HEX) +
+             "\",\"time\":" + String(entry.time) + ",\"title\":\"" + jsonEscape(entry.title) + "\"}");
+}
+
 void wsVolumeChange()  
 {
   ws.textAll("volume:" + String(volumeValue)); // wysyła wartosc volume do wszystkich połączonych klientów
@@ -2459,46 +2546,34 @@ void wsVolumeChange()
 //Funkcja odpowiedzialna za zapisywanie informacji o stacji do pamięci PSRAM
 void saveStationToPSRAM(const char *station) 
 {
-  
-  // Sprawdź, czy istnieje jeszcze miejsce na kolejną stację w pamięci PSRAM
-  if (stationsCount < MAX_STATIONS) {
-    int length = strlen(station);
-
-    // Sprawdź, czy długość linku nie przekracza ustalonego maksimum.
-    if (length <= STATION_NAME_LENGTH) {
-      // Zapisz długość linku jako pierwszy bajt.
-      psramData[stationsCount * (STATION_NAME_LENGTH + 1)] = length;
-      // Zapisz link jako kolejne bajty w pamięci PSRAM
-      for (int i = 0; i < length; i++) 
-      {
-        psramData[stationsCount * (STATION_NAME_LENGTH + 1) + 1 + i] = station[i];
-      }
-
-      // Wydrukuj informację o zapisanej stacji na Serialu.
-      Serial.println(String(stationsCount + 1) + "   " + String(station));  // Drukowanie na serialu od nr 1 jak w banku na serwerze
-
-      // Zwiększ licznik zapisanych stacji.
-      stationsCount++;
+  // Lista stacji nie ma stałych slotów - arena PSRAM rośnie razem z bankiem
+  if (station_store_add(station)) 
+  {
+    // Zwiększ licznik zapisanych stacji.
+    stationsCount = station_store_count();
 
-      // progress bar pobieranych stacji
+    // progress bar pobieranych stacji - odświeżany co 10 stacji aby duże banki nie wydłużały startu
+    if ((stationsCount % 10) == 1)
+    {
       u8g2.setFont(spleen6x12PL);  
       u8g2.drawStr(21, 36, "Progress:");
-      //u8g2.drawStr(21, 36, "Loading: ");
       u8g2.drawStr(75, 36, String(stationsCount).c_str());  // Napisz licznik pobranych stacji
 
       u8g2.drawRFrame(21, 42, 212, 12, 3);  // Ramka paska postępu ladowania stacji stacji w>8 h>8
       
-      int x = (stationsCount * 2) + 8;          // Dodajemy gdy stationCount=1 + 8 aby utrzymac warunek dla zaokrąglonego drawRBox - szerokość W>6 h>6 ma byc W>=2*(r+1), h >= 2*(r+1)
+      int x = ((stationsCount % 100) * 2) + 8;  // Pasek zawija co 100 stacji, +8 aby utrzymac warunek dla zaokrąglonego drawRBox W>=2*(r+1)
+      u8g2.setDrawColor(0);
+      u8g2.drawBox(23, 44, 208, 8);
+      u8g2.setDrawColor(1);
       u8g2.drawRBox(23, 44, x, 8, 2);       // Pasek postepu ladowania stacji z serwera lub karty SD / SPIFFS       
       
       u8g2.sendBuffer();  
-    } else {
-      // Informacja o błędzie w przypadku zbyt długiego linku do stacji.
-      Serial.println("Błąd: Link do stacji jest zbyt długi");
     }
-  } else {
-    // Informacja o błędzie w przypadku osiągnięcia maksymalnej liczby stacji.
-    Serial.println("Błąd: Osiągnięto maksymalną liczbę zapisanych stacji");
+  } 
+  else 
+  {
+    // Informacja o błędzie - zbyt długa linia lub brak pamięci PSRAM
+    Serial.println("Błąd: Nie można zapisać stacji (zbyt długi link lub brak pamięci PSRAM)");
   }
 }
 
@@ -2526,19 +2601,54 @@ void sanitizeAndSaveStation(const char *station) {
   saveStationToPSRAM(sanitizedStation);
 }
 
+// Odczyt linii banku ze strumienia (plik lub HTTP) prosto do listy stacji w PSRAM, bez bufora całego pliku
+void loadStationsFromStream(Stream &input)
+{
+  stationsCount = 0;
+  station_store_clear();   // Nowy bank - arena PSRAM używana od początku
+
+  int currentLine = 0;
+  String stationUrl = "";
+
+  station_search_bank_begin(bank_nr, 0); // Przebudowa indeksu wyszukiwarki tylko dla tego banku
+
+  while (input.available())
+  {
+    String line = input.readStringUntil('\n');
+    currentLine++;
+
+    stationName = line.substring(0, 42);
+    int urlStart = line.indexOf("http");  // Szukamy miejsca, gdzie zaczyna się URL
+    if (urlStart != -1) 
+    {
+      stationUrl = line.substring(urlStart);  // Wyciągamy URL od "http"
+      stationUrl.trim();                      // Usuwamy białe znaki na początku i końcu
+      String station = stationName + "  " + stationUrl;
+      uint16_t saved = stationsCount;
+      sanitizeAndSaveStation(station.c_str());  // przepisanie stacji do EEPROMu  (RAMU)
+      if (stationsCount != saved) station_search_bank_add(stationsCount, line.c_str()); // oryginalna linia z polskimi znakami do indeksu - numer jak przy odtwarzaniu
+    }
+  }
+  station_search_bank_end();
+
+  Serial.printf("debug SD -> Wczytano stacji: %d z linii: %d, PSRAM: %u B\n", stationsCount, currentLine, (unsigned)station_store_get_bytes_used());
+}
+
 // Odczyt banku z PIFFS lub karty SD (jesli dany bank istnieje juz na tej karcie)
 void readSDStations() 
 {
   stationsCount = 0;
+  station_store_clear();
   Serial.println("debuf SD -> Plik Banu isnieje lokalnie, czytamy TYLKO z karty");
   mp3 = flac = aac = vorbis = opus = false;
   stationString.remove(0);  // Usunięcie wszystkich znaków z obiektu stationString
+  stationStringUtf8.remove(0);
 
-  // Tworzymy nazwę pliku banku
-  String fileName = String("/bank") + (bank_nr < 10 ? "0" : "") + String(bank_nr) + ".txt";
+  // Nazwa pliku banku z rejestru banków
+  String fileName = String(bank_registry_file(bank_nr));
 
   // Sprawdzamy, czy plik istnieje
-  if (!STORAGE.exists(fileName)) 
+  if (fileName.isEmpty() || !STORAGE.exists(fileName)) 
   {
     Serial.println("Błąd: Plik banku nie istnieje.");
     return;
@@ -2552,33 +2662,7 @@ void readSDStations()
     return;
   }
 
-  // Przechodzimy do odpowiedniego wiersza pliku
-  int currentLine = 0;
-  String stationUrl = "";
-
-  while (bankFile.available())  // & currentLine <= MAX_STATIONS)
-  {
-    //if (currentLine < MAX_STATIONS)
-    //{
-    String line = bankFile.readStringUntil('\n');
-    currentLine++;
-
-    stationName = line.substring(0, 42);
-    int urlStart = line.indexOf("http");  // Szukamy miejsca, gdzie zaczyna się URL
-    if (urlStart != -1) 
-    {
-      stationUrl = line.substring(urlStart);  // Wyciągamy URL od "http"
-      stationUrl.trim();                      // Usuwamy białe znaki na początku i końcu
-      //Serial.print(" URL stacji:");
-      //Serial.println(stationUrl);
-      //String station = currentLine + "   " + stationName + "  " + stationUrl;
-      String station = stationName + "  " + stationUrl;
-      sanitizeAndSaveStation(station.c_str());  // przepisanie stacji do EEPROMu  (RAMU)
-    }
-  }
-
-  Serial.print("Zamykamy plik bankFile na wartosci currentLine:");
-  Serial.println(currentLine);
+  loadStationsFromStream(bankFile);
   bankFile.close();  // Zamykamy plik po odczycie
 }
 
@@ -2940,33 +3024,14 @@ void fetchStationsFromServer()
   String url; // URL stacji dla danego banku
 
   // ---------------------- WYBÓR URL BANKU ----------------------
-  switch (bank_nr) 
+  // Adres i plik banku z rejestru banków (/banks.txt lub domyślne STATIONS_URLx)
+  if ((bank_nr == 0) || (bank_nr > bank_registry_count()))
   {
-    case 1:  url = STATIONS_URL1; break;
-    case 2:  url = STATIONS_URL2; break;
-    case 3:  url = STATIONS_URL3; break;
-    case 4:  url = STATIONS_URL4; break;
-    case 5:  url = STATIONS_URL5; break;
-    case 6:  url = STATIONS_URL6; break;
-    case 7:  url = STATIONS_URL7; break;
-    case 8:  url = STATIONS_URL8; break;
-    case 9:  url = STATIONS_URL9; break;
-    case 10: url = STATIONS_URL10; break;
-    case 11: url = STATIONS_URL11; break;
-    case 12: url = STATIONS_URL12; break;
-    case 13: url = STATIONS_URL13; break;
-    case 14: url = STATIONS_URL14; break;
-    case 15: url = STATIONS_URL15; break;
-    case 16: url = STATIONS_URL16; break;
-    case 17: url = STATIONS_URL17; break;
-    case 18: url = STATIONS_URL18; break;
-    default:
-      Serial.println("Nieprawidłowy numer banku");
-      return;
+    Serial.println("Nieprawidłowy numer banku");
+    return;
   }
-
-  // Tworzenie nazwy pliku dla danego banku
-  String fileName = String("/bank") + (bank_nr < 10 ? "0" : "") + String(bank_nr) + ".txt";
+  url = bank_registry_url(bank_nr);
+  String fileName = String(bank_registry_file(bank_nr));
 
   // ---------------------- JEŚLI PLIK ISTNIEJE ----------------------
   if (STORAGE.exists(fileName) && bankNetworkUpdate == false) 
@@ -3015,7 +3080,9 @@ void fetchStationsFromServer()
   
   http.setConnectTimeout(3000);
 
+  net_connect_begin(url.c_str());
   int httpCode = http.GET();  
+  net_connect_end(httpCode > 0);
   Serial.print("debug http -> Kod HTTP: ");
   Serial.println(httpCode); // Wydrukuj dodatkowe informacje o kodzie http
 
@@ -3049,61 +3116,63 @@ void fetchStationsFromServer()
     return;
   }
 
-  // ---------------------- POBRANIE GETSTRING ----------------------
-  String payload = http.getString();
-
-  Serial.println("debug http -> Długość pobranych danych: " + String(payload.length()));
-
-  // Zabezpieczenie przed pustym stringiem
-  if (payload.length() == 0) 
-  {
-    Serial.println("debug http -> BŁĄD! Pobieranie zwróciło pusty payload. Usuwam plik.");
-    STORAGE.remove(fileName);
-    http.end();
-    return;
-  }
-
-  // ---------------------- ZAPIS DO PLIKU ----------------------
+  // ---------------------- ZAPIS STRUMIENIA DO PLIKU ----------------------
+  // Dane idą prosto z gniazda do pliku - bez bufora całej listy w pamięci
   File bankFile = STORAGE.open(fileName, FILE_WRITE);
   if (bankFile) 
   {
-    bankFile.print(payload);
+    int written = http.writeToStream(&bankFile);
     bankFile.close();
+    http.end();
+    Serial.println("debug http -> Długość pobranych danych: " + String(written));
+
+    // Zabezpieczenie przed pustym plikiem
+    if (written <= 0) 
+    {
+      Serial.println("debug http -> BŁĄD! Pobieranie zwróciło pusty payload. Usuwam plik.");
+      STORAGE.remove(fileName);
+      return;
+    }
     Serial.println("debug SD -> Dane zapisane do pliku: " + fileName);
+    readSDStations();
   } 
   else 
   {
+    // Brak możliwości zapisu - czytamy stacje bezpośrednio ze strumienia HTTP
     Serial.println("debug SD -> Błąd: Nie można otworzyć pliku do zapisu!");
+    loadStationsFromStream(*http.getStreamPtr());
+    http.end();
   }
 
-  http.end();
-
-  // ---------------------- SANITYZACJA STACJI  ----------------------
-  int startIndex = 0;
-  int endIndex;
-  stationsCount = 0;
+  wsRefreshPage();
+}
 
-  while ((endIndex = payload.indexOf('\n', startIndex)) != -1 && stationsCount < MAX_STATIONS) 
-  {
-    String station = payload.substring(startIndex, endIndex);
-    if (!station.isEmpty())
-      sanitizeAndSaveStation(station.c_str());
 
-    startIndex = endIndex + 1;
-  }
+// Układ EEPROM: 0 - młodszy bajt stacji, 1 - bank, 2 - głośność, 3 - starszy bajt stacji, 4 - znacznik układu
+static const uint8_t EEPROM_LAYOUT_ADDR      = 4;
+static const uint8_t EEPROM_LAYOUT_STATION16 = 0xA5;   // adres 3 zapisany - numer stacji 16-bitowy
 
-  wsRefreshPage();
+// Numer stacji z EEPROM - stary firmware nie zapisywał adresu 3 (zwykle 0xFF), bez znacznika starszy bajt = 0
+uint16_t readStationNrEEPROM()
+{
+  uint8_t high = (EEPROM.read(EEPROM_LAYOUT_ADDR) == EEPROM_LAYOUT_STATION16) ? EEPROM.read(3) : 0;
+  return EEPROM.read(0) | (high << 8);
 }
 
-
 void readEEPROM() // Funkcja kontrolna DEBUG odczytu EEPROMu, nie uzywan przez inne funkcje
 {
-  EEPROM.get(0, station_nr);
+  station_nr = readStationNrEEPROM();
   EEPROM.get(1, bank_nr);
   EEPROM.get(2, volumeValue); 
 }
 
 
+// Combo pilota (np. 99, 33) - ten sam klawisz dwa razy w krótkim odstępie, wolniejsze naciśnięcia to zwykłe wpisywanie cyfr
+bool irComboPressed(uint16_t key)
+{
+  return (ir_code == key) && (lastIrCode == key) && (millis() - lastIrCodeTime < irComboWindowMs);
+}
+
 void calcNec() // Funkcja umozliwajaca przeliczanie odwrotne aby "udawac" przyciski pilota IR w standardzie NEC
 {
   //składamy kod pilota do postaci ADDR/CMD/CMD/ADDR aby miec 4 bajty
@@ -3151,8 +3220,7 @@ void stationStringFormatting()
     }
     else // Jezeli stationString zawiera dane to przypisujemy go do stationStringScroll do funkcji scrollera
     {
-      stationStringWeb = stationString;
-      processText(stationString);  // przetwarzamy polsie znaki
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       stationStringScroll = stationString + "    "; // dodajemy separator do przewijanego tekstu jesli się nie miesci na ekranie
     }             
     
@@ -3171,7 +3239,7 @@ void stationStringFormatting()
   // ------ DUZY ZEGAR -------
   else if (displayMode == 1) // Tryb wświetlania zegara z 1 linijką radia na dole
   {
-    char StationNrStr[4];
+    char StationNrStr[STATION_NR_STR_LENGTH];
     snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
     
     if (urlPlaying) {
@@ -3201,8 +3269,7 @@ void stationStringFormatting()
     }
     else //stationString != "" -> ma wartość
     {
-      stationStringWeb = stationString;
-      processText(stationString);  // przetwarzamy polsie znaki
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       
       stationStringScroll = String(StationNrStr) + "." + stationName + ", " + stationString + "     "; 
       //stationStringScroll = String(StationNrStr) + "." + stationName; 
@@ -3237,8 +3304,7 @@ void stationStringFormatting()
     }
     else // Jezeli stationString zawiera dane to przypisujemy go do stationStringScroll do funkcji scrollera
     {
-      stationStringWeb = stationString;
-      processText(stationString);  // przetwarzamy polsie znaki
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       stationStringScroll = stationString;
     }  
   }
@@ -3259,8 +3325,7 @@ void stationStringFormatting()
     }
     else // Jezeli stationString zawiera dane to przypisujemy go do stationStringScroll do funkcji scrollera
     {
-      stationStringWeb = stationString;
-      processText(stationString);  // przetwarzamy polsie znaki
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       stationStringScroll = "  " + stationString + "  " ; // Nie dodajemy separator do tekstu aby wyswietlał się rowno na srodku
     }             
     //Liczymy długość napisu stationStringScroll 
@@ -3286,8 +3351,7 @@ void stationStringFormatting()
     }
     else // Jezeli stationString zawiera dane to przypisujemy go do stationStringScroll do funkcji scrollera
     {
-      stationStringWeb = stationString;
-      processText(stationString);  // przetwarzamy polsie znaki
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       stationStringScroll = "  " + stationString + "  " ; // Nie dodajemy separator do tekstu aby wyswietlał się rowno na srodku
     }             
     //Liczymy długość napisu stationStringScroll 
@@ -3314,8 +3378,7 @@ void stationStringFormatting()
     }
     else 
     {
-      stationStringWeb = stationString;
-      processText(stationString);
+      stationStringWeb = stationStringUtf8;  // tytuł przetworzony raz przy odbiorze (setStationStringFromStream)
       stationStringScroll = stationString + "    ";
     }             
     
@@ -3328,7 +3391,7 @@ void stationStringFormatting()
 void displayRadio() 
 {
   // KRYTYCZNE: Blokuj gdy SDPlayer aktywny
-  if (sdPlayerOLEDActive) return;
+  if (player_state_screen_active()) return;
   
   int StationNameEnd = stationName.indexOf("  "); // Wycinamy nazwe stacji tylko do miejsca podwojnej spacji 
   stationName = stationName.substring(0, StationNameEnd);
@@ -3357,7 +3420,7 @@ void displayRadio()
     
     u8g2.setDrawColor(0);
     
-    char StationNrStr[3];
+    char StationNrStr[STATION_NR_STR_LENGTH];
     snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
                                                 // Pozycja numeru stacji na gorze po lewej ekranu
     if (!urlPlaying) 
@@ -3433,7 +3496,7 @@ void displayRadio()
     
     u8g2.setFont(u8g2_font_04b_03_tr);
     char BankStr[8];  
-    char StationNrStr[3];
+    char StationNrStr[STATION_NR_STR_LENGTH];
     snprintf(BankStr, sizeof(BankStr), "%02d", bank_nr);
     snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);
     
@@ -3508,7 +3571,7 @@ void displayRadio()
     } //else {u8g2.print("URL");}
    
     u8g2.setDrawColor(0);
-    char StationNrStr[3];
+    char StationNrStr[STATION_NR_STR_LENGTH];
     snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
                                                 // Pozycja numeru stacji na gorze po lewej ekranu
     if (!urlPlaying) { u8g2.setCursor(4, 11); u8g2.print(StationNrStr);} else { u8g2.setCursor(5, 12); u8g2.print("URL");}
@@ -3583,7 +3646,7 @@ void displayRadio()
     
     if (!urlPlaying) // Jesli nie gramy z adresu URL wyslanego ze strony www
     {       
-      char StationNrStr[3]; snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
+      char StationNrStr[STATION_NR_STR_LENGTH]; snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
       
       if (f_simpleMode3)
       {
@@ -3641,7 +3704,7 @@ void displayRadio()
     //u8g2.setFont(mono04b03b);
     u8g2.setFont(u8g2_font_04b_03_tr);
     char BankStr[8];  
-    char StationNrStr[3];
+    char StationNrStr[STATION_NR_STR_LENGTH];
     snprintf(BankStr, sizeof(BankStr), "%02d", bank_nr); // Formatujemy numer banku do postacji 00
     snprintf(StationNrStr, sizeof(StationNrStr), "%02d", station_nr);  //Formatowanie informacji o stacji i banku do postaci 00
         
@@ -3721,154 +3784,72 @@ void my_audio_info(Audio::msg_t m)
   {
     case Audio::evt_info:  
     {
-      String msg = String(m.msg);   // zamiana na String
-      msg.trim(); // usuń spacje i \r\n
+      stream_info_scope_begin(); // Licznik alokacji sterty w obsłudze komunikatu
+
+      // Jedno przejście parsera po m.msg - bez String/indexOf/substring
+      uint8_t changed = stream_info_parse(m.msg, &streamInfo);
+
       // Sprawdź czy to błąd dekodera
-      if (msg.indexOf("Error") != -1 || msg.indexOf("error") != -1) {
-        Serial.printf("[AUDIO ERROR] %s\n", msg.c_str());
-        // Reset analizatora przy błędzie
-        eq_analyzer_reset();
+      if (changed & SI_EVENT_ERROR)
+      {
+        Serial.printf("[AUDIO ERROR] %s\n", m.msg);
+        eq_analyzer_reset(); // Reset analizatora przy błędzie
+        health_note_error();  // Licznik błędów dekodera dla nadzoru strumienia
       }
 
       // --- BitRate ---
-      int bitrateIndex = msg.indexOf("Bitrate (b/s):");  
-      if (bitrateIndex != -1)
-      {
-        int endIndex = msg.indexOf('\n', bitrateIndex);
-        if (endIndex == -1) endIndex = msg.length();
-        bitrateString = msg.substring(bitrateIndex + 14, endIndex);
-        bitrateString.trim();
-
-        //Przliczenie bps na Kbps
-        bitrateStringInt = bitrateString.toInt();  
-        bitrateStringInt = bitrateStringInt / 1000;
-        bitrateString = String(bitrateStringInt); 
-        
-        f_audioInfoRefreshDisplayRadio = true;
-        wsAudioRefresh = true;  //Web Socket - audio refresh
-        Serial.printf("bitrate: .... %s\n", m.msg); // icy-bitrate or bitrate from metadata
-      }
-      
-      // --- FLAC BitsPerSample ---
-      int bitrateIndexFlac = msg.indexOf("FLAC bitspersample:");
-      if ((bitrateIndexFlac != -1) && (flac == true))
+      if (changed & SI_CHANGED_BITRATE)
       {
-        Serial.printf("bitrate FLAC: .... %s\n", m.msg); // icy-bitrate or bitrate from metadata
-        int endIndex = msg.indexOf('\n', bitrateIndexFlac);
-        if (endIndex == -1) endIndex = msg.length();
-        bitrateString = msg.substring(bitrateIndex + 19, endIndex);
-        bitrateString.trim();
-
-        // przliczenie bps na Kbps
-        bitrateStringInt = bitrateString.toInt();  
-        bitrateStringInt = bitrateStringInt / 1000;
+        bitrateStringInt = streamInfo.bitrate / 1000; //Przliczenie bps na Kbps
         bitrateString = String(bitrateStringInt);
-            
-        f_audioInfoRefreshDisplayRadio = true;
-        wsAudioRefresh = true;  //Web Socket - audio refresh 
+        Serial.printf("bitrate: .... %s\n", m.msg); // icy-bitrate or bitrate from metadata
       }
 
-
       // --- SampleRate ---
-      int sampleRateIndex = msg.indexOf("SampleRate (Hz):");
-      if (sampleRateIndex != -1)
+      if (changed & SI_CHANGED_SAMPLERATE)
       {
-        int endIndex = msg.indexOf('\n', sampleRateIndex);
-        if (endIndex == -1) endIndex = msg.length();
-        //sampleRateString = msg.substring(sampleRateIndex + 11, endIndex);
-        sampleRateString = msg.substring(sampleRateIndex + 17, endIndex);
-        sampleRateString.trim();
-           
-        uint32_t fullSampleRate = sampleRateString.toInt();
-        SampleRate = fullSampleRate;
-        SampleRateRest = SampleRate % 1000;
-        SampleRateRest = SampleRateRest / 100;
-        SampleRate = SampleRate / 1000;
-        
+        sampleRateString = String(streamInfo.sampleRate);
+        SampleRate = streamInfo.sampleRate / 1000;
+        SampleRateRest = (streamInfo.sampleRate % 1000) / 100;
+
         // Ustaw sample rate w analizatorze
-        eq_analyzer_set_sample_rate(fullSampleRate);
-        Serial.printf("[AUDIO] Sample Rate detected: %u Hz\n", fullSampleRate);
-        
-        f_audioInfoRefreshDisplayRadio = true;
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
+        eq_analyzer_set_sample_rate(streamInfo.sampleRate);
+        Serial.printf("[AUDIO] Sample Rate detected: %u Hz\n", (unsigned)streamInfo.sampleRate);
       }
 
-      // --- BitsPerSample ---
-      int bitsPerSampleIndex = msg.indexOf("BitsPerSample:");
-      if (bitsPerSampleIndex != -1)
-      {     
-        int endIndex = msg.indexOf('\n', bitsPerSampleIndex);
-        if (endIndex == -1) endIndex = msg.length();
-        bitsPerSampleString = msg.substring(bitsPerSampleIndex + 15, endIndex);
-        bitsPerSampleString.trim();
-        
-        uint8_t bitsPerSample = bitsPerSampleString.toInt();
-        Serial.printf("[AUDIO] Bits per sample: %u\n", bitsPerSample);
-        
-        f_audioInfoRefreshDisplayRadio = true;	
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
+      // --- BitsPerSample (również "FLAC bitspersample:") ---
+      if (changed & SI_CHANGED_BITS)
+      {
+        bitsPerSampleString = String(streamInfo.bitsPerSample);
+        Serial.printf("[AUDIO] Bits per sample: %u\n", streamInfo.bitsPerSample);
       }
     
       // --- Rozpoznawanie dekodera / formatu ---
-      if (msg.indexOf("MP3Decoder") != -1)
-      {
-        mp3 = true;
-        flac = false; aac = false; vorbis = false; opus = false;
-        streamCodec = "MP3";
-        Serial.println("[AUDIO] Codec: MP3 detected");
-        eq_analyzer_set_flac_mode(false);
-        f_audioInfoRefreshDisplayRadio = true; // refresh displayRadio screen
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
-      }
-      if (msg.indexOf("FLACDecoder") != -1)
-      {
-        flac = true; 
-        mp3 = false; aac = false; vorbis = false; opus = false;
-        streamCodec = "FLAC";
-        Serial.println("[AUDIO] Codec: FLAC detected");
-        // Resetuj analizator dla nowego formatu i włącz tryb FLAC
-        eq_analyzer_set_flac_mode(true);
-        eq_analyzer_reset();
-        f_audioInfoRefreshDisplayRadio = true; // refresh displayRadio screen
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
-      }
-      if (msg.indexOf("AACDecoder") != -1)
-      {
-        aac = true;
-        flac = false; mp3 = false; vorbis = false; opus = false;
-        streamCodec = "AAC";
-        Serial.println("[AUDIO] Codec: AAC detected");
-        // Resetuj analizator dla nowego formatu
-        eq_analyzer_set_flac_mode(false);
-        eq_analyzer_reset();
-        f_audioInfoRefreshDisplayRadio = true; // refresh displayRadio screen
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
-      }
-      if (msg.indexOf("VORBISDecoder") != -1)
+      if (changed & SI_CHANGED_CODEC)
       {
-        vorbis = true;
-        aac = false; flac = false; mp3 = false; opus = false;
-        streamCodec = "VRB";
-        Serial.println("[AUDIO] Codec: VORBIS detected");
-        eq_analyzer_set_flac_mode(false);
-        eq_analyzer_reset();
-        f_audioInfoRefreshDisplayRadio = true; // refresh displayRadio screen
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
+        mp3    = (streamInfo.codec == SI_CODEC_MP3);
+        aac    = (streamInfo.codec == SI_CODEC_AAC);
+        flac   = (streamInfo.codec == SI_CODEC_FLAC);
+        vorbis = (streamInfo.codec == SI_CODEC_VORBIS);
+        opus   = (streamInfo.codec == SI_CODEC_OPUS);
+        streamCodec = stream_info_codec_name(streamInfo.codec);
+        Serial.printf("[AUDIO] Codec: %s detected\n", streamCodec.c_str());
+
+        // Resetuj analizator dla nowego formatu, tryb FLAC tylko dla FLAC
+        eq_analyzer_set_flac_mode(flac);
+        if (!mp3) {eq_analyzer_reset();}
       }
-      if (msg.indexOf("OPUSDecoder") != -1)
+
+      // Jedna maska zmian steruje odświeżeniem ekranu i WebSocket
+      if (changed & SI_CHANGED_DISPLAY)
       {
-        opus = true;
-        aac = false; flac = false; mp3 = false; vorbis = false;
-        streamCodec = "OPUS";
-        Serial.println("[AUDIO] Codec: OPUS detected");
-        eq_analyzer_set_flac_mode(false);
-        eq_analyzer_reset();
         f_audioInfoRefreshDisplayRadio = true; // refresh displayRadio screen
-        wsAudioRefresh = true;  //Web Socket - audio refresh    
+        wsAudioRefresh = true;  //Web Socket - audio refresh
       }
 
       // --- Debug ---
       Serial.printf("info: ....... %s\n", m.msg);      
+      stream_info_scope_end();
     }
     break;
 
@@ -3886,34 +3867,39 @@ void my_audio_info(Audio::msg_t m)
     {
       Serial.printf("end of file:  %s\n", m.msg);
       
-      // Sprawdź czy SDPlayer odtwarza muzykę - jeśli tak, ustaw flagę auto-play
-      if (sdPlayerPlayingMusic && g_sdPlayerWeb) {
+      // Sprawdź czy SDPlayer odtwarza muzykę - jeśli tak, żądanie auto-play
+      if (player_state_playing() && g_sdPlayerWeb) {
         Serial.println("[SDPlayer] Koniec utworu - żądanie automatycznego przejścia do następnego");
-        sdPlayerAutoPlayNext = true; // Ustaw flagę - obsługa w głównej pętli loop()
+        player_state_request_next(); // Obsługa w głównej pętli loop()
       }
       else if (resumePlay == true)
       {
+        voice_note_end(); // Koniec komunikatu zegara - od teraz mierzymy powrót stacji
         ir_code = rcCmdOk; // Przypisujemy kod pilota - OK
         bit_count = 32;
         calcNec();        // Przeliczamy kod pilota na pełny kod NEC
         resumePlay = false;
       }
+      else
+      {
+        health_note_eof(); // Koniec strumienia radia - nadzór zaplanuje ponowne połączenie
+      }
       
     }
     break;
 
     case Audio::evt_bitrate:
     {        
-      bitrateString = String(m.msg);
-      bitrateString.trim();
-      
-      // przliczenie bps na Kbps
-      bitrateStringInt = bitrateString.toInt();  
-      bitrateStringInt = bitrateStringInt / 1000;
-      bitrateString = String(bitrateStringInt);
-      
-      f_audioInfoRefreshDisplayRadio = true;
-      wsAudioRefresh = true;  //Web Socket - audio refresh
+      uint32_t bitrate = strtoul(m.msg, nullptr, 10);
+      if (bitrate && bitrate != streamInfo.bitrate)
+      {
+        streamInfo.bitrate = bitrate;
+        bitrateStringInt = bitrate / 1000; // przliczenie bps na Kbps
+        bitrateString = String(bitrateStringInt);
+        
+        f_audioInfoRefreshDisplayRadio = true;
+        wsAudioRefresh = true;  //Web Socket - audio refresh
+      }
       Serial.printf("info: ....... evt_bitrate: %s\n", m.msg); break; // icy-bitrate or bitrate from metadata
     }
     case Audio::evt_icyurl:         Serial.printf("icy URL: .... %s\n", m.msg); break;
@@ -3936,8 +3922,14 @@ void my_audio_info(Audio::msg_t m)
 
     case Audio::evt_streamtitle: // Zapisz tytuł utworu
     {
-      stationString = String(m.msg);
-		  stationString.trim();
+      static char titleDisplay[TEXT_DISPLAY_MAX];   // bufory tytułu - tylko zadanie loop() (callback audio)
+      static char titleWeb[TEXT_WEB_MAX];
+      setStationStringFromStream(m.msg, titleDisplay, sizeof(titleDisplay), titleWeb, sizeof(titleWeb)); // OLED + WWW w jednym przejściu
+      rec_mark_title(stationStringUtf8.c_str()); // Znacznik w pliku .cue gdy trwa nagrywanie
+
+      // Historia tytułów stacji - nowy wpis wysyłany do stron WWW
+      String historyUrl = urlPlaying ? url2play : stationUrlFromStore(station_nr - 1);
+      if (history_add(stationName.c_str(), historyUrl.c_str(), stationStringUtf8.c_str())) { wsHistoryPush(); }
 		
       //ActionNeedUpdateTime = true;
       f_audioInfoRefreshStationString = true;	
@@ -3959,7 +3951,16 @@ void my_audio_info(Audio::msg_t m)
     break;
     
     case Audio::evt_icydescription: Serial.printf("icy descr: .. %s\n", m.msg); break;
-    case Audio::evt_image: for(int i = 0; i < m.vec.size(); i += 2) { Serial.printf("cover image:  segment %02i, pos %07lu, len %05lu\n", i / 2, m.vec[i], m.vec[i + 1]);} break; // APIC
+    case Audio::evt_image:
+      for(int i = 0; i < m.vec.size(); i += 2) { Serial.printf("cover image:  segment %02i, pos %07lu, len %05lu\n", i / 2, m.vec[i], m.vec[i + 1]);} // APIC
+      // Okładka odtwarzanego pliku - dekodowanie w tle (CoverArt), wynik w bazie biblioteki.
+      // Ścieżka pliku otwartego przez dekoder - przy gapless PlayerState dostaje nową dopiero w loop()
+      if (player_state_playing() && g_sdPlayerWeb && m.vec.size() >= 2)
+      {
+        char path[AUDIO_CMD_TEXT_LENGTH + 1];
+        if (audio_task_open_file(path, sizeof(path))) cover_art_source(path, m.vec.data(), m.vec.size() / 2);
+      }
+      break;
     case Audio::evt_lyrics:         Serial.printf("sync lyrics:  %s\n", m.msg); break;
     default:                        Serial.printf("message:..... %s\n", m.msg); break;
   }
@@ -4017,10 +4018,16 @@ void bankMenuDisplay()
   
   }
   
+  // Nazwa banku z rejestru banków
+  u8g2.setFont(spleen6x12PL);
+  String bankName = String(bank_registry_name(bank_nr)).substring(0, 40);
+  u8g2.drawStr((256 - bankName.length() * 6) / 2, 12, bankName.c_str());
+
   u8g2.drawRFrame(21, 42, 214, 14, cornerRadius);                // Ramka do slidera bankow
     
   uint16_t sliderX = 23 + (uint16_t)round((bank_nr - 1)* segmentWidth); // Przeliczenie zmiennej X z zaokragleniemw  gore dla położenia slidera
-  uint16_t sliderWidth = (uint16_t)round(segmentWidth - 2); // Przliczenie szwerokości slidera w zaleznosci od ilosi banków
+  uint16_t sliderWidth = (segmentWidth > 4) ? (uint16_t)round(segmentWidth - 2) : 2; // Przliczenie szwerokości slidera w zaleznosci od ilosi banków, min. 2px przy dużej liczbie banków
+  if (sliderX + sliderWidth > 233) { sliderX = 233 - sliderWidth; }
   u8g2.drawRBox(sliderX, 44, sliderWidth, 10, 2);
 
   //u8g2.drawRBox((bank_nr * 13) + 10, 44, 15, 10, 2);  // wypełnienie slidera Rbox dla stałej wartosci max_bank = 16, stara wersja
@@ -4032,7 +4039,7 @@ void bankMenuDisplay()
 void handleButtons() 
 {
   // Blokuj obsługę przycisków radia gdy SD Player jest aktywny
-  if (sdPlayerOLEDActive) return;
+  if (player_state_screen_active()) return;
   
   static unsigned long buttonPressTime2 = 0;  // Zmienna do przechowywania czasu naciśnięcia przycisku enkodera 2
   static bool isButton2Pressed = false;       // Flaga do śledzenia, czy przycisk enkodera 2 jest wciśnięty
@@ -4208,7 +4215,7 @@ void readVolumeFromSD()
     EEPROM.get(2, volumeValue);
     if (volumeValue > maxVolume) {volumeValue = 10;} // zabezpiczenie przed pusta komorka EEPROM o wartosci FF (255)
     
-    if (f_volumeFadeOn == false) {audio.setVolume(volumeValue);}  // zakres 0...21...42
+    if (f_volumeFadeOn == false) {audio_cmd_volume(volumeValue);}  // zakres 0...21...42
     volumeBufferValue = volumeValue; 
     
     Serial.println(volumeValue);
@@ -4245,44 +4252,15 @@ void saveVolumeOnSD()
 {
   volumeBufferValue = volumeValue; // Wyrownanie wartosci bufora Volume i Volume przy zapisie
   
-  // Sprawdź, czy plik volume.txt istnieje
   Serial.print("debug SD -> Zaspis do pliku wartosci Volume: ");
   Serial.println(volumeValue); 
   
-  // Sprawdź, czy plik istnieje
-  if (STORAGE.exists("/volume.txt")) 
+  // Zapis odłożony przez harmonogram SD - seria zmian głośności = jeden zapis, w przerwie odtwarzania
+  char line[8];
+  int len = snprintf(line, sizeof(line), "%u\r\n", (unsigned)volumeValue);
+  if (!sdio_write_file("/volume.txt", line, len, SDIO_CLASS_CONFIG))
   {
-    Serial.println("debug SD -> Plik volume.txt już istnieje.");
-
-    // Otwórz plik do zapisu i nadpisz aktualną wartość flitrów equalizera
-    myFile = STORAGE.open("/volume.txt", FILE_WRITE);
-    if (myFile) 
-	  {
-      myFile.println(volumeValue);
-      myFile.close();
-      Serial.println("debug SD -> Aktualizacja volume.txt na karcie SD");
-    } 
-	  else 
-	  {
-      Serial.println("debug SD -> Błąd podczas otwierania pliku volume.txt.");
-    }
-  } 
-  else 
-  {
-    Serial.println("debug SD -> Plik volume.txt nie istnieje. Tworzenie...");
-
-    // Utwórz plik i zapisz w nim aktualną wartość głośności
-    myFile = STORAGE.open("/volume.txt", FILE_WRITE);
-    if (myFile) 
-	  {
-      myFile.println(volumeValue);
-      myFile.close();
-      Serial.println("debug SD -> Utworzono i zapisano volume.txt na karcie SD");
-    } 
-    else 
-    {
-      Serial.println("debug SD -> Błąd podczas tworzenia pliku volume.txt.");
-    }
+    Serial.println("debug SD -> Błąd zapisu pliku volume.txt.");
   }
   if (noSDcard == true) {EEPROM.write(2,volumeValue); EEPROM.commit(); Serial.println("debug eeprom -> Zapis volume do EEPROM");}
 }
@@ -4380,39 +4358,28 @@ void rcInputKey(uint8_t i)
     displayActive = true;
     displayStartTime = millis(); 
     
-    if (rcInputDigit1 == 0xFF)
-    {
-      rcInputDigit1 = i;
-    }
-    else 
-    {
-      rcInputDigit2 = i;
-    }
+    // Tyle cyfr ile ma liczba stacji w banku (min. 2 jak dotychczas), po ostatniej cyfrze pole od nowa
+    uint8_t digitsNeeded = 2;
+    for (uint32_t n = stationsCount; n >= 100 && digitsNeeded < STATION_NR_DIGITS_MAX; n /= 10) {digitsNeeded++;}
+    if (rcInputDigitCount >= digitsNeeded) {rcInputDigitCount = 0;}
+    if (rcInputDigitCount == 0) {rcInputNumber = 0;}
+    rcInputNumber = rcInputNumber * 10 + i;
+    rcInputDigitCount++;
 
     int y = 35;
     u8g2.clearBuffer();
     u8g2.setFont(u8g2_font_fub14_tf); // cziocnka 14x11
     u8g2.drawStr(65, y, "Station:"); 
-    if (rcInputDigit1 != 0xFF)
-    {u8g2.drawStr(153, y, String(rcInputDigit1).c_str());} 
-    //else {u8g2.drawStr(153, x,"_" ); }
-    else {u8g2.drawStr(153, y,"_" ); }
-    
-    if (rcInputDigit2 != 0xFF)
-    {u8g2.drawStr(164, y, String(rcInputDigit2).c_str());} 
-    else {u8g2.drawStr(164, y,"_" ); }
-
-
-
-    if ((rcInputDigit1 != 0xFF) && (rcInputDigit2 != 0xFF)) // jezeli obie wartosci nie są puste
+    char digitsStr[STATION_NR_STR_LENGTH];
+    snprintf(digitsStr, sizeof(digitsStr), "%0*u", rcInputDigitCount, (unsigned)rcInputNumber);
+    for (uint8_t d = 0; d < digitsNeeded; d++)
     {
-      station_nr = (rcInputDigit1 *10) + rcInputDigit2;
-    }
-    else if ((rcInputDigit1 != 0xFF) && (rcInputDigit2 == 0xFF))  // jezeli tylko podalismy jedna cyfrę
-    { 
-      station_nr = rcInputDigit1;
+      char digit[2] = { d < rcInputDigitCount ? digitsStr[d] : '_', '\0' };
+      u8g2.drawStr(153 + d * 11, y, digit);
     }
 
+    station_nr = (rcInputNumber > 0xFFFF) ? 0xFFFF : rcInputNumber;
+
     if (station_nr > stationsCount)  // sprawdzamy czy wprowadzona wartość nie wykracza poza licze stacji w danym banku
     {
       station_nr = stationsCount;  // jesli wpisana wartość jest wieksza niz ilosc stacji to ustawiamy war
@@ -4426,11 +4393,7 @@ void rcInputKey(uint8_t i)
     // Odczyt stacji pod daną komórka pamieci PSRAM:
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
     memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-    int length = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1)];   // Odczytaj długość nazwy stacji z PSRAM dla bieżącego indeksu stacji
-    
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) { // Odczytaj nazwę stacji z PSRAM jako ciąg bajtów, maksymalnie do STATION_NAME_LENGTH
-      station[j] = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }
+    station_store_get(station_nr - 1, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
     u8g2.setFont(spleen6x12PL);
     String stationNameText = String(station);
     stationNameText = stationNameText.substring(0, 25); // Przycinamy do 23 znakow
@@ -4441,10 +4404,9 @@ void rcInputKey(uint8_t i)
     u8g2.print("Bank:" + String(bank_nr) + ", 1-" + String(stationsCount) + "     " + stationNameText);
     u8g2.sendBuffer();
 
-    if ((rcInputDigit1 !=0xFF) && (rcInputDigit2 !=0xFF)) // jezeli wpisalismy obie cyfry to czyscimy pola aby mozna bylo je wpisac ponownie
+    if (rcInputDigitCount >= digitsNeeded) // wpisalismy wszystkie cyfry - czyscimy pole aby mozna bylo wpisac numer ponownie bez czekania 6 sek
     {
-      rcInputDigit1 = 0xFF; // czyscimy cyfre 1, flaga pustej zmiennej F aby naciskajac kolejny raz mozna bylo wypisac cyfre bez czekania 6 sek
-      rcInputDigit2 = 0xFF; // czyscimy cyfre 2, flaga pustej zmiennej F
+      rcInputDigitCount = 0;
     }
   }  
 }
@@ -4461,67 +4423,25 @@ void saveStationOnSD()
     Serial.print("debug SD -> Zapisujemy stacje: ");
     Serial.println(station_nr);
 
-    // Sprawdź, czy plik station_nr.txt istnieje
-    if (STORAGE.exists("/station_nr.txt")) {
-      Serial.println("debug SD -> Plik station_nr.txt już istnieje.");
-
-      // Otwórz plik do zapisu i nadpisz aktualną wartość station_nr
-      myFile = STORAGE.open("/station_nr.txt", FILE_WRITE);
-      if (myFile) {
-        myFile.println(station_nr);
-        myFile.close();
-        Serial.println("debug SD -> Aktualizacja station_nr.txt na karcie SD");
-      } else {
-        Serial.println("debug SD -> Błąd podczas otwierania pliku station_nr.txt.");
-      }
-    } else {
-      Serial.println("debug SD -> Plik station_nr.txt nie istnieje. Tworzenie...");
-
-      // Utwórz plik i zapisz w nim aktualną wartość station_nr
-      myFile = STORAGE.open("/station_nr.txt", FILE_WRITE);
-      if (myFile) {
-        myFile.println(station_nr);
-        myFile.close();
-        Serial.println("debug SD -> Utworzono i zapisano station_nr.txt na karcie SD");
-      } else {
-        Serial.println("debug SD -> Błąd podczas tworzenia pliku station_nr.txt.");
-      }
-    }
-
-    // Sprawdź, czy plik bank_nr.txt istnieje
-    if (STORAGE.exists("/bank_nr.txt")) 
+    // Zapis odłożony przez harmonogram SD - szybkie przełączanie stacji = jeden zapis, w przerwie odtwarzania
+    char line[8];
+    int len = snprintf(line, sizeof(line), "%u\r\n", (unsigned)station_nr);
+    if (!sdio_write_file("/station_nr.txt", line, len, SDIO_CLASS_CONFIG))
     {
-      Serial.println("debug SD -> Plik bank_nr.txt już istnieje.");
-
-      // Otwórz plik do zapisu i nadpisz aktualną wartość bank_nr
-      myFile = STORAGE.open("/bank_nr.txt", FILE_WRITE);
-      if (myFile) {
-        myFile.println(bank_nr);
-        myFile.close();
-        Serial.println("debug SD -> Aktualizacja bank_nr.txt na karcie STORAGE.");
-      } else {
-        Serial.println("debug SD -> Błąd podczas otwierania pliku bank_nr.txt.");
-      }
-    } 
-    else 
+      Serial.println("debug SD -> Błąd zapisu pliku station_nr.txt.");
+    }
+    len = snprintf(line, sizeof(line), "%u\r\n", (unsigned)bank_nr);
+    if (!sdio_write_file("/bank_nr.txt", line, len, SDIO_CLASS_CONFIG))
     {
-      Serial.println("debug SD -> Plik bank_nr.txt nie istnieje. Tworzenie...");
-
-      // Utwórz plik i zapisz w nim aktualną wartość bank_nr
-      myFile = STORAGE.open("/bank_nr.txt", FILE_WRITE);
-      if (myFile) {
-        myFile.println(bank_nr);
-        myFile.close();
-        Serial.println("debug SD -> Utworzono i zapisano bank_nr.txt na karcie SD");
-      } else {
-        Serial.println("debug SD -> Błąd podczas tworzenia pliku bank_nr.txt.");
-      }
+      Serial.println("debug SD -> Błąd zapisu pliku bank_nr.txt.");
     }
     
     if (noSDcard == true)
     {
       Serial.println("debug SD -> Brak karty SD zapisujemy do EEPROM");
-      EEPROM.write(0, station_nr);
+      EEPROM.write(0, station_nr & 0xFF);
+      EEPROM.write(3, station_nr >> 8);
+      EEPROM.write(EEPROM_LAYOUT_ADDR, EEPROM_LAYOUT_STATION16);
       EEPROM.write(1, bank_nr);
       EEPROM.commit();
     }
@@ -4537,7 +4457,7 @@ void startFadeIn(uint8_t target)
 {
   targetVolume = target;
   currentVolume = 0;
-  audio.setVolume(0);
+  audio_cmd_volume(0);
   fadingIn = true;
   lastFadeTime = millis();
 }
@@ -4552,13 +4472,13 @@ void handleFadeIn()
 
     if (currentVolume < targetVolume)
     {
-      audio.setVolume(currentVolume);
+      audio_cmd_volume(currentVolume);
       currentVolume++;
     }
     else
     {
       fadingIn = false; // zakończ fade-in
-      audio.setVolume(targetVolume);
+      audio_cmd_volume(targetVolume);
     }
   }
 }
@@ -4567,12 +4487,61 @@ void volumeFadeOut(uint8_t time_ms)
 {
   for (uint8_t i = volumeValue; i > 0; i--)
   {
-    audio.setVolume(i);
+    audio_cmd_volume(i);
     delay(time_ms);
   } 
 }
 
 
+// Odczytuje URL stacji o indeksie index (od 0) z listy w PSRAM, "" gdy brak
+String stationUrlFromStore(uint16_t index)
+{
+  char station[STATION_NAME_LENGTH + 1];
+  if (!station_store_get(index, station, sizeof(station))) {return "";}
+
+  char url[HEALTH_URL_LENGTH + 1];
+  if (!health_first_url(station, url, sizeof(url))) {return "";}  // Tylko adres główny, bez zapasowych
+  return String(url);
+}
+
+// Zlecenie rozgrzania stacji sąsiednich (z zawijaniem listy jak przy enkoderze)
+void warmNeighbourStations()
+{
+  uint16_t count = station_store_count();
+  if (count < 2 || station_nr == 0) {return;}
+
+  uint16_t prevIndex = (station_nr >= 2) ? station_nr - 2 : count - 1;  // station_nr-1
+  uint16_t nextIndex = (station_nr < count) ? station_nr : 0;           // station_nr+1
+
+  String prevUrl = stationUrlFromStore(prevIndex);
+  String nextUrl = stationUrlFromStore(nextIndex);
+  warm_neighbours(prevUrl.c_str(), nextUrl.c_str());
+}
+
+// Start nagrywania bieżącej stacji na kartę SD (minutes = 0 - bez limitu czasu)
+bool recordingStart(uint16_t minutes)
+{
+  if (!useSD) {Serial.println("debug rec -> Nagrywanie wymaga karty SD"); return false;}
+
+  String url = urlPlaying ? url2play : stationUrlFromStore(station_nr - 1);
+  if (url == "") {return false;}
+  return rec_start(url.c_str(), stationName.c_str(), minutes);
+}
+
+// Ponowne połączenie zleconą przez nadzór strumienia (ten sam lub zapasowy URL), bez przerysowania ekranu
+void streamReconnect(const char* url)
+{
+  Serial.printf("debug health -> Łączę ponownie: %s\n", url);
+  stream_info_reset(&streamInfo);
+  timeshift_reset();
+
+  net_connect_begin(url);
+  bool connected = audio_cmd_connect(url, 0);
+  net_connect_end(connected);
+  health_connect_result(connected);
+  if (!volumeMute) {audio_cmd_volume(volumeValue);}
+}
+
 void changeStation() 
 {
   fwupd = false;
@@ -4584,12 +4553,15 @@ void changeStation()
 
   mp3 = flac = aac = vorbis = opus = false;
   streamCodec = "-";
+  stream_info_reset(&streamInfo);
+  timeshift_reset();
   //stationLogoUrl = "";
   
   if (urlPlaying) {bank_nr = previous_bank_nr;}  // Przywracamy ostatni numer banku po graniu z ULR gdzie ustawilismy bank na 0
     
   // Usunięcie wszystkich znaków z obiektów 
   stationString.remove(0);  
+  stationStringUtf8.remove(0);
   stationNameStream.remove(0);
   stationStringWeb.remove(0);
   stationLogoUrl.remove(0);
@@ -4610,12 +4582,7 @@ void changeStation()
   // Odczyt stacji pod daną komórka pamieci PSRAM:
   char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
   memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-  int length = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1)];   // Odczytaj długość nazwy stacji z PSRAM dla bieżącego indeksu stacji
-      
-  for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-  { // Odczytaj nazwę stacji z PSRAM jako ciąg bajtów, maksymalnie do STATION_NAME_LENGTH
-    station[j] = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-  }
+  station_store_get(station_nr - 1, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
   
   //Serial.println("-------- GRAMY OBECNIE ---------- ");
   //Serial.print(station_nr - 1);
@@ -4633,8 +4600,7 @@ void changeStation()
   int urlStart = line.indexOf("http");  // Szukamy miejsca, gdzie zaczyna się URL
   if (urlStart != -1) 
   {
-    stationUrl = line.substring(urlStart);  // Wyciągamy URL od "http"
-    stationUrl.trim();                      // Usuwamy białe znaki na początku i końcu
+    stationUrl = health_begin(station);     // Adres główny lub zapasowy - najmniej zawodny wg statystyk
   }
   else
   {
@@ -4674,10 +4640,17 @@ void changeStation()
     if (f_volumeFadeOn && !volumeMute) {volumeFadeOut(volumeFadeOutTime);}
     
     // Połącz z daną stacją
-    audio.connecttohost(stationUrl.c_str());
+    uint32_t inBufferSize = buf_ctrl_begin(stationUrl.c_str(), stationName.c_str()); // Rozmiar bufora z historii stacji
+
+    warm_switch_begin(stationUrl.c_str());
+    net_connect_begin(stationUrl.c_str());
+    bool connected = audio_cmd_connect(stationUrl.c_str(), inBufferSize);
+    net_connect_end(connected);
+    warm_switch_end(connected);
+    health_connect_result(connected);
     
     // Właczamy sciszanie tylko jesli MUTE jest wyłaczone. Jesli MUTE jest wyłączone i sciszanie równiez to ustawiamy głośnośc zgodnie z volumeValue 
-    if (f_volumeFadeOn && !volumeMute) {startFadeIn(volumeValue);} else if (!volumeMute) {audio.setVolume(volumeValue);}   
+    if (f_volumeFadeOn && !volumeMute) {startFadeIn(volumeValue);} else if (!volumeMute) {audio_cmd_volume(volumeValue);}   
     
     // Zapisujemy jaki numer stacji i który bank gramy tylko jesli sie zmieniły
     //if ((station_nr != stationFromBuffer || bank_nr != previous_bank_nr) && f_saveVolumeStationAlways) {saveStationOnSD();}
@@ -4688,6 +4661,8 @@ void changeStation()
     //saveStationOnSD(); // Zapisujemy jaki numer stacji i który bank gramy
 
     urlPlaying = false; // Kasujemy flage odtwarzania z adresu przesłanego ze strony WWW
+
+    if (f_warmNeighbours) {warmNeighbourStations();} // Rozgrzewamy DNS stacji station_nr-1 i station_nr+1
         
   } 
   else 
@@ -4716,7 +4691,7 @@ void displayStations()
   u8g2.setCursor(20, 10);                                          // Ustaw pozycję kursora (x=60, y=10) dla nagłówka
   u8g2.print("BANK: " + String(bank_nr));                                          // Wyświetl nagłówek "BANK:"
   u8g2.setCursor(68, 10);                                          // Ustaw pozycję kursora (x=60, y=10) dla nagłówka
-  u8g2.print(" - RADIO STATIONS: ");                                // Wyświetl nagłówek "Radio Stations:"
+  u8g2.print(" - " + String(bank_registry_name(bank_nr)).substring(0, 16) + ": ");  // Wyświetl nazwę banku z rejestru
   u8g2.print(String(station_nr) + " / " + String(stationsCount));  // Dodaj numer aktualnej stacji i licznik wszystkich stacji
   u8g2.drawLine(0,11,256,11);
   // "BANK: 16 - RADIO STATIONS: 99 / 99
@@ -4733,14 +4708,7 @@ void displayStations()
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
     memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
 
-    // Odczytaj długość nazwy stacji z PSRAM dla bieżącego indeksu stacji
-    int length = psramData[i * (STATION_NAME_LENGTH + 1)];  //----------------------------------------------
-
-    // Odczytaj nazwę stacji z PSRAM jako ciąg bajtów, maksymalnie do STATION_NAME_LENGTH
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-    {
-      station[j] = psramData[i * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }
+    station_store_get(i, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
 
     // Sprawdź, czy bieżąca stacja to ta, która jest aktualnie zaznaczona
     if (i == currentSelection) 
@@ -5036,10 +5004,32 @@ void readEqualizerFromSD()
 	  toneMidValue = 0; // Domyślna wartość filtra gdy brak karty SD
 	  toneLowValue = 0; // Domyślna wartość filtra gdy brak karty SD
   }
-  audio.setTone(toneLowValue, toneMidValue, toneHiValue); // Ustawiamy filtry - zakres regulacji -40 + 6dB jako int8_t ze znakiem
+  audio_cmd_tone(toneLowValue, toneMidValue, toneHiValue); // Ustawiamy filtry - zakres regulacji -40 + 6dB jako int8_t ze znakiem
 }
 
 // Funkcja do odczytu danych stacji radiowej z karty SD
+// Rejestr banków - plik /banks.txt (nazwa;url;plik), gdy go brak to domyślne banki STATIONS_URLx
+void readBankRegistry()
+{
+  bank_registry_init();
+
+  if (bank_registry_load(STORAGE, BANK_REGISTRY_FILE) == 0)
+  {
+    const char* defaultBankUrls[BANK_NR_MAX_DEFAULT] = {
+      STATIONS_URL1, STATIONS_URL2, STATIONS_URL3, STATIONS_URL4, STATIONS_URL5, STATIONS_URL6,
+      STATIONS_URL7, STATIONS_URL8, STATIONS_URL9, STATIONS_URL10, STATIONS_URL11, STATIONS_URL12,
+      STATIONS_URL13, STATIONS_URL14, STATIONS_URL15, STATIONS_URL16, STATIONS_URL17 };
+
+    Serial.println("debug banks -> Brak pliku " BANK_REGISTRY_FILE ", używam domyślnych banków");
+    bank_registry_clear();
+    for (uint8_t i = 0; i < BANK_NR_MAX_DEFAULT; i++) { bank_registry_add(nullptr, defaultBankUrls[i], nullptr); }
+  }
+
+  bank_nr_max = bank_registry_count();
+  if (bank_nr_max == 0) { bank_nr_max = 1; } // Zabezpieczenie dla pustego rejestru
+  station_search_set_bank_count(bank_nr_max);
+}
+
 void readStationFromSD() 
 {
   // Sprawdź, czy karta SD jest dostępna
@@ -5050,7 +5040,7 @@ void readStationFromSD()
     Serial.println("debug SD -> Nie można znaleźć karty SD, ustawiam wartości z EEPROMu");
     //station_nr = 1;  // Domyślny numer stacji gdy brak karty SD
     //bank_nr = 1;     // Domyślny numer banku gdy brak karty SD
-    EEPROM.get(0, station_nr);
+    station_nr = readStationNrEEPROM(); // Młodszy bajt pod 0, starszy pod 3 (po zapisie znacznika układu)
     EEPROM.get(1, bank_nr);
     
     Serial.print("debug EEPROM -> Odczyt EEPROM Stacja: ");
@@ -5058,7 +5048,7 @@ void readStationFromSD()
     Serial.print("debug EEPROM -> Odczyt EEPROM Bank: ");
     Serial.println(bank_nr);
 
-    if ((station_nr > 99) || (station_nr == 0)) { station_nr = 1;} // zabezpiecznie na wypadek błędnego odczytu EEPROMu lub wartości
+    if ((station_nr == 0xFFFF) || (station_nr == 0)) { station_nr = 1;} // zabezpiecznie na wypadek błędnego odczytu EEPROMu lub wartości
     if ((bank_nr > bank_nr_max) || (bank_nr == 0)) { bank_nr = 1;}
     
     return;
@@ -5678,7 +5668,7 @@ void showIP(uint16_t xip, uint16_t yip)
 void displayClearUnderScroller() // Funkcja odpwoiedzialna za przewijanie informacji strem tittle lub stringstation
 {
   // KRYTYCZNE: Blokuj gdy SDPlayer aktywny
-  if (sdPlayerOLEDActive) return;
+  if (player_state_screen_active()) return;
   
   if (displayMode == 0) // Tryb normalny Mode 0- radio
   {
@@ -5717,7 +5707,7 @@ void displayClearUnderScroller() // Funkcja odpwoiedzialna za przewijanie inform
 void displayRadioScroller() // Funkcja odpwoiedzialna za przewijanie informacji strem tittle lub stringstation
 {
   // KRYTYCZNE: Blokuj gdy SDPlayer aktywny
-  if (sdPlayerOLEDActive) return;
+  if (player_state_screen_active()) return;
   
   // Jesli zmieniła sie dlugosc wyswietlanego stationString to wyczysc ekran OLED w miescach Scrollera
   if (stationStringScroll.length() != stationStringScrollLength) 
@@ -6102,7 +6092,7 @@ void volumeUp()
   volumeValue++;
 
   if (volumeValue > maxVolume) {volumeValue = maxVolume;}
-  audio.setVolume(volumeValue);  // zakres 0...21 lub 0...42
+  audio_cmd_volume(volumeValue);  // zakres 0...21 lub 0...42
   volumeDisplay();
 }
 
@@ -6117,7 +6107,7 @@ void volumeDown()
  
   volumeValue--;
   if (volumeValue < 1) {volumeValue = 1;}
-  audio.setVolume(volumeValue);  // zakres 0...21 lub 0...42
+  audio_cmd_volume(volumeValue);  // zakres 0...21 lub 0...42
   volumeDisplay();
 }
 
@@ -6135,12 +6125,13 @@ void clearFlags()
   bankNetworkUpdate = false;
   equalizerMenuEnable = false;
   rcInputDigitsMenuEnable = false;
+  stationSearchActive = false;
+  timeShiftActive = false;
   f_voiceTimeBlocked = false;
   if (f_displaySleepTime && f_sleepTimerOn) {f_displaySleepTimeSet = true;}
   f_displaySleepTime = false;
 
-  rcInputDigit1 = 0xFF; // czyscimy cyfre 1, flaga pustej zmiennej to FF
-  rcInputDigit2 = 0xFF; // czyscimy cyfre 2, flaga pustej zmiennej to FF
+  rcInputDigitCount = 0; // czyscimy wpisane cyfry
   station_nr = stationFromBuffer; // Przywracamy numer stacji z bufora
   bank_nr = previous_bank_nr;     // Przywracamy numer banku z bufora
 }
@@ -6160,7 +6151,8 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
 
     if (audio.isRunning() == true)
     {
-     sanitizeUtf8(stationStringWeb);
+     static char webBuf[TEXT_WEB_MAX];   // tylko zadanie AsyncTCP
+     sanitizeUtf8(stationStringWeb, webBuf, sizeof(webBuf));
      client->text("stationtext$" + stationStringWeb);
     }
     else
@@ -6198,7 +6190,7 @@ void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventTyp
         int newVolume = msg.substring(7).toInt();
         volumeValue = newVolume;
         volumeMute = false;
-        audio.setVolume(volumeValue);  // zakres 0...21 lub 0...42
+        audio_cmd_volume(volumeValue);  // zakres 0...21 lub 0...42
         volumeDisplay();   // wyswietle wartosci Volume na wyswietlaczu OLED
       }
       else if (msg.startsWith("station:")) 
@@ -6276,7 +6268,9 @@ void bufforAudioInfo()
   Serial.print("  Muzyka w buforze na: " + String(audioBufferTime) + " sek. " );
   Serial.print("  bitrate: " );
   Serial.print(audio.getBitRate());
-  Serial.print("  " );
+  Serial.print("  bufor: " );
+  Serial.print(buf_ctrl_get_applied_bytes() / 1024);
+  Serial.print(" kB  " );
   /*
   if (audioBufferTime >= 10) {Serial.println("##########");}
   if (audioBufferTime >= 9) {Serial.println("#########_");}
@@ -6440,7 +6434,7 @@ void displayEqualizer() // Funkcja rysująca menu 3-punktowego equalizera
   Serial.print("Wartość tonów Wysokich/High: ");
   Serial.println(toneHiValue);
     
-  audio.setTone(toneLowValue, toneMidValue, toneHiValue); // Zakres regulacji -40 + 6dB jako int8_t ze znakiem
+  audio_cmd_tone(toneLowValue, toneMidValue, toneHiValue); // Zakres regulacji -40 + 6dB jako int8_t ze znakiem
 
   u8g2.setDrawColor(1);
   u8g2.clearBuffer();
@@ -6567,15 +6561,6 @@ String chipSN = buf;
   
   u8g2.sendBuffer();
 }
-/*
-void audioProcessing(void *p)
-{
-  while (true) {
-  audio.loop();
-  vTaskDelay(1 / portTICK_PERIOD_MS); // Opóźnienie 1 milisekundy
-  }
-}
-*/
 
 
 //  OTA update callback dla Wifi Managera i trybu Recovery Mode
@@ -6659,6 +6644,7 @@ void recoveryModeCheck()
           u8g2.drawStr(1,28, "ESP will RESET in 3sec.       ");
           u8g2.sendBuffer();
           delay(3000);
+          sdio_flush();
           ESP.restart();
         }  
         else if (recoveryMode == 1)
@@ -6669,6 +6655,7 @@ void recoveryModeCheck()
           u8g2.sendBuffer();
           wifiManager.resetSettings();
           delay(3000);
+          sdio_flush();
           ESP.restart();
         }
       }
@@ -6873,6 +6860,200 @@ void displayDimmer(bool dimmerON)
 #endif
 
 
+// ---- Wyszukiwarka stacji na OLED (pilot T9 / enkoder) ---- //
+// Klawisze 2-9 jak w telefonie (multi-tap), 0 = spacja, 1 = cyfra 1
+// Góra/Dół lub enkoder - wybór wyniku, OK lub klik enkodera - odtwarzanie, Back - kasowanie znaku / wyjście
+const char* const stationSearchT9[10] = {" 0", "1", "abc2", "def3", "ghi4", "jkl5", "mno6", "pqrs7", "tuv8", "wxyz9"};
+
+void stationSearchDisplay()
+{
+  displayActive = true;
+  timeDisplay = false;
+  displayStartTime = millis();
+
+  u8g2.clearBuffer();
+  u8g2.setFont(spleen6x12PL);
+  u8g2.drawStr(0, 10, "Szukaj:");
+  u8g2.drawStr(48, 10, stationSearchQuery);
+  u8g2.drawStr(48 + strlen(stationSearchQuery) * 6, 10, "_");
+
+  String stats = String(stationSearchResultCount) + "/" + String(station_search_get_entry_count());
+  u8g2.drawStr(256 - stats.length() * 6, 10, stats.c_str());
+  u8g2.drawHLine(0, 13, 256);
+
+  if (stationSearchResultCount == 0)
+  {
+    u8g2.drawStr(0, 36, strlen(stationSearchQuery) ? "Brak wynikow" : "Wpisz nazwe stacji klawiszami 0-9");
+    u8g2.sendBuffer();
+    return;
+  }
+
+  // Okno 4 wyników przewijane razem z zaznaczeniem
+  uint8_t first = (stationSearchSelection > 3) ? stationSearchSelection - 3 : 0;
+  for (uint8_t i = 0; i < 4 && first + i < stationSearchResultCount; i++)
+  {
+    const search_result_t &r = stationSearchResults[first + i];
+    int y = 25 + i * 12;
+    char prefix[10];
+    snprintf(prefix, sizeof(prefix), "%02u-%02u", r.bank, r.station);
+    String name = String(r.name);
+    char nameBuf[sizeof(r.name)];   // wyjście OLED nie dłuższe niż nazwa
+    processText(name, nameBuf, sizeof(nameBuf));
+
+    if (first + i == stationSearchSelection)
+    {
+      u8g2.drawBox(0, y - 10, 256, 12);
+      u8g2.setDrawColor(0);
+    }
+    u8g2.drawStr(2, y, prefix);
+    u8g2.drawStr(38, y, name.c_str());
+    u8g2.setDrawColor(1);
+  }
+  u8g2.sendBuffer();
+}
+
+void stationSearchRun()
+{
+  stationSearchResultCount = station_search_query(stationSearchQuery, stationSearchResults, STATION_SEARCH_OLED_RESULTS);
+  stationSearchSelection = 0;
+  Serial.printf("debug search -> \"%s\" wyników: %u czas: %u us\n", stationSearchQuery, stationSearchResultCount, (unsigned)station_search_get_last_query_us());
+  stationSearchDisplay();
+}
+
+void stationSearchEnter()
+{
+  Serial.println("debug search -> Wyszukiwarka stacji aktywna");
+  stationSearchActive = true;
+  stationSearchQuery[0] = '\0';
+  stationSearchResultCount = 0;
+  stationSearchSelection = 0;
+  stationSearchLastKey = 0xFF;
+  stationSearchDisplay();
+}
+
+void stationSearchExit()
+{
+  stationSearchActive = false;
+  clearFlags();
+  displayRadio();
+  u8g2.sendBuffer();
+}
+
+void stationSearchKey(uint8_t key)
+{
+  const char* letters = stationSearchT9[key];
+  size_t len = strlen(stationSearchQuery);
+
+  if (key == stationSearchLastKey && len > 0 && (millis() - stationSearchLastKeyTime < stationSearchTapTimeout))
+  {
+    // Multi-tap - podmieniamy ostatni znak na kolejny z tego samego klawisza
+    stationSearchTapIndex = (stationSearchTapIndex + 1) % strlen(letters);
+    stationSearchQuery[len - 1] = letters[stationSearchTapIndex];
+  }
+  else if (len < SEARCH_QUERY_LENGTH)
+  {
+    stationSearchTapIndex = 0;
+    stationSearchQuery[len] = letters[0];
+    stationSearchQuery[len + 1] = '\0';
+  }
+  stationSearchLastKey = key;
+  stationSearchLastKeyTime = millis();
+  stationSearchRun();
+}
+
+void stationSearchBackspace()
+{
+  size_t len = strlen(stationSearchQuery);
+  if (len == 0) { stationSearchExit(); return; }
+  stationSearchQuery[len - 1] = '\0';
+  stationSearchLastKey = 0xFF;
+  stationSearchRun();
+}
+
+void stationSearchMove(int8_t dir)
+{
+  if (stationSearchResultCount == 0) { stationSearchDisplay(); return; }
+  if (dir < 0) { stationSearchSelection = (stationSearchSelection == 0) ? stationSearchResultCount - 1 : stationSearchSelection - 1; }
+  else { stationSearchSelection = (stationSearchSelection + 1) % stationSearchResultCount; }
+  stationSearchDisplay();
+}
+
+void stationSearchPlay()
+{
+  if (stationSearchResultCount == 0) { stationSearchDisplay(); return; }
+  const search_result_t r = stationSearchResults[stationSearchSelection];
+  Serial.printf("debug search -> Odtwarzam bank %u stacja %u: %s\n", r.bank, r.station, r.name);
+
+  stationSearchActive = false;
+  urlPlaying = false;
+  if (r.bank != previous_bank_nr)
+  {
+    bank_nr = r.bank;
+    fetchStationsFromServer(); // Ładujemy bank wyniku z karty lub serwera
+  }
+  bank_nr = r.bank;
+  station_nr = r.station;
+  stationFromBuffer = station_nr;
+
+  clearFlags();
+  changeStation();
+  displayRadio();
+  u8g2.sendBuffer();
+}
+
+// ===================== TIMESHIFT - EKRAN STEROWANIA =====================
+// Combo 555 na pilocie: OK - pauza/wznowienie, Lewo/Prawo - 10 s wstecz/naprzód,
+// Dół - 30 s wstecz, Góra - powrót "na żywo", Back - wyjście (opóźnienie zostaje)
+
+void timeShiftDisplay()
+{
+  timeshift_status_t ts;
+  timeshift_get_status(&ts);
+
+  displayActive = true;
+  timeDisplay = false;
+
+  char line[40];
+  u8g2.clearBuffer();
+  u8g2.setFont(u8g2_font_fub14_tf);
+  u8g2.drawStr(0, 16, ts.paused ? "PAUZA" : (ts.delayMs ? "TIMESHIFT" : "NA ZYWO"));
+
+  uint32_t delaySec = ts.delayMs / 1000;
+  snprintf(line, sizeof(line), "-%02u:%02u", (unsigned)(delaySec / 60), (unsigned)(delaySec % 60));
+  u8g2.drawStr(256 - u8g2.getStrWidth(line), 16, line);
+
+  // Pasek: cały bufor, wypełnienie = dostępna historia, znacznik = pozycja odtwarzania
+  u8g2.drawFrame(0, 26, 256, 10);
+  if (ts.capacityMs)
+  {
+    uint16_t filled = (uint64_t)ts.bufferedMs * 254 / ts.capacityMs;
+    uint16_t pos = (ts.delayMs > ts.bufferedMs) ? 0 : (uint64_t)(ts.bufferedMs - ts.delayMs) * 254 / ts.capacityMs;
+    u8g2.drawBox(255 - filled, 28, filled, 6);
+    u8g2.setDrawColor(0);
+    u8g2.drawBox(255 - filled + pos, 27, 2, 8);
+    u8g2.setDrawColor(1);
+  }
+
+  u8g2.setFont(spleen6x12PL);
+  snprintf(line, sizeof(line), "Bufor %us / %us", (unsigned)(ts.bufferedMs / 1000), (unsigned)(ts.capacityMs / 1000));
+  u8g2.drawStr(0, 49, line);
+  u8g2.drawStr(0, 62, "OK:pauza  <>:10s  v:-30s  ^:na zywo");
+  u8g2.sendBuffer();
+}
+
+void timeShiftEnter()
+{
+  if (!timeshift_is_enabled())
+  {
+    Serial.println("debug timeshift -> Wyłączony w konfiguracji");
+    return;
+  }
+  Serial.println("debug timeshift -> Ekran sterowania aktywny");
+  timeShiftActive = true;
+  displayStartTime = millis();
+  timeShiftDisplay();
+}
+
 void handleEncoder2StationsVolumeClick()
 {
   // =============== OBSŁUGA ENKODERA DLA ZINTEGROWANYCH MODUŁÓW ===============
@@ -6921,6 +7102,17 @@ void handleEncoder2StationsVolumeClick()
     
     return; // Wyjdź z funkcji - SDPlayer obsłużony
   }
+
+  // 2. Wyszukiwarka stacji - obrót wybiera wynik, kliknięcie odtwarza
+  if (stationSearchActive) {
+    CLK_state2 = digitalRead(CLK_PIN2);
+    if (CLK_state2 != prev_CLK_state2 && CLK_state2 == HIGH) {
+      stationSearchMove((digitalRead(DT_PIN2) == HIGH) ? -1 : 1);
+    }
+    prev_CLK_state2 = CLK_state2;
+    if (button2.isPressed()) { stationSearchPlay(); }
+    return;
+  }
   
   // ============== KONIEC OBSŁUGI MODUŁÓW - kontynuacja normalnej obsługi radia ==============
   
@@ -6939,8 +7131,7 @@ void handleEncoder2StationsVolumeClick()
       {  
         if (listedStations == true)
         {
-          station_nr--;
-          if (station_nr < 1) {station_nr = stationsCount;} //1;
+          if (station_nr <= 1 || station_nr > stationsCount) {station_nr = stationsCount;} else {station_nr--;} // bez przekręcenia uint16_t
           Serial.print("Numer stacji do tyłu: "); Serial.println(station_nr);
           
           scrollUp();
@@ -7075,7 +7266,7 @@ void handleEncoder2VolumeStationsClick()
   static unsigned long lastEncoderClickTime = 0;
   
   // Sprawdź triple-click tylko gdy SD Player nieaktywny
-  if (!sdPlayerOLEDActive) {
+  if (!player_state_screen_active()) {
     bool isPressed = (digitalRead(SW_PIN2) == LOW);
     static bool lastPressState = false;
     
@@ -7092,8 +7283,7 @@ void handleEncoder2VolumeStationsClick()
       if (encoderClickCount >= 3) {
         // Triple-click wykryty - aktywuj SD Player
         if (g_sdPlayerOLED) {
-          g_sdPlayerOLED->activate();
-          sdPlayerOLEDActive = true;  // KRYTYCZNE: Ustaw flagę aby zablokować radio display
+          g_sdPlayerOLED->activate();  // blokuje radio display (PlayerState)
         }
         encoderClickCount = 0; // Reset
       }
@@ -7145,6 +7335,17 @@ void handleEncoder2VolumeStationsClick()
     
     return; // Wyjdź z funkcji - SDPlayer obsłużony
   }
+
+  // Obsługa wyszukiwarki stacji - obrót wybiera wynik, kliknięcie odtwarza
+  if (stationSearchActive) {
+    CLK_state2 = digitalRead(CLK_PIN2);
+    if (CLK_state2 != prev_CLK_state2 && CLK_state2 == HIGH) {
+      stationSearchMove((digitalRead(DT_PIN2) == HIGH) ? -1 : 1);
+    }
+    prev_CLK_state2 = CLK_state2;
+    if (button2.isPressed()) { stationSearchPlay(); }
+    return;
+  }
   
   // ============== KONIEC OBSŁUGI MODUŁÓW - kontynuacja normalnej obsługi radia ==============
   
@@ -7237,11 +7438,11 @@ void handleEncoder2VolumeStationsClick()
       volumeMute = !volumeMute;
       if (volumeMute == true)
       {
-        audio.setVolume(0);   
+        audio_cmd_volume(0);   
       }
       else if (volumeMute == false)
       {
-        audio.setVolume(volumeValue);   
+        audio_cmd_volume(volumeValue);   
       }
       displayRadio();
       return;
@@ -7349,6 +7550,13 @@ void saveConfig()
       myFile.println("Analyzer FFT Enabled =" + String(analyzerEnabled) + ";");
       myFile.println("Analyzer Styles =" + String(analyzerStyles) + ";");
       myFile.println("Analyzer Preset =" + String(analyzerPreset) + ";");
+      myFile.println("Warm Neighbour Stations =" + String(f_warmNeighbours) + ";");
+      myFile.println("Live Timeshift =" + String(f_timeShift) + ";");
+      myFile.println("Audio Task =" + String(f_audioTask) + ";");
+      myFile.println("Title History Log =" + String(f_titleLog) + ";");
+      myFile.println("SD Player Gapless =" + String(f_sdGapless) + ";");
+      myFile.println("SD Player Crossfade =" + String(sdCrossfadeSec) + ";");
+      myFile.println("SD Player ReplayGain =" + String(sdReplayGain) + ";");
       
 
       myFile.close();
@@ -7397,6 +7605,13 @@ void saveConfig()
       myFile.println("Analyzer FFT Enabled =" + String(analyzerEnabled) + ";");
       myFile.println("Analyzer Styles =" + String(analyzerStyles) + ";");
       myFile.println("Analyzer Preset =" + String(analyzerPreset) + ";");
+      myFile.println("Warm Neighbour Stations =" + String(f_warmNeighbours) + ";");
+      myFile.println("Live Timeshift =" + String(f_timeShift) + ";");
+      myFile.println("Audio Task =" + String(f_audioTask) + ";");
+      myFile.println("Title History Log =" + String(f_titleLog) + ";");
+      myFile.println("SD Player Gapless =" + String(f_sdGapless) + ";");
+      myFile.println("SD Player Crossfade =" + String(sdCrossfadeSec) + ";");
+      myFile.println("SD Player ReplayGain =" + String(sdReplayGain) + ";");
       myFile.close();
       Serial.println("Utworzono i zapisano config.txt na karcie SD");
     } 
@@ -7569,6 +7784,21 @@ void readConfig()
   analyzerEnabled = configArray[26];
   analyzerStyles = configArray[27];
   analyzerPreset = configArray[28];
+  f_warmNeighbours = configArray[29];
+  warm_set_enabled(f_warmNeighbours);
+  f_timeShift = configArray[30];
+  if (f_timeShift) {f_timeShift = timeshift_enable();} else {timeshift_disable();}
+  f_audioTask = configArray[31];
+  audio_task_set_mode(f_audioTask); // Przełączenie w najbliższym obiegu loop()
+  f_titleLog = configArray[32];
+  history_set_log(f_titleLog && useSD); // Dziennik tylko na karcie SD
+  f_sdGapless = configArray[33];
+  sdCrossfadeSec = configArray[34];
+  if (sdCrossfadeSec > XFADE_MAX_SEC) {sdCrossfadeSec = XFADE_MAX_SEC;}
+  xfade_set(f_sdGapless, sdCrossfadeSec);
+  sdReplayGain = configArray[35];
+  if (sdReplayGain > RGAIN_MODE_ALBUM) {sdReplayGain = RGAIN_MODE_OFF;}
+  rgain_set_mode(sdReplayGain);
 
   if (maxVolumeExt == 1)
   { 
@@ -7578,7 +7808,7 @@ void readConfig()
   {
     maxVolume = 21;
   }
-  audio.setVolumeSteps(maxVolume);
+  audio_cmd_volume_steps(maxVolume);
   //stationNameSwap();
 }
 
@@ -7665,12 +7895,7 @@ void readPSRAMstations()  // Funkcja testowa-debug, do odczytu PSRAMu, nie uzywa
     // Odczyt stacji pod daną komórka pamieci PSRAM:
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
     memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-    int length = psramData[(i) * (STATION_NAME_LENGTH + 1)];   // Odczytaj długość nazwy stacji z PSRAM dla bieżącego indeksu stacji
-      
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-    { // Odczytaj nazwę stacji z PSRAM jako ciąg bajtów, maksymalnie do STATION_NAME_LENGTH
-        station[j] = psramData[(i) * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }
+    station_store_get(i, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
     String stationNameText = String(station);
     
     Serial.print(i+1);
@@ -7685,12 +7910,7 @@ void readPSRAMstations()  // Funkcja testowa-debug, do odczytu PSRAMu, nie uzywa
   // Odczyt stacji pod daną komórka pamieci PSRAM:
   char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
   memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-  int length = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1)];   // Odczytaj długość nazwy stacji z PSRAM dla bieżącego indeksu stacji
-      
-  for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-  { // Odczytaj nazwę stacji z PSRAM jako ciąg bajtów, maksymalnie do STATION_NAME_LENGTH
-    station[j] = psramData[(station_nr - 1) * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-  }
+  station_store_get(station_nr - 1, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
   
   //String stationNameText = String(station);
   
@@ -7703,10 +7923,11 @@ void readPSRAMstations()  // Funkcja testowa-debug, do odczytu PSRAMu, nie uzywa
 
 void webUrlStationPlay() 
 {
-  audio.stopSong();
+  audio_cmd_stop();
 
   // Usunięcie wszystkich znaków z obiektów 
   stationString.remove(0);  
+  stationStringUtf8.remove(0);
   stationNameStream.remove(0);
   stationStringWeb.remove(0);
   stationLogoUrl.remove(0);
@@ -7728,6 +7949,8 @@ void webUrlStationPlay()
 
   mp3 = flac = aac = vorbis = opus = false;
   streamCodec = "";
+  stream_info_reset(&streamInfo);
+  timeshift_reset();
     
   Serial.println("debug-- Read station from WEB URL");
     
@@ -7758,7 +7981,15 @@ void webUrlStationPlay()
     u8g2.sendBuffer();
     
     // Połącz z daną stacją
-    audio.connecttohost(url2play.c_str());
+    uint32_t inBufferSize = buf_ctrl_begin(url2play.c_str(), nullptr); // Rozmiar bufora z historii adresu
+
+    warm_switch_begin(url2play.c_str());
+    net_connect_begin(url2play.c_str());
+    health_begin(url2play.c_str());
+    bool connected = audio_cmd_connect(url2play.c_str(), inBufferSize);
+    net_connect_end(connected);
+    warm_switch_end(connected);
+    health_connect_result(connected);
     urlPlaying = true;
     station_nr = 0;
     bank_nr = 0;
@@ -7778,9 +8009,31 @@ void webUrlStationPlay()
   //url2play = "";
 }
 
-String stationBankListHtmlMobile()
+// Pasek stron listy stacji - duże banki renderujemy stronami po webStationsPageSize stacji
+String stationPageNavHtml(uint16_t page, uint16_t pages)
+{
+  if (pages <= 1) { return ""; }
+
+  String nav = "<p>";
+  for (uint16_t p = 1; p <= pages; p++)
+  {
+    uint16_t first = (p - 1) * webStationsPageSize + 1;
+    uint16_t last = min((int)(p * webStationsPageSize), stationsCount);
+    if (p == page) { nav += "<b>[" + String(first) + "-" + String(last) + "]</b> "; }
+    else { nav += "<a href='/?page=" + String(p) + "'>" + String(first) + "-" + String(last) + "</a> "; }
+  }
+  nav += "</p>" + String("\n");
+  return nav;
+}
+
+String stationBankListHtmlMobile(uint16_t page)
 {
   String html1;
+  uint16_t pages = (stationsCount + webStationsPageSize - 1) / webStationsPageSize;
+  if (page < 1) { page = 1; }
+  if (pages > 0 && page > pages) { page = pages; }
+  int firstStation = (page - 1) * webStationsPageSize;
+  int lastStation = min(firstStation + (int)webStationsPageSize, stationsCount);
   
   html1 += "<p>Volume: <span id='textSliderValue'>--</span></p>" + String("\n");
   html1 += "<p><input type='range' onchange='updateSliderVolume(this)' id='volumeSlider' min='1' max='" + String(maxVolume) + "' value='1' step='1' class='slider'></p>" + String("\n");
@@ -7788,46 +8041,33 @@ String stationBankListHtmlMobile()
 
   html1 += "<center>";  
   html1 += "<p>";
-  //for (int i = 1; i < 17; i++) // Przyciski Banków
   for (int i = 1; i < bank_nr_max + 1; i++) // Przyciski Banków
   {
-    
-    if (i == bank_nr)
-    {
-      html1 += "<button class='buttonBankSelected' onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
-    }
-    else
-    {
-      html1 += "<button class=\"buttonBank\" onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
-    }
-    //if (i == 8) {html1 += "</p><p>";}
+    String cssClass = (i == bank_nr) ? "buttonBankSelected" : "buttonBank";
+    html1 += "<button class='" + cssClass + "' title='" + String(bank_registry_name(i)) + "' onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
     if (i % 8 == 0) {html1 += "</p><p>";}
   }
   html1 += "</p>";
+  html1 += "<p>" + String(bank_registry_name(bank_nr)) + "</p>";
+  html1 += stationPageNavHtml(page, pages);
   html1 += "</center>";
   html1 += "<center>"; 
  
   html1 += "<table>";
 
-
-  for (int i = 0; i < stationsCount; i++) // lista stacji
+  for (int i = firstStation; i < lastStation; i++) // lista stacji - tylko bieżąca strona
   {
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
-    memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-    int length = psramData[i * (STATION_NAME_LENGTH + 1)];
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-    {
-      station[j] = psramData[i * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }
+    station_store_get(i, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
     
     html1 += "<tr>";
     html1 += "<td><p class='stationNumberList'>" + String(i + 1) + "</p></td>";
     html1 += "<td><p class='stationList' onClick=\"changeStation('" + String(i + 1) +  "');\">" + String(station).substring(0, stationNameLenghtCut) + "</p></td>";
     html1 += "</tr>" + String("\n");
-          
   }
  
   html1 += "</table>" + String("\n");
+  html1 += stationPageNavHtml(page, pages);
   html1 += "</div>" + String("\n");
 
   html1 += "<p style=\"font-size: 0.8rem;\">Web Radio, mobile, Evo: " + String(softwareRev) + "</p>" + String("\n");
@@ -7839,69 +8079,56 @@ String stationBankListHtmlMobile()
   return html1;
 }
 
-String stationBankListHtmlPC()
+String stationBankListHtmlPC(uint16_t page)
 {
   String html2;
-  
+  uint16_t pages = (stationsCount + webStationsPageSize - 1) / webStationsPageSize;
+  if (page < 1) { page = 1; }
+  if (pages > 0 && page > pages) { page = pages; }
+  int firstStation = (page - 1) * webStationsPageSize;
+  const int columnRows = webStationsPageSize / 4; // 4 kolumny tabel na stronie
 
   html2 += "<p>Volume: <span id='textSliderValue'>--</span></p>" + String("\n");
   html2 += "<p><input type='range' onchange='updateSliderVolume(this)' id='volumeSlider' min='1' max='" + String(maxVolume) + "' value='1' step='1' class='slider'></p>" + String("\n");
   html2 += "<p>Memory Bank Selection:</p>" + String("\n");
   
-  
   html2 += "<p>";
-  //for (int i = 1; i < 17; i++)
   for (int i = 1; i < bank_nr_max + 1; i++) // Przyciski Banków
   {
-    
-    if (i == bank_nr)
-    {
-      html2 += "<button class=\"buttonBankSelected\" onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
-    }
-    else
-    {
-      html2 += "<button class=\"buttonBank\" onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
-    }
+    String cssClass = (i == bank_nr) ? "buttonBankSelected" : "buttonBank";
+    html2 += "<button class=\"" + cssClass + "\" title=\"" + String(bank_registry_name(i)) + "\" onClick=\"changeBank('" + String(i) + "');\" id=\"Bank\">" + String(i) + "</button>" + String("\n");
   }
-  
   html2 += "</p>";
+  html2 += "<p>" + String(bank_registry_name(bank_nr)) + "</p>";
+  
   html2 += "<center>" + String("\n");
+  html2 += stationPageNavHtml(page, pages);
   html2 += "<div class=\"column\">" + String("\n");
-  for (int i = 0; i < MAX_STATIONS; i++) 
-  //for (int i = 0; i < stationsCount; i++) 
+  for (int row = 0; row < (int)webStationsPageSize; row++) // pełna strona, brakujące stacje jako puste komórki
   {
+    int i = firstStation + row;
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
-    memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
-
-    int length = psramData[i * (STATION_NAME_LENGTH + 1)];
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-    {
-      station[j] = psramData[i * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }     
+    station_store_get(i, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM, pusta gdy i >= stationsCount
 
-    
-    if ((i == 0) || (i == 25) || (i == 50) || (i == 75))
+    if (row % columnRows == 0)
     { 
       html2 += "<table>" + String("\n");
     } 
-    
-    // 0-98   >98
-    if (i >= stationsCount) { station[0] ='\0'; } // Jesli mamy mniej niz 99 stacji to wypełniamy pozostałe komórki pustymi wartościami
                  
     html2 += "<tr>";
     html2 += "<td><p class='stationNumberList'>" + String(i + 1) + "</p></td>";
     html2 += "<td><p class='stationList' onClick=\"changeStation('" + String(i + 1) +  "');\">" + String(station).substring(0, stationNameLenghtCut) + "</p></td>";
     html2 += "</tr>" + String("\n");
 
-    if ((i == 24) || (i == 49) || (i == 74)) //||(i == 98))
+    if ((row % columnRows == columnRows - 1) && (row != (int)webStationsPageSize - 1))
     { 
       html2 += "</table>" + String("\n");
     }
-           
   }
 
   html2 += "</table>" + String("\n");
   html2 += "</div>" + String("\n");
+  html2 += stationPageNavHtml(page, pages);
   html2 += "<p style=\"font-size: 0.8rem;\">Web Radio, desktop, Evo: " + String(softwareRev) + "</p>" + String("\n");
   html2 += "<p style='font-size: 0.8rem;'>IP: " + currentIP + "</p>" + String("\n");
   html2 += "<a href='/menu' class='button' style='padding: 0.2rem; font-size: 0.7rem; height: auto; line-height: 1;color: white; width: 65px; border: 1px solid black; display: inline-block; border-radius: 5px; text-decoration: none;'>Menu</a>";
@@ -7957,11 +8184,7 @@ String stationBankListHtml(bool mobilePage)
     char station[STATION_NAME_LENGTH + 1];  // Tablica na nazwę stacji o maksymalnej długości zdefiniowanej przez STATION_NAME_LENGTH
     memset(station, 0, sizeof(station));    // Wyczyszczenie tablicy zerami przed zapisaniem danych
 
-    int length = psramData[i * (STATION_NAME_LENGTH + 1)];
-    for (int j = 0; j < min(length, STATION_NAME_LENGTH); j++) 
-    {
-      station[j] = psramData[i * (STATION_NAME_LENGTH + 1) + 1 + j];  // Odczytaj znak po znaku nazwę stacji
-    }     
+    station_store_get(i, station, sizeof(station));  // Odczytaj linię stacji z listy w PSRAM
 
     
     if ((mobilePage == 0) && ((i == 0) || (i == 25) || (i == 50) || (i == 75)))
@@ -8021,7 +8244,9 @@ void voiceTime()
   Serial.print("debug voice time PL -> ");
   Serial.println(chbuf);
   
-  audio.connecttospeech(chbuf, "pl");
+  if (useSD && voice_play("pl", h, timeinfo.tm_min)) { return; } // Fragmenty z karty SD, bez usługi TTS
+  voice_begin(false);
+  audio_cmd_speech(chbuf, "pl");
 }
 
 void voiceTimeEn()
@@ -8042,12 +8267,14 @@ void voiceTimeEn()
   snprintf(timeString, sizeof(timeString), "%02d:%02d:%02d", timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
   time_s = String(timeString);
   int h = time_s.substring(0,2).toInt();
+  if (useSD && voice_play("en", h, timeinfo.tm_min)) { return; } // Fragmenty z karty SD, bez usługi TTS
   if(h > 12){h -= 12; strcpy(am_pm,"pm.");}
   //snprintf(chbuf, sizeof (chbuf), "Jest godzina %i:%02i", h, time_s.substring(3,5).toInt());
   sprintf(chbuf, "It is now %i%s and %i minutes", h, am_pm, time_s.substring(3,5).toInt());
   Serial.print("debug voice time EN -> ");
   Serial.println(chbuf);
-  audio.connecttospeech(chbuf, "en");
+  voice_begin(false);
+  audio_cmd_speech(chbuf, "en");
 }
 
 
@@ -8520,12 +8747,14 @@ void powerOff()
   // ---- ZAMYKAMY CALY OBIEKT AUDIO ----
   ws.closeAll();
   if (!volumeMute && f_volumeFadeOn) {volumeFadeOut(volumeSleepFadeOutTime);}
-  audio.setVolume(0);
-  audio.stopSong();
+  audio_cmd_volume(0);
+  audio_cmd_stop();
+  history_flush(); // Zaległa paczka dziennika tytułów
   delay(1000);
   
   // ---- ZAPIS OSTATNIEGO NR.STACJI, NR.BANKU, POZIOMU VOLUME jesli funkcja saveAlwasy wylaczona ----
   if (!f_saveVolumeStationAlways) {saveVolumeOnSD(); saveStationOnSD();}
+  sdio_flush(); // Zapisy odłożone przez harmonogram SD muszą trafić na kartę przed uśpieniem
   
   
   // ---- ANIMACJA POWER OFF, jesli wlaczona ----
@@ -8735,9 +8964,10 @@ void startOta()
   fwupd = true;
   
   ws.closeAll();
-  audio.stopSong();
+  audio_cmd_stop();
   delay(250);
   if (!f_saveVolumeStationAlways){saveStationOnSD(); saveVolumeOnSD();}
+  sdio_flush(); // Zapisy odłożone - przed aktualizacją i restartem
   
   for (int i = 0; i < 3; i++) 
   {
@@ -8796,8 +9026,8 @@ void handleRemote()
       
       // DEBUG: Sprawdź stan SDPlayera
       if (g_sdPlayerOLED) {
-        Serial.printf("DEBUG IR: SDPlayer ptr=%p active=%d sdPlayerOLEDActive=%d\n", 
-                     g_sdPlayerOLED, g_sdPlayerOLED->isActive(), sdPlayerOLEDActive);
+        Serial.printf("DEBUG IR: SDPlayer ptr=%p active=%d screen=%d\n", 
+                     g_sdPlayerOLED, g_sdPlayerOLED->isActive(), player_state_screen_active());
       }
       
       // ===== SDPLAYER PILOT ROUTING (PRIORITY) =====
@@ -8841,9 +9071,7 @@ void handleRemote()
             backClickCount = 0; // Reset
             
             g_sdPlayerOLED->deactivate();
-            sdPlayerOLEDActive = false;
-            sdPlayerPlayingMusic = false;
-            audio.stopSong();
+            if (g_sdPlayerWeb) g_sdPlayerWeb->stop(); else audio_cmd_stop();
             
             // WAŻNE: Wyczyść bufor przed przełączeniem na radio
             u8g2.clearBuffer();
@@ -8864,9 +9092,7 @@ void handleRemote()
           // Key0 - wyjście z SDPlayera do radia
           Serial.println("DEBUG: Exiting SDPlayer to radio Bank 1, Station 4");
           g_sdPlayerOLED->deactivate();
-          sdPlayerOLEDActive = false;
-          sdPlayerPlayingMusic = false;
-          audio.stopSong();
+          if (g_sdPlayerWeb) g_sdPlayerWeb->stop(); else audio_cmd_stop();
           
           // WAŻNE: Wyczyść bufor przed przełączeniem na radio
           u8g2.clearBuffer();
@@ -8905,20 +9131,65 @@ void handleRemote()
         }
       }
       // ===== KONIEC SDPLAYER ROUTING =====
+
+      // ===== WYSZUKIWARKA STACJI - ROUTING PILOTA =====
+      if (stationSearchActive) {
+        if (ir_code == rcCmdArrowUp) { stationSearchMove(-1); }
+        else if (ir_code == rcCmdArrowDown) { stationSearchMove(1); }
+        else if (ir_code == rcCmdOk) { stationSearchPlay(); }
+        else if (ir_code == rcCmdBack) { stationSearchBackspace(); }
+        else if (ir_code == rcCmdVolumeUp) { volumeUp(); }
+        else if (ir_code == rcCmdVolumeDown) { volumeDown(); }
+        else if (ir_code == rcCmdKey0) { stationSearchKey(0); }
+        else if (ir_code == rcCmdKey1) { stationSearchKey(1); }
+        else if (ir_code == rcCmdKey2) { stationSearchKey(2); }
+        else if (ir_code == rcCmdKey3) { stationSearchKey(3); }
+        else if (ir_code == rcCmdKey4) { stationSearchKey(4); }
+        else if (ir_code == rcCmdKey5) { stationSearchKey(5); }
+        else if (ir_code == rcCmdKey6) { stationSearchKey(6); }
+        else if (ir_code == rcCmdKey7) { stationSearchKey(7); }
+        else if (ir_code == rcCmdKey8) { stationSearchKey(8); }
+        else if (ir_code == rcCmdKey9) { stationSearchKey(9); }
+
+        if (stationSearchActive && (ir_code == rcCmdVolumeUp || ir_code == rcCmdVolumeDown)) { stationSearchDisplay(); }
+        lastIrCode = 0; // Cyfry w wyszukiwarce nie mogą uruchamiać combo 999/111/333
+        ir_code = 0;
+        bit_count = 0;
+        attachInterrupt(digitalPinToInterrupt(recv_pin), pulseISR, CHANGE);
+        return;
+      }
+
+      // ===== TIMESHIFT - ROUTING PILOTA =====
+      if (timeShiftActive) {
+        if (ir_code == rcCmdOk) { timeshift_toggle_pause(); }
+        else if (ir_code == rcCmdArrowLeft) { timeshift_skip(-TS_SKIP_SHORT_SEC); }
+        else if (ir_code == rcCmdArrowRight) { timeshift_skip(TS_SKIP_SHORT_SEC); }
+        else if (ir_code == rcCmdArrowDown) { timeshift_skip(-TS_SKIP_LONG_SEC); }
+        else if (ir_code == rcCmdArrowUp) { timeshift_go_live(); }
+        else if (ir_code == rcCmdVolumeUp) { volumeUp(); }
+        else if (ir_code == rcCmdVolumeDown) { volumeDown(); }
+        else if (ir_code == rcCmdBack) { displayStartTime = 0; } // Wyjście przy najbliższym sprawdzeniu timeoutu w loop()
+
+        if (ir_code != rcCmdBack && ir_code != rcCmdVolumeUp && ir_code != rcCmdVolumeDown) { displayStartTime = millis(); }
+        if (ir_code != rcCmdBack) { timeShiftDisplay(); }
+        lastIrCode = 0;
+        ir_code = 0;
+        bit_count = 0;
+        attachInterrupt(digitalPinToInterrupt(recv_pin), pulseISR, CHANGE);
+        return;
+      }
       
       // 2. Specjalne kody do uruchamiania modułów
       // Kod 999 - aktywacja SDPlayer (combo na pilocie)
-      if (ir_code == 0x999 || (ir_code == rcCmdKey9 && lastIrCode == rcCmdKey9)) {
+      if (ir_code == 0x999 || irComboPressed(rcCmdKey9)) {
         Serial.println("DEBUG: Activating SD Player (combo 999)");
         
         // KRYTYCZNE: Wyzeruj flagi rcInput aby nie wywołać changeStation()
         rcInputDigitsMenuEnable = false;
-        rcInputDigit1 = 0xFF;
-        rcInputDigit2 = 0xFF;
+        rcInputDigitCount = 0;
         
         if (g_sdPlayerOLED) {
-          g_sdPlayerOLED->activate();
-          sdPlayerOLEDActive = true;  // KRYTYCZNE: Ustaw flagę aby zablokować radio display
+          g_sdPlayerOLED->activate();  // blokuje radio display (PlayerState)
         }
         ir_code = 0;
         bit_count = 0;
@@ -8926,8 +9197,70 @@ void handleRemote()
         return;
       }
       
+      // Kod 333 - wyszukiwarka stacji (combo na pilocie)
+      if (ir_code == 0x333 || irComboPressed(rcCmdKey3)) {
+        Serial.println("DEBUG: Station search (combo 333)");
+
+        // KRYTYCZNE: Wyzeruj flagi rcInput aby nie wywołać changeStation()
+        rcInputDigitsMenuEnable = false;
+        rcInputDigitCount = 0;
+        station_nr = stationFromBuffer;
+
+        stationSearchEnter();
+        lastIrCode = 0;
+        ir_code = 0;
+        bit_count = 0;
+        attachInterrupt(digitalPinToInterrupt(recv_pin), pulseISR, CHANGE);
+        return;
+      }
+
+      // Kod 555 - sterowanie timeshift (combo na pilocie)
+      if (ir_code == 0x555 || irComboPressed(rcCmdKey5)) {
+        Serial.println("DEBUG: Timeshift (combo 555)");
+
+        // KRYTYCZNE: Wyzeruj flagi rcInput aby nie wywołać changeStation()
+        rcInputDigitsMenuEnable = false;
+        rcInputDigitCount = 0;
+        station_nr = stationFromBuffer;
+
+        timeShiftEnter();
+        lastIrCode = 0;
+        ir_code = 0;
+        bit_count = 0;
+        attachInterrupt(digitalPinToInterrupt(recv_pin), pulseISR, CHANGE);
+        return;
+      }
+
+      // Kod 777 - start / stop nagrywania stacji na SD (combo na pilocie)
+      if (ir_code == 0x777 || irComboPressed(rcCmdKey7)) {
+        Serial.println("DEBUG: Stream recording (combo 777)");
+
+        // KRYTYCZNE: Wyzeruj flagi rcInput aby nie wywołać changeStation()
+        rcInputDigitsMenuEnable = false;
+        rcInputDigitCount = 0;
+        station_nr = stationFromBuffer;
+
+        bool wasRecording = rec_is_active();
+        bool started = false;
+        if (wasRecording) {rec_stop();} else {started = recordingStart(0);}
+
+        displayActive = true;
+        timeDisplay = false;
+        displayStartTime = millis();
+        u8g2.clearBuffer();
+        u8g2.setFont(u8g2_font_fub14_tf);
+        u8g2.drawStr(60, 33, wasRecording ? "REC STOP" : (started ? "REC START" : "REC ERROR"));
+        u8g2.sendBuffer();
+
+        lastIrCode = 0;
+        ir_code = 0;
+        bit_count = 0;
+        attachInterrupt(digitalPinToInterrupt(recv_pin), pulseISR, CHANGE);
+        return;
+      }
+
       // Kod 111 - toggle menu Analyzer Settings
-      if (ir_code == 0x111 || (ir_code == rcCmdKey1 && lastIrCode == rcCmdKey1)) {
+      if (ir_code == 0x111 || irComboPressed(rcCmdKey1)) {
         Serial.println("DEBUG: Analyzer Settings Menu (combo 111)");
         
         if (!analyzerMenuActive) {
@@ -8984,6 +9317,7 @@ void handleRemote()
       
       // ============== KONIEC OBSŁUGI MODUŁÓW - kontynuacja normalnej obsługi radia ==============
       lastIrCode = ir_code; // Zapamiętujemy ostatni kod (dla combo)
+      lastIrCodeTime = millis();
       
       if (ir_code == rcCmdVolumeUp)  { volumeUp(); }         // Przycisk głośniej
       else if (ir_code == rcCmdVolumeDown) { volumeDown(); } // Przycisk ciszej
@@ -9020,6 +9354,7 @@ void handleRemote()
           for (int i = 0; i < 5; i++) {scrollDown();}
     
           if (station_nr > stationsCount) {station_nr = station_nr - stationsCount; } //Zbaezpiecznie aby przewijac sie tylko po stacjach w liczbie jaka jest w stationCount
+          if (station_nr < 1 || station_nr > stationsCount) { station_nr = 1; }        // bank krótszy niż 5 stacji
           
           displayStations();
         }
@@ -9063,23 +9398,19 @@ void handleRemote()
           displayStartTime = millis();    
           station_nr = currentSelection + 1;
 
-          station_nr = station_nr - 5;
-          
           for (int i = 0; i < 5; i++) {scrollUp();}
-      
-          //Zbaezpiecznie aby przewijac sie tylko po stacjach w liczbie jaka jest w stationCount
-          if (station_nr > stationsCount) { station_nr = (stationsCount - (255 - station_nr)) - 1 ;} 
-          
-          // Jesli jestesmy na stacji nr 5 to aby uniknąc station_nr = 0 przewijamy do ostatniej
-          if (station_nr == 0) {station_nr = stationsCount;} 
+
+          // Przewijanie w pętli po stacjach banku - odejmowanie przed przekręceniem uint16_t (stacja 5 -> ostatnia, 1 -> ostatnia-4)
+          if (station_nr > 5) { station_nr = station_nr - 5; }
+          else { station_nr = (stationsCount + station_nr > 5) ? stationsCount + station_nr - 5 : stationsCount; }
+          if (station_nr < 1 || station_nr > stationsCount) { station_nr = stationsCount; }
 
           displayStations();
         }      
         else
         {        
-          station_nr--;
-          //if (station_nr < 1) { station_nr = 1; }
-          if (station_nr < 1) { station_nr = stationsCount; } // Przwijanie listy stacji w pętli po osiągnieciu ostatniej stacji banku przewijamy do pierwszej.
+          // Przwijanie listy stacji w pętli po osiągnieciu pierwszej stacji banku przewijamy do ostatniej (także z URL, station_nr = 0)
+          if (station_nr <= 1 || station_nr > stationsCount) { station_nr = stationsCount; } else { station_nr--; }
           changeStation();
           displayRadio();
           u8g2.sendBuffer();
@@ -9232,11 +9563,11 @@ void handleRemote()
         volumeMute = !volumeMute;
         if (volumeMute == true)
         {
-          audio.setVolume(0);   
+          audio_cmd_volume(0);   
         }
         else if (volumeMute == false)
         {
-          audio.setVolume(volumeValue);   
+          audio_cmd_volume(volumeValue);   
         }
         displayRadio();
         //wsVolumeChange(volumeValue);
@@ -9385,7 +9716,7 @@ void setup()
   customSPI.begin(SD_SCLK, SD_MISO, SD_MOSI, SD_CS);  // SCLK = 45, MISO = 21, MOSI = 48, CS = 47
 
 
-  psramData = (unsigned char *)ps_malloc(PSRAM_lenght * sizeof(unsigned char));
+  station_store_init();  // Lista stacji w PSRAM - arena rośnie razem z bankiem
 
   if (psramInit()) {
     Serial.println("Pamiec PSRAM zainicjowana poprawnie.");
@@ -9399,6 +9730,15 @@ void setup()
     Serial.println("debug-- BLAD Pamieci PSRAM");
   }
 
+  // Indeks wyszukiwarki stacji - pozostałe banki z karty indeksowane w tle w loop()
+  station_search_init();
+
+  // Rozgrzewanie sąsiednich stacji - zadanie DNS w tle
+  if (!warm_init()) {Serial.println("debug warm -> Błąd uruchomienia zadania rozgrzewania");}
+
+  // Historia tytułów - pula napisów w PSRAM
+  history_init();
+
   wifiManager.setHostname(hostname);
   WiFi.setSleep(false);
 
@@ -9448,8 +9788,8 @@ void setup()
 
   
   audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);  // Konfiguruj pinout dla interfejsu I2S audio
-  Audio::audio_info_callback = my_audio_info; // Przypisanie własnej funkcji callback do obsługi zdarzeń i informacji audio
-  audio.setVolume(0);
+  audio_task_begin(&audio, my_audio_info); // Callback zdarzeń audio (w loop()) i kolejka poleceń dla audio.loop() w zadaniu
+  audio_cmd_volume(0);
   
   // Inicjalizuj interfejs SPI wyświetlacza
   SPI.begin(SPI_SCK_OLED, SPI_MISO_OLED, SPI_MOSI_OLED);
@@ -9482,6 +9822,16 @@ void setup()
   #endif
   delay(50);
   
+  // Fragmenty zegara głosowego na karcie
+  if (useSD) { voice_init(); }
+  dir_index_init();                     // listy katalogów odtwarzacza SD - mutex przed startem WWW i loop()
+  if (useSD) { media_lib_init(); }      // biblioteka utworów - indekser w tle
+  if (useSD) { cover_art_init(); }      // okładki albumów 64x64 dla ekranu odtwarzacza SD
+  if (useSD) { seek_index_init(); }     // tablice przewijania utworów odtwarzacza SD
+  if (useSD) { playlist_init(); }       // playlisty odtwarzacza SD + pozycje wznowienia
+  if (useSD) { rgain_init(); }          // ReplayGain - wyniki analizy głośności, analiza w tle
+  sdio_init(&audio);                    // harmonogram zapisów na karcie (odtwarzanie ma pierwszeństwo)
+
   // Odczyt konfiguracji
   readConfig();          
   if (configExist == false) { saveConfig(); readConfig();} // Jesli nie ma pliku config.txt to go tworzymy
@@ -9561,6 +9911,7 @@ void setup()
   wifiManager.setConfigPortalBlocking(false);
 
   // ---- ODCZYTY RÓZNYCH USTAWIEN Z KARTY SD / PAMIECI SPIFFS ----
+  readBankRegistry();        // Odczytujemy rejestr banków (nazwa, URL, plik) z pliku /banks.txt
   readStationFromSD();       // Odczytujemy zapisaną ostanią stację i bank z karty SD /EEPROMu
   readEqualizerFromSD();     // Odczytujemy ustawienia filtrów equalizera z karty SD 
   readVolumeFromSD();        // Odczytujemy nastawę ostatniego poziomu głośnosci z karty SD /EEPROMu
@@ -9569,7 +9920,7 @@ void setup()
   assignRemoteCodes();       // Przypisanie kodów pilota IR
   readTimezone();
 
-  audio.setVolumeSteps(maxVolume);
+  audio_cmd_volume_steps(maxVolume);
   //audio.setVolume(0);                  // Ustaw głośność na podstawie wartości zmiennej volumeValue w zakresie 0...21
   
   // ----------------- EKRAN - JASNOŚĆ -----------------
@@ -9644,9 +9995,10 @@ void setup()
     }
 
 
-    uint8_t temp_station_nr = station_nr; // Chowamy na chwile odczytaną stacje z karty SD aby podczas ładowania banku nie zmienic ostatniej odtwarzanej stacji
+    uint16_t temp_station_nr = station_nr; // Chowamy na chwile odczytaną stacje z karty SD aby podczas ładowania banku nie zmienic ostatniej odtwarzanej stacji
     fetchStationsFromServer();            // Ładujemy liste stacji z karty SD  lub serwera GitHub
     station_nr = temp_station_nr ;        // Przywracamy numer po odczycie stacji
+    if (stationsCount > 0 && station_nr > stationsCount) { station_nr = stationsCount; } // EEPROM / plik ze starszego banku - numer spoza listy
     changeStation();                      // Ustawiamy stację
     
     // ########################################### WEB Server ######################################################
@@ -9659,13 +10011,17 @@ void setup()
       String html =""; 
       //html.reserve(48000);  // rezerwuje bufor (np. 24KB)
 
+      // Strona listy stacji - domyślnie ta, na której jest grająca stacja
+      uint16_t page = (station_nr > 0) ? ((station_nr - 1) / webStationsPageSize) + 1 : 1;
+      if (request->hasParam("page")) { page = request->getParam("page")->value().toInt(); }
+
       if (userAgent.indexOf("Mobile") != -1 || userAgent.indexOf("Android") != -1 || userAgent.indexOf("iPhone") != -1) 
       {
-        html = stationBankListHtmlMobile();
+        html = stationBankListHtmlMobile(page);
       } 
       else //Jestemy na komputerze 
       {
-        html = stationBankListHtmlPC();
+        html = stationBankListHtmlPC(page);
       }
       
       String finalhtml = String(index_html) + html;  // Składamy cześć stałą html z częscią generowaną dynamicznie
@@ -9762,6 +10118,7 @@ void setup()
           reqCopy->onDisconnect([]() 
           {
             delay(3000);
+            sdio_flush();
             //ESP.restart();
             REG_WRITE(RTC_CNTL_OPTIONS0_REG, RTC_CNTL_SW_SYS_RST);
           });
@@ -9792,9 +10149,10 @@ void setup()
       fwupd = true;
       
       ws.closeAll();
-      audio.stopSong();
+      audio_cmd_stop();
       delay(250);
       if (!f_saveVolumeStationAlways){saveStationOnSD(); saveVolumeOnSD();}
+      sdio_flush(); // Zapisy odłożone - przed aktualizacją i restartem
       
       for (int i = 0; i < 3; i++) 
       {
@@ -9919,6 +10277,8 @@ void setup()
         if (request->hasParam("filename", true)) {
           filename += request->getParam("filename", true)->value();
           if (STORAGE.remove(filename.c_str())) {
+              dir_index_invalidate_parent(filename.c_str());   // lista odtwarzacza SD bez usuniętego pliku
+              media_lib_request_rescan();
               Serial.println("Plik usunięty: " + filename);
           } else {
               Serial.println("Nie można usunąć pliku: " + filename);
@@ -9960,6 +10320,13 @@ void setup()
         html.replace(F("%S24_checked"), f_powerOffAnimation ? " checked" : "");      
         html.replace(F("%S25_checked"), analyzerEnabled ? " checked" : "");
         html.replace(F("%S26_checked"), btModuleEnabled ? " checked" : "");      
+        html.replace(F("%S27_checked"), f_warmNeighbours ? " checked" : "");
+        html.replace(F("%S28_checked"), f_timeShift ? " checked" : "");
+        html.replace(F("%S29_checked"), f_audioTask ? " checked" : "");
+        html.replace(F("%S30_checked"), f_titleLog ? " checked" : "");
+        html.replace(F("%S31_checked"), f_sdGapless ? " checked" : "");
+        html.replace(F("%X1"), String(sdCrossfadeSec));
+        html.replace(F("%X2"), String(sdReplayGain));
 
         html.replace(F("%S1_checked"), displayAutoDimmerOn ? " checked" : "");
         html.replace(F("%S3_checked"), timeVoiceInfoEveryHour ? " checked" : "");
@@ -10091,6 +10458,13 @@ void setup()
       f_powerOffAnimation        = request->hasParam("f_powerOffAnimation", true);
       analyzerEnabled            = request->hasParam("fftAnalyzerOn", true);
       btModuleEnabled            = request->hasParam("btModuleEnabled", true);
+      f_warmNeighbours           = request->hasParam("f_warmNeighbours", true);
+      f_timeShift                = request->hasParam("f_timeShift", true);
+      f_audioTask                = request->hasParam("f_audioTask", true);
+      f_titleLog                 = request->hasParam("f_titleLog", true);
+      f_sdGapless                = request->hasParam("f_sdGapless", true);
+      if (request->hasParam("sdCrossfadeSec", true)) {sdCrossfadeSec = constrain(request->getParam("sdCrossfadeSec", true)->value().toInt(), 0, XFADE_MAX_SEC);}
+      if (request->hasParam("sdReplayGain", true)) {sdReplayGain = constrain(request->getParam("sdReplayGain", true)->value().toInt(), 0, RGAIN_MODE_ALBUM);}
 
       // Jeśli parametr istnieje checkbox był zaznaczony to TRUE
       // Jeśli go nie ma checkbox nie był zaznaczony to FALSE
@@ -10123,7 +10497,7 @@ void setup()
       // Zastosuj ustawienia analizatora i equalizera 3-point
       eq_analyzer_set_enabled(analyzerEnabled);
       readEqualizerFromSD();
-      audio.setTone(toneLowValue, toneMidValue, toneHiValue);
+      audio_cmd_tone(toneLowValue, toneMidValue, toneHiValue);
 
       saveConfig();
       readConfig();
@@ -10417,27 +10791,72 @@ void setup()
 
       // Otwórz plik na karcie SD
       static File file; // Użyj statycznej zmiennej do otwierania pliku tylko raz
+      // Fragmenty TCP (~1.4 kB) zbierane do UPLOAD_STAGE_SIZE - mniej i większe zapisy,
+      // każdy w przerwie odtwarzania (harmonogram SD)
+      static const size_t UPLOAD_STAGE_SIZE = 32 * 1024;
+      static uint8_t *stage = nullptr;
+      static size_t staged = 0;
       if (index == 0) {
+          sdio_begin(SDIO_CLASS_UPLOAD, SDIO_UPLOAD_MAX_WAIT_MS);
           file = STORAGE.open(filename, FILE_WRITE);
+          sdio_end(SDIO_CLASS_UPLOAD, 0);
           if (!file) {
               Serial.println("Failed to open file for writing");
               request->send(500, "text/plain", "Failed to open file for writing");
               return;
           }
+          if (!stage) { stage = (uint8_t *)(psramFound() ? ps_malloc(UPLOAD_STAGE_SIZE) : malloc(UPLOAD_STAGE_SIZE)); }
+          staged = 0;
+      }
+
+      // Zapisz dane do pliku (przez bufor zbiorczy, bez bufora - od razu)
+      bool writeOk = true;
+      const uint8_t *src = data;
+      size_t left = len;
+      while (writeOk && left > 0) {
+          if (stage && staged + left < UPLOAD_STAGE_SIZE) {
+              memcpy(stage + staged, src, left);
+              staged += left;
+              break;
+          }
+          const uint8_t *chunk = src;
+          size_t chunkLen = left;
+          if (stage) {
+              size_t part = UPLOAD_STAGE_SIZE - staged;
+              memcpy(stage + staged, src, part);
+              src += part;
+              left -= part;
+              chunk = stage;
+              chunkLen = UPLOAD_STAGE_SIZE;
+              staged = 0;
+          } else {
+              left = 0;
+          }
+          sdio_begin(SDIO_CLASS_UPLOAD, SDIO_UPLOAD_MAX_WAIT_MS);
+          writeOk = (file.write(chunk, chunkLen) == chunkLen);
+          sdio_end(SDIO_CLASS_UPLOAD, chunkLen);
       }
-
-      // Zapisz dane do pliku
-      size_t written = file.write(data, len);
-      if (written != len) {
+      if (writeOk && final && staged > 0) {
+          sdio_begin(SDIO_CLASS_UPLOAD, SDIO_UPLOAD_MAX_WAIT_MS);
+          writeOk = (file.write(stage, staged) == staged);
+          sdio_end(SDIO_CLASS_UPLOAD, staged);
+          staged = 0;
+      }
+      if (!writeOk) {
           Serial.println("Error writing data to file");
           file.close();
+          staged = 0;
           request->send(500, "text/plain", "Error writing data to file");
           return;
       }
 
       // Jeśli to ostatni fragment, zamknij plik i wyślij odpowiedź do klienta
       if (final) {
+          sdio_begin(SDIO_CLASS_UPLOAD, SDIO_UPLOAD_MAX_WAIT_MS);
           file.close();
+          sdio_end(SDIO_CLASS_UPLOAD, 0);
+          dir_index_invalidate_parent(filename.c_str());   // nowy plik widoczny w odtwarzaczu SD
+          media_lib_request_rescan();
           Serial.println("File upload completed successfully.");
           request->send(200, "text/plain", "File upload successful");
       } else {
@@ -10477,6 +10896,23 @@ void setup()
       //if (useSD) html.replace("%D7", String("SD").c_str()); 
       //else html.replace("%D7", String("SPIFFS").c_str()); 
       html.replace("%D0", chipStr); 
+
+      net_cache_stats_t net;
+      net_cache_get_stats(&net);
+      char netStr[64];
+      snprintf(netStr, sizeof(netStr), "%u / %u / %u (miss avg %u ms)", (unsigned)net.dnsHits, (unsigned)net.dnsMisses, (unsigned)net.dnsFailed, (unsigned)net.dnsMissAvgMs);
+      html.replace("%D8", netStr);
+      snprintf(netStr, sizeof(netStr), "%u ms (%u) / %u ms (%u)", (unsigned)net.tlsAvgMs, (unsigned)net.tlsConnects, (unsigned)net.tcpAvgMs, (unsigned)net.tcpConnects);
+      html.replace("%D9", netStr);
+
+      net_host_info_t hosts[6];
+      uint8_t hostCount = net_cache_get_hosts(hosts, 6);
+      String hostList = "";
+      for (uint8_t i = 0; i < hostCount; i++)
+      {
+        hostList += String(hosts[i].host) + " " + String(hosts[i].hits) + "/" + String(hosts[i].misses) + ", " + String(hosts[i].connectMs) + " ms" + (hosts[i].https ? " TLS" : "") + "<br>";
+      }
+      html.replace("%N1", hostList.length() ? hostList : String("-"));
       f_callInfo = true;
       
       request->send(200, "text/html", html);
@@ -10511,6 +10947,341 @@ void setup()
       request->send(200, "text/plain", "OK");
     });
 
+    // Wyszukiwarka stacji we wszystkich bankach - /api/search?q=nazwa[&limit=n]
+    server.on("/api/search", HTTP_GET, [](AsyncWebServerRequest *request){
+      if (!request->hasParam("q")) 
+      {
+        request->send(400, "text/plain", "Missing q parameter");
+        return;
+      }
+
+      uint8_t limit = SEARCH_MAX_RESULTS;
+      if (request->hasParam("limit")) { limit = constrain(request->getParam("limit")->value().toInt(), 1, SEARCH_MAX_RESULTS); }
+
+      search_result_t results[SEARCH_MAX_RESULTS];
+      uint8_t count = station_search_query(request->getParam("q")->value().c_str(), results, limit);
+
+      // Odpowiedź strumieniowa - bez składania całego JSON w jednym Stringu
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"count\":%u,\"indexed\":%u,\"banks\":%u,\"time_us\":%u,\"results\":[",
+                       count, station_search_get_entry_count(), station_search_get_indexed_banks(), (unsigned)station_search_get_last_query_us());
+      for (uint8_t i = 0; i < count; i++)
+      {
+        response->printf("%s{\"bank\":%u,\"station\":%u,\"score\":%u,\"name\":\"", i ? "," : "", results[i].bank, results[i].station, results[i].score);
+        char name[SEARCH_NAME_LENGTH * 3 + 1];   // nazwa z pliku banku bywa w Windows-1250 - w JSON tylko poprawny UTF-8
+        text_transcode(results[i].name, nullptr, 0, name, sizeof(name), nullptr);
+        for (const char *c = name; *c; c++)
+        {
+          if (*c == '"' || *c == '\\') { response->write('\\'); }
+          if ((uint8_t)*c >= 0x20) { response->write(*c); }
+        }
+        response->print("\"}");
+      }
+      response->print("]}");
+      request->send(response);
+    });
+
+    // Statystyki bufora wejściowego per stacja - /api/buffer
+    server.on("/api/buffer", HTTP_GET, [](AsyncWebServerRequest *request){
+      static buf_station_t stations[BUF_STATIONS_MAX];   // static - duża tablica poza stosem zadania async
+      uint8_t count = buf_ctrl_get_stations(stations, BUF_STATIONS_MAX);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"applied_bytes\":%u,\"hist_bounds_s\":[1,2,4,8,16],\"stations\":[", (unsigned)buf_ctrl_get_applied_bytes());
+      for (uint8_t i = 0; i < count; i++)
+      {
+        buf_station_t *st = &stations[i];
+        response->printf("%s{\"name\":\"", i ? "," : "");
+        for (const char *c = st->name; *c; c++)
+        {
+          if (*c == '"' || *c == '\\') { response->write('\\'); }
+          if ((uint8_t)*c >= 0x20) { response->write(*c); }
+        }
+        response->printf("\",\"id\":\"%08X\",\"kbps\":%u,\"codec\":\"%s\",\"underruns\":%u,\"jitter_ms\":%u,\"target_bytes\":%u,\"hist\":[%u,%u,%u,%u,%u,%u]}",
+                         (unsigned)st->urlHash, st->bitrateKbps, stream_info_codec_name(st->codec), st->underruns, st->jitterMs, (unsigned)st->targetBytes,
+                         st->hist[0], st->hist[1], st->hist[2], st->hist[3], st->hist[4], st->hist[5]);
+      }
+      response->print("]}");
+      request->send(response);
+    });
+
+    // Harmonogram karty SD - /api/sdio (kolejka, opóźnienia per klasa, spadki bufora przy odtwarzaniu z karty)
+    server.on("/api/sdio", HTTP_GET, [](AsyncWebServerRequest *request){
+      static const char *const classNames[SDIO_CLASS_COUNT] = { "config", "log", "upload", "cover", "loudness", "seek", "library" };
+      sdio_status_t st;
+      sdio_get_status(&st);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"queue\":%u,\"queue_high\":%u,\"playback\":%s,\"buffer_fill\":%u,\"buffer_size\":%u,\"readahead_bytes\":%u,"
+                       "\"low_buffer_events\":%u,\"io_stalls\":%u,\"classes\":{",
+                       st.queueDepth, st.queueHighWater, st.playback ? "true" : "false", (unsigned)st.bufferFill, (unsigned)st.bufferSize,
+                       (unsigned)SDIO_READAHEAD_BYTES, (unsigned)st.lowBufferEvents, (unsigned)st.ioStalls);
+      for (uint8_t i = 0; i < SDIO_CLASS_COUNT; i++)
+      {
+        sdio_class_stats_t *c = &st.cls[i];
+        response->printf("%s\"%s\":{\"ops\":%u,\"bytes\":%u,\"coalesced\":%u,\"wait_avg_ms\":%u,\"wait_max_ms\":%u,"
+                         "\"op_avg_ms\":%u,\"op_max_ms\":%u,\"gap_timeouts\":%u,\"stalls\":%u,\"failed\":%u}",
+                         i ? "," : "", classNames[i], (unsigned)c->ops, (unsigned)c->bytes, (unsigned)c->coalesced,
+                         (unsigned)c->waitAvgMs, (unsigned)c->waitMaxMs, (unsigned)c->opAvgMs, (unsigned)c->opMaxMs,
+                         (unsigned)c->gapTimeouts, (unsigned)c->stalls, (unsigned)c->failed);
+      }
+      response->print("}}");
+      request->send(response);
+    });
+
+    // ReplayGain - wzmocnienie bieżącego utworu, źródło, analiza głośności w tle (tempo w plikach / min)
+    server.on("/api/replaygain", HTTP_GET, [](AsyncWebServerRequest *request){
+      static const char *const modeNames[] = { "off", "track", "album" };
+      static const char *const analysisNames[] = { "off", "waiting", "running", "done" };
+      rgain_status_t rg;
+      rgain_get_status(&rg);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"mode\":\"%s\",\"gain_cdb\":%d,\"source\":\"%s\",\"peak_limited\":%s,\"clipped_samples\":%u,"
+                       "\"tracks\":%u,\"from_tags\":%u,\"from_analysis\":%u,\"untagged\":%u,\"preamp_cdb\":%d,\"untagged_cdb\":%d,"
+                       "\"analysis\":{\"state\":\"%s\",\"analysed\":%u,\"failed\":%u,\"aborted\":%u,\"session_files\":%u,"
+                       "\"files_per_min\":%u.%u,\"realtime\":%u.%u,\"last_file_ms\":%u,\"last_lufs\":%s%d.%d}}",
+                       modeNames[rg.mode <= RGAIN_MODE_ALBUM ? rg.mode : 0], rg.gainCdb, rgain_source_name(rg.source),
+                       rg.peakLimited ? "true" : "false", (unsigned)rg.clippedSamples, (unsigned)rg.tracks, (unsigned)rg.fromTags,
+                       (unsigned)rg.fromAnalysis, (unsigned)rg.untagged, RGAIN_PREAMP_CDB, RGAIN_UNTAGGED_CDB,
+                       analysisNames[rg.analysisState <= RGAIN_ANALYSIS_DONE ? rg.analysisState : 0], (unsigned)rg.analysed,
+                       (unsigned)rg.analysisFailed, (unsigned)rg.analysisAborted, (unsigned)rg.passFiles,
+                       (unsigned)(rg.filesPerMin10 / 10), (unsigned)(rg.filesPerMin10 % 10), (unsigned)(rg.realtime10 / 10),
+                       (unsigned)(rg.realtime10 % 10), (unsigned)rg.lastFileMs,
+                       rg.lastLufs10 < 0 ? "-" : "", abs(rg.lastLufs10) / 10, abs(rg.lastLufs10) % 10);
+      request->send(response);
+    });
+
+    // Sterowanie timeshift - /api/timeshift?cmd=pause|back10|back30|fwd10|live
+    server.on("/api/timeshift", HTTP_GET, [](AsyncWebServerRequest *request){
+      if (request->hasParam("cmd"))
+      {
+        String cmd = request->getParam("cmd")->value();
+        if (cmd == "pause") { timeshift_toggle_pause(); }
+        else if (cmd == "back10") { timeshift_skip(-TS_SKIP_SHORT_SEC); }
+        else if (cmd == "back30") { timeshift_skip(-TS_SKIP_LONG_SEC); }
+        else if (cmd == "fwd10") { timeshift_skip(TS_SKIP_SHORT_SEC); }
+        else if (cmd == "live") { timeshift_go_live(); }
+        else { request->send(400, "text/plain", "Unknown cmd"); return; }
+      }
+
+      timeshift_status_t ts;
+      timeshift_get_status(&ts);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"enabled\":%s,\"paused\":%s,\"delay_ms\":%u,\"buffered_ms\":%u,\"capacity_ms\":%u,\"ring_bytes\":%u,\"sample_rate\":%u,"
+                       "\"write_bps\":%u,\"read_bps\":%u,\"write_us_per_s\":%u,\"read_us_per_s\":%u,\"write_mbps\":%u,\"read_mbps\":%u}",
+                       ts.enabled ? "true" : "false", ts.paused ? "true" : "false", (unsigned)ts.delayMs, (unsigned)ts.bufferedMs,
+                       (unsigned)ts.capacityMs, (unsigned)ts.ringBytes, (unsigned)ts.sampleRate,
+                       (unsigned)ts.writeBytesPerSec, (unsigned)ts.readBytesPerSec, (unsigned)ts.writeUsPerSec, (unsigned)ts.readUsPerSec,
+                       (unsigned)ts.writeMBps, (unsigned)ts.readMBps);
+      request->send(response);
+    });
+
+    // Nagrywanie stacji na SD - /api/record?cmd=start[&min=N]|stop
+    server.on("/api/record", HTTP_GET, [](AsyncWebServerRequest *request){
+      if (request->hasParam("cmd"))
+      {
+        String cmd = request->getParam("cmd")->value();
+        if (cmd == "start")
+        {
+          uint16_t minutes = request->hasParam("min") ? request->getParam("min")->value().toInt() : 0;
+          if (!rec_is_active() && !recordingStart(minutes)) { request->send(409, "text/plain", "Recording not started"); return; }
+        }
+        else if (cmd == "stop") { rec_stop(); }
+        else { request->send(400, "text/plain", "Unknown cmd"); return; }
+      }
+
+      rec_status_t rs;
+      rec_get_status(&rs);
+      static const char* const states[] = {"idle", "connecting", "recording", "stopping", "error"};
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"state\":\"%s\",\"file\":\"%s\",\"error\":\"%s\",\"part\":%u,\"file_bytes\":%u,\"total_bytes\":%u,"
+                       "\"elapsed_s\":%u,\"remaining_s\":%u,\"net_kBps\":%u,\"write_kBps\":%u,\"max_write_ms\":%u,\"max_audio_gap_ms\":%u,"
+                       "\"ring_high_water\":%u,\"ring_bytes\":%u,\"stall_ms\":%u,\"dropped_bytes\":%u,\"titles\":%u,\"reconnects\":%u}",
+                       states[rs.state], rs.fileName, rs.error, rs.fileIndex, (unsigned)rs.fileBytes, (unsigned)rs.totalBytes,
+                       (unsigned)rs.elapsedSec, (unsigned)rs.remainingSec, (unsigned)rs.netKBps, (unsigned)rs.writeKBps,
+                       (unsigned)rs.maxWriteMs, (unsigned)rs.maxAudioGapMs, (unsigned)rs.ringHighWater, (unsigned)REC_RING_BYTES,
+                       (unsigned)rs.stallMs, (unsigned)rs.droppedBytes, rs.titles, rs.reconnects);
+      request->send(response);
+    });
+
+    // Nadzór strumienia i niezawodność adresów - /api/health
+    server.on("/api/health", HTTP_GET, [](AsyncWebServerRequest *request){
+      static health_url_stats_t urls[HEALTH_STATS_MAX];   // static - tablica poza stosem zadania async
+      uint8_t count = health_get_url_stats(urls, HEALTH_STATS_MAX);
+      health_status_t hs;
+      health_get_status(&hs);
+      static const char* const states[] = {"idle", "connecting", "playing", "wait_retry"};
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"state\":\"%s\",\"url_index\":%u,\"url_count\":%u,\"retries\":%u,\"next_retry_ms\":%u,"
+                       "\"buffer_filled\":%u,\"arrival_bps\":%u,\"errors_window\":%u,\"stalls\":%u,\"recoveries\":%u,\"failovers\":%u,"
+                       "\"ttr_last_ms\":%u,\"ttr_avg_ms\":%u,\"ttr_max_ms\":%u,\"urls\":[",
+                       states[hs.state], hs.urlIndex, hs.urlCount, hs.retries, (unsigned)hs.nextRetryMs,
+                       (unsigned)hs.bufferFilled, (unsigned)hs.arrivalBps, hs.errorsWindow, hs.stalls, hs.recoveries, hs.failovers,
+                       (unsigned)hs.lastTtrMs, (unsigned)hs.avgTtrMs, (unsigned)hs.maxTtrMs);
+      for (uint8_t i = 0; i < count; i++)
+      {
+        health_url_stats_t *u = &urls[i];
+        response->printf("%s{\"id\":\"%08X\",\"host\":\"%s\",\"connects\":%u,\"connect_fails\":%u,\"stalls\":%u,\"errors\":%u,\"play_s\":%u}",
+                         i ? "," : "", (unsigned)u->urlHash, u->host, u->connects, u->connectFails, u->stalls, u->errors, (unsigned)u->playSec);
+      }
+      response->print("]}");
+      request->send(response);
+    });
+
+    // Test stacji banku - /api/probe?cmd=start&bank=N[&base=http://127.0.0.1]|stop, wyniki /api/probe?from=N
+    server.on("/api/probe", HTTP_GET, [](AsyncWebServerRequest *request){
+      if (request->hasParam("cmd"))
+      {
+        String cmd = request->getParam("cmd")->value();
+        if (cmd == "start")
+        {
+          long bankParam = request->hasParam("bank") ? request->getParam("bank")->value().toInt() : bank_nr;
+          String base = request->hasParam("base") ? request->getParam("base")->value() : String();
+          if (bankParam < 1 || bankParam > bank_nr_max) { request->send(400, "text/plain", "Wrong bank"); return; } // zakres przed zawężeniem do uint8_t
+          uint8_t bank = (uint8_t)bankParam;
+          // Bieżący bank z pamięci PSRAM, pozostałe z pliku banku
+          if (!probe_start(bank, bank == bank_nr, base.c_str())) { request->send(409, "text/plain", "Probe not started"); return; }
+        }
+        else if (cmd == "stop") { probe_stop(); }
+        else { request->send(400, "text/plain", "Unknown cmd"); return; }
+      }
+
+      // Wyniki porcjami (from=N) - odpowiedź dla całego banku nie mieści się wygodnie w RAM
+      static const uint16_t PAGE = 40;
+      static probe_result_t results[PAGE];   // static - tablica poza stosem zadania async
+      long fromParam = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+      uint16_t first = (fromParam > 0 && fromParam <= UINT16_MAX) ? (uint16_t)fromParam : 0;
+      probe_status_t ps;
+      probe_get_status(&ps);
+      uint16_t count = probe_get_results(results, first, PAGE);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"running\":%s,\"bank\":%u,\"total\":%u,\"done\":%u,\"ok\":%u,\"elapsed_ms\":%u,\"base\":\"%s\",\"report\":\"%s\",\"from\":%u,\"results\":[",
+                       ps.running ? "true" : "false", ps.bank, ps.total, ps.done, ps.ok, (unsigned)ps.elapsedMs,
+                       jsonEscape(ps.base).c_str(), jsonEscape(ps.report).c_str(), first);
+      for (uint16_t i = 0; i < count; i++)
+      {
+        probe_result_t *r = &results[i];
+        response->printf("%s{\"station\":%u,\"name\":\"%s\",\"error\":\"%s\",\"http\":%u,\"redirects\":%u,\"host\":\"%s\",\"https\":%s,"
+                         "\"dns_ms\":%u,\"tcp_ms\":%u,\"tls_ms\":%u,\"first_byte_ms\":%u,\"first_audio_ms\":%u,\"total_ms\":%u,"
+                         "\"codec\":\"%s\",\"kbps\":%u,\"sample_rate\":%u}",
+                         i ? "," : "", r->station, jsonEscape(r->name).c_str(), probe_error_name(r->error), r->httpStatus, r->redirects, jsonEscape(r->finalHost).c_str(),
+                         r->https ? "true" : "false", r->dnsMs, r->tcpMs, r->tlsMs, r->firstByteMs, r->firstAudioMs, r->totalMs,
+                         stream_info_codec_name(r->codec), r->bitrateKbps, (unsigned)r->sampleRate);
+      }
+      response->print("]}");
+      request->send(response);
+    });
+
+    server.on("/probe", HTTP_GET, [](AsyncWebServerRequest *request){
+      String html = String(probe_html);
+      html.replace("%B0", String(bank_nr));
+      request->send(200, "text/html", html);
+    });
+
+    // Atrapa serwera strumieni dla testu bez internetu - /probe/standin?n=X[&r=1]
+    server.on("/probe/standin", HTTP_GET, [](AsyncWebServerRequest *request){
+      uint16_t n = request->hasParam("n") ? request->getParam("n")->value().toInt() : 0;
+      uint8_t kind = probe_standin_kind(n, request->hasParam("r"));
+      if (kind == 2) { request->redirect("/probe/standin?n=" + String(n) + "&r=1"); return; }
+      if (kind == 3) { request->send(404, "text/plain", "Not found"); return; }
+
+      AsyncWebServerResponse *response = request->beginChunkedResponse(kind == 1 ? "audio/aac" : "audio/mpeg",
+        [kind](uint8_t *buffer, size_t maxLen, size_t index) -> size_t { return probe_standin_fill(kind, index, buffer, maxLen); });
+      response->addHeader("icy-br", "128");
+      response->addHeader("icy-name", "Probe stand-in " + String(n));
+      request->send(response);
+    });
+
+    // Obsługa audio i zacięcia pętli - /api/audiotask
+    server.on("/api/audiotask", HTTP_GET, [](AsyncWebServerRequest *request){
+      audio_task_status_t as;
+      audio_task_get_status(&as);
+      stream_info_stats_t si;
+      stream_info_get_stats(&si);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"task_mode\":%s,\"core\":%u,\"priority\":%u,\"loop_max_ms\":%u,\"loop_avg_us\":%u,\"loop_worst_ms\":%u,\"loop_stalls\":%u,"
+                       "\"service_max_ms\":%u,\"service_worst_ms\":%u,\"service_stalls\":%u,\"stall_ms\":%u,"
+                       "\"commands\":%u,\"queue_high_water\":%u,\"info_dropped\":%u,\"stack_free\":%u,"
+                       "\"info_msgs\":%u,\"info_allocs\":%u,\"info_msgs_per_min\":%u,\"info_allocs_per_min\":%u,\"alloc_counter\":%s}",
+                       as.taskMode ? "true" : "false", AUDIO_TASK_CORE, AUDIO_TASK_PRIORITY, (unsigned)as.loopMaxMs, (unsigned)as.loopAvgUs,
+                       (unsigned)as.loopWorstMs, (unsigned)as.loopStalls, (unsigned)as.serviceMaxMs, (unsigned)as.serviceWorstMs,
+                       (unsigned)as.serviceStalls, AUDIO_STALL_MS, (unsigned)as.commands, as.queueHighWater, as.infoDropped, (unsigned)as.stackFree,
+                       (unsigned)si.messages, (unsigned)si.allocs, (unsigned)si.messagesPerMin, (unsigned)si.allocsPerMin,
+                       si.allocCounter ? "true" : "false");
+      request->send(response);
+    });
+
+    // Ostatnio grane tytuły - /api/history[?station=N] (N = 0 ostatnio grana stacja)
+    server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest *request){
+      static history_entry_t titles[HISTORY_TITLES_PER_STATION];   // static - tablica poza stosem zadania async
+      uint8_t index = request->hasParam("station") ? request->getParam("station")->value().toInt() : 0;
+      uint8_t count = history_get_titles(index, titles, HISTORY_TITLES_PER_STATION);
+      history_status_t hs;
+      history_get_status(&hs);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"strings\":%u,\"pool_used\":%u,\"pool_bytes\":%u,\"compactions\":%u,\"added\":%u,\"duplicates\":%u,"
+                       "\"log\":%s,\"log_pending\":%u,\"log_writes\":%u,\"log_bytes\":%u,\"stations\":[",
+                       hs.strings, (unsigned)hs.poolUsed, (unsigned)hs.poolBytes, hs.compactions, (unsigned)hs.titlesAdded, (unsigned)hs.duplicates,
+                       hs.logEnabled ? "true" : "false", hs.logPending, (unsigned)hs.logWrites, (unsigned)hs.logBytes);
+      history_station_t st;
+      for (uint8_t i = 0; history_get_station(i, &st); i++)
+      {
+        response->printf("%s{\"index\":%u,\"id\":\"%08X\",\"name\":\"%s\",\"count\":%u,\"last\":%u}",
+                         i ? "," : "", i, (unsigned)st.urlHash, jsonEscape(st.name).c_str(), st.count, (unsigned)st.lastTime);
+      }
+      response->printf("],\"station\":%u,\"titles\":[", index);
+      for (uint8_t i = 0; i < count; i++)
+      {
+        response->printf("%s{\"time\":%u,\"title\":\"%s\"}", i ? "," : "", (unsigned)titles[i].time, jsonEscape(titles[i].title).c_str());
+      }
+      response->print("]}");
+      request->send(response);
+    });
+
+    // Zegar głosowy - /api/voice[?cmd=fetch&lang=pl|en] - fragmenty na karcie, pobieranie, czas przerwy
+    server.on("/api/voice", HTTP_GET, [](AsyncWebServerRequest *request){
+      if (request->hasParam("cmd") && request->getParam("cmd")->value() == "fetch")
+      {
+        if (!useSD) { request->send(409, "text/plain", "No SD card"); return; }
+        String lang = request->hasParam("lang") ? request->getParam("lang")->value() : String("pl");
+        if (!voice_fetch_start(lang.c_str())) { request->send(409, "text/plain", "Fetch not started"); return; }
+      }
+
+      voice_status_t vs;
+      voice_get_status(&vs);
+      static const char* fetchStates[] = {"idle", "running", "done", "error"};
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"clips\":%u,\"cached_pl\":%u,\"cached_en\":%u,\"fetch\":\"%s\",\"fetch_lang\":\"%s\",\"fetch_done\":%u,\"fetch_failed\":%u,"
+                       "\"fetch_error\":\"%s\",\"played_cached\":%u,\"played_online\":%u,\"fallbacks\":%u,\"last_cached\":%s,"
+                       "\"last_clip_ms\":%u,\"last_resume_ms\":%u,\"last_total_ms\":%u,\"cached_avg_ms\":%u,\"online_avg_ms\":%u}",
+                       VOICE_CLIPS_PER_LANG, vs.cached[0], vs.cached[1], fetchStates[vs.fetchState], vs.fetchLang, vs.fetchDone, vs.fetchFailed,
+                       jsonEscape(vs.fetchError).c_str(), vs.playedCached, vs.playedOnline, vs.fallbacks, vs.lastCached ? "true" : "false",
+                       (unsigned)vs.lastClipMs, (unsigned)vs.lastResumeMs, (unsigned)vs.lastTotalMs, (unsigned)vs.cachedAvgMs, (unsigned)vs.onlineAvgMs);
+      request->send(response);
+    });
+
+    // Czas do pierwszego dźwięku po zmianie stacji - /api/ttfa
+    server.on("/api/ttfa", HTTP_GET, [](AsyncWebServerRequest *request){
+      warm_stats_t st;
+      warm_get_stats(&st);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      response->printf("{\"enabled\":%s,\"last_ms\":%u,\"last_warm\":%s,\"warm_avg_ms\":%u,\"warm_count\":%u,"
+                       "\"cold_avg_ms\":%u,\"cold_count\":%u,\"resolve_ms\":%u,\"resolve_failed\":%u}",
+                       warm_is_enabled() ? "true" : "false", (unsigned)st.lastTtfaMs, st.lastWarm ? "true" : "false",
+                       (unsigned)st.warmAvgMs, st.warmCount, (unsigned)st.coldAvgMs, st.coldCount,
+                       (unsigned)st.lastResolveMs, st.resolveFailed);
+      request->send(response);
+    });
+
     ws.onEvent(onWsEvent);
     server.addHandler(&ws);
     
@@ -10645,19 +11416,37 @@ void setup()
 // Funkcja przekazująca próbki audio do analizatora FFT (wywoływana z Audio.cpp)
 void audio_process_i2s(int16_t* outBuff, int32_t validSamples, bool* continueI2S)
 {
+  // Continue normal audio processing
+  *continueI2S = true;
+
+  // Timeshift - zapis do bufora PSRAM, przy pauzie / cofnięciu podmiana próbek (tylko radio)
+  if (!sdPlayerActive && !player_state_screen_active()) { timeshift_process(outBuff, validSamples, streamInfo.sampleRate); }
+
+  // Odtwarzacz SD - linia opóźniająca i przenikanie utworów, pomiar przerwy między utworami
+  if (player_state_playing())
+  {
+    uint32_t duration = audio.getAudioFileDuration();
+    uint32_t position = audio.getAudioCurrentTime();
+    seek_index_process(validSamples, audio.getSampleRate()); // Pozycja utworu (ramki od startu / przewinięcia) i opóźnienie przewinięcia
+    rgain_process(outBuff, validSamples); // Wzmocnienie ReplayGain - przed linią opóźniającą (końcówka A z własnym wzmocnieniem)
+    xfade_process(outBuff, validSamples, audio.getSampleRate(), duration > position ? duration - position : 0, continueI2S);
+    if (!*continueI2S) { return; } // Blok tylko do bufora linii opóźniającej - nie trafia na wyjście
+  }
+
   // Push audio samples to EQ analyzer (validSamples is number of stereo frames)
   eq_analyzer_push_samples_i16((const int16_t*)outBuff, validSamples);
+
+  // Pierwsze próbki po zmianie stacji - pomiar TTFA
+  if (validSamples > 0) { warm_first_audio(); health_audio_flowing(); voice_note_audio(); }
   
   // Używamy 3-punktowego equalizera z audio.setTone()
-  // Continue normal audio processing
-  *continueI2S = true;
 }
 
 // #######################################################################################  LOOP  ####################################################################################### //
 void loop() 
 {
   runTime1 = esp_timer_get_time();
-  audio.loop();           // Wykonuje główną pętlę dla obiektu audio
+  audio_task_loop();      // audio.loop() (lub tylko polecenia i zdarzenia gdy audio działa w osobnym zadaniu) + pomiar obiegu pętli
   
   // =============== OBSŁUGA ZINTEGROWANYCH MODUŁÓW ===============
   // SDPlayer - obsługa odtwarzania plików SD
@@ -10670,18 +11459,12 @@ void loop()
   }
   
   // Obsługa auto-play SDPlayera (w głównej pętli, nie w callback Audio)
-  if (sdPlayerAutoPlayNext && g_sdPlayerWeb && sdPlayerPlayingMusic) {
-    sdPlayerAutoPlayNext = false; // Zresetuj flagę
+  // OLED przesuwa kursor sam po zmianie wersji PlayerState
+  if (player_state_take_next_request() && g_sdPlayerWeb && player_state_playing()) {
     Serial.println("[SDPlayer] Wykonywanie auto-play następnego utworu");
     g_sdPlayerWeb->playNextAuto();
-    
-    // KRYTYCZNE: Synchronizuj indeks między WebUI a OLED
-    if (g_sdPlayerOLED && sdPlayerOLEDActive) {
-      int webIndex = g_sdPlayerWeb->getSelectedIndex();
-      g_sdPlayerOLED->setSelectedIndex(webIndex);
-      Serial.printf("[SDPlayer] Synchronized OLED index to %d\n", webIndex);
-    }
   }
+  if (g_sdPlayerWeb) g_sdPlayerWeb->loop();   // stan odtwarzacza do strony (WebSocket) po zmianie
   
   // Analyzer - analiza spektrum (działa na osobnym rdzeniu)
   // eq_analyzer_loop() wywoływane jest automatycznie w osobnym wątku
@@ -10703,6 +11486,25 @@ void loop()
   /*---------------------  FUNKCJA PILOT IR  / Obsluga pilota IR w kodzie NEC ---------------------*/ 
   handleRemote();         
 
+  /*---------------------  WYSZUKIWARKA / Indeksowanie banków z karty w tle ---------------------*/ 
+  if ((displayActive == false) && !player_state_screen_active() && (fwupd == false)) { station_search_loop(); }
+
+  /*---------------------  BUFOR AUDIO / Pomiar zapełnienia bufora wejściowego co 1s ---------------------*/ 
+  if ((millis() - bufferControlTime >= 1000) && !sdPlayerActive && !player_state_screen_active())
+  {
+    bufferControlTime = millis();
+    buf_ctrl_tick(audio.inBufferFilled(), audio.getBitRate(), streamInfo.codec, audio.isRunning());
+    if (timeShiftActive) { timeShiftDisplay(); }  // Odświeżenie opóźnienia / paska bufora
+
+    // Nadzór strumienia - pomijany w trakcie komunikatu głosowego, aktualizacji i w trybie power off
+    if (!resumePlay && !fwupd && !f_powerOff)
+    {
+      const char* retryUrl = health_tick(audio.inBufferFilled(), audio.getBitRate(), audio.isRunning());
+      if (retryUrl) { streamReconnect(retryUrl); }
+    }
+    history_tick(); // Paczka dziennika tytułów na kartę gdy pora
+  }
+
   /*-- FUNKCJA KLAWIATURA / Odczyt stanu klawiatura ADC pod GPIO 9 ---------------------*/
   if ((millis() - keyboardLastSampleTime >= keyboardSampleDelay) && (adcKeyboardEnabled)) // Sprawdzenie ADC - klawiatury 
   {
@@ -10732,7 +11534,7 @@ void loop()
   if ((displayActive == true) && (displayDimmerActive == true) && (fwupd == false)) {displayDimmer(0);}  
 
   /*---------------------  FUNKCJA BACK / POWROTU ze wszystkich opcji Menu, Ustawien, itd ---------------------*/
-  if ((fwupd == false) && (displayActive) && (millis() - displayStartTime >= displayTimeout))  // Przywracanie poprzedniej zawartości ekranu po 6 sekundach
+  if ((fwupd == false) && (displayActive) && (millis() - displayStartTime >= ((stationSearchActive || timeShiftActive) ? stationSearchTimeout : displayTimeout)))  // Przywracanie poprzedniej zawartości ekranu po 6 sekundach
   {
     if (volumeBufferValue != volumeValue && f_saveVolumeStationAlways) { saveVolumeOnSD(); }    
     if ((rcInputDigitsMenuEnable == true) && (station_nr != stationFromBuffer)) { changeStation(); }  // Jezeli nastapiła zmiana numeru stacji to wczytujemy nową stacje
@@ -10741,7 +11543,7 @@ void loop()
     clearFlags();
     
     // KRYTYCZNE: Nie nadpisuj ekranu gdy SDPlayer OLED aktywny
-    if (!sdPlayerOLEDActive) {
+    if (!player_state_screen_active()) {
       displayRadio();
       u8g2.sendBuffer();
     }
@@ -10753,7 +11555,7 @@ void loop()
 
 
   /*---------------------  FUNKCJA PETLI MILLIS SCROLLER / Odswiezanie VU Meter, Time, Scroller, OLED, WiFi ver. 1 ---------------------*/ 
-  if ((millis() - scrollingStationStringTime > scrollingRefresh) && (displayActive == false) && !sdPlayerActive && !sdPlayerOLEDActive) // KRYTYCZNE: Dodano !sdPlayerOLEDActive
+  if ((millis() - scrollingStationStringTime > scrollingRefresh) && (displayActive == false) && !sdPlayerActive && !player_state_screen_active()) // KRYTYCZNE: Dodano !player_state_screen_active()
   {
     scrollingStationStringTime = millis();
     
@@ -10780,7 +11582,7 @@ void loop()
         stationStringFormatting(); // Formatujemy StationString do wyswietlenia przez Scroller
       } 
 
-      if (f_audioInfoRefreshDisplayRadio == true && displayActive == false && !sdPlayerOLEDActive) // Blokuj gdy SD Player OLED aktywny
+      if (f_audioInfoRefreshDisplayRadio == true && displayActive == false && !player_state_screen_active()) // Blokuj gdy SD Player OLED aktywny
       { 
         f_audioInfoRefreshDisplayRadio = false;
         ActionNeedUpdateTime = true;
@@ -10877,13 +11679,13 @@ void loop()
       urlToPlay = false;
       webUrlStationPlay();
       // KRYTYCZNE: Nie nadpisuj ekranu gdy SDPlayer OLED aktywny
-      if (!sdPlayerOLEDActive) {
+      if (!player_state_screen_active()) {
         displayRadio();
       }
     }
     
     // KRYTYCZNE: Nie rysuj radio scrollera gdy SDPlayer aktywny
-    if (!sdPlayerOLEDActive) {
+    if (!player_state_screen_active()) {
       displayRadioScroller();  // wykonujemy przewijanie tekstu station stringi przygotowujemy bufor ekranu
       u8g2.sendBuffer();  // rysujemy całą zawartosc ekranu.
     }
@@ -0,0 +1,5 @@
+#pragma once
+// Zastępnik Arduino.h dla kompilacji na hoście - TextTranscode nie używa API Arduino
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
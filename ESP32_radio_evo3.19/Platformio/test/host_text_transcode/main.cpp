@@ -0,0 +1,162 @@
+// ========================================================================
+// TEXT TRANSCODE - próba na hoście (fuzz + porównanie + pomiar czasu)
+// ========================================================================
+// Program poza firmware - repozytorium nie ma środowiska native PlatformIO.
+// Kompilacja i uruchomienie z katalogu Platformio/:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined \
+//       -Itest/host_text_transcode -Isrc \
+//       test/host_text_transcode/main.cpp src/TextTranscode.cpp -o /tmp/tt_host
+//   /tmp/tt_host            (pomiar bez sanitizerów: -O2 zamiast -O1 -fsanitize)
+// Sprawdza:
+//   - zakończenie '\0' w każdym buforze i długości = strlen (losowe wejścia
+//     i rozmiary buforów, także 1 bajt),
+//   - wyjście "web" zawsze poprawnym UTF-8 (bez overlong / surogatów),
+//   - polskie litery na OLED jak w dawnym processText(),
+// i mierzy czas tytułu 120 znaków: text_transcode vs dawne processText().
+// ========================================================================
+
+#include "TextTranscode.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static const long FUZZ_ITERATIONS = 2000000;
+static const int  BENCH_ITERATIONS = 200000;
+
+static int g_failed = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("BŁĄD: " __VA_ARGS__); printf("\n"); g_failed++; } } while (0)
+
+// Poprawny UTF-8: najkrótszy zapis, bez surogatów, <= U+10FFFF
+static bool valid_utf8(const uint8_t* s)
+{
+  while (*s) {
+    uint8_t c = *s;
+    int n = c < 0x80 ? 0 : (c >> 5) == 0x06 ? 1 : (c >> 4) == 0x0E ? 2 : (c >> 3) == 0x1E ? 3 : -1;
+    if (n < 0) return false;
+    uint32_t cp = n == 0 ? c : n == 1 ? (c & 0x1F) : n == 2 ? (c & 0x0F) : (c & 0x07);
+    for (int i = 1; i <= n; i++) {
+      if ((s[i] & 0xC0) != 0x80) return false;
+      cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    if ((n == 1 && cp < 0x80) || (n == 2 && cp < 0x800) || (n == 3 && cp < 0x10000)) return false;
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+    s += n + 1;
+  }
+  return true;
+}
+
+// Dawne processText() z main.cpp (String -> std::string) - wzorzec dla polskich liter i pomiaru
+static void legacy_process_text(std::string& text)
+{
+  if (text.size() >= 3 && (uint8_t)text[0] == 0xEF && (uint8_t)text[1] == 0xBB && (uint8_t)text[2] == 0xBF) text.erase(0, 3);
+  for (size_t i = 0; i + 1 < text.size(); i++) {
+    uint8_t a = text[i], b = text[i + 1];
+    uint8_t out = 0;
+    if (a == 0xC3) { out = b == 0xB3 ? 0xF3 : b == 0x93 ? 0xD3 : 0; }
+    else if (a == 0xC4) {
+      switch (b) { case 0x85: out = 0xB9; break; case 0x84: out = 0xA5; break; case 0x87: out = 0xE6; break;
+                   case 0x86: out = 0xC6; break; case 0x99: out = 0xEA; break; case 0x98: out = 0xCA; break; }
+    }
+    else if (a == 0xC5) {
+      switch (b) { case 0x82: out = 0xB3; break; case 0x81: out = 0xA3; break; case 0x84: out = 0xF1; break;
+                   case 0x83: out = 0xD1; break; case 0x9B: out = 0x9C; break; case 0x9A: out = 0x8C; break;
+                   case 0xBA: out = 0x9F; break; case 0xB9: out = 0x8F; break; case 0xBC: out = 0xBF; break;
+                   case 0xBB: out = 0xAF; break; }
+    }
+    else continue;
+    if (out) text[i] = (char)out;
+    text.erase(i + 1, 1);
+  }
+}
+
+static void fuzz(void)
+{
+  std::mt19937 rng(20261018);
+  std::vector<char> in, display, web;
+  for (long it = 0; it < FUZZ_ITERATIONS && g_failed < 10; it++) {
+    size_t len = rng() % 200;
+    in.assign(len + 1, 0);
+    for (size_t i = 0; i < len; i++) {
+      uint32_t r = rng();
+      in[i] = (r & 3) ? (char)(1 + (r >> 8) % 255) : (char)(0x20 + (r >> 8) % 0x5F);   // bajty 1..255, co 4. ASCII
+    }
+    size_t displaySize = rng() % 64, webSize = rng() % 96;
+    display.assign(displaySize ? displaySize : 1, 'X');
+    web.assign(webSize ? webSize : 1, 'X');
+
+    text_result_t r;
+    text_transcode(in.data(), displaySize ? display.data() : nullptr, displaySize,
+                   webSize ? web.data() : nullptr, webSize, &r);
+
+    if (displaySize) {
+      CHECK(memchr(display.data(), 0, displaySize) != nullptr, "display bez '\\0' (próba %ld)", it);
+      CHECK(strlen(display.data()) == r.displayLength, "display długość (próba %ld)", it);
+    }
+    if (webSize) {
+      CHECK(memchr(web.data(), 0, webSize) != nullptr, "web bez '\\0' (próba %ld)", it);
+      CHECK(strlen(web.data()) == r.webLength, "web długość (próba %ld)", it);
+      CHECK(valid_utf8((const uint8_t*)web.data()), "web niepoprawny UTF-8 (próba %ld)", it);
+    }
+  }
+  printf("fuzz: %ld prób\n", FUZZ_ITERATIONS);
+}
+
+static void polish_letters(void)
+{
+  const char* samples[] = {
+    "Zażółć gęślą jaźń",
+    "ZAŻÓŁĆ GĘŚLĄ JAŹŃ",
+    "\xEF\xBB\xBF" "Ćma nad łąką - Śpiew",
+  };
+  for (const char* s : samples) {
+    char display[TEXT_DISPLAY_MAX];
+    text_transcode(s, display, sizeof(display), nullptr, 0, nullptr);
+    std::string legacy = s;
+    legacy_process_text(legacy);
+    CHECK(legacy == display, "polskie litery różne od processText(): %s", s);
+  }
+  printf("polskie litery: %zu tekstów\n", sizeof(samples) / sizeof(samples[0]));
+}
+
+static void bench(void)
+{
+  std::string title;
+  while (title.size() < 120) title += "Artysta Łódź - Piosenka o żółtej gęsi (Remix) ";
+  title.resize(120);
+  while ((uint8_t)title.back() >= 0x80) title.pop_back();   // bez uciętego znaku na końcu
+
+  char display[TEXT_DISPLAY_MAX];
+  char web[TEXT_WEB_MAX];
+  volatile size_t sink = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    text_result_t r;
+    text_transcode(title.c_str(), display, sizeof(display), web, sizeof(web), &r);
+    sink += r.displayLength;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    std::string s = title;
+    legacy_process_text(s);
+    sink += s.size();
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  double newNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_ITERATIONS;
+  double oldNs = std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_ITERATIONS;
+  printf("pomiar (%zu znaków): text_transcode OLED+WWW %.0f ns, dawne processText OLED %.0f ns\n", title.size(), newNs, oldNs);
+}
+
+int main()
+{
+  fuzz();
+  polish_letters();
+  bench();
+  printf(g_failed ? "WYNIK: błędy %d\n" : "WYNIK: OK\n", g_failed);
+  return g_failed ? 1 : 0;
+}